@@ -74,6 +74,28 @@ test_shared_libraries := $(sort $(LOCAL_SHARED_LIBRARIES))
 test_static_libraries := $(sort $(LOCAL_STATIC_LIBRARIES))
 endif # LIBCORE_SKIP_TESTS
 
+# Set up the benchmark executable the same way.
+ifeq ($(LIBCORE_SKIP_BENCHMARKS),)
+include $(CLEAR_VARS)
+LOCAL_MODULE := $(core_magic_local_target)
+core_src_files :=
+
+# Include the sub.mk files.
+$(foreach dir, \
+    luni/src/benchmark/native, \
+    $(eval $(call include-core-native-dir,$(dir))))
+
+# This is for the benchmark executable, so rename the variable.
+benchmark_src_files := $(core_src_files)
+core_src_files :=
+
+# Extract out the allowed LOCAL_* variables. Note: $(sort) also
+# removes duplicates.
+benchmark_c_includes := $(sort libcore/include $(LOCAL_C_INCLUDES) $(JNI_H_INCLUDE))
+benchmark_shared_libraries := $(sort $(LOCAL_SHARED_LIBRARIES))
+benchmark_static_libraries := $(sort $(LOCAL_STATIC_LIBRARIES))
+endif # LIBCORE_SKIP_BENCHMARKS
+
 
 include $(CLEAR_VARS)
 LOCAL_MODULE := $(core_magic_local_target)
@@ -165,6 +187,35 @@ LOCAL_ADDITIONAL_DEPENDENCIES := $(LOCAL_PATH)/NativeCode.mk
 include $(BUILD_SHARED_LIBRARY)
 endif # LIBCORE_SKIP_TESTS
 
+# Native microbenchmarks. This is a device-only executable: it creates its
+# own VM, which reaches libjavacore's natives the way apps do. Its options
+# are described in luni/src/benchmark/native/BenchmarkMain.cpp.
+ifeq ($(LIBCORE_SKIP_BENCHMARKS),)
+include $(CLEAR_VARS)
+
+LOCAL_CFLAGS += -Wall -Wextra -Werror
+LOCAL_CFLAGS += $(core_cflags)
+LOCAL_CPPFLAGS += $(core_cppflags)
+ifeq ($(TARGET_ARCH),arm)
+# Ignore "note: the mangling of 'va_list' has changed in GCC 4.4"
+LOCAL_CFLAGS += -Wno-psabi
+endif
+
+# Define the rules.
+LOCAL_SRC_FILES := $(benchmark_src_files)
+LOCAL_C_INCLUDES := $(benchmark_c_includes)
+LOCAL_SHARED_LIBRARIES := $(benchmark_shared_libraries)
+LOCAL_STATIC_LIBRARIES := $(benchmark_static_libraries)
+LOCAL_MODULE_TAGS := optional
+LOCAL_MODULE := javacore-benchmark
+LOCAL_ADDITIONAL_DEPENDENCIES := $(LOCAL_PATH)/NativeCode.mk
+
+LOCAL_C_INCLUDES += external/stlport/stlport bionic/ bionic/libstdc++/include
+LOCAL_SHARED_LIBRARIES += libstlport
+
+include $(BUILD_EXECUTABLE)
+endif # LIBCORE_SKIP_BENCHMARKS
+
 
 #
 # Build for the host.
@@ -215,6 +215,17 @@ public final class BlockGuard {
             mFileSystem.fsync(fileDescriptor, metadata);
         }
 
+        public void groupSync(int fileDescriptor, boolean metadata) throws IOException {
+            BlockGuard.getThreadPolicy().onWriteToDisk();
+            mFileSystem.groupSync(fileDescriptor, metadata);
+        }
+
+        public void syncFileRange(int fileDescriptor, long offset, long length, int flags)
+                throws IOException {
+            BlockGuard.getThreadPolicy().onWriteToDisk();
+            mFileSystem.syncFileRange(fileDescriptor, offset, length, flags);
+        }
+
         public void truncate(int fileDescriptor, long size) throws IOException {
             BlockGuard.getThreadPolicy().onWriteToDisk();
             mFileSystem.truncate(fileDescriptor, size);
@@ -226,17 +237,69 @@ public final class BlockGuard {
 
         public int open(String path, int mode) throws FileNotFoundException {
             BlockGuard.getThreadPolicy().onReadFromDisk();
-            if (mode != 0) {  // 0 is read-only
+            int accessMode = mode & ~(IFileSystem.O_SEQUENTIAL | IFileSystem.O_RANDOM
+                    | IFileSystem.O_DIRECT);
+            if (accessMode != 0) {  // 0 is read-only
                 BlockGuard.getThreadPolicy().onWriteToDisk();
             }
             return mFileSystem.open(path, mode);
         }
 
+        public void advise(int fileDescriptor, long offset, long length, int advice)
+                throws IOException {
+            mFileSystem.advise(fileDescriptor, offset, length, advice);
+        }
+
+        public void readahead(int fileDescriptor, long offset, long length)
+                throws IOException {
+            mFileSystem.readahead(fileDescriptor, offset, length);
+        }
+
         public long transfer(int fileHandler, FileDescriptor socketDescriptor,
                              long offset, long count) throws IOException {
             return mFileSystem.transfer(fileHandler, socketDescriptor, offset, count);
         }
 
+        public long transferFile(int in, long inOffset, int out, long count) throws IOException {
+            BlockGuard.getThreadPolicy().onReadFromDisk();
+            BlockGuard.getThreadPolicy().onWriteToDisk();
+            return mFileSystem.transferFile(in, inOffset, out, count);
+        }
+
+        public long relay(FileDescriptor source, FileDescriptor sink, long count)
+                throws IOException {
+            BlockGuard.getThreadPolicy().onNetwork();
+            return mFileSystem.relay(source, sink, count);
+        }
+
+        public int ioQueueOpen(int depth) throws IOException {
+            return mFileSystem.ioQueueOpen(depth);
+        }
+
+        public int ioQueueSubmit(int queue, int[] ops, int[] fds, long[] offsets,
+                int[] addresses, int[] lengths, int[] tags, int count) throws IOException {
+            for (int i = 0; i < count; i++) {
+                if (ops[i] == IFileSystem.IO_WRITE) {
+                    BlockGuard.getThreadPolicy().onWriteToDisk();
+                    break;
+                }
+            }
+            return mFileSystem.ioQueueSubmit(queue, ops, fds, offsets, addresses, lengths,
+                    tags, count);
+        }
+
+        public int ioQueueReap(int queue, int[] tags, long[] results, int minComplete)
+                throws IOException {
+            if (minComplete > 0) {
+                BlockGuard.getThreadPolicy().onReadFromDisk();
+            }
+            return mFileSystem.ioQueueReap(queue, tags, results, minComplete);
+        }
+
+        public void ioQueueClose(int queue) {
+            mFileSystem.ioQueueClose(queue);
+        }
+
         public int ioctlAvailable(FileDescriptor fileDescriptor) throws IOException {
             return mFileSystem.ioctlAvailable(fileDescriptor);
         }
@@ -290,6 +353,18 @@ public final class BlockGuard {
             return mNetwork.writeDirect(fd, address, offset, count);
         }
 
+        public long readv(FileDescriptor fd, int[] buffers, int[] offsets, int[] lengths,
+                int size) throws IOException {
+            BlockGuard.getThreadPolicy().onNetwork();
+            return mNetwork.readv(fd, buffers, offsets, lengths, size);
+        }
+
+        public long writev(FileDescriptor fd, int[] buffers, int[] offsets, int[] lengths,
+                int size, boolean more) throws IOException {
+            BlockGuard.getThreadPolicy().onNetwork();
+            return mNetwork.writev(fd, buffers, offsets, lengths, size, more);
+        }
+
         public boolean connectNonBlocking(FileDescriptor fd, InetAddress inetAddress, int port)
                 throws IOException {
             BlockGuard.getThreadPolicy().onNetwork();
@@ -315,6 +390,18 @@ public final class BlockGuard {
             return mNetwork.sendDirect(fd, address, offset, length, port, inetAddress);
         }
 
+        public int sendConnected(FileDescriptor fd, byte[] data, int offset, int length)
+                throws IOException {
+            // Note: no BlockGuard violation, as for sendDirect.
+            return mNetwork.sendConnected(fd, data, offset, length);
+        }
+
+        public int sendConnectedDirect(FileDescriptor fd, int address, int offset, int length)
+                throws IOException {
+            // Note: no BlockGuard violation, as for sendDirect.
+            return mNetwork.sendConnectedDirect(fd, address, offset, length);
+        }
+
         public int recv(FileDescriptor fd, DatagramPacket packet, byte[] data, int offset,
                 int length, boolean peek, boolean connected) throws IOException {
             BlockGuard.getThreadPolicy().onNetwork();
@@ -327,6 +414,18 @@ public final class BlockGuard {
             return mNetwork.recvDirect(fd, packet, address, offset, length, peek, connected);
         }
 
+        public int recvBatchDirect(FileDescriptor fd, int address, int stride, int count,
+                int[] lengths, int[] ports, byte[] addresses) throws IOException {
+            BlockGuard.getThreadPolicy().onNetwork();
+            return mNetwork.recvBatchDirect(fd, address, stride, count, lengths, ports, addresses);
+        }
+
+        public int sendBatchDirect(FileDescriptor fd, int address, int stride, int count,
+                int[] lengths, int[] ports, byte[] addresses) throws IOException {
+            // Note: no BlockGuard violation, for the same reason as sendDirect.
+            return mNetwork.sendBatchDirect(fd, address, stride, count, lengths, ports, addresses);
+        }
+
         public void disconnectDatagram(FileDescriptor aFD) throws SocketException {
             mNetwork.disconnectDatagram(aFD);
         }
@@ -357,6 +456,12 @@ public final class BlockGuard {
             mNetwork.connect(aFD, inetAddress, port, timeout);
         }
 
+        public int connectWithData(FileDescriptor aFD, InetAddress inetAddress, int port,
+                int timeout, byte[] data, int offset, int count) throws SocketException {
+            BlockGuard.getThreadPolicy().onNetwork();
+            return mNetwork.connectWithData(aFD, inetAddress, port, timeout, data, offset, count);
+        }
+
         public InetAddress getSocketLocalAddress(FileDescriptor aFD) {
             return mNetwork.getSocketLocalAddress(aFD);
         }
@@ -368,6 +473,31 @@ public final class BlockGuard {
             return mNetwork.select(readFDs, writeFDs, numReadable, numWritable, timeout, flags);
         }
 
+        public void epollCreate(FileDescriptor epollFd) throws SocketException {
+            mNetwork.epollCreate(epollFd);
+        }
+
+        public void epollRegister(FileDescriptor epollFd, FileDescriptor fd, int ops, int token)
+                throws SocketException {
+            mNetwork.epollRegister(epollFd, fd, ops, token);
+        }
+
+        public void epollModify(FileDescriptor epollFd, FileDescriptor fd, int ops, int token)
+                throws SocketException {
+            mNetwork.epollModify(epollFd, fd, ops, token);
+        }
+
+        public void epollDeregister(FileDescriptor epollFd, FileDescriptor fd)
+                throws SocketException {
+            mNetwork.epollDeregister(epollFd, fd);
+        }
+
+        public int epollWait(FileDescriptor epollFd, int[] readyTokens, int[] readyOps,
+                long timeout) throws SocketException {
+            BlockGuard.getThreadPolicy().onNetwork();
+            return mNetwork.epollWait(epollFd, readyTokens, readyOps, timeout);
+        }
+
         public int getSocketLocalPort(FileDescriptor aFD) {
             return mNetwork.getSocketLocalPort(aFD);
         }
@@ -382,6 +512,14 @@ public final class BlockGuard {
             mNetwork.setSocketOption(aFD, opt, optVal);
         }
 
+        public void setSocketStatsEnabled(boolean enabled) {
+            mNetwork.setSocketStatsEnabled(enabled);
+        }
+
+        public long[] getSocketStats(boolean reset) {
+            return mNetwork.getSocketStats(reset);
+        }
+
         public void close(FileDescriptor aFD) throws IOException {
             // We exclude sockets without SO_LINGER so that apps can close their network connections
             // in methods like onDestroy, which will run on the UI thread, without jumping through
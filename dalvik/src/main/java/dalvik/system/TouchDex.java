@@ -21,6 +21,8 @@ import java.io.File;
 import java.io.FilenameFilter;
 import java.io.IOException;
 import java.io.InputStreamReader;
+import java.util.ArrayList;
+import java.util.List;
 
 /**
  * Induces optimization/verification of a set of DEX files.
@@ -46,6 +48,23 @@ public class TouchDex {
         return trampoline(dexFiles, System.getProperty("java.boot.class.path"));
     }
 
+    /**
+     * Like {@link #start(String)}, but prepares each file in its own
+     * process, running up to {@code maxWorkers} of them at once. Fewer are
+     * used if there aren't enough cores or free memory. The time taken and
+     * peak RSS of each file's process are logged.
+     *
+     * @param dexFiles the DEX files to prepare. Directories are expanded to
+     * the JAR and APK files they contain, each prepared separately.
+     * @param maxWorkers the most processes to run at once.
+     * @return zero on success, otherwise the status of the first file that
+     * failed
+     */
+    public static int start(String[] dexFiles, int maxWorkers) {
+        String[] files = expandDirectories(dexFiles);
+        return trampolineParallel(files, System.getProperty("java.boot.class.path"), maxWorkers);
+    }
+
     /**
      * This calls fork() and then, in the child, calls cont(dexFiles).
      *
@@ -54,6 +73,14 @@ public class TouchDex {
      */
     native private static int trampoline(String dexFiles, String bcp);
 
+    /**
+     * Forks a child for each of dexFiles, with at most maxWorkers alive at
+     * once, and waits for them all.
+     *
+     * @return zero on success
+     */
+    native private static int trampolineParallel(String[] dexFiles, String bcp, int maxWorkers);
+
     /**
      * The entry point for the child process. args[0] can be a colon-separated
      * path list, or "-" to read from stdin.
@@ -85,17 +112,42 @@ public class TouchDex {
     }
 
 
+    // A filename filter accepting *.jar and *.apk
+    private static final FilenameFilter JAR_OR_APK = new FilenameFilter() {
+        public boolean accept(File dir, String name) {
+            return name.endsWith(".jar") || name.endsWith(".apk");
+        }
+    };
+
+    /**
+     * Replaces each directory in paths with the JAR and APK files it
+     * contains. Files are kept even if they don't exist yet; the child
+     * reports those.
+     */
+    private static String[] expandDirectories(String[] paths) {
+        List<String> result = new ArrayList<String>(paths.length);
+        for (String path : paths) {
+            File f = new File(path);
+            if (!f.isDirectory()) {
+                result.add(path);
+                continue;
+            }
+            String[] filenames = f.list(JAR_OR_APK);
+            if (filenames == null) {
+                System.err.println("I/O error with directory: " + path);
+                continue;
+            }
+            for (String filename : filenames) {
+                result.add(path + File.separatorChar + filename);
+            }
+        }
+        return result.toArray(new String[result.size()]);
+    }
+
     private static String expandDirectories(String dexPath) {
         String[] parts = dexPath.split(":");
         StringBuilder outPath = new StringBuilder(dexPath.length());
 
-        // A filename filter accepting *.jar and *.apk
-        FilenameFilter filter = new FilenameFilter() {
-            public boolean accept(File dir, String name) {
-                return name.endsWith(".jar") || name.endsWith(".apk");
-            }
-        };
-
         for (String part: parts) {
             File f = new File(part);
 
@@ -103,7 +155,7 @@ public class TouchDex {
                 outPath.append(part);
                 outPath.append(':');
             } else if (f.isDirectory()) {
-                String[] filenames = f.list(filter);
+                String[] filenames = f.list(JAR_OR_APK);
 
                 if (filenames == null) {
                     System.err.println("I/O error with directory: " + part);
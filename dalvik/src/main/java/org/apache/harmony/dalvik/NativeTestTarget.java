@@ -17,9 +17,10 @@
 package org.apache.harmony.dalvik;
 
 /**
- * Methods used to test calling into native code. The methods in this
- * class are all effectively no-ops and may be used to test the mechanisms
- * and performance of calling native methods.
+ * Methods used to test calling into native code. Most methods in this
+ * class are effectively no-ops and may be used to test the mechanisms
+ * and performance of calling native methods. The rest exercise native
+ * helpers that have no Java API of their own.
  */
 public final class NativeTestTarget {
     /**
@@ -51,6 +52,14 @@ public final class NativeTestTarget {
     public static native void emptyJniStaticMethod6L(String a, String[] b,
         int[][] c, Object d, Object[] e, Object[][][][] f);
 
+    /**
+     * Exercises the calling thread's native scratch arena, directly and
+     * through LocalArray: nested use, out-of-order release, and requests
+     * too big for it. Returns null if all is well, or a description of
+     * the first problem found.
+     */
+    public static native String checkScratchArena();
+
     /**
      * This method is intended to be "inlined" by the virtual machine
      * (e.g., given special treatment as an intrinsic).
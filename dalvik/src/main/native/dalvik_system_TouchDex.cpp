@@ -20,20 +20,28 @@
 
 #define LOG_TAG "TouchDex"
 #include "JNIHelp.h"
+#include "ScopedLocalRef.h"
+#include "ScopedUtfChars.h"
 
 #include "cutils/properties.h"
 
+#include <limits.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
 #include <signal.h>
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <sys/wait.h>
 #include <sys/time.h>
+#include <sys/resource.h>
 #include <assert.h>
 #include <errno.h>
 
+#include <string>
+#include <vector>
+
 #define JAVA_PACKAGE "dalvik/system"
 
 #ifndef HAVE_ANDROID_OS
@@ -47,36 +55,24 @@ namespace android {
 // fwd
 static void logProcStatus(pid_t pid);
 
+static const int kMinTimeout = 900;     // 90 seconds, in 1/10ths of a second
+static const char* kExecFile = BASE_DIR "/system/bin/dalvikvm";
 
 /*
- * private static int trampoline(String dexFiles, String bcp)
+ * The dalvikvm arguments that don't depend on which files are being
+ * prepared.  kExecMode may point into execModeBuf, so don't copy these.
  */
-static jint dalvik_system_TouchDex_trampoline(JNIEnv* env,
-    jclass, jstring dexFilesStr, jstring bcpStr)
-{
-#ifndef HAVE_ANDROID_OS
-    /* don't do this on simulator -- gdb goes "funny" in goobuntu */
-    return 0;
-#endif
-
-    const int kMinTimeout = 900;        // 90 seconds
-    const char* bcp;
-    const char* dexFiles;
-    static const char* kExecFile = BASE_DIR "/system/bin/dalvikvm";
-    //static const char* kDebugArg =
-    //        "-Xrunjdwp:transport=dt_socket,address=8000,server=y,suspend=n";
-    static const char* kBcpArgName = "-Xbootclasspath:";
-    static const char* kClassName = "dalvik.system.TouchDex";
-    static const char* kExecMode = "-Xint";
-    static const int argc = 7;
-    const char* argv[argc+1];
+struct DexoptArgs {
     const char* kVerifyArg;
     const char* kDexOptArg;
+    const char* kExecMode;
     int timeoutMult;
-    pid_t pid;
-    struct timeval startWhen, endWhen;
-    char propBuf[PROPERTY_VALUE_MAX];
     char execModeBuf[PROPERTY_VALUE_MAX + sizeof("-X")];
+};
+
+static void getDexoptArgs(DexoptArgs* args)
+{
+    char propBuf[PROPERTY_VALUE_MAX];
     bool verifyJava = true;
 
     property_get("dalvik.vm.verify-bytecode", propBuf, "");
@@ -89,39 +85,43 @@ static jint dalvik_system_TouchDex_trampoline(JNIEnv* env,
     }
 
     if (verifyJava) {
-        kVerifyArg = "-Xverify:all";
-        kDexOptArg = "-Xdexopt:verified";
-        timeoutMult = 11;
+        args->kVerifyArg = "-Xverify:all";
+        args->kDexOptArg = "-Xdexopt:verified";
+        args->timeoutMult = 11;
     } else {
-        kVerifyArg = "-Xverify:none";
-        //kDexOptArg = "-Xdexopt:all";
-        kDexOptArg = "-Xdexopt:verified";
-        timeoutMult = 7;
+        args->kVerifyArg = "-Xverify:none";
+        //args->kDexOptArg = "-Xdexopt:all";
+        args->kDexOptArg = "-Xdexopt:verified";
+        args->timeoutMult = 7;
     }
 
+    args->kExecMode = "-Xint";
     property_get("dalvik.vm.execution-mode", propBuf, "");
     if (strncmp(propBuf, "int:", 4) == 0) {
-        strcpy(execModeBuf, "-X");
-        strcat(execModeBuf, propBuf);
-        kExecMode = execModeBuf;
+        strcpy(args->execModeBuf, "-X");
+        strcat(args->execModeBuf, propBuf);
+        args->kExecMode = args->execModeBuf;
     }
+}
 
-    ALOGV("TouchDex trampoline forking\n");
-    gettimeofday(&startWhen, NULL);
-
-    /*
-     * Retrieve strings.  Note we want to do this *before* the fork() -- bad
-     * idea to perform Java operations in the child process (not all threads
-     * get carried over to the new process).
-     */
-    bcp = env->GetStringUTFChars(bcpStr, NULL);
-    dexFiles = env->GetStringUTFChars(dexFilesStr, NULL);
-    if (bcp == NULL || dexFiles == NULL) {
-        ALOGE("Bad values for bcp=%p dexFiles=%p\n", bcp, dexFiles);
-        abort();
-    }
+/*
+ * Forks a dalvikvm that runs TouchDex.main on dexFiles.  Returns the
+ * child's pid, or -1 if the fork failed.  The strings must have been
+ * retrieved *before* calling this -- bad idea to perform Java operations
+ * in the child process (not all threads get carried over to the new
+ * process).
+ */
+static pid_t startDexopt(const DexoptArgs* args, const char* bcp,
+    const char* dexFiles)
+{
+    //static const char* kDebugArg =
+    //        "-Xrunjdwp:transport=dt_socket,address=8000,server=y,suspend=n";
+    static const char* kBcpArgName = "-Xbootclasspath:";
+    static const char* kClassName = "dalvik.system.TouchDex";
+    static const int argc = 7;
+    const char* argv[argc+1];
 
-    pid = fork();
+    pid_t pid = fork();
     if (pid < 0) {
         ALOGE("fork failed: %s", strerror(errno));
         return -1;
@@ -139,9 +139,9 @@ static jint dalvik_system_TouchDex_trampoline(JNIEnv* env,
 
         argv[0] = kExecFile;
         argv[1] = bcpArg;
-        argv[2] = kVerifyArg;
-        argv[3] = kDexOptArg;
-        argv[4] = kExecMode;
+        argv[2] = args->kVerifyArg;
+        argv[3] = args->kDexOptArg;
+        argv[4] = args->kExecMode;
         argv[5] = kClassName;
         argv[6] = dexFiles;
         argv[7] = NULL;
@@ -155,6 +155,48 @@ static jint dalvik_system_TouchDex_trampoline(JNIEnv* env,
 
         ALOGE("execv '%s' failed: %s\n", kExecFile, strerror(errno));
         exit(1);
+    }
+    return pid;
+}
+
+static long long nowUsec()
+{
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return now.tv_sec * 1000000LL + now.tv_usec;
+}
+
+/*
+ * private static int trampoline(String dexFiles, String bcp)
+ */
+static jint dalvik_system_TouchDex_trampoline(JNIEnv* env,
+    jclass, jstring dexFilesStr, jstring bcpStr)
+{
+#ifndef HAVE_ANDROID_OS
+    /* don't do this on simulator -- gdb goes "funny" in goobuntu */
+    return 0;
+#endif
+
+    const char* bcp;
+    const char* dexFiles;
+    DexoptArgs args;
+    pid_t pid;
+
+    getDexoptArgs(&args);
+
+    ALOGV("TouchDex trampoline forking\n");
+    long long start = nowUsec();
+
+    bcp = env->GetStringUTFChars(bcpStr, NULL);
+    dexFiles = env->GetStringUTFChars(dexFilesStr, NULL);
+    if (bcp == NULL || dexFiles == NULL) {
+        ALOGE("Bad values for bcp=%p dexFiles=%p\n", bcp, dexFiles);
+        abort();
+    }
+
+    pid = startDexopt(&args, bcp, dexFiles);
+    if (pid < 0) {
+        return -1;
     } else {
         int cc, count, dexCount, timeout;
         int result = -1;
@@ -184,7 +226,7 @@ static jint dalvik_system_TouchDex_trampoline(JNIEnv* env,
             if (*cp == ':')
                 dexCount++;
         }
-        timeout = timeoutMult * dexCount;
+        timeout = args.timeoutMult * dexCount;
         if (timeout < kMinTimeout)
             timeout = kMinTimeout;
 
@@ -218,9 +260,7 @@ static jint dalvik_system_TouchDex_trampoline(JNIEnv* env,
                 count, kill(pid, 0));
         }
 
-        gettimeofday(&endWhen, NULL);
-        long long start = startWhen.tv_sec * 1000000 + startWhen.tv_usec;
-        long long end = endWhen.tv_sec * 1000000 + endWhen.tv_usec;
+        long long end = nowUsec();
 
         ALOGI("Dalvik-cache prep: status=0x%04x, finished in %dms\n",
             result, (int) ((end - start) / 1000));
@@ -232,6 +272,218 @@ static jint dalvik_system_TouchDex_trampoline(JNIEnv* env,
     }
 }
 
+/*
+ * Rough upper bound on a dexopt worker's resident size.  The peak RSS we
+ * log for each file is what this should be tuned against.
+ */
+static const long kWorkerMemoryKiB = 24 * 1024;
+
+/*
+ * Returns MemFree + Cached from /proc/meminfo, in KiB, or -1 if it can't
+ * be read.  Page cache can be reclaimed to make room for the workers, so
+ * it counts as available.
+ */
+static long availableMemoryKiB()
+{
+    char line[128];
+    long memFree = -1, cached = -1;
+    FILE* fp = fopen("/proc/meminfo", "r");
+    if (fp == NULL) {
+        return -1;
+    }
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        sscanf(line, "MemFree: %ld kB", &memFree);
+        sscanf(line, "Cached: %ld kB", &cached);
+    }
+    fclose(fp);
+    if (memFree < 0 || cached < 0) {
+        return -1;
+    }
+    return memFree + cached;
+}
+
+/*
+ * Clamps the caller's requested worker count to the number of files, the
+ * number of online cores, and the number of workers that fit in memory.
+ * Always allows at least one.
+ */
+static int chooseWorkerCount(int requested, int fileCount)
+{
+    int count = requested;
+    if (count > fileCount) {
+        count = fileCount;
+    }
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores > 0 && count > cores) {
+        count = cores;
+    }
+    long memory = availableMemoryKiB();
+    if (memory >= 0 && count > memory / kWorkerMemoryKiB) {
+        count = memory / kWorkerMemoryKiB;
+    }
+    if (count < 1) {
+        count = 1;
+    }
+    ALOGD("TouchDex using %d worker(s) for %d file(s) (requested %d, %ld cores, %ldKiB available)\n",
+        count, fileCount, requested, cores, memory);
+    return count;
+}
+
+/*
+ * How many bytes of input earn a file one timeoutMult's worth of time in
+ * the parallel path.  The serial path allows timeoutMult per file, which
+ * suits a file of about this size; scaling by size instead keeps a big
+ * file from being killed merely for being big.
+ */
+static const off_t kTimeoutBytesPerMult = 256 * 1024;
+
+/*
+ * Returns how long to let a worker spend on the file at path, in 1/10ths
+ * of a second: timeoutMult for every kTimeoutBytesPerMult of it, but never
+ * less than kMinTimeout.  A file we can't stat gets the minimum; its
+ * worker will report the problem.
+ */
+static int fileTimeout(const DexoptArgs* args, const char* path)
+{
+    struct stat sb;
+    if (stat(path, &sb) != 0) {
+        return kMinTimeout;
+    }
+    long long timeout = (long long) args->timeoutMult
+            * (sb.st_size / kTimeoutBytesPerMult + 1);
+    if (timeout < kMinTimeout) {
+        return kMinTimeout;
+    }
+    return (timeout > INT_MAX) ? INT_MAX : (int) timeout;
+}
+
+struct DexoptWorker {
+    pid_t pid;              // 0 when this slot is free
+    int fileIndex;
+    long long startUsec;
+    long long timeoutUsec;
+};
+
+/*
+ * private static int trampolineParallel(String[] dexFiles, String bcp,
+ *     int maxWorkers)
+ *
+ * Prepares each entry of dexFiles in its own dalvikvm, running up to
+ * maxWorkers of them at once.  Each file gets a timeout scaled by its
+ * size (see fileTimeout); a worker that exceeds it is killed so its slot
+ * can be reused.  Logs each
+ * file's elapsed time and peak RSS.  Returns zero if every file was
+ * prepared, otherwise the status of the first file that failed.
+ */
+static jint dalvik_system_TouchDex_trampolineParallel(JNIEnv* env,
+    jclass, jobjectArray dexFilesArray, jstring bcpStr, jint maxWorkers)
+{
+#ifndef HAVE_ANDROID_OS
+    /* don't do this on simulator -- gdb goes "funny" in goobuntu */
+    return 0;
+#endif
+
+    DexoptArgs args;
+    getDexoptArgs(&args);
+
+    const jsize fileCount = env->GetArrayLength(dexFilesArray);
+    if (fileCount == 0) {
+        return 0;
+    }
+
+    /* retrieve every string before the first fork() */
+    std::vector<std::string> dexFiles(fileCount);
+    for (jsize i = 0; i < fileCount; ++i) {
+        ScopedLocalRef<jstring> javaFile(env,
+            (jstring) env->GetObjectArrayElement(dexFilesArray, i));
+        ScopedUtfChars file(env, javaFile.get());
+        if (file.c_str() == NULL) {
+            return -1;
+        }
+        dexFiles[i] = file.c_str();
+    }
+    ScopedUtfChars bcp(env, bcpStr);
+    if (bcp.c_str() == NULL) {
+        return -1;
+    }
+
+    const int workerCount = chooseWorkerCount(maxWorkers, fileCount);
+    std::vector<DexoptWorker> workers(workerCount);
+    int nextFile = 0;
+    int running = 0;
+    int firstFailure = 0;
+    long long start = nowUsec();
+
+    while (nextFile < fileCount || running > 0) {
+        for (int i = 0; i < workerCount && nextFile < fileCount; ++i) {
+            if (workers[i].pid != 0) {
+                continue;
+            }
+            const int fileIndex = nextFile++;
+            pid_t pid = startDexopt(&args, bcp.c_str(), dexFiles[fileIndex].c_str());
+            if (pid < 0) {
+                if (firstFailure == 0) {
+                    firstFailure = -1;
+                }
+                continue;
+            }
+            workers[i].pid = pid;
+            workers[i].fileIndex = fileIndex;
+            workers[i].startUsec = nowUsec();
+            workers[i].timeoutUsec =
+                fileTimeout(&args, dexFiles[fileIndex].c_str()) * 100000LL;
+            ++running;
+        }
+
+        bool reaped = false;
+        for (int i = 0; i < workerCount; ++i) {
+            DexoptWorker& worker = workers[i];
+            if (worker.pid == 0) {
+                continue;
+            }
+            /* wait4 rather than waitpid, for the child's peak RSS */
+            int status = -1;
+            struct rusage usage;
+            memset(&usage, 0, sizeof(usage));
+            pid_t cc = wait4(worker.pid, &status, WNOHANG, &usage);
+            if (cc == 0) {
+                if (nowUsec() - worker.startUsec < worker.timeoutUsec) {
+                    continue;
+                }
+                ALOGE("timed out waiting for %d (%s); killing it\n",
+                    (int) worker.pid, dexFiles[worker.fileIndex].c_str());
+                logProcStatus(worker.pid);
+                kill(worker.pid, SIGKILL);
+                cc = wait4(worker.pid, &status, 0, &usage);
+            }
+            if (cc < 0) {
+                ALOGE("wait4(%d) failed: %s", (int) worker.pid, strerror(errno));
+                status = -1;
+            }
+
+            ALOGI("Dalvik-cache prep: %s status=0x%04x, finished in %dms, peak RSS %ldKiB\n",
+                dexFiles[worker.fileIndex].c_str(), status,
+                (int) ((nowUsec() - worker.startUsec) / 1000), usage.ru_maxrss);
+
+            int result = WIFEXITED(status) ? WEXITSTATUS(status) : status;
+            if (result != 0 && firstFailure == 0) {
+                firstFailure = result;
+            }
+            worker.pid = 0;
+            --running;
+            reaped = true;
+        }
+
+        if (!reaped && running > 0) {
+            usleep(100000);     /* 0.1 sec */
+        }
+    }
+
+    ALOGI("Dalvik-cache prep: %d file(s) with %d worker(s) finished in %dms\n",
+        fileCount, workerCount, (int) ((nowUsec() - start) / 1000));
+    return firstFailure;
+}
+
 /*
  * Dump the contents of /proc/<pid>/status to the log file.
  */
@@ -261,6 +513,8 @@ static void logProcStatus(pid_t pid)
 static JNINativeMethod gMethods[] = {
     { "trampoline", "(Ljava/lang/String;Ljava/lang/String;)I",
         (void*) dalvik_system_TouchDex_trampoline },
+    { "trampolineParallel", "([Ljava/lang/String;Ljava/lang/String;I)I",
+        (void*) dalvik_system_TouchDex_trampolineParallel },
 };
 void register_dalvik_system_TouchDex(JNIEnv* env) {
     jniRegisterNativeMethods(env, JAVA_PACKAGE "/TouchDex", gMethods, NELEM(gMethods));
@@ -15,6 +15,10 @@
  */
 
 #include "JNIHelp.h"
+#include "LocalArray.h"
+#include "ScratchArena.h"
+
+#include <string.h>
 
 /*
  * public static void emptyJniStaticMethod0()
@@ -50,7 +54,130 @@ static void emptyJniStaticMethod6L(JNIEnv*, jclass,
     // This space intentionally left blank.
 }
 
+static bool overlaps(const void* a, size_t aLength, const void* b, size_t bLength) {
+    const char* aStart = reinterpret_cast<const char*>(a);
+    const char* bStart = reinterpret_cast<const char*>(b);
+    return aStart < bStart + bLength && bStart < aStart + aLength;
+}
+
+static bool filledWith(const char* p, size_t length, char value) {
+    for (size_t i = 0; i < length; ++i) {
+        if (p[i] != value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Nested LocalArrays must get disjoint scratch space, and the inner one mustn't disturb the
+// outer one's contents. Returns NULL on success, or what went wrong.
+static const char* checkNestedLocalArrays() {
+    LocalArray<8> outer(1000);
+    memset(&outer[0], 'o', outer.size());
+    {
+        LocalArray<8> inner(2000);
+        if (overlaps(&outer[0], outer.size(), &inner[0], inner.size())) {
+            return "nested LocalArrays overlap";
+        }
+        memset(&inner[0], 'i', inner.size());
+        {
+            // Too big for the arena while others are outstanding, so this one is from the heap.
+            LocalArray<8> oversized(ScratchArena::MAX_BYTE_COUNT + 1);
+            memset(&oversized[0], 'x', oversized.size());
+        }
+        if (!filledWith(&inner[0], inner.size(), 'i')) {
+            return "inner LocalArray was overwritten";
+        }
+    }
+    if (!filledWith(&outer[0], outer.size(), 'o')) {
+        return "outer LocalArray was overwritten";
+    }
+    return NULL;
+}
+
+// Returns NULL on success, or what went wrong.
+static const char* checkScratchArenaReleaseOrder(ScratchArena* arena) {
+    void* first = arena->allocate(100);
+    void* second = arena->allocate(200);
+    if (first == NULL || second == NULL) {
+        return "small allocations failed";
+    }
+    if (overlaps(first, 100, second, 200)) {
+        return "allocations overlap";
+    }
+    // Releasing out of order mustn't let a new allocation land on one still in use.
+    arena->release(first, 100);
+    void* third = arena->allocate(300);
+    if (third == NULL) {
+        return "allocation after out-of-order release failed";
+    }
+    if (overlaps(second, 200, third, 300)) {
+        return "allocation after out-of-order release overlaps a live one";
+    }
+    arena->release(second, 200);
+    arena->release(third, 300);
+    // With everything released, the space is all reclaimed.
+    void* again = arena->allocate(100);
+    arena->release(again, 100);
+    if (again != first) {
+        return "space wasn't reclaimed after out-of-order releases";
+    }
+    return NULL;
+}
+
+// Returns NULL on success, or what went wrong.
+static const char* checkScratchArenaLimits(ScratchArena* arena) {
+    if (arena->allocate(ScratchArena::MAX_BYTE_COUNT + 1) != NULL) {
+        return "oversized allocation succeeded";
+    }
+    if (arena->allocate(static_cast<size_t>(-1)) != NULL) {
+        return "allocation of SIZE_MAX bytes succeeded";
+    }
+    // The arena can't move its block to grow while something is outstanding.
+    void* small = arena->allocate(16);
+    void* big = arena->allocate(ScratchArena::MAX_BYTE_COUNT);
+    if (big != NULL) {
+        arena->release(big, ScratchArena::MAX_BYTE_COUNT);
+    }
+    arena->release(small, 16);
+    if (small == NULL || big != NULL) {
+        return "arena grew with an allocation outstanding";
+    }
+    // Once nothing is outstanding it can grow to the limit.
+    void* whole = arena->allocate(ScratchArena::MAX_BYTE_COUNT);
+    if (whole == NULL) {
+        return "arena didn't grow to its limit";
+    }
+    memset(whole, 0, ScratchArena::MAX_BYTE_COUNT);
+    arena->release(whole, ScratchArena::MAX_BYTE_COUNT);
+    return NULL;
+}
+
+/*
+ * public static String checkScratchArena()
+ *
+ * For tests, exercises LocalArray and the calling thread's ScratchArena.
+ */
+static jstring checkScratchArena(JNIEnv* env, jclass)
+{
+    ScratchArena* arena = ScratchArena::get();
+    if (arena == NULL) {
+        return env->NewStringUTF("no scratch arena");
+    }
+    // The limits check leaves the arena grown to its limit, so the others run in the arena
+    // rather than falling back to the heap.
+    const char* failure = checkScratchArenaLimits(arena);
+    if (failure == NULL) {
+        failure = checkNestedLocalArrays();
+    }
+    if (failure == NULL) {
+        failure = checkScratchArenaReleaseOrder(arena);
+    }
+    return (failure != NULL) ? env->NewStringUTF(failure) : NULL;
+}
+
 static JNINativeMethod gMethods[] = {
+  { "checkScratchArena",      "()Ljava/lang/String;", (void*)checkScratchArena },
   { "emptyJniStaticMethod0",  "()V",       (void*)emptyJniStaticMethod0 },
   { "emptyJniStaticMethod6",  "(IIIIII)V", (void*)emptyJniStaticMethod6 },
   { "emptyJniStaticMethod6L", "(Ljava/lang/String;[Ljava/lang/String;[[ILjava/lang/Object;[Ljava/lang/Object;[[[[Ljava/lang/Object;)V", (void*)emptyJniStaticMethod6L },
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package dalvik.system;
+
+import java.io.File;
+import java.io.FileOutputStream;
+import junit.framework.TestCase;
+
+public class TouchDexTest extends TestCase {
+    private File tmpDir;
+
+    @Override protected void setUp() throws Exception {
+        super.setUp();
+        tmpDir = new File(System.getProperty("java.io.tmpdir"), "TouchDexTest");
+        tmpDir.mkdirs();
+    }
+
+    @Override protected void tearDown() throws Exception {
+        File[] files = tmpDir.listFiles();
+        if (files != null) {
+            for (File file : files) {
+                file.delete();
+            }
+        }
+        tmpDir.delete();
+        super.tearDown();
+    }
+
+    /**
+     * Several files prepared in parallel, with a corrupt one and a missing
+     * one among them, give the same status as the serial path, and the bad
+     * files don't hold up the rest until they time out.
+     */
+    public void testParallelWithBadFiles() throws Exception {
+        String[] bootClassPath = System.getProperty("java.boot.class.path").split(":");
+        assertTrue(bootClassPath.length >= 2);
+
+        File corrupt = new File(tmpDir, "corrupt.jar");
+        FileOutputStream out = new FileOutputStream(corrupt);
+        out.write("this is not a zip file".getBytes("US-ASCII"));
+        out.close();
+        File missing = new File(tmpDir, "missing.jar");
+
+        String[] files = new String[] {
+            bootClassPath[0],
+            corrupt.getPath(),
+            bootClassPath[1],
+            missing.getPath(),
+        };
+        StringBuilder serialFiles = new StringBuilder();
+        for (String file : files) {
+            if (serialFiles.length() > 0) {
+                serialFiles.append(':');
+            }
+            serialFiles.append(file);
+        }
+
+        long start = System.currentTimeMillis();
+        int parallelResult = TouchDex.start(files, 3);
+        long elapsedMillis = System.currentTimeMillis() - start;
+        // Well under the 90s minimum timeout, so no worker was killed.
+        assertTrue("took " + elapsedMillis + "ms", elapsedMillis < 60 * 1000);
+        assertEquals(TouchDex.start(serialFiles.toString()), parallelResult);
+
+        // One worker at a time gets through the same list.
+        assertEquals(parallelResult, TouchDex.start(files, 1));
+    }
+}
@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.apache.harmony.dalvik;
+
+import junit.framework.TestCase;
+
+public class ScratchArenaTest extends TestCase {
+    public void testScratchArena() {
+        assertNull(NativeTestTarget.checkScratchArena());
+    }
+
+    // Each thread has its own arena, starting out empty.
+    public void testScratchArenaOnNewThread() throws Exception {
+        final String[] result = new String[] { "not run" };
+        Thread thread = new Thread() {
+            @Override public void run() {
+                result[0] = NativeTestTarget.checkScratchArena();
+            }
+        };
+        thread.start();
+        thread.join();
+        assertNull(result[0]);
+    }
+}
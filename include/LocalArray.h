@@ -17,14 +17,17 @@
 #ifndef LOCAL_ARRAY_H_included
 #define LOCAL_ARRAY_H_included
 
+#include "ScratchArena.h"
+
 #include <cstddef>
 #include <new>
 
 /**
  * A fixed-size array with a size hint. That number of bytes will be allocated
  * on the stack, and used if possible, but if more bytes are requested at
- * construction time, a buffer will be allocated on the heap (and deallocated
- * by the destructor).
+ * construction time, a buffer is taken from the calling thread's ScratchArena
+ * (and given back by the destructor). Only if that can't satisfy the request
+ * is a buffer allocated on the heap.
  *
  * The API is intended to be a compatible subset of C++0x's std::array.
  */
@@ -34,22 +37,30 @@ public:
     /**
      * Allocates a new fixed-size array of the given size. If this size is
      * less than or equal to the template parameter STACK_BYTE_COUNT, an
-     * internal on-stack buffer will be used. Otherwise a heap buffer will
-     * be allocated.
+     * internal on-stack buffer will be used. Otherwise the thread's scratch
+     * arena, or failing that the heap, will be used.
      */
-    LocalArray(size_t desiredByteCount) : mSize(desiredByteCount) {
-        if (desiredByteCount > STACK_BYTE_COUNT) {
-            mPtr = new char[mSize];
-        } else {
+    LocalArray(size_t desiredByteCount) : mSize(desiredByteCount), mArena(NULL) {
+        if (desiredByteCount <= STACK_BYTE_COUNT) {
             mPtr = &mOnStackBuffer[0];
+            return;
+        }
+        ScratchArena* arena = ScratchArena::get();
+        mPtr = (arena != NULL) ? reinterpret_cast<char*>(arena->allocate(mSize)) : NULL;
+        if (mPtr != NULL) {
+            mArena = arena;
+        } else {
+            mPtr = new char[mSize];
         }
     }
 
     /**
-     * Frees the heap-allocated buffer, if there was one.
+     * Returns the arena buffer or frees the heap buffer, if there was one.
      */
     ~LocalArray() {
-        if (mPtr != &mOnStackBuffer[0]) {
+        if (mArena != NULL) {
+            mArena->release(mPtr, mSize);
+        } else if (mPtr != &mOnStackBuffer[0]) {
             delete[] mPtr;
         }
     }
@@ -66,6 +77,8 @@ private:
     char mOnStackBuffer[STACK_BYTE_COUNT];
     char* mPtr;
     size_t mSize;
+    // The arena mPtr came from, if it did.
+    ScratchArena* mArena;
 
     // Disallow copy and assignment.
     LocalArray(const LocalArray&);
@@ -105,4 +105,99 @@ INSTANTIATE_SCOPED_PRIMITIVE_ARRAY_RW(jshort, Short);
 
 #undef INSTANTIATE_SCOPED_PRIMITIVE_ARRAY_RW
 
+// ScopedBooleanArrayCriticalRO, ScopedByteArrayCriticalRO, ScopedCharArrayCriticalRO, and so on,
+// are like the RO classes above but use GetPrimitiveArrayCritical, which gives direct access to
+// the array wherever the VM can rather than copying it, as Get<Type>ArrayElements may. In
+// exchange, while one is in scope the caller must not call any other JNI function (other than
+// to take more critical regions), block, or run for long, because the VM may hold off the GC
+// until it ends. They suit short, bounded loops over bulk data: checksums, transcoding, copies.
+// size() is read before the region starts, so it's safe to call inside it. A null array throws
+// NullPointerException from the constructor, which mustn't happen inside another region, so when
+// nesting them, check the inner arrays for null before taking the outer one.
+#define INSTANTIATE_SCOPED_PRIMITIVE_ARRAY_CRITICAL_RO(PRIMITIVE_TYPE, NAME) \
+    class Scoped ## NAME ## ArrayCriticalRO { \
+    public: \
+        Scoped ## NAME ## ArrayCriticalRO(JNIEnv* env, PRIMITIVE_TYPE ## Array javaArray) \
+        : mEnv(env), mJavaArray(javaArray), mRawArray(NULL), mSize(0) { \
+            if (mJavaArray == NULL) { \
+                jniThrowNullPointerException(mEnv, NULL); \
+            } else { \
+                mSize = mEnv->GetArrayLength(mJavaArray); \
+                mRawArray = reinterpret_cast<PRIMITIVE_TYPE*>( \
+                        mEnv->GetPrimitiveArrayCritical(mJavaArray, NULL)); \
+            } \
+        } \
+        ~Scoped ## NAME ## ArrayCriticalRO() { \
+            if (mRawArray) { \
+                mEnv->ReleasePrimitiveArrayCritical(mJavaArray, mRawArray, JNI_ABORT); \
+            } \
+        } \
+        const PRIMITIVE_TYPE* get() const { return mRawArray; } \
+        const PRIMITIVE_TYPE& operator[](size_t n) const { return mRawArray[n]; } \
+        size_t size() const { return mSize; } \
+    private: \
+        JNIEnv* mEnv; \
+        PRIMITIVE_TYPE ## Array mJavaArray; \
+        PRIMITIVE_TYPE* mRawArray; \
+        size_t mSize; \
+        Scoped ## NAME ## ArrayCriticalRO(const Scoped ## NAME ## ArrayCriticalRO&); \
+        void operator=(const Scoped ## NAME ## ArrayCriticalRO&); \
+    }
+
+INSTANTIATE_SCOPED_PRIMITIVE_ARRAY_CRITICAL_RO(jboolean, Boolean);
+INSTANTIATE_SCOPED_PRIMITIVE_ARRAY_CRITICAL_RO(jbyte, Byte);
+INSTANTIATE_SCOPED_PRIMITIVE_ARRAY_CRITICAL_RO(jchar, Char);
+INSTANTIATE_SCOPED_PRIMITIVE_ARRAY_CRITICAL_RO(jdouble, Double);
+INSTANTIATE_SCOPED_PRIMITIVE_ARRAY_CRITICAL_RO(jfloat, Float);
+INSTANTIATE_SCOPED_PRIMITIVE_ARRAY_CRITICAL_RO(jint, Int);
+INSTANTIATE_SCOPED_PRIMITIVE_ARRAY_CRITICAL_RO(jlong, Long);
+INSTANTIATE_SCOPED_PRIMITIVE_ARRAY_CRITICAL_RO(jshort, Short);
+
+#undef INSTANTIATE_SCOPED_PRIMITIVE_ARRAY_CRITICAL_RO
+
+// ScopedBooleanArrayCriticalRW, ScopedByteArrayCriticalRW, and so on are the read-write
+// equivalents, with the same restrictions.
+#define INSTANTIATE_SCOPED_PRIMITIVE_ARRAY_CRITICAL_RW(PRIMITIVE_TYPE, NAME) \
+    class Scoped ## NAME ## ArrayCriticalRW { \
+    public: \
+        Scoped ## NAME ## ArrayCriticalRW(JNIEnv* env, PRIMITIVE_TYPE ## Array javaArray) \
+        : mEnv(env), mJavaArray(javaArray), mRawArray(NULL), mSize(0) { \
+            if (mJavaArray == NULL) { \
+                jniThrowNullPointerException(mEnv, NULL); \
+            } else { \
+                mSize = mEnv->GetArrayLength(mJavaArray); \
+                mRawArray = reinterpret_cast<PRIMITIVE_TYPE*>( \
+                        mEnv->GetPrimitiveArrayCritical(mJavaArray, NULL)); \
+            } \
+        } \
+        ~Scoped ## NAME ## ArrayCriticalRW() { \
+            if (mRawArray) { \
+                mEnv->ReleasePrimitiveArrayCritical(mJavaArray, mRawArray, 0); \
+            } \
+        } \
+        const PRIMITIVE_TYPE* get() const { return mRawArray; } \
+        const PRIMITIVE_TYPE& operator[](size_t n) const { return mRawArray[n]; } \
+        PRIMITIVE_TYPE* get() { return mRawArray; } \
+        PRIMITIVE_TYPE& operator[](size_t n) { return mRawArray[n]; } \
+        size_t size() const { return mSize; } \
+    private: \
+        JNIEnv* mEnv; \
+        PRIMITIVE_TYPE ## Array mJavaArray; \
+        PRIMITIVE_TYPE* mRawArray; \
+        size_t mSize; \
+        Scoped ## NAME ## ArrayCriticalRW(const Scoped ## NAME ## ArrayCriticalRW&); \
+        void operator=(const Scoped ## NAME ## ArrayCriticalRW&); \
+    }
+
+INSTANTIATE_SCOPED_PRIMITIVE_ARRAY_CRITICAL_RW(jboolean, Boolean);
+INSTANTIATE_SCOPED_PRIMITIVE_ARRAY_CRITICAL_RW(jbyte, Byte);
+INSTANTIATE_SCOPED_PRIMITIVE_ARRAY_CRITICAL_RW(jchar, Char);
+INSTANTIATE_SCOPED_PRIMITIVE_ARRAY_CRITICAL_RW(jdouble, Double);
+INSTANTIATE_SCOPED_PRIMITIVE_ARRAY_CRITICAL_RW(jfloat, Float);
+INSTANTIATE_SCOPED_PRIMITIVE_ARRAY_CRITICAL_RW(jint, Int);
+INSTANTIATE_SCOPED_PRIMITIVE_ARRAY_CRITICAL_RW(jlong, Long);
+INSTANTIATE_SCOPED_PRIMITIVE_ARRAY_CRITICAL_RW(jshort, Short);
+
+#undef INSTANTIATE_SCOPED_PRIMITIVE_ARRAY_CRITICAL_RW
+
 #endif  // SCOPED_PRIMITIVE_ARRAY_H_included
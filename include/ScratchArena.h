@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SCRATCH_ARENA_H_included
+#define SCRATCH_ARENA_H_included
+
+#include <pthread.h>
+#include <stdlib.h>
+
+/**
+ * A per-thread stack of scratch memory for native methods that need a temporary buffer bigger
+ * than is sensible to put on the stack. The block is allocated on a thread's first use, grown
+ * as needed up to MAX_BYTE_COUNT, and kept until the thread exits, so a thread that repeatedly
+ * needs a few KiB allocates it once.
+ *
+ * Allocations are expected to be released in the reverse order they were made, on the thread
+ * that made them, which scoped users such as LocalArray guarantee, even across nested native
+ * calls. allocate returns NULL if the request doesn't fit, and the caller should fall back to
+ * the heap.
+ */
+class ScratchArena {
+public:
+    // Bigger requests are left to the heap, so no thread sits on more than this.
+    static const size_t MAX_BYTE_COUNT = 128 * 1024;
+
+    // Returns the calling thread's arena, or NULL if it couldn't be created.
+    static ScratchArena* get() {
+        pthread_once(&keyOnce(), makeKey);
+        ScratchArena* arena = reinterpret_cast<ScratchArena*>(pthread_getspecific(key()));
+        if (arena == NULL) {
+            arena = new ScratchArena;
+            if (arena != NULL) {
+                pthread_setspecific(key(), arena);
+            }
+        }
+        return arena;
+    }
+
+    void* allocate(size_t byteCount) {
+        size_t rounded = roundUp(byteCount);
+        if (rounded > MAX_BYTE_COUNT || rounded < byteCount) {
+            return NULL;
+        }
+        if (mUsed + rounded > mCapacity) {
+            // Only grow when nothing is outstanding, since growing moves the block.
+            if (mOutstanding != 0) {
+                return NULL;
+            }
+            size_t newCapacity = (mCapacity * 2 < MAX_BYTE_COUNT) ? mCapacity * 2 : MAX_BYTE_COUNT;
+            if (newCapacity < rounded) {
+                newCapacity = rounded;
+            }
+            char* bigger = reinterpret_cast<char*>(malloc(newCapacity));
+            if (bigger == NULL) {
+                return NULL;
+            }
+            free(mBase);
+            mBase = bigger;
+            mCapacity = newCapacity;
+            mUsed = 0;
+        }
+        void* result = mBase + mUsed;
+        mUsed += rounded;
+        ++mOutstanding;
+        return result;
+    }
+
+    // Releases 'p', the result of allocate(byteCount). Out-of-order releases are tolerated:
+    // their space is reclaimed once everything allocated since has been released too.
+    void release(void* p, size_t byteCount) {
+        if (reinterpret_cast<char*>(p) + roundUp(byteCount) == mBase + mUsed) {
+            mUsed -= roundUp(byteCount);
+        }
+        if (--mOutstanding == 0) {
+            mUsed = 0;
+        }
+    }
+
+private:
+    static const size_t ALIGNMENT = 16;
+
+    ScratchArena() : mBase(NULL), mCapacity(0), mUsed(0), mOutstanding(0) {
+    }
+
+    ~ScratchArena() {
+        free(mBase);
+    }
+
+    // Function-local statics, so this header needs no separate definitions.
+    static pthread_key_t& key() {
+        static pthread_key_t key;
+        return key;
+    }
+
+    static pthread_once_t& keyOnce() {
+        static pthread_once_t once = PTHREAD_ONCE_INIT;
+        return once;
+    }
+
+    static size_t roundUp(size_t byteCount) {
+        return (byteCount + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    }
+
+    static void makeKey() {
+        pthread_key_create(&key(), destroy);
+    }
+
+    static void destroy(void* arena) {
+        delete reinterpret_cast<ScratchArena*>(arena);
+    }
+
+    char* mBase;
+    size_t mCapacity;
+    size_t mUsed;
+    size_t mOutstanding;
+
+    // Disallow copy and assignment.
+    ScratchArena(const ScratchArena&);
+    void operator=(const ScratchArena&);
+};
+
+#endif  // SCRATCH_ARENA_H_included
@@ -70,6 +70,45 @@ public class JSONTokener {
      */
     private int pos;
 
+    /*
+     * Token types on the tape. These must be kept in sync with the TokenType
+     * enum in org_json_JSONTokener.cpp.
+     */
+    private static final int TOKEN_END = 0;
+    private static final int TOKEN_ERROR = 1;
+    private static final int TOKEN_BEGIN_OBJECT = 2;
+    private static final int TOKEN_END_OBJECT = 3;
+    private static final int TOKEN_BEGIN_ARRAY = 4;
+    private static final int TOKEN_END_ARRAY = 5;
+    private static final int TOKEN_NAME_SEPARATOR = 6;
+    private static final int TOKEN_VALUE_SEPARATOR = 7;
+    private static final int TOKEN_STRING = 8;
+    private static final int TOKEN_ESCAPED_STRING = 9;
+    private static final int TOKEN_LITERAL = 10;
+    private static final int TOKEN_TRUE = 11;
+    private static final int TOKEN_FALSE = 12;
+    private static final int TOKEN_NULL = 13;
+    private static final int TOKEN_INTEGER = 14;
+
+    /**
+     * Thrown when the tape doesn't hold a well-formed value. We never report
+     * it; we parse the value again a character at a time instead, to fail in
+     * exactly the way we always have.
+     */
+    private static final JSONException TAPE_MISMATCH = new JSONException("tape mismatch");
+
+    /**
+     * The tokens of the value {@link #nextValue} is reading, found by native
+     * code: a type, an offset and a length for each, ending with a {@code
+     * TOKEN_END} or {@code TOKEN_ERROR}. Only that one value is scanned, so
+     * callers that mix {@code nextValue} with the character-level methods
+     * below never cause the rest of the input to be scanned again.
+     */
+    private int[] tape;
+
+    /** The index in {@link #tape} of the next token's type. */
+    private int tapeIndex;
+
     /**
      * @param in JSON encoded string. Null is not permitted and will yield a
      *     tokener that throws {@code NullPointerExceptions} when methods are
@@ -87,6 +126,174 @@ public class JSONTokener {
      * @throws JSONException if the input is malformed.
      */
     public Object nextValue() throws JSONException {
+        int start = pos;
+        tape = tokenize(in, pos);
+        tapeIndex = 0;
+        try {
+            return readValue();
+        } catch (JSONException e) {
+            pos = start;
+            return nextValueInternal();
+        } finally {
+            tape = null;
+        }
+    }
+
+    /**
+     * Returns the tokens of the value in {@code in} at {@code pos}, as
+     * described for {@link #tape}.
+     */
+    private static native int[] tokenize(String in, int pos);
+
+    /**
+     * Reads the value starting at the next token on the tape, leaving {@link
+     * #pos} just after its last token. Strings and numbers are made straight
+     * from the input without copying anything else.
+     */
+    private Object readValue() throws JSONException {
+        int type = tape[tapeIndex];
+        int offset = tape[tapeIndex + 1];
+        int length = tape[tapeIndex + 2];
+        tapeIndex += 3;
+        pos = offset + length;
+        switch (type) {
+            case TOKEN_BEGIN_OBJECT:
+                return readObjectTokens();
+
+            case TOKEN_BEGIN_ARRAY:
+                return readArrayTokens();
+
+            case TOKEN_STRING:
+                // a new string avoids leaking memory
+                return new String(in.substring(offset + 1, offset + length - 1));
+
+            case TOKEN_ESCAPED_STRING:
+                pos = offset + 1;
+                return nextString(in.charAt(offset));
+
+            case TOKEN_TRUE:
+                return Boolean.TRUE;
+
+            case TOKEN_FALSE:
+                return Boolean.FALSE;
+
+            case TOKEN_NULL:
+                return JSONObject.NULL;
+
+            case TOKEN_INTEGER:
+                return readInteger(offset, length);
+
+            case TOKEN_LITERAL:
+                pos = offset;
+                return readLiteral();
+
+            default:
+                throw TAPE_MISMATCH;
+        }
+    }
+
+    /**
+     * Returns the value of a decimal integer the tokenizer found to fit in an
+     * int, as readLiteral would.
+     */
+    private int readInteger(int offset, int length) {
+        int i = offset;
+        int end = offset + length;
+        boolean negative = in.charAt(i) == '-';
+        if (negative) {
+            i++;
+        }
+        int result = 0;
+        for (; i < end; i++) {
+            result = result * 10 + (in.charAt(i) - '0');
+        }
+        return negative ? -result : result;
+    }
+
+    /**
+     * Returns the type of the next token on the tape, moving past it.
+     */
+    private int nextToken() {
+        int type = tape[tapeIndex];
+        pos = tape[tapeIndex + 1] + tape[tapeIndex + 2];
+        tapeIndex += 3;
+        return type;
+    }
+
+    /**
+     * Like {@link #readObject}, but from the tape.
+     */
+    private JSONObject readObjectTokens() throws JSONException {
+        JSONObject result = new JSONObject();
+
+        /* Peek to see if this is the empty object. */
+        if (tape[tapeIndex] == TOKEN_END_OBJECT) {
+            nextToken();
+            return result;
+        }
+
+        while (true) {
+            Object name = readValue();
+            if (!(name instanceof String) || nextToken() != TOKEN_NAME_SEPARATOR) {
+                throw TAPE_MISMATCH;
+            }
+
+            result.put((String) name, readValue());
+
+            switch (nextToken()) {
+                case TOKEN_END_OBJECT:
+                    return result;
+                case TOKEN_VALUE_SEPARATOR:
+                    continue;
+                default:
+                    throw TAPE_MISMATCH;
+            }
+        }
+    }
+
+    /**
+     * Like {@link #readArray}, but from the tape.
+     */
+    private JSONArray readArrayTokens() throws JSONException {
+        JSONArray result = new JSONArray();
+
+        /* to cover input that ends with ",]". */
+        boolean hasTrailingSeparator = false;
+
+        while (true) {
+            switch (tape[tapeIndex]) {
+                case TOKEN_END_ARRAY:
+                    nextToken();
+                    if (hasTrailingSeparator) {
+                        result.put(null);
+                    }
+                    return result;
+                case TOKEN_VALUE_SEPARATOR:
+                    /* A separator without a value first means "null". */
+                    nextToken();
+                    result.put(null);
+                    hasTrailingSeparator = true;
+                    continue;
+            }
+
+            result.put(readValue());
+
+            switch (nextToken()) {
+                case TOKEN_END_ARRAY:
+                    return result;
+                case TOKEN_VALUE_SEPARATOR:
+                    hasTrailingSeparator = true;
+                    continue;
+                default:
+                    throw TAPE_MISMATCH;
+            }
+        }
+    }
+
+    /**
+     * Returns the next value from the input, a character at a time.
+     */
+    private Object nextValueInternal() throws JSONException {
         int c = nextCleanInternal();
         switch (c) {
             case -1:
@@ -355,7 +562,7 @@ public class JSONTokener {
         }
 
         while (true) {
-            Object name = nextValue();
+            Object name = nextValueInternal();
             if (!(name instanceof String)) {
                 if (name == null) {
                     throw syntaxError("Names cannot be null");
@@ -378,7 +585,7 @@ public class JSONTokener {
                 pos++;
             }
 
-            result.put((String) name, nextValue());
+            result.put((String) name, nextValueInternal());
 
             switch (nextCleanInternal()) {
                 case '}':
@@ -423,7 +630,7 @@ public class JSONTokener {
                     pos--;
             }
 
-            result.put(nextValue());
+            result.put(nextValueInternal());
 
             switch (nextCleanInternal()) {
                 case ']':
@@ -574,6 +574,51 @@ public class JSONTokenerTest extends TestCase {
         assertEquals("skipTo shouldn't stop when it sees '\\0'", 'F', tokener.next());
     }
 
+    public void testNextValueLenientSyntax() throws JSONException {
+        JSONObject object = (JSONObject) new JSONTokener("/* c */ {a=>'b\\u0041'; \"c\":>"
+                + "[1, -20, 012, 0x1F, 1e3, 12345678901, TRUE, null,, x\"y] # end\n}").nextValue();
+        assertEquals("bA", object.get("a"));
+        JSONArray array = object.getJSONArray("c");
+        assertEquals(10, array.length());
+        assertEquals(1, array.get(0));
+        assertEquals(-20, array.get(1));
+        assertEquals(10, array.get(2));
+        assertEquals(31, array.get(3));
+        assertEquals(1000.0, array.get(4));
+        assertEquals(12345678901L, array.get(5));
+        assertEquals(Boolean.TRUE, array.get(6));
+        assertEquals(JSONObject.NULL, array.get(7));
+        assertTrue(array.isNull(8));
+        assertEquals("x\"y", array.get(9));
+    }
+
+    public void testNextValueAfterCharacterNavigation() throws JSONException {
+        JSONTokener tokener = new JSONTokener("[1] \"two\" 3 4");
+        assertEquals(1, ((JSONArray) tokener.nextValue()).get(0));
+        assertEquals("two", tokener.nextValue());
+        assertEquals('3', tokener.nextClean());
+        tokener.back();
+        assertEquals(3, tokener.nextValue());
+        assertEquals(' ', tokener.next());
+        assertEquals(4, tokener.nextValue());
+        assertFalse(tokener.more());
+    }
+
+    public void testNextValueErrorsReportPosition() {
+        try {
+            new JSONTokener("[1,2").nextValue();
+            fail();
+        } catch (JSONException e) {
+            assertEquals("Unterminated array at character 4 of [1,2", e.getMessage());
+        }
+        try {
+            new JSONTokener("{\"a\":\"b").nextValue();
+            fail();
+        } catch (JSONException e) {
+            assertEquals("Unterminated string at character 7 of {\"a\":\"b", e.getMessage());
+        }
+    }
+
     public void testDehexchar() {
         assertEquals( 0, JSONTokener.dehexchar('0'));
         assertEquals( 1, JSONTokener.dehexchar('1'));
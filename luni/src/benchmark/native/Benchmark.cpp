@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+// Room for the handful of local references one call creates. Reps delete their own results,
+// so this doesn't grow with the rep count.
+static const jint kLocalFrameCapacity = 32;
+
+// Calibration stops doubling once one call takes this fraction of the target sample time.
+static const int kCalibrationDivisor = 4;
+
+static volatile long long gSink;
+
+Benchmark::Benchmark(const char* name) : mName(name) {
+    all().push_back(this);
+}
+
+std::vector<Benchmark*>& Benchmark::all() {
+    // A function-local static, so registration from other translation units' static
+    // initializers doesn't depend on initialization order.
+    static std::vector<Benchmark*> benchmarks;
+    return benchmarks;
+}
+
+void benchmarkSink(long long value) {
+    gSink += value;
+}
+
+jclass findGlobalClass(JNIEnv* env, const char* className) {
+    jclass c = env->FindClass(className);
+    if (c == NULL) {
+        return NULL;
+    }
+    jclass result = reinterpret_cast<jclass>(env->NewGlobalRef(c));
+    env->DeleteLocalRef(c);
+    return result;
+}
+
+jmethodID findMethod(JNIEnv* env, jclass c, const char* name, const char* signature) {
+    return (c == NULL) ? NULL : env->GetMethodID(c, name, signature);
+}
+
+jmethodID findStaticMethod(JNIEnv* env, jclass c, const char* name, const char* signature) {
+    return (c == NULL) ? NULL : env->GetStaticMethodID(c, name, signature);
+}
+
+jbyteArray newBenchmarkByteArray(JNIEnv* env, size_t length) {
+    jbyteArray array = env->NewByteArray(length);
+    if (array == NULL) {
+        return NULL;
+    }
+    std::vector<jbyte> bytes(length);
+    // Short runs of a small alphabet with an LCG-chosen symbol: deflate gets a ratio around
+    // 3:1, which is closer to real zip and jar entries than all-zero or random input.
+    unsigned int seed = 1;
+    for (size_t i = 0; i < length; ) {
+        seed = seed * 1103515245 + 12345;
+        jbyte symbol = 'a' + ((seed >> 16) % 16);
+        size_t run = 1 + ((seed >> 8) % 4);
+        for (; run > 0 && i < length; --run) {
+            bytes[i++] = symbol;
+        }
+    }
+    env->SetByteArrayRegion(array, 0, length, &bytes[0]);
+    return array;
+}
+
+static long long nowNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<long long>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// Runs 'reps' reps in a fresh local frame. Returns the elapsed time, or -1 if the benchmark
+// threw.
+static long long timeRun(JNIEnv* env, Benchmark* benchmark, int reps) {
+    if (env->PushLocalFrame(kLocalFrameCapacity) != JNI_OK) {
+        return -1;
+    }
+    long long start = nowNs();
+    benchmark->run(env, reps);
+    long long elapsed = nowNs() - start;
+    env->PopLocalFrame(NULL);
+    return env->ExceptionCheck() ? -1 : elapsed;
+}
+
+// Nearest-rank percentile of sorted 'values'.
+static double percentile(const std::vector<double>& values, int p) {
+    size_t rank = (values.size() * p + 99) / 100;
+    return values[(rank == 0) ? 0 : rank - 1];
+}
+
+struct BenchmarkResult {
+    int reps;
+    double minNs, p50Ns, p90Ns, p99Ns, maxNs, meanNs, stddevNs;
+    double mibPerSecond;
+};
+
+static bool measure(JNIEnv* env, Benchmark* benchmark, const BenchmarkOptions& options,
+        BenchmarkResult& result) {
+    const long long sampleNs = options.sampleMs * 1000000LL;
+
+    // Calibrate: double the rep count until one call is long enough to time reliably, then
+    // scale linearly to the target sample length.
+    int reps = 1;
+    long long elapsed;
+    while (true) {
+        elapsed = timeRun(env, benchmark, reps);
+        if (elapsed < 0) {
+            return false;
+        }
+        if (elapsed >= sampleNs / kCalibrationDivisor || reps >= (1 << 28)) {
+            break;
+        }
+        reps *= 2;
+    }
+    if (elapsed > 0) {
+        reps = std::max(1LL, std::min(1LL << 30, reps * sampleNs / elapsed));
+    }
+
+    const long long warmupEnd = nowNs() + options.warmupMs * 1000000LL;
+    while (nowNs() < warmupEnd) {
+        if (timeRun(env, benchmark, reps) < 0) {
+            return false;
+        }
+    }
+
+    std::vector<double> samples;
+    for (int i = 0; i < options.samples; ++i) {
+        elapsed = timeRun(env, benchmark, reps);
+        if (elapsed < 0) {
+            return false;
+        }
+        samples.push_back(static_cast<double>(elapsed) / reps);
+    }
+    std::sort(samples.begin(), samples.end());
+
+    double sum = 0;
+    for (size_t i = 0; i < samples.size(); ++i) {
+        sum += samples[i];
+    }
+    double mean = sum / samples.size();
+    double squares = 0;
+    for (size_t i = 0; i < samples.size(); ++i) {
+        squares += (samples[i] - mean) * (samples[i] - mean);
+    }
+
+    result.reps = reps;
+    result.minNs = samples.front();
+    result.p50Ns = percentile(samples, 50);
+    result.p90Ns = percentile(samples, 90);
+    result.p99Ns = percentile(samples, 99);
+    result.maxNs = samples.back();
+    result.meanNs = mean;
+    result.stddevNs = sqrt(squares / samples.size());
+    // Throughput is quoted at the median, which is steadier than the mean.
+    size_t bytes = benchmark->bytesPerRep();
+    result.mibPerSecond = (bytes == 0) ? 0 : (bytes / result.p50Ns) * 1e9 / (1024 * 1024);
+    return true;
+}
+
+// Benchmark names are plain identifiers with '/' and '_', but escape anyway so a future name
+// can't break the output.
+static void printJsonString(const char* s) {
+    putchar('"');
+    for (; *s != '\0'; ++s) {
+        if (*s == '"' || *s == '\\') {
+            putchar('\\');
+        }
+        putchar(*s);
+    }
+    putchar('"');
+}
+
+static void printResult(const Benchmark* benchmark, const BenchmarkResult& r, bool json) {
+    if (json) {
+        printf("{\"benchmark\":");
+        printJsonString(benchmark->name());
+        printf(",\"reps\":%d,\"min_ns\":%.1f,\"p50_ns\":%.1f,\"p90_ns\":%.1f,\"p99_ns\":%.1f"
+                ",\"max_ns\":%.1f,\"mean_ns\":%.1f,\"stddev_ns\":%.1f,\"bytes_per_rep\":%lu"
+                ",\"mib_per_s\":%.2f}\n",
+                r.reps, r.minNs, r.p50Ns, r.p90Ns, r.p99Ns, r.maxNs, r.meanNs, r.stddevNs,
+                static_cast<unsigned long>(benchmark->bytesPerRep()), r.mibPerSecond);
+    } else {
+        printf("%-40s %10d %12.1f %12.1f %12.1f %12.1f %8.1f%%",
+                benchmark->name(), r.reps, r.minNs, r.p50Ns, r.p90Ns, r.p99Ns,
+                100 * r.stddevNs / r.meanNs);
+        if (benchmark->bytesPerRep() != 0) {
+            printf(" %10.1f", r.mibPerSecond);
+        }
+        printf("\n");
+    }
+    fflush(stdout);
+}
+
+static void printFailure(const Benchmark* benchmark, bool json) {
+    if (json) {
+        printf("{\"benchmark\":");
+        printJsonString(benchmark->name());
+        printf(",\"failed\":true}\n");
+    } else {
+        printf("%-40s FAILED\n", benchmark->name());
+    }
+    fflush(stdout);
+}
+
+int runBenchmarks(JNIEnv* env, const BenchmarkOptions& options) {
+    if (!options.json) {
+        printf("%-40s %10s %12s %12s %12s %12s %9s %10s\n", "benchmark", "reps", "min ns",
+                "p50 ns", "p90 ns", "p99 ns", "stddev", "MiB/s");
+    }
+    int failures = 0;
+    std::vector<Benchmark*>& benchmarks(Benchmark::all());
+    for (size_t i = 0; i < benchmarks.size(); ++i) {
+        Benchmark* benchmark = benchmarks[i];
+        if (options.filter != NULL && strstr(benchmark->name(), options.filter) == NULL) {
+            continue;
+        }
+        BenchmarkResult result;
+        bool ok = benchmark->setUp(env) && !env->ExceptionCheck();
+        ok = ok && measure(env, benchmark, options, result);
+        if (env->ExceptionCheck()) {
+            env->ExceptionDescribe();
+            env->ExceptionClear();
+        }
+        benchmark->tearDown(env);
+        env->ExceptionClear();
+        if (ok) {
+            printResult(benchmark, result, options.json);
+        } else {
+            printFailure(benchmark, options.json);
+            ++failures;
+        }
+    }
+    return failures;
+}
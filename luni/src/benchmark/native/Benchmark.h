@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BENCHMARK_H_included
+#define BENCHMARK_H_included
+
+#include "jni.h"
+
+#include <stddef.h>
+#include <vector>
+
+/**
+ * A microbenchmark of one libjavacore native. Subclasses are declared as file-scope statics,
+ * which registers them with the harness, and are run by javacore-benchmark inside a freshly
+ * created VM, so the natives are reached through the same JNI dispatch callers use.
+ *
+ * The harness calls setUp once, then run(env, reps) repeatedly: first to pick a rep count
+ * that makes one sample last about --sample-ms, then for --warmup-ms without recording, then
+ * --samples times while recording ns per rep. run must do 'reps' operations and must not
+ * accumulate local references across reps; each call is wrapped in its own local frame, but
+ * Dalvik's local reference table is small. A pending exception after any call fails the
+ * benchmark.
+ *
+ * For numbers that can be compared between builds, run on an idle device with the CPU
+ * frequency fixed: set the governor of every online CPU to "performance" (or "userspace" with
+ * scaling_setspeed written) through /sys/devices/system/cpu/cpuN/cpufreq, stop thermal and
+ * mpdecision-style daemons that hotplug cores, and pin the process with --cpu. The harness
+ * warns when the governor of the CPU it runs on scales frequency.
+ */
+class Benchmark {
+public:
+    explicit Benchmark(const char* name);
+    virtual ~Benchmark() {}
+
+    const char* name() const { return mName; }
+
+    // Returns false, optionally with a pending exception, if the benchmark can't run.
+    virtual bool setUp(JNIEnv*) { return true; }
+    virtual void run(JNIEnv* env, int reps) = 0;
+    virtual void tearDown(JNIEnv*) {}
+
+    // How many bytes one rep processes, for throughput reporting. 0 if that isn't meaningful.
+    virtual size_t bytesPerRep() const { return 0; }
+
+    static std::vector<Benchmark*>& all();
+
+private:
+    const char* mName;
+
+    // Disallow copy and assignment.
+    Benchmark(const Benchmark&);
+    void operator=(const Benchmark&);
+};
+
+struct BenchmarkOptions {
+    BenchmarkOptions()
+    : filter(NULL), samples(30), warmupMs(500), sampleMs(20), json(false), cpu(-1) {
+    }
+
+    // Only benchmarks whose name contains this substring are run. NULL runs everything.
+    const char* filter;
+    int samples;
+    int warmupMs;
+    int sampleMs;
+    // Emit JSON lines (one header object, then one object per benchmark) instead of a table.
+    bool json;
+    // The CPU the process was pinned to, or -1.
+    int cpu;
+};
+
+/**
+ * Runs every registered benchmark matching 'options' and prints its results to stdout.
+ * Returns the number of benchmarks that failed.
+ */
+int runBenchmarks(JNIEnv* env, const BenchmarkOptions& options);
+
+// Helpers for the suites. Each looks up a class or member and, on failure, leaves the
+// NoClassDefFoundError or NoSuchMethodError pending and returns NULL.
+jclass findGlobalClass(JNIEnv* env, const char* className);
+jmethodID findMethod(JNIEnv* env, jclass c, const char* name, const char* signature);
+jmethodID findStaticMethod(JNIEnv* env, jclass c, const char* name, const char* signature);
+
+// Fills a new Java byte[] with 'length' bytes of deterministic, moderately compressible data.
+jbyteArray newBenchmarkByteArray(JNIEnv* env, size_t length);
+
+// Keeps the compiler from discarding a result the benchmark otherwise ignores.
+void benchmarkSink(long long value);
+
+#endif  // BENCHMARK_H_included
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * javacore-benchmark: runs the libjavacore native microbenchmarks in a new VM.
+ *
+ *   adb shell javacore-benchmark [--filter=SUBSTRING] [--samples=N] [--warmup-ms=N]
+ *       [--sample-ms=N] [--cpu=N] [--json] [--list] [-Xvm-option ...]
+ *
+ * The VM finds its boot classpath in BOOTCLASSPATH, as dalvikvm does. Arguments starting
+ * with -X or -D are passed to the VM unchanged. Don't pass -Xcheck:jni for real numbers.
+ */
+
+#include "Benchmark.h"
+
+#include <cutils/properties.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+static void usage(const char* program) {
+    fprintf(stderr, "usage: %s [--filter=SUBSTRING] [--samples=N] [--warmup-ms=N] "
+            "[--sample-ms=N] [--cpu=N] [--json] [--list] [-Xvm-option ...]\n", program);
+    exit(2);
+}
+
+static bool parseIntOption(const char* arg, const char* prefix, int* value) {
+    size_t prefixLength = strlen(prefix);
+    if (strncmp(arg, prefix, prefixLength) != 0) {
+        return false;
+    }
+    *value = atoi(arg + prefixLength);
+    return true;
+}
+
+// Reads the cpufreq governor of 'cpu' into 'governor'. Returns false if there's no cpufreq
+// driver, which is common on emulators.
+static bool readGovernor(int cpu, char* governor, size_t size) {
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/scaling_governor", cpu);
+    FILE* f = fopen(path, "r");
+    if (f == NULL) {
+        return false;
+    }
+    bool ok = (fgets(governor, size, f) != NULL);
+    fclose(f);
+    if (ok) {
+        governor[strcspn(governor, "\n")] = '\0';
+    }
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    BenchmarkOptions options;
+    bool list = false;
+    std::vector<JavaVMOption> vmOptions;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (strncmp(arg, "--filter=", 9) == 0) {
+            options.filter = arg + 9;
+        } else if (parseIntOption(arg, "--samples=", &options.samples) ||
+                parseIntOption(arg, "--warmup-ms=", &options.warmupMs) ||
+                parseIntOption(arg, "--sample-ms=", &options.sampleMs) ||
+                parseIntOption(arg, "--cpu=", &options.cpu)) {
+            // Handled.
+        } else if (strcmp(arg, "--json") == 0) {
+            options.json = true;
+        } else if (strcmp(arg, "--list") == 0) {
+            list = true;
+        } else if (strncmp(arg, "-X", 2) == 0 || strncmp(arg, "-D", 2) == 0) {
+            JavaVMOption option;
+            option.optionString = arg;
+            option.extraInfo = NULL;
+            vmOptions.push_back(option);
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (options.samples < 1 || options.sampleMs < 1 || options.warmupMs < 0) {
+        usage(argv[0]);
+    }
+
+    if (list) {
+        std::vector<Benchmark*>& benchmarks(Benchmark::all());
+        for (size_t i = 0; i < benchmarks.size(); ++i) {
+            printf("%s\n", benchmarks[i]->name());
+        }
+        return 0;
+    }
+
+    // Pin before the VM starts so its threads inherit the mask. The GC and compiler threads
+    // then compete with the benchmark for one core, which is noisier per sample but keeps
+    // every sample on the same core and frequency domain.
+    if (options.cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(options.cpu, &cpus);
+        if (sched_setaffinity(0, sizeof(cpus), &cpus) == -1) {
+            perror("sched_setaffinity");
+            return 1;
+        }
+    }
+
+    char governor[PROPERTY_VALUE_MAX] = "unknown";
+    int governorCpu = (options.cpu >= 0) ? options.cpu : 0;
+    if (readGovernor(governorCpu, governor, sizeof(governor)) &&
+            strcmp(governor, "performance") != 0 && strcmp(governor, "userspace") != 0) {
+        fprintf(stderr, "warning: cpu%d uses the '%s' cpufreq governor, so results will "
+                "vary with frequency scaling; write 'performance' to "
+                "/sys/devices/system/cpu/cpu%d/cpufreq/scaling_governor and pass --cpu=%d\n",
+                governorCpu, governor, governorCpu, governorCpu);
+    }
+
+    JavaVMInitArgs initArgs;
+    initArgs.version = JNI_VERSION_1_6;
+    initArgs.nOptions = vmOptions.size();
+    initArgs.options = vmOptions.empty() ? NULL : &vmOptions[0];
+    initArgs.ignoreUnrecognized = JNI_FALSE;
+    JavaVM* vm;
+    JNIEnv* env;
+    if (JNI_CreateJavaVM(&vm, &env, &initArgs) != JNI_OK) {
+        fprintf(stderr, "%s: couldn't create the VM\n", argv[0]);
+        return 1;
+    }
+
+    if (options.json) {
+        // The header identifies the build and conditions, so result files from different
+        // builds can be compared mechanically.
+        char fingerprint[PROPERTY_VALUE_MAX];
+        property_get("ro.build.fingerprint", fingerprint, "unknown");
+        printf("{\"format\":\"javacore-benchmark\",\"version\":1,\"fingerprint\":\"%s\""
+                ",\"cpu\":%d,\"governor\":\"%s\",\"samples\":%d,\"warmup_ms\":%d"
+                ",\"sample_ms\":%d}\n", fingerprint, options.cpu, governor, options.samples,
+                options.warmupMs, options.sampleMs);
+    }
+
+    int failures = runBenchmarks(env, options);
+    vm->DestroyJavaVM();
+    return (failures == 0) ? 0 : 1;
+}
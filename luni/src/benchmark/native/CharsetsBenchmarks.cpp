@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Benchmark.h"
+#include "ScopedLocalRef.h"
+
+#include <vector>
+
+/**
+ * Charsets.toUtf8Bytes on all-ASCII text, the common case String.getBytes sees, and on text
+ * mixing every sequence length, which defeats any ASCII fast path.
+ */
+class ToUtf8BytesBenchmark : public Benchmark {
+public:
+    ToUtf8BytesBenchmark(const char* name, bool ascii, size_t charCount)
+    : Benchmark(name), mAscii(ascii), mCharCount(charCount), mChars(NULL), mCharsets(NULL) {
+    }
+
+    virtual bool setUp(JNIEnv* env) {
+        mCharsets = findGlobalClass(env, "java/nio/charset/Charsets");
+        mToUtf8Bytes = findStaticMethod(env, mCharsets, "toUtf8Bytes", "([CII)[B");
+        if (mToUtf8Bytes == NULL) {
+            return false;
+        }
+        // 'a', LATIN SMALL LETTER E WITH ACUTE, CJK UNIFIED IDEOGRAPH-4E2D and U+1F600 as a
+        // surrogate pair: one-, two-, three- and four-byte UTF-8 sequences.
+        static const jchar kMixed[] = { 'a', 0x00e9, 0x4e2d, 0xd83d, 0xde00 };
+        const size_t mixedCount = sizeof(kMixed) / sizeof(kMixed[0]);
+        std::vector<jchar> chars(mCharCount);
+        for (size_t i = 0; i < mCharCount; ++i) {
+            chars[i] = mAscii ? ('a' + (i % 26)) : kMixed[i % mixedCount];
+        }
+        if (chars[mCharCount - 1] == 0xd83d) {
+            // Don't end on an unpaired high surrogate.
+            chars[mCharCount - 1] = 'z';
+        }
+        ScopedLocalRef<jcharArray> javaChars(env, env->NewCharArray(mCharCount));
+        if (javaChars.get() == NULL) {
+            return false;
+        }
+        env->SetCharArrayRegion(javaChars.get(), 0, mCharCount, &chars[0]);
+        mChars = reinterpret_cast<jcharArray>(env->NewGlobalRef(javaChars.get()));
+        return true;
+    }
+
+    virtual void run(JNIEnv* env, int reps) {
+        jlong total = 0;
+        for (int i = 0; i < reps; ++i) {
+            jobject bytes = env->CallStaticObjectMethod(mCharsets, mToUtf8Bytes, mChars, 0,
+                    static_cast<jint>(mCharCount));
+            if (bytes == NULL) {
+                return;
+            }
+            total += env->GetArrayLength(reinterpret_cast<jbyteArray>(bytes));
+            env->DeleteLocalRef(bytes);
+        }
+        benchmarkSink(total);
+    }
+
+    virtual void tearDown(JNIEnv* env) {
+        env->DeleteGlobalRef(mChars);
+        env->DeleteGlobalRef(mCharsets);
+        mChars = NULL;
+        mCharsets = NULL;
+    }
+
+    // Quoted in UTF-16 input bytes, so the ASCII and mixed cases are comparable.
+    virtual size_t bytesPerRep() const { return mCharCount * sizeof(jchar); }
+
+private:
+    bool mAscii;
+    size_t mCharCount;
+    jcharArray mChars;
+    jclass mCharsets;
+    jmethodID mToUtf8Bytes;
+};
+
+static ToUtf8BytesBenchmark gAsciiSmall("Charsets_toUtf8Bytes/ascii/64", true, 64);
+static ToUtf8BytesBenchmark gAsciiLarge("Charsets_toUtf8Bytes/ascii/16384", true, 16384);
+static ToUtf8BytesBenchmark gMixedSmall("Charsets_toUtf8Bytes/mixed/64", false, 64);
+static ToUtf8BytesBenchmark gMixedLarge("Charsets_toUtf8Bytes/mixed/16384", false, 16384);
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Benchmark.h"
+#include "ScopedLocalRef.h"
+
+#include <stdio.h>
+
+#include <string>
+
+/**
+ * Parses an in-memory UTF-8 document with ExpatReader and an empty DefaultHandler, so the
+ * time is ExpatParser's natives plus their upcalls for every element, attribute and run of
+ * text. The reader is reused across reps, as SAXParser users typically do.
+ */
+class ExpatParseBenchmark : public Benchmark {
+public:
+    ExpatParseBenchmark(const char* name, int elementCount)
+    : Benchmark(name), mElementCount(elementCount), mReader(NULL), mDocument(NULL),
+      mInputStreamClass(NULL), mInputSourceClass(NULL), mDocumentLength(0) {
+    }
+
+    virtual bool setUp(JNIEnv* env) {
+        ScopedLocalRef<jclass> readerClass(env,
+                env->FindClass("org/apache/harmony/xml/ExpatReader"));
+        ScopedLocalRef<jclass> handlerClass(env,
+                env->FindClass("org/xml/sax/helpers/DefaultHandler"));
+        mInputStreamClass = findGlobalClass(env, "java/io/ByteArrayInputStream");
+        mInputSourceClass = findGlobalClass(env, "org/xml/sax/InputSource");
+        jmethodID readerConstructor = findMethod(env, readerClass.get(), "<init>", "()V");
+        jmethodID handlerConstructor = findMethod(env, handlerClass.get(), "<init>", "()V");
+        jmethodID setContentHandler = findMethod(env, readerClass.get(), "setContentHandler",
+                "(Lorg/xml/sax/ContentHandler;)V");
+        mParse = findMethod(env, readerClass.get(), "parse", "(Lorg/xml/sax/InputSource;)V");
+        mInputStreamConstructor = findMethod(env, mInputStreamClass, "<init>", "([B)V");
+        mInputSourceConstructor = findMethod(env, mInputSourceClass, "<init>",
+                "(Ljava/io/InputStream;)V");
+        if (readerConstructor == NULL || handlerConstructor == NULL ||
+                setContentHandler == NULL || mParse == NULL ||
+                mInputStreamConstructor == NULL || mInputSourceConstructor == NULL) {
+            return false;
+        }
+
+        std::string xml("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<feed>\n");
+        for (int i = 0; i < mElementCount; ++i) {
+            char entry[256];
+            snprintf(entry, sizeof(entry),
+                    "  <entry id=\"%d\" kind=\"%s\">\n"
+                    "    <title>Entry number %d &amp; friends</title>\n"
+                    "    <summary>Caf\xc3\xa9 menu, item %d of %d</summary>\n"
+                    "  </entry>\n",
+                    i, (i % 2 == 0) ? "post" : "comment", i, i, mElementCount);
+            xml += entry;
+        }
+        xml += "</feed>\n";
+
+        ScopedLocalRef<jbyteArray> document(env, env->NewByteArray(xml.size()));
+        ScopedLocalRef<jobject> reader(env, env->NewObject(readerClass.get(), readerConstructor));
+        ScopedLocalRef<jobject> handler(env,
+                env->NewObject(handlerClass.get(), handlerConstructor));
+        if (document.get() == NULL || reader.get() == NULL || handler.get() == NULL) {
+            return false;
+        }
+        env->SetByteArrayRegion(document.get(), 0, xml.size(),
+                reinterpret_cast<const jbyte*>(xml.data()));
+        env->CallVoidMethod(reader.get(), setContentHandler, handler.get());
+        mReader = env->NewGlobalRef(reader.get());
+        mDocument = reinterpret_cast<jbyteArray>(env->NewGlobalRef(document.get()));
+        mDocumentLength = xml.size();
+        return !env->ExceptionCheck();
+    }
+
+    virtual void run(JNIEnv* env, int reps) {
+        for (int i = 0; i < reps; ++i) {
+            ScopedLocalRef<jobject> in(env, env->NewObject(mInputStreamClass,
+                    mInputStreamConstructor, mDocument));
+            ScopedLocalRef<jobject> source(env, env->NewObject(mInputSourceClass,
+                    mInputSourceConstructor, in.get()));
+            if (source.get() == NULL) {
+                return;
+            }
+            env->CallVoidMethod(mReader, mParse, source.get());
+            if (env->ExceptionCheck()) {
+                return;
+            }
+        }
+    }
+
+    virtual void tearDown(JNIEnv* env) {
+        env->DeleteGlobalRef(mReader);
+        env->DeleteGlobalRef(mDocument);
+        env->DeleteGlobalRef(mInputStreamClass);
+        env->DeleteGlobalRef(mInputSourceClass);
+        mReader = mDocument = NULL;
+        mInputStreamClass = mInputSourceClass = NULL;
+    }
+
+    virtual size_t bytesPerRep() const { return mDocumentLength; }
+
+private:
+    int mElementCount;
+    jobject mReader;
+    jbyteArray mDocument;
+    jclass mInputStreamClass;
+    jclass mInputSourceClass;
+    jmethodID mInputStreamConstructor;
+    jmethodID mInputSourceConstructor;
+    jmethodID mParse;
+    size_t mDocumentLength;
+};
+
+static ExpatParseBenchmark gExpatSmall("ExpatParser_parse/8", 8);
+static ExpatParseBenchmark gExpatLarge("ExpatParser_parse/512", 512);
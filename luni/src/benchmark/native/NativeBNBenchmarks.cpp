@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Benchmark.h"
+#include "ScopedLocalRef.h"
+
+#include <string>
+
+/**
+ * NativeBN.BN_mod_exp with a fixed odd modulus, as BigInteger.modPow does for RSA and
+ * Diffie-Hellman. Reusing the modulus means steady state includes NativeBN's per-thread
+ * Montgomery context cache, as it would for a server doing repeated handshakes. A full-width
+ * exponent models private-key operations; 65537 models public-key ones.
+ */
+class ModExpBenchmark : public Benchmark {
+public:
+    ModExpBenchmark(const char* name, int bits, bool smallExponent)
+    : Benchmark(name), mBits(bits), mSmallExponent(smallExponent), mNativeBN(NULL) {
+        for (int i = 0; i < kBignumCount; ++i) {
+            mBignums[i] = 0;
+        }
+    }
+
+    virtual bool setUp(JNIEnv* env) {
+        mNativeBN = findGlobalClass(env, "java/math/NativeBN");
+        jmethodID newBignum = findStaticMethod(env, mNativeBN, "BN_new", "()I");
+        jmethodID hex2bn = findStaticMethod(env, mNativeBN, "BN_hex2bn",
+                "(ILjava/lang/String;)I");
+        mModExp = findStaticMethod(env, mNativeBN, "BN_mod_exp", "(IIII)Z");
+        if (newBignum == NULL || hex2bn == NULL || mModExp == NULL) {
+            return false;
+        }
+        for (int i = 0; i < kBignumCount; ++i) {
+            mBignums[i] = env->CallStaticIntMethod(mNativeBN, newBignum);
+            if (env->ExceptionCheck()) {
+                return false;
+            }
+        }
+        const std::string values[] = {
+            hexDigits(mBits - 8, 1),                                    // base
+            mSmallExponent ? std::string("10001") : hexDigits(mBits, 2), // exponent
+            hexDigits(mBits, 3),                                        // modulus
+        };
+        for (int i = 0; i < 3; ++i) {
+            ScopedLocalRef<jstring> hex(env, env->NewStringUTF(values[i].c_str()));
+            if (hex.get() == NULL) {
+                return false;
+            }
+            env->CallStaticIntMethod(mNativeBN, hex2bn, mBignums[kBase + i], hex.get());
+            if (env->ExceptionCheck()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    virtual void run(JNIEnv* env, int reps) {
+        for (int i = 0; i < reps; ++i) {
+            env->CallStaticBooleanMethod(mNativeBN, mModExp, mBignums[kResult], mBignums[kBase],
+                    mBignums[kExponent], mBignums[kModulus]);
+        }
+    }
+
+    virtual void tearDown(JNIEnv* env) {
+        jmethodID freeBignum = findStaticMethod(env, mNativeBN, "BN_free", "(I)V");
+        for (int i = 0; i < kBignumCount; ++i) {
+            if (freeBignum != NULL && mBignums[i] != 0) {
+                env->CallStaticVoidMethod(mNativeBN, freeBignum, mBignums[i]);
+            }
+            mBignums[i] = 0;
+        }
+        env->DeleteGlobalRef(mNativeBN);
+        mNativeBN = NULL;
+    }
+
+private:
+    // Returns 'bits' bits of deterministic hex with the top bit set, odd, so it's also usable
+    // as a Montgomery modulus. Different seeds give unrelated values.
+    static std::string hexDigits(int bits, unsigned int seed) {
+        static const char kHex[] = "0123456789abcdef";
+        std::string result;
+        for (int i = 0; i < bits / 4; ++i) {
+            seed = seed * 1103515245 + 12345;
+            result += kHex[(seed >> 16) & 0xf];
+        }
+        result[0] = 'c';
+        result[result.size() - 1] = '1';
+        return result;
+    }
+
+    enum { kBase, kExponent, kModulus, kResult, kBignumCount };
+
+    int mBits;
+    bool mSmallExponent;
+    jclass mNativeBN;
+    jmethodID mModExp;
+    jint mBignums[kBignumCount];
+};
+
+static ModExpBenchmark gModExp1024("NativeBN_BN_mod_exp/1024", 1024, false);
+static ModExpBenchmark gModExp2048("NativeBN_BN_mod_exp/2048", 2048, false);
+static ModExpBenchmark gModExp2048Public("NativeBN_BN_mod_exp/2048/e65537", 2048, true);
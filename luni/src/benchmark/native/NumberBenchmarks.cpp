@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Benchmark.h"
+#include "ScopedLocalRef.h"
+
+#include <vector>
+
+/**
+ * FloatingPointParser.parseDblImpl on the (digits, exponent) pairs Double.parseDouble hands it
+ * after stripping the sign, point and exponent: a short decimal, a full 17-digit mantissa, a
+ * value near Double.MAX_VALUE, and a denormal, which takes the slow big-integer path.
+ */
+class ParseDoubleBenchmark : public Benchmark {
+public:
+    ParseDoubleBenchmark() : Benchmark("FloatingPointParser_parseDblImpl"), mParser(NULL) {
+    }
+
+    virtual bool setUp(JNIEnv* env) {
+        mParser = findGlobalClass(env, "org/apache/harmony/luni/util/FloatingPointParser");
+        mParseDblImpl = findStaticMethod(env, mParser, "parseDblImpl", "(Ljava/lang/String;I)D");
+        if (mParseDblImpl == NULL) {
+            return false;
+        }
+        for (size_t i = 0; i < kInputCount; ++i) {
+            ScopedLocalRef<jstring> digits(env, env->NewStringUTF(kInputs[i].digits));
+            if (digits.get() == NULL) {
+                return false;
+            }
+            mDigits.push_back(reinterpret_cast<jstring>(env->NewGlobalRef(digits.get())));
+        }
+        return true;
+    }
+
+    virtual void run(JNIEnv* env, int reps) {
+        double total = 0;
+        for (int i = 0; i < reps; ++i) {
+            const Input& input = kInputs[i % kInputCount];
+            total += env->CallStaticDoubleMethod(mParser, mParseDblImpl, mDigits[i % kInputCount],
+                    input.exponent);
+        }
+        benchmarkSink(static_cast<long long>(total));
+    }
+
+    virtual void tearDown(JNIEnv* env) {
+        for (size_t i = 0; i < mDigits.size(); ++i) {
+            env->DeleteGlobalRef(mDigits[i]);
+        }
+        mDigits.clear();
+        env->DeleteGlobalRef(mParser);
+        mParser = NULL;
+    }
+
+private:
+    struct Input {
+        const char* digits;
+        jint exponent;
+    };
+    static const Input kInputs[];
+    static const size_t kInputCount;
+
+    jclass mParser;
+    jmethodID mParseDblImpl;
+    std::vector<jstring> mDigits;
+};
+
+const ParseDoubleBenchmark::Input ParseDoubleBenchmark::kInputs[] = {
+    { "125", -2 },                  // 1.25
+    { "31415926535897932", -16 },   // 3.1415926535897932
+    { "17976931348623157", 292 },   // 1.7976931348623157E308
+    { "49406564584124654", -340 },  // 4.9406564584124654E-324
+};
+const size_t ParseDoubleBenchmark::kInputCount =
+        sizeof(ParseDoubleBenchmark::kInputs) / sizeof(ParseDoubleBenchmark::kInputs[0]);
+
+static ParseDoubleBenchmark gParseDouble;
+
+/**
+ * Double.toString on values whose binary exponent is outside the range RealToString handles
+ * in Java, so every rep reaches the shortestDigitGenerator native.
+ */
+class DoubleToStringBenchmark : public Benchmark {
+public:
+    DoubleToStringBenchmark() : Benchmark("RealToString_shortestDigitGenerator"), mDouble(NULL) {
+    }
+
+    virtual bool setUp(JNIEnv* env) {
+        mDouble = findGlobalClass(env, "java/lang/Double");
+        mToString = findStaticMethod(env, mDouble, "toString", "(D)Ljava/lang/String;");
+        return mToString != NULL;
+    }
+
+    virtual void run(JNIEnv* env, int reps) {
+        static const double kValues[] = { 6.02214179e23, 1.7976931348623157e308, 1.0e-200,
+                2.2250738585072014e-308, 123456789.0e30 };
+        static const size_t kValueCount = sizeof(kValues) / sizeof(kValues[0]);
+        jlong total = 0;
+        for (int i = 0; i < reps; ++i) {
+            jobject s = env->CallStaticObjectMethod(mDouble, mToString, kValues[i % kValueCount]);
+            if (s == NULL) {
+                return;
+            }
+            total += env->GetStringLength(reinterpret_cast<jstring>(s));
+            env->DeleteLocalRef(s);
+        }
+        benchmarkSink(total);
+    }
+
+    virtual void tearDown(JNIEnv* env) {
+        env->DeleteGlobalRef(mDouble);
+        mDouble = NULL;
+    }
+
+private:
+    jclass mDouble;
+    jmethodID mToString;
+};
+
+static DoubleToStringBenchmark gDoubleToString;
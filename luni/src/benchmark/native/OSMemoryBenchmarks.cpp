@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Benchmark.h"
+#include "ScopedLocalRef.h"
+
+/**
+ * OSMemory's byte-swapping array peeks and pokes between a Java array and native memory, as
+ * a ByteBuffer in non-native order does for asIntBuffer().get(int[]) and friends. Swapping
+ * is the slow path, so it's the one worth tracking.
+ */
+class SwapBenchmark : public Benchmark {
+public:
+    SwapBenchmark(const char* name, const char* method, char elementType, size_t elementSize,
+            size_t count)
+    : Benchmark(name), mMethod(method), mElementType(elementType), mElementSize(elementSize),
+      mCount(count), mOSMemory(NULL), mArray(NULL), mAddress(0) {
+    }
+
+    virtual bool setUp(JNIEnv* env) {
+        mOSMemory = findGlobalClass(env, "org/apache/harmony/luni/platform/OSMemory");
+        // peekIntArray is "(I[IIIZ)V", pokeLongArray "(I[JIIZ)V" and so on.
+        char signature[] = "(I[?IIZ)V";
+        signature[3] = mElementType;
+        mPeekOrPoke = findStaticMethod(env, mOSMemory, mMethod, signature);
+        jmethodID mallocMethod = findStaticMethod(env, mOSMemory, "malloc", "(I)I");
+        if (mPeekOrPoke == NULL || mallocMethod == NULL) {
+            return false;
+        }
+        jobject array;
+        switch (mElementType) {
+        case 'S': array = env->NewShortArray(mCount); break;
+        case 'I': array = env->NewIntArray(mCount); break;
+        default: array = env->NewLongArray(mCount); break;
+        }
+        ScopedLocalRef<jobject> localArray(env, array);
+        if (array == NULL) {
+            return false;
+        }
+        mArray = env->NewGlobalRef(array);
+        mAddress = env->CallStaticIntMethod(mOSMemory, mallocMethod,
+                static_cast<jint>(mCount * mElementSize));
+        return !env->ExceptionCheck();
+    }
+
+    virtual void run(JNIEnv* env, int reps) {
+        for (int i = 0; i < reps; ++i) {
+            env->CallStaticVoidMethod(mOSMemory, mPeekOrPoke, mAddress, mArray, 0,
+                    static_cast<jint>(mCount), JNI_TRUE);
+        }
+    }
+
+    virtual void tearDown(JNIEnv* env) {
+        if (mAddress != 0) {
+            jmethodID freeMethod = findStaticMethod(env, mOSMemory, "free", "(I)V");
+            env->CallStaticVoidMethod(mOSMemory, freeMethod, mAddress);
+            mAddress = 0;
+        }
+        env->DeleteGlobalRef(mArray);
+        env->DeleteGlobalRef(mOSMemory);
+        mArray = NULL;
+        mOSMemory = NULL;
+    }
+
+    virtual size_t bytesPerRep() const { return mCount * mElementSize; }
+
+private:
+    const char* mMethod;
+    char mElementType;
+    size_t mElementSize;
+    size_t mCount;
+    jclass mOSMemory;
+    jmethodID mPeekOrPoke;
+    jobject mArray;
+    jint mAddress;
+};
+
+static SwapBenchmark gPeekShort("OSMemory_peekShortArray/swap/4096", "peekShortArray", 'S', 2,
+        4096);
+static SwapBenchmark gPokeShort("OSMemory_pokeShortArray/swap/4096", "pokeShortArray", 'S', 2,
+        4096);
+static SwapBenchmark gPeekInt("OSMemory_peekIntArray/swap/16", "peekIntArray", 'I', 4, 16);
+static SwapBenchmark gPeekIntLarge("OSMemory_peekIntArray/swap/4096", "peekIntArray", 'I', 4, 4096);
+static SwapBenchmark gPokeInt("OSMemory_pokeIntArray/swap/16", "pokeIntArray", 'I', 4, 16);
+static SwapBenchmark gPokeIntLarge("OSMemory_pokeIntArray/swap/4096", "pokeIntArray", 'I', 4, 4096);
+static SwapBenchmark gPeekLong("OSMemory_peekLongArray/swap/4096", "peekLongArray", 'J', 8, 4096);
+static SwapBenchmark gPokeLong("OSMemory_pokeLongArray/swap/4096", "pokeLongArray", 'J', 8, 4096);
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Benchmark.h"
+#include "ScopedLocalRef.h"
+
+#include <stdio.h>
+
+#include <string>
+
+/**
+ * Finds every match of a pattern in a few KiB of text with one Matcher, resetting it each
+ * rep, so the cost is Matcher.find's trips through findNextImpl into ICU rather than
+ * compilation or Matcher allocation.
+ */
+class RegexFindBenchmark : public Benchmark {
+public:
+    RegexFindBenchmark(const char* name, const char* regex)
+    : Benchmark(name), mRegex(regex), mMatcher(NULL), mTextLength(0) {
+    }
+
+    virtual bool setUp(JNIEnv* env) {
+        ScopedLocalRef<jclass> patternClass(env, env->FindClass("java/util/regex/Pattern"));
+        ScopedLocalRef<jclass> matcherClass(env, env->FindClass("java/util/regex/Matcher"));
+        jmethodID compile = findStaticMethod(env, patternClass.get(), "compile",
+                "(Ljava/lang/String;)Ljava/util/regex/Pattern;");
+        jmethodID matcher = findMethod(env, patternClass.get(), "matcher",
+                "(Ljava/lang/CharSequence;)Ljava/util/regex/Matcher;");
+        mFind = findMethod(env, matcherClass.get(), "find", "()Z");
+        mReset = findMethod(env, matcherClass.get(), "reset", "()Ljava/util/regex/Matcher;");
+        if (compile == NULL || matcher == NULL || mFind == NULL || mReset == NULL) {
+            return false;
+        }
+
+        // Log-like lines, about a quarter of which contain an address.
+        std::string text;
+        for (int i = 0; text.size() < 4096; ++i) {
+            char line[128];
+            snprintf(line, sizeof(line), (i % 4 == 0)
+                    ? "%05d INFO request from user%d@example.com took %d ms\n"
+                    : "%05d DEBUG cache lookup %d returned %d entries\n", i, i * 7, i % 97);
+            text += line;
+        }
+        ScopedLocalRef<jstring> javaRegex(env, env->NewStringUTF(mRegex));
+        ScopedLocalRef<jstring> javaText(env, env->NewStringUTF(text.c_str()));
+        if (javaRegex.get() == NULL || javaText.get() == NULL) {
+            return false;
+        }
+        ScopedLocalRef<jobject> pattern(env,
+                env->CallStaticObjectMethod(patternClass.get(), compile, javaRegex.get()));
+        if (pattern.get() == NULL) {
+            return false;
+        }
+        ScopedLocalRef<jobject> m(env, env->CallObjectMethod(pattern.get(), matcher,
+                javaText.get()));
+        if (m.get() == NULL) {
+            return false;
+        }
+        mMatcher = env->NewGlobalRef(m.get());
+        mTextLength = text.size();
+        return true;
+    }
+
+    virtual void run(JNIEnv* env, int reps) {
+        jlong matches = 0;
+        for (int i = 0; i < reps; ++i) {
+            env->DeleteLocalRef(env->CallObjectMethod(mMatcher, mReset));
+            while (env->CallBooleanMethod(mMatcher, mFind)) {
+                ++matches;
+            }
+        }
+        benchmarkSink(matches);
+    }
+
+    virtual void tearDown(JNIEnv* env) {
+        env->DeleteGlobalRef(mMatcher);
+        mMatcher = NULL;
+    }
+
+    // Quoted in UTF-16 bytes scanned.
+    virtual size_t bytesPerRep() const { return mTextLength * sizeof(jchar); }
+
+private:
+    const char* mRegex;
+    jobject mMatcher;
+    jmethodID mFind;
+    jmethodID mReset;
+    size_t mTextLength;
+};
+
+static RegexFindBenchmark gFindLiteral("Matcher_find/literal", "took");
+static RegexFindBenchmark gFindEmail("Matcher_find/email", "[a-z0-9]+@[a-z]+\\.com");
+static RegexFindBenchmark gFindGroups("Matcher_find/groups", "(\\d+) (INFO|DEBUG) (\\w+)");
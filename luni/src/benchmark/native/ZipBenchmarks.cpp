@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Benchmark.h"
+#include "ScopedLocalRef.h"
+
+/**
+ * Calls CRC32.updateImpl or Adler32.updateImpl directly, so the number is the native's cost
+ * plus one JNI call, without the Java-side bounds checks.
+ */
+class ChecksumBenchmark : public Benchmark {
+public:
+    ChecksumBenchmark(const char* name, const char* className, size_t byteCount)
+    : Benchmark(name), mClassName(className), mByteCount(byteCount),
+      mChecksum(NULL), mBytes(NULL), mUpdateImpl(NULL) {
+    }
+
+    virtual bool setUp(JNIEnv* env) {
+        ScopedLocalRef<jclass> c(env, env->FindClass(mClassName));
+        jmethodID constructor = findMethod(env, c.get(), "<init>", "()V");
+        mUpdateImpl = findMethod(env, c.get(), "updateImpl", "([BIIJ)J");
+        if (constructor == NULL || mUpdateImpl == NULL) {
+            return false;
+        }
+        ScopedLocalRef<jobject> checksum(env, env->NewObject(c.get(), constructor));
+        ScopedLocalRef<jbyteArray> bytes(env, newBenchmarkByteArray(env, mByteCount));
+        if (checksum.get() == NULL || bytes.get() == NULL) {
+            return false;
+        }
+        mChecksum = env->NewGlobalRef(checksum.get());
+        mBytes = reinterpret_cast<jbyteArray>(env->NewGlobalRef(bytes.get()));
+        return true;
+    }
+
+    virtual void run(JNIEnv* env, int reps) {
+        jlong value = 0;
+        for (int i = 0; i < reps; ++i) {
+            value = env->CallLongMethod(mChecksum, mUpdateImpl, mBytes, 0,
+                    static_cast<jint>(mByteCount), value);
+        }
+        benchmarkSink(value);
+    }
+
+    virtual void tearDown(JNIEnv* env) {
+        env->DeleteGlobalRef(mChecksum);
+        env->DeleteGlobalRef(mBytes);
+        mChecksum = mBytes = NULL;
+    }
+
+    virtual size_t bytesPerRep() const { return mByteCount; }
+
+private:
+    const char* mClassName;
+    size_t mByteCount;
+    jobject mChecksum;
+    jbyteArray mBytes;
+    jmethodID mUpdateImpl;
+};
+
+static ChecksumBenchmark gCrc32Small("CRC32_updateImpl/64", "java/util/zip/CRC32", 64);
+static ChecksumBenchmark gCrc32Medium("CRC32_updateImpl/4096", "java/util/zip/CRC32", 4096);
+static ChecksumBenchmark gCrc32Large("CRC32_updateImpl/1048576", "java/util/zip/CRC32", 1 << 20);
+static ChecksumBenchmark gAdler32Small("Adler32_updateImpl/64", "java/util/zip/Adler32", 64);
+static ChecksumBenchmark gAdler32Medium("Adler32_updateImpl/4096", "java/util/zip/Adler32", 4096);
+static ChecksumBenchmark gAdler32Large("Adler32_updateImpl/1048576", "java/util/zip/Adler32",
+        1 << 20);
+
+/**
+ * Deflates or inflates a whole buffer per rep through the public Deflater and Inflater API,
+ * reusing one stream with reset(), the way ZipOutputStream and ZipFile do. Most of the time
+ * is in deflateImpl and inflateImpl; the rest is what every caller pays anyway.
+ */
+class ZipStreamBenchmark : public Benchmark {
+public:
+    ZipStreamBenchmark(const char* name, bool inflate, size_t byteCount)
+    : Benchmark(name), mInflate(inflate), mByteCount(byteCount),
+      mStream(NULL), mInput(NULL), mOutput(NULL) {
+    }
+
+    virtual bool setUp(JNIEnv* env) {
+        ScopedLocalRef<jclass> deflaterClass(env, env->FindClass("java/util/zip/Deflater"));
+        ScopedLocalRef<jclass> inflaterClass(env, env->FindClass("java/util/zip/Inflater"));
+        jclass c = mInflate ? inflaterClass.get() : deflaterClass.get();
+        jmethodID constructor = findMethod(env, c, "<init>", "()V");
+        mReset = findMethod(env, c, "reset", "()V");
+        mSetInput = findMethod(env, c, "setInput", "([B)V");
+        mFinished = findMethod(env, c, "finished", "()Z");
+        mFinish = findMethod(env, deflaterClass.get(), "finish", "()V");
+        mDeflate = findMethod(env, deflaterClass.get(), "deflate", "([B)I");
+        mInflateMethod = findMethod(env, inflaterClass.get(), "inflate", "([B)I");
+        mEnd = findMethod(env, c, "end", "()V");
+        if (constructor == NULL || mReset == NULL || mSetInput == NULL || mFinished == NULL ||
+                mFinish == NULL || mDeflate == NULL || mInflateMethod == NULL || mEnd == NULL) {
+            return false;
+        }
+
+        ScopedLocalRef<jbyteArray> input(env, newBenchmarkByteArray(env, mByteCount));
+        // Room for incompressible input plus zlib's framing, so one call can finish the stream
+        // in either direction.
+        jsize outputLength = mByteCount + mByteCount / 8 + 64;
+        ScopedLocalRef<jbyteArray> output(env, env->NewByteArray(outputLength));
+        ScopedLocalRef<jobject> stream(env, env->NewObject(c, constructor));
+        if (input.get() == NULL || output.get() == NULL || stream.get() == NULL) {
+            return false;
+        }
+        mStream = env->NewGlobalRef(stream.get());
+        if (!mInflate) {
+            mInput = reinterpret_cast<jbyteArray>(env->NewGlobalRef(input.get()));
+            mOutput = reinterpret_cast<jbyteArray>(env->NewGlobalRef(output.get()));
+            return true;
+        }
+
+        // Compress the input once with a throwaway Deflater to get the inflate input.
+        jmethodID deflaterConstructor = findMethod(env, deflaterClass.get(), "<init>", "()V");
+        jmethodID deflaterSetInput = findMethod(env, deflaterClass.get(), "setInput", "([B)V");
+        jmethodID deflaterEnd = findMethod(env, deflaterClass.get(), "end", "()V");
+        if (deflaterConstructor == NULL || deflaterSetInput == NULL || deflaterEnd == NULL) {
+            return false;
+        }
+        ScopedLocalRef<jobject> deflater(env,
+                env->NewObject(deflaterClass.get(), deflaterConstructor));
+        if (deflater.get() == NULL) {
+            return false;
+        }
+        env->CallVoidMethod(deflater.get(), deflaterSetInput, input.get());
+        env->CallVoidMethod(deflater.get(), mFinish);
+        jint compressedLength = env->CallIntMethod(deflater.get(), mDeflate, output.get());
+        env->CallVoidMethod(deflater.get(), deflaterEnd);
+        if (env->ExceptionCheck()) {
+            return false;
+        }
+        ScopedLocalRef<jbyteArray> compressed(env, env->NewByteArray(compressedLength));
+        if (compressed.get() == NULL) {
+            return false;
+        }
+        jbyte* bytes = env->GetByteArrayElements(output.get(), NULL);
+        env->SetByteArrayRegion(compressed.get(), 0, compressedLength, bytes);
+        env->ReleaseByteArrayElements(output.get(), bytes, JNI_ABORT);
+        mInput = reinterpret_cast<jbyteArray>(env->NewGlobalRef(compressed.get()));
+        mOutput = reinterpret_cast<jbyteArray>(env->NewGlobalRef(output.get()));
+        return true;
+    }
+
+    virtual void run(JNIEnv* env, int reps) {
+        jmethodID step = mInflate ? mInflateMethod : mDeflate;
+        jlong total = 0;
+        for (int i = 0; i < reps; ++i) {
+            env->CallVoidMethod(mStream, mReset);
+            env->CallVoidMethod(mStream, mSetInput, mInput);
+            if (!mInflate) {
+                env->CallVoidMethod(mStream, mFinish);
+            }
+            while (!env->CallBooleanMethod(mStream, mFinished)) {
+                jint count = env->CallIntMethod(mStream, step, mOutput);
+                if (env->ExceptionCheck() || count == 0) {
+                    // A 0 here means the stream wants input or a dictionary it won't get;
+                    // stop rather than spin.
+                    return;
+                }
+                total += count;
+            }
+        }
+        benchmarkSink(total);
+    }
+
+    virtual void tearDown(JNIEnv* env) {
+        if (mStream != NULL) {
+            env->CallVoidMethod(mStream, mEnd);
+        }
+        env->DeleteGlobalRef(mStream);
+        env->DeleteGlobalRef(mInput);
+        env->DeleteGlobalRef(mOutput);
+        mStream = mInput = mOutput = NULL;
+    }
+
+    // Both directions are quoted in uncompressed bytes.
+    virtual size_t bytesPerRep() const { return mByteCount; }
+
+private:
+    bool mInflate;
+    size_t mByteCount;
+    jobject mStream;
+    jbyteArray mInput;
+    jbyteArray mOutput;
+    jmethodID mReset;
+    jmethodID mSetInput;
+    jmethodID mFinished;
+    jmethodID mFinish;
+    jmethodID mDeflate;
+    jmethodID mInflateMethod;
+    jmethodID mEnd;
+};
+
+static ZipStreamBenchmark gDeflaterSmall("Deflater_deflate/4096", false, 4096);
+static ZipStreamBenchmark gDeflaterLarge("Deflater_deflate/262144", false, 256 * 1024);
+static ZipStreamBenchmark gInflaterSmall("Inflater_inflate/4096", true, 4096);
+static ZipStreamBenchmark gInflaterLarge("Inflater_inflate/262144", true, 256 * 1024);
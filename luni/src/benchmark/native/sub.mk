@@ -0,0 +1,19 @@
+# This file is included by the top-level libcore Android.mk.
+# It's not a normal makefile, so we don't include CLEAR_VARS
+# or BUILD_*_LIBRARY.
+
+LOCAL_SRC_FILES := \
+	Benchmark.cpp \
+	BenchmarkMain.cpp \
+	CharsetsBenchmarks.cpp \
+	ExpatBenchmarks.cpp \
+	NativeBNBenchmarks.cpp \
+	NumberBenchmarks.cpp \
+	OSMemoryBenchmarks.cpp \
+	RegexBenchmarks.cpp \
+	ZipBenchmarks.cpp
+
+LOCAL_SHARED_LIBRARIES += \
+	libcutils \
+	libdvm \
+	libnativehelper
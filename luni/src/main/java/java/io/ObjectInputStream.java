@@ -1222,7 +1222,12 @@ public class ObjectInputStream extends InputStream implements ObjectInput,
             throw new ClassNotFoundException(classDesc.getName());
         }
 
-        for (ObjectStreamField fieldDesc : fields) {
+        // BEGIN android-changed
+        // Streams list the primitive fields first: read and set those in one go.
+        int firstOtherField = readPrimitiveFieldValues(obj, classDesc, fields, declaringClass);
+        for (int i = firstOtherField; i < fields.length; ++i) {
+            ObjectStreamField fieldDesc = fields[i];
+        // END android-changed
 
             // BEGIN android-removed
             // // get associated Field
@@ -1321,6 +1326,53 @@ public class ObjectInputStream extends InputStream implements ObjectInput,
         }
     }
 
+    // BEGIN android-added
+    /**
+     * Reads the values of the primitive fields at the start of {@code fields} and sets them in
+     * {@code obj} with a single native call, looking up their field IDs only the first time
+     * {@code classDesc} is used. Returns the number of fields read.
+     */
+    private int readPrimitiveFieldValues(Object obj, ObjectStreamClass classDesc,
+            ObjectStreamField[] fields, Class<?> declaringClass) throws IOException {
+        int count = 0;
+        int byteCount = 0;
+        while (count < fields.length && fields[count].isPrimitive()) {
+            char typeCode = fields[count].getTypeCode();
+            switch (typeCode) {
+                case 'B': case 'Z': byteCount += 1; break;
+                case 'C': case 'S': byteCount += 2; break;
+                case 'F': case 'I': byteCount += 4; break;
+                case 'D': case 'J': byteCount += 8; break;
+                default:
+                    throw new StreamCorruptedException("Invalid typecode: " + typeCode);
+            }
+            ++count;
+        }
+        if (count == 0) {
+            return 0;
+        }
+        byte[] values = new byte[byteCount];
+        input.readFully(values);
+        if (obj == null || declaringClass == null) {
+            return count;
+        }
+        ObjectStreamClass.PrimitiveFieldIds ids = classDesc.getPrimitiveFieldIds();
+        if (ids == null) {
+            String[] names = new String[count];
+            byte[] typeCodes = new byte[count];
+            for (int i = 0; i < count; ++i) {
+                names[i] = fields[i].getName();
+                typeCodes[i] = (byte) fields[i].getTypeCode();
+            }
+            ids = new ObjectStreamClass.PrimitiveFieldIds(
+                    getFieldIds(declaringClass, names, typeCodes), typeCodes);
+            classDesc.setPrimitiveFieldIds(ids);
+        }
+        setPrimitiveFields(obj, ids.fieldIds, ids.typeCodes, values);
+        return count;
+    }
+    // END android-added
+
     /**
      * Reads a float (32 bit) from the source stream.
      *
@@ -2637,6 +2689,20 @@ public class ObjectInputStream extends InputStream implements ObjectInput,
             Class<?> declaringClass, String fieldName, boolean value)
             throws NoSuchFieldError;
 
+    /*
+     * Returns the JNI field IDs of the primitive fields of declaringClass with the given
+     * names and type codes, with 0 for any that don't exist.
+     */
+    private static native int[] getFieldIds(Class<?> declaringClass, String[] names,
+            byte[] typeCodes);
+
+    /*
+     * Sets the primitive fields fieldIds of instance from values, which holds their values in
+     * order in the stream's format. Fields whose ID is 0 are skipped.
+     */
+    private static native void setPrimitiveFields(Object instance, int[] fieldIds,
+            byte[] typeCodes, byte[] values);
+
     // END android-added
 
     /**
@@ -117,6 +117,10 @@ public class ObjectStreamClass implements Serializable {
 
     private static final String CLINIT_SIGNATURE = "()V";
 
+    // The SUIDs computed so far for classes without a serialVersionUID field.
+    private static final WeakHashMap<Class<?>, Long> computedSerialVersionUIDs =
+            new WeakHashMap<Class<?>, Long>();
+
     // Used to determine if an object is Serializable or Externalizable
     private static final Class<Serializable> SERIALIZABLE = Serializable.class;
 
@@ -188,9 +192,33 @@ public class ObjectStreamClass implements Serializable {
     // Array of ObjectStreamField describing the serialized fields of this class
     private transient ObjectStreamField[] loadFields;
 
+    // The JNI field IDs and type codes of the primitive fields at the start of loadFields, so
+    // ObjectInputStream can set them all at once. Resolved the first time an instance is read.
+    // Both arrays are published together through one volatile reference, so another thread
+    // never sees the IDs of one resolution with the type codes of another, or half-built arrays.
+    private transient volatile PrimitiveFieldIds primitiveFieldIds;
+
+    static final class PrimitiveFieldIds {
+        final int[] fieldIds;
+        final byte[] typeCodes;
+
+        PrimitiveFieldIds(int[] fieldIds, byte[] typeCodes) {
+            this.fieldIds = fieldIds;
+            this.typeCodes = typeCodes;
+        }
+    }
+
     // MethodID for deserialization constructor
     private transient long constructor = CONSTRUCTOR_IS_NOT_RESOLVED;
 
+    PrimitiveFieldIds getPrimitiveFieldIds() {
+        return primitiveFieldIds;
+    }
+
+    void setPrimitiveFieldIds(PrimitiveFieldIds ids) {
+        primitiveFieldIds = ids;
+    }
+
     void setConstructor(long newConstructor) {
         constructor = newConstructor;
     }
@@ -419,6 +447,14 @@ public class ObjectStreamClass implements Serializable {
             }
         }
 
+        // Descriptors are cached per thread, so remember computed SUIDs for all threads.
+        synchronized (computedSerialVersionUIDs) {
+            Long cached = computedSerialVersionUIDs.get(cl);
+            if (cached != null) {
+                return cached;
+            }
+        }
+
         MessageDigest digest;
         try {
             digest = MessageDigest.getInstance("SHA");
@@ -483,6 +519,7 @@ public class ObjectStreamClass implements Serializable {
             }
 
             // Dump them
+            String[] fieldSignatures = getFieldSignatures(fields);
             for (int i = 0; i < fields.length; i++) {
                 Field field = fields[i];
                 int modifiers = field.getModifiers() & FIELD_MODIFIERS_MASK;
@@ -496,7 +533,7 @@ public class ObjectStreamClass implements Serializable {
                     output.writeUTF(field.getName());
                     output.writeInt(modifiers);
                     output
-                            .writeUTF(descriptorForFieldSignature(getFieldSignature(field)));
+                            .writeUTF(descriptorForFieldSignature(fieldSignatures[i]));
                 }
             }
 
@@ -512,76 +549,26 @@ public class ObjectStreamClass implements Serializable {
                 output.writeUTF(CLINIT_SIGNATURE);
             }
 
-            // Constructor information
+            // Constructor information. They all have the same name, so they're sorted by
+            // signature.
             Constructor<?>[] constructors = cl.getDeclaredConstructors();
-            if (constructors.length > 1) {
-                // Only attempt to sort if really needed (saves object creation,
-                // etc)
-                Comparator<Constructor<?>> constructorComparator = new Comparator<Constructor<?>>() {
-                    public int compare(Constructor<?> ctr1, Constructor<?> ctr2) {
-                        // All constructors have same name, so we sort based on
-                        // signature
-                        return (getConstructorSignature(ctr1)
-                                .compareTo(getConstructorSignature(ctr2)));
-                    }
-                };
-                Arrays.sort(constructors, constructorComparator);
-            }
-
-            // Dump them
+            String[] constructorSignatures = getConstructorSignatures(constructors);
+            MemberSignature[] sortedConstructors = new MemberSignature[constructors.length];
             for (int i = 0; i < constructors.length; i++) {
-                Constructor<?> constructor = constructors[i];
-                int modifiers = constructor.getModifiers()
-                        & METHOD_MODIFIERS_MASK;
-                boolean isPrivate = Modifier.isPrivate(modifiers);
-                if (!isPrivate) {
-                    /*
-                     * write name, modifier & "descriptor" of all but private
-                     * ones
-                     *
-                     * constructor.getName() returns the constructor name as
-                     * typed, not the VM name
-                     */
-                    output.writeUTF("<init>");
-                    output.writeInt(modifiers);
-                    output.writeUTF(descriptorForSignature(
-                            getConstructorSignature(constructor)).replace('/',
-                            '.'));
-                }
+                sortedConstructors[i] = new MemberSignature("<init>",
+                        constructors[i].getModifiers(), constructorSignatures[i]);
             }
+            writeMemberSignatures(output, sortedConstructors);
 
             // Method information
             Method[] methods = cl.getDeclaredMethods();
-            if (methods.length > 1) {
-                Comparator<Method> methodComparator = new Comparator<Method>() {
-                    public int compare(Method m1, Method m2) {
-                        int result = m1.getName().compareTo(m2.getName());
-                        if (result == 0) {
-                            // same name, signature will tell which one comes
-                            // first
-                            return getMethodSignature(m1).compareTo(
-                                    getMethodSignature(m2));
-                        }
-                        return result;
-                    }
-                };
-                Arrays.sort(methods, methodComparator);
-            }
-
-            // Dump them
+            String[] methodSignatures = getMethodSignatures(methods);
+            MemberSignature[] sortedMethods = new MemberSignature[methods.length];
             for (int i = 0; i < methods.length; i++) {
-                Method method = methods[i];
-                int modifiers = method.getModifiers() & METHOD_MODIFIERS_MASK;
-                boolean isPrivate = Modifier.isPrivate(modifiers);
-                if (!isPrivate) {
-                    // write name, modifier & "descriptor" of all but private
-                    // ones
-                    output.writeUTF(method.getName());
-                    output.writeInt(modifiers);
-                    output.writeUTF(descriptorForSignature(
-                            getMethodSignature(method)).replace('/', '.'));
-                }
+                sortedMethods[i] = new MemberSignature(methods[i].getName(),
+                        methods[i].getModifiers(), methodSignatures[i]);
             }
+            writeMemberSignatures(output, sortedMethods);
         } catch (IOException e) {
             throw new RuntimeException(e + " computing SHA-1/SUID");
         }
@@ -589,7 +576,51 @@ public class ObjectStreamClass implements Serializable {
         // now compute the UID based on the SHA
         byte[] hash = digest.digest(sha.toByteArray());
 
-        return littleEndianLongAt(hash, 0);
+        long result = littleEndianLongAt(hash, 0);
+        synchronized (computedSerialVersionUIDs) {
+            computedSerialVersionUIDs.put(cl, result);
+        }
+        return result;
+    }
+
+    /**
+     * A constructor or method's name, modifiers and signature. The signature is fetched once,
+     * rather than on each comparison while sorting.
+     */
+    private static final class MemberSignature implements Comparable<MemberSignature> {
+        final String name;
+        final int modifiers;
+        final String signature;
+
+        MemberSignature(String name, int modifiers, String signature) {
+            this.name = name;
+            this.modifiers = modifiers;
+            this.signature = signature;
+        }
+
+        public int compareTo(MemberSignature other) {
+            int result = name.compareTo(other.name);
+            return (result != 0) ? result : signature.compareTo(other.signature);
+        }
+    }
+
+    /**
+     * Sorts {@code members} by name and then signature, and writes the name, modifiers and
+     * "descriptor" of all but the private ones, as the SUID computation requires.
+     */
+    private static void writeMemberSignatures(DataOutputStream output, MemberSignature[] members)
+            throws IOException {
+        if (members.length > 1) {
+            Arrays.sort(members);
+        }
+        for (MemberSignature member : members) {
+            int modifiers = member.modifiers & METHOD_MODIFIERS_MASK;
+            if (!Modifier.isPrivate(modifiers)) {
+                output.writeUTF(member.name);
+                output.writeInt(modifiers);
+                output.writeUTF(descriptorForSignature(member.signature).replace('/', '.'));
+            }
+        }
     }
 
     /**
@@ -656,14 +687,9 @@ public class ObjectStreamClass implements Serializable {
     }
 
     /**
-     * Return a String representing the signature for a Constructor {@code c}.
-     *
-     * @param c
-     *            a java.lang.reflect.Constructor for which to compute the
-     *            signature
-     * @return the constructor's signature
+     * Returns the signatures of the constructors {@code constructors}, in the same order.
      */
-    static native String getConstructorSignature(Constructor<?> c);
+    private static native String[] getConstructorSignatures(Constructor<?>[] constructors);
 
     /**
      * Gets a field descriptor of the class represented by this class
@@ -755,13 +781,9 @@ public class ObjectStreamClass implements Serializable {
     }
 
     /**
-     * Return a String representing the signature for a field {@code f}.
-     *
-     * @param f
-     *            a java.lang.reflect.Field for which to compute the signature
-     * @return the field's signature
+     * Returns the signatures of the fields {@code fields}, in the same order.
      */
-    private static native String getFieldSignature(Field f);
+    private static native String[] getFieldSignatures(Field[] fields);
 
     /**
      * Returns the flags for this descriptor, where possible combined values are
@@ -777,13 +799,9 @@ public class ObjectStreamClass implements Serializable {
     }
 
     /**
-     * Return a String representing the signature for a method {@code m}.
-     *
-     * @param m
-     *            a java.lang.reflect.Method for which to compute the signature
-     * @return the method's signature
+     * Returns the signatures of the methods {@code methods}, in the same order.
      */
-    static native String getMethodSignature(Method m);
+    private static native String[] getMethodSignatures(Method[] methods);
 
     /**
      * Returns the name of the class represented by this descriptor.
@@ -16,6 +16,8 @@
 
 package java.lang;
 
+import java.io.FileDescriptor;
+import java.io.IOException;
 import org.apache.harmony.kernel.vm.LangAccess;
 
 /**
@@ -52,4 +54,29 @@ import org.apache.harmony.kernel.vm.LangAccess;
     public void parkUntil(long time) {
         Thread.currentThread().parkUntil(time);
     }
+
+    /** {@inheritDoc} */
+    public Process startSupervisedProcess(ProcessBuilder builder) throws IOException {
+        return builder.start(true);
+    }
+
+    /** {@inheritDoc} */
+    public int getProcessId(Process process) {
+        return ((ProcessManager.ProcessImpl) process).id;
+    }
+
+    /** {@inheritDoc} */
+    public FileDescriptor openProcessPidFd(Process process) throws IOException {
+        return ProcessManager.getInstance().openPidFd(process);
+    }
+
+    /** {@inheritDoc} */
+    public FileDescriptor openSigChldFd() throws IOException {
+        return ProcessManager.openSigChldFd();
+    }
+
+    /** {@inheritDoc} */
+    public int reapSupervisedProcesses(int[] pids, int[] statuses) {
+        return ProcessManager.getInstance().reapSupervised(pids, statuses);
+    }
 }
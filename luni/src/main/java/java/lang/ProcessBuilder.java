@@ -192,6 +192,14 @@ public final class ProcessBuilder {
      *             if an I/O error happens.
      */
     public Process start() throws IOException {
+        return start(false);
+    }
+
+    /**
+     * Starts a new process, which is supervised if {@code supervised} is
+     * true. See {@link ProcessManager#exec(String[], String[], File, boolean, boolean)}.
+     */
+    Process start(boolean supervised) throws IOException {
         // BEGIN android-changed: push responsibility for argument checking into ProcessManager
         String[] cmdArray = command.toArray(new String[command.size()]);
         String[] envArray = new String[environment.size()];
@@ -199,7 +207,8 @@ public final class ProcessBuilder {
         for (Map.Entry<String, String> entry : environment.entrySet()) {
             envArray[i++] = entry.getKey() + "=" + entry.getValue();
         }
-        return ProcessManager.getInstance().exec(cmdArray, envArray, directory, redirectErrorStream);
+        return ProcessManager.getInstance().exec(cmdArray, envArray, directory, redirectErrorStream,
+                supervised);
         // END android-changed
     }
 
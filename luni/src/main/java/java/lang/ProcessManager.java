@@ -73,6 +73,16 @@ final class ProcessManager {
     private final Map<Integer, ProcessReference> processReferences
             = new HashMap<Integer, ProcessReference>();
 
+    /**
+     * Map from pid to Process for supervised children. These are in their
+     * own process groups, so {@link #watchChildren} never sees them; they're
+     * reaped by {@link #reapSupervised} instead. Entries stay until then even
+     * if the Process is collected, since the pid still needs reaping. Guarded
+     * by processReferences.
+     */
+    private final Map<Integer, ProcessReference> supervisedReferences
+            = new HashMap<Integer, ProcessReference>();
+
     /** Keeps track of garbage-collected Processes. */
     private final ProcessReferenceQueue referenceQueue
             = new ProcessReferenceQueue();
@@ -104,7 +114,10 @@ final class ProcessManager {
         ProcessReference reference;
         while ((reference = referenceQueue.poll()) != null) {
             synchronized (processReferences) {
-                processReferences.remove(reference.processId);
+                // The pid may have been reaped and reused since; only drop our own entry.
+                if (processReferences.get(reference.processId) == reference) {
+                    processReferences.remove(reference.processId);
+                }
             }
         }
     }
@@ -163,19 +176,100 @@ final class ProcessManager {
         }
     }
 
+    /**
+     * Reaps, without blocking, the supervised children that have exited.
+     * Their pids and exit values are written to the start of {@code pids}
+     * and {@code statuses}, and their Processes are told they've exited.
+     * Costs one waitpid(2) for each supervised child still running.
+     *
+     * @return the number of children reaped, at most the length of the
+     *     shorter array
+     */
+    int reapSupervised(int[] pids, int[] statuses) {
+        ProcessReference[] reaped;
+        int count;
+        synchronized (processReferences) {
+            int[] candidates = new int[supervisedReferences.size()];
+            int i = 0;
+            for (int pid : supervisedReferences.keySet()) {
+                candidates[i++] = pid;
+            }
+            count = reapExited(candidates, pids, statuses);
+            reaped = new ProcessReference[count];
+            for (i = 0; i < count; ++i) {
+                reaped[i] = supervisedReferences.remove(pids[i]);
+            }
+        }
+        for (int i = 0; i < count; ++i) {
+            ProcessImpl process = reaped[i].get();
+            if (process != null) {
+                process.setExitValue(statuses[i]);
+            }
+        }
+        return count;
+    }
+
+    /**
+     * Returns a new pidfd for {@code process}, which becomes readable when
+     * the process exits. The caller must close it.
+     *
+     * @throws IllegalArgumentException if the process isn't an unreaped
+     *     supervised child; its pid may already belong to someone else
+     * @throws IOException if pidfds aren't supported (ENOSYS), for example
+     */
+    FileDescriptor openPidFd(Process process) throws IOException {
+        int pid = ((ProcessImpl) process).id;
+        // Holding the lock stops the pid being reaped, and so reused, while we open it.
+        synchronized (processReferences) {
+            if (!supervisedReferences.containsKey(pid)) {
+                throw new IllegalArgumentException("not an unreaped supervised child: " + process);
+            }
+            return openPidFd(pid);
+        }
+    }
+
+    /**
+     * Reaps whichever of {@code candidates} have exited; see
+     * {@link #reapSupervised}.
+     */
+    private static native int reapExited(int[] candidates, int[] pids, int[] statuses);
+
+    private static native FileDescriptor openPidFd(int pid) throws IOException;
+
+    /**
+     * Blocks SIGCHLD in the calling thread and returns a signalfd(2) that's
+     * readable when it's pending. Each read(2) consumes one 128-byte
+     * signalfd_siginfo. Signals may be coalesced, so a read means "call
+     * {@link #reapSupervised}", not "one child exited". SIGCHLD is only
+     * reliably queued for the fd if every thread blocks it.
+     */
+    static native FileDescriptor openSigChldFd() throws IOException;
+
     /**
      * Executes a native process. Fills in in, out, and err and returns the
      * new process ID upon success.
      */
     static native int exec(String[] command, String[] environment,
             String workingDirectory, FileDescriptor in, FileDescriptor out,
-            FileDescriptor err, boolean redirectErrorStream) throws IOException;
+            FileDescriptor err, boolean redirectErrorStream, boolean supervised)
+            throws IOException;
 
     /**
      * Executes a process and returns an object representing it.
      */
     Process exec(String[] taintedCommand, String[] taintedEnvironment, File workingDirectory,
             boolean redirectErrorStream) throws IOException {
+        return exec(taintedCommand, taintedEnvironment, workingDirectory, redirectErrorStream,
+                false);
+    }
+
+    /**
+     * Executes a process and returns an object representing it. A supervised
+     * process is in its own process group and isn't reaped by the watcher
+     * thread: its exit value is only set once {@link #reapSupervised} reaps it.
+     */
+    Process exec(String[] taintedCommand, String[] taintedEnvironment, File workingDirectory,
+            boolean redirectErrorStream, boolean supervised) throws IOException {
         // Make sure we throw the same exceptions as the RI.
         if (taintedCommand == null) {
             throw new NullPointerException();
@@ -219,7 +313,8 @@ final class ProcessManager {
         synchronized (processReferences) {
             int pid;
             try {
-                pid = exec(command, environment, workingPath, in, out, err, redirectErrorStream);
+                pid = exec(command, environment, workingPath, in, out, err, redirectErrorStream,
+                        supervised);
             } catch (IOException e) {
                 IOException wrapper = new IOException("Error running exec()."
                         + " Command: " + Arrays.toString(command)
@@ -231,6 +326,10 @@ final class ProcessManager {
             ProcessImpl process = new ProcessImpl(pid, in, out, err);
             ProcessReference processReference
                     = new ProcessReference(process, referenceQueue);
+            if (supervised) {
+                supervisedReferences.put(pid, processReference);
+                return process;
+            }
             processReferences.put(pid, processReference);
 
             /*
@@ -31,7 +31,7 @@ final class RealToString {
     private int firstK;
 
     /**
-     * An array of decimal digits, filled by longDigitGenerator or bigIntDigitGenerator.
+     * An array of decimal digits, filled by longDigitGenerator or shortestDigitGenerator.
      */
     private final int[] digits = new int[64];
 
@@ -110,7 +110,7 @@ final class RealToString {
         if (-59 < pow && pow < 6 || (pow == -59 && !mantissaIsZero)) {
             longDigitGenerator(f, pow, e == 0, mantissaIsZero, numBits);
         } else {
-            bigIntDigitGenerator(f, pow, e == 0, numBits);
+            shortestDigitGenerator(f, pow, e == 0, numBits);
         }
         AbstractStringBuilder dst = (sb != null) ? sb : new StringBuilder(26);
         if (inputNumber >= 1e7D || inputNumber <= -1e7D
@@ -176,7 +176,7 @@ final class RealToString {
         if (-59 < pow && pow < 35 || (pow == -59 && !mantissaIsZero)) {
             longDigitGenerator(f, pow, e == 0, mantissaIsZero, numBits);
         } else {
-            bigIntDigitGenerator(f, pow, e == 0, numBits);
+            shortestDigitGenerator(f, pow, e == 0, numBits);
         }
         AbstractStringBuilder dst = (sb != null) ? sb : new StringBuilder(26);
         if (inputNumber >= 1e7f || inputNumber <= -1e7f
@@ -241,7 +241,7 @@ final class RealToString {
         } while (U != -1 || k >= -1);
     }
 
-    private native void bigIntDigitGenerator(long f, int e, boolean isDenormalized, int p);
+    private native void shortestDigitGenerator(long f, int e, boolean isDenormalized, int p);
 
     private void longDigitGenerator(long f, int e, boolean isDenormalized,
             boolean mantissaIsZero, int p) {
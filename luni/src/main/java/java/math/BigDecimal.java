@@ -826,8 +826,9 @@ public class BigDecimal extends Number implements Comparable<BigDecimal>, Serial
                 Math.max(thisValue.bitLength,augend.bitLength+LONG_POWERS_OF_TEN_BIT_LENGTH[diffScale])+1<64) {
             return valueOf(thisValue.smallValue+augend.smallValue*MathUtils.LONG_POWERS_OF_TEN[diffScale],thisValue.scale);
         } else {
-            BigInt bi = Multiplication.multiplyByTenPow(augend.getUnscaledValue(),diffScale).getBigInt();
-            bi.add(thisValue.getUnscaledValue().getBigInt());
+            BigInt bi = thisValue.getUnscaledValue().getBigInt().copy();
+            bi.addProduct(augend.getUnscaledValue().getBigInt(),
+                    Multiplication.powerOf10(diffScale).getBigInt());
             return new BigDecimal(new BigInteger(bi), thisValue.scale);
         }
         // END android-changed
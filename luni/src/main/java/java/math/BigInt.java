@@ -299,6 +299,10 @@ final class BigInt {
         Check(NativeBN.BN_add(this.bignum, this.bignum, a.bignum));
     }
 
+    void addProduct(BigInt a, BigInt b) {
+        Check(NativeBN.addProduct(this.bignum, a.bignum, b.bignum));
+    }
+
     static BigInt subtraction(BigInt a, BigInt b) {
         BigInt r = newBigInt();
         Check(NativeBN.BN_sub(r.bignum, a.bignum, b.bignum));
@@ -144,6 +144,9 @@ final class NativeBN {
     public static native boolean BN_mod_exp(int r, int a, int p, int m);
     // int BN_mod_exp(BIGNUM *r, const BIGNUM *a, const BIGNUM *p, const BIGNUM *m, BN_CTX *ctx);
 
+    public static native boolean addProduct(int r, int a, int b);
+    // r += a * b, without a separate BIGNUM for the product.
+
     // OPTIONAL:
 //    public static native boolean BN_mod_sqr(BigInteger r, BigInteger a, BigInteger m, BN_CTX ctx);
     // int BN_mod_sqr(BIGNUM *r, const BIGNUM *a, const BIGNUM *m, BN_CTX *ctx);
@@ -253,11 +253,47 @@ public class InetAddress implements Serializable {
         return getAllByNameImpl(host).clone();
     }
 
+    /**
+     * Like {@link #getAllByName}, but gives up if resolving {@code host} takes
+     * more than {@code timeoutMillis} milliseconds. The lookup carries on in
+     * the background, so later calls may find its result cached.
+     *
+     * @throws UnknownHostException if the address lookup fails or times out.
+     * @hide
+     */
+    public static InetAddress[] getAllByNameWithTimeout(String host, int timeoutMillis)
+            throws UnknownHostException {
+        if (timeoutMillis <= 0) {
+            throw new IllegalArgumentException("timeoutMillis <= 0: " + timeoutMillis);
+        }
+        return getAllByNameImpl(host, timeoutMillis).clone();
+    }
+
+    /**
+     * Starts resolving {@code host} in the background, so that a later lookup
+     * is satisfied from the cache. Does nothing if {@code host} is a literal IP
+     * address or its addresses are already cached.
+     * @hide
+     */
+    public static void prefetchByName(String host) {
+        if (host == null || host.isEmpty() || !isHostName(host)) {
+            return;
+        }
+        if (addressCache.get(host) == null) {
+            prefetchaddrinfo(host);
+        }
+    }
+
     /**
      * Returns the InetAddresses for {@code host}. The returned array is shared
      * and must be cloned before it is returned to application code.
      */
     static InetAddress[] getAllByNameImpl(String host) throws UnknownHostException {
+        return getAllByNameImpl(host, 0);
+    }
+
+    private static InetAddress[] getAllByNameImpl(String host, int timeoutMillis)
+            throws UnknownHostException {
         if (host == null || host.isEmpty()) {
             if (preferIPv6Addresses()) {
                 return new InetAddress[] { Inet6Address.LOOPBACK, Inet4Address.LOOPBACK };
@@ -288,7 +324,7 @@ public class InetAddress implements Serializable {
             security.checkConnect(host, -1);
         }
 
-        return lookupHostByName(host);
+        return lookupHostByName(host, timeoutMillis);
     }
 
     private static native String byteArrayToIpString(byte[] address);
@@ -482,6 +518,16 @@ public class InetAddress implements Serializable {
      * @return the IP addresses of the host.
      */
     private static InetAddress[] lookupHostByName(String host) throws UnknownHostException {
+        return lookupHostByName(host, 0);
+    }
+
+    /**
+     * Resolves a hostname to its IP addresses using a cache, waiting at most
+     * {@code timeoutMillis} milliseconds for the name service (or as long as
+     * it takes, if {@code timeoutMillis} is 0).
+     */
+    private static InetAddress[] lookupHostByName(String host, int timeoutMillis)
+            throws UnknownHostException {
         BlockGuard.getThreadPolicy().onNetwork();
         // Do we have a result cached?
         InetAddress[] cachedResult = addressCache.get(host);
@@ -494,16 +540,45 @@ public class InetAddress implements Serializable {
                 throw new UnknownHostException(host);
             }
         }
+        byte[][] rawAddresses;
         try {
-            InetAddress[] addresses = bytesToInetAddresses(getaddrinfo(host), host);
-            addressCache.put(host, addresses);
-            return addresses;
+            rawAddresses = getaddrinfoWithTimeout(host, timeoutMillis);
         } catch (UnknownHostException e) {
             addressCache.putUnknownHost(host);
             throw new UnknownHostException(host);
         }
+        if (rawAddresses == null) {
+            // We timed out. That says nothing about whether the host exists, so don't cache it.
+            throw new UnknownHostException(host + ": timed out after " + timeoutMillis + "ms");
+        }
+        InetAddress[] addresses = bytesToInetAddresses(rawAddresses, host);
+        addressCache.put(host, addresses);
+        return addresses;
     }
-    private static native byte[][] getaddrinfo(String name) throws UnknownHostException;
+
+    /**
+     * Resolves a hostname through the native resolver, which caches results and
+     * shares lookups between threads. Returns null if {@code timeoutMillis} is
+     * non-zero and passes before the lookup finishes.
+     */
+    private static native byte[][] getaddrinfoWithTimeout(String name, int timeoutMillis)
+            throws UnknownHostException;
+
+    /**
+     * Starts a background lookup of a hostname in the native resolver.
+     */
+    private static native void prefetchaddrinfo(String name);
+
+    /**
+     * Removes all entries from the native resolver's cache.
+     */
+    private static native void clearaddrinfoCache();
+
+    /**
+     * For tests: makes lookups that need a native resolver thread fail as if
+     * none could be started.
+     */
+    private static native void setResolverThreadsUnavailable(boolean unavailable);
 
     /**
      * Removes all entries from the VM's DNS cache. This does not affect the C library's DNS
@@ -512,6 +587,7 @@ public class InetAddress implements Serializable {
      */
     public static void clearDnsCache() {
         addressCache.clear();
+        clearaddrinfoCache();
     }
 
     /**
@@ -38,6 +38,15 @@ public final class NetworkInterface extends Object {
     static final int NO_INTERFACE_INDEX = 0;
     static final int UNSET_INTERFACE_INDEX = -1;
 
+    // Bits in snapshotFlags. These must match the values in java_net_NetworkInterface.cpp.
+    private static final int SNAPSHOT_UP = 1;
+    private static final int SNAPSHOT_LOOPBACK = 2;
+    private static final int SNAPSHOT_POINT_TO_POINT = 4;
+    private static final int SNAPSHOT_MULTICAST = 8;
+
+    private static final Object snapshotLock = new Object();
+    private static List<NetworkInterface> lastSnapshot;
+
     private final String name;
     private final String displayName;
     private final List<InterfaceAddress> interfaceAddresses = new LinkedList<InterfaceAddress>();
@@ -53,13 +62,24 @@ public final class NetworkInterface extends Object {
 
     private final List<NetworkInterface> children = new LinkedList<NetworkInterface>();
 
+    // Set for interfaces returned by getNetworkInterfacesSnapshot, whose flags, MTU and
+    // hardware address were read along with their addresses.
+    private boolean isSnapshot;
+    private int snapshotFlags;
+    private int snapshotMtu;
+    private byte[] snapshotHardwareAddress;
+
     // BEGIN android-changed: we pay this extra complexity on the Java side
     // in return for vastly simpler native code.
     private static native InterfaceAddress[] getAllInterfaceAddressesImpl() throws SocketException;
 
     private static NetworkInterface[] getNetworkInterfacesImpl() throws SocketException {
+        return groupInterfaceAddresses(getAllInterfaceAddressesImpl());
+    }
+
+    private static NetworkInterface[] groupInterfaceAddresses(InterfaceAddress[] interfaceAddresses) {
         Map<String, NetworkInterface> networkInterfaces = new LinkedHashMap<String, NetworkInterface>();
-        for (InterfaceAddress ia : getAllInterfaceAddressesImpl()) {
+        for (InterfaceAddress ia : interfaceAddresses) {
             if (ia != null) { // The array may contain harmless null elements.
                 String name = ia.name;
                 NetworkInterface ni = networkInterfaces.get(name);
@@ -77,6 +97,67 @@ public final class NetworkInterface extends Object {
     }
     // END android-changed
 
+    /**
+     * Returns the addresses of every interface with an IP address (whether or not it's up)
+     * along with each interface's flags, MTU and hardware address, or null if 'force' is false
+     * and no interface has changed since the last call. See java_net_NetworkInterface.cpp for the layout.
+     */
+    private static native Object[] getInterfaceSnapshotImpl(boolean force) throws SocketException;
+
+    private static List<NetworkInterface> makeSnapshot(Object[] snapshot) {
+        NetworkInterface[] interfaces = groupInterfaceAddresses((InterfaceAddress[]) snapshot[0]);
+        String[] names = (String[]) snapshot[1];
+        int[] flags = (int[]) snapshot[2];
+        int[] mtus = (int[]) snapshot[3];
+        byte[][] hardwareAddresses = (byte[][]) snapshot[4];
+        for (NetworkInterface ni : interfaces) {
+            for (int i = 0; i < names.length; ++i) {
+                if (names[i].equals(ni.name)) {
+                    ni.isSnapshot = true;
+                    ni.snapshotFlags = flags[i];
+                    ni.snapshotMtu = mtus[i];
+                    ni.snapshotHardwareAddress = hardwareAddresses[i];
+                    break;
+                }
+            }
+        }
+        return linkInterfaces(interfaces);
+    }
+
+    /**
+     * Returns every network interface with an IP address, whether or not it's up.
+     * The returned interfaces answer {@link #isUp}, {@link #isLoopback},
+     * {@link #isPointToPoint}, {@link #supportsMulticast},
+     * {@link #getHardwareAddress} and {@link #getMTU} from the snapshot rather
+     * than by asking the kernel again. Where the kernel reports interface changes,
+     * polling costs nothing while nothing changes: the previous snapshot is
+     * returned.
+     *
+     * @throws SocketException if an error occurs while getting the network
+     *             interface information.
+     * @hide
+     */
+    public static List<NetworkInterface> getNetworkInterfacesSnapshot() throws SocketException {
+        return getNetworkInterfacesSnapshot(false);
+    }
+
+    /**
+     * Like {@link #getNetworkInterfacesSnapshot()}, but if {@code refresh} is
+     * true, takes a new snapshot even if no change has been reported.
+     *
+     * @hide
+     */
+    public static List<NetworkInterface> getNetworkInterfacesSnapshot(boolean refresh)
+            throws SocketException {
+        synchronized (snapshotLock) {
+            Object[] snapshot = getInterfaceSnapshotImpl(refresh || lastSnapshot == null);
+            if (snapshot != null) {
+                lastSnapshot = Collections.unmodifiableList(makeSnapshot(snapshot));
+            }
+            return lastSnapshot;
+        }
+    }
+
     /**
      * This constructor is used by the native method in order to construct the
      * NetworkInterface objects in the array that it returns.
@@ -238,8 +319,10 @@ public final class NetworkInterface extends Object {
     }
 
     private static List<NetworkInterface> getNetworkInterfacesList() throws SocketException {
-        NetworkInterface[] interfaces = getNetworkInterfacesImpl();
+        return linkInterfaces(getNetworkInterfacesImpl());
+    }
 
+    private static List<NetworkInterface> linkInterfaces(NetworkInterface[] interfaces) {
         for (NetworkInterface netif : interfaces) {
             // Ensure that current NetworkInterface is bound to at least
             // one InetAddress before processing
@@ -417,6 +500,9 @@ public final class NetworkInterface extends Object {
         if (addresses.isEmpty()) {
             return false;
         }
+        if (isSnapshot) {
+            return (snapshotFlags & SNAPSHOT_UP) != 0;
+        }
         return isUpImpl(name);
     }
     private static native boolean isUpImpl(String n) throws SocketException;
@@ -432,6 +518,9 @@ public final class NetworkInterface extends Object {
         if (addresses.isEmpty()) {
             return false;
         }
+        if (isSnapshot) {
+            return (snapshotFlags & SNAPSHOT_LOOPBACK) != 0;
+        }
         return isLoopbackImpl(name);
     }
     private static native boolean isLoopbackImpl(String n) throws SocketException;
@@ -448,6 +537,9 @@ public final class NetworkInterface extends Object {
         if (addresses.isEmpty()) {
             return false;
         }
+        if (isSnapshot) {
+            return (snapshotFlags & SNAPSHOT_POINT_TO_POINT) != 0;
+        }
         return isPointToPointImpl(name);
     }
     private static native boolean isPointToPointImpl(String n) throws SocketException;
@@ -462,6 +554,9 @@ public final class NetworkInterface extends Object {
         if (addresses.isEmpty()) {
             return false;
         }
+        if (isSnapshot) {
+            return (snapshotFlags & SNAPSHOT_MULTICAST) != 0;
+        }
         return supportsMulticastImpl(name);
     }
     private static native boolean supportsMulticastImpl(String n) throws SocketException;
@@ -479,6 +574,9 @@ public final class NetworkInterface extends Object {
         if (addresses.isEmpty()) {
             return new byte[0];
         }
+        if (isSnapshot) {
+            return (snapshotHardwareAddress != null) ? snapshotHardwareAddress.clone() : null;
+        }
         return getHardwareAddressImpl(name);
     }
     private static native byte[] getHardwareAddressImpl(String n) throws SocketException;
@@ -494,6 +592,9 @@ public final class NetworkInterface extends Object {
         if (addresses.isEmpty()) {
             return 0;
         }
+        if (isSnapshot) {
+            return snapshotMtu;
+        }
         return getMTUImpl(name);
     }
     private static native int getMTUImpl(String n) throws SocketException;
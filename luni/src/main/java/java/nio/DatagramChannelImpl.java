@@ -330,8 +330,13 @@ class DatagramChannelImpl extends DatagramChannel implements FileDescriptorHandl
             if (source.isDirect()) {
                 synchronized (writeLock) {
                     int data_address = NioUtils.getDirectBufferAddress(source);
-                    sendCount = Platform.NETWORK.sendDirect(fd, data_address, start, length,
-                            isa.getPort(), isa.getAddress());
+                    if (isConnected()) {
+                        sendCount = Platform.NETWORK.sendConnectedDirect(fd, data_address,
+                                start, length);
+                    } else {
+                        sendCount = Platform.NETWORK.sendDirect(fd, data_address, start, length,
+                                isa.getPort(), isa.getAddress());
+                    }
                 }
             } else {
                 if (source.hasArray()) {
@@ -343,8 +348,12 @@ class DatagramChannelImpl extends DatagramChannel implements FileDescriptorHandl
                     start = 0;
                 }
                 synchronized (writeLock) {
-                    sendCount = Platform.NETWORK.send(fd, array, start, length,
-                            isa.getPort(), isa.getAddress());
+                    if (isConnected()) {
+                        sendCount = Platform.NETWORK.sendConnected(fd, array, start, length);
+                    } else {
+                        sendCount = Platform.NETWORK.send(fd, array, start, length,
+                                isa.getPort(), isa.getAddress());
+                    }
                 }
             }
             source.position(oldposition + sendCount);
@@ -526,11 +535,11 @@ class DatagramChannelImpl extends DatagramChannel implements FileDescriptorHandl
 
                 if (buf.isDirect()) {
                     int address = NioUtils.getDirectBufferAddress(buf);
-                    result = Platform.NETWORK.sendDirect(fd, address, start, length, 0, null);
+                    result = Platform.NETWORK.sendConnectedDirect(fd, address, start, length);
                 } else {
                     // buf is assured to have array.
                     start += buf.arrayOffset();
-                    result = Platform.NETWORK.send(fd, buf.array(), start, length, 0, null);
+                    result = Platform.NETWORK.sendConnected(fd, buf.array(), start, length);
                 }
                 return result;
             } finally {
@@ -401,6 +401,9 @@ abstract class FileChannelImpl extends FileChannel {
             return kernelTransfer(handle, ((SocketChannelImpl) target).getFD(),
                     position, count);
         }
+        if (target instanceof FileChannelImpl && !((FileChannelImpl) target).isAppend()) {
+            return fileTransfer((FileChannelImpl) target, position, count);
+        }
 
         try {
             buffer = map(MapMode.READ_ONLY, position, count);
@@ -423,6 +426,30 @@ abstract class FileChannelImpl extends FileChannel {
         }
     }
 
+    private long fileTransfer(FileChannelImpl target, long position, long count)
+            throws IOException {
+        boolean completed = false;
+        try {
+            begin();
+            long ret;
+            // The copy goes to (and advances) the target's file position.
+            synchronized (target.repositioningLock) {
+                ret = Platform.FILE_SYSTEM.transferFile(handle, position, target.handle, count);
+            }
+            completed = true;
+            return ret;
+        } finally {
+            end(completed);
+        }
+    }
+
+    /**
+     * Returns true if writes to this channel always go to the end of the file.
+     */
+    boolean isAppend() {
+        return false;
+    }
+
     public FileChannel truncate(long size) throws IOException {
         openCheck();
         if (size < 0) {
@@ -401,6 +401,9 @@ class SocketChannelImpl extends SocketChannel implements FileDescriptorHandler {
         if (count == 0) {
             return 0;
         }
+        if (allDirect(sources, offset, length)) {
+            return writevImpl(sources, offset, length);
+        }
         ByteBuffer writeBuf = ByteBuffer.allocate(count);
         for (int val = offset; val < length + offset; val++) {
             ByteBuffer source = sources[val];
@@ -422,6 +425,52 @@ class SocketChannelImpl extends SocketChannel implements FileDescriptorHandler {
         return written;
     }
 
+    private static boolean allDirect(ByteBuffer[] buffers, int offset, int length) {
+        for (int i = offset; i < offset + length; ++i) {
+            if (!buffers[i].isDirect()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /*
+     * Write direct buffers with a single gathering write. return the count of
+     * bytes written.
+     */
+    private long writevImpl(ByteBuffer[] sources, int offset, int length) throws IOException {
+        int[] addresses = new int[length];
+        int[] offsets = new int[length];
+        int[] lengths = new int[length];
+        for (int i = 0; i < length; ++i) {
+            ByteBuffer source = sources[offset + i];
+            addresses[i] = NioUtils.getDirectBufferAddress(source);
+            offsets[i] = source.position();
+            lengths[i] = source.remaining();
+        }
+        long written = 0;
+        synchronized (writeLock) {
+            try {
+                if (isBlocking()) {
+                    begin();
+                }
+                written = Platform.NETWORK.writev(fd, addresses, offsets, lengths, length, false);
+            } finally {
+                if (isBlocking()) {
+                    end(written >= 0);
+                }
+            }
+        }
+        long remaining = written;
+        for (int i = offset; i < offset + length && remaining > 0; ++i) {
+            ByteBuffer source = sources[i];
+            int gap = (int) Math.min(remaining, source.remaining());
+            source.position(source.position() + gap);
+            remaining -= gap;
+        }
+        return written;
+    }
+
     /*
      * Write the source. return the count of bytes written.
      */
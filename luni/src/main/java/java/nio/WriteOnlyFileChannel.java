@@ -85,6 +85,10 @@ final class WriteOnlyFileChannel extends FileChannelImpl {
         throw new NonReadableChannelException();
     }
 
+    @Override boolean isAppend() {
+        return append;
+    }
+
     public int write(ByteBuffer buffer) throws IOException {
         if (append) {
             position(size());
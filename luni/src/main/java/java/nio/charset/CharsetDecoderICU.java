@@ -16,6 +16,7 @@ package libcore.icu;
 
 import java.nio.ByteBuffer;
 import java.nio.CharBuffer;
+import java.nio.NioUtils;
 import java.nio.charset.Charset;
 import java.nio.charset.CharsetDecoder;
 import java.nio.charset.CoderResult;
@@ -199,11 +200,23 @@ public final class CharsetDecoderICU extends CharsetDecoder {
             return CoderResult.UNDERFLOW;
         }
 
-        data[INPUT_OFFSET] = getArray(in);
+        // Direct input is read in place rather than copied to a temporary array.
+        boolean directInput = in.isDirect();
+        if (directInput) {
+            inEnd = in.remaining();
+            data[INPUT_OFFSET] = savedInputHeldLen;
+        } else {
+            data[INPUT_OFFSET] = getArray(in);
+        }
         data[OUTPUT_OFFSET]= getArray(out);
         data[INPUT_HELD] = 0;
 
         try{
+            if (directInput) {
+                ec = NativeConverter.decodeDirect(converterHandle,
+                        NioUtils.getDirectBufferAddress(in) + in.position(), inEnd,
+                        output, outEnd, data, false);
+            } else {
             ec = NativeConverter.decode(
                                 converterHandle,  /* Handle to ICU Converter */
                                 input,            /* input array of bytes */
@@ -213,6 +226,7 @@ public final class CharsetDecoderICU extends CharsetDecoder {
                                 data,             /* contains data, inOff,outOff */
                                 false             /* don't flush the data */
                                 );
+            }
 
             // Return an error.
             if (ec == ErrorCode.U_BUFFER_OVERFLOW_ERROR) {
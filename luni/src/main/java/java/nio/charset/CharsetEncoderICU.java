@@ -16,6 +16,7 @@ package libcore.icu;
 
 import java.nio.ByteBuffer;
 import java.nio.CharBuffer;
+import java.nio.NioUtils;
 import java.nio.charset.Charset;
 import java.nio.charset.CharsetEncoder;
 import java.nio.charset.CoderResult;
@@ -214,7 +215,14 @@ public final class CharsetEncoderICU extends CharsetEncoder {
         }
 
         data[INPUT_OFFSET] = getArray(in);
-        data[OUTPUT_OFFSET]= getArray(out);
+        // Direct output is written in place rather than through a temporary array.
+        boolean directOutput = out.isDirect();
+        if (directOutput) {
+            outEnd = out.remaining();
+            data[OUTPUT_OFFSET] = 0;
+        } else {
+            data[OUTPUT_OFFSET]= getArray(out);
+        }
         data[INPUT_HELD] = 0;
         // BEGIN android-added
         data[INVALID_CHARS] = 0; // Make sure we don't see earlier errors.
@@ -222,6 +230,10 @@ public final class CharsetEncoderICU extends CharsetEncoder {
 
         try {
             /* do the conversion */
+            if (directOutput) {
+                ec = NativeConverter.encodeDirect(converterHandle, input, inEnd,
+                        NioUtils.getDirectBufferAddress(out) + out.position(), outEnd, data, false);
+            } else {
             ec = NativeConverter.encode(converterHandle,/* Handle to ICU Converter */
                                         input, /* input array of bytes */
                                         inEnd, /* last index+1 to be converted */
@@ -230,6 +242,7 @@ public final class CharsetEncoderICU extends CharsetEncoder {
                                         data, /* contains data, inOff,outOff */
                                         false /* donot flush the data */
                                         );
+            }
             if (ErrorCode.isFailure(ec)) {
                 /* If we don't have room for the output return error */
                 if (ec == ErrorCode.U_BUFFER_OVERFLOW_ERROR) {
@@ -245,7 +258,11 @@ public final class CharsetEncoderICU extends CharsetEncoder {
         } finally {
             /* save state */
             setPosition(in);
-            setPosition(out);
+            if (directOutput) {
+                out.position(out.position() + data[OUTPUT_OFFSET]);
+            } else {
+                setPosition(out);
+            }
         }
     }
 
@@ -94,6 +94,14 @@ public class Charsets {
      */
     public static native void isoLatin1BytesToChars(byte[] bytes, int offset, int length, char[] chars);
 
+    /**
+     * Decodes the given UTF-8 bytes into the given char[], which must have room
+     * for {@code length} chars, and returns the number of chars written.
+     * Malformed input is replaced by U+FFFD exactly as String's UTF-8 decoder
+     * always has done it.
+     */
+    public static native int utf8BytesToChars(byte[] bytes, int offset, int length, char[] chars);
+
     private Charsets() {
     }
 }
@@ -143,13 +143,7 @@ public final class Bidi {
             ((NumericShaper) numericShaper).shape(text, 0, length);
         }
 
-        long bidi = 0;
-        try {
-            bidi = createUBiDi(text, 0, embeddings, 0, length, flags);
-            readBidiInfo(bidi);
-        } finally {
-            NativeBidi.ubidi_close(bidi);
-        }
+        analyze(text, 0, embeddings, 0, length, flags);
     }
 
     /**
@@ -208,13 +202,7 @@ public final class Bidi {
             throw new IllegalArgumentException("Negative paragraph length " + paragraphLength);
         }
 
-        long bidi = 0;
-        try {
-            bidi = createUBiDi(text, textStart, embeddings, embStart, paragraphLength, flags);
-            readBidiInfo(bidi);
-        } finally {
-            NativeBidi.ubidi_close(bidi);
-        }
+        analyze(text, textStart, embeddings, embStart, paragraphLength, flags);
     }
 
     /**
@@ -241,46 +229,21 @@ public final class Bidi {
     // create the native UBiDi struct, need to be closed with ubidi_close().
     private static long createUBiDi(char[] text, int textStart,
             byte[] embeddings, int embStart, int paragraphLength, int flags) {
-        char[] realText = null;
-
-        byte[] realEmbeddings = null;
-
         if (text == null || text.length - textStart < paragraphLength) {
             throw new IllegalArgumentException();
         }
-        realText = new char[paragraphLength];
+        char[] realText = new char[paragraphLength];
         System.arraycopy(text, textStart, realText, 0, paragraphLength);
 
-        if (embeddings != null) {
-            if (embeddings.length - embStart < paragraphLength) {
-                throw new IllegalArgumentException();
-            }
-            if (paragraphLength > 0) {
-                Bidi temp = new Bidi(text, textStart, null, 0, paragraphLength, flags);
-                realEmbeddings = new byte[paragraphLength];
-                System.arraycopy(temp.offsetLevel, 0, realEmbeddings, 0, paragraphLength);
-                for (int i = 0; i < paragraphLength; i++) {
-                    byte e = embeddings[i];
-                    if (e < 0) {
-                        realEmbeddings[i] = (byte) (NativeBidi.UBIDI_LEVEL_OVERRIDE - e);
-                    } else if (e > 0) {
-                        realEmbeddings[i] = e;
-                    } else {
-                        realEmbeddings[i] |= (byte) NativeBidi.UBIDI_LEVEL_OVERRIDE;
-                    }
-                }
-            }
-        }
-
-        if (flags > 1 || flags < -2) {
-            flags = 0;
-        }
+        byte[] realEmbeddings = realEmbeddings(text, textStart, embeddings, embStart,
+                paragraphLength, flags);
 
         long bidi = 0;
         boolean needsDeletion = true;
         try {
             bidi = NativeBidi.ubidi_open();
-            NativeBidi.ubidi_setPara(bidi, realText, paragraphLength, flags, realEmbeddings);
+            NativeBidi.ubidi_setPara(bidi, realText, paragraphLength, realFlags(flags),
+                    realEmbeddings);
             needsDeletion = false;
         } finally {
             if (needsDeletion) {
@@ -290,6 +253,74 @@ public final class Bidi {
         return bidi;
     }
 
+    // Runs the algorithm over the paragraph and reads the results back in a single native call,
+    // rather than open/setPara/get*/close through a native UBiDi struct.
+    private void analyze(char[] text, int textStart,
+            byte[] embeddings, int embStart, int paragraphLength, int flags) {
+        if (text == null || text.length - textStart < paragraphLength) {
+            throw new IllegalArgumentException();
+        }
+        byte[] realEmbeddings = realEmbeddings(text, textStart, embeddings, embStart,
+                paragraphLength, flags);
+        byte[] levels = new byte[paragraphLength];
+        int[] info = NativeBidi.ubidi_analyze(text, textStart, paragraphLength, realFlags(flags),
+                realEmbeddings, levels, null);
+
+        length = paragraphLength;
+        offsetLevel = (length == 0) ? null : levels;
+        direction = info[0];
+        baseLevel = info[1];
+
+        int runCount = info[2];
+        if (runCount == 0) {
+            unidirectional = true;
+            runs = null;
+        } else if (runCount == 1 && info[5] == baseLevel) {
+            // Simplified case for one run which has the base level
+            unidirectional = true;
+            runs = null;
+        } else {
+            runs = new BidiRun[runCount];
+            for (int i = 0; i < runCount; ++i) {
+                runs[i] = new BidiRun(info[3 + 3 * i], info[4 + 3 * i], info[5 + 3 * i]);
+            }
+        }
+    }
+
+    // Translates java.text.Bidi embeddings into the levels and overrides ICU expects, or returns
+    // null if there aren't any.
+    private static byte[] realEmbeddings(char[] text, int textStart,
+            byte[] embeddings, int embStart, int paragraphLength, int flags) {
+        if (embeddings == null) {
+            return null;
+        }
+        if (embeddings.length - embStart < paragraphLength) {
+            throw new IllegalArgumentException();
+        }
+        if (paragraphLength == 0) {
+            return null;
+        }
+        Bidi temp = new Bidi(text, textStart, null, 0, paragraphLength, flags);
+        byte[] realEmbeddings = new byte[paragraphLength];
+        System.arraycopy(temp.offsetLevel, 0, realEmbeddings, 0, paragraphLength);
+        for (int i = 0; i < paragraphLength; i++) {
+            byte e = embeddings[i];
+            if (e < 0) {
+                realEmbeddings[i] = (byte) (NativeBidi.UBIDI_LEVEL_OVERRIDE - e);
+            } else if (e > 0) {
+                realEmbeddings[i] = e;
+            } else {
+                realEmbeddings[i] |= (byte) NativeBidi.UBIDI_LEVEL_OVERRIDE;
+            }
+        }
+        return realEmbeddings;
+    }
+
+    // Unknown directions are treated as DIRECTION_DEFAULT_LEFT_TO_RIGHT.
+    private static int realFlags(int flags) {
+        return (flags > 1 || flags < -2) ? 0 : flags;
+    }
+
     /* private constructor used by createLineBidi() */
     private Bidi(long pBidi) {
         readBidiInfo(pBidi);
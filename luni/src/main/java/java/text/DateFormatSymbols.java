@@ -107,18 +107,18 @@ public class DateFormatSymbols implements Serializable, Cloneable {
         this.locale = locale;
         this.localPatternChars = SimpleDateFormat.PATTERN_CHARS;
         LocaleData localeData = LocaleData.get(locale);
-        this.ampms = localeData.amPm;
-        this.eras = localeData.eras;
-        this.months = localeData.longMonthNames;
-        this.shortMonths = localeData.shortMonthNames;
-        this.weekdays = localeData.longWeekdayNames;
-        this.shortWeekdays = localeData.shortWeekdayNames;
+        this.ampms = localeData.getAmPm();
+        this.eras = localeData.getEras();
+        this.months = localeData.getLongMonthNames();
+        this.shortMonths = localeData.getShortMonthNames();
+        this.weekdays = localeData.getLongWeekdayNames();
+        this.shortWeekdays = localeData.getShortWeekdayNames();
 
         // ICU/Android extensions.
-        this.longStandAloneMonths = localeData.longStandAloneMonthNames;
-        this.shortStandAloneMonths = localeData.shortStandAloneMonthNames;
-        this.longStandAloneWeekdays = localeData.longStandAloneWeekdayNames;
-        this.shortStandAloneWeekdays = localeData.shortStandAloneWeekdayNames;
+        this.longStandAloneMonths = localeData.getLongStandAloneMonthNames();
+        this.shortStandAloneMonths = localeData.getShortStandAloneMonthNames();
+        this.longStandAloneWeekdays = localeData.getLongStandAloneWeekdayNames();
+        this.shortStandAloneWeekdays = localeData.getShortStandAloneWeekdayNames();
     }
 
     /**
@@ -522,7 +522,7 @@ public class DecimalFormat extends NumberFormat {
     public DecimalFormat() {
         Locale locale = Locale.getDefault();
         this.symbols = new DecimalFormatSymbols(locale);
-        initNative(LocaleData.get(locale).numberPattern);
+        initNative(LocaleData.get(locale).getNumberPattern());
     }
 
     /**
@@ -686,14 +686,22 @@ public class DecimalFormat extends NumberFormat {
                 setRoundingMode(RoundingMode.UNNECESSARY);
             }
         }
-        buffer.append(dform.formatDouble(value, position));
+        if (NativeDecimalFormat.needsFieldPosition(position)) {
+            buffer.append(dform.formatDouble(value, position));
+        } else {
+            dform.formatDouble(value, buffer);
+        }
         return buffer;
     }
 
     @Override
     public StringBuffer format(long value, StringBuffer buffer, FieldPosition position) {
         checkBufferAndFieldPosition(buffer, position);
-        buffer.append(dform.formatLong(value, position));
+        if (NativeDecimalFormat.needsFieldPosition(position)) {
+            buffer.append(dform.formatLong(value, position));
+        } else {
+            dform.formatLong(value, buffer);
+        }
         return buffer;
     }
 
@@ -82,18 +82,18 @@ public class DecimalFormatSymbols implements Cloneable, Serializable {
      */
     public DecimalFormatSymbols(Locale locale) {
         LocaleData localeData = LocaleData.get(locale);
-        this.zeroDigit = localeData.zeroDigit;
-        this.digit = localeData.digit;
-        this.decimalSeparator = localeData.decimalSeparator;
-        this.groupingSeparator = localeData.groupingSeparator;
-        this.patternSeparator = localeData.patternSeparator;
-        this.percent = localeData.percent;
-        this.perMill = localeData.perMill;
-        this.monetarySeparator = localeData.monetarySeparator;
-        this.minusSign = localeData.minusSign;
-        this.infinity = localeData.infinity;
-        this.NaN = localeData.NaN;
-        this.exponentSeparator = localeData.exponentSeparator;
+        this.zeroDigit = localeData.getZeroDigit();
+        this.digit = localeData.getDigit();
+        this.decimalSeparator = localeData.getDecimalSeparator();
+        this.groupingSeparator = localeData.getGroupingSeparator();
+        this.patternSeparator = localeData.getPatternSeparator();
+        this.percent = localeData.getPercent();
+        this.perMill = localeData.getPerMill();
+        this.monetarySeparator = localeData.getMonetarySeparator();
+        this.minusSign = localeData.getMinusSign();
+        this.infinity = localeData.getInfinity();
+        this.NaN = localeData.getNaN();
+        this.exponentSeparator = localeData.getExponentSeparator();
         this.locale = locale;
         try {
             currency = Currency.getInstance(locale);
@@ -101,8 +101,8 @@ public class DecimalFormatSymbols implements Cloneable, Serializable {
             intlCurrencySymbol = currency.getCurrencyCode();
         } catch (IllegalArgumentException e) {
             currency = Currency.getInstance("XXX");
-            currencySymbol = localeData.currencySymbol;
-            intlCurrencySymbol = localeData.internationalCurrencySymbol;
+            currencySymbol = localeData.getCurrencySymbol();
+            intlCurrencySymbol = localeData.getInternationalCurrencySymbol();
         }
     }
 
@@ -212,7 +212,9 @@ public abstract class NumberFormat extends Format {
      * @return the formatted string.
      */
     public final String format(double value) {
-        return format(value, new StringBuffer(), new FieldPosition(0))
+        // We throw the field position away, so ask for no field: that lets DecimalFormat skip
+        // tracking where the fields are.
+        return format(value, new StringBuffer(), new FieldPosition(-1))
                 .toString();
     }
 
@@ -245,7 +247,7 @@ public abstract class NumberFormat extends Format {
      * @return the formatted string.
      */
     public final String format(long value) {
-        return format(value, new StringBuffer(), new FieldPosition(0))
+        return format(value, new StringBuffer(), new FieldPosition(-1))
                 .toString();
     }
 
@@ -353,7 +355,7 @@ public abstract class NumberFormat extends Format {
      * @return a {@code NumberFormat} for handling currency values.
      */
     public static NumberFormat getCurrencyInstance(Locale locale) {
-        return getInstance(LocaleData.get(locale).currencyPattern, locale);
+        return getInstance(LocaleData.get(locale).getCurrencyPattern(), locale);
     }
 
     /**
@@ -376,7 +378,7 @@ public abstract class NumberFormat extends Format {
      * @return a {@code NumberFormat} for handling integers.
      */
     public static NumberFormat getIntegerInstance(Locale locale) {
-        NumberFormat result = getInstance(LocaleData.get(locale).integerPattern, locale);
+        NumberFormat result = getInstance(LocaleData.get(locale).getIntegerPattern(), locale);
         result.setParseIntegerOnly(true);
         return result;
     }
@@ -471,7 +473,7 @@ public abstract class NumberFormat extends Format {
      * @return a {@code NumberFormat} for handling {@code Number} objects.
      */
     public static NumberFormat getNumberInstance(Locale locale) {
-        return getInstance(LocaleData.get(locale).numberPattern, locale);
+        return getInstance(LocaleData.get(locale).getNumberPattern(), locale);
     }
 
     /**
@@ -498,7 +500,7 @@ public abstract class NumberFormat extends Format {
      * treated as 5,300%, which is rarely what you intended.
      */
     public static NumberFormat getPercentInstance(Locale locale) {
-        return getInstance(LocaleData.get(locale).percentPattern, locale);
+        return getInstance(LocaleData.get(locale).getPercentPattern(), locale);
     }
 
     @Override
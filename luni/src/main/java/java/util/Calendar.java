@@ -722,8 +722,8 @@ public abstract class Calendar implements Serializable, Cloneable, Comparable<Ca
     protected Calendar(TimeZone timezone, Locale locale) {
         this(timezone);
         LocaleData localeData = LocaleData.get(locale);
-        setFirstDayOfWeek(localeData.firstDayOfWeek.intValue());
-        setMinimalDaysInFirstWeek(localeData.minimalDaysInFirstWeek.intValue());
+        setFirstDayOfWeek(localeData.getFirstDayOfWeek().intValue());
+        setMinimalDaysInFirstWeek(localeData.getMinimalDaysInFirstWeek().intValue());
     }
 
 
@@ -165,8 +165,8 @@ public final class Currency implements Serializable {
 
         // Check the locale first, in case the locale has the same currency.
         LocaleData localeData = LocaleData.get(locale);
-        if (localeData.internationalCurrencySymbol.equals(currencyCode)) {
-            return localeData.currencySymbol;
+        if (localeData.getInternationalCurrencySymbol().equals(currencyCode)) {
+            return localeData.getCurrencySymbol();
         }
 
         // Try ICU, and fall back to the currency code if ICU has nothing.
@@ -1443,7 +1443,7 @@ public final class Formatter implements Closeable, Flushable {
                 }
                 break;
             case 'd':
-                boolean needLocalizedDigits = (localeData.zeroDigit != '0');
+                boolean needLocalizedDigits = (localeData.getZeroDigit() != '0');
                 if (out instanceof StringBuilder && !needLocalizedDigits) {
                     if (arg instanceof Integer || arg instanceof Short || arg instanceof Byte) {
                         IntegralToString.appendInt((StringBuilder) out, ((Number) arg).intValue());
@@ -1516,7 +1516,7 @@ public final class Formatter implements Closeable, Flushable {
      */
     private CharSequence localizeDigits(CharSequence s) {
         int length = s.length();
-        int offsetToLocalizedDigits = localeData.zeroDigit - '0';
+        int offsetToLocalizedDigits = localeData.getZeroDigit() - '0';
         StringBuilder result = new StringBuilder(length);
         for (int i = 0; i < length; ++i) {
             char ch = s.charAt(i);
@@ -1554,7 +1554,7 @@ public final class Formatter implements Closeable, Flushable {
 
         // Append the remaining groups.
         for (; i < s.length(); i += 3) {
-            result.append(localeData.groupingSeparator);
+            result.append(localeData.getGroupingSeparator());
             result.append(s, i, i + 3);
         }
         return result;
@@ -1665,7 +1665,7 @@ public final class Formatter implements Closeable, Flushable {
         char paddingChar = '\u0020'; // space as padding char.
         if (formatToken.flagZero) {
             if (formatToken.getConversionType() == 'd') {
-                paddingChar = localeData.zeroDigit;
+                paddingChar = localeData.getZeroDigit();
             } else {
                 paddingChar = '0'; // No localized digits for bases other than decimal.
             }
@@ -1736,7 +1736,7 @@ public final class Formatter implements Closeable, Flushable {
             if (formatToken.flagComma) {
                 digits = insertGrouping(digits);
             }
-            if (localeData.zeroDigit != '0') {
+            if (localeData.getZeroDigit() != '0') {
                 digits = localizeDigits(digits);
             }
             result.append(digits);
@@ -1868,16 +1868,16 @@ public final class Formatter implements Closeable, Flushable {
     private boolean appendT(StringBuilder result, char conversion, Calendar calendar) {
         switch (conversion) {
         case 'A':
-            result.append(localeData.longWeekdayNames[calendar.get(Calendar.DAY_OF_WEEK)]);
+            result.append(localeData.getLongWeekdayNames()[calendar.get(Calendar.DAY_OF_WEEK)]);
             return true;
         case 'a':
-            result.append(localeData.shortWeekdayNames[calendar.get(Calendar.DAY_OF_WEEK)]);
+            result.append(localeData.getShortWeekdayNames()[calendar.get(Calendar.DAY_OF_WEEK)]);
             return true;
         case 'B':
-            result.append(localeData.longMonthNames[calendar.get(Calendar.MONTH)]);
+            result.append(localeData.getLongMonthNames()[calendar.get(Calendar.MONTH)]);
             return true;
         case 'b': case 'h':
-            result.append(localeData.shortMonthNames[calendar.get(Calendar.MONTH)]);
+            result.append(localeData.getShortMonthNames()[calendar.get(Calendar.MONTH)]);
             return true;
         case 'C':
             appendLocalized(result, calendar.get(Calendar.YEAR) / 100, 2);
@@ -1970,7 +1970,7 @@ public final class Formatter implements Closeable, Flushable {
             appendLocalized(result, calendar.get(Calendar.MONTH) + 1, 2);
             return true;
         case 'p':
-            result.append(localeData.amPm[calendar.get(Calendar.AM_PM)].toLowerCase(locale));
+            result.append(localeData.getAmPm()[calendar.get(Calendar.AM_PM)].toLowerCase(locale));
             return true;
         case 'r':
             appendT(result, 'I', calendar);
@@ -1979,7 +1979,7 @@ public final class Formatter implements Closeable, Flushable {
             result.append(':');
             appendT(result, 'S', calendar);
             result.append(' ');
-            result.append(localeData.amPm[calendar.get(Calendar.AM_PM)]);
+            result.append(localeData.getAmPm()[calendar.get(Calendar.AM_PM)]);
             return true;
         case 's':
             appendLocalized(result, calendar.getTimeInMillis() / 1000, 0);
@@ -2008,7 +2008,7 @@ public final class Formatter implements Closeable, Flushable {
 
     private void appendLocalized(StringBuilder result, long value, int width) {
         int paddingIndex = result.length();
-        char zeroDigit = localeData.zeroDigit;
+        char zeroDigit = localeData.getZeroDigit();
         if (zeroDigit == '0') {
             result.append(value);
         } else {
@@ -2097,7 +2097,7 @@ public final class Formatter implements Closeable, Flushable {
         formatToken.setPrecision(FormatToken.UNSET);
 
         int startIndex = 0;
-        if (result.charAt(0) == localeData.minusSign) {
+        if (result.charAt(0) == localeData.getMinusSign()) {
             if (formatToken.flagParenthesis) {
                 return wrapParentheses(result);
             }
@@ -2113,7 +2113,7 @@ public final class Formatter implements Closeable, Flushable {
         }
 
         char firstChar = result.charAt(0);
-        if (formatToken.flagZero && (firstChar == '+' || firstChar == localeData.minusSign)) {
+        if (formatToken.flagZero && (firstChar == '+' || firstChar == localeData.getMinusSign())) {
             startIndex = 1;
         }
 
@@ -2153,7 +2153,7 @@ public final class Formatter implements Closeable, Flushable {
         // The # flag requires that we always output a decimal separator.
         if (formatToken.flagSharp && precision == 0) {
             int indexOfE = result.indexOf("e");
-            result.insert(indexOfE, localeData.decimalSeparator);
+            result.insert(indexOfE, localeData.getDecimalSeparator());
         }
     }
 
@@ -2250,7 +2250,7 @@ public final class Formatter implements Closeable, Flushable {
         }
         // The # flag requires that we always output a decimal separator.
         if (formatToken.flagSharp && precision == 0) {
-            result.append(localeData.decimalSeparator);
+            result.append(localeData.getDecimalSeparator());
         }
     }
 
@@ -70,6 +70,11 @@ public final class Matcher implements MatchResult {
      */
     private int[] matchOffsets;
 
+    /**
+     * How many matches {@link #replaceAll} asks native code for at a time.
+     */
+    private static final int REPLACE_ALL_BATCH_SIZE = 64;
+
     /**
      * Reflects whether the bounds of the region are anchoring.
      */
@@ -318,9 +323,16 @@ public final class Matcher implements MatchResult {
     public String replaceAll(String replacement) {
         reset();
         StringBuffer buffer = new StringBuffer(input.length());
-        while (find()) {
-            appendReplacement(buffer, replacement);
-        }
+        int[] matches;
+        do {
+            matches = findAll(REPLACE_ALL_BATCH_SIZE);
+            for (int i = 0; i < matches.length; i += matchOffsets.length) {
+                System.arraycopy(matches, i, matchOffsets, 0, matchOffsets.length);
+                matchFound = true;
+                appendReplacement(buffer, replacement);
+            }
+        } while (matches.length == REPLACE_ALL_BATCH_SIZE * matchOffsets.length);
+        matchFound = false;
         return appendTail(buffer).toString();
     }
 
@@ -420,6 +432,28 @@ public final class Matcher implements MatchResult {
         return matchFound;
     }
 
+    /**
+     * Finds up to {@code limit} further occurrences of the {@link Pattern} in
+     * one call to native code, leaving this matcher just as that many calls
+     * to {@link #find()} would. Returns the offsets of each match in turn,
+     * laid out as {@link #matchOffsets}: a start and an end for each group,
+     * group 0 first. Fewer than {@code limit} matches means there are no
+     * more, and no current match.
+     */
+    int[] findAll(int limit) {
+        int[] matches = findAllImpl(address, input, limit);
+        if (matches.length > 0) {
+            System.arraycopy(matches, matches.length - matchOffsets.length,
+                    matchOffsets, 0, matchOffsets.length);
+            findPos = matchOffsets[1];
+            matchFound = true;
+        }
+        if (matches.length / matchOffsets.length < limit) {
+            matchFound = false;
+        }
+        return matches;
+    }
+
     /**
      * Tries to match the {@link Pattern}, starting from the beginning of the
      * region (or the beginning of the input, if no region has been set).
@@ -669,6 +703,7 @@ public final class Matcher implements MatchResult {
     }
 
     private static native void closeImpl(int addr);
+    private static native int[] findAllImpl(int addr, String s, int limit);
     private static native boolean findImpl(int addr, String s, int startIndex, int[] offsets);
     private static native boolean findNextImpl(int addr, String s, int[] offsets);
     private static native int groupCountImpl(int addr);
@@ -211,7 +211,8 @@ import java.io.Serializable;
  *
  * <p>In some cases, Android will recognize that a regular expression is a simple
  * special case that can be handled more efficiently. This is true of both the convenience methods
- * in {@code String} and the methods in {@code Pattern}.
+ * in {@code String} and the methods in {@code Pattern}. The compiled forms of recently used
+ * regular expressions are also shared, so compiling the same regular expression again is cheap.
  *
  * @see Matcher
  */
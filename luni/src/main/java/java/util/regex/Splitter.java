@@ -91,10 +91,12 @@ public class Splitter {
         ArrayList<String> list = new ArrayList<String>();
         int maxSize = limit <= 0 ? Integer.MAX_VALUE : limit;
         Matcher matcher = new Matcher(pattern, input);
+        int[] matches = matcher.findAll(maxSize - 1);
+        int stride = 2 * (matcher.groupCount() + 1);
         int begin = 0;
-        while (matcher.find() && list.size() + 1 < maxSize) {
-            list.add(input.substring(begin, matcher.start()));
-            begin = matcher.end();
+        for (int i = 0; i < matches.length; i += stride) {
+            list.add(input.substring(begin, matches[i]));
+            begin = matches[i + 1];
         }
         return finishSplit(list, input, begin, maxSize, limit);
     }
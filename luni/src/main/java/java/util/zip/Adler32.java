@@ -17,6 +17,9 @@
 
 package java.util.zip;
 
+import java.nio.ByteBuffer;
+import java.nio.NioUtils;
+
 /**
  * The Adler-32 class is used to compute the {@code Adler32} checksum from a set
  * of data. Compared to {@link CRC32} it trades reliability for speed.
@@ -50,7 +53,12 @@ public class Adler32 implements java.util.zip.Checksum {
      *            the byte to update checksum with.
      */
     public void update(int i) {
-        adler = updateByteImpl(i, adler);
+        // A single byte isn't worth a JNI call.
+        long s1 = adler & 0xffff;
+        long s2 = adler >>> 16;
+        s1 = (s1 + (i & 0xff)) % 65521;
+        s2 = (s2 + s1) % 65521;
+        adler = (s2 << 16) | s1;
     }
 
     /**
@@ -87,7 +95,39 @@ public class Adler32 implements java.util.zip.Checksum {
         }
     }
 
+    /**
+     * Updates this checksum with the bytes remaining in {@code buffer}, from
+     * its position to its limit, and advances its position to its limit.
+     * Direct buffers are checksummed in place, without copying.
+     *
+     * @hide
+     */
+    public void update(ByteBuffer buffer) {
+        int position = buffer.position();
+        int remaining = buffer.remaining();
+        if (buffer.isDirect()) {
+            adler = updateDirectImpl(NioUtils.getDirectBufferAddress(buffer) + position,
+                    remaining, adler);
+        } else if (buffer.hasArray()) {
+            update(buffer.array(), buffer.arrayOffset() + position, remaining);
+        } else {
+            byte[] bytes = new byte[remaining];
+            buffer.get(bytes);
+            update(bytes);
+            return;
+        }
+        buffer.position(position + remaining);
+    }
+
+    /**
+     * Returns the Adler32 of two pieces of data laid end to end, given the
+     * Adler32 of each piece and the length of the second piece.
+     *
+     * @hide
+     */
+    public static native long combine(long adler1, long adler2, long len2);
+
     private native long updateImpl(byte[] buf, int off, int nbytes, long adler1);
 
-    private native long updateByteImpl(int val, long adler1);
+    private static native long updateDirectImpl(int address, int nbytes, long adler1);
 }
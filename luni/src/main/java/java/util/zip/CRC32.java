@@ -17,12 +17,27 @@
 
 package java.util.zip;
 
+import java.nio.ByteBuffer;
+import java.nio.NioUtils;
+
 /**
  * The CRC32 class is used to compute a CRC32 checksum from data provided as
  * input value.
  */
 public class CRC32 implements java.util.zip.Checksum {
 
+    // For single-byte updates, which aren't worth a JNI call.
+    private static final int[] TABLE = new int[256];
+    static {
+        for (int n = 0; n < 256; ++n) {
+            int c = n;
+            for (int k = 0; k < 8; ++k) {
+                c = ((c & 1) != 0) ? (0xedb88320 ^ (c >>> 1)) : (c >>> 1);
+            }
+            TABLE[n] = c;
+        }
+    }
+
     private long crc = 0L;
 
     long tbytes = 0L;
@@ -51,7 +66,9 @@ public class CRC32 implements java.util.zip.Checksum {
      *            represents the byte to update the checksum.
      */
     public void update(int val) {
-        crc = updateByteImpl((byte) val, crc);
+        int c = ~(int) crc;
+        c = TABLE[(c ^ val) & 0xff] ^ (c >>> 8);
+        crc = ~c & 0xffffffffL;
     }
 
     /**
@@ -86,7 +103,40 @@ public class CRC32 implements java.util.zip.Checksum {
         }
     }
 
+    /**
+     * Updates this checksum with the bytes remaining in {@code buffer}, from
+     * its position to its limit, and advances its position to its limit.
+     * Direct buffers are checksummed in place, without copying.
+     *
+     * @hide
+     */
+    public void update(ByteBuffer buffer) {
+        int position = buffer.position();
+        int remaining = buffer.remaining();
+        if (buffer.isDirect()) {
+            tbytes += remaining;
+            crc = updateDirectImpl(NioUtils.getDirectBufferAddress(buffer) + position,
+                    remaining, crc);
+        } else if (buffer.hasArray()) {
+            update(buffer.array(), buffer.arrayOffset() + position, remaining);
+        } else {
+            byte[] bytes = new byte[remaining];
+            buffer.get(bytes);
+            update(bytes);
+            return;
+        }
+        buffer.position(position + remaining);
+    }
+
+    /**
+     * Returns the CRC32 of two pieces of data laid end to end, given the
+     * CRC32 of each piece and the length of the second piece.
+     *
+     * @hide
+     */
+    public static native long combine(long crc1, long crc2, long len2);
+
     private native long updateImpl(byte[] buf, int off, int nbytes, long crc1);
 
-    private native long updateByteImpl(byte val, long crc1);
+    private static native long updateDirectImpl(int address, int nbytes, long crc1);
 }
@@ -18,6 +18,9 @@
 package java.util.zip;
 
 import dalvik.system.CloseGuard;
+import java.nio.ByteBuffer;
+import java.nio.NioUtils;
+import java.nio.ReadOnlyBufferException;
 
 /**
  * This class compresses data using the <i>DEFLATE</i> algorithm (see <a
@@ -242,9 +245,60 @@ public class Deflater {
         return deflateImpl(buf, off, nbytes, streamHandle, flush);
     }
 
+    /**
+     * Deflates the bytes remaining in {@code input} into the space remaining in
+     * {@code output}, advancing both buffers' positions past the bytes consumed
+     * and produced. Both must be direct buffers; neither is copied through the
+     * Java heap. Input that isn't consumed stays in {@code input} and must be
+     * passed again; any input passed to {@link #setInput} beforehand is
+     * discarded. Call {@link #finish} first to end the stream, and repeat
+     * until {@link #finished} returns true.
+     *
+     * @param flush one of {@link #NO_FLUSH}, {@link #SYNC_FLUSH} or
+     *      {@link #FULL_FLUSH}. Ignored after {@link #finish}.
+     * @return the number of bytes written to {@code output}.
+     * @hide
+     */
+    public synchronized int deflate(ByteBuffer input, ByteBuffer output, int flush) {
+        if (flush != NO_FLUSH && flush != SYNC_FLUSH && flush != FULL_FLUSH) {
+            throw new IllegalArgumentException();
+        }
+        if (!input.isDirect() || !output.isDirect()) {
+            throw new IllegalArgumentException("buffers must be direct");
+        }
+        if (output.isReadOnly()) {
+            throw new ReadOnlyBufferException();
+        }
+        if (streamHandle == -1) {
+            throw new IllegalStateException();
+        }
+        if (inputBuffer == null) {
+            setLevelsImpl(compressLevel, strategy, streamHandle);
+            inputBuffer = STUB_INPUT_BUFFER;
+        }
+        int inPosition = input.position();
+        int outPosition = output.position();
+        inRead = 0;
+        inLength = input.remaining();
+        int result;
+        try {
+            result = deflateDirectImpl(NioUtils.getDirectBufferAddress(input) + inPosition,
+                    inLength, NioUtils.getDirectBufferAddress(output) + outPosition,
+                    output.remaining(), streamHandle, flushParm == FINISH ? FINISH : flush);
+            input.position(inPosition + inRead);
+        } finally {
+            inRead = inLength = 0;
+        }
+        output.position(outPosition + result);
+        return result;
+    }
+
     private synchronized native int deflateImpl(byte[] buf, int off,
             int nbytes, long handle, int flushParm1);
 
+    private synchronized native int deflateDirectImpl(int inAddress, int inLength,
+            int outAddress, int outLength, long handle, int flushParm1);
+
     private synchronized native void endImpl(long handle);
 
     /**
@@ -562,4 +616,32 @@ public class Deflater {
     }
 
     private native long createStream(int level, int strategy1, boolean noHeader1);
+
+    /**
+     * Sets how many ended deflaters' native streams are kept for reuse by
+     * later ones with the same parameters: at most {@code maxPerKey} for
+     * any one combination of parameters, and {@code maxTotal} in all. Streams
+     * over the new limits are freed. Zero turns the pool off. The defaults are
+     * 4 and 8.
+     *
+     * @hide
+     */
+    public static native void setStreamPoolLimits(int maxPerKey, int maxTotal);
+
+    /**
+     * Returns the {@link #setStreamPoolLimits stream pool}'s hit count, miss
+     * count, and the number of streams it currently holds, in that order.
+     *
+     * @hide
+     */
+    public static native long[] getStreamPoolStats();
+
+    /**
+     * Compresses one block of a stream deflated in parallel by {@link
+     * ParallelDeflaterOutputStream}, returning raw deflate data. Blocks other
+     * than the last end on a byte boundary and can simply be concatenated.
+     */
+    static native byte[] deflateBlockImpl(byte[] buf, int off, int nbytes,
+            byte[] dictionary, int dictionaryOff, int dictionaryLength,
+            int level, int strategy, boolean last);
 }
@@ -19,6 +19,9 @@ package java.util.zip;
 
 import dalvik.system.CloseGuard;
 import java.io.FileDescriptor;
+import java.nio.ByteBuffer;
+import java.nio.NioUtils;
+import java.nio.ReadOnlyBufferException;
 
 /**
  * This class uncompresses data that was compressed using the <i>DEFLATE</i>
@@ -72,6 +75,25 @@ public class Inflater {
 
     private native long createStream(boolean noHeader1);
 
+    /**
+     * Sets how many ended inflaters' native streams are kept for reuse by
+     * later ones with the same parameters: at most {@code maxPerKey} for
+     * any one combination of parameters, and {@code maxTotal} in all. Streams
+     * over the new limits are freed. Zero turns the pool off. The defaults are
+     * 4 and 8.
+     *
+     * @hide
+     */
+    public static native void setStreamPoolLimits(int maxPerKey, int maxTotal);
+
+    /**
+     * Returns the {@link #setStreamPoolLimits stream pool}'s hit count, miss
+     * count, and the number of streams it currently holds, in that order.
+     *
+     * @hide
+     */
+    public static native long[] getStreamPoolStats();
+
     /**
      * Release any resources associated with this {@code Inflater}. Any unused
      * input/output is discarded. This is also called by the finalize method.
@@ -265,6 +287,53 @@ public class Inflater {
         return result;
     }
 
+    /**
+     * Inflates the bytes remaining in {@code input} into the space remaining in
+     * {@code output}, advancing both buffers' positions past the bytes consumed
+     * and produced. Both must be direct buffers; neither is copied through the
+     * Java heap. Input that isn't consumed stays in {@code input}, so once this
+     * returns, {@link #needsInput} and {@link #getRemaining} say nothing about
+     * it; any input passed to {@link #setInput} beforehand is discarded.
+     *
+     * @return the number of bytes written to {@code output}.
+     * @hide
+     */
+    public synchronized int inflate(ByteBuffer input, ByteBuffer output)
+            throws DataFormatException {
+        if (!input.isDirect() || !output.isDirect()) {
+            throw new IllegalArgumentException("buffers must be direct");
+        }
+        if (output.isReadOnly()) {
+            throw new ReadOnlyBufferException();
+        }
+        if (streamHandle == -1) {
+            throw new IllegalStateException();
+        }
+        int inPosition = input.position();
+        int outPosition = output.position();
+        boolean neededDict = needsDictionary;
+        needsDictionary = false;
+        inRead = 0;
+        inLength = input.remaining();
+        int result;
+        try {
+            result = inflateDirectImpl(NioUtils.getDirectBufferAddress(input) + inPosition,
+                    inLength, NioUtils.getDirectBufferAddress(output) + outPosition,
+                    output.remaining(), streamHandle);
+            input.position(inPosition + inRead);
+        } finally {
+            inRead = inLength = 0;
+        }
+        if (needsDictionary && neededDict) {
+            throw new DataFormatException("Needs dictionary");
+        }
+        output.position(outPosition + result);
+        return result;
+    }
+
+    private native synchronized int inflateDirectImpl(int inAddress, int inLength,
+            int outAddress, int outLength, long handle);
+
     private native synchronized int inflateImpl(byte[] buf, int off,
             int nbytes, long handle);
 
@@ -418,6 +487,22 @@ public class Inflater {
         inLength = setFileInputImpl(fd, off, nbytes, streamHandle);
         return inLength;
     }
+
+    /**
+     * Like {@link #setFileInput}, but maps the region into memory and inflates
+     * straight out of the mapping rather than reading it into a buffer first.
+     * The whole region must lie within the file. Only a bounded window at the
+     * start of the region is used at a time, so this may return less than
+     * {@code nbytes}; the caller sets the rest as input later.
+     */
+    synchronized int setMappedFileInput(FileDescriptor fd, long off, int nbytes) {
+        if (streamHandle == -1) {
+            throw new IllegalStateException();
+        }
+        inRead = 0;
+        inLength = setFileMappedInputImpl(fd, off, nbytes, streamHandle);
+        return inLength;
+    }
     // END android-only
 
     private native synchronized void setInputImpl(byte[] buf, int off,
@@ -426,5 +511,8 @@ public class Inflater {
     // BEGIN android-only
     private native synchronized int setFileInputImpl(FileDescriptor fd, long off,
             int nbytes, long handle);
+
+    private native synchronized int setFileMappedInputImpl(FileDescriptor fd, long off,
+            int nbytes, long handle);
     // END android-only
 }
@@ -63,6 +63,13 @@ public class InflaterInputStream extends FilterInputStream {
 
     int nativeEndBufSize = 0; // android-only
 
+    /**
+     * Entries with at least this many compressed bytes are inflated straight
+     * out of a mapping of the archive. Below this, a read is cheaper than setting
+     * up and tearing down a mapping.
+     */
+    static final int MAPPED_INPUT_THRESHOLD = 64 * 1024; // android-only
+
     /**
      * This is the most basic constructor. You only need to pass the {@code
      * InputStream} from which the compressed data is to be read from. Default
@@ -217,6 +224,12 @@ public class InflaterInputStream extends FilterInputStream {
             ZipFile.RAFStream is = (ZipFile.RAFStream)in;
             synchronized (is.mSharedRaf) {
                 long len = is.mLength - is.mOffset;
+                if (len >= MAPPED_INPUT_THRESHOLD && len <= Integer.MAX_VALUE) {
+                    // Map (the next window of) the rest of the entry, with no intermediate copy.
+                    int cnt = inf.setMappedFileInput(is.mSharedRaf.getFD(), is.mOffset, (int) len);
+                    is.skip(cnt);
+                    return;
+                }
                 if (len > nativeEndBufSize) len = nativeEndBufSize;
                 int cnt = inf.setFileInput(is.mSharedRaf.getFD(), is.mOffset, (int)nativeEndBufSize);
                 is.skip(cnt);
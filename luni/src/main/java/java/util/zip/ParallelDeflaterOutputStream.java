@@ -0,0 +1,313 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package java.util.zip;
+
+import java.io.FilterOutputStream;
+import java.io.IOException;
+import java.io.InterruptedIOException;
+import java.io.OutputStream;
+import java.util.ArrayDeque;
+import java.util.concurrent.Callable;
+import java.util.concurrent.ExecutionException;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.Future;
+import java.util.concurrent.ThreadFactory;
+
+/**
+ * Compresses data on several threads at once, in the manner of pigz. The input
+ * is cut into fixed-size blocks, each deflated independently with the last 32
+ * KiB of the block before it as a preset dictionary, and the results are
+ * written out in order as a single deflate, zlib or gzip stream that any
+ * {@link Inflater} can read. The checksum in the trailer is assembled from each
+ * block's own checksum.
+ *
+ * <p>The output is a little larger than a single {@link Deflater} would produce,
+ * because the compressor's state restarts at every block; with the default
+ * 128 KiB blocks the difference is usually well under 1%.
+ *
+ * <p>Instances are not safe for concurrent use by multiple threads.
+ *
+ * @hide
+ */
+public class ParallelDeflaterOutputStream extends FilterOutputStream {
+    /** Raw deflate data, with no header or trailer. */
+    public static final int FORMAT_RAW = 0;
+
+    /** A zlib stream, as written by {@code new Deflater()}. */
+    public static final int FORMAT_ZLIB = 1;
+
+    /** A gzip stream, as written by {@link GZIPOutputStream}. */
+    public static final int FORMAT_GZIP = 2;
+
+    public static final int DEFAULT_BLOCK_SIZE = 128 * 1024;
+
+    /** The deflate window: no match can reach further back than this. */
+    private static final int DICTIONARY_SIZE = 32 * 1024;
+
+    private static final ThreadFactory DAEMON_THREAD_FACTORY = new ThreadFactory() {
+        public Thread newThread(Runnable r) {
+            Thread thread = new Thread(r, "ParallelDeflater");
+            thread.setDaemon(true);
+            return thread;
+        }
+    };
+
+    private static class Block {
+        final byte[] compressed;
+        final long checksum;
+        final int length;
+
+        Block(byte[] compressed, long checksum, int length) {
+            this.compressed = compressed;
+            this.checksum = checksum;
+            this.length = length;
+        }
+    }
+
+    private final int format;
+    private final int level;
+    private final int blockSize;
+    private final ExecutorService executor;
+    private final int maxBlocksInFlight;
+
+    /** Blocks handed to the executor, in output order. */
+    private final ArrayDeque<Future<Block>> pending = new ArrayDeque<Future<Block>>();
+
+    private byte[] buffer;
+    private int count;
+
+    /** The input of the block most recently handed off, for the next block's dictionary. */
+    private byte[] previous;
+    private int previousLength;
+
+    private long checksum;
+    private long totalIn;
+    private boolean finished;
+
+    /**
+     * Constructs a stream writing {@code format} data at the default level,
+     * using one thread per processor.
+     */
+    public ParallelDeflaterOutputStream(OutputStream os, int format) throws IOException {
+        this(os, format, Deflater.DEFAULT_COMPRESSION, DEFAULT_BLOCK_SIZE,
+                Runtime.getRuntime().availableProcessors());
+    }
+
+    /**
+     * Constructs a stream writing {@code format} data at compression level
+     * {@code level}, cutting the input into blocks of {@code blockSize} bytes and
+     * compressing up to {@code threadCount} of them at a time.
+     */
+    public ParallelDeflaterOutputStream(OutputStream os, int format, int level, int blockSize,
+            int threadCount) throws IOException {
+        super(os);
+        if (format < FORMAT_RAW || format > FORMAT_GZIP) {
+            throw new IllegalArgumentException("format=" + format);
+        }
+        if (level < Deflater.DEFAULT_COMPRESSION || level > Deflater.BEST_COMPRESSION) {
+            throw new IllegalArgumentException("level=" + level);
+        }
+        if (blockSize <= 0) {
+            throw new IllegalArgumentException("blockSize=" + blockSize);
+        }
+        if (threadCount <= 0) {
+            throw new IllegalArgumentException("threadCount=" + threadCount);
+        }
+        this.format = format;
+        this.level = level;
+        this.blockSize = blockSize;
+        this.executor = Executors.newFixedThreadPool(threadCount, DAEMON_THREAD_FACTORY);
+        // Keep every thread busy while the oldest block is being written out.
+        this.maxBlocksInFlight = 2 * threadCount;
+        this.buffer = new byte[blockSize];
+        this.checksum = (format == FORMAT_ZLIB) ? 1 : 0;
+        writeHeader();
+    }
+
+    @Override
+    public void write(int b) throws IOException {
+        write(new byte[] { (byte) b }, 0, 1);
+    }
+
+    @Override
+    public void write(byte[] b, int off, int len) throws IOException {
+        if (finished) {
+            throw new IOException("attempt to write after finish");
+        }
+        if ((off | len) < 0 || off > b.length - len) {
+            throw new ArrayIndexOutOfBoundsException();
+        }
+        while (len > 0) {
+            if (count == blockSize) {
+                submitBlock(false);
+            }
+            int n = Math.min(len, blockSize - count);
+            System.arraycopy(b, off, buffer, count, n);
+            count += n;
+            off += n;
+            len -= n;
+        }
+    }
+
+    /**
+     * Writes out every block that has already been compressed. Input that
+     * doesn't yet fill a block stays buffered until it does, or until {@link
+     * #finish}.
+     */
+    @Override
+    public void flush() throws IOException {
+        while (!pending.isEmpty() && pending.peek().isDone()) {
+            writeBlock(pending.remove());
+        }
+        out.flush();
+    }
+
+    /**
+     * Compresses any buffered input, waits for all outstanding blocks and
+     * writes the trailer, without closing the underlying stream.
+     */
+    public void finish() throws IOException {
+        if (finished) {
+            return;
+        }
+        // Always submit a last block, even if it's empty, to mark the end of the stream.
+        submitBlock(true);
+        while (!pending.isEmpty()) {
+            writeBlock(pending.remove());
+        }
+        finished = true;
+        executor.shutdown();
+        writeTrailer();
+    }
+
+    @Override
+    public void close() throws IOException {
+        try {
+            finish();
+        } finally {
+            executor.shutdownNow();
+            out.close();
+        }
+    }
+
+    private void submitBlock(final boolean last) throws IOException {
+        final byte[] input = buffer;
+        final int length = count;
+        final byte[] dictionary = previous;
+        final int dictionaryLength = Math.min(previousLength, DICTIONARY_SIZE);
+        final int dictionaryOffset = previousLength - dictionaryLength;
+        pending.add(executor.submit(new Callable<Block>() {
+            public Block call() {
+                byte[] compressed = Deflater.deflateBlockImpl(input, 0, length,
+                        dictionary, dictionaryOffset, dictionaryLength,
+                        level, Deflater.DEFAULT_STRATEGY, last);
+                Checksum blockChecksum = null;
+                if (format == FORMAT_GZIP) {
+                    blockChecksum = new CRC32();
+                } else if (format == FORMAT_ZLIB) {
+                    blockChecksum = new Adler32();
+                }
+                long value = 0;
+                if (blockChecksum != null) {
+                    blockChecksum.update(input, 0, length);
+                    value = blockChecksum.getValue();
+                }
+                return new Block(compressed, value, length);
+            }
+        }));
+        previous = input;
+        previousLength = length;
+        if (!last) {
+            buffer = new byte[blockSize];
+        }
+        count = 0;
+
+        while (pending.size() >= maxBlocksInFlight) {
+            writeBlock(pending.remove());
+        }
+    }
+
+    private void writeBlock(Future<Block> future) throws IOException {
+        Block block;
+        try {
+            block = future.get();
+        } catch (InterruptedException e) {
+            throw new InterruptedIOException();
+        } catch (ExecutionException e) {
+            IOException ioException = new IOException("block compression failed");
+            ioException.initCause(e.getCause());
+            throw ioException;
+        }
+        out.write(block.compressed);
+        if (format == FORMAT_GZIP) {
+            checksum = CRC32.combine(checksum, block.checksum, block.length);
+        } else if (format == FORMAT_ZLIB) {
+            checksum = Adler32.combine(checksum, block.checksum, block.length);
+        }
+        totalIn += block.length;
+    }
+
+    private void writeHeader() throws IOException {
+        if (format == FORMAT_GZIP) {
+            out.write(GZIPInputStream.GZIP_MAGIC & 0xff);
+            out.write((GZIPInputStream.GZIP_MAGIC >> 8) & 0xff);
+            out.write(Deflater.DEFLATED);
+            out.write(0); // flags
+            writeIntLittleEndian(0); // mod time
+            out.write(0); // extra flags
+            out.write(0); // operating system
+        } else if (format == FORMAT_ZLIB) {
+            // CMF is deflate with a 32 KiB window; FLG carries the level and a check value.
+            int effectiveLevel = (level == Deflater.DEFAULT_COMPRESSION) ? 6 : level;
+            int levelFlags;
+            if (effectiveLevel < 2) {
+                levelFlags = 0;
+            } else if (effectiveLevel < 6) {
+                levelFlags = 1;
+            } else if (effectiveLevel == 6) {
+                levelFlags = 2;
+            } else {
+                levelFlags = 3;
+            }
+            int header = (0x78 << 8) | (levelFlags << 6);
+            header += 31 - (header % 31);
+            out.write(header >> 8);
+            out.write(header & 0xff);
+        }
+    }
+
+    private void writeTrailer() throws IOException {
+        if (format == FORMAT_GZIP) {
+            writeIntLittleEndian((int) checksum);
+            writeIntLittleEndian((int) totalIn);
+        } else if (format == FORMAT_ZLIB) {
+            int adler = (int) checksum;
+            out.write(adler >>> 24);
+            out.write((adler >>> 16) & 0xff);
+            out.write((adler >>> 8) & 0xff);
+            out.write(adler & 0xff);
+        }
+    }
+
+    private void writeIntLittleEndian(int i) throws IOException {
+        out.write(i & 0xff);
+        out.write((i >> 8) & 0xff);
+        out.write((i >> 16) & 0xff);
+        out.write((i >>> 24) & 0xff);
+    }
+}
@@ -17,11 +17,16 @@
 package libcore.icu;
 
 import java.util.Locale;
+import libcore.util.NativeSubsystems;
 
 /**
  * Makes ICU data accessible to Java.
  */
 public final class ICU {
+    static {
+        NativeSubsystems.ensureRegistered(NativeSubsystems.ICU);
+    }
+
     /**
      * Cache for ISO language names.
      */
@@ -128,6 +133,35 @@ public final class ICU {
     public static native String toLowerCase(String s, String localeName);
     public static native String toUpperCase(String s, String localeName);
 
+    // --- Character classification.
+
+    /**
+     * Sets {@code types[i]} to the {@link Character#getType} value of
+     * {@code chars[offset + i]}, for {@code i} in {@code [0, length)}. This is one native call
+     * for the whole range. Both chars of a surrogate pair get the type of the code point they
+     * encode; a surrogate whose partner is outside the range is {@code Character.SURROGATE}.
+     */
+    public static void getCharacterTypes(char[] chars, int offset, int length, byte[] types) {
+        checkCharacterTypesBounds(chars.length, offset, length, types);
+        getCharacterTypesNative(chars, offset, length, types);
+    }
+
+    /**
+     * Like {@link #getCharacterTypes(char[], int, int, byte[])}, for the chars of {@code s}.
+     */
+    public static void getCharacterTypes(String s, int offset, int length, byte[] types) {
+        checkCharacterTypesBounds(s.length(), offset, length, types);
+        getStringCharacterTypesNative(s, offset, length, types);
+    }
+
+    private static void checkCharacterTypesBounds(int charCount, int offset, int length,
+            byte[] types) {
+        if ((offset | length) < 0 || offset > charCount - length || length > types.length) {
+            throw new IndexOutOfBoundsException("offset=" + offset + " length=" + length +
+                    " charCount=" + charCount + " types.length=" + types.length);
+        }
+    }
+
     // --- Native methods accessing ICU's database.
 
     private static native String[] getAvailableBreakIteratorLocalesNative();
@@ -137,6 +171,11 @@ public final class ICU {
     private static native String[] getAvailableLocalesNative();
     private static native String[] getAvailableNumberFormatLocalesNative();
 
+    private static native void getCharacterTypesNative(char[] chars, int offset, int length,
+            byte[] types);
+    private static native void getStringCharacterTypesNative(String s, int offset, int length,
+            byte[] types);
+
     public static native String getCurrencyCodeNative(String locale);
     public static native int getCurrencyFractionDigitsNative(String currencyCode);
     public static native String getCurrencySymbolNative(String locale, String currencyCode);
@@ -151,5 +190,5 @@ public final class ICU {
     private static native String[] getISOLanguagesNative();
     private static native String[] getISOCountriesNative();
 
-    static native boolean initLocaleDataImpl(String locale, LocaleData result);
+    static native boolean initLocaleDataImpl(String locale, int sections, LocaleData result);
 }
@@ -24,70 +24,93 @@ import java.util.Locale;
 /**
  * Passes locale-specific from ICU native code to Java.
  * <p>
- * Note that you share these; you must not alter any of the fields, nor their array elements
- * in the case of arrays. If you ever expose any of these things to user code, you must give
- * them a clone rather than the original.
+ * Note that you share these; you must not alter any of the arrays they return. If you ever
+ * expose any of these things to user code, you must give them a clone rather than the original.
+ * <p>
+ * Each part of the data is read from ICU the first time one of its getters is called, so a
+ * DateFormat doesn't pay for the locale's number symbols, and vice versa.
  */
 public final class LocaleData {
     // A cache for the locale-specific data.
     private static final HashMap<String, LocaleData> localeDataCache = new HashMap<String, LocaleData>();
 
     // Used by Calendar.
-    public Integer firstDayOfWeek;
-    public Integer minimalDaysInFirstWeek;
+    private Integer firstDayOfWeek;
+    private Integer minimalDaysInFirstWeek;
 
     // Used by DateFormatSymbols.
-    public String[] amPm;
-    public String[] eras;
+    private String[] amPm;
+    private String[] eras;
 
-    public String[] longMonthNames;
-    public String[] shortMonthNames;
-    public String[] longStandAloneMonthNames;
-    public String[] shortStandAloneMonthNames;
+    private String[] longMonthNames;
+    private String[] shortMonthNames;
+    private String[] longStandAloneMonthNames;
+    private String[] shortStandAloneMonthNames;
 
-    public String[] longWeekdayNames;
-    public String[] shortWeekdayNames;
-    public String[] longStandAloneWeekdayNames;
-    public String[] shortStandAloneWeekdayNames;
+    private String[] longWeekdayNames;
+    private String[] shortWeekdayNames;
+    private String[] longStandAloneWeekdayNames;
+    private String[] shortStandAloneWeekdayNames;
 
-    public String fullTimeFormat;
-    public String longTimeFormat;
-    public String mediumTimeFormat;
-    public String shortTimeFormat;
+    private String fullTimeFormat;
+    private String longTimeFormat;
+    private String mediumTimeFormat;
+    private String shortTimeFormat;
 
-    public String fullDateFormat;
-    public String longDateFormat;
-    public String mediumDateFormat;
-    public String shortDateFormat;
+    private String fullDateFormat;
+    private String longDateFormat;
+    private String mediumDateFormat;
+    private String shortDateFormat;
 
     // Used by DecimalFormatSymbols.
-    public char zeroDigit;
-    public char digit;
-    public char decimalSeparator;
-    public char groupingSeparator;
-    public char patternSeparator;
-    public char percent;
-    public char perMill;
-    public char monetarySeparator;
-    public char minusSign;
-    public String exponentSeparator;
-    public String infinity;
-    public String NaN;
+    private char zeroDigit;
+    private char digit;
+    private char decimalSeparator;
+    private char groupingSeparator;
+    private char patternSeparator;
+    private char percent;
+    private char perMill;
+    private char monetarySeparator;
+    private char minusSign;
+    private String exponentSeparator;
+    private String infinity;
+    private String NaN;
     // Also used by Currency.
-    public String currencySymbol;
-    public String internationalCurrencySymbol;
+    private String currencySymbol;
+    private String internationalCurrencySymbol;
 
     // Used by DecimalFormat and NumberFormat.
-    public String numberPattern;
-    public String integerPattern;
-    public String currencyPattern;
-    public String percentPattern;
+    private String numberPattern;
+    private String integerPattern;
+    private String currencyPattern;
+    private String percentPattern;
+
+    // The parts of the data that are loaded together, the first time any of their fields is
+    // asked for. These must be kept in sync with the LocaleDataSection enum in ICU.cpp.
+    private static final int SECTION_CALENDAR = 1;
+    private static final int SECTION_DATE_FORMAT_SYMBOLS = 2;
+    private static final int SECTION_DATE_TIME_PATTERNS = 4;
+    private static final int SECTION_NUMBER_SYMBOLS = 8;
+    private static final int SECTION_CURRENCY = 16;
+    private static final int SECTION_NUMBER_PATTERNS = 32;
+
+    private final Locale locale;
 
-    private LocaleData() {
+    // The data for the next-most-specific locale, which ours overrides. Null for the root locale.
+    private final LocaleData parent;
+
+    // The sections loaded so far. A field may only be read once its section's bit is set.
+    private volatile int loadedSections;
+
+    private LocaleData(Locale locale, LocaleData parent) {
+        this.locale = locale;
+        this.parent = parent;
     }
 
     /**
-     * Returns a shared LocaleData for the given locale.
+     * Returns a shared LocaleData for the given locale. Nothing is read from
+     * ICU until it's needed, and then only the part of the locale's data
+     * that was asked for.
      */
     public static LocaleData get(Locale locale) {
         if (locale == null) {
@@ -115,180 +138,403 @@ public final class LocaleData {
         String language = locale.getLanguage();
         String country = locale.getCountry();
         String variant = locale.getVariant();
-        // Start with data from the parent (next-most-specific) locale...
-        LocaleData result = new LocaleData();
+        LocaleData parent = null;
         if (!variant.isEmpty()) {
-            result.overrideWithDataFrom(get(new Locale(language, country, "")));
+            parent = get(new Locale(language, country, ""));
         } else if (!country.isEmpty()) {
-            result.overrideWithDataFrom(get(new Locale(language, "", "")));
+            parent = get(new Locale(language, "", ""));
         } else if (!language.isEmpty()) {
-            result.overrideWithDataFrom(get(Locale.ROOT));
+            parent = get(Locale.ROOT);
         }
-        // Override with data from this locale.
-        result.overrideWithDataFrom(initLocaleData(locale));
-        return result;
+        return new LocaleData(locale, parent);
     }
 
-    @Override public String toString() {
-        return "LocaleData[" +
-                "firstDayOfWeek=" + firstDayOfWeek + "," +
-                "minimalDaysInFirstWeek=" + minimalDaysInFirstWeek + "," +
-                "amPm=" + Arrays.toString(amPm) + "," +
-                "eras=" + Arrays.toString(eras) + "," +
-                "longMonthNames=" + Arrays.toString(longMonthNames) + "," +
-                "shortMonthNames=" + Arrays.toString(shortMonthNames) + "," +
-                "longStandAloneMonthNames=" + Arrays.toString(longStandAloneMonthNames) + "," +
-                "shortStandAloneMonthNames=" + Arrays.toString(shortStandAloneMonthNames) + "," +
-                "longWeekdayNames=" + Arrays.toString(longWeekdayNames) + "," +
-                "shortWeekdayNames=" + Arrays.toString(shortWeekdayNames) + "," +
-                "longStandAloneWeekdayNames=" + Arrays.toString(longStandAloneWeekdayNames) + "," +
-                "shortStandAloneWeekdayNames=" + Arrays.toString(shortStandAloneWeekdayNames) + "," +
-                "fullTimeFormat=" + fullTimeFormat + "," +
-                "longTimeFormat=" + longTimeFormat + "," +
-                "mediumTimeFormat=" + mediumTimeFormat + "," +
-                "shortTimeFormat=" + shortTimeFormat + "," +
-                "fullDateFormat=" + fullDateFormat + "," +
-                "longDateFormat=" + longDateFormat + "," +
-                "mediumDateFormat=" + mediumDateFormat + "," +
-                "shortDateFormat=" + shortDateFormat + "," +
-                "zeroDigit=" + zeroDigit + "," +
-                "digit=" + digit + "," +
-                "decimalSeparator=" + decimalSeparator + "," +
-                "groupingSeparator=" + groupingSeparator + "," +
-                "patternSeparator=" + patternSeparator + "," +
-                "percent=" + percent + "," +
-                "perMill=" + perMill + "," +
-                "monetarySeparator=" + monetarySeparator + "," +
-                "minusSign=" + minusSign + "," +
-                "exponentSeparator=" + exponentSeparator + "," +
-                "infinity=" + infinity + "," +
-                "NaN=" + NaN + "," +
-                "currencySymbol=" + currencySymbol + "," +
-                "internationalCurrencySymbol=" + internationalCurrencySymbol + "," +
-                "numberPattern=" + numberPattern + "," +
-                "integerPattern=" + integerPattern + "," +
-                "currencyPattern=" + currencyPattern + "," +
-                "percentPattern=" + percentPattern + "]";
-    }
-
-    private void overrideWithDataFrom(LocaleData overrides) {
-        if (overrides.firstDayOfWeek != null) {
-            firstDayOfWeek = overrides.firstDayOfWeek;
-        }
-        if (overrides.minimalDaysInFirstWeek != null) {
-            minimalDaysInFirstWeek = overrides.minimalDaysInFirstWeek;
-        }
-        if (overrides.amPm != null) {
-            amPm = overrides.amPm;
-        }
-        if (overrides.eras != null) {
-            eras = overrides.eras;
-        }
-        if (overrides.longMonthNames != null) {
-            longMonthNames = overrides.longMonthNames;
-        }
-        if (overrides.shortMonthNames != null) {
-            shortMonthNames = overrides.shortMonthNames;
-        }
-        if (overrides.longStandAloneMonthNames != null) {
-            longStandAloneMonthNames = overrides.longStandAloneMonthNames;
-        }
-        if (overrides.shortStandAloneMonthNames != null) {
-            shortStandAloneMonthNames = overrides.shortStandAloneMonthNames;
-        }
-        if (overrides.longWeekdayNames != null) {
-            longWeekdayNames = overrides.longWeekdayNames;
-        }
-        if (overrides.shortWeekdayNames != null) {
-            shortWeekdayNames = overrides.shortWeekdayNames;
-        }
-        if (overrides.longStandAloneWeekdayNames != null) {
-            longStandAloneWeekdayNames = overrides.longStandAloneWeekdayNames;
-        }
-        if (overrides.shortStandAloneWeekdayNames != null) {
-            shortStandAloneWeekdayNames = overrides.shortStandAloneWeekdayNames;
-        }
-        if (overrides.fullTimeFormat != null) {
-            fullTimeFormat = overrides.fullTimeFormat;
+    private void ensureLoaded(int section) {
+        if ((loadedSections & section) == 0) {
+            load(section);
         }
-        if (overrides.longTimeFormat != null) {
-            longTimeFormat = overrides.longTimeFormat;
-        }
-        if (overrides.mediumTimeFormat != null) {
-            mediumTimeFormat = overrides.mediumTimeFormat;
-        }
-        if (overrides.shortTimeFormat != null) {
-            shortTimeFormat = overrides.shortTimeFormat;
-        }
-        if (overrides.fullDateFormat != null) {
-            fullDateFormat = overrides.fullDateFormat;
-        }
-        if (overrides.longDateFormat != null) {
-            longDateFormat = overrides.longDateFormat;
-        }
-        if (overrides.mediumDateFormat != null) {
-            mediumDateFormat = overrides.mediumDateFormat;
-        }
-        if (overrides.shortDateFormat != null) {
-            shortDateFormat = overrides.shortDateFormat;
-        }
-        if (overrides.zeroDigit != '\0') {
-            zeroDigit = overrides.zeroDigit;
-        }
-        if (overrides.digit != '\0') {
-            digit = overrides.digit;
-        }
-        if (overrides.decimalSeparator != '\0') {
-            decimalSeparator = overrides.decimalSeparator;
-        }
-        if (overrides.groupingSeparator != '\0') {
-            groupingSeparator = overrides.groupingSeparator;
-        }
-        if (overrides.patternSeparator != '\0') {
-            patternSeparator = overrides.patternSeparator;
-        }
-        if (overrides.percent != '\0') {
-            percent = overrides.percent;
-        }
-        if (overrides.perMill != '\0') {
-            perMill = overrides.perMill;
-        }
-        if (overrides.monetarySeparator != '\0') {
-            monetarySeparator = overrides.monetarySeparator;
-        }
-        if (overrides.minusSign != '\0') {
-            minusSign = overrides.minusSign;
-        }
-        if (overrides.exponentSeparator != null) {
-            exponentSeparator = overrides.exponentSeparator;
-        }
-        if (overrides.NaN != null) {
-            NaN = overrides.NaN;
+    }
+
+    private synchronized void load(int section) {
+        if ((loadedSections & section) != 0) {
+            return;
         }
-        if (overrides.infinity != null) {
-            infinity = overrides.infinity;
+        // Start with data from the parent (next-most-specific) locale...
+        if (parent != null) {
+            parent.ensureLoaded(section);
+            overrideWithDataFrom(parent, section);
         }
-        if (overrides.currencySymbol != null) {
-            currencySymbol = overrides.currencySymbol;
+        // Override with data from this locale.
+        overrideWithDataFrom(initLocaleData(locale, section), section);
+        loadedSections |= section;
+    }
+
+    @Override public String toString() {
+        return "LocaleData[" +
+                "firstDayOfWeek=" + getFirstDayOfWeek() + "," +
+                "minimalDaysInFirstWeek=" + getMinimalDaysInFirstWeek() + "," +
+                "amPm=" + Arrays.toString(getAmPm()) + "," +
+                "eras=" + Arrays.toString(getEras()) + "," +
+                "longMonthNames=" + Arrays.toString(getLongMonthNames()) + "," +
+                "shortMonthNames=" + Arrays.toString(getShortMonthNames()) + "," +
+                "longStandAloneMonthNames=" + Arrays.toString(getLongStandAloneMonthNames()) + "," +
+                "shortStandAloneMonthNames=" +
+                        Arrays.toString(getShortStandAloneMonthNames()) + "," +
+                "longWeekdayNames=" + Arrays.toString(getLongWeekdayNames()) + "," +
+                "shortWeekdayNames=" + Arrays.toString(getShortWeekdayNames()) + "," +
+                "longStandAloneWeekdayNames=" +
+                        Arrays.toString(getLongStandAloneWeekdayNames()) + "," +
+                "shortStandAloneWeekdayNames=" +
+                        Arrays.toString(getShortStandAloneWeekdayNames()) + "," +
+                "fullTimeFormat=" + getFullTimeFormat() + "," +
+                "longTimeFormat=" + getLongTimeFormat() + "," +
+                "mediumTimeFormat=" + getMediumTimeFormat() + "," +
+                "shortTimeFormat=" + getShortTimeFormat() + "," +
+                "fullDateFormat=" + getFullDateFormat() + "," +
+                "longDateFormat=" + getLongDateFormat() + "," +
+                "mediumDateFormat=" + getMediumDateFormat() + "," +
+                "shortDateFormat=" + getShortDateFormat() + "," +
+                "zeroDigit=" + getZeroDigit() + "," +
+                "digit=" + getDigit() + "," +
+                "decimalSeparator=" + getDecimalSeparator() + "," +
+                "groupingSeparator=" + getGroupingSeparator() + "," +
+                "patternSeparator=" + getPatternSeparator() + "," +
+                "percent=" + getPercent() + "," +
+                "perMill=" + getPerMill() + "," +
+                "monetarySeparator=" + getMonetarySeparator() + "," +
+                "minusSign=" + getMinusSign() + "," +
+                "exponentSeparator=" + getExponentSeparator() + "," +
+                "infinity=" + getInfinity() + "," +
+                "NaN=" + getNaN() + "," +
+                "currencySymbol=" + getCurrencySymbol() + "," +
+                "internationalCurrencySymbol=" + getInternationalCurrencySymbol() + "," +
+                "numberPattern=" + getNumberPattern() + "," +
+                "integerPattern=" + getIntegerPattern() + "," +
+                "currencyPattern=" + getCurrencyPattern() + "," +
+                "percentPattern=" + getPercentPattern() + "]";
+    }
+
+    private void overrideWithDataFrom(LocaleData overrides, int sections) {
+        if ((sections & SECTION_CALENDAR) != 0) {
+            if (overrides.firstDayOfWeek != null) {
+                firstDayOfWeek = overrides.firstDayOfWeek;
+            }
+            if (overrides.minimalDaysInFirstWeek != null) {
+                minimalDaysInFirstWeek = overrides.minimalDaysInFirstWeek;
+            }
         }
-        if (overrides.internationalCurrencySymbol != null) {
-            internationalCurrencySymbol = overrides.internationalCurrencySymbol;
+        if ((sections & SECTION_DATE_FORMAT_SYMBOLS) != 0) {
+            if (overrides.amPm != null) {
+                amPm = overrides.amPm;
+            }
+            if (overrides.eras != null) {
+                eras = overrides.eras;
+            }
+            if (overrides.longMonthNames != null) {
+                longMonthNames = overrides.longMonthNames;
+            }
+            if (overrides.shortMonthNames != null) {
+                shortMonthNames = overrides.shortMonthNames;
+            }
+            if (overrides.longStandAloneMonthNames != null) {
+                longStandAloneMonthNames = overrides.longStandAloneMonthNames;
+            }
+            if (overrides.shortStandAloneMonthNames != null) {
+                shortStandAloneMonthNames = overrides.shortStandAloneMonthNames;
+            }
+            if (overrides.longWeekdayNames != null) {
+                longWeekdayNames = overrides.longWeekdayNames;
+            }
+            if (overrides.shortWeekdayNames != null) {
+                shortWeekdayNames = overrides.shortWeekdayNames;
+            }
+            if (overrides.longStandAloneWeekdayNames != null) {
+                longStandAloneWeekdayNames = overrides.longStandAloneWeekdayNames;
+            }
+            if (overrides.shortStandAloneWeekdayNames != null) {
+                shortStandAloneWeekdayNames = overrides.shortStandAloneWeekdayNames;
+            }
         }
-        if (overrides.numberPattern != null) {
-            numberPattern = overrides.numberPattern;
+        if ((sections & SECTION_DATE_TIME_PATTERNS) != 0) {
+            if (overrides.fullTimeFormat != null) {
+                fullTimeFormat = overrides.fullTimeFormat;
+            }
+            if (overrides.longTimeFormat != null) {
+                longTimeFormat = overrides.longTimeFormat;
+            }
+            if (overrides.mediumTimeFormat != null) {
+                mediumTimeFormat = overrides.mediumTimeFormat;
+            }
+            if (overrides.shortTimeFormat != null) {
+                shortTimeFormat = overrides.shortTimeFormat;
+            }
+            if (overrides.fullDateFormat != null) {
+                fullDateFormat = overrides.fullDateFormat;
+            }
+            if (overrides.longDateFormat != null) {
+                longDateFormat = overrides.longDateFormat;
+            }
+            if (overrides.mediumDateFormat != null) {
+                mediumDateFormat = overrides.mediumDateFormat;
+            }
+            if (overrides.shortDateFormat != null) {
+                shortDateFormat = overrides.shortDateFormat;
+            }
         }
-        if (overrides.integerPattern != null) {
-            integerPattern = overrides.integerPattern;
+        if ((sections & SECTION_NUMBER_SYMBOLS) != 0) {
+            if (overrides.zeroDigit != '\0') {
+                zeroDigit = overrides.zeroDigit;
+            }
+            if (overrides.digit != '\0') {
+                digit = overrides.digit;
+            }
+            if (overrides.decimalSeparator != '\0') {
+                decimalSeparator = overrides.decimalSeparator;
+            }
+            if (overrides.groupingSeparator != '\0') {
+                groupingSeparator = overrides.groupingSeparator;
+            }
+            if (overrides.patternSeparator != '\0') {
+                patternSeparator = overrides.patternSeparator;
+            }
+            if (overrides.percent != '\0') {
+                percent = overrides.percent;
+            }
+            if (overrides.perMill != '\0') {
+                perMill = overrides.perMill;
+            }
+            if (overrides.monetarySeparator != '\0') {
+                monetarySeparator = overrides.monetarySeparator;
+            }
+            if (overrides.minusSign != '\0') {
+                minusSign = overrides.minusSign;
+            }
+            if (overrides.exponentSeparator != null) {
+                exponentSeparator = overrides.exponentSeparator;
+            }
+            if (overrides.infinity != null) {
+                infinity = overrides.infinity;
+            }
+            if (overrides.NaN != null) {
+                NaN = overrides.NaN;
+            }
         }
-        if (overrides.currencyPattern != null) {
-            currencyPattern = overrides.currencyPattern;
+        if ((sections & SECTION_CURRENCY) != 0) {
+            if (overrides.currencySymbol != null) {
+                currencySymbol = overrides.currencySymbol;
+            }
+            if (overrides.internationalCurrencySymbol != null) {
+                internationalCurrencySymbol = overrides.internationalCurrencySymbol;
+            }
         }
-        if (overrides.percentPattern != null) {
-            percentPattern = overrides.percentPattern;
+        if ((sections & SECTION_NUMBER_PATTERNS) != 0) {
+            if (overrides.numberPattern != null) {
+                numberPattern = overrides.numberPattern;
+            }
+            if (overrides.integerPattern != null) {
+                integerPattern = overrides.integerPattern;
+            }
+            if (overrides.currencyPattern != null) {
+                currencyPattern = overrides.currencyPattern;
+            }
+            if (overrides.percentPattern != null) {
+                percentPattern = overrides.percentPattern;
+            }
         }
     }
 
+    public Integer getFirstDayOfWeek() {
+        ensureLoaded(SECTION_CALENDAR);
+        return firstDayOfWeek;
+    }
+
+    public Integer getMinimalDaysInFirstWeek() {
+        ensureLoaded(SECTION_CALENDAR);
+        return minimalDaysInFirstWeek;
+    }
+
+    public String[] getAmPm() {
+        ensureLoaded(SECTION_DATE_FORMAT_SYMBOLS);
+        return amPm;
+    }
+
+    public String[] getEras() {
+        ensureLoaded(SECTION_DATE_FORMAT_SYMBOLS);
+        return eras;
+    }
+
+    public String[] getLongMonthNames() {
+        ensureLoaded(SECTION_DATE_FORMAT_SYMBOLS);
+        return longMonthNames;
+    }
+
+    public String[] getShortMonthNames() {
+        ensureLoaded(SECTION_DATE_FORMAT_SYMBOLS);
+        return shortMonthNames;
+    }
+
+    public String[] getLongStandAloneMonthNames() {
+        ensureLoaded(SECTION_DATE_FORMAT_SYMBOLS);
+        return longStandAloneMonthNames;
+    }
+
+    public String[] getShortStandAloneMonthNames() {
+        ensureLoaded(SECTION_DATE_FORMAT_SYMBOLS);
+        return shortStandAloneMonthNames;
+    }
+
+    public String[] getLongWeekdayNames() {
+        ensureLoaded(SECTION_DATE_FORMAT_SYMBOLS);
+        return longWeekdayNames;
+    }
+
+    public String[] getShortWeekdayNames() {
+        ensureLoaded(SECTION_DATE_FORMAT_SYMBOLS);
+        return shortWeekdayNames;
+    }
+
+    public String[] getLongStandAloneWeekdayNames() {
+        ensureLoaded(SECTION_DATE_FORMAT_SYMBOLS);
+        return longStandAloneWeekdayNames;
+    }
+
+    public String[] getShortStandAloneWeekdayNames() {
+        ensureLoaded(SECTION_DATE_FORMAT_SYMBOLS);
+        return shortStandAloneWeekdayNames;
+    }
+
+    public String getFullTimeFormat() {
+        ensureLoaded(SECTION_DATE_TIME_PATTERNS);
+        return fullTimeFormat;
+    }
+
+    public String getLongTimeFormat() {
+        ensureLoaded(SECTION_DATE_TIME_PATTERNS);
+        return longTimeFormat;
+    }
+
+    public String getMediumTimeFormat() {
+        ensureLoaded(SECTION_DATE_TIME_PATTERNS);
+        return mediumTimeFormat;
+    }
+
+    public String getShortTimeFormat() {
+        ensureLoaded(SECTION_DATE_TIME_PATTERNS);
+        return shortTimeFormat;
+    }
+
+    public String getFullDateFormat() {
+        ensureLoaded(SECTION_DATE_TIME_PATTERNS);
+        return fullDateFormat;
+    }
+
+    public String getLongDateFormat() {
+        ensureLoaded(SECTION_DATE_TIME_PATTERNS);
+        return longDateFormat;
+    }
+
+    public String getMediumDateFormat() {
+        ensureLoaded(SECTION_DATE_TIME_PATTERNS);
+        return mediumDateFormat;
+    }
+
+    public String getShortDateFormat() {
+        ensureLoaded(SECTION_DATE_TIME_PATTERNS);
+        return shortDateFormat;
+    }
+
+    public char getZeroDigit() {
+        ensureLoaded(SECTION_NUMBER_SYMBOLS);
+        return zeroDigit;
+    }
+
+    public char getDigit() {
+        ensureLoaded(SECTION_NUMBER_SYMBOLS);
+        return digit;
+    }
+
+    public char getDecimalSeparator() {
+        ensureLoaded(SECTION_NUMBER_SYMBOLS);
+        return decimalSeparator;
+    }
+
+    public char getGroupingSeparator() {
+        ensureLoaded(SECTION_NUMBER_SYMBOLS);
+        return groupingSeparator;
+    }
+
+    public char getPatternSeparator() {
+        ensureLoaded(SECTION_NUMBER_SYMBOLS);
+        return patternSeparator;
+    }
+
+    public char getPercent() {
+        ensureLoaded(SECTION_NUMBER_SYMBOLS);
+        return percent;
+    }
+
+    public char getPerMill() {
+        ensureLoaded(SECTION_NUMBER_SYMBOLS);
+        return perMill;
+    }
+
+    public char getMonetarySeparator() {
+        ensureLoaded(SECTION_NUMBER_SYMBOLS);
+        return monetarySeparator;
+    }
+
+    public char getMinusSign() {
+        ensureLoaded(SECTION_NUMBER_SYMBOLS);
+        return minusSign;
+    }
+
+    public String getExponentSeparator() {
+        ensureLoaded(SECTION_NUMBER_SYMBOLS);
+        return exponentSeparator;
+    }
+
+    public String getInfinity() {
+        ensureLoaded(SECTION_NUMBER_SYMBOLS);
+        return infinity;
+    }
+
+    public String getNaN() {
+        ensureLoaded(SECTION_NUMBER_SYMBOLS);
+        return NaN;
+    }
+
+    public String getCurrencySymbol() {
+        ensureLoaded(SECTION_CURRENCY);
+        return currencySymbol;
+    }
+
+    public String getInternationalCurrencySymbol() {
+        ensureLoaded(SECTION_CURRENCY);
+        return internationalCurrencySymbol;
+    }
+
+    public String getNumberPattern() {
+        ensureLoaded(SECTION_NUMBER_PATTERNS);
+        return numberPattern;
+    }
+
+    public String getIntegerPattern() {
+        ensureLoaded(SECTION_NUMBER_PATTERNS);
+        return integerPattern;
+    }
+
+    public String getCurrencyPattern() {
+        ensureLoaded(SECTION_NUMBER_PATTERNS);
+        return currencyPattern;
+    }
+
+    public String getPercentPattern() {
+        ensureLoaded(SECTION_NUMBER_PATTERNS);
+        return percentPattern;
+    }
+
     public String getDateFormat(int style) {
+        ensureLoaded(SECTION_DATE_TIME_PATTERNS);
         switch (style) {
         case DateFormat.SHORT:
             return shortDateFormat;
@@ -303,6 +549,7 @@ public final class LocaleData {
     }
 
     public String getTimeFormat(int style) {
+        ensureLoaded(SECTION_DATE_TIME_PATTERNS);
         switch (style) {
         case DateFormat.SHORT:
             return shortTimeFormat;
@@ -316,9 +563,9 @@ public final class LocaleData {
         throw new AssertionError();
     }
 
-    private static LocaleData initLocaleData(Locale locale) {
-        LocaleData localeData = new LocaleData();
-        if (!ICU.initLocaleDataImpl(locale.toString(), localeData)) {
+    private static LocaleData initLocaleData(Locale locale, int sections) {
+        LocaleData localeData = new LocaleData(locale, null);
+        if (!ICU.initLocaleDataImpl(locale.toString(), sections, localeData)) {
             throw new AssertionError("couldn't initialize LocaleData for locale " + locale);
         }
         if (localeData.fullTimeFormat != null) {
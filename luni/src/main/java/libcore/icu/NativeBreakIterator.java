@@ -19,8 +19,13 @@ package libcore.icu;
 import java.text.CharacterIterator;
 import java.text.StringCharacterIterator;
 import java.util.Locale;
+import libcore.util.NativeSubsystems;
 
 public final class NativeBreakIterator implements Cloneable {
+    static {
+        NativeSubsystems.ensureRegistered(NativeSubsystems.ICU);
+    }
+
     // Acceptable values for the 'type' field.
     private static final int BI_CHAR_INSTANCE = 1;
     private static final int BI_WORD_INSTANCE = 2;
@@ -119,6 +124,17 @@ public final class NativeBreakIterator implements Cloneable {
         setText(new StringCharacterIterator(newText));
     }
 
+    /**
+     * Returns every boundary in the text, first to last, each followed by
+     * the status of the rule that produced it: {@code [offset0, status0,
+     * offset1, status1, ...]}. Tokenizing a whole text this way takes one call
+     * into ICU rather than one per boundary. The current position is left
+     * unchanged.
+     */
+    public int[] getBoundaries() {
+        return getBoundariesImpl(this.addr);
+    }
+
     public boolean isBoundary(int offset) {
         return isBoundaryImpl(this.addr, offset);
     }
@@ -157,5 +173,6 @@ public final class NativeBreakIterator implements Cloneable {
     private static native int currentImpl(int addr);
     private static native int firstImpl(int addr);
     private static native int followingImpl(int addr, int offset);
+    private static native int[] getBoundariesImpl(int addr);
     private static native int lastImpl(int addr);
 }
@@ -10,12 +10,18 @@
 
 package libcore.icu;
 
+import libcore.util.NativeSubsystems;
+
 /**
 * Package static class for declaring all native methods for collation use.
 * @author syn wee quek
 * @internal ICU 2.4
 */
 public final class NativeCollation {
+    static {
+        NativeSubsystems.ensureRegistered(NativeSubsystems.ICU);
+    }
+
     private NativeCollation() {
     }
 
@@ -26,10 +32,12 @@ public final class NativeCollation {
     public static native int getCollationElementIterator(int address, String source);
     public static native String getRules(int address);
     public static native byte[] getSortKey(int address, String source);
+    public static native byte[] getSortKeys(int address, String[] sources, int[] offsets);
     public static native int openCollator(String locale);
     public static native int openCollatorFromRules(String rules, int normalizationMode, int collationStrength);
     public static native int safeClone(int address);
     public static native void setAttribute(int address, int type, int value);
+    public static native int[] sort(int address, String[] sources);
 
     // CollationElementIterator.
     public static native void closeElements(int address);
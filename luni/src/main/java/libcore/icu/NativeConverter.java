@@ -13,8 +13,13 @@ import java.nio.charset.Charset;
 import java.nio.charset.CharsetDecoder;
 import java.nio.charset.CharsetEncoder;
 import java.nio.charset.CodingErrorAction;
+import libcore.util.NativeSubsystems;
 
 public final class NativeConverter {
+    static {
+        NativeSubsystems.ensureRegistered(NativeSubsystems.ICU);
+    }
+
     /**
      * Converts an array of bytes containing characters in an external
      * encoding into an array of Unicode characters.  This  method allows
@@ -39,6 +44,13 @@ public final class NativeConverter {
     public static native int decode(long converterHandle, byte[] input, int inEnd,
             char[] output, int outEnd, int[] data, boolean flush);
 
+    /**
+     * Like {@link #decode}, but reading the input in place from native memory,
+     * such as a direct buffer, starting at {@code inputAddress}.
+     */
+    public static native int decodeDirect(long converterHandle, int inputAddress, int inEnd,
+            char[] output, int outEnd, int[] data, boolean flush);
+
     /**
      * Converts an array of Unicode chars to an array of bytes in an external encoding.
      * This  method allows a buffer by buffer conversion of a data stream.  The state of the
@@ -62,6 +74,13 @@ public final class NativeConverter {
     public static native int encode(long converterHandle, char[] input, int inEnd,
             byte[] output, int outEnd, int[] data, boolean flush);
 
+    /**
+     * Like {@link #encode}, but writing the output in place to native memory,
+     * such as a direct buffer, starting at {@code outputAddress}.
+     */
+    public static native int encodeDirect(long converterHandle, char[] input, int inEnd,
+            int outputAddress, int outEnd, int[] data, boolean flush);
+
     /**
      * Writes any remaining output to the output buffer and resets the
      * converter to its initial state.
@@ -29,8 +29,13 @@ import java.text.ParsePosition;
 import java.util.Currency;
 import java.util.NoSuchElementException;
 import libcore.icu.LocaleData;
+import libcore.util.NativeSubsystems;
 
 public final class NativeDecimalFormat {
+    static {
+        NativeSubsystems.ensureRegistered(NativeSubsystems.ICU);
+    }
+
     /**
      * Constants corresponding to the native type UNumberFormatSymbol, for setSymbol.
      */
@@ -119,6 +124,11 @@ public final class NativeDecimalFormat {
      */
     private BigDecimal multiplierBigDecimal = null;
 
+    /**
+     * Scratch space for formatting numbers straight into a StringBuffer.
+     */
+    private char[] formatBuffer = new char[32];
+
     public NativeDecimalFormat(String pattern, DecimalFormatSymbols dfs) {
         try {
             this.addr = open(pattern, dfs.getCurrencySymbol(),
@@ -137,11 +147,12 @@ public final class NativeDecimalFormat {
 
     // Used so java.util.Formatter doesn't need to allocate DecimalFormatSymbols instances.
     public NativeDecimalFormat(String pattern, LocaleData data) {
-        this.addr = open(pattern, data.currencySymbol,
-                data.decimalSeparator, data.digit, data.exponentSeparator, data.groupingSeparator,
-                data.infinity, data.internationalCurrencySymbol, data.minusSign,
-                data.monetarySeparator, data.NaN, data.patternSeparator,
-                data.percent, data.perMill, data.zeroDigit);
+        this.addr = open(pattern, data.getCurrencySymbol(),
+                data.getDecimalSeparator(), data.getDigit(), data.getExponentSeparator(),
+                data.getGroupingSeparator(), data.getInfinity(),
+                data.getInternationalCurrencySymbol(), data.getMinusSign(),
+                data.getMonetarySeparator(), data.getNaN(), data.getPatternSeparator(),
+                data.getPercent(), data.getPerMill(), data.getZeroDigit());
         this.lastPattern = pattern;
     }
 
@@ -222,11 +233,13 @@ public final class NativeDecimalFormat {
     }
 
     public void setDecimalFormatSymbols(final LocaleData localeData) {
-        setDecimalFormatSymbols(this.addr, localeData.currencySymbol, localeData.decimalSeparator,
-                localeData.digit, localeData.exponentSeparator, localeData.groupingSeparator,
-                localeData.infinity, localeData.internationalCurrencySymbol, localeData.minusSign,
-                localeData.monetarySeparator, localeData.NaN, localeData.patternSeparator,
-                localeData.percent, localeData.perMill, localeData.zeroDigit);
+        setDecimalFormatSymbols(this.addr, localeData.getCurrencySymbol(),
+                localeData.getDecimalSeparator(), localeData.getDigit(),
+                localeData.getExponentSeparator(), localeData.getGroupingSeparator(),
+                localeData.getInfinity(), localeData.getInternationalCurrencySymbol(),
+                localeData.getMinusSign(), localeData.getMonetarySeparator(), localeData.getNaN(),
+                localeData.getPatternSeparator(), localeData.getPercent(), localeData.getPerMill(),
+                localeData.getZeroDigit());
     }
 
     public char[] formatBigDecimal(BigDecimal value, FieldPosition field) {
@@ -265,6 +278,58 @@ public final class NativeDecimalFormat {
         return result;
     }
 
+    /**
+     * Formats {@code value} into {@code dst}, without allocating anything.
+     * Returns the length of the result. If that's greater than {@code
+     * dst.length}, {@code dst} is left untouched; call again with a larger
+     * array.
+     */
+    public int formatLong(long value, char[] dst) {
+        return formatLongInto(this.addr, value, dst);
+    }
+
+    /**
+     * Like {@link #formatLong(long, char[])}, but for doubles.
+     */
+    public int formatDouble(double value, char[] dst) {
+        return formatDoubleInto(this.addr, value, dst);
+    }
+
+    /**
+     * Appends {@code value}, formatted, to {@code buffer}. This is cheaper
+     * than {@link #formatLong(long, FieldPosition)} when no field position is
+     * needed.
+     */
+    public void formatLong(long value, StringBuffer buffer) {
+        int length = formatLongInto(this.addr, value, formatBuffer);
+        if (length > formatBuffer.length) {
+            formatBuffer = new char[length];
+            formatLongInto(this.addr, value, formatBuffer);
+        }
+        buffer.append(formatBuffer, 0, length);
+    }
+
+    /**
+     * Like {@link #formatLong(long, StringBuffer)}, but for doubles.
+     */
+    public void formatDouble(double value, StringBuffer buffer) {
+        int length = formatDoubleInto(this.addr, value, formatBuffer);
+        if (length > formatBuffer.length) {
+            formatBuffer = new char[length];
+            formatDoubleInto(this.addr, value, formatBuffer);
+        }
+        buffer.append(formatBuffer, 0, length);
+    }
+
+    /**
+     * Returns true if formatting with {@code field} tracks any field's
+     * position. If not, the StringBuffer methods above will do.
+     */
+    public static boolean needsFieldPosition(FieldPosition field) {
+        // This must agree with FieldPositionIterator.forFieldPosition.
+        return field != null && field.getField() != -1;
+    }
+
     public void applyLocalizedPattern(String pattern) {
         applyPattern(this.addr, true, pattern);
         lastPattern = null;
@@ -621,6 +686,8 @@ public final class NativeDecimalFormat {
     private static native void close(int addr);
     private static native char[] formatLong(int addr, long value, FieldPositionIterator iter);
     private static native char[] formatDouble(int addr, double value, FieldPositionIterator iter);
+    private static native int formatDoubleInto(int addr, double value, char[] dst);
+    private static native int formatLongInto(int addr, long value, char[] dst);
     private static native char[] formatDigitList(int addr, String value, FieldPositionIterator iter);
     private static native int getAttribute(int addr, int symbol);
     private static native String getTextAttribute(int addr, int symbol);
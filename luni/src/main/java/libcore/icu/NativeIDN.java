@@ -16,7 +16,13 @@
 
 package libcore.icu;
 
+import libcore.util.NativeSubsystems;
+
 public final class NativeIDN {
+    static {
+        NativeSubsystems.ensureRegistered(NativeSubsystems.ICU);
+    }
+
     public static String toASCII(String s, int flags) {
         return convert(s, flags, true);
     }
@@ -17,8 +17,13 @@
 package libcore.icu;
 
 import java.text.Normalizer.Form;
+import libcore.util.NativeSubsystems;
 
 public final class NativeNormalizer {
+    static {
+        NativeSubsystems.ensureRegistered(NativeSubsystems.ICU);
+    }
+
     public static boolean isNormalized(CharSequence src, Form form) {
         return isNormalizedImpl(src.toString(), toUNormalizationMode(form));
     }
@@ -27,6 +32,15 @@ public final class NativeNormalizer {
         return normalizeImpl(src.toString(), toUNormalizationMode(form));
     }
 
+    /**
+     * Normalizes each of {@code src} in one call into ICU, for callers with
+     * many strings to normalize at once. Strings that were already
+     * normalized are returned as they are.
+     */
+    public static String[] normalize(String[] src, Form form) {
+        return normalizeAllImpl(src, toUNormalizationMode(form));
+    }
+
     private static int toUNormalizationMode(Form form) {
         // Translates Java enum constants to ICU int constants.
         // See UNormalizationMode in "unicode/unorm.h". Stable API since ICU 2.0.
@@ -41,6 +55,8 @@ public final class NativeNormalizer {
 
     private static native String normalizeImpl(String src, int form);
 
+    private static native String[] normalizeAllImpl(String[] src, int form);
+
     private static native boolean isNormalizedImpl(String src, int form);
 
     private NativeNormalizer() {}
@@ -102,6 +102,38 @@ public final class RuleBasedCollatorICU implements Cloneable {
         return new CollationKeyICU(source, key);
     }
 
+    /**
+     * Returns the collation keys of all of {@code sources}, computed in a
+     * single native call. The keys of null sources are null.
+     */
+    public CollationKey[] getCollationKeys(String[] sources) {
+        int[] offsets = new int[sources.length + 1];
+        byte[] keys = NativeCollation.getSortKeys(address, sources, offsets);
+        CollationKey[] result = new CollationKey[sources.length];
+        for (int i = 0; i < sources.length; ++i) {
+            int length = offsets[i + 1] - offsets[i];
+            if (length > 0) {
+                byte[] key = new byte[length];
+                System.arraycopy(keys, offsets[i], key, 0, length);
+                result[i] = new CollationKeyICU(sources[i], key);
+            }
+        }
+        return result;
+    }
+
+    /**
+     * Returns the indices of {@code sources} in collation order: element
+     * {@code i} of the result is the index of the {@code i}th string. Equal
+     * strings keep their relative order. This sorts by collation key entirely
+     * in native code, which is much faster than sorting with {@link #compare}
+     * for large arrays.
+     *
+     * @throws NullPointerException if any of {@code sources} is null.
+     */
+    public int[] sort(String[] sources) {
+        return NativeCollation.sort(address, sources);
+    }
+
     public String getRules() {
         return NativeCollation.getRules(address);
     }
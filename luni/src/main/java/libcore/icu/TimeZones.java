@@ -20,27 +20,27 @@ import java.util.HashMap;
 import java.util.Locale;
 import java.util.TimeZone;
 import java.util.logging.Logger;
+import libcore.util.NativeSubsystems;
 
 /**
  * Provides access to ICU's time zone data.
  */
 public final class TimeZones {
+    static {
+        NativeSubsystems.ensureRegistered(NativeSubsystems.ICU);
+    }
+
     private static final String[] availableTimeZones = TimeZone.getAvailableIDs();
 
     private TimeZones() {}
 
     /**
-     * Implements TimeZone.getDisplayName by asking ICU.
+     * Implements TimeZone.getDisplayName by asking ICU. The native code
+     * remembers each zone's names once it's worked them out, so this never
+     * costs more than the one zone, and never builds the whole table that
+     * {@link #getZoneStrings} returns.
      */
     public static String getDisplayName(String id, boolean daylight, int style, Locale locale) {
-        // If we already have the strings, linear search through them is 10x quicker than
-        // calling ICU for just the one we want.
-        if (CachedTimeZones.locale.equals(locale)) {
-            String result = lookupDisplayName(CachedTimeZones.names, id, daylight, style);
-            if (result != null) {
-                return result;
-            }
-        }
         return getDisplayNameImpl(id, daylight, style, locale.toString());
     }
 
@@ -77,7 +77,9 @@ public final class TimeZones {
 
     /**
      * Creates array of time zone names for the given locale.
-     * This method takes about 2s to run on a 400MHz ARM11.
+     * This method takes about 2s to run on a 400MHz ARM11 the first time it's
+     * called for a locale. The native code keeps the names, so later calls for
+     * the same locale only cost the copying.
      */
     private static String[][] createZoneStringsFor(Locale locale) {
         long start = System.currentTimeMillis();
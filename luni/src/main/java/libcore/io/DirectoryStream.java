@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.io;
+
+import java.io.Closeable;
+import java.io.IOException;
+
+/**
+ * Reads a directory's entries a batch at a time, reporting each entry's type as
+ * readdir(3) does. Unlike {@link java.io.File#list}, this never holds the whole
+ * directory in memory, and a recursive walk needn't stat each entry to find
+ * subdirectories.
+ *
+ * <p>Entries are reported in the order the file system returns them, and never
+ * include "." or "..".
+ */
+public final class DirectoryStream implements Closeable {
+    /**
+     * The file system didn't say what type the entry is; use stat(2) to find
+     * out. Some file systems always report this.
+     */
+    public static final int DT_UNKNOWN = 0;
+    public static final int DT_FIFO = 1;
+    public static final int DT_CHR = 2;
+    public static final int DT_DIR = 4;
+    public static final int DT_BLK = 6;
+    public static final int DT_REG = 8;
+    public static final int DT_LNK = 10;
+    public static final int DT_SOCK = 12;
+
+    private final String path;
+    private int handle;
+
+    /**
+     * Opens the directory at 'path'.
+     * @throws IOException if 'path' can't be opened as a directory
+     */
+    public DirectoryStream(String path) throws IOException {
+        if (path == null) {
+            throw new NullPointerException("path == null");
+        }
+        this.path = path;
+        this.handle = openImpl(path);
+    }
+
+    /**
+     * Reads up to {@code names.length} entries into 'names', with their
+     * {@code DT_*} types in 'types' and, if 'inodes' isn't null, their inode
+     * numbers in 'inodes'. Returns the number of entries read, which is 0 only
+     * at the end of the directory.
+     */
+    public synchronized int read(String[] names, int[] types, long[] inodes)
+            throws IOException {
+        if (handle == 0) {
+            throw new IOException("DirectoryStream closed: " + path);
+        }
+        if (types.length < names.length || (inodes != null && inodes.length < names.length)) {
+            throw new IllegalArgumentException("names.length=" + names.length +
+                    "; types.length=" + types.length +
+                    "; inodes.length=" + (inodes != null ? inodes.length : -1));
+        }
+        return readImpl(handle, names, types, inodes);
+    }
+
+    public synchronized void close() throws IOException {
+        if (handle != 0) {
+            int oldHandle = handle;
+            handle = 0;
+            closeImpl(oldHandle);
+        }
+    }
+
+    @Override protected void finalize() throws Throwable {
+        try {
+            close();
+        } finally {
+            super.finalize();
+        }
+    }
+
+    private static native int openImpl(String path) throws IOException;
+    private static native int readImpl(int handle, String[] names, int[] types, long[] inodes)
+            throws IOException;
+    private static native void closeImpl(int handle) throws IOException;
+}
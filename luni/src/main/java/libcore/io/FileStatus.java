@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.io;
+
+/**
+ * Fetches everything stat(2) knows about a file in one call, for callers that
+ * would otherwise ask {@link java.io.File} for its length, modification time
+ * and type separately (a stat(2) and a JNI call each).
+ *
+ * <p>Results are written to a {@code long[]} with {@link #FIELD_COUNT} slots per
+ * file, indexed by the {@code ST_*} constants. Use the {@code S_IS*} methods in
+ * {@link OsConstants} to interpret {@code ST_MODE}.
+ */
+public final class FileStatus {
+    /** The file's type and permissions. Never 0 for a file that exists. */
+    public static final int ST_MODE = 0;
+    /** The file's size in bytes, as stat(2) reports it. */
+    public static final int ST_SIZE = 1;
+    /** The number of 512-byte blocks allocated to the file. */
+    public static final int ST_BLOCKS = 2;
+    /** The last access time, in milliseconds since the epoch. */
+    public static final int ST_ATIME = 3;
+    /** The last modification time, in milliseconds since the epoch. */
+    public static final int ST_MTIME = 4;
+    /** The last status change time, in milliseconds since the epoch. */
+    public static final int ST_CTIME = 5;
+    public static final int ST_INO = 6;
+    public static final int ST_DEV = 7;
+
+    public static final int FIELD_COUNT = 8;
+
+    private FileStatus() {
+    }
+
+    /**
+     * Fills {@code out[0]} through {@code out[FIELD_COUNT - 1]} with the status
+     * of 'path'. If 'followLinks' is false, a symbolic link describes itself, as
+     * with lstat(2). Returns false, leaving 'out' zeroed, if the file doesn't
+     * exist or can't be examined.
+     */
+    public static boolean stat(String path, boolean followLinks, long[] out) {
+        if (path == null) {
+            throw new NullPointerException("path == null");
+        }
+        checkLength(out, 1);
+        return statImpl(path, followLinks, out);
+    }
+
+    /**
+     * Fills {@code out} with {@link #FIELD_COUNT} slots for each of 'paths', in
+     * order. Files that don't exist or can't be examined are left zeroed (so
+     * their {@code ST_MODE} is 0). Returns the number of files successfully
+     * examined.
+     */
+    public static int stat(String[] paths, boolean followLinks, long[] out) {
+        checkLength(out, paths.length);
+        return statBatchImpl(paths, followLinks, out);
+    }
+
+    private static void checkLength(long[] out, int fileCount) {
+        if (out.length < fileCount * FIELD_COUNT) {
+            throw new IllegalArgumentException("out.length=" + out.length +
+                    " < " + fileCount + " * " + FIELD_COUNT);
+        }
+    }
+
+    private static native boolean statImpl(String path, boolean followLinks, long[] out);
+    private static native int statBatchImpl(String[] paths, boolean followLinks, long[] out);
+}
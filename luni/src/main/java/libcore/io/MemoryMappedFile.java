@@ -41,14 +41,22 @@ public final class MemoryMappedFile implements Closeable {
     }
 
     public static MemoryMappedFile mmap(FileChannel fc, FileChannel.MapMode mapMode, long start, long size) throws IOException {
-        return mmap(NioUtils.getFd(fc), mapMode, start, size);
+        return mmap(NioUtils.getFd(fc), mapMode, start, size, 0);
     }
 
     public static MemoryMappedFile mmap(FileDescriptor fd, FileChannel.MapMode mapMode, long start, long size) throws IOException {
-        return mmap(IoUtils.getFd(fd), mapMode, start, size);
+        return mmap(IoUtils.getFd(fd), mapMode, start, size, 0);
     }
 
-    private static MemoryMappedFile mmap(int fd, FileChannel.MapMode mapMode, long start, long size) throws IOException {
+    /**
+     * Maps a file as {@link #mmap(FileDescriptor, FileChannel.MapMode, long, long)} does, applying
+     * the given {@code OSMemory.MAP_OPTION_*} flags.
+     */
+    public static MemoryMappedFile mmap(FileDescriptor fd, FileChannel.MapMode mapMode, long start, long size, int options) throws IOException {
+        return mmap(IoUtils.getFd(fd), mapMode, start, size, options);
+    }
+
+    private static MemoryMappedFile mmap(int fd, FileChannel.MapMode mapMode, long start, long size, int options) throws IOException {
         if (start < 0) {
             throw new IllegalArgumentException("start < 0: " + start);
         }
@@ -58,7 +66,7 @@ public final class MemoryMappedFile implements Closeable {
         if ((start + size) > Integer.MAX_VALUE) {
             throw new IllegalArgumentException("(start + size) > Integer.MAX_VALUE");
         }
-        int address = OSMemory.mmap(fd, start, size, mapMode);
+        int address = OSMemory.mmap(fd, start, size, mapMode, options);
         return new MemoryMappedFile(address, (int) size);
     }
 
@@ -77,6 +85,21 @@ public final class MemoryMappedFile implements Closeable {
         }
     }
 
+    /**
+     * Applies one of the {@code OSMemory.MADVICE_*} hints to {@code length} bytes of the mapped
+     * region starting {@code offset} bytes in.
+     */
+    public synchronized void advise(int offset, int length, int advice) throws IOException {
+        if (address == 0) {
+            throw new IOException("MemoryMappedFile closed");
+        }
+        if (offset < 0 || length < 0 || offset > size - length) {
+            throw new IndexOutOfBoundsException("offset=" + offset + " length=" + length +
+                    " size=" + size);
+        }
+        OSMemory.madvise(address + offset, length, advice);
+    }
+
     /**
      * Returns a new iterator that treats the mapped data as big-endian.
      */
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.io;
+
+import java.io.FileDescriptor;
+import java.io.IOException;
+import org.apache.harmony.kernel.vm.LangAccess;
+
+/**
+ * Starts child processes whose exits are reported through file descriptors
+ * rather than the process-reaping thread, so that an event loop can wait for
+ * them alongside its sockets, for example with
+ * {@link org.apache.harmony.luni.platform.INetworkSystem#epollRegister}.
+ *
+ * <p>A supervised process is started in its own process group. It's only
+ * reaped, and its {@link Process#waitFor} only returns, once {@link #reap}
+ * has seen it exit. Callers should call {@code reap} whenever one of their
+ * notification fds is readable:
+ * <ul>
+ *   <li>{@link #openPidFd} gives a pidfd per process, readable once that
+ *       process exits. This needs Linux 5.3 or later.
+ *   <li>Failing that, {@link #openSigChldFd} gives one signalfd that's
+ *       readable when any child exits.
+ * </ul>
+ */
+public final class SupervisedProcesses {
+    private SupervisedProcesses() {
+    }
+
+    /**
+     * Starts a supervised process as {@link ProcessBuilder#start} would.
+     */
+    public static Process start(ProcessBuilder builder) throws IOException {
+        return LangAccess.getInstance().startSupervisedProcess(builder);
+    }
+
+    /**
+     * Returns the pid of {@code process}, as written to {@link #reap}'s
+     * {@code pids}.
+     */
+    public static int getPid(Process process) {
+        return LangAccess.getInstance().getProcessId(process);
+    }
+
+    /**
+     * Returns a new pidfd for {@code process}, which becomes readable when it
+     * exits. The caller must close it.
+     *
+     * @throws IllegalArgumentException if {@code process} isn't a supervised
+     *     process or has already been reaped
+     * @throws IOException if the kernel doesn't support pidfds
+     */
+    public static FileDescriptor openPidFd(Process process) throws IOException {
+        return LangAccess.getInstance().openProcessPidFd(process);
+    }
+
+    /**
+     * Blocks SIGCHLD in the calling thread and returns a new signalfd that's
+     * readable while a SIGCHLD is pending. Each read consumes one 128-byte
+     * {@code struct signalfd_siginfo}. Several exits may be reported by
+     * one signal, so follow each read with {@link #reap}. SIGCHLD is only
+     * reliably queued for the fd if every thread blocks it. The caller must
+     * close the fd.
+     */
+    public static FileDescriptor openSigChldFd() throws IOException {
+        return LangAccess.getInstance().openSigChldFd();
+    }
+
+    /**
+     * Reaps every supervised process that has exited, without blocking. Their
+     * pids and exit values are written to the start of {@code pids} and
+     * {@code statuses}. If more have exited than fit, the rest are left for
+     * the next call.
+     *
+     * @return the number of processes reaped
+     */
+    public static int reap(int[] pids, int[] statuses) {
+        if (pids == null || statuses == null) {
+            throw new NullPointerException();
+        }
+        return LangAccess.getInstance().reapSupervisedProcesses(pids, statuses);
+    }
+}
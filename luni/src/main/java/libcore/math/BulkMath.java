@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.math;
+
+/**
+ * Applies {@link Math} functions to ranges of {@code double[]}s, crossing into native code once
+ * per range rather than once per element.
+ *
+ * <p>Each method sets {@code out[i]} to the result of the corresponding {@code Math} method
+ * applied to {@code in[i]}, for each {@code i} in {@code [offset, offset + length)}. The results
+ * are exactly those the {@code Math} methods return. {@code in} and {@code out} may be the same
+ * array. There are no {@link StrictMath} equivalents.
+ */
+public final class BulkMath {
+    private BulkMath() { }
+
+    public static void sin(double[] in, double[] out, int offset, int length) {
+        checkBounds(in, out, offset, length);
+        sinImpl(in, out, offset, length);
+    }
+
+    public static void cos(double[] in, double[] out, int offset, int length) {
+        checkBounds(in, out, offset, length);
+        cosImpl(in, out, offset, length);
+    }
+
+    public static void tan(double[] in, double[] out, int offset, int length) {
+        checkBounds(in, out, offset, length);
+        tanImpl(in, out, offset, length);
+    }
+
+    public static void exp(double[] in, double[] out, int offset, int length) {
+        checkBounds(in, out, offset, length);
+        expImpl(in, out, offset, length);
+    }
+
+    public static void log(double[] in, double[] out, int offset, int length) {
+        checkBounds(in, out, offset, length);
+        logImpl(in, out, offset, length);
+    }
+
+    public static void log10(double[] in, double[] out, int offset, int length) {
+        checkBounds(in, out, offset, length);
+        log10Impl(in, out, offset, length);
+    }
+
+    public static void cbrt(double[] in, double[] out, int offset, int length) {
+        checkBounds(in, out, offset, length);
+        cbrtImpl(in, out, offset, length);
+    }
+
+    public static void sqrt(double[] in, double[] out, int offset, int length) {
+        checkBounds(in, out, offset, length);
+        sqrtImpl(in, out, offset, length);
+    }
+
+    /**
+     * Sets {@code out[i]} to {@code Math.pow(in[i], exponent)} for each {@code i} in
+     * {@code [offset, offset + length)}.
+     */
+    public static void pow(double[] in, double exponent, double[] out, int offset, int length) {
+        checkBounds(in, out, offset, length);
+        powImpl(in, exponent, out, offset, length);
+    }
+
+    private static void checkBounds(double[] in, double[] out, int offset, int length) {
+        if (in == null || out == null) {
+            throw new NullPointerException();
+        }
+        if ((offset | length) < 0 || offset > in.length - length || offset > out.length - length) {
+            throw new ArrayIndexOutOfBoundsException("offset=" + offset + " length=" + length
+                    + " in.length=" + in.length + " out.length=" + out.length);
+        }
+    }
+
+    private static native void sinImpl(double[] in, double[] out, int offset, int length);
+    private static native void cosImpl(double[] in, double[] out, int offset, int length);
+    private static native void tanImpl(double[] in, double[] out, int offset, int length);
+    private static native void expImpl(double[] in, double[] out, int offset, int length);
+    private static native void logImpl(double[] in, double[] out, int offset, int length);
+    private static native void log10Impl(double[] in, double[] out, int offset, int length);
+    private static native void cbrtImpl(double[] in, double[] out, int offset, int length);
+    private static native void sqrtImpl(double[] in, double[] out, int offset, int length);
+    private static native void powImpl(double[] in, double exponent, double[] out,
+            int offset, int length);
+}
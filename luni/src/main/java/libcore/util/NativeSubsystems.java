@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.util;
+
+/**
+ * Registers the natives of the parts of libjavacore that most processes never use, the first
+ * time they're needed. Each class with natives in one of these subsystems must call
+ * {@link #ensureRegistered} from its static initializer, before its first native call.
+ */
+public final class NativeSubsystems {
+    /** NativeCrypto, backed by OpenSSL. */
+    public static final String CRYPTO = "crypto";
+
+    /** ExpatParser, ExpatAttributes and ExpatInternPool. */
+    public static final String EXPAT = "expat";
+
+    /** The libcore.icu classes and NativeBidi. */
+    public static final String ICU = "icu";
+
+    private NativeSubsystems() {
+    }
+
+    /**
+     * Registers the natives of {@code subsystem} unless that's already been done.
+     *
+     * @throws IllegalArgumentException if {@code subsystem} isn't one of the constants above
+     */
+    public static native void ensureRegistered(String subsystem);
+}
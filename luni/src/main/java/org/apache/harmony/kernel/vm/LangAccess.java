@@ -17,6 +17,8 @@
 package org.apache.harmony.kernel.vm;
 
 import dalvik.system.VMStack;
+import java.io.FileDescriptor;
+import java.io.IOException;
 
 /**
  * Bridge into <code>java.lang</code> from other trusted parts of the
@@ -126,4 +128,36 @@ public abstract class LangAccess {
      * in absolute milliseconds-since-the-epoch
      */
     public abstract void parkUntil(long time);
+
+    /**
+     * Starts a supervised process: one in its own process group, which
+     * isn't reaped until {@link #reapSupervisedProcesses} is called.
+     *
+     * @param builder non-null; the description of the process to start
+     * @return non-null; the new process
+     */
+    public abstract Process startSupervisedProcess(ProcessBuilder builder) throws IOException;
+
+    /**
+     * Gets the pid of a process started by this library.
+     */
+    public abstract int getProcessId(Process process);
+
+    /**
+     * Opens a pidfd for an unreaped supervised process.
+     */
+    public abstract FileDescriptor openProcessPidFd(Process process) throws IOException;
+
+    /**
+     * Opens a signalfd for SIGCHLD, blocking it in the calling thread.
+     */
+    public abstract FileDescriptor openSigChldFd() throws IOException;
+
+    /**
+     * Reaps the supervised processes that have exited, writing their pids
+     * and exit values to {@code pids} and {@code statuses}.
+     *
+     * @return the number reaped
+     */
+    public abstract int reapSupervisedProcesses(int[] pids, int[] statuses);
 }
@@ -182,10 +182,13 @@ public class PlainDatagramSocketImpl extends DatagramSocketImpl {
 
     @Override
     public void send(DatagramPacket packet) throws IOException {
-        int port = isNativeConnected ? 0 : packet.getPort();
-        InetAddress address = isNativeConnected ? null : packet.getAddress();
+        if (isNativeConnected) {
+            Platform.NETWORK.sendConnected(fd, packet.getData(), packet.getOffset(),
+                    packet.getLength());
+            return;
+        }
         Platform.NETWORK.send(fd, packet.getData(), packet.getOffset(), packet.getLength(),
-                              port, address);
+                              packet.getPort(), packet.getAddress());
     }
 
     public void setOption(int optID, Object val) throws SocketException {
@@ -61,6 +61,48 @@ public interface IFileSystem {
 
     public final int O_TRUNC = 0x10000000;
 
+    /**
+     * Hints that may be or'ed into the mode passed to {@link #open}: the file
+     * will be read sequentially (so read ahead aggressively), or randomly (so
+     * don't read ahead at all).
+     */
+    public final int O_SEQUENTIAL = 0x20000000;
+
+    public final int O_RANDOM = 0x40000000;
+
+    /**
+     * Bypasses the page cache where the platform supports it. Buffers,
+     * lengths and file positions must then be aligned to the file system's
+     * block size; use {@link OSMemory#mallocAligned} for the buffers.
+     * Misaligned transfers throw IllegalArgumentException. File systems
+     * that refuse O_DIRECT silently fall back to cached I/O.
+     */
+    public final int O_DIRECT = 0x02000000;
+
+    /**
+     * Access-pattern hints for {@link #advise}, as for posix_fadvise(2).
+     */
+    public final int ADVICE_NORMAL = 0;
+
+    public final int ADVICE_SEQUENTIAL = 1;
+
+    public final int ADVICE_RANDOM = 2;
+
+    public final int ADVICE_WILLNEED = 3;
+
+    public final int ADVICE_DONTNEED = 4;
+
+    public final int ADVICE_NOREUSE = 5;
+
+    /**
+     * Flags for {@link #syncFileRange}, as for sync_file_range(2).
+     */
+    public final int SYNC_FILE_RANGE_WAIT_BEFORE = 1;
+
+    public final int SYNC_FILE_RANGE_WRITE = 2;
+
+    public final int SYNC_FILE_RANGE_WAIT_AFTER = 4;
+
     public long read(int fileDescriptor, byte[] bytes, int offset, int length)
             throws IOException;
 
@@ -93,6 +135,26 @@ public interface IFileSystem {
 
     public void fsync(int fileDescriptor, boolean metadata) throws IOException;
 
+    /**
+     * Like {@link #fsync}, but threads calling this concurrently for the same
+     * file descriptor share flushes: each call returns once a flush that
+     * started after it was made has finished. Many threads committing to one
+     * journal then pay for a few flushes between them rather than one each.
+     */
+    public void groupSync(int fileDescriptor, boolean metadata) throws IOException;
+
+    /**
+     * Starts and/or waits for writeback of the given range, according to the
+     * {@code SYNC_FILE_RANGE_*} flags, as sync_file_range(2) does. A
+     * {@code length} of 0 means "to the end of the file". This makes no
+     * promise of durability, since metadata and the disk's own cache aren't
+     * flushed; use it to get writeback going early so a later
+     * {@link #fsync} has less to do. Where sync_file_range(2) isn't available,
+     * starting writeback does nothing and waiting means fdatasync(2).
+     */
+    public void syncFileRange(int fileDescriptor, long offset, long length, int flags)
+            throws IOException;
+
     public void truncate(int fileDescriptor, long size) throws IOException;
 
     /**
@@ -102,9 +164,93 @@ public interface IFileSystem {
 
     public int open(String path, int mode) throws FileNotFoundException;
 
+    /**
+     * Tells the kernel how {@code length} bytes of the file starting at
+     * {@code offset} will be accessed. A {@code length} of 0 means to the
+     * end of the file. For example, a scan can drop the pages behind it with
+     * {@code ADVICE_DONTNEED}. Where the platform doesn't take advice this
+     * does nothing.
+     */
+    public void advise(int fileDescriptor, long offset, long length, int advice)
+            throws IOException;
+
+    /**
+     * Starts reading the given range of the file into the page cache without
+     * waiting for it.
+     */
+    public void readahead(int fileDescriptor, long offset, long length) throws IOException;
+
     public long transfer(int fileHandler, FileDescriptor socketDescriptor,
             long offset, long count) throws IOException;
 
+    /**
+     * Copies up to {@code count} bytes of the file {@code in}, starting at
+     * {@code inOffset}, to the file {@code out} at its current position,
+     * advancing that position. Where the platform allows, the data stays in
+     * the kernel (copy_file_range(2) or sendfile(2)), or isn't copied at all:
+     * copying a whole file into an empty one on a file system with reflinks
+     * just shares the data.
+     *
+     * @return the number of bytes copied, less than {@code count} only at the
+     *         end of {@code in}.
+     */
+    public long transferFile(int in, long inOffset, int out, long count) throws IOException;
+
+    /**
+     * Moves up to {@code count} bytes from the socket {@code source} to
+     * {@code sink} without copying them through the Java heap. Where the
+     * platform supports it the bytes never leave the kernel.
+     *
+     * @return the number of bytes moved, 0 if a non-blocking {@code source}
+     *         had nothing to read, or -1 at end of stream.
+     */
+    public long relay(FileDescriptor source, FileDescriptor sink, long count)
+            throws IOException;
+
+    /**
+     * Operations for {@link #ioQueueSubmit}.
+     */
+    public final int IO_READ = 0;
+
+    public final int IO_WRITE = 1;
+
+    /**
+     * Creates a queue for batches of positional reads and writes, allowing
+     * up to {@code depth} requests to be outstanding at once. The queue must
+     * be released with {@link #ioQueueClose}, and must only be used by one
+     * thread at a time.
+     *
+     * @return a handle to the queue.
+     */
+    public int ioQueueOpen(int depth) throws IOException;
+
+    /**
+     * Queues the first {@code count} requests described by the given
+     * arrays. Request i reads or writes (according to {@code ops[i]})
+     * {@code lengths[i]} bytes at offset {@code offsets[i]} of the file
+     * {@code fds[i]}, to or from the native memory at {@code addresses[i]},
+     * which must stay valid until the request is reaped. {@code tags[i]} is
+     * handed back with the request's completion.
+     *
+     * @return the number of requests accepted, which is less than
+     *         {@code count} if the queue is full.
+     */
+    public int ioQueueSubmit(int queue, int[] ops, int[] fds, long[] offsets,
+            int[] addresses, int[] lengths, int[] tags, int count) throws IOException;
+
+    /**
+     * Waits until at least {@code minComplete} requests have completed, or
+     * none are outstanding, and returns the completions available: for each,
+     * the request's tag in {@code tags} and the number of bytes transferred,
+     * or a negated errno, at the same index in {@code results}.
+     *
+     * @return the number of completions returned.
+     */
+    public int ioQueueReap(int queue, int[] tags, long[] results, int minComplete)
+            throws IOException;
+
+    public void ioQueueClose(int queue);
+
     // BEGIN android-deleted
     // public long ttyAvailable() throws IOException;
     // public long ttyRead(byte[] bytes, int offset, int length) throws IOException;
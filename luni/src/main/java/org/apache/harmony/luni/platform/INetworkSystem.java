@@ -45,6 +45,27 @@ public interface INetworkSystem {
 
     public int writeDirect(FileDescriptor fd, int address, int offset, int count) throws IOException;
 
+    /**
+     * Reads into {@code size} buffers with a single system call. Buffer
+     * {@code i} starts at address {@code buffers[i] + offsets[i]} and is
+     * {@code lengths[i]} bytes long.
+     *
+     * @return the number of bytes read, 0 if a non-blocking socket had nothing
+     *         to read, or -1 at end of stream
+     */
+    public long readv(FileDescriptor fd, int[] buffers, int[] offsets, int[] lengths, int size)
+            throws IOException;
+
+    /**
+     * Writes {@code size} buffers, laid out as for {@link #readv}, with a
+     * single system call. If {@code more} is true the kernel is told more data
+     * will follow shortly, letting it coalesce this write with the next one.
+     *
+     * @return the number of bytes written, which may be less than requested
+     */
+    public long writev(FileDescriptor fd, int[] buffers, int[] offsets, int[] lengths, int size,
+            boolean more) throws IOException;
+
     public boolean connectNonBlocking(FileDescriptor fd, InetAddress inetAddress, int port)
             throws IOException;
     public boolean isConnected(FileDescriptor fd, int timeout) throws IOException;
@@ -54,11 +75,52 @@ public interface INetworkSystem {
     public int sendDirect(FileDescriptor fd, int address, int offset, int length,
             int port, InetAddress inetAddress) throws IOException;
 
+    /**
+     * Sends a datagram to the peer the datagram socket {@code fd} is
+     * connected to. Cheaper than {@link #send} with a null address, because
+     * only the packet's bytes are copied out of {@code data}.
+     */
+    public int sendConnected(FileDescriptor fd, byte[] data, int offset, int length)
+            throws IOException;
+
+    /**
+     * Sends a datagram from native memory to the peer the datagram socket
+     * {@code fd} is connected to.
+     */
+    public int sendConnectedDirect(FileDescriptor fd, int address, int offset, int length)
+            throws IOException;
+
     public int recv(FileDescriptor fd, DatagramPacket packet, byte[] data, int offset,
             int length, boolean peek, boolean connected) throws IOException;
     public int recvDirect(FileDescriptor fd, DatagramPacket packet, int address, int offset,
             int length, boolean peek, boolean connected) throws IOException;
 
+    /**
+     * Receives up to {@code count} datagrams in a single call. Datagram
+     * {@code i} is written to {@code address + i * stride}, and its length,
+     * sender port and sender address are written to element {@code i} of
+     * {@code lengths}, {@code ports} and {@code addresses}. Each address takes
+     * 16 bytes of {@code addresses}, with IPv4 addresses in IPv4-mapped form.
+     * {@code ports} and {@code addresses} may be null. Only the first datagram
+     * blocks.
+     *
+     * @return the number of datagrams received
+     */
+    public int recvBatchDirect(FileDescriptor fd, int address, int stride, int count,
+            int[] lengths, int[] ports, byte[] addresses) throws IOException;
+
+    /**
+     * Sends up to {@code count} datagrams in a single call. Datagram {@code i}
+     * is {@code lengths[i]} bytes read from {@code address + i * stride}. If
+     * {@code addresses} is null the socket must be connected; otherwise
+     * datagram {@code i} is sent to the 16-byte address at offset
+     * {@code 16 * i} of {@code addresses} and port {@code ports[i]}.
+     *
+     * @return the number of datagrams sent
+     */
+    public int sendBatchDirect(FileDescriptor fd, int address, int stride, int count,
+            int[] lengths, int[] ports, byte[] addresses) throws IOException;
+
     public void disconnectDatagram(FileDescriptor fd) throws SocketException;
 
     public void socket(FileDescriptor fd, boolean stream) throws SocketException;
@@ -74,6 +136,17 @@ public interface INetworkSystem {
     public void connect(FileDescriptor fd, InetAddress inetAddress, int port, int timeout)
             throws SocketException;
 
+    /**
+     * Connects like {@link #connect}, but where the platform supports TCP Fast
+     * Open, sends up to {@code count} bytes of {@code data} in the SYN. This
+     * saves a round trip when reconnecting to a peer we've recently talked to.
+     *
+     * @return the number of bytes of {@code data} already sent; the caller
+     *         must write the rest
+     */
+    public int connectWithData(FileDescriptor fd, InetAddress inetAddress, int port, int timeout,
+            byte[] data, int offset, int count) throws SocketException;
+
     public InetAddress getSocketLocalAddress(FileDescriptor fd);
 
     /**
@@ -110,6 +183,63 @@ public interface INetworkSystem {
             int numReadable, int numWritable, long timeout, int[] flags)
             throws SocketException;
 
+    /**
+     * Creates a new epoll(7) instance and stores it in {@code epollFd}. Unlike
+     * {@link #select}, an epoll instance remembers its registered file
+     * descriptors between waits, has no FD_SETSIZE limit, and each wait costs
+     * time proportional to the number of ready file descriptors rather than
+     * the number registered. Close it with {@link #close}.
+     *
+     * @throws SocketException if the instance can't be created
+     * @throws UnsupportedOperationException if epoll isn't available
+     */
+    public void epollCreate(FileDescriptor epollFd) throws SocketException;
+
+    /**
+     * Adds {@code fd} to the epoll instance {@code epollFd}. The
+     * {@code ops} are a combination of {@code SelectorImpl.READABLE} and
+     * {@code SelectorImpl.WRITEABLE}. The {@code token} is returned by
+     * {@link #epollWait} when {@code fd} is ready, and will typically index
+     * the caller's own table of registrations.
+     */
+    public void epollRegister(FileDescriptor epollFd, FileDescriptor fd, int ops, int token)
+            throws SocketException;
+
+    /**
+     * Changes the interest set and token of a file descriptor already added
+     * with {@link #epollRegister}.
+     */
+    public void epollModify(FileDescriptor epollFd, FileDescriptor fd, int ops, int token)
+            throws SocketException;
+
+    /**
+     * Removes {@code fd} from the epoll instance {@code epollFd}. It is not
+     * an error if {@code fd} has already been closed, which implicitly removes
+     * it.
+     */
+    public void epollDeregister(FileDescriptor epollFd, FileDescriptor fd)
+            throws SocketException;
+
+    /**
+     * Waits for registered file descriptors to become ready.
+     *
+     * @param epollFd
+     *            an epoll instance created by {@link #epollCreate}
+     * @param readyTokens
+     *            for output. Upon returning, the first elements hold the
+     *            tokens of the ready file descriptors
+     * @param readyOps
+     *            for output. Upon returning, the first elements hold the
+     *            ready operations corresponding to {@code readyTokens}
+     * @param timeout
+     *            timeout in milliseconds, or a negative value to wait forever
+     * @return the number of ready file descriptors; 0 if the wait timed out
+     *            or was interrupted
+     * @throws SocketException
+     */
+    public int epollWait(FileDescriptor epollFd, int[] readyTokens, int[] readyOps,
+            long timeout) throws SocketException;
+
     /*
      * Query the IP stack for the local port to which this socket is bound.
      *
@@ -140,6 +270,30 @@ public interface INetworkSystem {
     public void setSocketOption(FileDescriptor fd, int opt, Object optVal)
             throws SocketException;
 
+    /**
+     * Turns the collection of socket I/O statistics on or off. Collection is
+     * off by default, and costs next to nothing while off.
+     */
+    public void setSocketStatsEnabled(boolean enabled);
+
+    /**
+     * Returns a snapshot of the socket I/O statistics collected while enabled.
+     * The array holds a record of 217 longs for each file descriptor with
+     * statistics, in ascending order of file descriptor. A record starts with
+     * the file descriptor. Then, for each of read, write, recv, send, accept
+     * and connect, in that order, it holds 36 longs: the number of calls, the
+     * number of bytes transferred, the number of calls that would have
+     * blocked, the number of other failures, and then 32 latency histogram
+     * buckets, where bucket {@code i} counts calls that took less than
+     * 2<sup>i</sup> microseconds but not less than 2<sup>i-1</sup>.
+     *
+     * <p>A record outlives its socket, and a later socket given the same file
+     * descriptor adds to the same record, so reset between measurements.
+     *
+     * @param reset whether to clear the statistics after taking the snapshot
+     */
+    public long[] getSocketStats(boolean reset);
+
     /**
      * It is an error to close the same file descriptor from multiple threads
      * concurrently.
@@ -82,6 +82,11 @@ class OSFileSystem implements IFileSystem {
 
     public native void fsync(int fd, boolean metadata) throws IOException;
 
+    public native void groupSync(int fd, boolean metadata) throws IOException;
+
+    public native void syncFileRange(int fd, long offset, long length, int flags)
+            throws IOException;
+
     /*
      * File position seeking.
      */
@@ -114,8 +119,31 @@ class OSFileSystem implements IFileSystem {
 
     public native int open(String path, int mode) throws FileNotFoundException;
 
+    public native void advise(int fd, long offset, long length, int advice) throws IOException;
+
+    public native void readahead(int fd, long offset, long length) throws IOException;
+
     public native long transfer(int fd, FileDescriptor sd, long offset, long count)
             throws IOException;
 
+    public native long transferFile(int in, long inOffset, int out, long count)
+            throws IOException;
+
+    public native long relay(FileDescriptor source, FileDescriptor sink, long count)
+            throws IOException;
+
     public native int ioctlAvailable(FileDescriptor fileDescriptor) throws IOException;
+
+    /*
+     * Batched positional I/O.
+     */
+    public native int ioQueueOpen(int depth) throws IOException;
+
+    public native int ioQueueSubmit(int queue, int[] ops, int[] fds, long[] offsets,
+            int[] addresses, int[] lengths, int[] tags, int count) throws IOException;
+
+    public native int ioQueueReap(int queue, int[] tags, long[] results, int minComplete)
+            throws IOException;
+
+    public native void ioQueueClose(int queue);
 }
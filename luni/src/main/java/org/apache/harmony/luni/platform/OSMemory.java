@@ -145,11 +145,21 @@ public final class OSMemory {
      */
     public static native int malloc(int byteCount) throws OutOfMemoryError;
 
+    /**
+     * Like {@link #malloc(int)}, but the address returned is a multiple of
+     * {@code alignment}, a power of two of at least 16. Use it for buffers
+     * passed to files opened with {@code IFileSystem.O_DIRECT}, which
+     * typically need 512- or 4096-byte alignment. Release the memory with
+     * {@link #free(int)}.
+     */
+    public static native int mallocAligned(int byteCount, int alignment) throws OutOfMemoryError;
+
     /**
      * Deallocates space for a memory block that was previously allocated by a
-     * call to {@link #malloc(int) malloc(int)}. The number of bytes freed is
-     * identical to the number of bytes acquired when the memory block was
-     * allocated. If <code>address</code> is zero the method does nothing.
+     * call to {@link #malloc(int) malloc(int)} or {@link #mallocAligned}. The
+     * number of bytes freed is identical to the number of bytes acquired when
+     * the memory block was allocated. If <code>address</code> is zero the
+     * method does nothing.
      * <p>
      * Freeing a pointer to a memory block that was not allocated by
      * <code>malloc()</code> has unspecified effect.
@@ -160,6 +170,23 @@ public final class OSMemory {
      */
     public static native void free(int address);
 
+    /**
+     * Enables recycling of {@link #malloc} blocks between 512 bytes and 64KiB,
+     * for callers that churn through short-lived direct buffers. Freed blocks
+     * are kept (per thread first, then in a shared pool) until up to
+     * {@code maxBytes} are held. Zero, the default, turns the pool off and
+     * releases the shared part of it and the calling thread's part. Other
+     * threads release theirs on their next {@code malloc} or {@code free}, or
+     * when they exit.
+     */
+    public static native void setPoolLimit(int maxBytes);
+
+    /**
+     * Returns the {@link #setPoolLimit pool}'s hit count, miss count, and the
+     * number of bytes it currently holds, in that order.
+     */
+    public static native long[] getPoolStats();
+
     /**
      * Copies <code>length</code> bytes from <code>srcAddress</code> to
      * <code>destAddress</code>. Where any part of the source memory block
@@ -209,9 +236,42 @@ public final class OSMemory {
     public static native void pokeLongArray(int address, long[] src, int offset, int count, boolean swap);
     public static native void pokeShortArray(int address, short[] src, int offset, int count, boolean swap);
 
-    private static native int mmapImpl(int fd, long offset, long size, int mapMode);
+    /**
+     * Option for {@link #mmap(int, long, long, MapMode, int)}: fault in the
+     * whole mapping up front (MAP_POPULATE), so first accesses don't each take
+     * a page fault.
+     */
+    public static final int MAP_OPTION_POPULATE = 1;
+
+    /**
+     * Option for {@link #mmap(int, long, long, MapMode, int)}: ask for
+     * transparent huge pages (MADV_HUGEPAGE) to cut TLB misses on large
+     * mappings. This is only a hint, which many kernels ignore for file-backed
+     * memory.
+     */
+    public static final int MAP_OPTION_HUGE_PAGES = 2;
+
+    /**
+     * Access-pattern advice for {@link #madvise}, as for madvise(2).
+     */
+    public static final int MADVICE_NORMAL = 0;
+    public static final int MADVICE_RANDOM = 1;
+    public static final int MADVICE_SEQUENTIAL = 2;
+    public static final int MADVICE_WILLNEED = 3;
+    public static final int MADVICE_DONTNEED = 4;
+
+    private static native int mmapImpl(int fd, long offset, long size, int mapMode, int options);
 
     public static int mmap(int fd, long offset, long size, MapMode mapMode) throws IOException {
+        return mmap(fd, offset, size, mapMode, 0);
+    }
+
+    /**
+     * Maps 'size' bytes of 'fd' starting at 'offset', applying the given
+     * {@code MAP_OPTION_*} flags.
+     */
+    public static int mmap(int fd, long offset, long size, MapMode mapMode, int options)
+            throws IOException {
         // Check just those errors mmap(2) won't detect.
         if (offset < 0 || size < 0 || offset > Integer.MAX_VALUE || size > Integer.MAX_VALUE) {
             throw new IllegalArgumentException("offset=" + offset + " size=" + size);
@@ -222,11 +282,18 @@ public final class OSMemory {
         } else if (mapMode == MapMode.READ_WRITE) {
             intMode = 2;
         }
-        return mmapImpl(fd, offset, size, intMode);
+        return mmapImpl(fd, offset, size, intMode, options);
     }
 
     public static native void munmap(int addr, long size);
 
+    /**
+     * Applies one of the {@code MADVICE_*} hints to the mapped range
+     * {@code [addr, addr + size)}. The start is rounded down to a page boundary.
+     * Note that {@code MADVICE_DONTNEED} discards changes to private mappings.
+     */
+    public static native void madvise(int addr, long size, int advice) throws IOException;
+
     public static native void load(int addr, long size);
 
     public static native boolean isLoaded(int addr, long size);
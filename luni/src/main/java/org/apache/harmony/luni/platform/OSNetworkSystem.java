@@ -46,6 +46,9 @@ final class OSNetworkSystem implements INetworkSystem {
     public native void connect(FileDescriptor fd, InetAddress inetAddress, int port, int timeout)
             throws SocketException;
 
+    public native int connectWithData(FileDescriptor fd, InetAddress inetAddress, int port,
+            int timeout, byte[] data, int offset, int count) throws SocketException;
+
     public native boolean connectNonBlocking(FileDescriptor fd, InetAddress inetAddress, int port)
             throws IOException;
     public native boolean isConnected(FileDescriptor fd, int timeout) throws IOException;
@@ -54,6 +57,20 @@ final class OSNetworkSystem implements INetworkSystem {
 
     public native void disconnectDatagram(FileDescriptor fd) throws SocketException;
 
+    public native void epollCreate(FileDescriptor epollFd) throws SocketException;
+
+    public native void epollRegister(FileDescriptor epollFd, FileDescriptor fd, int ops,
+            int token) throws SocketException;
+
+    public native void epollModify(FileDescriptor epollFd, FileDescriptor fd, int ops,
+            int token) throws SocketException;
+
+    public native void epollDeregister(FileDescriptor epollFd, FileDescriptor fd)
+            throws SocketException;
+
+    public native int epollWait(FileDescriptor epollFd, int[] readyTokens, int[] readyOps,
+            long timeout) throws SocketException;
+
     public native InetAddress getSocketLocalAddress(FileDescriptor fd);
 
     public native int getSocketLocalPort(FileDescriptor fd);
@@ -67,6 +84,9 @@ final class OSNetworkSystem implements INetworkSystem {
 
     public native int readDirect(FileDescriptor fd, int address, int count) throws IOException;
 
+    public native long readv(FileDescriptor fd, int[] buffers, int[] offsets, int[] lengths,
+            int size) throws IOException;
+
     public native int recv(FileDescriptor fd, DatagramPacket packet,
             byte[] data, int offset, int length,
             boolean peek, boolean connected) throws IOException;
@@ -75,6 +95,9 @@ final class OSNetworkSystem implements INetworkSystem {
             int address, int offset, int length,
             boolean peek, boolean connected) throws IOException;
 
+    public native int recvBatchDirect(FileDescriptor fd, int address, int stride, int count,
+            int[] lengths, int[] ports, byte[] addresses) throws IOException;
+
     public boolean select(FileDescriptor[] readFDs, FileDescriptor[] writeFDs,
             int numReadable, int numWritable, long timeout, int[] flags)
             throws SocketException {
@@ -99,6 +122,15 @@ final class OSNetworkSystem implements INetworkSystem {
     public native int sendDirect(FileDescriptor fd, int address, int offset, int length,
             int port, InetAddress inetAddress) throws IOException;
 
+    public native int sendConnected(FileDescriptor fd, byte[] data, int offset, int length)
+            throws IOException;
+
+    public native int sendConnectedDirect(FileDescriptor fd, int address, int offset, int length)
+            throws IOException;
+
+    public native int sendBatchDirect(FileDescriptor fd, int address, int stride, int count,
+            int[] lengths, int[] ports, byte[] addresses) throws IOException;
+
     public native void sendUrgentData(FileDescriptor fd, byte value);
 
     public native void setInetAddress(InetAddress sender, byte[] address);
@@ -106,6 +138,10 @@ final class OSNetworkSystem implements INetworkSystem {
     public native void setSocketOption(FileDescriptor fd, int opt, Object optVal)
             throws SocketException;
 
+    public native void setSocketStatsEnabled(boolean enabled);
+
+    public native long[] getSocketStats(boolean reset);
+
     public native void shutdownInput(FileDescriptor fd) throws IOException;
 
     public native void shutdownOutput(FileDescriptor fd) throws IOException;
@@ -117,4 +153,7 @@ final class OSNetworkSystem implements INetworkSystem {
 
     public native int writeDirect(FileDescriptor fd, int address, int offset, int count)
             throws IOException;
+
+    public native long writev(FileDescriptor fd, int[] buffers, int[] offsets, int[] lengths,
+            int size, boolean more) throws IOException;
 }
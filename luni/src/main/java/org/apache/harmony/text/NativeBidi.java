@@ -17,12 +17,17 @@
 
 package org.apache.harmony.text;
 
+import libcore.util.NativeSubsystems;
+
 /**
  * Dalvik Bidi wrapper. Derived from an old version of Harmony; today they call
  * straight through to ICU4J.
  */
 
 public final class NativeBidi {
+    static {
+        NativeSubsystems.ensureRegistered(NativeSubsystems.ICU);
+    }
 
     public static final int UBIDI_DEFAULT_LTR = 0xfe;
 
@@ -82,6 +87,13 @@ public final class NativeBidi {
     // Get the BidiRuns
     public static native BidiRun[] ubidi_getRuns(long pBidi);
 
+    // Runs the algorithm over text[textStart..textStart+length) and returns the direction,
+    // paragraph level, run count and the runs as (start, limit, level) triples, all in one call.
+    // The levels go in levelsOut, and the visual order in visualMapOut if it's non-null.
+    // This is a convenience function that does not use a UBiDi object.
+    public static native int[] ubidi_analyze(char[] text, int textStart, int length,
+            int paraLevel, byte[] embeddingLevels, byte[] levelsOut, int[] visualMapOut);
+
     // This is a convenience function that does not use a UBiDi object
     public static native int[] ubidi_reorderVisual(byte[] levels, int length);
 }
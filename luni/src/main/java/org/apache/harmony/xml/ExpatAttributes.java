@@ -16,18 +16,58 @@
 
 package org.apache.harmony.xml;
 
+import java.util.HashMap;
+import libcore.util.NativeSubsystems;
 import org.xml.sax.Attributes;
 
 /**
  * Wraps native attribute array.
  */
 abstract class ExpatAttributes implements Attributes {
+    static {
+        NativeSubsystems.ensureRegistered(NativeSubsystems.EXPAT);
+    }
 
     /**
      * Since we don't do validation, pretty much everything is CDATA type.
      */
     private static final String CDATA = "CDATA";
 
+    /**
+     * Elements with at least this many attributes get hash tables for
+     * looking attributes up by qualified name, rather than a native scan.
+     */
+    private static final int NAME_INDEX_THRESHOLD = 8;
+
+    /*
+     * Strings we've already fetched for the current attributes, so that
+     * asking for them again doesn't cross into native code. Values are
+     * fetched all at once, the first time any is needed.
+     */
+    private String[] uris;
+    private String[] localNames;
+    private String[] qNames;
+    private String[] values;
+
+    /** Index of the first attribute with each qualified name, or null. */
+    private HashMap<String, Integer> qNameIndex;
+
+    /** Index of the first attribute with each local name, or null. */
+    private HashMap<String, Integer> localNameIndex;
+
+    /**
+     * Forgets everything fetched so far. Called whenever the underlying
+     * attributes change.
+     */
+    /*package*/ void clearCache() {
+        uris = null;
+        localNames = null;
+        qNames = null;
+        values = null;
+        qNameIndex = null;
+        localNameIndex = null;
+    }
+
     /**
      * Gets the number of attributes.
      */
@@ -46,22 +86,48 @@ abstract class ExpatAttributes implements Attributes {
     public abstract int getPointer();
 
     public String getURI(int index) {
-        if (index < 0 || index >= getLength()) {
+        int length = getLength();
+        if (index < 0 || index >= length) {
             return null;
         }
-        return getURI(getParserPointer(), getPointer(), index);
+        if (uris == null) {
+            uris = new String[length];
+        }
+        String uri = uris[index];
+        if (uri == null) {
+            uri = uris[index] = getURI(getParserPointer(), getPointer(), index);
+        }
+        return uri;
     }
 
     public String getLocalName(int index) {
-        return (index < 0 || index >= getLength())
-                ? null
-                : getLocalName(getParserPointer(), getPointer(), index);
+        int length = getLength();
+        if (index < 0 || index >= length) {
+            return null;
+        }
+        if (localNames == null) {
+            localNames = new String[length];
+        }
+        String localName = localNames[index];
+        if (localName == null) {
+            localName = localNames[index] = getLocalName(getParserPointer(), getPointer(), index);
+        }
+        return localName;
     }
 
     public String getQName(int index) {
-        return (index < 0 || index >= getLength())
-                ? null
-                : getQName(getParserPointer(), getPointer(), index);
+        int length = getLength();
+        if (index < 0 || index >= length) {
+            return null;
+        }
+        if (qNames == null) {
+            qNames = new String[length];
+        }
+        String qName = qNames[index];
+        if (qName == null) {
+            qName = qNames[index] = getQName(getParserPointer(), getPointer(), index);
+        }
+        return qName;
     }
 
     public String getType(int index) {
@@ -69,9 +135,14 @@ abstract class ExpatAttributes implements Attributes {
     }
 
     public String getValue(int index) {
-        return (index < 0 || index >= getLength())
-                ? null
-                : getValueByIndex(getPointer(), index);
+        int length = getLength();
+        if (index < 0 || index >= length) {
+            return null;
+        }
+        if (values == null) {
+            values = getValues(getPointer(), length);
+        }
+        return values[index];
     }
 
     public int getIndex(String uri, String localName) {
@@ -96,7 +167,39 @@ abstract class ExpatAttributes implements Attributes {
         if (pointer == 0) {
             return -1;
         }
-        return getIndexForQName(pointer, qName);
+        int length = getLength();
+        if (length < NAME_INDEX_THRESHOLD) {
+            return getIndexForQName(pointer, qName);
+        }
+
+        /*
+         * Like the native scan, a name without a prefix matches by local name
+         * alone, whatever the attribute's prefix; otherwise the whole
+         * qualified name must match.
+         */
+        HashMap<String, Integer> index;
+        if (qName.indexOf(':') == -1) {
+            if (localNameIndex == null) {
+                localNameIndex = buildIndex(getLocalNames(getParserPointer(), pointer, length));
+            }
+            index = localNameIndex;
+        } else {
+            if (qNameIndex == null) {
+                qNameIndex = buildIndex(getQNames(getParserPointer(), pointer, length));
+            }
+            index = qNameIndex;
+        }
+        Integer result = index.get(qName);
+        return result != null ? result : -1;
+    }
+
+    private static HashMap<String, Integer> buildIndex(String[] names) {
+        HashMap<String, Integer> index = new HashMap<String, Integer>(names.length * 2);
+        // Walk backwards so that the first of any duplicates wins, as with a linear scan.
+        for (int i = names.length - 1; i >= 0; i--) {
+            index.put(names[i], i);
+        }
+        return index;
     }
 
     public String getType(String uri, String localName) {
@@ -120,31 +223,25 @@ abstract class ExpatAttributes implements Attributes {
         if (localName == null) {
             throw new NullPointerException("local name");
         }
-        int pointer = getPointer();
-        if (pointer == 0) {
-            return null;
-        }
-        return getValue(pointer, uri, localName);
+        int index = getIndex(uri, localName);
+        return index == -1 ? null : getValue(index);
     }
 
     public String getValue(String qName) {
         if (qName == null) {
             throw new NullPointerException("qName");
         }
-        int pointer = getPointer();
-        if (pointer == 0) {
-            return null;
-        }
-        return getValueForQName(pointer, qName);
+        int index = getIndex(qName);
+        return index == -1 ? null : getValue(index);
     }
 
     private static native String getURI(int pointer, int attributePointer, int index);
     private static native String getLocalName(int pointer, int attributePointer, int index);
     private static native String getQName(int pointer, int attributePointer, int index);
-    private static native String getValueByIndex(int attributePointer, int index);
+    private static native String[] getValues(int attributePointer, int count);
+    private static native String[] getLocalNames(int pointer, int attributePointer, int count);
+    private static native String[] getQNames(int pointer, int attributePointer, int count);
     private static native int getIndex(int attributePointer, String uri, String localName);
     private static native int getIndexForQName(int attributePointer, String qName);
-    private static native String getValue(int attributePointer, String uri, String localName);
-    private static native String getValueForQName(int attributePointer, String qName);
     protected native void freeAttributes(int pointer);
 }
@@ -0,0 +1,272 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.apache.harmony.xml;
+
+import java.io.ByteArrayOutputStream;
+import java.io.CharArrayWriter;
+import java.io.FilterInputStream;
+import java.io.FilterReader;
+import java.io.IOException;
+import java.io.InputStream;
+import java.io.Reader;
+import java.util.Iterator;
+import java.util.LinkedHashMap;
+import java.util.Map;
+
+/**
+ * External entities, such as DTDs, remembered by public and system id. Give
+ * one cache to every {@link ExpatReader} that reads documents referring to
+ * the same entities, and each entity is only resolved and read the first
+ * time any of them needs it; later documents get the same text straight from
+ * the cache, without asking the {@link org.xml.sax.EntityResolver}. Expat
+ * still parses the entity for each document. A cache may be used by several
+ * threads at once.
+ *
+ * <p>Entries stay until they're evicted to make room, removed, or reported
+ * stale by {@link #isStale}, which subclasses can override to expire them.
+ */
+public class ExpatEntityCache {
+    /** The default limit on the total size of the cached text, in bytes. */
+    public static final int DEFAULT_MAX_SIZE = 1024 * 1024;
+
+    private final int maxSize;
+    private int size;
+
+    /** Entries by key, least recently used first. */
+    private final LinkedHashMap<String, Entry> entries
+            = new LinkedHashMap<String, Entry>(16, 0.75f, true);
+
+    public ExpatEntityCache() {
+        this(DEFAULT_MAX_SIZE);
+    }
+
+    /**
+     * Constructs a cache holding up to {@code maxSize} bytes of entity text.
+     * Chars count as two bytes. Entities bigger than that are never cached.
+     */
+    public ExpatEntityCache(int maxSize) {
+        if (maxSize < 0) {
+            throw new IllegalArgumentException("maxSize=" + maxSize);
+        }
+        this.maxSize = maxSize;
+    }
+
+    /**
+     * Returns true if the cached text for the given entity, read at {@code
+     * loadedAtMillis}, should no longer be used. The entity is then resolved
+     * and read again. The default implementation always returns false.
+     */
+    protected boolean isStale(String publicId, String systemId, long loadedAtMillis) {
+        return false;
+    }
+
+    /**
+     * Forgets the given entity, if it's cached.
+     */
+    public synchronized void remove(String publicId, String systemId) {
+        Entry entry = entries.remove(key(publicId, systemId));
+        if (entry != null) {
+            size -= entry.size();
+        }
+    }
+
+    /**
+     * Forgets every entity.
+     */
+    public synchronized void clear() {
+        entries.clear();
+        size = 0;
+    }
+
+    private static String key(String publicId, String systemId) {
+        // A null id and an empty one both mean "none" to us.
+        return (publicId == null ? "" : publicId) + '\u0000' + (systemId == null ? "" : systemId);
+    }
+
+    /**
+     * Returns the cached text for the given entity, or null.
+     */
+    /*package*/ Entry get(String publicId, String systemId) {
+        Entry entry;
+        synchronized (this) {
+            entry = entries.get(key(publicId, systemId));
+        }
+        if (entry != null && isStale(publicId, systemId, entry.loadedAtMillis)) {
+            remove(publicId, systemId);
+            return null;
+        }
+        return entry;
+    }
+
+    /*package*/ synchronized void put(String publicId, String systemId, Entry entry) {
+        int entrySize = entry.size();
+        if (entrySize > maxSize) {
+            return;
+        }
+        Entry old = entries.put(key(publicId, systemId), entry);
+        size += entrySize - (old != null ? old.size() : 0);
+        Iterator<Map.Entry<String, Entry>> it = entries.entrySet().iterator();
+        while (size > maxSize) {
+            size -= it.next().getValue().size();
+            it.remove();
+        }
+    }
+
+    /**
+     * Returns a reader that records what's read from {@code in}, for building
+     * an entry afterwards.
+     */
+    /*package*/ RecordingReader record(Reader in) {
+        return new RecordingReader(in, maxSize / 2);
+    }
+
+    /*package*/ RecordingInputStream record(InputStream in) {
+        return new RecordingInputStream(in, maxSize);
+    }
+
+    /**
+     * The text of an entity, along with the ids and encoding its parser
+     * was given.
+     */
+    /*package*/ static final class Entry {
+        final String publicId;
+        final String systemId;
+        final String encoding;
+        final char[] chars;
+        final byte[] bytes;
+        final long loadedAtMillis = System.currentTimeMillis();
+
+        Entry(String publicId, String systemId, String encoding, char[] chars,
+                byte[] bytes) {
+            this.publicId = publicId;
+            this.systemId = systemId;
+            this.encoding = encoding;
+            this.chars = chars;
+            this.bytes = bytes;
+        }
+
+        int size() {
+            return chars != null ? 2 * chars.length : bytes.length;
+        }
+    }
+
+    /**
+     * Keeps a copy of everything read through it, until that gets too big to
+     * cache.
+     */
+    /*package*/ static final class RecordingReader extends FilterReader {
+        private final int maxLength;
+        private CharArrayWriter recorded = new CharArrayWriter();
+
+        RecordingReader(Reader in, int maxLength) {
+            super(in);
+            this.maxLength = maxLength;
+        }
+
+        @Override public int read() throws IOException {
+            int c = in.read();
+            if (c != -1) {
+                record(new char[] { (char) c }, 0, 1);
+            }
+            return c;
+        }
+
+        @Override public int read(char[] buffer, int offset, int length) throws IOException {
+            int count = in.read(buffer, offset, length);
+            if (count > 0) {
+                record(buffer, offset, count);
+            }
+            return count;
+        }
+
+        @Override public long skip(long n) throws IOException {
+            // Skipped text would be missing from the recording.
+            recorded = null;
+            return in.skip(n);
+        }
+
+        @Override public boolean markSupported() {
+            return false;
+        }
+
+        private void record(char[] buffer, int offset, int count) {
+            if (recorded != null) {
+                if (recorded.size() + count > maxLength) {
+                    recorded = null;
+                } else {
+                    recorded.write(buffer, offset, count);
+                }
+            }
+        }
+
+        /**
+         * Returns everything read, or null if there was too much.
+         */
+        char[] toCharArray() {
+            return recorded != null ? recorded.toCharArray() : null;
+        }
+    }
+
+    /*package*/ static final class RecordingInputStream extends FilterInputStream {
+        private final int maxLength;
+        private ByteArrayOutputStream recorded = new ByteArrayOutputStream();
+
+        RecordingInputStream(InputStream in, int maxLength) {
+            super(in);
+            this.maxLength = maxLength;
+        }
+
+        @Override public int read() throws IOException {
+            int b = in.read();
+            if (b != -1) {
+                record(new byte[] { (byte) b }, 0, 1);
+            }
+            return b;
+        }
+
+        @Override public int read(byte[] buffer, int offset, int length) throws IOException {
+            int count = in.read(buffer, offset, length);
+            if (count > 0) {
+                record(buffer, offset, count);
+            }
+            return count;
+        }
+
+        @Override public long skip(long n) throws IOException {
+            recorded = null;
+            return in.skip(n);
+        }
+
+        @Override public boolean markSupported() {
+            return false;
+        }
+
+        private void record(byte[] buffer, int offset, int count) {
+            if (recorded != null) {
+                if (recorded.size() + count > maxLength) {
+                    recorded = null;
+                } else {
+                    recorded.write(buffer, offset, count);
+                }
+            }
+        }
+
+        byte[] toByteArray() {
+            return recorded != null ? recorded.toByteArray() : null;
+        }
+    }
+}
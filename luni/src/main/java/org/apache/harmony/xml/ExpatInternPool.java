@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.apache.harmony.xml;
+
+import libcore.util.NativeSubsystems;
+
+/**
+ * Interned strings shared between parsers. Give one pool to every {@link
+ * ExpatReader} that reads documents following the same schema, and each
+ * name is only turned into a Java string the first time any of them sees it.
+ * A pool may be used by several threads at once.
+ *
+ * <p>The pool keeps its strings for as long as it or any parser using it is
+ * reachable. It stops taking new strings once it holds a few thousand, after
+ * which parsers intern anything else per document as usual.
+ */
+public final class ExpatInternPool {
+    static {
+        NativeSubsystems.ensureRegistered(NativeSubsystems.EXPAT);
+    }
+
+    /** Pointer to the native InternPool. */
+    /*package*/ final int pointer;
+
+    public ExpatInternPool() {
+        this.pointer = create();
+    }
+
+    @Override protected void finalize() throws Throwable {
+        try {
+            release(pointer);
+        } finally {
+            super.finalize();
+        }
+    }
+
+    private static native int create();
+
+    /**
+     * Releases this object's hold on the native pool, which is freed once no
+     * parser is using it either.
+     */
+    private static native void release(int pointer);
+}
@@ -16,6 +16,8 @@
 
 package org.apache.harmony.xml;
 
+import java.io.FileDescriptor;
+import java.io.FileInputStream;
 import java.io.IOException;
 import java.io.InputStream;
 import java.io.Reader;
@@ -25,6 +27,7 @@ import java.net.URLConnection;
 import java.util.logging.Level;
 import java.util.logging.Logger;
 import libcore.io.IoUtils;
+import libcore.util.NativeSubsystems;
 import org.xml.sax.Attributes;
 import org.xml.sax.ContentHandler;
 import org.xml.sax.DTDHandler;
@@ -43,6 +46,9 @@ import org.xml.sax.ext.LexicalHandler;
  * @see org.apache.harmony.xml.ExpatReader
  */
 class ExpatParser {
+    static {
+        NativeSubsystems.ensureRegistered(NativeSubsystems.EXPAT);
+    }
 
     private static final int BUFFER_SIZE = 8096; // in bytes
 
@@ -81,6 +87,18 @@ class ExpatParser {
      */
     /*package*/ ExpatParser(String encoding, ExpatReader xmlReader,
             boolean processNamespaces, String publicId, String systemId) {
+        this(encoding, xmlReader, processNamespaces, publicId, systemId, false);
+    }
+
+    /**
+     * Constructs a new parser with the specified encoding. In pull mode,
+     * Expat stops after each element or comment event it hands over, and
+     * the caller must {@link #resume} it until it has consumed its input
+     * before appending more.
+     */
+    /*package*/ ExpatParser(String encoding, ExpatReader xmlReader,
+            boolean processNamespaces, String publicId, String systemId,
+            boolean pullEvents) {
         this.publicId = publicId;
         this.systemId = systemId;
 
@@ -94,9 +112,13 @@ class ExpatParser {
          * workaround.
          */
         this.encoding = encoding == null ? DEFAULT_ENCODING : encoding;
+        ExpatInternPool internPool = xmlReader.getInternPool();
         this.pointer = initialize(
             this.encoding,
-            processNamespaces
+            processNamespaces,
+            internPool == null ? 0 : internPool.pointer,
+            xmlReader.isEventBatchingEnabled(),
+            pullEvents
         );
     }
 
@@ -115,9 +137,15 @@ class ExpatParser {
     /**
      * Initializes native resources.
      *
+     * @param internPoolPointer pointer to the native intern pool to share, or 0
+     * @param batchEvents true to deliver element, text and comment events
+     *  through {@link #dispatchEvents} rather than one call at a time
+     * @param pullEvents true to batch events and also suspend Expat after
+     *  each one other than text
      * @return the pointer to the native parser
      */
-    private native int initialize(String encoding, boolean namespacesEnabled);
+    private native int initialize(String encoding, boolean namespacesEnabled,
+            int internPoolPointer, boolean batchEvents, boolean pullEvents);
 
     /**
      * Called at the start of an element.
@@ -149,6 +177,7 @@ class ExpatParser {
             inStartElement = false;
             this.attributeCount = -1;
             this.attributePointer = 0;
+            this.attributes.clearCache();
         }
     }
 
@@ -174,6 +203,64 @@ class ExpatParser {
         }
     }
 
+    /*
+     * Event types in the batches passed to dispatchEvents. These must match
+     * the constants in the native EventBatch.
+     */
+    private static final int EVENT_START_ELEMENT = 0;
+    private static final int EVENT_END_ELEMENT = 1;
+    private static final int EVENT_TEXT = 2;
+    private static final int EVENT_COMMENT = 3;
+
+    /**
+     * Called with a batch of events when event batching is enabled. Each
+     * event is its type followed by its arguments: for elements, indices
+     * into {@code strings} for the names, and for start elements the
+     * attribute pointer and count too; for text and comments, an offset and
+     * length in {@code text}.
+     *
+     * @param events the encoded events
+     * @param eventsLength number of ints in use in {@code events}
+     * @param text character data for the text and comment events
+     * @param strings names used by the element events
+     */
+    /*package*/ void dispatchEvents(int[] events, int eventsLength, char[] text,
+            String[] strings) throws SAXException {
+        int i = 0;
+        while (i < eventsLength) {
+            switch (events[i]) {
+            case EVENT_START_ELEMENT:
+                startElement(strings[events[i + 1]], strings[events[i + 2]],
+                        strings[events[i + 3]], events[i + 4], events[i + 5]);
+                i += 6;
+                break;
+            case EVENT_END_ELEMENT:
+                endElement(strings[events[i + 1]], strings[events[i + 2]],
+                        strings[events[i + 3]]);
+                i += 4;
+                break;
+            case EVENT_TEXT: {
+                ContentHandler contentHandler = xmlReader.contentHandler;
+                if (contentHandler != null) {
+                    contentHandler.characters(text, events[i + 1], events[i + 2]);
+                }
+                i += 3;
+                break;
+            }
+            case EVENT_COMMENT: {
+                LexicalHandler lexicalHandler = xmlReader.lexicalHandler;
+                if (lexicalHandler != null) {
+                    lexicalHandler.comment(text, events[i + 1], events[i + 2]);
+                }
+                i += 3;
+                break;
+            }
+            default:
+                throw new AssertionError("unknown event " + events[i]);
+            }
+        }
+    }
+
     /*package*/ void startCdata() throws SAXException {
         LexicalHandler lexicalHandler = xmlReader.lexicalHandler;
         if (lexicalHandler != null) {
@@ -284,6 +371,15 @@ class ExpatParser {
             }
         }
 
+        ExpatEntityCache entityCache = xmlReader.getEntityCache();
+        if (entityCache != null) {
+            ExpatEntityCache.Entry entry = entityCache.get(publicId, systemId);
+            if (entry != null) {
+                parseCachedEntity(context, entry);
+                return;
+            }
+        }
+
         InputSource inputSource = entityResolver.resolveEntity(
                 publicId, systemId);
         if (inputSource == null) {
@@ -312,7 +408,34 @@ class ExpatParser {
                     pointer, inputSource.getPublicId(),
                     inputSource.getSystemId());
 
-            parseExternalEntity(entityParser, inputSource);
+            ExpatEntityCache.Entry entry
+                    = parseExternalEntity(entityParser, inputSource, entityCache);
+            if (entry != null) {
+                entityCache.put(publicId, systemId, entry);
+            }
+        } finally {
+            releaseParser(pointer);
+        }
+    }
+
+    /**
+     * Parses an external entity from the text cached for it.
+     */
+    private void parseCachedEntity(String context, ExpatEntityCache.Entry entry)
+            throws IOException, SAXException {
+        int pointer = createEntityParser(this.pointer, context);
+        try {
+            EntityParser entityParser = new EntityParser(entry.encoding,
+                    xmlReader, pointer, entry.publicId, entry.systemId);
+            if (entry.chars != null) {
+                entityParser.append("<externalEntity>");
+                entityParser.append(entry.chars, 0, entry.chars.length);
+                entityParser.append("</externalEntity>");
+            } else {
+                entityParser.append("<externalEntity>".getBytes(entry.encoding));
+                entityParser.append(entry.bytes);
+                entityParser.append("</externalEntity>".getBytes(entry.encoding));
+            }
         } finally {
             releaseParser(pointer);
         }
@@ -333,9 +456,14 @@ class ExpatParser {
 
     /**
      * Parses the the external entity provided by the input source.
+     *
+     * @param entityCache the cache to record the entity's text for, or null
+     * @return the entry to cache, or null if there's no cache or the entity
+     *  was too big for it
      */
-    private void parseExternalEntity(ExpatParser entityParser,
-            InputSource inputSource) throws IOException, SAXException {
+    private ExpatEntityCache.Entry parseExternalEntity(
+            ExpatParser entityParser, InputSource inputSource,
+            ExpatEntityCache entityCache) throws IOException, SAXException {
         /*
          * Expat complains if the external entity isn't wrapped with a root
          * element so we add one and ignore it later on during parsing.
@@ -344,6 +472,10 @@ class ExpatParser {
         // Try the character stream.
         Reader reader = inputSource.getCharacterStream();
         if (reader != null) {
+            ExpatEntityCache.RecordingReader recorder = null;
+            if (entityCache != null) {
+                reader = recorder = entityCache.record(reader);
+            }
             try {
                 entityParser.append("<externalEntity>");
                 entityParser.parseFragment(reader);
@@ -351,33 +483,27 @@ class ExpatParser {
             } finally {
                 IoUtils.closeQuietly(reader);
             }
-            return;
+            char[] chars = (recorder != null) ? recorder.toCharArray() : null;
+            return (chars != null) ? new ExpatEntityCache.Entry(
+                    entityParser.publicId, entityParser.systemId,
+                    entityParser.encoding, chars, null) : null;
         }
 
-        // Try the byte stream.
+        // Try the byte stream, then the system id.
         InputStream in = inputSource.getByteStream();
-        if (in != null) {
-            try {
-                entityParser.append("<externalEntity>"
-                        .getBytes(entityParser.encoding));
-                entityParser.parseFragment(in);
-                entityParser.append("</externalEntity>"
-                        .getBytes(entityParser.encoding));
-            } finally {
-                IoUtils.closeQuietly(in);
+        if (in == null) {
+            // Make sure we use the user-provided systemId.
+            String systemId = inputSource.getSystemId();
+            if (systemId == null) {
+                // TODO: We could just try our systemId here.
+                throw new ParseException("No input specified.", locator);
             }
-            return;
+            in = openUrl(systemId);
         }
-
-        // Make sure we use the user-provided systemId.
-        String systemId = inputSource.getSystemId();
-        if (systemId == null) {
-            // TODO: We could just try our systemId here.
-            throw new ParseException("No input specified.", locator);
+        ExpatEntityCache.RecordingInputStream recorder = null;
+        if (entityCache != null) {
+            in = recorder = entityCache.record(in);
         }
-
-        // Try the system id.
-        in = openUrl(systemId);
         try {
             entityParser.append("<externalEntity>"
                     .getBytes(entityParser.encoding));
@@ -387,6 +513,10 @@ class ExpatParser {
         } finally {
             IoUtils.closeQuietly(in);
         }
+        byte[] bytes = (recorder != null) ? recorder.toByteArray() : null;
+        return (bytes != null) ? new ExpatEntityCache.Entry(
+                entityParser.publicId, entityParser.systemId,
+                entityParser.encoding, null, bytes) : null;
     }
 
     /**
@@ -469,6 +599,33 @@ class ExpatParser {
     private native void appendBytes(int pointer, byte[] xml, int offset,
             int length) throws SAXException, ExpatException;
 
+    /**
+     * Lets a parser in pull mode carry on with the input it has already been
+     * given, after it stopped to deliver an event.
+     *
+     * @return false if the parser wasn't suspended, in which case it has
+     *  consumed all of its input and is ready for more
+     * @throws SAXException if an error occurs during parsing
+     */
+    /*package*/ boolean resume() throws SAXException {
+        try {
+            return resumeParser(this.pointer);
+        } catch (ExpatException e) {
+            throw new ParseException(e.getMessage(), this.locator);
+        }
+    }
+
+    private native boolean resumeParser(int pointer)
+            throws SAXException, ExpatException;
+
+    /**
+     * Parses everything from {@code fd}'s current offset to the end of the
+     * file, reading it natively so the bytes never pass through the Java
+     * heap.
+     */
+    private native void appendFd(int pointer, FileDescriptor fd)
+            throws IOException, SAXException, ExpatException;
+
     /**
      * Parses an XML document from the given input stream.
      */
@@ -510,6 +667,16 @@ class ExpatParser {
      */
     private void parseFragment(InputStream in)
             throws IOException, SAXException {
+        // A plain FileInputStream has no buffer of its own, so we can read its fd directly.
+        if (in.getClass() == FileInputStream.class) {
+            try {
+                appendFd(this.pointer, ((FileInputStream) in).getFD());
+            } catch (ExpatException e) {
+                throw new ParseException(e.getMessage(), this.locator);
+            }
+            return;
+        }
+
         byte[] buffer = new byte[BUFFER_SIZE];
         int length;
         while ((length = in.read(buffer)) != -1) {
@@ -561,6 +728,20 @@ class ExpatParser {
         }
     }
 
+    /**
+     * Hands the native parser back to be reset and reused by a later document
+     * with the same encoding and namespace setting. This parser can't be used
+     * afterwards; its locator reports -1 for the line and column.
+     */
+    /*package*/ synchronized void recycle() {
+        if (this.pointer != 0) {
+            recycleParser(this.pointer, this.encoding);
+            this.pointer = 0;
+        }
+    }
+
+    private native void recycleParser(int pointer, String encoding);
+
     /**
      * Releases all native objects.
      */
@@ -580,11 +761,22 @@ class ExpatParser {
         staticInitialize("");
     }
 
+    /**
+     * Returns the number of calls the native parser has made to this one so
+     * far, including those made while parsing external entities. This is
+     * for benchmarks.
+     */
+    /*package*/ int getUpcallCount() {
+        return getUpcallCount(this.pointer);
+    }
+
+    private static native int getUpcallCount(int pointer);
+
     /**
      * Gets the current line number within the XML file.
      */
     private int line() {
-        return line(this.pointer);
+        return this.pointer != 0 ? line(this.pointer) : -1;
     }
 
     private static native int line(int pointer);
@@ -593,7 +785,7 @@ class ExpatParser {
      * Gets the current column number within the XML file.
      */
     private int column() {
-        return column(this.pointer);
+        return this.pointer != 0 ? column(this.pointer) : -1;
     }
 
     private static native int column(int pointer);
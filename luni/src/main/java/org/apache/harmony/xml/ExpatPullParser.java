@@ -726,8 +726,9 @@ public class ExpatPullParser implements XmlPullParser {
             ExpatReader xmlReader = new ExpatReader();
             xmlReader.setContentHandler(new SaxHandler());
 
+            // Pull mode hands us about one event per pump, not a buffer's worth.
             this.parser = new ExpatParser(
-                    encoding, xmlReader, processNamespaces, null, null);
+                    encoding, xmlReader, processNamespaces, null, null, true);
         }
 
         /** Namespace stack builder. */
@@ -745,6 +746,16 @@ public class ExpatPullParser implements XmlPullParser {
                 return;
             }
 
+            // Expat may still have input left over from the last flush.
+            try {
+                if (parser.resume()) {
+                    return;
+                }
+            } catch (SAXException e) {
+                throw new XmlPullParserException(
+                        "Error parsing document.", ExpatPullParser.this, e);
+            }
+
             int length = buffer();
 
             // End of document.
@@ -753,6 +764,8 @@ public class ExpatPullParser implements XmlPullParser {
                 if (!relaxed) {
                     try {
                         parser.finish();
+                        while (parser.resume()) {
+                        }
                     } catch (SAXException e) {
                         throw new XmlPullParserException(
                             "Premature end of document.", ExpatPullParser.this, e);
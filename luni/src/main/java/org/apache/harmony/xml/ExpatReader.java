@@ -48,6 +48,10 @@ public class ExpatReader implements XMLReader {
 
     private boolean processNamespaces = true;
     private boolean processNamespacePrefixes = false;
+    private ExpatInternPool internPool;
+    private ExpatEntityCache entityCache;
+    private int lastUpcallCount;
+    private boolean eventBatchingEnabled = false;
 
     private static final String LEXICAL_HANDLER_PROPERTY
             = "http://xml.org/sax/properties/lexical-handler";
@@ -242,6 +246,84 @@ public class ExpatReader implements XMLReader {
         this.processNamespaces = processNamespaces;
     }
 
+    /**
+     * Returns the pool this reader interns names in, or null if each
+     * document gets strings of its own.
+     *
+     * @see #setInternPool(ExpatInternPool)
+     */
+    public ExpatInternPool getInternPool() {
+        return internPool;
+    }
+
+    /**
+     * Shares interned element names, attribute names and the like with every
+     * other reader using {@code internPool}, so that parsing many documents
+     * with the same vocabulary stops creating new strings for them. Set to
+     * null, the default, to intern per document.
+     */
+    public void setInternPool(ExpatInternPool internPool) {
+        this.internPool = internPool;
+    }
+
+    /**
+     * Returns the cache this reader takes external entities from, or null if
+     * it resolves and reads them afresh for each document.
+     *
+     * @see #setEntityCache(ExpatEntityCache)
+     */
+    public ExpatEntityCache getEntityCache() {
+        return entityCache;
+    }
+
+    /**
+     * Shares the text of external entities with every other reader using
+     * {@code entityCache}, so that documents referring to the same DTD
+     * needn't each resolve and read it. Once an entity is cached, the
+     * {@link EntityResolver} isn't consulted for it again. Set to null, the
+     * default, to resolve every reference.
+     */
+    public void setEntityCache(ExpatEntityCache entityCache) {
+        this.entityCache = entityCache;
+    }
+
+    /**
+     * Returns true if element, text and comment events are delivered in
+     * batches.
+     *
+     * @see #setEventBatchingEnabled(boolean)
+     */
+    public boolean isEventBatchingEnabled() {
+        return eventBatchingEnabled;
+    }
+
+    /**
+     * Enables or disables event batching. Disabled by default. When enabled,
+     * the parser collects element, text and comment events and calls the
+     * handlers for a whole batch of them at once, which is much faster for
+     * documents made of many small elements. Other events, such as
+     * processing instructions and namespace mappings, first deliver the
+     * batch so that handlers still see everything in document order.
+     *
+     * <p>Because a batch is delivered after the parser has moved past its
+     * events, the {@link org.xml.sax.Locator} reports where the parser has
+     * got to rather than the position of the event being handled. As SAX
+     * already requires, handlers must copy any characters they want to keep.
+     */
+    public void setEventBatchingEnabled(boolean eventBatchingEnabled) {
+        this.eventBatchingEnabled = eventBatchingEnabled;
+    }
+
+    /**
+     * Returns the number of calls from native code into the Java parser
+     * during the most recent parse, including any external entities. Event
+     * batching and interning both exist to bring this down; it's meant for
+     * benchmarks and tuning.
+     */
+    public int getLastUpcallCount() {
+        return lastUpcallCount;
+    }
+
     public void parse(InputSource input) throws IOException, SAXException {
         if (processNamespacePrefixes && processNamespaces) {
             /*
@@ -302,7 +384,12 @@ public class ExpatReader implements XMLReader {
                 publicId,
                 systemId
         );
-        parser.parseDocument(in);
+        try {
+            parser.parseDocument(in);
+        } finally {
+            lastUpcallCount = parser.getUpcallCount();
+            parser.recycle();
+        }
     }
 
     private void parse(InputStream in, String encoding, String publicId,
@@ -314,7 +401,12 @@ public class ExpatReader implements XMLReader {
                 publicId,
                 systemId
         );
-        parser.parseDocument(in);
+        try {
+            parser.parseDocument(in);
+        } finally {
+            lastUpcallCount = parser.getUpcallCount();
+            parser.recycle();
+        }
     }
 
     public void parse(String systemId) throws IOException, SAXException {
@@ -16,9 +16,14 @@
 
 package org.apache.harmony.xnet.provider.jsse;
 
+import java.io.IOException;
+import java.security.cert.Certificate;
+import java.security.cert.CertificateEncodingException;
+import java.security.cert.X509Certificate;
 import java.util.HashMap;
 import java.util.Map;
 import javax.net.ssl.SSLSession;
+import org.apache.harmony.security.provider.cert.X509CertImpl;
 
 /**
  * Caches client sessions. Indexes by host and port. Users are typically
@@ -75,6 +80,21 @@ public class ClientSessionContext extends AbstractSessionContext {
             return session;
         }
 
+        // Look in the native cache, which outlives this context's small Java cache.
+        byte[][][] peerCertificates = new byte[1][][];
+        int sslSessionNativePointer = NativeCrypto.SSL_SESSION_cache_get(sslCtxNativePointer,
+                host, port, peerCertificates);
+        if (sslSessionNativePointer != 0) {
+            session = toSession(sslSessionNativePointer, peerCertificates[0], host, port);
+            if (session != null && session.isValid()) {
+                super.putSession(session);
+                synchronized (sessionsByHostAndPort) {
+                    sessionsByHostAndPort.put(hostAndPortKey, session);
+                }
+                return session;
+            }
+        }
+
         // Look in persistent cache.
         if (persistentCache != null) {
             byte[] data = persistentCache.getSessionData(host, port);
@@ -108,6 +128,14 @@ public class ClientSessionContext extends AbstractSessionContext {
             sessionsByHostAndPort.put(hostAndPortKey, session);
         }
 
+        if (session instanceof OpenSSLSessionImpl) {
+            byte[][] peerCertificates = encodePeerCertificates(session);
+            if (peerCertificates != null) {
+                NativeCrypto.SSL_SESSION_cache_put(sslCtxNativePointer, host, port,
+                        ((OpenSSLSessionImpl) session).sslSessionNativePointer, peerCertificates);
+            }
+        }
+
         // TODO: This in a background thread.
         if (persistentCache != null) {
             byte[] data = toBytes(session);
@@ -117,6 +145,59 @@ public class ClientSessionContext extends AbstractSessionContext {
         }
     }
 
+    @Override
+    public SSLSession getSession(byte[] sessionId) {
+        SSLSession session = super.getSession(sessionId);
+        if (session != null) {
+            return session;
+        }
+        byte[][][] peerCertificates = new byte[1][][];
+        int sslSessionNativePointer = NativeCrypto.SSL_SESSION_cache_get_by_id(
+                sslCtxNativePointer, sessionId, peerCertificates);
+        if (sslSessionNativePointer == 0) {
+            return null;
+        }
+        // The native cache doesn't know which host this session was for.
+        session = toSession(sslSessionNativePointer, peerCertificates[0], null, -1);
+        return (session != null && session.isValid()) ? session : null;
+    }
+
+    /**
+     * Wraps a session from the native cache, taking ownership of the
+     * reference to it.
+     */
+    private SSLSession toSession(int sslSessionNativePointer, byte[][] peerCertificates,
+            String host, int port) {
+        try {
+            X509Certificate[] certs = new X509Certificate[peerCertificates.length];
+            for (int i = 0; i < peerCertificates.length; i++) {
+                certs[i] = new X509CertImpl(peerCertificates[i]);
+            }
+            return new OpenSSLSessionImpl(sslSessionNativePointer, null, certs, host, port, this);
+        } catch (IOException e) {
+            log(e);
+            NativeCrypto.SSL_SESSION_free(sslSessionNativePointer);
+            return null;
+        }
+    }
+
+    private byte[][] encodePeerCertificates(SSLSession session) {
+        try {
+            Certificate[] certs = session.getPeerCertificates();
+            byte[][] result = new byte[certs.length][];
+            for (int i = 0; i < certs.length; i++) {
+                result[i] = certs[i].getEncoded();
+            }
+            return result;
+        } catch (CertificateEncodingException e) {
+            log(e);
+            return null;
+        } catch (IOException e) {
+            // No peer certificates: nothing we could resume with.
+            return null;
+        }
+    }
+
     static class HostAndPort {
         final String host;
         final int port;
@@ -33,11 +33,15 @@ import java.util.LinkedHashMap;
 import java.util.List;
 import java.util.Map;
 import javax.net.ssl.SSLException;
+import libcore.util.NativeSubsystems;
 
 /**
  * Provides the Java side of our JNI glue for OpenSSL.
  */
 public final class NativeCrypto {
+    static {
+        NativeSubsystems.ensureRegistered(NativeSubsystems.CRYPTO);
+    }
 
     // --- OpenSSL library initialization --------------------------------------
     static {
@@ -46,6 +50,20 @@ public final class NativeCrypto {
 
     private native static void clinit();
 
+    /**
+     * Turns on or off counting of acquisitions and contended waits for each
+     * of OpenSSL's locks. Counting is off by default.
+     */
+    public static native void CRYPTO_set_lock_stats_enabled(boolean enabled);
+
+    /**
+     * Returns two counts per OpenSSL lock id, at index {@code 2 * id}: the
+     * number of acquisitions and the number of those that had to wait.
+     */
+    public static native long[] CRYPTO_get_lock_stats();
+
+    public static native String CRYPTO_get_lock_name(int lockId);
+
     // --- DSA/RSA public/private key handling functions -----------------------
 
     public static native int EVP_PKEY_new_DSA(byte[] p, byte[] q, byte[] g,
@@ -69,6 +87,20 @@ public final class NativeCrypto {
 
     public static native void EVP_DigestUpdate(int ctx, byte[] buffer, int offset, int length);
 
+    /**
+     * Like {@link #EVP_DigestUpdate}, but reads {@code length} bytes directly
+     * from native memory at {@code address}, such as a direct buffer.
+     */
+    public static native void EVP_DigestUpdateDirect(int ctx, int address, int length);
+
+    /**
+     * Computes the digest of each {@code (offsets[i], lengths[i])} slice of
+     * {@code buffer} in a single call, writing the i'th digest at
+     * {@code i * digestSize} in {@code out}. Returns the digest size.
+     */
+    public static native int EVP_Digest_batch(String algorithm, byte[] buffer,
+                                              int[] offsets, int[] lengths, byte[] out);
+
     public static native int EVP_DigestFinal(int ctx, byte[] hash, int offset);
 
     public static native int EVP_MD_CTX_size(int ctx);
@@ -261,6 +293,16 @@ public final class NativeCrypto {
 
     public static native int SSL_CTX_new();
 
+    /**
+     * Configures the background pool of ephemeral RSA keys and DH parameters
+     * handshakes use. Pooled RSA keys are replaced every {@code
+     * rotationIntervalSeconds}; 0 turns the pool off so each handshake
+     * generates its own, as before. {@code keyLengths}, if non-null, names key
+     * lengths to start generating for now rather than on first use.
+     */
+    public static native void SSL_ephemeral_key_pool_configure(int rotationIntervalSeconds,
+                                                               int[] keyLengths);
+
     public static String[] getDefaultCipherSuites() {
         return new String[] {
             "SSL_RSA_WITH_RC4_128_MD5",
@@ -524,6 +566,32 @@ public final class NativeCrypto {
                                               boolean client_mode)
         throws SSLException, SocketTimeoutException, CertificateException;
 
+    /*
+     * Results of SSL_do_handshake_nonblocking. See the OpenSSL ssl.h header file.
+     */
+    public static final int SSL_ERROR_NONE =       0;
+    public static final int SSL_ERROR_WANT_READ =  2;
+    public static final int SSL_ERROR_WANT_WRITE = 3;
+
+    /**
+     * Advances the handshake as far as it can go without blocking. Returns
+     * SSL_ERROR_NONE when the handshake is complete, after which
+     * {@link #SSL_get1_session} returns the negotiated session. Otherwise
+     * returns SSL_ERROR_WANT_READ or SSL_ERROR_WANT_WRITE, and the caller
+     * should call again once the socket is readable or writable. The same
+     * {@code client_mode} must be passed on every call for one handshake.
+     */
+    public static native int SSL_do_handshake_nonblocking(int sslNativePointer,
+                                                          FileDescriptor fd,
+                                                          SSLHandshakeCallbacks shc,
+                                                          boolean client_mode)
+        throws SSLException, CertificateException;
+
+    /**
+     * Returns a new reference to the negotiated session, or 0 if none.
+     */
+    public static native int SSL_get1_session(int sslNativePointer);
+
     /**
      * Currently only intended for forcing renegotiation for testing.
      * Not used within OpenSSLSocketImpl.
@@ -540,6 +608,13 @@ public final class NativeCrypto {
      */
     public static native byte[][] SSL_get_peer_cert_chain(int sslNativePointer);
 
+    /**
+     * Returns the {@code algorithm} digest, e.g. "sha1", of each of the peer's
+     * ASN.1 DER encoded X509 certificates, leaf first.
+     */
+    public static native byte[][] SSL_get_peer_cert_fingerprints(int sslNativePointer,
+                                                                 String algorithm);
+
     /**
      * Reads with the native SSL_read function from the encrypted data stream
      * @return -1 if error or the end of the stream is reached.
@@ -554,6 +629,17 @@ public final class NativeCrypto {
                                       byte[] b, int off, int len, int timeout)
         throws IOException;
 
+    /**
+     * Reads with the native SSL_read function into {@code len} bytes of
+     * native memory at {@code address}, such as a direct ByteBuffer's.
+     * @return -1 if error or the end of the stream is reached.
+     */
+    public static native int SSL_read_direct(int sslNativePointer,
+                                             FileDescriptor fd,
+                                             SSLHandshakeCallbacks shc,
+                                             int address, int len, int timeout)
+        throws IOException;
+
     /**
      * Writes with the native SSL_write function to the encrypted data stream.
      */
@@ -567,6 +653,27 @@ public final class NativeCrypto {
                                         byte[] b, int off, int len)
         throws IOException;
 
+    /**
+     * Writes {@code len} bytes of native memory at {@code address} with the
+     * native SSL_write function.
+     */
+    public static native void SSL_write_direct(int sslNativePointer,
+                                               FileDescriptor fd,
+                                               SSLHandshakeCallbacks shc,
+                                               int address, int len)
+        throws IOException;
+
+    /**
+     * Writes {@code lengths[i]} bytes of each {@code buffers[i]}, starting at
+     * {@code offsets[i]}, with the native SSL_write function. The buffers are
+     * packed into as few full-sized TLS records as possible.
+     */
+    public static native void SSL_write_gathering(int sslNativePointer,
+                                                  FileDescriptor fd,
+                                                  SSLHandshakeCallbacks shc,
+                                                  byte[][] buffers, int[] offsets, int[] lengths)
+        throws IOException;
+
     public static native void SSL_interrupt(int sslNativePointer) throws IOException;
     public static native void SSL_shutdown(int sslNativePointer,
                                            FileDescriptor fd,
@@ -591,6 +698,42 @@ public final class NativeCrypto {
 
     public static native int d2i_SSL_SESSION(byte[] data);
 
+    /**
+     * Adds a session to the native session cache for the given SSL_CTX, under
+     * both the host and port and the session's id. Only the same SSL_CTX can
+     * get the session back, since no other has vetted the peer. The cache
+     * takes its own reference to the session. {@code peerCertificates} holds
+     * the DER encoding of each of the peer's certificates.
+     */
+    public static native void SSL_SESSION_cache_put(int sslCtxNativePointer,
+                                                    String host, int port,
+                                                    int sslSessionNativePointer,
+                                                    byte[][] peerCertificates);
+
+    /**
+     * Returns a new reference to the native session the SSL_CTX cached for a
+     * host and port, or 0 if there's no such unexpired session. The
+     * DER-encoded peer certificates are returned in
+     * {@code peerCertificatesOut[0]}. The caller must release the session
+     * with {@link #SSL_SESSION_free}.
+     */
+    public static native int SSL_SESSION_cache_get(int sslCtxNativePointer,
+                                                   String host, int port,
+                                                   byte[][][] peerCertificatesOut);
+
+    /**
+     * Like {@link #SSL_SESSION_cache_get}, but finds the session by its id.
+     */
+    public static native int SSL_SESSION_cache_get_by_id(int sslCtxNativePointer,
+                                                         byte[] sessionId,
+                                                         byte[][][] peerCertificatesOut);
+
+    /**
+     * Sets the number of sessions the native session cache holds before it
+     * evicts the least recently used. 0 disables the cache.
+     */
+    public static native void SSL_SESSION_cache_set_max_size(int maxSize);
+
     /**
      * A collection of callbacks from the native OpenSSL code that are
      * related to the SSL handshake initiated by SSL_do_handshake.
@@ -16,6 +16,8 @@
 
 package org.apache.harmony.xnet.provider.jsse;
 
+import java.nio.ByteBuffer;
+import java.nio.NioUtils;
 import java.security.MessageDigest;
 import java.security.NoSuchAlgorithmException;
 
@@ -88,6 +90,23 @@ public class OpenSSLMessageDigestJDK extends MessageDigest implements Cloneable
         NativeCrypto.EVP_DigestUpdate(ctx, input, offset, len);
     }
 
+    @Override
+    protected void engineUpdate(ByteBuffer input) {
+        // Hash direct buffers in place rather than copying them to the heap first.
+        if (!input.isDirect()) {
+            super.engineUpdate(input);
+            return;
+        }
+        int position = input.position();
+        int remaining = input.remaining();
+        if (remaining == 0) {
+            return;
+        }
+        int address = NioUtils.getDirectBufferAddress(input);
+        NativeCrypto.EVP_DigestUpdateDirect(ctx, address + position, remaining);
+        input.position(position + remaining);
+    }
+
     public Object clone() throws CloneNotSupportedException {
         OpenSSLMessageDigestJDK d = (OpenSSLMessageDigestJDK) super.clone();
         d.ctx = NativeCrypto.EVP_MD_CTX_copy(ctx);
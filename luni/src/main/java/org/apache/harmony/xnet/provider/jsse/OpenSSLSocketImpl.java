@@ -848,6 +848,29 @@ public class OpenSSLSocketImpl
         }
     }
 
+    /**
+     * Writes {@code lengths[i]} bytes of each {@code buffers[i]}, starting at
+     * {@code offsets[i]}. Unlike a series of writes to the output stream, the
+     * data is packed into as few TLS records as possible, so many small buffers
+     * don't each cost a record and a system call.
+     */
+    public void writeGathering(byte[][] buffers, int[] offsets, int[] lengths)
+            throws IOException {
+        if (buffers == null || offsets == null || lengths == null) {
+            throw new NullPointerException();
+        }
+        if (offsets.length < buffers.length || lengths.length < buffers.length) {
+            throw new IndexOutOfBoundsException();
+        }
+        startHandshake(false);
+        BlockGuard.getThreadPolicy().onNetwork();
+        synchronized (writeLock) {
+            checkOpen();
+            NativeCrypto.SSL_write_gathering(sslNativePointer, fd, this,
+                                             buffers, offsets, lengths);
+        }
+    }
+
 
     /**
      * The SSL session used by this connection is returned. The SSL session
@@ -24,15 +24,28 @@
 #include <string.h>
 
 /**
- * We use an intrusive doubly-linked list to keep track of blocked threads.
+ * We use intrusive doubly-linked lists to keep track of blocked threads.
  * This gives us O(1) insertion and removal, and means we don't need to do any allocation.
  * (The objects themselves are stack-allocated.)
- * Waking potentially-blocked threads when a socket is closed is O(n) in the total number of
- * blocked threads (not the number of threads actually blocked on the socket in question).
- * For now at least, this seems like a good compromise for Android.
+ *
+ * Rather than one global list, blocked threads are spread across a fixed number of stripes
+ * keyed by file descriptor, each with its own lock. Unrelated sockets rarely share a stripe,
+ * so threads blocking and unblocking on different sockets don't contend with one another,
+ * and waking the threads blocked on a socket is O(n) in the number of threads blocked on
+ * the sockets in its stripe (in practice, the threads actually blocked on that socket).
  */
-static pthread_mutex_t blockedThreadListMutex = PTHREAD_MUTEX_INITIALIZER;
-static AsynchronousSocketCloseMonitor* blockedThreadList = NULL;
+static const size_t STRIPE_COUNT = 64; // Must be a power of two.
+
+struct BlockedThreadStripe {
+    pthread_mutex_t mutex;
+    AsynchronousSocketCloseMonitor* list;
+};
+
+static BlockedThreadStripe blockedThreadStripes[STRIPE_COUNT];
+
+static BlockedThreadStripe& stripeFor(int fd) {
+    return blockedThreadStripes[static_cast<unsigned>(fd) & (STRIPE_COUNT - 1)];
+}
 
 /**
  * The specific signal chosen here is arbitrary.
@@ -44,6 +57,11 @@ static void blockedThreadSignalHandler(int /*signal*/) {
 }
 
 void AsynchronousSocketCloseMonitor::init() {
+    for (size_t i = 0; i < STRIPE_COUNT; ++i) {
+        pthread_mutex_init(&blockedThreadStripes[i].mutex, NULL);
+        blockedThreadStripes[i].list = NULL;
+    }
+
     // Ensure that the signal we send interrupts system calls but doesn't kill threads.
     // Using sigaction(2) lets us ensure that the SA_RESTART flag is not set.
     // (The whole reason we're sending this signal is to unblock system calls!)
@@ -58,8 +76,9 @@ void AsynchronousSocketCloseMonitor::init() {
 }
 
 void AsynchronousSocketCloseMonitor::signalBlockedThreads(int fd) {
-    ScopedPthreadMutexLock lock(&blockedThreadListMutex);
-    for (AsynchronousSocketCloseMonitor* it = blockedThreadList; it != NULL; it = it->mNext) {
+    BlockedThreadStripe& stripe(stripeFor(fd));
+    ScopedPthreadMutexLock lock(&stripe.mutex);
+    for (AsynchronousSocketCloseMonitor* it = stripe.list; it != NULL; it = it->mNext) {
         if (it->mFd == fd) {
             pthread_kill(it->mThread, BLOCKED_THREAD_SIGNAL);
             // Keep going, because there may be more than one thread...
@@ -68,27 +87,29 @@ void AsynchronousSocketCloseMonitor::signalBlockedThreads(int fd) {
 }
 
 AsynchronousSocketCloseMonitor::AsynchronousSocketCloseMonitor(int fd) {
-    ScopedPthreadMutexLock lock(&blockedThreadListMutex);
+    BlockedThreadStripe& stripe(stripeFor(fd));
+    ScopedPthreadMutexLock lock(&stripe.mutex);
     // Who are we, and what are we waiting for?
     mThread = pthread_self();
     mFd = fd;
-    // Insert ourselves at the head of the intrusive doubly-linked list...
+    // Insert ourselves at the head of our stripe's intrusive doubly-linked list...
     mPrev = NULL;
-    mNext = blockedThreadList;
+    mNext = stripe.list;
     if (mNext != NULL) {
         mNext->mPrev = this;
     }
-    blockedThreadList = this;
+    stripe.list = this;
 }
 
 AsynchronousSocketCloseMonitor::~AsynchronousSocketCloseMonitor() {
-    ScopedPthreadMutexLock lock(&blockedThreadListMutex);
-    // Unlink ourselves from the intrusive doubly-linked list...
+    BlockedThreadStripe& stripe(stripeFor(mFd));
+    ScopedPthreadMutexLock lock(&stripe.mutex);
+    // Unlink ourselves from our stripe's intrusive doubly-linked list...
     if (mNext != NULL) {
         mNext->mPrev = mPrev;
     }
     if (mPrev == NULL) {
-        blockedThreadList = mNext;
+        stripe.list = mNext;
     } else {
         mPrev->mNext = mNext;
     }
@@ -21,8 +21,11 @@
 #include "JniConstants.h"
 #include "ScopedJavaUnicodeString.h"
 #include "ScopedLocalRef.h"
+#include "ScopedPrimitiveArray.h"
+#include "ScopedPthreadMutexLock.h"
 #include "ScopedUtfChars.h"
 #include "UniquePtr.h"
+#include "Utf8.h"
 #include "cutils/log.h"
 #include "unicode/calendar.h"
 #include "unicode/datefmt.h"
@@ -33,6 +36,7 @@
 #include "unicode/locid.h"
 #include "unicode/numfmt.h"
 #include "unicode/strenum.h"
+#include "unicode/uchar.h"
 #include "unicode/ubrk.h"
 #include "unicode/ucal.h"
 #include "unicode/uclean.h"
@@ -40,12 +44,26 @@
 #include "unicode/ucurr.h"
 #include "unicode/udat.h"
 #include "unicode/ustring.h"
+#include "unicode/utf16.h"
 #include "ureslocs.h"
 #include "valueOf.h"
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <sys/time.h>
+#include <map>
+#include <string>
+#include <vector>
+
+// As in Utf8.cpp, we pick the vector kernels at compile time for the ABI we're built for.
+#if defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define HAVE_NEON_CASE
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define HAVE_SSE2_CASE
+#endif
 
 class ScopedResourceBundle {
 public:
@@ -62,6 +80,12 @@ public:
         return mBundle;
     }
 
+    UResourceBundle* release() {
+        UResourceBundle* bundle = mBundle;
+        mBundle = NULL;
+        return bundle;
+    }
+
 private:
     UResourceBundle* mBundle;
 
@@ -407,39 +431,81 @@ static void setCharField(JNIEnv* env, jobject obj, const char* fieldName, UResou
     }
 }
 
-static jboolean ICU_initLocaleDataImpl(JNIEnv* env, jclass, jstring locale, jobject localeData) {
-    ScopedUtfChars localeName(env, locale);
+/*
+ * Opening a locale's resource bundles means ICU walking the locale's fallback chain, and
+ * LocaleData asks for each locale several times over as it loads each part of its data. Instead
+ * we open each locale's root and gregorian calendar bundles once and keep them. They're only ever
+ * read through ICU's const API, so any number of threads can share them. Like LocaleData's own
+ * cache, this only grows, but there are only so many locales.
+ */
+struct LocaleBundles {
+    UResourceBundle* root;
+    UResourceBundle* gregorian;
+};
+typedef std::map<std::string, LocaleBundles> LocaleBundlesCache;
+static LocaleBundlesCache gLocaleBundles;
+static pthread_mutex_t gLocaleBundlesMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static bool getLocaleBundles(const char* localeName, LocaleBundles* result) {
+    ScopedPthreadMutexLock lock(&gLocaleBundlesMutex);
+    LocaleBundlesCache::iterator it = gLocaleBundles.find(localeName);
+    if (it != gLocaleBundles.end()) {
+        *result = it->second;
+        return true;
+    }
+
     UErrorCode status = U_ZERO_ERROR;
-    ScopedResourceBundle root(ures_open(NULL, localeName.c_str(), &status));
+    ScopedResourceBundle root(ures_open(NULL, localeName, &status));
     if (U_FAILURE(status)) {
         ALOGE("Error getting ICU resource bundle: %s", u_errorName(status));
-        status = U_ZERO_ERROR;
-        return JNI_FALSE;
+        return false;
     }
 
     ScopedResourceBundle calendar(ures_getByKey(root.get(), "calendar", NULL, &status));
     if (U_FAILURE(status)) {
         ALOGE("Error getting ICU calendar resource bundle: %s", u_errorName(status));
-        return JNI_FALSE;
+        return false;
     }
 
-    ScopedResourceBundle gregorian(ures_getByKey(calendar.get(), "gregorian", NULL, &status));
+    UResourceBundle* gregorian = ures_getByKey(calendar.get(), "gregorian", NULL, &status);
     if (U_FAILURE(status)) {
         ALOGE("Error getting ICU gregorian resource bundle: %s", u_errorName(status));
-        return JNI_FALSE;
+        ures_close(gregorian);
+        return false;
     }
 
+    result->root = root.release();
+    result->gregorian = gregorian;
+    gLocaleBundles[localeName] = *result;
+    return true;
+}
+
+// The parts of a LocaleData that can be loaded separately. These must be kept in sync with the
+// SECTION_ constants in LocaleData.java.
+enum LocaleDataSection {
+    SECTION_CALENDAR = 1,
+    SECTION_DATE_FORMAT_SYMBOLS = 2,
+    SECTION_DATE_TIME_PATTERNS = 4,
+    SECTION_NUMBER_SYMBOLS = 8,
+    SECTION_CURRENCY = 16,
+    SECTION_NUMBER_PATTERNS = 32,
+};
+
+static void initCalendar(JNIEnv* env, jobject localeData, UResourceBundle* gregorian) {
     int firstDayVals[] = { 0, 0 };
-    if (getDayIntVector(env, gregorian.get(), firstDayVals)) {
+    if (getDayIntVector(env, gregorian, firstDayVals)) {
         setIntegerField(env, localeData, "firstDayOfWeek", firstDayVals[0]);
         setIntegerField(env, localeData, "minimalDaysInFirstWeek", firstDayVals[1]);
     }
+}
 
-    setStringArrayField(env, localeData, "amPm", getAmPmMarkers(env, gregorian.get()));
-    setStringArrayField(env, localeData, "eras", getEras(env, gregorian.get()));
+static void initDateFormatSymbols(JNIEnv* env, jobject localeData, UResourceBundle* gregorian) {
+    setStringArrayField(env, localeData, "amPm", getAmPmMarkers(env, gregorian));
+    setStringArrayField(env, localeData, "eras", getEras(env, gregorian));
 
-    ScopedResourceBundle dayNames(ures_getByKey(gregorian.get(), "dayNames", NULL, &status));
-    ScopedResourceBundle monthNames(ures_getByKey(gregorian.get(), "monthNames", NULL, &status));
+    UErrorCode status = U_ZERO_ERROR;
+    ScopedResourceBundle dayNames(ures_getByKey(gregorian, "dayNames", NULL, &status));
+    ScopedResourceBundle monthNames(ures_getByKey(gregorian, "monthNames", NULL, &status));
 
     // Get the regular month and weekday names.
     jobjectArray longMonthNames = getNames(env, monthNames.get(), true, REGULAR, LONG);
@@ -475,8 +541,11 @@ static jboolean ICU_initLocaleDataImpl(JNIEnv* env, jclass, jstring locale, jobj
     setStringArrayField(env, localeData, "shortStandAloneMonthNames", shortStandAloneMonthNames);
     setStringArrayField(env, localeData, "longStandAloneWeekdayNames", longStandAloneWeekdayNames);
     setStringArrayField(env, localeData, "shortStandAloneWeekdayNames", shortStandAloneWeekdayNames);
+}
 
-    ScopedResourceBundle dateTimePatterns(ures_getByKey(gregorian.get(), "DateTimePatterns", NULL, &status));
+static void initDateTimePatterns(JNIEnv* env, jobject localeData, UResourceBundle* gregorian) {
+    UErrorCode status = U_ZERO_ERROR;
+    ScopedResourceBundle dateTimePatterns(ures_getByKey(gregorian, "DateTimePatterns", NULL, &status));
     if (U_SUCCESS(status)) {
         setStringField(env, localeData, "fullTimeFormat", dateTimePatterns.get(), 0);
         setStringField(env, localeData, "longTimeFormat", dateTimePatterns.get(), 1);
@@ -487,9 +556,11 @@ static jboolean ICU_initLocaleDataImpl(JNIEnv* env, jclass, jstring locale, jobj
         setStringField(env, localeData, "mediumDateFormat", dateTimePatterns.get(), 6);
         setStringField(env, localeData, "shortDateFormat", dateTimePatterns.get(), 7);
     }
-    status = U_ZERO_ERROR;
+}
 
-    ScopedResourceBundle numberElements(ures_getByKey(root.get(), "NumberElements", NULL, &status));
+static void initNumberSymbols(JNIEnv* env, jobject localeData, UResourceBundle* root) {
+    UErrorCode status = U_ZERO_ERROR;
+    ScopedResourceBundle numberElements(ures_getByKey(root, "NumberElements", NULL, &status));
     if (U_SUCCESS(status) && ures_getSize(numberElements.get()) >= 11) {
         setCharField(env, localeData, "zeroDigit", numberElements.get(), 4);
         setCharField(env, localeData, "digit", numberElements.get(), 5);
@@ -504,8 +575,9 @@ static jboolean ICU_initLocaleDataImpl(JNIEnv* env, jclass, jstring locale, jobj
         setStringField(env, localeData, "infinity", numberElements.get(), 9);
         setStringField(env, localeData, "NaN", numberElements.get(), 10);
     }
-    status = U_ZERO_ERROR;
+}
 
+static void initCurrency(JNIEnv* env, jobject localeData, jstring locale) {
     jstring internationalCurrencySymbol = getIntCurrencyCode(env, locale);
     jstring currencySymbol = NULL;
     if (internationalCurrencySymbol != NULL) {
@@ -519,18 +591,163 @@ static jboolean ICU_initLocaleDataImpl(JNIEnv* env, jclass, jstring locale, jobj
     }
     setStringField(env, localeData, "currencySymbol", currencySymbol);
     setStringField(env, localeData, "internationalCurrencySymbol", internationalCurrencySymbol);
+}
 
-    ScopedResourceBundle numberPatterns(ures_getByKey(root.get(), "NumberPatterns", NULL, &status));
+static void initNumberPatterns(JNIEnv* env, jobject localeData, UResourceBundle* root) {
+    UErrorCode status = U_ZERO_ERROR;
+    ScopedResourceBundle numberPatterns(ures_getByKey(root, "NumberPatterns", NULL, &status));
     if (U_SUCCESS(status) && ures_getSize(numberPatterns.get()) >= 3) {
         setStringField(env, localeData, "numberPattern", numberPatterns.get(), 0);
         setStringField(env, localeData, "currencyPattern", numberPatterns.get(), 1);
         setStringField(env, localeData, "percentPattern", numberPatterns.get(), 2);
     }
+}
 
+static jboolean ICU_initLocaleDataImpl(JNIEnv* env, jclass, jstring locale, jint sections, jobject localeData) {
+    ScopedUtfChars localeName(env, locale);
+    if (localeName.c_str() == NULL) {
+        return JNI_FALSE;
+    }
+    LocaleBundles bundles;
+    if (!getLocaleBundles(localeName.c_str(), &bundles)) {
+        return JNI_FALSE;
+    }
+
+    if ((sections & SECTION_CALENDAR) != 0) {
+        initCalendar(env, localeData, bundles.gregorian);
+    }
+    if ((sections & SECTION_DATE_FORMAT_SYMBOLS) != 0) {
+        initDateFormatSymbols(env, localeData, bundles.gregorian);
+    }
+    if ((sections & SECTION_DATE_TIME_PATTERNS) != 0) {
+        initDateTimePatterns(env, localeData, bundles.gregorian);
+    }
+    if ((sections & SECTION_NUMBER_SYMBOLS) != 0) {
+        initNumberSymbols(env, localeData, bundles.root);
+    }
+    if ((sections & SECTION_CURRENCY) != 0) {
+        initCurrency(env, localeData, locale);
+    }
+    if ((sections & SECTION_NUMBER_PATTERNS) != 0) {
+        initNumberPatterns(env, localeData, bundles.root);
+    }
     return JNI_TRUE;
 }
 
+/**
+ * Returns the index of the first char in src[i..length) that's between 'lo' and 'hi' inclusive, or
+ * 'length' if there's none. Looks at 8 chars at a time where the CPU allows.
+ */
+static size_t findCharInRange(const jchar* src, size_t i, size_t length, jchar lo, jchar hi) {
+#if defined(HAVE_NEON_CASE)
+    const uint16x8_t los = vdupq_n_u16(lo);
+    const uint16x8_t his = vdupq_n_u16(hi);
+    for (; i + 8 <= length; i += 8) {
+        uint16x8_t v = vld1q_u16(src + i);
+        uint64x2_t hits = vreinterpretq_u64_u16(vandq_u16(vcgeq_u16(v, los), vcleq_u16(v, his)));
+        if ((vgetq_lane_u64(hits, 0) | vgetq_lane_u64(hits, 1)) != 0) {
+            break;
+        }
+    }
+#elif defined(HAVE_SSE2_CASE)
+    // SSE2 only has signed comparisons, which is fine for the ASCII ranges we're given.
+    const __m128i los = _mm_set1_epi16(lo - 1);
+    const __m128i his = _mm_set1_epi16(hi + 1);
+    for (; i + 8 <= length; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        if (_mm_movemask_epi8(_mm_and_si128(_mm_cmpgt_epi16(v, los), _mm_cmplt_epi16(v, his))) != 0) {
+            break;
+        }
+    }
+#endif
+    for (; i < length && (src[i] < lo || src[i] > hi); ++i) {
+    }
+    return i;
+}
+
+/**
+ * Copies src[i..length) to dst[i..length), flipping the case of the ASCII letters between 'lo'
+ * and 'hi'. Eight chars at a time where the CPU allows.
+ */
+static void flipAsciiCase(const jchar* src, jchar* dst, size_t i, size_t length, jchar lo, jchar hi) {
+#if defined(HAVE_NEON_CASE)
+    const uint16x8_t los = vdupq_n_u16(lo);
+    const uint16x8_t his = vdupq_n_u16(hi);
+    const uint16x8_t caseBits = vdupq_n_u16(0x20);
+    for (; i + 8 <= length; i += 8) {
+        uint16x8_t v = vld1q_u16(src + i);
+        uint16x8_t letters = vandq_u16(vcgeq_u16(v, los), vcleq_u16(v, his));
+        vst1q_u16(dst + i, veorq_u16(v, vandq_u16(letters, caseBits)));
+    }
+#elif defined(HAVE_SSE2_CASE)
+    const __m128i los = _mm_set1_epi16(lo - 1);
+    const __m128i his = _mm_set1_epi16(hi + 1);
+    const __m128i caseBits = _mm_set1_epi16(0x20);
+    for (; i + 8 <= length; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i letters = _mm_and_si128(_mm_cmpgt_epi16(v, los), _mm_cmplt_epi16(v, his));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                _mm_xor_si128(v, _mm_and_si128(letters, caseBits)));
+    }
+#endif
+    for (; i < length; ++i) {
+        jchar ch = src[i];
+        dst[i] = (ch >= lo && ch <= hi) ? (ch ^ 0x20) : ch;
+    }
+}
+
+static bool isLanguage(const char* localeName, const char* language) {
+    size_t length = strlen(language);
+    return strncmp(localeName, language, length) == 0 &&
+            (localeName[length] == '\0' || localeName[length] == '_');
+}
+
+/**
+ * Maps the case of an all-ASCII string without going through ICU, flipping the letters between
+ * 'lo' and 'hi'. Sets '*result', which is 'javaString' itself if nothing changed, and returns
+ * true; returns false if the string needs ICU's help. That's any string with non-ASCII chars in
+ * it, and in Turkish and Azeri, any string containing 'turkicChar', the 'I' or 'i' that those
+ * languages map to a dotless or dotted i. Lithuanian's special cases all involve combining marks,
+ * which aren't ASCII.
+ */
+static bool mapAsciiCase(JNIEnv* env, jstring javaString, jstring localeName, jchar lo, jchar hi,
+        jchar turkicChar, jstring* result) {
+    if (javaString == NULL || localeName == NULL) {
+        return false;
+    }
+    const jchar* chars = env->GetStringChars(javaString, NULL);
+    if (chars == NULL) {
+        return false;
+    }
+    size_t length = env->GetStringLength(javaString);
+    bool handled = false;
+    size_t first;
+    if (asciiCharCount(chars, length) != length) {
+        // Leave it to ICU.
+    } else if ((first = findCharInRange(chars, 0, length, lo, hi)) == length) {
+        *result = javaString;
+        handled = true;
+    } else {
+        ScopedUtfChars localeChars(env, localeName);
+        bool turkic = localeChars.c_str() != NULL &&
+                (isLanguage(localeChars.c_str(), "tr") || isLanguage(localeChars.c_str(), "az"));
+        if (!turkic || findCharInRange(chars, first, length, turkicChar, turkicChar) == length) {
+            std::vector<jchar> mapped(length);
+            memcpy(&mapped[0], chars, first * sizeof(jchar));
+            flipAsciiCase(chars, &mapped[0], first, length, lo, hi);
+            *result = env->NewString(&mapped[0], length);
+            handled = true;
+        }
+    }
+    env->ReleaseStringChars(javaString, chars);
+    return handled;
+}
+
 static jstring ICU_toLowerCase(JNIEnv* env, jclass, jstring javaString, jstring localeName) {
+    jstring result;
+    if (mapAsciiCase(env, javaString, localeName, 'A', 'Z', 'I', &result)) {
+        return result;
+    }
     ScopedJavaUnicodeString scopedString(env, javaString);
     UnicodeString& s(scopedString.unicodeString());
     UnicodeString original(s);
@@ -539,6 +756,10 @@ static jstring ICU_toLowerCase(JNIEnv* env, jclass, jstring javaString, jstring
 }
 
 static jstring ICU_toUpperCase(JNIEnv* env, jclass, jstring javaString, jstring localeName) {
+    jstring result;
+    if (mapAsciiCase(env, javaString, localeName, 'a', 'z', 'i', &result)) {
+        return result;
+    }
     ScopedJavaUnicodeString scopedString(env, javaString);
     UnicodeString& s(scopedString.unicodeString());
     UnicodeString original(s);
@@ -546,6 +767,71 @@ static jstring ICU_toUpperCase(JNIEnv* env, jclass, jstring javaString, jstring
     return s == original ? javaString : env->NewString(s.getBuffer(), s.length());
 }
 
+// Character.getType's values are ICU's, except that the RI skips 17.
+static jbyte javaCharacterType(UChar32 codePoint) {
+    int8_t type = u_charType(codePoint);
+    return (type <= U_FORMAT_CHAR) ? type : type + 1;
+}
+
+// Latin-1 is most of most text, so it gets a table. ICU's own lookup is a trie, so there's little
+// to be gained by tabulating the rest of the BMP.
+static jbyte gLatin1CharacterTypes[256];
+static pthread_once_t gLatin1CharacterTypesOnce = PTHREAD_ONCE_INIT;
+
+static void initLatin1CharacterTypes() {
+    for (int i = 0; i < 256; ++i) {
+        gLatin1CharacterTypes[i] = javaCharacterType(i);
+    }
+}
+
+/**
+ * Sets types[i] to the Character.getType value of chars[i], for 'length' chars. Both halves of a
+ * surrogate pair get the type of the code point they encode; a surrogate whose partner isn't in
+ * the range is Character.SURROGATE.
+ */
+static void getCharacterTypes(const jchar* chars, jint length, jbyte* types) {
+    pthread_once(&gLatin1CharacterTypesOnce, initLatin1CharacterTypes);
+    jint i = 0;
+    while (i < length) {
+        jchar ch = chars[i];
+        if (ch < 0x100) {
+            types[i++] = gLatin1CharacterTypes[ch];
+        } else if (U16_IS_LEAD(ch) && i + 1 < length && U16_IS_TRAIL(chars[i + 1])) {
+            types[i] = types[i + 1] = javaCharacterType(U16_GET_SUPPLEMENTARY(ch, chars[i + 1]));
+            i += 2;
+        } else {
+            types[i++] = javaCharacterType(ch);
+        }
+    }
+}
+
+static void ICU_getCharacterTypesNative(JNIEnv* env, jclass, jcharArray javaChars, jint offset,
+        jint length, jbyteArray javaTypes) {
+    ScopedCharArrayRO chars(env, javaChars);
+    if (chars.get() == NULL) {
+        return;
+    }
+    ScopedByteArrayRW types(env, javaTypes);
+    if (types.get() == NULL) {
+        return;
+    }
+    getCharacterTypes(chars.get() + offset, length, types.get());
+}
+
+static void ICU_getStringCharacterTypesNative(JNIEnv* env, jclass, jstring javaString, jint offset,
+        jint length, jbyteArray javaTypes) {
+    ScopedByteArrayRW types(env, javaTypes);
+    if (types.get() == NULL) {
+        return;
+    }
+    const jchar* chars = env->GetStringChars(javaString, NULL);
+    if (chars == NULL) {
+        return;
+    }
+    getCharacterTypes(chars + offset, length, types.get());
+    env->ReleaseStringChars(javaString, chars);
+}
+
 static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(ICU, getAvailableBreakIteratorLocalesNative, "()[Ljava/lang/String;"),
     NATIVE_METHOD(ICU, getAvailableCalendarLocalesNative, "()[Ljava/lang/String;"),
@@ -553,6 +839,7 @@ static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(ICU, getAvailableDateFormatLocalesNative, "()[Ljava/lang/String;"),
     NATIVE_METHOD(ICU, getAvailableLocalesNative, "()[Ljava/lang/String;"),
     NATIVE_METHOD(ICU, getAvailableNumberFormatLocalesNative, "()[Ljava/lang/String;"),
+    NATIVE_METHOD(ICU, getCharacterTypesNative, "([CII[B)V"),
     NATIVE_METHOD(ICU, getCurrencyCodeNative, "(Ljava/lang/String;)Ljava/lang/String;"),
     NATIVE_METHOD(ICU, getCurrencyFractionDigitsNative, "(Ljava/lang/String;)I"),
     NATIVE_METHOD(ICU, getCurrencySymbolNative, "(Ljava/lang/String;Ljava/lang/String;)Ljava/lang/String;"),
@@ -563,7 +850,8 @@ static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(ICU, getISO3LanguageNative, "(Ljava/lang/String;)Ljava/lang/String;"),
     NATIVE_METHOD(ICU, getISOCountriesNative, "()[Ljava/lang/String;"),
     NATIVE_METHOD(ICU, getISOLanguagesNative, "()[Ljava/lang/String;"),
-    NATIVE_METHOD(ICU, initLocaleDataImpl, "(Ljava/lang/String;Llibcore/icu/LocaleData;)Z"),
+    NATIVE_METHOD(ICU, getStringCharacterTypesNative, "(Ljava/lang/String;II[B)V"),
+    NATIVE_METHOD(ICU, initLocaleDataImpl, "(Ljava/lang/String;ILlibcore/icu/LocaleData;)Z"),
     NATIVE_METHOD(ICU, toLowerCase, "(Ljava/lang/String;Ljava/lang/String;)Ljava/lang/String;"),
     NATIVE_METHOD(ICU, toUpperCase, "(Ljava/lang/String;Ljava/lang/String;)Ljava/lang/String;"),
 };
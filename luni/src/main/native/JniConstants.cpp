@@ -15,6 +15,7 @@
  */
 
 #include "JniConstants.h"
+#include "ScopedStartupTimer.h"
 
 #include <stdlib.h>
 
@@ -38,6 +39,7 @@ jclass JniConstants::interfaceAddressClass;
 jclass JniConstants::localeDataClass;
 jclass JniConstants::longClass;
 jclass JniConstants::methodClass;
+jclass JniConstants::objectClass;
 jclass JniConstants::parsePositionClass;
 jclass JniConstants::patternSyntaxExceptionClass;
 jclass JniConstants::realToStringClass;
@@ -47,6 +49,7 @@ jclass JniConstants::stringClass;
 jclass JniConstants::vmRuntimeClass;
 
 static jclass findClass(JNIEnv* env, const char* name) {
+    ScopedStartupTimer timer("FindClass", name);
     jclass result = reinterpret_cast<jclass>(env->NewGlobalRef(env->FindClass(name)));
     if (result == NULL) {
         ALOGE("failed to find class '%s'", name);
@@ -56,27 +59,22 @@ static jclass findClass(JNIEnv* env, const char* name) {
 }
 
 void JniConstants::init(JNIEnv* env) {
-    bidiRunClass = findClass(env, "org/apache/harmony/text/BidiRun");
-    bigDecimalClass = findClass(env, "java/math/BigDecimal");
     booleanClass = findClass(env, "java/lang/Boolean");
     byteClass = findClass(env, "java/lang/Byte");
     byteArrayClass = findClass(env, "[B");
-    charsetICUClass = findClass(env, "libcore/icu/CharsetICU");
     constructorClass = findClass(env, "java/lang/reflect/Constructor");
     datagramPacketClass = findClass(env, "java/net/DatagramPacket");
     deflaterClass = findClass(env, "java/util/zip/Deflater");
     doubleClass = findClass(env, "java/lang/Double");
     fieldClass = findClass(env, "java/lang/reflect/Field");
-    fieldPositionIteratorClass = findClass(env, "libcore/icu/NativeDecimalFormat$FieldPositionIterator");
     inetAddressClass = findClass(env, "java/net/InetAddress");
     inflaterClass = findClass(env, "java/util/zip/Inflater");
     integerClass = findClass(env, "java/lang/Integer");
     interfaceAddressClass = findClass(env, "java/net/InterfaceAddress");
-    localeDataClass = findClass(env, "libcore/icu/LocaleData");
     longClass = findClass(env, "java/lang/Long");
     methodClass = findClass(env, "java/lang/reflect/Method");
     multicastGroupRequestClass = findClass(env, "java/net/MulticastGroupRequest");
-    parsePositionClass = findClass(env, "java/text/ParsePosition");
+    objectClass = findClass(env, "java/lang/Object");
     patternSyntaxExceptionClass = findClass(env, "java/util/regex/PatternSyntaxException");
     realToStringClass = findClass(env, "java/lang/RealToString");
     socketClass = findClass(env, "java/net/Socket");
@@ -84,3 +82,12 @@ void JniConstants::init(JNIEnv* env) {
     stringClass = findClass(env, "java/lang/String");
     vmRuntimeClass = findClass(env, "dalvik/system/VMRuntime");
 }
+
+void JniConstants::initIcu(JNIEnv* env) {
+    bidiRunClass = findClass(env, "org/apache/harmony/text/BidiRun");
+    bigDecimalClass = findClass(env, "java/math/BigDecimal");
+    charsetICUClass = findClass(env, "libcore/icu/CharsetICU");
+    fieldPositionIteratorClass = findClass(env, "libcore/icu/NativeDecimalFormat$FieldPositionIterator");
+    localeDataClass = findClass(env, "libcore/icu/LocaleData");
+    parsePositionClass = findClass(env, "java/text/ParsePosition");
+}
@@ -35,10 +35,16 @@
  * the serialization code. The former is clearly not a performance case, and we're currently
  * assuming that neither is the latter.
  *
+ * The exception is the classes only used by the ICU natives, which are looked up by initIcu when
+ * those natives are first registered (see NativeSubsystems in Register.cpp). On a device the
+ * zygote's preloading still pays for them during boot; this just spares short-lived command-line
+ * processes that never use ICU.
+ *
  * TODO: similar arguments hold for field and method IDs; we should cache them centrally too.
  */
 struct JniConstants {
     static void init(JNIEnv* env);
+    static void initIcu(JNIEnv* env);
 
     static jclass bidiRunClass;
     static jclass bigDecimalClass;
@@ -60,6 +66,7 @@ struct JniConstants {
     static jclass longClass;
     static jclass methodClass;
     static jclass multicastGroupRequestClass;
+    static jclass objectClass;
     static jclass parsePositionClass;
     static jclass patternSyntaxExceptionClass;
     static jclass realToStringClass;
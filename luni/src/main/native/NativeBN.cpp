@@ -30,14 +30,89 @@
 #include <openssl/bn.h>
 #include <openssl/crypto.h>
 #include <openssl/err.h>
+#include <pthread.h>
 #include <stdio.h>
+#include <string.h>
 
-struct BN_CTX_Deleter {
-    void operator()(BN_CTX* p) const {
-        BN_CTX_free(p);
-    }
+/*
+ * Each thread keeps one BN_CTX for all its operations, rather than allocating one per call, along
+ * with Montgomery contexts for the last few odd moduli it passed to BN_mod_exp. Setting one of
+ * those up costs a modular inverse and a division, which a series of modPows against the same
+ * modulus (as in Diffie-Hellman or RSA) would otherwise pay every time. A thread's state is only
+ * ever touched by that thread, so there's no locking.
+ */
+static const int kMontgomeryCacheSize = 4;
+
+struct ThreadState {
+    BN_CTX* ctx;
+    // Copies of the moduli, so we notice if a BIGNUM handle is reused for a different value.
+    BIGNUM* moduli[kMontgomeryCacheSize];
+    BN_MONT_CTX* montgomery[kMontgomeryCacheSize];
+    int nextVictim;
 };
-typedef UniquePtr<BN_CTX, BN_CTX_Deleter> Unique_BN_CTX;
+static pthread_key_t gThreadStateKey;
+static pthread_once_t gThreadStateKeyOnce = PTHREAD_ONCE_INIT;
+
+static void destroyThreadState(void* value) {
+    ThreadState* state = reinterpret_cast<ThreadState*>(value);
+    for (int i = 0; i < kMontgomeryCacheSize; ++i) {
+        BN_free(state->moduli[i]);
+        BN_MONT_CTX_free(state->montgomery[i]);
+    }
+    BN_CTX_free(state->ctx);
+    delete state;
+}
+
+static void createThreadStateKey() {
+    pthread_key_create(&gThreadStateKey, destroyThreadState);
+}
+
+// Returns this thread's state, creating it if necessary, or NULL if that's impossible.
+static ThreadState* getThreadState() {
+    pthread_once(&gThreadStateKeyOnce, createThreadStateKey);
+    ThreadState* state = reinterpret_cast<ThreadState*>(pthread_getspecific(gThreadStateKey));
+    if (state == NULL) {
+        BN_CTX* ctx = BN_CTX_new();
+        if (ctx == NULL) {
+            return NULL;
+        }
+        state = new ThreadState;
+        memset(state, 0, sizeof(*state));
+        state->ctx = ctx;
+        pthread_setspecific(gThreadStateKey, state);
+    }
+    return state;
+}
+
+// Returns this thread's BN_CTX, or NULL if it couldn't be allocated.
+static BN_CTX* getThreadContext() {
+    ThreadState* state = getThreadState();
+    return (state != NULL) ? state->ctx : NULL;
+}
+
+// Returns a Montgomery context for the odd modulus 'm', reusing this thread's if it has one for
+// the same value, or NULL if one couldn't be made.
+static BN_MONT_CTX* getMontgomeryContext(ThreadState* state, const BIGNUM* m) {
+    for (int i = 0; i < kMontgomeryCacheSize; ++i) {
+        if (state->moduli[i] != NULL && BN_cmp(state->moduli[i], m) == 0) {
+            return state->montgomery[i];
+        }
+    }
+    BN_MONT_CTX* mont = BN_MONT_CTX_new();
+    BIGNUM* modulus = BN_dup(m);
+    if (mont == NULL || modulus == NULL || !BN_MONT_CTX_set(mont, m, state->ctx)) {
+        BN_MONT_CTX_free(mont);
+        BN_free(modulus);
+        return NULL;
+    }
+    int victim = state->nextVictim;
+    state->nextVictim = (victim + 1) % kMontgomeryCacheSize;
+    BN_free(state->moduli[victim]);
+    BN_MONT_CTX_free(state->montgomery[victim]);
+    state->moduli[victim] = modulus;
+    state->montgomery[victim] = mont;
+    return mont;
+}
 
 static int isValidHandle (JNIEnv* env, void* handle, const char* message) {
     if (handle == NULL) {
@@ -459,44 +534,76 @@ static jboolean NativeBN_BN_sub(JNIEnv* env, jclass, BIGNUM* r, BIGNUM* a, BIGNU
 
 static jboolean NativeBN_BN_gcd(JNIEnv* env, jclass, BIGNUM* r, BIGNUM* a, BIGNUM* b) {
     if (!threeValidHandles(env, r, a, b)) return JNI_FALSE;
-    Unique_BN_CTX ctx(BN_CTX_new());
-    return BN_gcd(r, a, b, ctx.get());
+    BN_CTX* ctx = getThreadContext();
+    if (ctx == NULL) return JNI_FALSE;
+    return BN_gcd(r, a, b, ctx);
 }
 
 static jboolean NativeBN_BN_mul(JNIEnv* env, jclass, BIGNUM* r, BIGNUM* a, BIGNUM* b) {
     if (!threeValidHandles(env, r, a, b)) return JNI_FALSE;
-    Unique_BN_CTX ctx(BN_CTX_new());
-    return BN_mul(r, a, b, ctx.get());
+    BN_CTX* ctx = getThreadContext();
+    if (ctx == NULL) return JNI_FALSE;
+    return BN_mul(r, a, b, ctx);
 }
 
 static jboolean NativeBN_BN_exp(JNIEnv* env, jclass, BIGNUM* r, BIGNUM* a, BIGNUM* p) {
     if (!threeValidHandles(env, r, a, p)) return JNI_FALSE;
-    Unique_BN_CTX ctx(BN_CTX_new());
-    return BN_exp(r, a, p, ctx.get());
+    BN_CTX* ctx = getThreadContext();
+    if (ctx == NULL) return JNI_FALSE;
+    return BN_exp(r, a, p, ctx);
 }
 
 static jboolean NativeBN_BN_div(JNIEnv* env, jclass, BIGNUM* dv, BIGNUM* rem, BIGNUM* m, BIGNUM* d) {
     if (!fourValidHandles(env, (rem ? rem : dv), (dv ? dv : rem), m, d)) return JNI_FALSE;
-    Unique_BN_CTX ctx(BN_CTX_new());
-    return BN_div(dv, rem, m, d, ctx.get());
+    BN_CTX* ctx = getThreadContext();
+    if (ctx == NULL) return JNI_FALSE;
+    return BN_div(dv, rem, m, d, ctx);
 }
 
 static jboolean NativeBN_BN_nnmod(JNIEnv* env, jclass, BIGNUM* r, BIGNUM* a, BIGNUM* m) {
     if (!threeValidHandles(env, r, a, m)) return JNI_FALSE;
-    Unique_BN_CTX ctx(BN_CTX_new());
-    return BN_nnmod(r, a, m, ctx.get());
+    BN_CTX* ctx = getThreadContext();
+    if (ctx == NULL) return JNI_FALSE;
+    return BN_nnmod(r, a, m, ctx);
 }
 
 static jboolean NativeBN_BN_mod_exp(JNIEnv* env, jclass, BIGNUM* r, BIGNUM* a, BIGNUM* p, BIGNUM* m) {
     if (!fourValidHandles(env, r, a, p, m)) return JNI_FALSE;
-    Unique_BN_CTX ctx(BN_CTX_new());
-    return BN_mod_exp(r, a, p, m, ctx.get());
+    ThreadState* state = getThreadState();
+    if (state == NULL) return JNI_FALSE;
+    if (BN_is_odd(m)) {
+        // This is what BN_mod_exp does for odd moduli, but with the cached Montgomery context.
+        BN_MONT_CTX* mont = getMontgomeryContext(state, m);
+        if (mont == NULL) return JNI_FALSE;
+        if (a->top == 1 && !a->neg && !BN_get_flags(p, BN_FLG_CONSTTIME)) {
+            return BN_mod_exp_mont_word(r, a->d[0], p, m, state->ctx, mont);
+        }
+        return BN_mod_exp_mont(r, a, p, m, state->ctx, mont);
+    }
+    return BN_mod_exp(r, a, p, m, state->ctx);
+}
+
+/**
+ * public static native boolean addProduct(int r, int a, int b)
+ * Computes r += a * b, with the product in a temporary from the thread's BN_CTX rather than a
+ * BIGNUM of its own that Java would have to allocate and free.
+ */
+static jboolean NativeBN_addProduct(JNIEnv* env, jclass, BIGNUM* r, BIGNUM* a, BIGNUM* b) {
+    if (!threeValidHandles(env, r, a, b)) return JNI_FALSE;
+    BN_CTX* ctx = getThreadContext();
+    if (ctx == NULL) return JNI_FALSE;
+    BN_CTX_start(ctx);
+    BIGNUM* product = BN_CTX_get(ctx);
+    bool success = (product != NULL && BN_mul(product, a, b, ctx) && BN_add(r, r, product));
+    BN_CTX_end(ctx);
+    return success;
 }
 
 static jboolean NativeBN_BN_mod_inverse(JNIEnv* env, jclass, BIGNUM* ret, BIGNUM* a, BIGNUM* n) {
     if (!threeValidHandles(env, ret, a, n)) return JNI_FALSE;
-    Unique_BN_CTX ctx(BN_CTX_new());
-    return (BN_mod_inverse(ret, a, n, ctx.get()) != NULL);
+    BN_CTX* ctx = getThreadContext();
+    if (ctx == NULL) return JNI_FALSE;
+    return (BN_mod_inverse(ret, a, n, ctx) != NULL);
 }
 
 static jboolean NativeBN_BN_generate_prime_ex(JNIEnv* env, jclass, BIGNUM* ret, int bits, jboolean safe,
@@ -507,8 +614,9 @@ static jboolean NativeBN_BN_generate_prime_ex(JNIEnv* env, jclass, BIGNUM* ret,
 
 static jboolean NativeBN_BN_is_prime_ex(JNIEnv* env, jclass, BIGNUM* p, int nchecks, jint cb) {
     if (!oneValidHandle(env, p)) return JNI_FALSE;
-    Unique_BN_CTX ctx(BN_CTX_new());
-    return BN_is_prime_ex(p, nchecks, ctx.get(), reinterpret_cast<BN_GENCB*>(cb));
+    BN_CTX* ctx = getThreadContext();
+    if (ctx == NULL) return JNI_FALSE;
+    return BN_is_prime_ex(p, nchecks, ctx, reinterpret_cast<BN_GENCB*>(cb));
 }
 
 static JNINativeMethod gMethods[] = {
@@ -543,6 +651,7 @@ static JNINativeMethod gMethods[] = {
    NATIVE_METHOD(NativeBN, BN_sub_word, "(II)Z"),
    NATIVE_METHOD(NativeBN, ERR_error_string, "(I)Ljava/lang/String;"),
    NATIVE_METHOD(NativeBN, ERR_get_error, "()I"),
+   NATIVE_METHOD(NativeBN, addProduct, "(III)Z"),
    NATIVE_METHOD(NativeBN, bitLength, "(I)I"),
    NATIVE_METHOD(NativeBN, bn2litEndInts, "(I)[I"),
    NATIVE_METHOD(NativeBN, litEndInts2bn, "([IIZI)Z"),
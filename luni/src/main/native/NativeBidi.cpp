@@ -155,6 +155,73 @@ static jobjectArray NativeBidi_ubidi_getRuns(JNIEnv* env, jclass, jlong ptr) {
     return runs;
 }
 
+/**
+ * Runs the Bidi algorithm over text[textStart..textStart+length) and reads back everything
+ * java.text.Bidi needs in the same call, without calling back into Java. Each char's resolved
+ * level goes in 'levelsOut', and if 'visualMapOut' isn't null, the logical index of each char in
+ * visual order goes there. Returns { direction, paraLevel, runCount, start0, limit0, level0,
+ * start1, ... }, with runs in logical order.
+ */
+static jintArray NativeBidi_ubidi_analyze(JNIEnv* env, jclass, jcharArray text, jint textStart, jint length, jint paraLevel, jbyteArray embeddingLevels, jbyteArray levelsOut, jintArray visualMapOut) {
+    UErrorCode err = U_ZERO_ERROR;
+    BiDiData data(ubidi_openSized(length, 0, &err));
+    if (icu4jni_error(env, err)) {
+        return NULL;
+    }
+    // ICU keeps using the embedding levels after setPara, so they need a copy of their own.
+    if (embeddingLevels != NULL) {
+        jbyte* dst;
+        data.setEmbeddingLevels(dst = new jbyte[length]);
+        env->GetByteArrayRegion(embeddingLevels, 0, length, dst);
+    }
+    ScopedCharArrayRO chars(env, text);
+    if (chars.get() == NULL) {
+        return NULL;
+    }
+    UBiDi* ubidi = data.uBiDi();
+    ubidi_setPara(ubidi, chars.get() + textStart, length, paraLevel, data.embeddingLevels(), &err);
+    int runCount = ubidi_countRuns(ubidi, &err);
+    if (icu4jni_error(env, err)) {
+        return NULL;
+    }
+
+    if (length > 0) {
+        const UBiDiLevel* levels = ubidi_getLevels(ubidi, &err);
+        if (icu4jni_error(env, err)) {
+            return NULL;
+        }
+        env->SetByteArrayRegion(levelsOut, 0, length, reinterpret_cast<const jbyte*>(levels));
+        if (visualMapOut != NULL) {
+            UniquePtr<int32_t[]> visualMap(new int32_t[length]);
+            ubidi_getVisualMap(ubidi, &visualMap[0], &err);
+            if (icu4jni_error(env, err)) {
+                return NULL;
+            }
+            env->SetIntArrayRegion(visualMapOut, 0, length, &visualMap[0]);
+        }
+    }
+
+    UniquePtr<jint[]> info(new jint[3 + 3 * runCount]);
+    info[0] = ubidi_getDirection(ubidi);
+    info[1] = ubidi_getParaLevel(ubidi);
+    info[2] = runCount;
+    int32_t start = 0;
+    for (int i = 0; i < runCount; ++i) {
+        int32_t limit;
+        UBiDiLevel level;
+        ubidi_getLogicalRun(ubidi, start, &limit, &level);
+        info[3 + 3 * i] = start;
+        info[4 + 3 * i] = limit;
+        info[5 + 3 * i] = level;
+        start = limit;
+    }
+    jintArray result = env->NewIntArray(3 + 3 * runCount);
+    if (result != NULL) {
+        env->SetIntArrayRegion(result, 0, 3 + 3 * runCount, &info[0]);
+    }
+    return result;
+}
+
 static jintArray NativeBidi_ubidi_reorderVisual(JNIEnv* env, jclass, jbyteArray javaLevels, jint length) {
     ScopedByteArrayRO levelBytes(env, javaLevels);
     if (levelBytes.get() == NULL) {
@@ -172,6 +239,7 @@ static jintArray NativeBidi_ubidi_reorderVisual(JNIEnv* env, jclass, jbyteArray
 }
 
 static JNINativeMethod gMethods[] = {
+    NATIVE_METHOD(NativeBidi, ubidi_analyze, "([CIII[B[B[I)[I"),
     NATIVE_METHOD(NativeBidi, ubidi_close, "(J)V"),
     NATIVE_METHOD(NativeBidi, ubidi_countRuns, "(J)I"),
     NATIVE_METHOD(NativeBidi, ubidi_getDirection, "(J)I"),
@@ -20,10 +20,33 @@
 #include "JniConstants.h"
 #include "ErrorCode.h"
 #include "ScopedJavaUnicodeString.h"
+#include "ScopedPthreadMutexLock.h"
 #include "ScopedUtfChars.h"
 #include "unicode/ubrk.h"
 #include "unicode/putil.h"
+#include <map>
 #include <stdlib.h>
+#include <string>
+#include <vector>
+
+static UBreakIterator* cloneIterator(const UBreakIterator* it, UErrorCode* status) {
+    // With no buffer of ours, ubrk_safeClone allocates the clone, and ubrk_close will free it.
+    jint bufferSize = U_BRK_SAFECLONE_BUFFERSIZE;
+    UBreakIterator* clone = ubrk_safeClone(it, NULL, &bufferSize, status);
+    if (*status == U_SAFECLONE_ALLOCATED_WARNING) {
+        *status = U_ZERO_ERROR;
+    }
+    return clone;
+}
+
+/*
+ * ubrk_open loads and parses the rules for the locale and type every time, which costs far more
+ * than breaking a typical string. Instead we open each (locale, type) once, keep that iterator as
+ * a template, and hand out clones of it. The templates are never given any text.
+ */
+typedef std::map<std::pair<std::string, UBreakIteratorType>, UBreakIterator*> IteratorTemplates;
+static IteratorTemplates gIteratorTemplates;
+static pthread_mutex_t gIteratorTemplatesMutex = PTHREAD_MUTEX_INITIALIZER;
 
 static jint getIterator(JNIEnv* env, jstring locale, UBreakIteratorType type) {
     UErrorCode status = U_ZERO_ERROR;
@@ -31,9 +54,23 @@ static jint getIterator(JNIEnv* env, jstring locale, UBreakIteratorType type) {
     if (localeChars.c_str() == NULL) {
         return 0;
     }
-    UBreakIterator* it = ubrk_open(type, localeChars.c_str(), NULL, 0, &status);
+    ScopedPthreadMutexLock lock(&gIteratorTemplatesMutex);
+    IteratorTemplates::key_type key(localeChars.c_str(), type);
+    IteratorTemplates::iterator it = gIteratorTemplates.find(key);
+    UBreakIterator* tmpl;
+    if (it != gIteratorTemplates.end()) {
+        tmpl = it->second;
+    } else {
+        tmpl = ubrk_open(type, localeChars.c_str(), NULL, 0, &status);
+        if (U_FAILURE(status)) {
+            icu4jni_error(env, status);
+            return 0;
+        }
+        gIteratorTemplates[key] = tmpl;
+    }
+    UBreakIterator* result = cloneIterator(tmpl, &status);
     icu4jni_error(env, status);
-    return reinterpret_cast<uintptr_t>(it);
+    return reinterpret_cast<uintptr_t>(result);
 }
 
 static jint NativeBreakIterator_getCharacterInstanceImpl(JNIEnv* env, jclass, jstring locale) {
@@ -62,8 +99,7 @@ static void NativeBreakIterator_closeBreakIteratorImpl(JNIEnv*, jclass, jint add
 
 static jint NativeBreakIterator_cloneImpl(JNIEnv* env, jclass, jint address) {
     UErrorCode status = U_ZERO_ERROR;
-    jint bufferSize = U_BRK_SAFECLONE_BUFFERSIZE;
-    UBreakIterator* it = ubrk_safeClone(breakIterator(address), NULL, &bufferSize, &status);
+    UBreakIterator* it = cloneIterator(breakIterator(address), &status);
     icu4jni_error(env, status);
     return reinterpret_cast<uintptr_t>(it);
 }
@@ -122,12 +158,35 @@ static jint NativeBreakIterator_lastImpl(JNIEnv*, jclass, jint address) {
     return ubrk_last(breakIterator(address));
 }
 
+/**
+ * Returns every boundary in the current text, first to last, each followed by the status of the
+ * rule that produced it. The iterator is left where it was.
+ */
+static jintArray NativeBreakIterator_getBoundariesImpl(JNIEnv* env, jclass, jint address) {
+    UBreakIterator* bi = breakIterator(address);
+    int32_t current = ubrk_current(bi);
+    std::vector<jint> boundaries;
+    for (int32_t offset = ubrk_first(bi); offset != UBRK_DONE; offset = ubrk_next(bi)) {
+        boundaries.push_back(offset);
+        boundaries.push_back(ubrk_getRuleStatus(bi));
+    }
+    // The current position is always a boundary, so this just moves back there.
+    ubrk_isBoundary(bi, current);
+
+    jintArray result = env->NewIntArray(boundaries.size());
+    if (result != NULL && !boundaries.empty()) {
+        env->SetIntArrayRegion(result, 0, boundaries.size(), &boundaries[0]);
+    }
+    return result;
+}
+
 static JNINativeMethod gMethods[] = {
   NATIVE_METHOD(NativeBreakIterator, cloneImpl, "(I)I"),
   NATIVE_METHOD(NativeBreakIterator, closeBreakIteratorImpl, "(I)V"),
   NATIVE_METHOD(NativeBreakIterator, currentImpl, "(I)I"),
   NATIVE_METHOD(NativeBreakIterator, firstImpl, "(I)I"),
   NATIVE_METHOD(NativeBreakIterator, followingImpl, "(II)I"),
+  NATIVE_METHOD(NativeBreakIterator, getBoundariesImpl, "(I)[I"),
   NATIVE_METHOD(NativeBreakIterator, getCharacterInstanceImpl, "(Ljava/lang/String;)I"),
   NATIVE_METHOD(NativeBreakIterator, getLineInstanceImpl, "(Ljava/lang/String;)I"),
   NATIVE_METHOD(NativeBreakIterator, getSentenceInstanceImpl, "(Ljava/lang/String;)I"),
@@ -13,12 +13,17 @@
 #include "JNIHelp.h"
 #include "JniConstants.h"
 #include "ScopedJavaUnicodeString.h"
+#include "ScopedLocalRef.h"
 #include "ScopedUtfChars.h"
 #include "UniquePtr.h"
 #include "ucol_imp.h"
 #include "unicode/ucol.h"
 #include "unicode/ucoleitr.h"
 
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
 static UCollator* toCollator(jint address) {
     return reinterpret_cast<UCollator*>(static_cast<uintptr_t>(address));
 }
@@ -96,6 +101,101 @@ static jbyteArray NativeCollation_getSortKey(JNIEnv* env, jclass, jint address,
     return result;
 }
 
+/**
+ * Appends the sort key for each of 'sources' to 'keys', and where each starts to 'offsets',
+ * followed by the end of the last. A null source gets an empty key if 'allowNulls', and
+ * otherwise we throw NullPointerException. Returns false if we threw.
+ */
+static bool getSortKeys(JNIEnv* env, const UCollator* collator, jobjectArray sources,
+        bool allowNulls, std::vector<uint8_t>& keys, std::vector<jint>& offsets) {
+    jsize count = env->GetArrayLength(sources);
+    offsets.reserve(count + 1);
+    size_t used = 0;
+    for (jsize i = 0; i < count; ++i) {
+        offsets.push_back(used);
+        ScopedLocalRef<jstring> source(env,
+                reinterpret_cast<jstring>(env->GetObjectArrayElement(sources, i)));
+        if (source.get() == NULL) {
+            if (!allowNulls) {
+                jniThrowNullPointerException(env, NULL);
+                return false;
+            }
+            continue;
+        }
+        ScopedJavaUnicodeString chars(env, source.get());
+        const UChar* buffer = chars.unicodeString().getBuffer();
+        int32_t charCount = chars.unicodeString().length();
+        while (true) {
+            if (keys.size() - used < UCOL_MAX_BUFFER) {
+                keys.resize(std::max(2 * keys.size(), used + UCOL_MAX_BUFFER));
+            }
+            size_t keyLength = ucol_getSortKey(collator, buffer, charCount,
+                    &keys[used], keys.size() - used);
+            if (keyLength <= keys.size() - used) {
+                used += keyLength;
+                break;
+            }
+            // Didn't fit; make room for it and try again.
+            keys.resize(used + keyLength);
+        }
+    }
+    offsets.push_back(used);
+    keys.resize(used);
+    return true;
+}
+
+static jbyteArray NativeCollation_getSortKeys(JNIEnv* env, jclass, jint address,
+        jobjectArray sources, jintArray javaOffsets) {
+    std::vector<uint8_t> keys;
+    std::vector<jint> offsets;
+    if (!getSortKeys(env, toCollator(address), sources, true, keys, offsets)) {
+        return NULL;
+    }
+    env->SetIntArrayRegion(javaOffsets, 0, offsets.size(), &offsets[0]);
+    jbyteArray result = env->NewByteArray(keys.size());
+    if (result != NULL && !keys.empty()) {
+        env->SetByteArrayRegion(result, 0, keys.size(), reinterpret_cast<jbyte*>(&keys[0]));
+    }
+    return result;
+}
+
+// Orders indices by the sort keys of the strings they refer to. ICU's sort keys are
+// null-terminated, with no other nulls, so strcmp's unsigned comparison orders them correctly.
+struct SortKeyLess {
+    SortKeyLess(const std::vector<uint8_t>& keys, const std::vector<jint>& offsets)
+    : keys(reinterpret_cast<const char*>(&keys[0])), offsets(&offsets[0]) {
+    }
+
+    bool operator()(jint lhs, jint rhs) const {
+        return strcmp(keys + offsets[lhs], keys + offsets[rhs]) < 0;
+    }
+
+    const char* keys;
+    const jint* offsets;
+};
+
+static jintArray NativeCollation_sort(JNIEnv* env, jclass, jint address, jobjectArray sources) {
+    std::vector<uint8_t> keys;
+    std::vector<jint> offsets;
+    if (!getSortKeys(env, toCollator(address), sources, false, keys, offsets)) {
+        return NULL;
+    }
+    size_t count = offsets.size() - 1;
+    std::vector<jint> indices(count);
+    for (size_t i = 0; i < count; ++i) {
+        indices[i] = i;
+    }
+    if (count > 1) {
+        // Stable, like Collections.sort: equal strings keep their order.
+        std::stable_sort(indices.begin(), indices.end(), SortKeyLess(keys, offsets));
+    }
+    jintArray result = env->NewIntArray(count);
+    if (result != NULL && count > 0) {
+        env->SetIntArrayRegion(result, 0, count, &indices[0]);
+    }
+    return result;
+}
+
 static jint NativeCollation_next(JNIEnv* env, jclass, jint address) {
     UErrorCode status = U_ZERO_ERROR;
     jint result = ucol_next(toCollationElements(address), &status);
@@ -172,6 +272,7 @@ static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(NativeCollation, getOffset, "(I)I"),
     NATIVE_METHOD(NativeCollation, getRules, "(I)Ljava/lang/String;"),
     NATIVE_METHOD(NativeCollation, getSortKey, "(ILjava/lang/String;)[B"),
+    NATIVE_METHOD(NativeCollation, getSortKeys, "(I[Ljava/lang/String;[I)[B"),
     NATIVE_METHOD(NativeCollation, next, "(I)I"),
     NATIVE_METHOD(NativeCollation, openCollator, "(Ljava/lang/String;)I"),
     NATIVE_METHOD(NativeCollation, openCollatorFromRules, "(Ljava/lang/String;II)I"),
@@ -181,6 +282,7 @@ static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(NativeCollation, setAttribute, "(III)V"),
     NATIVE_METHOD(NativeCollation, setOffset, "(II)V"),
     NATIVE_METHOD(NativeCollation, setText, "(ILjava/lang/String;)V"),
+    NATIVE_METHOD(NativeCollation, sort, "(I[Ljava/lang/String;)[I"),
 };
 void register_libcore_icu_NativeCollation(JNIEnv* env) {
     jniRegisterNativeMethods(env, "libcore/icu/NativeCollation", gMethods, NELEM(gMethods));
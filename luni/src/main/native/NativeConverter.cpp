@@ -20,6 +20,7 @@
 #include "JniConstants.h"
 #include "ScopedLocalRef.h"
 #include "ScopedPrimitiveArray.h"
+#include "ScopedPthreadMutexLock.h"
 #include "ScopedUtfChars.h"
 #include "UniquePtr.h"
 #include "cutils/log.h"
@@ -28,8 +29,12 @@
 #include "unicode/uniset.h"
 #include "unicode/ustring.h"
 #include "unicode/utypes.h"
+#include <map>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
+#include <string>
+#include <vector>
 
 #define NativeConverter_REPORT 0
 #define NativeConverter_IGNORE 1
@@ -49,6 +54,49 @@ struct EncoderCallbackContext {
     UConverterFromUCallback onMalformedInput;
 };
 
+/*
+ * Every encoder and decoder sets a callback, so rather than allocate a context for each and
+ * free it when the converter is closed, we keep a few freed ones around for reuse.
+ */
+template <typename T>
+class CallbackContextCache {
+public:
+    CallbackContextCache() {
+        pthread_mutex_init(&mMutex, NULL);
+    }
+
+    T* take() {
+        {
+            ScopedPthreadMutexLock lock(&mMutex);
+            if (!mFree.empty()) {
+                T* context = mFree.back();
+                mFree.pop_back();
+                return context;
+            }
+        }
+        return new T;
+    }
+
+    void put(const T* context) {
+        {
+            ScopedPthreadMutexLock lock(&mMutex);
+            if (mFree.size() < kMaxCachedContexts) {
+                mFree.push_back(const_cast<T*>(context));
+                return;
+            }
+        }
+        delete context;
+    }
+
+private:
+    static const size_t kMaxCachedContexts = 64;
+    pthread_mutex_t mMutex;
+    std::vector<T*> mFree;
+};
+
+static CallbackContextCache<DecoderCallbackContext> gDecoderCallbackContexts;
+static CallbackContextCache<EncoderCallbackContext> gEncoderCallbackContexts;
+
 struct UConverterDeleter {
     void operator()(UConverter* p) const {
         ucnv_close(p);
@@ -60,13 +108,53 @@ static UConverter* toUConverter(jlong address) {
     return reinterpret_cast<UConverter*>(static_cast<uintptr_t>(address));
 }
 
+/*
+ * ucnv_open looks the name up in ICU's alias tables and builds a converter from scratch every
+ * time, which adds up when encoders and decoders are made thousands of times a second. Instead we
+ * open each charset once, keep that converter as a template, and hand out clones of it. The
+ * templates are never used to convert anything or given callbacks, so they stay pristine.
+ */
+typedef std::map<std::string, UConverter*> ConverterTemplates;
+static ConverterTemplates gConverterTemplates;
+static pthread_mutex_t gConverterTemplatesMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Returns the template for 'name', opening it if this is the first time it's been asked for.
+// The caller must hold gConverterTemplatesMutex.
+static UConverter* getConverterTemplate(const char* name, UErrorCode* errorCode) {
+    ConverterTemplates::iterator it = gConverterTemplates.find(name);
+    if (it != gConverterTemplates.end()) {
+        return it->second;
+    }
+    UConverter* tmpl = ucnv_open(name, errorCode);
+    if (U_FAILURE(*errorCode)) {
+        return NULL;
+    }
+    gConverterTemplates[name] = tmpl;
+    return tmpl;
+}
+
+static UConverter* openConverter(const char* name, UErrorCode* errorCode) {
+    ScopedPthreadMutexLock lock(&gConverterTemplatesMutex);
+    UConverter* tmpl = getConverterTemplate(name, errorCode);
+    if (tmpl == NULL) {
+        return NULL;
+    }
+    // With no buffer of ours, ucnv_safeClone allocates the clone, and ucnv_close will free it.
+    int32_t bufferSize = U_CNV_SAFECLONE_BUFFERSIZE;
+    UConverter* cnv = ucnv_safeClone(tmpl, NULL, &bufferSize, errorCode);
+    if (*errorCode == U_SAFECLONE_ALLOCATED_WARNING) {
+        *errorCode = U_ZERO_ERROR;
+    }
+    return cnv;
+}
+
 static jlong NativeConverter_openConverter(JNIEnv* env, jclass, jstring converterName) {
     ScopedUtfChars converterNameChars(env, converterName);
     if (converterNameChars.c_str() == NULL) {
         return 0;
     }
     UErrorCode errorCode = U_ZERO_ERROR;
-    UConverter* cnv = ucnv_open(converterNameChars.c_str(), &errorCode);
+    UConverter* cnv = openConverter(converterNameChars.c_str(), &errorCode);
     icu4jni_error(env, errorCode);
     return reinterpret_cast<uintptr_t>(cnv);
 }
@@ -75,38 +163,21 @@ static void NativeConverter_closeConverter(JNIEnv*, jclass, jlong address) {
     ucnv_close(toUConverter(address));
 }
 
-static jint NativeConverter_encode(JNIEnv* env, jclass, jlong address,
-        jcharArray source, jint sourceEnd, jbyteArray target, jint targetEnd,
-        jintArray data, jboolean flush) {
-
-    UConverter* cnv = toUConverter(address);
-    if (cnv == NULL) {
-        return U_ILLEGAL_ARGUMENT_ERROR;
-    }
-    ScopedCharArrayRO uSource(env, source);
-    if (uSource.get() == NULL) {
-        return U_ILLEGAL_ARGUMENT_ERROR;
-    }
-    ScopedByteArrayRW uTarget(env, target);
-    if (uTarget.get() == NULL) {
-        return U_ILLEGAL_ARGUMENT_ERROR;
-    }
-    ScopedIntArrayRW myData(env, data);
-    if (myData.get() == NULL) {
-        return U_ILLEGAL_ARGUMENT_ERROR;
-    }
-
+// Converts from 'source' to 'target', which are the starts of the caller's arrays or buffers;
+// 'myData' holds the offsets to start at, as described in NativeConverter.java.
+static jint encode(UConverter* cnv, const UChar* source, jint sourceEnd, char* target,
+        jint targetEnd, jint* myData, jboolean flush) {
     // Do the conversion.
     jint* sourceOffset = &myData[0];
     jint* targetOffset = &myData[1];
-    const jchar* mySource = uSource.get() + *sourceOffset;
-    const UChar* mySourceLimit= uSource.get() + sourceEnd;
-    char* cTarget = reinterpret_cast<char*>(uTarget.get() + *targetOffset);
-    const char* cTargetLimit = reinterpret_cast<const char*>(uTarget.get() + targetEnd);
+    const jchar* mySource = source + *sourceOffset;
+    const UChar* mySourceLimit= source + sourceEnd;
+    char* cTarget = target + *targetOffset;
+    const char* cTargetLimit = target + targetEnd;
     UErrorCode errorCode = U_ZERO_ERROR;
     ucnv_fromUnicode(cnv , &cTarget, cTargetLimit, &mySource, mySourceLimit, NULL, (UBool) flush, &errorCode);
-    *sourceOffset = (mySource - uSource.get()) - *sourceOffset;
-    *targetOffset = (reinterpret_cast<jbyte*>(cTarget) - uTarget.get()) - *targetOffset;
+    *sourceOffset = (mySource - source) - *sourceOffset;
+    *targetOffset = (cTarget - target) - *targetOffset;
 
     // Check how much more input is necessary to complete what's in the converter's internal buffer.
     UErrorCode minorErrorCode = U_ZERO_ERROR;
@@ -127,19 +198,19 @@ static jint NativeConverter_encode(JNIEnv* env, jclass, jlong address,
     return errorCode;
 }
 
-static jint NativeConverter_decode(JNIEnv* env, jclass, jlong address,
-        jbyteArray source, jint sourceEnd, jcharArray target, jint targetEnd,
+static jint NativeConverter_encode(JNIEnv* env, jclass, jlong address,
+        jcharArray source, jint sourceEnd, jbyteArray target, jint targetEnd,
         jintArray data, jboolean flush) {
 
     UConverter* cnv = toUConverter(address);
     if (cnv == NULL) {
         return U_ILLEGAL_ARGUMENT_ERROR;
     }
-    ScopedByteArrayRO uSource(env, source);
+    ScopedCharArrayRO uSource(env, source);
     if (uSource.get() == NULL) {
         return U_ILLEGAL_ARGUMENT_ERROR;
     }
-    ScopedCharArrayRW uTarget(env, target);
+    ScopedByteArrayRW uTarget(env, target);
     if (uTarget.get() == NULL) {
         return U_ILLEGAL_ARGUMENT_ERROR;
     }
@@ -147,18 +218,45 @@ static jint NativeConverter_decode(JNIEnv* env, jclass, jlong address,
     if (myData.get() == NULL) {
         return U_ILLEGAL_ARGUMENT_ERROR;
     }
+    return encode(cnv, uSource.get(), sourceEnd, reinterpret_cast<char*>(uTarget.get()),
+            targetEnd, &myData[0], flush);
+}
+
+static jint NativeConverter_encodeDirect(JNIEnv* env, jclass, jlong address,
+        jcharArray source, jint sourceEnd, jint targetAddress, jint targetEnd,
+        jintArray data, jboolean flush) {
 
+    UConverter* cnv = toUConverter(address);
+    if (cnv == NULL) {
+        return U_ILLEGAL_ARGUMENT_ERROR;
+    }
+    ScopedCharArrayRO uSource(env, source);
+    if (uSource.get() == NULL) {
+        return U_ILLEGAL_ARGUMENT_ERROR;
+    }
+    ScopedIntArrayRW myData(env, data);
+    if (myData.get() == NULL) {
+        return U_ILLEGAL_ARGUMENT_ERROR;
+    }
+    char* target = reinterpret_cast<char*>(static_cast<uintptr_t>(targetAddress));
+    return encode(cnv, uSource.get(), sourceEnd, target, targetEnd, &myData[0], flush);
+}
+
+// Converts from 'source' to 'target', which are the starts of the caller's arrays or buffers;
+// 'myData' holds the offsets to start at, as described in NativeConverter.java.
+static jint decode(UConverter* cnv, const char* source, jint sourceEnd, UChar* target,
+        jint targetEnd, jint* myData, jboolean flush) {
     // Do the conversion.
     jint* sourceOffset = &myData[0];
     jint* targetOffset = &myData[1];
-    const char* mySource = reinterpret_cast<const char*>(uSource.get() + *sourceOffset);
-    const char* mySourceLimit = reinterpret_cast<const char*>(uSource.get() + sourceEnd);
-    UChar* cTarget = uTarget.get() + *targetOffset;
-    const UChar* cTargetLimit = uTarget.get() + targetEnd;
+    const char* mySource = source + *sourceOffset;
+    const char* mySourceLimit = source + sourceEnd;
+    UChar* cTarget = target + *targetOffset;
+    const UChar* cTargetLimit = target + targetEnd;
     UErrorCode errorCode = U_ZERO_ERROR;
     ucnv_toUnicode(cnv, &cTarget, cTargetLimit, &mySource, mySourceLimit, NULL, flush, &errorCode);
-    *sourceOffset = mySource - reinterpret_cast<const char*>(uSource.get()) - *sourceOffset;
-    *targetOffset = cTarget - uTarget.get() - *targetOffset;
+    *sourceOffset = mySource - source - *sourceOffset;
+    *targetOffset = cTarget - target - *targetOffset;
 
     // Check how much more input is necessary to complete what's in the converter's internal buffer.
     UErrorCode minorErrorCode = U_ZERO_ERROR;
@@ -178,6 +276,50 @@ static jint NativeConverter_decode(JNIEnv* env, jclass, jlong address,
     return errorCode;
 }
 
+static jint NativeConverter_decode(JNIEnv* env, jclass, jlong address,
+        jbyteArray source, jint sourceEnd, jcharArray target, jint targetEnd,
+        jintArray data, jboolean flush) {
+
+    UConverter* cnv = toUConverter(address);
+    if (cnv == NULL) {
+        return U_ILLEGAL_ARGUMENT_ERROR;
+    }
+    ScopedByteArrayRO uSource(env, source);
+    if (uSource.get() == NULL) {
+        return U_ILLEGAL_ARGUMENT_ERROR;
+    }
+    ScopedCharArrayRW uTarget(env, target);
+    if (uTarget.get() == NULL) {
+        return U_ILLEGAL_ARGUMENT_ERROR;
+    }
+    ScopedIntArrayRW myData(env, data);
+    if (myData.get() == NULL) {
+        return U_ILLEGAL_ARGUMENT_ERROR;
+    }
+    return decode(cnv, reinterpret_cast<const char*>(uSource.get()), sourceEnd, uTarget.get(),
+            targetEnd, &myData[0], flush);
+}
+
+static jint NativeConverter_decodeDirect(JNIEnv* env, jclass, jlong address,
+        jint sourceAddress, jint sourceEnd, jcharArray target, jint targetEnd,
+        jintArray data, jboolean flush) {
+
+    UConverter* cnv = toUConverter(address);
+    if (cnv == NULL) {
+        return U_ILLEGAL_ARGUMENT_ERROR;
+    }
+    ScopedCharArrayRW uTarget(env, target);
+    if (uTarget.get() == NULL) {
+        return U_ILLEGAL_ARGUMENT_ERROR;
+    }
+    ScopedIntArrayRW myData(env, data);
+    if (myData.get() == NULL) {
+        return U_ILLEGAL_ARGUMENT_ERROR;
+    }
+    const char* source = reinterpret_cast<const char*>(static_cast<uintptr_t>(sourceAddress));
+    return decode(cnv, source, sourceEnd, uTarget.get(), targetEnd, &myData[0], flush);
+}
+
 static void NativeConverter_resetByteToChar(JNIEnv*, jclass, jlong address) {
     UConverter* cnv = toUConverter(address);
     if (cnv) {
@@ -290,15 +432,15 @@ static jboolean NativeConverter_canEncode(JNIEnv*, jclass, jlong address, jint c
  * the registry must be valid aliases. If a supported charset is not listed in the IANA
  * registry then its canonical name must begin with one of the strings "X-" or "x-".
  */
-static jstring getJavaCanonicalName(JNIEnv* env, const char* icuCanonicalName) {
+static std::string getJavaCanonicalName(const char* icuCanonicalName) {
     UErrorCode status = U_ZERO_ERROR;
 
     // Check to see if this is a well-known MIME or IANA name.
     const char* cName = NULL;
     if ((cName = ucnv_getStandardName(icuCanonicalName, "MIME", &status)) != NULL) {
-        return env->NewStringUTF(cName);
+        return cName;
     } else if ((cName = ucnv_getStandardName(icuCanonicalName, "IANA", &status)) != NULL) {
-        return env->NewStringUTF(cName);
+        return cName;
     }
 
     // Check to see if an alias already exists with "x-" prefix, if yes then
@@ -307,7 +449,7 @@ static jstring getJavaCanonicalName(JNIEnv* env, const char* icuCanonicalName) {
     for (int i = 0; i < aliasCount; ++i) {
         const char* name = ucnv_getAlias(icuCanonicalName, i, &status);
         if (name != NULL && name[0] == 'x' && name[1] == '-') {
-            return env->NewStringUTF(name);
+            return name;
         }
     }
 
@@ -321,24 +463,53 @@ static jstring getJavaCanonicalName(JNIEnv* env, const char* icuCanonicalName) {
     if (name == NULL) {
         name = icuCanonicalName;
     }
-    UniquePtr<char[]> result(new char[2 + strlen(name) + 1]);
-    strcpy(&result[0], "x-");
-    strcat(&result[0], name);
-    return env->NewStringUTF(&result[0]);
+    return std::string("x-") + name;
 }
 
+/*
+ * The set of converters can't change while we're running, so the list of their names is only
+ * built once. Callers get their own copy of the array, but the strings in it are shared.
+ */
+static pthread_mutex_t gAvailableCharsetNamesMutex = PTHREAD_MUTEX_INITIALIZER;
+static jobjectArray gAvailableCharsetNames = NULL;
+
 static jobjectArray NativeConverter_getAvailableCharsetNames(JNIEnv* env, jclass) {
-    int32_t num = ucnv_countAvailable();
+    ScopedPthreadMutexLock lock(&gAvailableCharsetNamesMutex);
+    if (gAvailableCharsetNames == NULL) {
+        int32_t num = ucnv_countAvailable();
+        ScopedLocalRef<jobjectArray> names(env,
+                env->NewObjectArray(num, JniConstants::stringClass, NULL));
+        if (names.get() == NULL) {
+            return NULL;
+        }
+        for (int i = 0; i < num; ++i) {
+            const char* name = ucnv_getAvailableName(i);
+            ScopedLocalRef<jstring> javaCanonicalName(env,
+                    env->NewStringUTF(getJavaCanonicalName(name).c_str()));
+            if (javaCanonicalName.get() == NULL) {
+                return NULL;
+            }
+            env->SetObjectArrayElement(names.get(), i, javaCanonicalName.get());
+        }
+        gAvailableCharsetNames = reinterpret_cast<jobjectArray>(env->NewGlobalRef(names.get()));
+        if (gAvailableCharsetNames == NULL) {
+            return NULL;
+        }
+    }
+
+    jsize num = env->GetArrayLength(gAvailableCharsetNames);
     jobjectArray result = env->NewObjectArray(num, JniConstants::stringClass, NULL);
-    for (int i = 0; i < num; ++i) {
-        const char* name = ucnv_getAvailableName(i);
-        ScopedLocalRef<jstring> javaCanonicalName(env, getJavaCanonicalName(env, name));
-        env->SetObjectArrayElement(result, i, javaCanonicalName.get());
+    if (result == NULL) {
+        return NULL;
+    }
+    for (jsize i = 0; i < num; ++i) {
+        ScopedLocalRef<jobject> name(env, env->GetObjectArrayElement(gAvailableCharsetNames, i));
+        env->SetObjectArrayElement(result, i, name.get());
     }
     return result;
 }
 
-static jobjectArray getAliases(JNIEnv* env, const char* icuCanonicalName) {
+static bool getAliases(const char* icuCanonicalName, std::vector<std::string>& aliases) {
     // Get an upper bound on the number of aliases...
     const char* myEncName = icuCanonicalName;
     UErrorCode error = U_ZERO_ERROR;
@@ -348,30 +519,21 @@ static jobjectArray getAliases(JNIEnv* env, const char* icuCanonicalName) {
         aliasCount = ucnv_countAliases(myEncName, &error);
     }
     if (!U_SUCCESS(error)) {
-        return NULL;
+        return false;
     }
 
     // Collect the aliases we want...
-    const char* aliasArray[aliasCount];
-    int actualAliasCount = 0;
     for(int i = 0; i < aliasCount; ++i) {
         const char* name = ucnv_getAlias(myEncName, (uint16_t) i, &error);
         if (!U_SUCCESS(error)) {
-            return NULL;
+            return false;
         }
         // TODO: why do we ignore these ones?
         if (strchr(name, '+') == 0 && strchr(name, ',') == 0) {
-            aliasArray[actualAliasCount++]= name;
+            aliases.push_back(name);
         }
     }
-
-    // Convert our C++ char*[] into a Java String[]...
-    jobjectArray result = env->NewObjectArray(actualAliasCount, JniConstants::stringClass, NULL);
-    for (int i = 0; i < actualAliasCount; ++i) {
-        ScopedLocalRef<jstring> alias(env, env->NewStringUTF(aliasArray[i]));
-        env->SetObjectArrayElement(result, i, alias.get());
-    }
-    return result;
+    return true;
 }
 
 static const char* getICUCanonicalName(const char* name) {
@@ -413,7 +575,7 @@ static void CHARSET_ENCODER_CALLBACK(const void* rawContext, UConverterFromUnico
         ctx->onMalformedInput(ctx, args, codeUnits, length, codePoint, reason, status);
         return;
     case UCNV_CLOSE:
-        delete ctx;
+        gEncoderCallbackContexts.put(ctx);
         return;
     default:
         *status = U_ILLEGAL_ARGUMENT_ERROR;
@@ -461,7 +623,7 @@ static jint NativeConverter_setCallbackEncode(JNIEnv* env, jclass, jlong address
     EncoderCallbackContext* fromUNewContext=NULL;
     UConverterFromUCallback fromUNewAction=NULL;
     if (fromUOldContext == NULL) {
-        fromUNewContext = new EncoderCallbackContext;
+        fromUNewContext = gEncoderCallbackContexts.take();
         fromUNewAction = CHARSET_ENCODER_CALLBACK;
     } else {
         fromUNewContext = const_cast<EncoderCallbackContext*>(
@@ -526,7 +688,7 @@ static void CHARSET_DECODER_CALLBACK(const void* rawContext, UConverterToUnicode
         ctx->onMalformedInput(ctx, args, codeUnits, length, reason, status);
         return;
     case UCNV_CLOSE:
-        delete ctx;
+        gDecoderCallbackContexts.put(ctx);
         return;
     default:
         *status = U_ILLEGAL_ARGUMENT_ERROR;
@@ -552,7 +714,7 @@ static jint NativeConverter_setCallbackDecode(JNIEnv* env, jclass, jlong address
     DecoderCallbackContext* toUNewContext = NULL;
     UConverterToUCallback toUNewAction = NULL;
     if (toUOldContext == NULL) {
-        toUNewContext = new DecoderCallbackContext;
+        toUNewContext = gDecoderCallbackContexts.take();
         toUNewAction = CHARSET_DECODER_CALLBACK;
     } else {
         toUNewContext = const_cast<DecoderCallbackContext*>(
@@ -621,37 +783,109 @@ static jboolean NativeConverter_contains(JNIEnv* env, jclass, jstring name1, jst
     return U_SUCCESS(errorCode) && set1.containsAll(set2);
 }
 
+/*
+ * Everything charsetForName needs to know about a charset, worked out from ICU's alias tables
+ * the first time the charset is asked for.
+ */
+struct CharsetInfo {
+    std::string icuCanonicalName;
+    std::string javaCanonicalName;
+    std::vector<std::string> aliases;
+};
+
+/*
+ * Every name a charset has been asked for by, mapped to what we found out about it. ICU matches
+ * names loosely, so there are endless spellings of each one; we stop remembering new ones once
+ * there are this many, rather than let a caller with made-up names grow the index without limit.
+ */
+static const size_t kMaxCharsetIndexNames = 1024;
+
+typedef std::map<std::string, CharsetInfo*> CharsetIndex;
+static CharsetIndex gCharsetsByName;
+static CharsetIndex gCharsetsByIcuName;
+static pthread_mutex_t gCharsetIndexMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Returns what we know about the charset called 'name', or NULL if there's no such charset.
+static const CharsetInfo* findCharset(const char* name) {
+    ScopedPthreadMutexLock lock(&gCharsetIndexMutex);
+    CharsetIndex::iterator it = gCharsetsByName.find(name);
+    if (it != gCharsetsByName.end()) {
+        return it->second;
+    }
+
+    // Get ICU's canonical name for this charset.
+    const char* icuCanonicalName = getICUCanonicalName(name);
+    if (icuCanonicalName == NULL) {
+        return NULL;
+    }
+
+    CharsetInfo* info;
+    it = gCharsetsByIcuName.find(icuCanonicalName);
+    if (it != gCharsetsByIcuName.end()) {
+        info = it->second;
+    } else {
+        // Check that this charset is supported.
+        // ICU doesn't offer any "isSupported", so we see whether we can open it. The converter
+        // stays around as the template for the encoders and decoders we're about to be asked for.
+        {
+            ScopedPthreadMutexLock templatesLock(&gConverterTemplatesMutex);
+            UErrorCode dummy = U_ZERO_ERROR;
+            if (getConverterTemplate(icuCanonicalName, &dummy) == NULL) {
+                return NULL;
+            }
+        }
+
+        UniquePtr<CharsetInfo> newInfo(new CharsetInfo);
+        newInfo->icuCanonicalName = icuCanonicalName;
+        // Get Java's canonical name for this charset.
+        newInfo->javaCanonicalName = getJavaCanonicalName(icuCanonicalName);
+        // Get the aliases for this charset.
+        if (!getAliases(icuCanonicalName, newInfo->aliases)) {
+            return NULL;
+        }
+        info = newInfo.release();
+        gCharsetsByIcuName[info->icuCanonicalName] = info;
+    }
+
+    if (gCharsetsByName.size() < kMaxCharsetIndexNames) {
+        gCharsetsByName[name] = info;
+    }
+    return info;
+}
+
 static jobject NativeConverter_charsetForName(JNIEnv* env, jclass, jstring charsetName) {
     ScopedUtfChars charsetNameChars(env, charsetName);
     if (charsetNameChars.c_str() == NULL) {
         return NULL;
     }
-    // Get ICU's canonical name for this charset.
-    const char* icuCanonicalName = getICUCanonicalName(charsetNameChars.c_str());
-    if (icuCanonicalName == NULL) {
+    const CharsetInfo* info = findCharset(charsetNameChars.c_str());
+    if (info == NULL) {
         return NULL;
     }
-    // Get Java's canonical name for this charset.
-    jstring javaCanonicalName = getJavaCanonicalName(env, icuCanonicalName);
-    if (env->ExceptionOccurred()) {
+
+    ScopedLocalRef<jstring> javaCanonicalName(env,
+            env->NewStringUTF(info->javaCanonicalName.c_str()));
+    if (javaCanonicalName.get() == NULL) {
         return NULL;
     }
-
-    // Check that this charset is supported.
-    // ICU doesn't offer any "isSupported", so we just open and immediately close.
-    // We ignore the UErrorCode because ucnv_open returning NULL is all the information we need.
-    UErrorCode dummy = U_ZERO_ERROR;
-    UniqueUConverter cnv(ucnv_open(icuCanonicalName, &dummy));
-    if (cnv.get() == NULL) {
+    ScopedLocalRef<jstring> icuCanonicalName(env,
+            env->NewStringUTF(info->icuCanonicalName.c_str()));
+    if (icuCanonicalName.get() == NULL) {
         return NULL;
     }
-    cnv.reset();
-
-    // Get the aliases for this charset.
-    jobjectArray aliases = getAliases(env, icuCanonicalName);
-    if (env->ExceptionOccurred()) {
+    // Convert our aliases into a Java String[]...
+    ScopedLocalRef<jobjectArray> aliases(env,
+            env->NewObjectArray(info->aliases.size(), JniConstants::stringClass, NULL));
+    if (aliases.get() == NULL) {
         return NULL;
     }
+    for (size_t i = 0; i < info->aliases.size(); ++i) {
+        ScopedLocalRef<jstring> alias(env, env->NewStringUTF(info->aliases[i].c_str()));
+        if (alias.get() == NULL) {
+            return NULL;
+        }
+        env->SetObjectArrayElement(aliases.get(), i, alias.get());
+    }
 
     // Construct the CharsetICU object.
     jmethodID charsetConstructor = env->GetMethodID(JniConstants::charsetICUClass, "<init>",
@@ -660,7 +894,7 @@ static jobject NativeConverter_charsetForName(JNIEnv* env, jclass, jstring chars
         return NULL;
     }
     return env->NewObject(JniConstants::charsetICUClass, charsetConstructor,
-            javaCanonicalName, env->NewStringUTF(icuCanonicalName), aliases);
+            javaCanonicalName.get(), icuCanonicalName.get(), aliases.get());
 }
 
 static JNINativeMethod gMethods[] = {
@@ -669,7 +903,9 @@ static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(NativeConverter, closeConverter, "(J)V"),
     NATIVE_METHOD(NativeConverter, contains, "(Ljava/lang/String;Ljava/lang/String;)Z"),
     NATIVE_METHOD(NativeConverter, decode, "(J[BI[CI[IZ)I"),
+    NATIVE_METHOD(NativeConverter, decodeDirect, "(JII[CI[IZ)I"),
     NATIVE_METHOD(NativeConverter, encode, "(J[CI[BI[IZ)I"),
+    NATIVE_METHOD(NativeConverter, encodeDirect, "(J[CII[IZ)I"),
     NATIVE_METHOD(NativeConverter, flushByteToChar, "(J[CI[I)I"),
     NATIVE_METHOD(NativeConverter, flushCharToByte, "(J[BI[I)I"),
     NATIVE_METHOD(NativeConverter, getAvailableCharsetNames, "()[Ljava/lang/String;"),
@@ -31,8 +31,10 @@
 #include "unicode/unum.h"
 #include "unicode/ustring.h"
 #include "valueOf.h"
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
+#include <algorithm>
 
 static DecimalFormat* toDecimalFormat(jint addr) {
     return reinterpret_cast<DecimalFormat*>(static_cast<uintptr_t>(addr));
@@ -222,6 +224,101 @@ static jcharArray formatResult(JNIEnv* env, const UnicodeString &str, FieldPosit
     return result;
 }
 
+// Enough for any integer formatSimple will take on: a sign, 19 digits and 18 separators, a
+// decimal separator and MAX_SIMPLE_FRACTION_DIGITS zeros.
+static const int MAX_SIMPLE_FRACTION_DIGITS = 16;
+static const size_t SIMPLE_FORMAT_CAPACITY = 64;
+
+// Returns the symbol if it's a single char, and 0 otherwise.
+static jchar singleCharSymbol(const DecimalFormatSymbols* symbols,
+        DecimalFormatSymbols::ENumberFormatSymbol symbol) {
+    UnicodeString s(symbols->getSymbol(symbol));
+    return (s.length() == 1) ? s.charAt(0) : 0;
+}
+
+/**
+ * Formats 'value' straight into 'dst', which must have room for SIMPLE_FORMAT_CAPACITY chars,
+ * if 'fmt' is simple enough that the result is just a minus sign, digits, grouping separators
+ * and maybe a decimal separator followed by zeros. That covers patterns like "#,##0" and
+ * "#,##0.00", which is what most reports use. Returns the length, or -1 if ICU's general
+ * formatter is needed.
+ */
+static int formatSimple(DecimalFormat* fmt, jlong value, jchar* dst) {
+    if (fmt->getMultiplier() != 1 || fmt->isScientificNotation() ||
+            fmt->areSignificantDigitsUsed() || fmt->isDecimalSeparatorAlwaysShown() ||
+            fmt->getFormatWidth() != 0 || fmt->getRoundingIncrement() != 0.0) {
+        return -1;
+    }
+    int minFractionDigits = fmt->getMinimumFractionDigits();
+    if (minFractionDigits > MAX_SIMPLE_FRACTION_DIGITS) {
+        return -1;
+    }
+    int groupingSize = fmt->isGroupingUsed() ? fmt->getGroupingSize() : 0;
+    int secondaryGroupingSize = fmt->getSecondaryGroupingSize();
+    if (secondaryGroupingSize > 0 && secondaryGroupingSize != groupingSize) {
+        return -1;
+    }
+    UnicodeString affix;
+    if (fmt->getPositivePrefix(affix).length() != 0 || fmt->getPositiveSuffix(affix).length() != 0
+            || fmt->getNegativeSuffix(affix).length() != 0
+            || fmt->getNegativePrefix(affix).length() != 1) {
+        return -1;
+    }
+    jchar minus = affix.charAt(0);
+    const DecimalFormatSymbols* symbols = fmt->getDecimalFormatSymbols();
+    jchar zero = singleCharSymbol(symbols, DecimalFormatSymbols::kZeroDigitSymbol);
+    jchar grouping = singleCharSymbol(symbols, DecimalFormatSymbols::kGroupingSeparatorSymbol);
+    jchar decimal = singleCharSymbol(symbols, DecimalFormatSymbols::kDecimalSeparatorSymbol);
+    if (zero == 0 || (groupingSize > 0 && grouping == 0) || (minFractionDigits > 0 && decimal == 0)) {
+        return -1;
+    }
+
+    // Collect the digits, least significant first.
+    jchar digits[20];
+    int digitCount = 0;
+    uint64_t magnitude = (value < 0) ? -static_cast<uint64_t>(value) : value;
+    while (magnitude != 0) {
+        digits[digitCount++] = zero + (magnitude % 10);
+        magnitude /= 10;
+    }
+    int integerDigitCount = std::max(digitCount, fmt->getMinimumIntegerDigits());
+    if (integerDigitCount > fmt->getMaximumIntegerDigits() || integerDigitCount > 20) {
+        // ICU would drop the high digits.
+        return -1;
+    }
+
+    jchar* p = dst;
+    if (value < 0) {
+        *p++ = minus;
+    }
+    for (int i = integerDigitCount - 1; i >= 0; --i) {
+        *p++ = (i < digitCount) ? digits[i] : zero;
+        if (i > 0 && groupingSize > 0 && i % groupingSize == 0) {
+            *p++ = grouping;
+        }
+    }
+    if (minFractionDigits > 0) {
+        *p++ = decimal;
+        for (int i = 0; i < minFractionDigits; ++i) {
+            *p++ = zero;
+        }
+    } else if (integerDigitCount == 0) {
+        // Like ICU, never format a number as nothing at all.
+        *p++ = zero;
+    }
+    return p - dst;
+}
+
+static int formatSimple(DecimalFormat* fmt, jdouble value, jchar* dst) {
+    // Only integers are easy: anything else needs ICU's rounding. Every double this side of
+    // 2^53 that equals its floor is exactly a jlong.
+    if (!(value > -9007199254740992.0 && value < 9007199254740992.0) || value != floor(value)
+            || (value == 0 && signbit(value))) {
+        return -1;
+    }
+    return formatSimple(fmt, static_cast<jlong>(value), dst);
+}
+
 template <typename T>
 static jcharArray format(JNIEnv* env, jint addr, jobject fpIter, T val) {
     UErrorCode status = U_ZERO_ERROR;
@@ -233,12 +330,59 @@ static jcharArray format(JNIEnv* env, jint addr, jobject fpIter, T val) {
     return formatResult(env, str, pfpi, fpIter);
 }
 
+template <typename T>
+static jcharArray formatNumber(JNIEnv* env, jint addr, jobject fpIter, T val) {
+    if (fpIter == NULL) {
+        jchar chars[SIMPLE_FORMAT_CAPACITY];
+        int length = formatSimple(toDecimalFormat(addr), val, chars);
+        if (length != -1) {
+            jcharArray result = env->NewCharArray(length);
+            if (result != NULL) {
+                env->SetCharArrayRegion(result, 0, length, chars);
+            }
+            return result;
+        }
+    }
+    return format(env, addr, fpIter, val);
+}
+
+/**
+ * Formats 'val' into the caller's char[], copying nothing if it doesn't fit. Returns the length
+ * of the result either way, so the caller can grow its array and try again.
+ */
+template <typename T>
+static jint formatInto(JNIEnv* env, jint addr, T val, jcharArray javaDst) {
+    DecimalFormat* fmt = toDecimalFormat(addr);
+    jchar chars[SIMPLE_FORMAT_CAPACITY];
+    int length = formatSimple(fmt, val, chars);
+    const jchar* result = chars;
+    UnicodeString str;
+    if (length == -1) {
+        UErrorCode status = U_ZERO_ERROR;
+        fmt->format(val, str, NULL, status);
+        result = str.getBuffer();
+        length = str.length();
+    }
+    if (length <= env->GetArrayLength(javaDst)) {
+        env->SetCharArrayRegion(javaDst, 0, length, result);
+    }
+    return length;
+}
+
 static jcharArray NativeDecimalFormat_formatLong(JNIEnv* env, jclass, jint addr, jlong value, jobject fpIter) {
-    return format(env, addr, fpIter, value);
+    return formatNumber(env, addr, fpIter, value);
 }
 
 static jcharArray NativeDecimalFormat_formatDouble(JNIEnv* env, jclass, jint addr, jdouble value, jobject fpIter) {
-    return format(env, addr, fpIter, value);
+    return formatNumber(env, addr, fpIter, value);
+}
+
+static jint NativeDecimalFormat_formatLongInto(JNIEnv* env, jclass, jint addr, jlong value, jcharArray dst) {
+    return formatInto(env, addr, value, dst);
+}
+
+static jint NativeDecimalFormat_formatDoubleInto(JNIEnv* env, jclass, jint addr, jdouble value, jcharArray dst) {
+    return formatInto(env, addr, value, dst);
 }
 
 static jcharArray NativeDecimalFormat_formatDigitList(JNIEnv* env, jclass, jint addr, jstring value, jobject fpIter) {
@@ -337,7 +481,9 @@ static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(NativeDecimalFormat, cloneImpl, "(I)I"),
     NATIVE_METHOD(NativeDecimalFormat, close, "(I)V"),
     NATIVE_METHOD(NativeDecimalFormat, formatDouble, "(IDLlibcore/icu/NativeDecimalFormat$FieldPositionIterator;)[C"),
+    NATIVE_METHOD(NativeDecimalFormat, formatDoubleInto, "(ID[C)I"),
     NATIVE_METHOD(NativeDecimalFormat, formatLong, "(IJLlibcore/icu/NativeDecimalFormat$FieldPositionIterator;)[C"),
+    NATIVE_METHOD(NativeDecimalFormat, formatLongInto, "(IJ[C)I"),
     NATIVE_METHOD(NativeDecimalFormat, formatDigitList, "(ILjava/lang/String;Llibcore/icu/NativeDecimalFormat$FieldPositionIterator;)[C"),
     NATIVE_METHOD(NativeDecimalFormat, getAttribute, "(II)I"),
     NATIVE_METHOD(NativeDecimalFormat, getTextAttribute, "(II)Ljava/lang/String;"),
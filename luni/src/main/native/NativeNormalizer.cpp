@@ -20,29 +20,112 @@
 #include "JNIHelp.h"
 #include "JniConstants.h"
 #include "ScopedJavaUnicodeString.h"
-#include "unicode/normlzr.h"
+#include "ScopedLocalRef.h"
+#include "unicode/normalizer2.h"
+#include "unicode/unorm.h"
 
-static jstring NativeNormalizer_normalizeImpl(JNIEnv* env, jclass, jstring s, jint intMode) {
+/**
+ * Returns ICU's shared normalizer for the given UNormalizationMode. These are owned by ICU and
+ * safe to use from any thread.
+ */
+static const Normalizer2* getNormalizer(jint intMode, UErrorCode& errorCode) {
+    switch (static_cast<UNormalizationMode>(intMode)) {
+    case UNORM_NFC:
+        return Normalizer2::getInstance(NULL, "nfc", UNORM2_COMPOSE, errorCode);
+    case UNORM_NFD:
+        return Normalizer2::getInstance(NULL, "nfc", UNORM2_DECOMPOSE, errorCode);
+    case UNORM_NFKC:
+        return Normalizer2::getInstance(NULL, "nfkc", UNORM2_COMPOSE, errorCode);
+    case UNORM_NFKD:
+        return Normalizer2::getInstance(NULL, "nfkc", UNORM2_DECOMPOSE, errorCode);
+    default:
+        errorCode = U_ILLEGAL_ARGUMENT_ERROR;
+        return NULL;
+    }
+}
+
+/**
+ * Returns 's' normalized, or 's' itself if it already was. Most strings are, and the quick check
+ * finds that out without building a normalized copy. Otherwise only the part after the longest
+ * normalized prefix goes through the full normalization.
+ */
+static jstring normalize(JNIEnv* env, jstring s, const Normalizer2* normalizer, UErrorCode& errorCode) {
     ScopedJavaUnicodeString src(env, s);
-    UNormalizationMode mode = static_cast<UNormalizationMode>(intMode);
+    const UnicodeString& in(src.unicodeString());
+    int32_t normalizedLength = normalizer->spanQuickCheckYes(in, errorCode);
+    if (U_FAILURE(errorCode)) {
+        return NULL;
+    }
+    if (normalizedLength == in.length()) {
+        return s;
+    }
+    UnicodeString dst(in, 0, normalizedLength);
+    UnicodeString rest(false, in.getBuffer() + normalizedLength, in.length() - normalizedLength);
+    normalizer->normalizeSecondAndAppend(dst, rest, errorCode);
+    if (U_FAILURE(errorCode) || dst.isBogus()) {
+        return NULL;
+    }
+    return env->NewString(dst.getBuffer(), dst.length());
+}
+
+static jstring NativeNormalizer_normalizeImpl(JNIEnv* env, jclass, jstring s, jint intMode) {
     UErrorCode errorCode = U_ZERO_ERROR;
-    UnicodeString dst;
-    Normalizer::normalize(src.unicodeString(), mode, 0, dst, errorCode);
+    const Normalizer2* normalizer = getNormalizer(intMode, errorCode);
+    jstring result = (normalizer != NULL) ? normalize(env, s, normalizer, errorCode) : NULL;
     icu4jni_error(env, errorCode);
-    return dst.isBogus() ? NULL : env->NewString(dst.getBuffer(), dst.length());
+    return result;
+}
+
+static jobjectArray NativeNormalizer_normalizeAllImpl(JNIEnv* env, jclass, jobjectArray strings, jint intMode) {
+    if (strings == NULL) {
+        jniThrowNullPointerException(env, NULL);
+        return NULL;
+    }
+    UErrorCode errorCode = U_ZERO_ERROR;
+    const Normalizer2* normalizer = getNormalizer(intMode, errorCode);
+    if (icu4jni_error(env, errorCode)) {
+        return NULL;
+    }
+    jsize count = env->GetArrayLength(strings);
+    jobjectArray result = env->NewObjectArray(count, JniConstants::stringClass, NULL);
+    if (result == NULL) {
+        return NULL;
+    }
+    for (jsize i = 0; i < count; ++i) {
+        ScopedLocalRef<jstring> s(env,
+                reinterpret_cast<jstring>(env->GetObjectArrayElement(strings, i)));
+        if (s.get() == NULL) {
+            jniThrowNullPointerException(env, NULL);
+            return NULL;
+        }
+        jstring normalized = normalize(env, s.get(), normalizer, errorCode);
+        if (icu4jni_error(env, errorCode) || normalized == NULL) {
+            return NULL;
+        }
+        env->SetObjectArrayElement(result, i, normalized);
+        if (normalized != s.get()) {
+            env->DeleteLocalRef(normalized);
+        }
+    }
+    return result;
 }
 
 static jboolean NativeNormalizer_isNormalizedImpl(JNIEnv* env, jclass, jstring s, jint intMode) {
-    ScopedJavaUnicodeString src(env, s);
-    UNormalizationMode mode = static_cast<UNormalizationMode>(intMode);
     UErrorCode errorCode = U_ZERO_ERROR;
-    UBool result = Normalizer::isNormalized(src.unicodeString(), mode, errorCode);
+    const Normalizer2* normalizer = getNormalizer(intMode, errorCode);
+    if (icu4jni_error(env, errorCode)) {
+        return JNI_FALSE;
+    }
+    ScopedJavaUnicodeString src(env, s);
+    // Normalizer2 only does the full check on what follows the quick check's normalized prefix.
+    UBool result = normalizer->isNormalized(src.unicodeString(), errorCode);
     icu4jni_error(env, errorCode);
     return result;
 }
 
 static JNINativeMethod gMethods[] = {
   NATIVE_METHOD(NativeNormalizer, normalizeImpl, "(Ljava/lang/String;I)Ljava/lang/String;"),
+  NATIVE_METHOD(NativeNormalizer, normalizeAllImpl, "([Ljava/lang/String;I)[Ljava/lang/String;"),
   NATIVE_METHOD(NativeNormalizer, isNormalizedImpl, "(Ljava/lang/String;I)Z"),
 };
 void register_libcore_icu_NativeNormalizer(JNIEnv* env) {
@@ -18,8 +18,12 @@
 
 #include "JniConstants.h"
 #include "ScopedLocalFrame.h"
+#include "ScopedPthreadMutexLock.h"
+#include "ScopedStartupTimer.h"
+#include "ScopedUtfChars.h"
 
 #include <stdlib.h>
+#include <string.h>
 namespace android {
     extern void register_dalvik_system_TouchDex(JNIEnv* env);
 }
@@ -59,8 +63,11 @@ REGISTER_bis(register_libcore_icu_NativeIDN);
 REGISTER_bis(register_libcore_icu_NativeNormalizer);
 REGISTER_bis(register_libcore_icu_NativePluralRules);
 REGISTER_bis(register_libcore_icu_TimeZones);
+REGISTER_bis(register_libcore_io_DirectoryStream);
+REGISTER_bis(register_libcore_io_FileStatus);
 REGISTER_bis(register_libcore_io_IoUtils);
 REGISTER_bis(register_libcore_io_OsConstants);
+REGISTER_bis(register_libcore_math_BulkMath);
 REGISTER_bis(register_org_apache_harmony_luni_platform_OSFileSystem);
 REGISTER_bis(register_org_apache_harmony_luni_platform_OSMemory);
 REGISTER_bis(register_org_apache_harmony_luni_platform_OSNetworkSystem);
@@ -69,8 +76,83 @@ REGISTER_bis(register_java_text_Bidi);
 REGISTER_bis(register_org_apache_harmony_xnet_provider_jsse_NativeCrypto);
 REGISTER_bis(register_org_apache_harmony_dalvik_NativeTestTarget);
 REGISTER_bis(register_org_apache_harmony_xml_ExpatParser);
+REGISTER_bis(register_org_json_JSONTokener);
+
+#define REGISTER(FN) extern void FN(JNIEnv*); { ScopedStartupTimer timer("register", #FN); FN(env); }
+
+// The subsystems below aren't needed by most processes, so their natives are only registered when
+// the first of their classes is initialized. Each class with natives in one of them must call
+// libcore.util.NativeSubsystems.ensureRegistered from its static initializer.
+static void registerCrypto(JNIEnv* env) {
+    REGISTER(register_org_apache_harmony_xnet_provider_jsse_NativeCrypto);
+}
+
+static void registerExpat(JNIEnv* env) {
+    REGISTER(register_org_apache_harmony_xml_ExpatParser);
+}
+
+static void registerIcu(JNIEnv* env) {
+    JniConstants::initIcu(env);
+    REGISTER(register_java_text_Bidi);
+    REGISTER(register_libcore_icu_ICU);
+    REGISTER(register_libcore_icu_NativeBreakIterator);
+    REGISTER(register_libcore_icu_NativeCollation);
+    REGISTER(register_libcore_icu_NativeConverter);
+    REGISTER(register_libcore_icu_NativeDecimalFormat);
+    REGISTER(register_libcore_icu_NativeIDN);
+    REGISTER(register_libcore_icu_NativeNormalizer);
+    REGISTER(register_libcore_icu_NativePluralRules);
+    REGISTER(register_libcore_icu_TimeZones);
+}
+
+struct LazySubsystem {
+    const char* name;
+    void (*registerNatives)(JNIEnv*);
+    bool registered;
+};
+
+static LazySubsystem gLazySubsystems[] = {
+    { "crypto", registerCrypto, false },
+    { "expat", registerExpat, false },
+    { "icu", registerIcu, false },
+};
+
+static pthread_mutex_t gLazySubsystemsMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void NativeSubsystems_ensureRegistered(JNIEnv* env, jclass, jstring javaName) {
+    ScopedUtfChars name(env, javaName);
+    if (name.c_str() == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < NELEM(gLazySubsystems); ++i) {
+        LazySubsystem& subsystem = gLazySubsystems[i];
+        if (strcmp(name.c_str(), subsystem.name) != 0) {
+            continue;
+        }
+        ScopedPthreadMutexLock lock(&gLazySubsystemsMutex);
+        if (!subsystem.registered) {
+            ScopedLocalFrame localFrame(env);
+            ScopedStartupTimer timer("subsystem", subsystem.name);
+            subsystem.registerNatives(env);
+            subsystem.registered = true;
+        }
+        return;
+    }
+    jniThrowExceptionFmt(env, "java/lang/IllegalArgumentException",
+            "unknown native subsystem: %s", name.c_str());
+}
+
+static JNINativeMethod gNativeSubsystemsMethods[] = {
+    NATIVE_METHOD(NativeSubsystems, ensureRegistered, "(Ljava/lang/String;)V"),
+};
+static void register_libcore_util_NativeSubsystems(JNIEnv* env) {
+    jniRegisterNativeMethods(env, "libcore/util/NativeSubsystems",
+            gNativeSubsystemsMethods, NELEM(gNativeSubsystemsMethods));
+}
 
 // DalvikVM calls this on startup, so we can statically register all our native methods.
+// Set LIBCORE_STARTUP_TIMING in the environment to log how long each class lookup and
+// register_* call takes.
 int JNI_OnLoad(JavaVM* vm, void*) {
     JNIEnv* env;
     if (vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) != JNI_OK) {
@@ -79,10 +161,10 @@ int JNI_OnLoad(JavaVM* vm, void*) {
     }
 
     ScopedLocalFrame localFrame(env);
+    ScopedStartupTimer timer("JNI_OnLoad", "libjavacore");
 
     JniConstants::init(env);
 
-#define REGISTER(FN) extern void FN(JNIEnv*); FN(env)
     REGISTER(register_java_io_Console);
     REGISTER(register_java_io_File);
     REGISTER(register_java_io_FileDescriptor);
@@ -102,34 +184,30 @@ int JNI_OnLoad(JavaVM* vm, void*) {
     REGISTER(register_java_net_NetworkInterface);
     REGISTER(register_java_nio_ByteOrder);
     REGISTER(register_java_nio_charset_Charsets);
-    REGISTER(register_java_text_Bidi);
     REGISTER(register_java_util_regex_Matcher);
     REGISTER(register_java_util_regex_Pattern);
     REGISTER(register_java_util_zip_Adler32);
     REGISTER(register_java_util_zip_CRC32);
     REGISTER(register_java_util_zip_Deflater);
     REGISTER(register_java_util_zip_Inflater);
-    REGISTER(register_libcore_icu_ICU);
-    REGISTER(register_libcore_icu_NativeBreakIterator);
-    REGISTER(register_libcore_icu_NativeCollation);
-    REGISTER(register_libcore_icu_NativeConverter);
-    REGISTER(register_libcore_icu_NativeDecimalFormat);
-    REGISTER(register_libcore_icu_NativeIDN);
-    REGISTER(register_libcore_icu_NativeNormalizer);
-    REGISTER(register_libcore_icu_NativePluralRules);
-    REGISTER(register_libcore_icu_TimeZones);
+    REGISTER(register_libcore_io_DirectoryStream);
+    REGISTER(register_libcore_io_FileStatus);
     REGISTER(register_libcore_io_IoUtils);
     REGISTER(register_libcore_io_OsConstants);
+    REGISTER(register_libcore_math_BulkMath);
+    REGISTER(register_libcore_util_NativeSubsystems);
     REGISTER(register_org_apache_harmony_luni_platform_OSFileSystem);
     REGISTER(register_org_apache_harmony_luni_platform_OSMemory);
     REGISTER(register_org_apache_harmony_luni_platform_OSNetworkSystem);
     REGISTER(register_org_apache_harmony_luni_util_fltparse);
     REGISTER(register_org_apache_harmony_dalvik_NativeTestTarget);
-    REGISTER(register_org_apache_harmony_xml_ExpatParser);
-    REGISTER(register_org_apache_harmony_xnet_provider_jsse_NativeCrypto);
-#undef REGISTER
+    REGISTER(register_org_json_JSONTokener);
             // Initialize the Android classes last, as they have dependencies on the "corer" core classes.
-    android::register_dalvik_system_TouchDex(env);
+    {
+        ScopedStartupTimer timer("register", "register_dalvik_system_TouchDex");
+        android::register_dalvik_system_TouchDex(env);
+    }
 
     return JNI_VERSION_1_6;
 }
+#undef REGISTER
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SCOPED_STARTUP_TIMER_H_included
+#define SCOPED_STARTUP_TIMER_H_included
+
+#include "JNIHelp.h"
+
+#include <stdlib.h>
+#include <time.h>
+
+/**
+ * Logs how long a scope took, for breaking down where library load time goes. This only does
+ * anything if the LIBCORE_STARTUP_TIMING environment variable is set, so it's cheap enough to
+ * leave around every register_* call and class lookup.
+ */
+class ScopedStartupTimer {
+public:
+    ScopedStartupTimer(const char* what, const char* name) : mWhat(what), mName(name), mStart(0) {
+        if (isEnabled()) {
+            mStart = now();
+        }
+    }
+
+    ~ScopedStartupTimer() {
+        if (isEnabled()) {
+            ALOGI("%s %s: %lld us", mWhat, mName, (now() - mStart) / 1000);
+        }
+    }
+
+    static bool isEnabled() {
+        static const bool enabled = (getenv("LIBCORE_STARTUP_TIMING") != NULL);
+        return enabled;
+    }
+
+private:
+    static long long now() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<long long>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+    }
+
+    const char* mWhat;
+    const char* mName;
+    long long mStart;
+
+    // Disallow copy and assignment.
+    ScopedStartupTimer(const ScopedStartupTimer&);
+    void operator=(const ScopedStartupTimer&);
+};
+
+#endif  // SCOPED_STARTUP_TIMER_H_included
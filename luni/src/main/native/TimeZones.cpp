@@ -21,23 +21,13 @@
 #include "JniConstants.h"
 #include "ScopedJavaUnicodeString.h"
 #include "ScopedLocalRef.h"
+#include "ScopedPthreadMutexLock.h"
 #include "ScopedUtfChars.h"
 #include "UniquePtr.h"
 #include "unicode/smpdtfmt.h"
 #include "unicode/timezone.h"
-
-extern Locale getLocale(JNIEnv* env, jstring localeName);
-
-static jstring formatDate(JNIEnv* env, const SimpleDateFormat& fmt, const UDate& when) {
-    UnicodeString str;
-    fmt.format(when, str);
-    return env->NewString(str.getBuffer(), str.length());
-}
-
-static TimeZone* timeZoneFromId(JNIEnv* env, jstring javaZoneId) {
-    ScopedJavaUnicodeString zoneID(env, javaZoneId);
-    return TimeZone::createTimeZone(zoneID.unicodeString());
-}
+#include <map>
+#include <string>
 
 static jobjectArray TimeZones_forCountryCode(JNIEnv* env, jclass, jstring countryCode) {
     ScopedUtfChars countryChars(env, countryCode);
@@ -69,78 +59,172 @@ static jobjectArray TimeZones_forCountryCode(JNIEnv* env, jclass, jstring countr
     return result;
 }
 
-static jstring TimeZones_getDisplayNameImpl(JNIEnv* env, jclass, jstring zoneId, jboolean isDST, jint style, jstring localeId) {
-    UniquePtr<TimeZone> zone(timeZoneFromId(env, zoneId));
-    Locale locale = getLocale(env, localeId);
-    // Try to get the display name of the TimeZone according to the Locale
-    UnicodeString displayName;
-    zone->getDisplayName((UBool)isDST, (style == 0 ? TimeZone::SHORT : TimeZone::LONG), locale, displayName);
-    return env->NewString(displayName.getBuffer(), displayName.length());
+/*
+ * Each zone's names cost a few SimpleDateFormat::format calls, and DateFormatSymbols wants every
+ * zone's names at once: that's hundreds of milliseconds per locale. So each locale's names for a
+ * zone are worked out the first time anyone asks for them, and kept for the life of the process.
+ * Asking for one zone's name doesn't cost any more than that zone.
+ */
+struct ZoneNames {
+    UnicodeString longStd;
+    UnicodeString shortStd;
+    UnicodeString longDst;
+    UnicodeString shortDst;
+};
+
+struct LocaleZoneNames {
+    // We could use TimeZone::getDisplayName, but that's way too slow.
+    // The cost of building the whole table goes from 0.5s to 4.5s on a Nexus One.
+    // Much of the saving comes from reusing these SimpleDateFormat instances.
+    SimpleDateFormat longFormat;
+    SimpleDateFormat shortFormat;
+    std::map<UnicodeString, ZoneNames> zones;
+
+    LocaleZoneNames(const Locale& locale, UErrorCode& status)
+            : longFormat(UnicodeString("zzzz", ""), locale, status),
+              shortFormat(UnicodeString("z", ""), locale, status) {
+    }
+};
+
+typedef std::map<std::string, LocaleZoneNames*> ZoneNamesCache;
+static ZoneNamesCache gZoneNames;
+// Guards gZoneNames and everything in it, including the SimpleDateFormats.
+static pthread_mutex_t gZoneNamesMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Returns the names for 'localeName', creating them if necessary, or NULL with 'status' set.
+// The caller must hold gZoneNamesMutex.
+static LocaleZoneNames* getLocaleZoneNames(const char* localeName, UErrorCode& status) {
+    ZoneNamesCache::iterator it = gZoneNames.find(localeName);
+    if (it != gZoneNames.end()) {
+        return it->second;
+    }
+    UniquePtr<LocaleZoneNames> names(new LocaleZoneNames(Locale::createFromName(localeName), status));
+    if (U_FAILURE(status)) {
+        return NULL;
+    }
+    gZoneNames[localeName] = names.get();
+    return names.release();
 }
 
-static void TimeZones_getZoneStringsImpl(JNIEnv* env, jclass, jobjectArray outerArray, jstring localeName) {
-    Locale locale = getLocale(env, localeName);
+// Works out the names for zone 'id'. Returns false if ICU doesn't know the zone, in which case
+// we get the names of the zone ICU uses instead. The caller must hold gZoneNamesMutex.
+static bool computeZoneNames(LocaleZoneNames& localeNames, const UnicodeString& id, ZoneNames& result) {
+    UniquePtr<TimeZone> tz(TimeZone::createTimeZone(id));
+    localeNames.longFormat.setTimeZone(*tz);
+    localeNames.shortFormat.setTimeZone(*tz);
+
+    // 15th January 2008
+    UDate date1 = 1203105600000.0;
+    // 15th July 2008
+    UDate date2 = 1218826800000.0;
 
-    // We could use TimeZone::getDisplayName, but that's way too slow.
-    // The cost of this method goes from 0.5s to 4.5s on a Nexus One.
-    // Much of the saving comes from caching SimpleDateFormat instances.
     UErrorCode status = U_ZERO_ERROR;
-    UnicodeString longPattern("zzzz", "");
-    SimpleDateFormat longFormat(longPattern, locale, status);
-    UnicodeString shortPattern("z", "");
-    SimpleDateFormat shortFormat(shortPattern, locale, status);
+    int32_t daylightOffset;
+    int32_t rawOffset;
+    tz->getOffset(date1, false, rawOffset, daylightOffset, status);
+    UDate standardDate;
+    UDate daylightSavingDate;
+    if (daylightOffset != 0) {
+        // The Timezone is reporting that we are in daylight time
+        // for the winter date.  The dates are for the wrong hemisphere,
+        // swap them.
+        standardDate = date2;
+        daylightSavingDate = date1;
+    } else {
+        standardDate = date1;
+        daylightSavingDate = date2;
+    }
+
+    localeNames.shortFormat.format(standardDate, result.shortStd);
+    localeNames.longFormat.format(standardDate, result.longStd);
+    if (tz->useDaylightTime()) {
+        localeNames.shortFormat.format(daylightSavingDate, result.shortDst);
+        localeNames.longFormat.format(daylightSavingDate, result.longDst);
+    } else {
+        result.shortDst = result.shortStd;
+        result.longDst = result.longStd;
+    }
+
+    UnicodeString actualId;
+    tz->getID(actualId);
+    return actualId == id;
+}
+
+// Sets 'result' to the names for zone 'id'. The caller must hold gZoneNamesMutex.
+static void getZoneNames(LocaleZoneNames& localeNames, const UnicodeString& id, ZoneNames& result) {
+    std::map<UnicodeString, ZoneNames>::iterator it = localeNames.zones.find(id);
+    if (it != localeNames.zones.end()) {
+        result = it->second;
+        return;
+    }
+    // Don't let a caller with made-up ids fill the cache.
+    if (computeZoneNames(localeNames, id, result)) {
+        localeNames.zones[id] = result;
+    }
+}
+
+static jstring newString(JNIEnv* env, const UnicodeString& s) {
+    return env->NewString(s.getBuffer(), s.length());
+}
+
+static jstring TimeZones_getDisplayNameImpl(JNIEnv* env, jclass, jstring zoneId, jboolean isDST, jint style, jstring localeId) {
+    ScopedUtfChars localeName(env, localeId);
+    if (localeName.c_str() == NULL) {
+        return NULL;
+    }
+    ScopedJavaUnicodeString id(env, zoneId);
+    ZoneNames names;
+    {
+        ScopedPthreadMutexLock lock(&gZoneNamesMutex);
+        UErrorCode status = U_ZERO_ERROR;
+        LocaleZoneNames* localeNames = getLocaleZoneNames(localeName.c_str(), status);
+        if (localeNames == NULL) {
+            icu4jni_error(env, status);
+            return NULL;
+        }
+        getZoneNames(*localeNames, id.unicodeString(), names);
+    }
+    if (isDST) {
+        return newString(env, (style == 0) ? names.shortDst : names.longDst);
+    } else {
+        return newString(env, (style == 0) ? names.shortStd : names.longStd);
+    }
+}
+
+static void TimeZones_getZoneStringsImpl(JNIEnv* env, jclass, jobjectArray outerArray, jstring localeName) {
+    ScopedUtfChars localeChars(env, localeName);
+    if (localeChars.c_str() == NULL) {
+        return;
+    }
 
     jobjectArray longStdArray = (jobjectArray) env->GetObjectArrayElement(outerArray, 1);
     jobjectArray shortStdArray = (jobjectArray) env->GetObjectArrayElement(outerArray, 2);
     jobjectArray longDstArray = (jobjectArray) env->GetObjectArrayElement(outerArray, 3);
     jobjectArray shortDstArray = (jobjectArray) env->GetObjectArrayElement(outerArray, 4);
 
-    // 15th January 2008
-    UDate date1 = 1203105600000.0;
-    // 15th July 2008
-    UDate date2 = 1218826800000.0;
+    ScopedPthreadMutexLock lock(&gZoneNamesMutex);
+    UErrorCode status = U_ZERO_ERROR;
+    LocaleZoneNames* localeNames = getLocaleZoneNames(localeChars.c_str(), status);
+    if (localeNames == NULL) {
+        icu4jni_error(env, status);
+        return;
+    }
 
     jobjectArray zoneIds = (jobjectArray) env->GetObjectArrayElement(outerArray, 0);
     int zoneIdCount = env->GetArrayLength(zoneIds);
     for (int i = 0; i < zoneIdCount; ++i) {
         ScopedLocalRef<jstring> id(env, reinterpret_cast<jstring>(env->GetObjectArrayElement(zoneIds, i)));
-        UniquePtr<TimeZone> tz(timeZoneFromId(env, id.get()));
-
-        longFormat.setTimeZone(*tz);
-        shortFormat.setTimeZone(*tz);
-
-        int32_t daylightOffset;
-        int32_t rawOffset;
-        tz->getOffset(date1, false, rawOffset, daylightOffset, status);
-        UDate standardDate;
-        UDate daylightSavingDate;
-        if (daylightOffset != 0) {
-            // The Timezone is reporting that we are in daylight time
-            // for the winter date.  The dates are for the wrong hemisphere,
-            // swap them.
-            standardDate = date2;
-            daylightSavingDate = date1;
-        } else {
-            standardDate = date1;
-            daylightSavingDate = date2;
-        }
+        ZoneNames names;
+        getZoneNames(*localeNames, ScopedJavaUnicodeString(env, id.get()).unicodeString(), names);
 
-        ScopedLocalRef<jstring> shortStd(env, formatDate(env, shortFormat, standardDate));
+        ScopedLocalRef<jstring> shortStd(env, newString(env, names.shortStd));
         env->SetObjectArrayElement(shortStdArray, i, shortStd.get());
-
-        ScopedLocalRef<jstring> longStd(env, formatDate(env, longFormat, standardDate));
+        ScopedLocalRef<jstring> longStd(env, newString(env, names.longStd));
         env->SetObjectArrayElement(longStdArray, i, longStd.get());
-
-        if (tz->useDaylightTime()) {
-            ScopedLocalRef<jstring> shortDst(env, formatDate(env, shortFormat, daylightSavingDate));
-            env->SetObjectArrayElement(shortDstArray, i, shortDst.get());
-
-            ScopedLocalRef<jstring> longDst(env, formatDate(env, longFormat, daylightSavingDate));
-            env->SetObjectArrayElement(longDstArray, i, longDst.get());
-        } else {
-            env->SetObjectArrayElement(shortDstArray, i, shortStd.get());
-            env->SetObjectArrayElement(longDstArray, i, longStd.get());
-        }
+        ScopedLocalRef<jstring> shortDst(env, newString(env, names.shortDst));
+        env->SetObjectArrayElement(shortDstArray, i, shortDst.get());
+        ScopedLocalRef<jstring> longDst(env, newString(env, names.longDst));
+        env->SetObjectArrayElement(longDstArray, i, longDst.get());
     }
 }
 
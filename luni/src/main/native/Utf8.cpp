@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Utf8.h"
+#include "unicode/utf16.h"
+
+// Each Android ABI is built for a known instruction set, so we pick the vector ASCII kernels at
+// compile time rather than probing the CPU at runtime.
+#if defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define HAVE_NEON_ASCII
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define HAVE_SSE2_ASCII
+#endif
+
+/**
+ * Returns the number of leading chars in 'src' that are ASCII, looking at 16 at a time.
+ */
+size_t asciiCharCount(const jchar* src, size_t length) {
+    size_t i = 0;
+#if defined(HAVE_NEON_ASCII)
+    const uint16x8_t nonAscii = vdupq_n_u16(0xff80);
+    for (; i + 16 <= length; i += 16) {
+        uint16x8_t v = vorrq_u16(vld1q_u16(src + i), vld1q_u16(src + i + 8));
+        uint64x2_t high = vreinterpretq_u64_u16(vandq_u16(v, nonAscii));
+        if ((vgetq_lane_u64(high, 0) | vgetq_lane_u64(high, 1)) != 0) {
+            break;
+        }
+    }
+#elif defined(HAVE_SSE2_ASCII)
+    const __m128i nonAscii = _mm_set1_epi16(0xff80);
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= length; i += 16) {
+        __m128i v = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8)));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, nonAscii), zero)) != 0xffff) {
+            break;
+        }
+    }
+#endif
+    for (; i < length && src[i] < 0x80; ++i) {
+    }
+    return i;
+}
+
+/**
+ * Narrows 'length' chars, all known to be ASCII, to bytes.
+ */
+void narrowAsciiChars(const jchar* src, jbyte* dst, size_t length) {
+    size_t i = 0;
+#if defined(HAVE_NEON_ASCII)
+    for (; i + 16 <= length; i += 16) {
+        uint8x16_t bytes = vcombine_u8(vmovn_u16(vld1q_u16(src + i)),
+                vmovn_u16(vld1q_u16(src + i + 8)));
+        vst1q_u8(reinterpret_cast<uint8_t*>(dst + i), bytes);
+    }
+#elif defined(HAVE_SSE2_ASCII)
+    for (; i + 16 <= length; i += 16) {
+        __m128i bytes = _mm_packus_epi16(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), bytes);
+    }
+#endif
+    for (; i < length; ++i) {
+        dst[i] = static_cast<jbyte>(src[i]);
+    }
+}
+
+/**
+ * Returns the number of leading bytes in 'src' that are ASCII, widening them to chars in 'dst' 16
+ * at a time as it goes. Bytes after the first non-ASCII one may also have been written to 'dst'.
+ */
+static size_t widenAsciiBytes(const jbyte* src, jchar* dst, size_t length) {
+    size_t i = 0;
+#if defined(HAVE_NEON_ASCII)
+    for (; i + 16 <= length; i += 16) {
+        uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(src + i));
+        uint64x2_t high = vreinterpretq_u64_u8(vandq_u8(v, vdupq_n_u8(0x80)));
+        if ((vgetq_lane_u64(high, 0) | vgetq_lane_u64(high, 1)) != 0) {
+            break;
+        }
+        vst1q_u16(dst + i, vmovl_u8(vget_low_u8(v)));
+        vst1q_u16(dst + i + 8, vmovl_u8(vget_high_u8(v)));
+    }
+#elif defined(HAVE_SSE2_ASCII)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= length; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        if (_mm_movemask_epi8(v) != 0) {
+            break;
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_unpacklo_epi8(v, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 8), _mm_unpackhi_epi8(v, zero));
+    }
+#endif
+    for (; i < length && src[i] >= 0; ++i) {
+        dst[i] = src[i];
+    }
+    return i;
+}
+
+/**
+ * Decodes UTF-8, replacing malformed input exactly as String's Java decoder always has: each bad
+ * lead byte, or lead byte followed by a bad continuation byte, becomes one U+FFFD; a sequence cut
+ * off by the end of the input becomes one U+FFFD and ends decoding; so do surrogates not encoded
+ * in three bytes and anything above U+10FFFF. Like that decoder, we accept overlong forms and the
+ * old five- and six-byte sequences.
+ */
+size_t utf8ToUtf16(const jbyte* src, size_t length, jchar* dst) {
+    static const jchar REPLACEMENT_CHAR = 0xfffd;
+    const jbyte* end = src + length;
+    jchar* start = dst;
+    while (src < end) {
+        size_t asciiCount = widenAsciiBytes(src, dst, end - src);
+        src += asciiCount;
+        dst += asciiCount;
+        if (src == end) {
+            break;
+        }
+
+        int b0 = *src++ & 0xff;
+        int utfCount;
+        if ((b0 & 0xe0) == 0xc0) {
+            utfCount = 1;
+        } else if ((b0 & 0xf0) == 0xe0) {
+            utfCount = 2;
+        } else if ((b0 & 0xf8) == 0xf0) {
+            utfCount = 3;
+        } else if ((b0 & 0xfc) == 0xf8) {
+            utfCount = 4;
+        } else if ((b0 & 0xfe) == 0xfc) {
+            utfCount = 5;
+        } else {
+            // A stray continuation byte, or 0xfe or 0xff.
+            *dst++ = REPLACEMENT_CHAR;
+            continue;
+        }
+        if (end - src < utfCount) {
+            *dst++ = REPLACEMENT_CHAR;
+            break;
+        }
+
+        jint val = b0 & (0x1f >> (utfCount - 1));
+        bool malformed = false;
+        for (int i = 0; i < utfCount; ++i) {
+            int b = *src & 0xff;
+            if ((b & 0xc0) != 0x80) {
+                // Leave the offending byte to be decoded afresh.
+                malformed = true;
+                break;
+            }
+            ++src;
+            val = (val << 6) | (b & 0x3f);
+        }
+        if (malformed || (utfCount != 2 && U_IS_SURROGATE(val)) || val > 0x10ffff) {
+            *dst++ = REPLACEMENT_CHAR;
+        } else if (val < 0x10000) {
+            *dst++ = val;
+        } else {
+            *dst++ = U16_LEAD(val);
+            *dst++ = U16_TRAIL(val);
+        }
+    }
+    return dst - start;
+}
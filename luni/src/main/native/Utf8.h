@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UTF8_H_included
+#define UTF8_H_included
+
+#include "jni.h"
+
+#include <stddef.h>
+
+// Returns the number of leading chars in 'src' that are ASCII.
+size_t asciiCharCount(const jchar* src, size_t length);
+
+// Narrows 'length' chars, all known to be ASCII, to bytes.
+void narrowAsciiChars(const jchar* src, jbyte* dst, size_t length);
+
+// Decodes 'length' bytes of UTF-8 from 'src' into 'dst', which must have room for 'length'
+// chars; that's always enough. Malformed input becomes U+FFFD. Returns the number of chars
+// written. Runs of ASCII are copied a vector at a time where the CPU allows.
+size_t utf8ToUtf16(const jbyte* src, size_t length, jchar* dst);
+
+#endif // UTF8_H_included
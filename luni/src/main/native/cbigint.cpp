@@ -109,6 +109,16 @@
 #define FLOAT_NORMAL_MASK   (0x00800000)
 #define FLOAT_E_OFFSET (150)
 
+/* Where the compiler has a 128-bit integer type, the arithmetic below works
+ * a whole 64-bit limb at a time, and carries are computed rather than
+ * branched on. The half-word versions remain for the other compilers, and
+ * can be forced with -DCBIGINT_NO_UINT128 to test them on a 64-bit host.
+ */
+#if defined(__SIZEOF_INT128__) && !defined(CBIGINT_NO_UINT128)
+#define USE_UINT128
+typedef unsigned __int128 uint128_t;
+#endif
+
 int32_t
 simpleAddHighPrecision (uint64_t * arg1, int32_t length, uint64_t arg2)
 {
@@ -126,6 +136,105 @@ simpleAddHighPrecision (uint64_t * arg1, int32_t length, uint64_t arg2)
   return index == length;
 }
 
+#if defined(USE_UINT128)
+int32_t
+addHighPrecision (uint64_t * arg1, int32_t length1, uint64_t * arg2, int32_t length2)
+{
+  /* addition is limited by length of arg1 as it this function is
+   * storing the result in arg1 */
+  uint64_t carry = 0;
+  int32_t index;
+
+  if (length1 < length2)
+    length2 = length1;
+
+  for (index = 0; index < length2; ++index)
+    {
+      uint128_t sum = static_cast<uint128_t>(arg1[index]) + arg2[index] + carry;
+      arg1[index] = static_cast<uint64_t>(sum);
+      carry = static_cast<uint64_t>(sum >> 64);
+    }
+  for (; carry != 0 && index < length1; ++index)
+    carry = (++arg1[index] == 0);
+
+  return static_cast<int32_t>(carry);
+}
+
+void
+subtractHighPrecision (uint64_t * arg1, int32_t length1, uint64_t * arg2, int32_t length2)
+{
+  /* assumes arg1 > arg2 */
+  uint64_t borrow = 0;
+  int32_t index;
+
+  if (length1 < length2)
+    length2 = length1;
+
+  for (index = 0; index < length2; ++index)
+    {
+      uint128_t difference = static_cast<uint128_t>(arg1[index]) - arg2[index] - borrow;
+      arg1[index] = static_cast<uint64_t>(difference);
+      borrow = static_cast<uint64_t>(difference >> 64) & 1;
+    }
+  for (; borrow != 0 && index < length1; ++index)
+    borrow = (arg1[index]-- == 0);
+}
+
+static uint32_t simpleMultiplyHighPrecision(uint64_t* arg1, int32_t length, uint64_t arg2) {
+  /* assumes arg2 only holds 32 bits of information */
+  uint64_t carry = 0;
+  int32_t index;
+
+  for (index = 0; index < length; ++index)
+    {
+      uint128_t product = static_cast<uint128_t>(arg1[index]) * arg2 + carry;
+      arg1[index] = static_cast<uint64_t>(product);
+      carry = static_cast<uint64_t>(product >> 64);
+    }
+
+  return static_cast<uint32_t>(carry);
+}
+
+void
+multiplyHighPrecision (uint64_t * arg1, int32_t length1, uint64_t * arg2, int32_t length2,
+                       uint64_t * result, int32_t length)
+{
+  /* assumes result is large enough to hold product */
+  int32_t i, j;
+
+  memset (result, 0, sizeof (uint64_t) * length);
+
+  for (i = 0; i < length2; ++i)
+    {
+      uint64_t carry = 0;
+      for (j = 0; j < length1; ++j)
+        {
+          uint128_t product =
+            static_cast<uint128_t>(arg1[j]) * arg2[i] + result[i + j] + carry;
+          result[i + j] = static_cast<uint64_t>(product);
+          carry = static_cast<uint64_t>(product >> 64);
+        }
+      result[i + length1] = carry;
+    }
+}
+
+uint32_t
+simpleAppendDecimalDigitHighPrecision (uint64_t * arg1, int32_t length, uint64_t digit)
+{
+  /* assumes digit is less than 32 bits */
+  uint64_t carry = digit;
+  int32_t index;
+
+  for (index = 0; index < length; ++index)
+    {
+      uint128_t product = static_cast<uint128_t>(arg1[index]) * 10 + carry;
+      arg1[index] = static_cast<uint64_t>(product);
+      carry = static_cast<uint64_t>(product >> 64);
+    }
+
+  return static_cast<uint32_t>(carry);
+}
+#else
 int32_t
 addHighPrecision (uint64_t * arg1, int32_t length1, uint64_t * arg2, int32_t length2)
 {
@@ -332,6 +441,7 @@ simpleAppendDecimalDigitHighPrecision (uint64_t * arg1, int32_t length, uint64_t
 
   return HIGH_U32_FROM_VAR (digit);
 }
+#endif
 
 void
 simpleShiftLeftHighPrecision (uint64_t * arg1, int32_t length, int32_t arg2)
@@ -363,6 +473,19 @@ simpleShiftLeftHighPrecision (uint64_t * arg1, int32_t length, int32_t arg2)
   *arg1 <<= arg2;
 }
 
+#if defined(USE_UINT128)
+int32_t
+highestSetBit (uint64_t * y)
+{
+  return (*y == 0) ? 0 : 64 - __builtin_clzll (*y);
+}
+
+int32_t
+lowestSetBit (uint64_t * y)
+{
+  return (*y == 0) ? 0 : __builtin_ctzll (*y) + 1;
+}
+#else
 int32_t
 highestSetBit (uint64_t * y)
 {
@@ -505,6 +628,7 @@ lowestSetBit (uint64_t * y)
   else
     return result + 4;
 }
+#endif
 
 int32_t
 highestSetBitHighPrecision (uint64_t * arg, int32_t length)
@@ -818,55 +942,49 @@ floatExponent (jfloat z)
 }
 
 /* Allow a 64-bit value in arg2 */
+#if defined(USE_UINT128)
 uint64_t
 simpleMultiplyHighPrecision64 (uint64_t * arg1, int32_t length, uint64_t arg2)
 {
-  uint64_t intermediate, carry1, carry2, prod1, prod2, sum;
-  uint64_t* pArg1;
+  uint64_t carry = 0;
   int32_t index;
-  uint32_t buf32;
 
-  index = 0;
-  intermediate = 0;
-  pArg1 = arg1 + index;
-  carry1 = carry2 = 0;
+  for (index = 0; index < length; ++index)
+    {
+      uint128_t product = static_cast<uint128_t>(arg1[index]) * arg2 + carry;
+      arg1[index] = static_cast<uint64_t>(product);
+      carry = static_cast<uint64_t>(product >> 64);
+    }
+  return carry;
+}
+#else
+uint64_t
+simpleMultiplyHighPrecision64 (uint64_t * arg1, int32_t length, uint64_t arg2)
+{
+  /* Each limb's 128-bit product is built from four 32x32-bit partial
+   * products. The middle sum can't overflow: it's at most 3 * (2^32 - 1).
+   */
+  uint64_t carry = 0;
+  uint64_t low, middle, high, crossLow, crossHigh;
+  int32_t index;
 
-  do
+  for (index = 0; index < length; ++index)
     {
-      if ((*pArg1 != 0) || (intermediate != 0))
-        {
-          prod1 =
-            static_cast<uint64_t>(LOW_U32_FROM_VAR (arg2)) * static_cast<uint64_t>(LOW_U32_FROM_PTR (pArg1));
-          sum = intermediate + prod1;
-          if ((sum < prod1) || (sum < intermediate))
-            {
-              carry1 = 1;
-            }
-          else
-            {
-              carry1 = 0;
-            }
-          prod1 =
-            static_cast<uint64_t>(LOW_U32_FROM_VAR (arg2)) * static_cast<uint64_t>(HIGH_U32_FROM_PTR (pArg1));
-          prod2 =
-            static_cast<uint64_t>(HIGH_U32_FROM_VAR (arg2)) * static_cast<uint64_t>(LOW_U32_FROM_PTR (pArg1));
-          intermediate = carry2 + HIGH_IN_U64 (sum) + prod1 + prod2;
-          if ((intermediate < prod1) || (intermediate < prod2))
-            {
-              carry2 = 1;
-            }
-          else
-            {
-              carry2 = 0;
-            }
-          LOW_U32_FROM_PTR (pArg1) = LOW_U32_FROM_VAR (sum);
-          buf32 = HIGH_U32_FROM_PTR (pArg1);
-          HIGH_U32_FROM_PTR (pArg1) = LOW_U32_FROM_VAR (intermediate);
-          intermediate = carry1 + HIGH_IN_U64 (intermediate)
-            + static_cast<uint64_t>(HIGH_U32_FROM_VAR (arg2)) * static_cast<uint64_t>(buf32);
-        }
-      pArg1++;
+      low = LOW_IN_U64 (arg2) * LOW_IN_U64 (arg1[index]);
+      crossLow = HIGH_IN_U64 (arg2) * LOW_IN_U64 (arg1[index]);
+      crossHigh = LOW_IN_U64 (arg2) * HIGH_IN_U64 (arg1[index]);
+      high = HIGH_IN_U64 (arg2) * HIGH_IN_U64 (arg1[index]);
+
+      middle = HIGH_IN_U64 (low) + LOW_IN_U64 (crossLow) + LOW_IN_U64 (crossHigh);
+      high += HIGH_IN_U64 (crossLow) + HIGH_IN_U64 (crossHigh) + HIGH_IN_U64 (middle);
+      low = (middle << 32) | LOW_IN_U64 (low);
+
+      /* The whole product plus a carry still fits in 128 bits. */
+      low += carry;
+      high += (low < carry);
+      arg1[index] = low;
+      carry = high;
     }
-  while (++index < length);
-  return intermediate;
+  return carry;
 }
+#endif
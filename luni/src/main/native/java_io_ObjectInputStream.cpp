@@ -19,8 +19,13 @@
 
 #include "JNIHelp.h"
 #include "JniConstants.h"
+#include "ScopedLocalRef.h"
+#include "ScopedPrimitiveArray.h"
 #include "ScopedUtfChars.h"
 
+#include <stdint.h>
+#include <string.h>
+
 #define SETTER(FUNCTION_NAME, JNI_C_TYPE, JNI_TYPE_STRING, JNI_SETTER_FUNCTION) \
     static void FUNCTION_NAME(JNIEnv* env, jclass, jobject instance, \
             jclass declaringClass, jstring javaFieldName, JNI_C_TYPE newValue) { \
@@ -65,6 +70,119 @@ static void ObjectInputStream_setFieldObject(JNIEnv* env, jclass, jobject instan
     }
 }
 
+/**
+ * Returns the field IDs of the named fields of 'declaringClass', whose type codes are in
+ * 'javaTypeCodes'. A field that doesn't exist gets 0, which setPrimitiveFields skips.
+ */
+static jintArray ObjectInputStream_getFieldIds(JNIEnv* env, jclass, jclass declaringClass,
+        jobjectArray javaNames, jbyteArray javaTypeCodes) {
+    ScopedByteArrayRO typeCodes(env, javaTypeCodes);
+    if (typeCodes.get() == NULL) {
+        return NULL;
+    }
+    size_t count = typeCodes.size();
+    jintArray result = env->NewIntArray(count);
+    if (result == NULL) {
+        return NULL;
+    }
+    ScopedIntArrayRW ids(env, result);
+    if (ids.get() == NULL) {
+        return NULL;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        ScopedLocalRef<jstring> javaName(env,
+                reinterpret_cast<jstring>(env->GetObjectArrayElement(javaNames, i)));
+        ScopedUtfChars name(env, javaName.get());
+        if (name.c_str() == NULL) {
+            return NULL;
+        }
+        char signature[2] = { static_cast<char>(typeCodes[i]), '\0' };
+        jfieldID fid = env->GetFieldID(declaringClass, name.c_str(), signature);
+        if (fid == 0) {
+            // The class has changed since the stream was written; the value is discarded.
+            env->ExceptionClear();
+        }
+        ids[i] = static_cast<jint>(reinterpret_cast<uintptr_t>(fid));
+    }
+    return result;
+}
+
+/**
+ * Sets the primitive fields 'javaFieldIds' of 'instance' from 'javaData', which holds their values
+ * one after another in the stream's big-endian format.
+ */
+static void ObjectInputStream_setPrimitiveFields(JNIEnv* env, jclass, jobject instance,
+        jintArray javaFieldIds, jbyteArray javaTypeCodes, jbyteArray javaData) {
+    if (instance == NULL) {
+        return;
+    }
+    ScopedIntArrayRO fieldIds(env, javaFieldIds);
+    if (fieldIds.get() == NULL) {
+        return;
+    }
+    ScopedByteArrayRO typeCodes(env, javaTypeCodes);
+    if (typeCodes.get() == NULL) {
+        return;
+    }
+    ScopedByteArrayRO data(env, javaData);
+    if (data.get() == NULL) {
+        return;
+    }
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data.get());
+    for (size_t i = 0; i < fieldIds.size(); ++i) {
+        jfieldID fid = reinterpret_cast<jfieldID>(static_cast<uintptr_t>(fieldIds[i]));
+        switch (typeCodes[i]) {
+        case 'Z':
+            if (fid != 0) env->SetBooleanField(instance, fid, p[0] != 0);
+            p += 1;
+            break;
+        case 'B':
+            if (fid != 0) env->SetByteField(instance, fid, p[0]);
+            p += 1;
+            break;
+        case 'C':
+            if (fid != 0) env->SetCharField(instance, fid, (p[0] << 8) | p[1]);
+            p += 2;
+            break;
+        case 'S':
+            if (fid != 0) env->SetShortField(instance, fid, (p[0] << 8) | p[1]);
+            p += 2;
+            break;
+        case 'I':
+        case 'F':
+            if (fid != 0) {
+                jint bits = (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+                if (typeCodes[i] == 'I') {
+                    env->SetIntField(instance, fid, bits);
+                } else {
+                    jfloat value;
+                    memcpy(&value, &bits, sizeof(value));
+                    env->SetFloatField(instance, fid, value);
+                }
+            }
+            p += 4;
+            break;
+        case 'J':
+        case 'D':
+            if (fid != 0) {
+                jlong bits = 0;
+                for (int j = 0; j < 8; ++j) {
+                    bits = (bits << 8) | p[j];
+                }
+                if (typeCodes[i] == 'J') {
+                    env->SetLongField(instance, fid, bits);
+                } else {
+                    jdouble value;
+                    memcpy(&value, &bits, sizeof(value));
+                    env->SetDoubleField(instance, fid, value);
+                }
+            }
+            p += 8;
+            break;
+        }
+    }
+}
+
 static jobject ObjectInputStream_newInstance(JNIEnv* env, jclass,
         jclass instantiationClass, jclass constructorClass) {
     jmethodID mid = env->GetMethodID(constructorClass, "<init>", "()V");
@@ -75,6 +193,7 @@ static jobject ObjectInputStream_newInstance(JNIEnv* env, jclass,
 }
 
 static JNINativeMethod gMethods[] = {
+    NATIVE_METHOD(ObjectInputStream, getFieldIds, "(Ljava/lang/Class;[Ljava/lang/String;[B)[I"),
     NATIVE_METHOD(ObjectInputStream, newInstance, "(Ljava/lang/Class;Ljava/lang/Class;)Ljava/lang/Object;"),
     NATIVE_METHOD(ObjectInputStream, setFieldObject, "(Ljava/lang/Object;Ljava/lang/Class;Ljava/lang/String;Ljava/lang/String;Ljava/lang/Object;)V"),
     NATIVE_METHOD(ObjectInputStream, setFieldByte, "(Ljava/lang/Object;Ljava/lang/Class;Ljava/lang/String;B)V"),
@@ -85,6 +204,7 @@ static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(ObjectInputStream, setFieldLong, "(Ljava/lang/Object;Ljava/lang/Class;Ljava/lang/String;J)V"),
     NATIVE_METHOD(ObjectInputStream, setFieldShort, "(Ljava/lang/Object;Ljava/lang/Class;Ljava/lang/String;S)V"),
     NATIVE_METHOD(ObjectInputStream, setFieldBool, "(Ljava/lang/Object;Ljava/lang/Class;Ljava/lang/String;Z)V"),
+    NATIVE_METHOD(ObjectInputStream, setPrimitiveFields, "(Ljava/lang/Object;[I[B[B)V"),
 };
 void register_java_io_ObjectInputStream(JNIEnv* env) {
     jniRegisterNativeMethods(env, "java/io/ObjectInputStream", gMethods, NELEM(gMethods));
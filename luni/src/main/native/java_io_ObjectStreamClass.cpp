@@ -19,26 +19,44 @@
 
 #include "JNIHelp.h"
 #include "JniConstants.h"
+#include "ScopedLocalRef.h"
 
-static jobject getSignature(JNIEnv* env, jclass c, jobject object) {
+/**
+ * Returns the signatures of all the members in 'members', which are instances of 'c', looking up
+ * getSignature only once. Computing a serialVersionUID needs every field, constructor and method
+ * signature of a class.
+ */
+static jobjectArray getSignatures(JNIEnv* env, jclass c, jobjectArray members) {
     jmethodID mid = env->GetMethodID(c, "getSignature", "()Ljava/lang/String;");
     if (!mid) {
         return NULL;
     }
-    jclass objectClass = env->GetObjectClass(object);
-    return env->CallNonvirtualObjectMethod(object, objectClass, mid);
+    jsize count = env->GetArrayLength(members);
+    jobjectArray result = env->NewObjectArray(count, JniConstants::stringClass, NULL);
+    if (result == NULL) {
+        return NULL;
+    }
+    for (jsize i = 0; i < count; ++i) {
+        ScopedLocalRef<jobject> member(env, env->GetObjectArrayElement(members, i));
+        ScopedLocalRef<jobject> signature(env, env->CallNonvirtualObjectMethod(member.get(), c, mid));
+        if (env->ExceptionCheck()) {
+            return NULL;
+        }
+        env->SetObjectArrayElement(result, i, signature.get());
+    }
+    return result;
 }
 
-static jobject ObjectStreamClass_getFieldSignature(JNIEnv* env, jclass, jobject field) {
-    return getSignature(env, JniConstants::fieldClass, field);
+static jobjectArray ObjectStreamClass_getFieldSignatures(JNIEnv* env, jclass, jobjectArray fields) {
+    return getSignatures(env, JniConstants::fieldClass, fields);
 }
 
-static jobject ObjectStreamClass_getMethodSignature(JNIEnv* env, jclass, jobject method) {
-    return getSignature(env, JniConstants::methodClass, method);
+static jobjectArray ObjectStreamClass_getMethodSignatures(JNIEnv* env, jclass, jobjectArray methods) {
+    return getSignatures(env, JniConstants::methodClass, methods);
 }
 
-static jobject ObjectStreamClass_getConstructorSignature(JNIEnv* env, jclass, jobject constructor) {
-    return getSignature(env, JniConstants::constructorClass, constructor);
+static jobjectArray ObjectStreamClass_getConstructorSignatures(JNIEnv* env, jclass, jobjectArray constructors) {
+    return getSignatures(env, JniConstants::constructorClass, constructors);
 }
 
 static jboolean ObjectStreamClass_hasClinit(JNIEnv * env, jclass, jclass targetClass) {
@@ -48,9 +66,9 @@ static jboolean ObjectStreamClass_hasClinit(JNIEnv * env, jclass, jclass targetC
 }
 
 static JNINativeMethod gMethods[] = {
-    NATIVE_METHOD(ObjectStreamClass, getConstructorSignature, "(Ljava/lang/reflect/Constructor;)Ljava/lang/String;"),
-    NATIVE_METHOD(ObjectStreamClass, getFieldSignature, "(Ljava/lang/reflect/Field;)Ljava/lang/String;"),
-    NATIVE_METHOD(ObjectStreamClass, getMethodSignature, "(Ljava/lang/reflect/Method;)Ljava/lang/String;"),
+    NATIVE_METHOD(ObjectStreamClass, getConstructorSignatures, "([Ljava/lang/reflect/Constructor;)[Ljava/lang/String;"),
+    NATIVE_METHOD(ObjectStreamClass, getFieldSignatures, "([Ljava/lang/reflect/Field;)[Ljava/lang/String;"),
+    NATIVE_METHOD(ObjectStreamClass, getMethodSignatures, "([Ljava/lang/reflect/Method;)[Ljava/lang/String;"),
     NATIVE_METHOD(ObjectStreamClass, hasClinit, "(Ljava/lang/Class;)Z"),
 };
 void register_java_io_ObjectStreamClass(JNIEnv* env) {
@@ -17,11 +17,16 @@
 #define LOG_TAG "ProcessManager"
 
 #include <sys/resource.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <limits.h>
+#include <paths.h>
+#include <pthread.h>
 #include <signal.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
@@ -29,8 +34,16 @@
 #include "jni.h"
 #include "JNIHelp.h"
 #include "JniConstants.h"
+#include "ScopedPrimitiveArray.h"
 #include "utils/Log.h"
 
+#include <algorithm>
+
+#ifdef __linux__
+#define HAVE_SIGNALFD
+#include <sys/signalfd.h>
+#endif
+
 /** Environment variables. */
 extern char **environ;
 
@@ -59,6 +72,19 @@ static void ProcessManager_kill(JNIEnv* env, jclass, jint pid) {
     }
 }
 
+/** Extracts the value Process.exitValue reports from a wait status. */
+static int exitValue(int status) {
+    if (WIFEXITED(status)) {
+        return WEXITSTATUS(status);
+    } else if (WIFSIGNALED(status)) {
+        return WTERMSIG(status);
+    } else if (WIFSTOPPED(status)) {
+        return WSTOPSIG(status);
+    } else {
+        return WAIT_STATUS_UNKNOWN;
+    }
+}
+
 /**
  * Loops indefinitely and calls ProcessManager.onExit() when children exit.
  */
@@ -75,16 +101,7 @@ static void ProcessManager_watchChildren(JNIEnv* env, jobject o) {
         pid_t pid = waitpid(0, &status, 0);
 
         if (pid >= 0) {
-            // Extract real status.
-            if (WIFEXITED(status)) {
-                status = WEXITSTATUS(status);
-            } else if (WIFSIGNALED(status)) {
-                status = WTERMSIG(status);
-            } else if (WIFSTOPPED(status)) {
-                status = WSTOPSIG(status);
-            } else {
-                status = WAIT_STATUS_UNKNOWN;
-            }
+            status = exitValue(status);
         } else {
             /*
              * The pid should be -1 already, but force it here just in case
@@ -135,23 +152,274 @@ static void ProcessManager_watchChildren(JNIEnv* env, jobject o) {
     }
 }
 
-/** Close all open fds > 2 (i.e. everything but stdin/out/err), != skipFd. */
-static void closeNonStandardFds(int skipFd) {
-    // TODO: rather than close all these non-open files, we could look in /proc/self/fd.
+/**
+ * Reaps whichever of 'candidates' have exited, without blocking, writing their pids and exit
+ * values to the start of 'pids' and 'statuses'. Stops once those are full. Returns the number
+ * reaped. The candidates must be supervised children, which watchChildren never waits for.
+ */
+static jint ProcessManager_reapExited(JNIEnv* env, jclass, jintArray javaCandidates,
+        jintArray javaPids, jintArray javaStatuses) {
+    ScopedIntArrayRO candidates(env, javaCandidates);
+    if (candidates.get() == NULL) {
+        return 0;
+    }
+    ScopedIntArrayRW pids(env, javaPids);
+    if (pids.get() == NULL) {
+        return 0;
+    }
+    ScopedIntArrayRW statuses(env, javaStatuses);
+    if (statuses.get() == NULL) {
+        return 0;
+    }
+    const size_t capacity = std::min(pids.size(), statuses.size());
+    size_t count = 0;
+    for (size_t i = 0; i < candidates.size() && count < capacity; ++i) {
+        int status;
+        pid_t pid = TEMP_FAILURE_RETRY(waitpid(candidates[i], &status, WNOHANG));
+        if (pid > 0) {
+            pids[count] = pid;
+            statuses[count] = exitValue(status);
+            ++count;
+        } else if (pid == -1 && errno != ECHILD) {
+            ALOGE("Error %d calling waitpid(%d): %s", errno, candidates[i], strerror(errno));
+        }
+    }
+    return count;
+}
+
+/**
+ * Returns a pidfd for 'pid', which becomes readable when the process exits. The pid must not
+ * have been reaped yet, or it may since have been reused.
+ */
+static jobject ProcessManager_openPidFd(JNIEnv* env, jclass, jint pid) {
+#if defined(__NR_pidfd_open)
+    int fd = syscall(__NR_pidfd_open, pid, 0);
+    if (fd == -1) {
+        jniThrowIOException(env, errno);
+        return NULL;
+    }
+    // Don't leak the pidfd into later children.
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    return jniCreateFileDescriptor(env, fd);
+#else
+    (void) pid;
+    jniThrowIOException(env, ENOSYS);
+    return NULL;
+#endif
+}
+
+/**
+ * Blocks SIGCHLD in the calling thread and returns a signalfd that becomes readable when it
+ * arrives. For kernels without pidfds.
+ */
+static jobject ProcessManager_openSigChldFd(JNIEnv* env, jclass) {
+#if defined(HAVE_SIGNALFD)
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    pthread_sigmask(SIG_BLOCK, &mask, NULL);
+    int fd = signalfd(-1, &mask, SFD_CLOEXEC);
+    if (fd == -1) {
+        jniThrowIOException(env, errno);
+        return NULL;
+    }
+    return jniCreateFileDescriptor(env, fd);
+#else
+    jniThrowIOException(env, ENOSYS);
+    return NULL;
+#endif
+}
+
+/** Returns true if the child should inherit fd: stdin/out/err, keepFd, or the properties fd. */
+static bool isInheritedFd(int fd, int keepFd) {
+    return fd <= 2 || fd == keepFd
+#ifdef ANDROID
+            || fd == androidSystemPropertiesFd
+#endif
+            ;
+}
+
+/**
+ * Closes every fd above 2 other than keepFd with close_range(2), one call per gap between the
+ * fds we keep. Returns false if the kernel doesn't have close_range.
+ */
+static bool closeFdsWithCloseRange(int keepFd) {
+#if defined(__NR_close_range)
+    int kept[2] = { keepFd, -1 };
+#ifdef ANDROID
+    kept[1] = androidSystemPropertiesFd;
+#endif
+    if (kept[1] < kept[0]) {
+        int tmp = kept[0];
+        kept[0] = kept[1];
+        kept[1] = tmp;
+    }
+    unsigned int first = 3;
+    for (int i = 0; i < 2; ++i) {
+        if (kept[i] < static_cast<int>(first)) {
+            continue;
+        }
+        if (kept[i] > static_cast<int>(first)
+                && syscall(__NR_close_range, first, kept[i] - 1, 0) == -1) {
+            return false;
+        }
+        first = kept[i] + 1;
+    }
+    return syscall(__NR_close_range, first, ~0U, 0) == 0;
+#else
+    (void) keepFd;
+    return false;
+#endif
+}
+
+/**
+ * Closes every fd above 2 other than keepFd by listing /proc/self/fd. Uses getdents64 directly
+ * because opendir(3) would malloc. Returns false if the directory couldn't be read.
+ */
+static bool closeFdsFromProc(int keepFd) {
+#if defined(__NR_getdents64)
+    struct linux_dirent64 {
+        uint64_t d_ino;
+        int64_t d_off;
+        unsigned short d_reclen;
+        unsigned char d_type;
+        char d_name[1];
+    };
+    int dirFd = open("/proc/self/fd", O_RDONLY | O_DIRECTORY);
+    if (dirFd == -1) {
+        return false;
+    }
+    uint64_t buf[512];
+    long byteCount;
+    // Closing entries as we go is safe: /proc/self/fd is read in fd order.
+    while ((byteCount = syscall(__NR_getdents64, dirFd, buf, sizeof(buf))) > 0) {
+        char* entries = reinterpret_cast<char*>(buf);
+        for (long offset = 0; offset < byteCount; ) {
+            linux_dirent64* entry = reinterpret_cast<linux_dirent64*>(entries + offset);
+            offset += entry->d_reclen;
+            // Skip "." and "..", and anything else that isn't a number.
+            int fd = 0;
+            const char* p = entry->d_name;
+            for (; *p >= '0' && *p <= '9'; ++p) {
+                fd = fd * 10 + (*p - '0');
+            }
+            if (p == entry->d_name || *p != '\0') {
+                continue;
+            }
+            if (fd != dirFd && !isInheritedFd(fd, keepFd)) {
+                close(fd);
+            }
+        }
+    }
+    close(dirFd);
+    return byteCount == 0;
+#else
+    (void) keepFd;
+    return false;
+#endif
+}
+
+/**
+ * Close all open fds > 2 (i.e. everything but stdin/out/err), != keepFd. Calling close on every
+ * fd up to RLIMIT_NOFILE costs a syscall per possible fd, so that's only the last resort.
+ */
+static void closeNonStandardFds(int keepFd) {
+    if (closeFdsWithCloseRange(keepFd) || closeFdsFromProc(keepFd)) {
+        return;
+    }
     rlimit rlimit;
     getrlimit(RLIMIT_NOFILE, &rlimit);
     const int max_fd = rlimit.rlim_max;
     for (int fd = 3; fd < max_fd; ++fd) {
-        if (fd != skipFd
-#ifdef ANDROID
-                && fd != androidSystemPropertiesFd
-#endif
-                ) {
+        if (!isInheritedFd(fd, keepFd)) {
             close(fd);
         }
     }
 }
 
+/**
+ * Runs execve(2), falling back as execvp(3) does to running the file with the shell if it's
+ * neither a binary nor a #! script. Only returns on failure, with errno set.
+ */
+static void execveOrShell(const char* file, char* const argv[], char* const environment[]) {
+    execve(file, argv, environment);
+    if (errno != ENOEXEC) {
+        return;
+    }
+    size_t argc = 0;
+    while (argv[argc] != NULL) {
+        ++argc;
+    }
+    const char* shellArgv[argc + 2];
+    shellArgv[0] = _PATH_BSHELL;
+    shellArgv[1] = file;
+    for (size_t i = 1; i <= argc; ++i) {
+        shellArgv[i + 1] = argv[i];
+    }
+    execve(_PATH_BSHELL, const_cast<char* const*>(shellArgv), environment);
+    // Report the original failure, not the shell's.
+    errno = ENOEXEC;
+}
+
+/**
+ * Returns the value of PATH in 'environment', or NULL if it has none.
+ */
+static const char* findPath(char* const environment[]) {
+    for (size_t i = 0; environment[i] != NULL; ++i) {
+        if (strncmp(environment[i], "PATH=", 5) == 0) {
+            return environment[i] + 5;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Like execvp(3), but with 'environment' as the new process' environment. A vfork child can't
+ * assign to environ without changing the parent's, so this does the PATH search itself over
+ * 'path', which should be the PATH in 'environment', as if the child had set environ to it and
+ * called execvp. 'path' must be looked up before vfork. Only returns on failure, with errno set.
+ */
+static void execvpWithEnvironment(const char* file, char* const argv[],
+        char* const environment[], const char* path) {
+    if (strchr(file, '/') != NULL) {
+        execveOrShell(file, argv, environment);
+        return;
+    }
+    if (path == NULL) {
+        path = _PATH_DEFPATH;
+    }
+    bool sawEacces = false;
+    char candidate[PATH_MAX];
+    const size_t fileLength = strlen(file);
+    while (true) {
+        const char* end = strchr(path, ':');
+        size_t dirLength = (end != NULL) ? end - path : strlen(path);
+        // An empty PATH entry means the current directory.
+        const char* dir = (dirLength == 0) ? "." : path;
+        if (dirLength == 0) {
+            dirLength = 1;
+        }
+        if (dirLength + 1 + fileLength < sizeof(candidate)) {
+            memcpy(candidate, dir, dirLength);
+            candidate[dirLength] = '/';
+            memcpy(candidate + dirLength + 1, file, fileLength + 1);
+            execveOrShell(candidate, argv, environment);
+            if (errno == EACCES) {
+                sawEacces = true;
+            } else if (errno != ENOENT && errno != ENOTDIR) {
+                return;
+            }
+        }
+        if (end == NULL) {
+            break;
+        }
+        path = end + 1;
+    }
+    if (sawEacces) {
+        errno = EACCES;
+    }
+}
+
 #define PIPE_COUNT (4) // number of pipes used to communicate with child proc
 
 /** Closes all pipes in the given array. */
@@ -172,7 +440,7 @@ static void closePipes(int pipes[], int skipFd) {
 static pid_t executeProcess(JNIEnv* env, char** commands, char** environment,
         const char* workingDirectory, jobject inDescriptor,
         jobject outDescriptor, jobject errDescriptor,
-        jboolean redirectErrorStream) {
+        jboolean redirectErrorStream, jboolean supervised) {
     int i, result, error;
 
     // Create 4 pipes: stdin, stdout, stderr, and an exec() status pipe.
@@ -193,11 +461,29 @@ static pid_t executeProcess(JNIEnv* env, char** commands, char** environment,
     int statusIn = pipes[6];
     int statusOut = pipes[7];
 
-    pid_t childPid = fork();
+    // Looked up now because the child mustn't touch the parent's memory beyond its own stack.
+    // The command is searched for on the child's PATH, as when the child's environment was
+    // installed in environ before calling execvp.
+    if (environment == NULL) {
+        environment = environ;
+    }
+    const char* path = findPath(environment);
+
+    // The child shares the parent's memory until it execs, so keep the child's signal handlers
+    // from running until it has reset them.
+    sigset_t allSignals, oldMask;
+    sigfillset(&allSignals);
+    pthread_sigmask(SIG_SETMASK, &allSignals, &oldMask);
 
-    // If fork() failed...
+    // vfork rather than fork: fork would copy the page tables of the whole heap only for the
+    // child to throw them away when it execs.
+    pid_t childPid = vfork();
+
+    // If vfork() failed...
     if (childPid == -1) {
-        jniThrowIOException(env, errno);
+        error = errno;
+        pthread_sigmask(SIG_SETMASK, &oldMask, NULL);
+        jniThrowIOException(env, error);
         closePipes(pipes, -1);
         return -1;
     }
@@ -205,11 +491,30 @@ static pid_t executeProcess(JNIEnv* env, char** commands, char** environment,
     // If this is the child process...
     if (childPid == 0) {
         /*
-         * Note: We cannot malloc() or free() after this point!
-         * A no-longer-running thread may be holding on to the heap lock, and
-         * an attempt to malloc() or free() would result in deadlock.
+         * Note: We cannot malloc() or free() after this point, or write to
+         * anything but our own stack: we're running in the parent's address
+         * space. A no-longer-running thread may be holding on to the heap
+         * lock, and an attempt to malloc() or free() would result in deadlock.
          */
 
+        // exec would reset handled signals to the default anyway; doing it now means none of the
+        // parent's handlers can run in this process once signals are unblocked.
+        for (int signum = 1; signum < NSIG; ++signum) {
+            struct sigaction action;
+            if (sigaction(signum, NULL, &action) == 0 && action.sa_handler != SIG_IGN
+                    && action.sa_handler != SIG_DFL) {
+                action.sa_handler = SIG_DFL;
+                sigaction(signum, &action, NULL);
+            }
+        }
+        sigprocmask(SIG_SETMASK, &oldMask, NULL);
+
+        // A supervised child gets its own process group, so watchChildren's waitpid(0) won't
+        // reap it out from under ProcessManager.reapSupervised.
+        if (supervised) {
+            setpgid(0, 0);
+        }
+
         // Replace stdin, out, and err with pipes.
         dup2(stdinIn, 0);
         dup2(stdoutOut, 1);
@@ -222,7 +527,7 @@ static pid_t executeProcess(JNIEnv* env, char** commands, char** environment,
         // Close all but statusOut. This saves some work in the next step.
         closePipes(pipes, statusOut);
 
-        // Make statusOut automatically close if execvp() succeeds.
+        // Make statusOut automatically close if exec succeeds.
         fcntl(statusOut, F_SETFD, FD_CLOEXEC);
 
         // Close remaining open fds with the exception of statusOut.
@@ -235,25 +540,22 @@ static pid_t executeProcess(JNIEnv* env, char** commands, char** environment,
             }
         }
 
-        // Set up environment.
-        if (environment != NULL) {
-            environ = environment;
-        }
-
         // Execute process. By convention, the first argument in the arg array
         // should be the command itself. In fact, I get segfaults when this
         // isn't the case.
-        execvp(commands[0], commands);
+        execvpWithEnvironment(commands[0], commands, environment, path);
 
-        // If we got here, execvp() failed or the working dir was invalid.
+        // If we got here, exec failed or the working dir was invalid.
 execFailed:
-        error = errno;
-        write(statusOut, &error, sizeof(int));
+        int childError = errno;
+        write(statusOut, &childError, sizeof(int));
         close(statusOut);
-        exit(error);
+        // _exit, because exit would run the parent's atexit handlers and flush its stdio.
+        _exit(childError);
     }
 
     // This is the parent process.
+    pthread_sigmask(SIG_SETMASK, &oldMask, NULL);
 
     // Close child's pipe ends.
     close(stdinIn);
@@ -324,7 +626,7 @@ static void freeStrings(JNIEnv* env, jobjectArray javaArray, char** array) {
 static pid_t ProcessManager_exec(JNIEnv* env, jclass, jobjectArray javaCommands,
         jobjectArray javaEnvironment, jstring javaWorkingDirectory,
         jobject inDescriptor, jobject outDescriptor, jobject errDescriptor,
-        jboolean redirectErrorStream) {
+        jboolean redirectErrorStream, jboolean supervised) {
 
     // Copy commands into char*[].
     char** commands = convertStrings(env, javaCommands);
@@ -339,7 +641,7 @@ static pid_t ProcessManager_exec(JNIEnv* env, jclass, jobjectArray javaCommands,
     char** environment = convertStrings(env, javaEnvironment);
 
     pid_t result = executeProcess(env, commands, environment, workingDirectory,
-            inDescriptor, outDescriptor, errDescriptor, redirectErrorStream);
+            inDescriptor, outDescriptor, errDescriptor, redirectErrorStream, supervised);
 
     // Temporarily clear exception so we can clean up.
     jthrowable exception = env->ExceptionOccurred();
@@ -384,9 +686,12 @@ static void ProcessManager_staticInitialize(JNIEnv* env,
 
 static JNINativeMethod methods[] = {
     NATIVE_METHOD(ProcessManager, kill, "(I)V"),
+    NATIVE_METHOD(ProcessManager, openPidFd, "(I)Ljava/io/FileDescriptor;"),
+    NATIVE_METHOD(ProcessManager, openSigChldFd, "()Ljava/io/FileDescriptor;"),
+    NATIVE_METHOD(ProcessManager, reapExited, "([I[I[I)I"),
     NATIVE_METHOD(ProcessManager, staticInitialize, "()V"),
     NATIVE_METHOD(ProcessManager, watchChildren, "()V"),
-    NATIVE_METHOD(ProcessManager, exec, "([Ljava/lang/String;[Ljava/lang/String;Ljava/lang/String;Ljava/io/FileDescriptor;Ljava/io/FileDescriptor;Ljava/io/FileDescriptor;Z)I"),
+    NATIVE_METHOD(ProcessManager, exec, "([Ljava/lang/String;[Ljava/lang/String;Ljava/lang/String;Ljava/io/FileDescriptor;Ljava/io/FileDescriptor;Ljava/io/FileDescriptor;ZZ)I"),
 };
 void register_java_lang_ProcessManager(JNIEnv* env) {
     jniRegisterNativeMethods(env, "java/lang/ProcessManager", methods, NELEM(methods));
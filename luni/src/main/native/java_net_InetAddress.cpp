@@ -31,6 +31,12 @@
 #include <string.h>
 #include <netdb.h>
 #include <errno.h>
+#include <pthread.h>
+#include <time.h>
+
+#include <map>
+#include <string>
+#include <vector>
 
 #include <netinet/in.h>
 #include <arpa/inet.h>
@@ -66,12 +72,63 @@ static inline void logIpString(addrinfo*, const char*)
 }
 #endif
 
-static jobjectArray InetAddress_getaddrinfo(JNIEnv* env, jclass, jstring javaName) {
-    ScopedUtfChars name(env, javaName);
-    if (name.c_str() == NULL) {
-        return NULL;
+/*
+ * A resolver shared by all threads. Results (including failures) are cached for a while, and
+ * concurrent lookups of the same name share one getaddrinfo(3) call. Callers that can't afford
+ * to stall hand the lookup to a small pool of worker threads and wait only as long as they're
+ * prepared to; the lookup carries on without them, and its result is cached for next time.
+ *
+ * getaddrinfo(3) doesn't tell us the TTLs of the records it found, so we use the same fixed
+ * TTLs as the Java AddressCache. Transient failures (EAI_AGAIN) are only cached briefly, so a
+ * DNS hiccup doesn't hang every thread but doesn't outlive the hiccup by much either.
+ */
+static const int64_t RESOLVER_POSITIVE_TTL_MS = 600 * 1000;
+static const int64_t RESOLVER_NEGATIVE_TTL_MS = 10 * 1000;
+static const int64_t RESOLVER_TRANSIENT_TTL_MS = 1000;
+static const size_t RESOLVER_MAX_ENTRIES = 512;
+static const int RESOLVER_MAX_THREADS = 4;
+
+struct ResolverEntry {
+    ResolverEntry() : inFlight(false), done(false), result(0), error(0), expiryMs(0), waiters(0) {
     }
 
+    // Whether someone is currently calling getaddrinfo for this entry.
+    bool inFlight;
+    // Whether 'addresses' (or 'result' and 'error') hold the outcome of a finished lookup.
+    bool done;
+    // The getaddrinfo result, and errno if that was EAI_SYSTEM.
+    int result;
+    int error;
+    // The raw 4- or 16-byte addresses, in the order getaddrinfo returned them.
+    std::vector<std::string> addresses;
+    int64_t expiryMs;
+    // The number of threads waiting for this entry. Entries with waiters are never evicted.
+    int waiters;
+};
+
+typedef std::map<std::string, ResolverEntry*> ResolverCache;
+
+static pthread_mutex_t gResolverMutex = PTHREAD_MUTEX_INITIALIZER;
+// Signalled whenever an entry's lookup finishes.
+static pthread_cond_t gResolverDone = PTHREAD_COND_INITIALIZER;
+// Signalled whenever work is queued for the resolver threads.
+static pthread_cond_t gResolverWork = PTHREAD_COND_INITIALIZER;
+static ResolverCache gResolverCache;
+static std::vector<std::string> gResolverQueue;
+static int gResolverThreadCount = 0;
+static int gResolverIdleThreadCount = 0;
+// For tests: behave as if no resolver thread is running and none can be started.
+static bool gResolverThreadsUnavailable = false;
+
+static int64_t monotonicMs() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000 + now.tv_nsec / 1000000;
+}
+
+// Calls getaddrinfo(3) for 'name', storing the outcome in 'entry'. Called without the lock
+// held, on a private 'entry'.
+static void resolve(const char* name, ResolverEntry* entry) {
     addrinfo hints;
     memset(&hints, 0, sizeof(hints));
     hints.ai_family = AF_UNSPEC;
@@ -84,79 +141,315 @@ static jobjectArray InetAddress_getaddrinfo(JNIEnv* env, jclass, jstring javaNam
     hints.ai_socktype = SOCK_STREAM;
 
     addrinfo* addressList = NULL;
-    jobjectArray addressArray = NULL;
-    int result = getaddrinfo(name.c_str(), NULL, &hints, &addressList);
-    if (result == 0 && addressList) {
-        // Count results so we know how to size the output array.
-        int addressCount = 0;
-        for (addrinfo* ai = addressList; ai != NULL; ai = ai->ai_next) {
-            if (ai->ai_family == AF_INET || ai->ai_family == AF_INET6) {
-                addressCount++;
-            }
-        }
-
-        // Prepare output array.
-        addressArray = env->NewObjectArray(addressCount, JniConstants::byteArrayClass, NULL);
-        if (addressArray == NULL) {
-            // Appropriate exception will be thrown.
-            ALOGE("getaddrinfo: could not allocate array of size %i", addressCount);
-            freeaddrinfo(addressList);
-            return NULL;
-        }
-
-        // Examine returned addresses one by one, save them in the output array.
-        int index = 0;
+    entry->result = getaddrinfo(name, NULL, &hints, &addressList);
+    entry->error = errno;
+    if (entry->result == 0 && addressList) {
         for (addrinfo* ai = addressList; ai != NULL; ai = ai->ai_next) {
             sockaddr* address = ai->ai_addr;
-            size_t addressLength = 0;
-            void* rawAddress;
-
             switch (ai->ai_family) {
-                // Find the raw address length and start pointer.
                 case AF_INET6:
-                    addressLength = 16;
-                    rawAddress = &reinterpret_cast<sockaddr_in6*>(address)->sin6_addr.s6_addr;
-                    logIpString(ai, name.c_str());
+                    logIpString(ai, name);
+                    entry->addresses.push_back(std::string(reinterpret_cast<const char*>(
+                            &reinterpret_cast<sockaddr_in6*>(address)->sin6_addr.s6_addr), 16));
                     break;
                 case AF_INET:
-                    addressLength = 4;
-                    rawAddress = &reinterpret_cast<sockaddr_in*>(address)->sin_addr.s_addr;
-                    logIpString(ai, name.c_str());
+                    logIpString(ai, name);
+                    entry->addresses.push_back(std::string(reinterpret_cast<const char*>(
+                            &reinterpret_cast<sockaddr_in*>(address)->sin_addr.s_addr), 4));
                     break;
                 default:
                     // Unknown address family. Skip this address.
                     ALOGE("getaddrinfo: Unknown address family %d", ai->ai_family);
-                    continue;
+                    break;
             }
+        }
+    }
+    if (addressList) {
+        freeaddrinfo(addressList);
+    }
+
+    int64_t ttl = RESOLVER_NEGATIVE_TTL_MS;
+    if (entry->result == 0) {
+        ttl = RESOLVER_POSITIVE_TTL_MS;
+    } else if (entry->result == EAI_AGAIN) {
+        ttl = RESOLVER_TRANSIENT_TTL_MS;
+    } else if (entry->result == EAI_SYSTEM && entry->error == EACCES) {
+        // Permission can be granted at any time.
+        ttl = 0;
+    }
+    entry->expiryMs = monotonicMs() + ttl;
+}
 
-            // Convert each IP address into a Java byte array.
-            ScopedLocalRef<jbyteArray> byteArray(env, env->NewByteArray(addressLength));
-            if (byteArray.get() == NULL) {
-                // Out of memory error will be thrown on return.
-                ALOGE("getaddrinfo: Can't allocate %d-byte array", addressLength);
-                addressArray = NULL;
-                break;
+// Makes room in the cache by dropping expired entries, or every finished entry if none have
+// expired. Called with the lock held.
+static void trimResolverCacheLocked() {
+    if (gResolverCache.size() < RESOLVER_MAX_ENTRIES) {
+        return;
+    }
+    int64_t now = monotonicMs();
+    for (int pass = 0; pass < 2 && gResolverCache.size() >= RESOLVER_MAX_ENTRIES; ++pass) {
+        for (ResolverCache::iterator it = gResolverCache.begin(); it != gResolverCache.end(); ) {
+            ResolverEntry* entry = it->second;
+            bool evictable = entry->done && !entry->inFlight && entry->waiters == 0;
+            if (evictable && (pass == 1 || entry->expiryMs <= now)) {
+                delete entry;
+                gResolverCache.erase(it++);
+            } else {
+                ++it;
             }
-            env->SetByteArrayRegion(byteArray.get(),
-                    0, addressLength, reinterpret_cast<jbyte*>(rawAddress));
-            env->SetObjectArrayElement(addressArray, index, byteArray.get());
-            index++;
         }
-    } else if (result == EAI_SYSTEM && errno == EACCES) {
-        /* No permission to use network */
-        jniThrowException(env, "java/lang/SecurityException",
-            "Permission denied (maybe missing INTERNET permission)");
+    }
+}
+
+// Publishes the outcome of a lookup of 'name'. Called with the lock held.
+static void finishLookupLocked(const std::string& name, ResolverEntry* result) {
+    ResolverEntry* entry = gResolverCache[name];
+    entry->result = result->result;
+    entry->error = result->error;
+    entry->addresses.swap(result->addresses);
+    entry->expiryMs = result->expiryMs;
+    entry->inFlight = false;
+    entry->done = true;
+    pthread_cond_broadcast(&gResolverDone);
+}
+
+static void* resolverThread(void*) {
+    pthread_mutex_lock(&gResolverMutex);
+    while (true) {
+        while (gResolverQueue.empty()) {
+            ++gResolverIdleThreadCount;
+            pthread_cond_wait(&gResolverWork, &gResolverMutex);
+            --gResolverIdleThreadCount;
+        }
+        std::string name(gResolverQueue.front());
+        gResolverQueue.erase(gResolverQueue.begin());
+        pthread_mutex_unlock(&gResolverMutex);
+
+        ResolverEntry result;
+        resolve(name.c_str(), &result);
+
+        pthread_mutex_lock(&gResolverMutex);
+        finishLookupLocked(name, &result);
+    }
+    return NULL;
+}
+
+// Queues a lookup of 'name' for the resolver threads, starting another thread if they're all
+// busy and we're allowed more. If there's no thread to serve the queue and none can be started,
+// fails the lookup with EAI_AGAIN instead, so its waiters aren't left blocked on a lookup that
+// will never happen. Called with the lock held.
+static void queueLookupLocked(const std::string& name) {
+    bool served = gResolverThreadCount > 0 && !gResolverThreadsUnavailable;
+    if (!gResolverThreadsUnavailable && gResolverIdleThreadCount == 0
+            && gResolverThreadCount < RESOLVER_MAX_THREADS) {
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        pthread_t thread;
+        int rc = pthread_create(&thread, &attr, resolverThread, NULL);
+        if (rc == 0) {
+            ++gResolverThreadCount;
+            served = true;
+        } else if (!served) {
+            ALOGE("couldn't start a resolver thread: %s", strerror(rc));
+        }
+        pthread_attr_destroy(&attr);
+    }
+    if (!served) {
+        // Already expired, so the next attempt tries again.
+        ResolverEntry result;
+        result.result = EAI_AGAIN;
+        result.expiryMs = monotonicMs();
+        finishLookupLocked(name, &result);
+        return;
+    }
+    gResolverQueue.push_back(name);
+    pthread_cond_signal(&gResolverWork);
+}
+
+/**
+ * Returns the entry for 'name', starting a lookup if there isn't a current result or one on
+ * the way. If 'synchronous', the lookup is done on the calling thread (unless another thread
+ * is already doing it). Called with the lock held. Returns NULL only if 'synchronous' and the
+ * calling thread must do the lookup itself.
+ */
+static ResolverEntry* findOrStartLookupLocked(const std::string& name, bool synchronous) {
+    ResolverCache::iterator it = gResolverCache.find(name);
+    ResolverEntry* entry;
+    if (it == gResolverCache.end()) {
+        trimResolverCacheLocked();
+        entry = new ResolverEntry;
+        gResolverCache[name] = entry;
     } else {
-        jniThrowException(env, "java/net/UnknownHostException", gai_strerror(result));
+        entry = it->second;
+        if (entry->done && entry->expiryMs > monotonicMs()) {
+            return entry;
+        }
+    }
+    if (!entry->inFlight) {
+        // Threads already waiting for this entry will wait for the new lookup.
+        entry->inFlight = true;
+        entry->done = false;
+        if (synchronous) {
+            return NULL;
+        }
+        queueLookupLocked(name);
     }
+    return entry;
+}
 
-    if (addressList) {
-        freeaddrinfo(addressList);
+/**
+ * Waits until 'entry' is done, or until 'deadlineMs' (if it's not 0). Called with the lock
+ * held. Returns false if the deadline passed first.
+ */
+static bool waitForLookupLocked(ResolverEntry* entry, int64_t deadlineMs) {
+    ++entry->waiters;
+    while (!entry->done) {
+        if (deadlineMs == 0) {
+            pthread_cond_wait(&gResolverDone, &gResolverMutex);
+            continue;
+        }
+        int64_t remainingMs = deadlineMs - monotonicMs();
+        if (remainingMs <= 0) {
+            break;
+        }
+        // pthread_cond_timedwait wants an absolute CLOCK_REALTIME time.
+        timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += remainingMs / 1000;
+        deadline.tv_nsec += (remainingMs % 1000) * 1000000;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec += 1;
+            deadline.tv_nsec -= 1000000000;
+        }
+        pthread_cond_timedwait(&gResolverDone, &gResolverMutex, &deadline);
     }
+    --entry->waiters;
+    return entry->done;
+}
 
+/**
+ * Converts a finished lookup to the byte[][] that getaddrinfo returns to Java, or throws.
+ */
+static jobjectArray toAddressArray(JNIEnv* env, const ResolverEntry& entry) {
+    if (entry.result != 0) {
+        if (entry.result == EAI_SYSTEM && entry.error == EACCES) {
+            /* No permission to use network */
+            jniThrowException(env, "java/lang/SecurityException",
+                "Permission denied (maybe missing INTERNET permission)");
+        } else {
+            jniThrowException(env, "java/net/UnknownHostException", gai_strerror(entry.result));
+        }
+        return NULL;
+    }
+
+    // Prepare output array.
+    int addressCount = entry.addresses.size();
+    jobjectArray addressArray = env->NewObjectArray(addressCount, JniConstants::byteArrayClass, NULL);
+    if (addressArray == NULL) {
+        // Appropriate exception will be thrown.
+        ALOGE("getaddrinfo: could not allocate array of size %i", addressCount);
+        return NULL;
+    }
+
+    // Convert each IP address into a Java byte array.
+    for (int i = 0; i < addressCount; ++i) {
+        const std::string& address = entry.addresses[i];
+        int addressLength = address.size();
+        ScopedLocalRef<jbyteArray> byteArray(env, env->NewByteArray(addressLength));
+        if (byteArray.get() == NULL) {
+            // Out of memory error will be thrown on return.
+            ALOGE("getaddrinfo: Can't allocate %d-byte array", addressLength);
+            return NULL;
+        }
+        env->SetByteArrayRegion(byteArray.get(),
+                0, addressLength, reinterpret_cast<const jbyte*>(address.data()));
+        env->SetObjectArrayElement(addressArray, i, byteArray.get());
+    }
     return addressArray;
 }
 
+/**
+ * Resolves 'javaName', waiting at most 'timeoutMs' milliseconds (or as long as it takes, if
+ * 'timeoutMs' is 0). Returns NULL without throwing if the lookup timed out. The lookup carries
+ * on in the background, and its result will be cached.
+ */
+static jobjectArray InetAddress_getaddrinfoWithTimeout(JNIEnv* env, jclass, jstring javaName,
+        jint timeoutMs) {
+    ScopedUtfChars name(env, javaName);
+    if (name.c_str() == NULL) {
+        return NULL;
+    }
+    const std::string key(name.c_str());
+    const int64_t deadlineMs = (timeoutMs > 0) ? monotonicMs() + timeoutMs : 0;
+
+    ResolverEntry result;
+    pthread_mutex_lock(&gResolverMutex);
+    ResolverEntry* entry = findOrStartLookupLocked(key, timeoutMs <= 0);
+    if (entry == NULL) {
+        // We're the first to want this name, and we're prepared to wait: look it up ourselves.
+        pthread_mutex_unlock(&gResolverMutex);
+        resolve(name.c_str(), &result);
+        pthread_mutex_lock(&gResolverMutex);
+        finishLookupLocked(key, &result);
+        entry = gResolverCache[key];
+    }
+    bool done = waitForLookupLocked(entry, deadlineMs);
+    if (done) {
+        // Copy the result so we can build the Java arrays without holding the lock.
+        result.result = entry->result;
+        result.error = entry->error;
+        result.addresses = entry->addresses;
+    }
+    pthread_mutex_unlock(&gResolverMutex);
+
+    if (!done) {
+        return NULL;
+    }
+    return toAddressArray(env, result);
+}
+
+/**
+ * Starts resolving 'javaName' in the background, unless there's already a current result.
+ */
+static void InetAddress_prefetchaddrinfo(JNIEnv* env, jclass, jstring javaName) {
+    ScopedUtfChars name(env, javaName);
+    if (name.c_str() == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&gResolverMutex);
+    findOrStartLookupLocked(std::string(name.c_str()), false);
+    pthread_mutex_unlock(&gResolverMutex);
+}
+
+/**
+ * Drops every finished entry from the native resolver cache.
+ */
+static void InetAddress_clearaddrinfoCache(JNIEnv*, jclass) {
+    pthread_mutex_lock(&gResolverMutex);
+    for (ResolverCache::iterator it = gResolverCache.begin(); it != gResolverCache.end(); ) {
+        ResolverEntry* entry = it->second;
+        if (entry->done && !entry->inFlight && entry->waiters == 0) {
+            delete entry;
+            gResolverCache.erase(it++);
+        } else {
+            // Make sure nobody uses this entry's result again.
+            entry->expiryMs = 0;
+            ++it;
+        }
+    }
+    pthread_mutex_unlock(&gResolverMutex);
+}
+
+/**
+ * For tests: makes asynchronous lookups fail as if no resolver thread could be started.
+ */
+static void InetAddress_setResolverThreadsUnavailable(JNIEnv*, jclass, jboolean unavailable) {
+    pthread_mutex_lock(&gResolverMutex);
+    gResolverThreadsUnavailable = unavailable;
+    pthread_mutex_unlock(&gResolverMutex);
+}
+
 /**
  * Looks up the name corresponding to an IP address.
  *
@@ -327,10 +620,13 @@ static jstring InetAddress_byteArrayToIpString(JNIEnv* env, jobject, jbyteArray
 
 static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(InetAddress, byteArrayToIpString, "([B)Ljava/lang/String;"),
-    NATIVE_METHOD(InetAddress, getaddrinfo, "(Ljava/lang/String;)[[B"),
+    NATIVE_METHOD(InetAddress, clearaddrinfoCache, "()V"),
+    NATIVE_METHOD(InetAddress, getaddrinfoWithTimeout, "(Ljava/lang/String;I)[[B"),
     NATIVE_METHOD(InetAddress, gethostname, "()Ljava/lang/String;"),
     NATIVE_METHOD(InetAddress, getnameinfo, "([B)Ljava/lang/String;"),
     NATIVE_METHOD(InetAddress, ipStringToByteArray, "(Ljava/lang/String;)[B"),
+    NATIVE_METHOD(InetAddress, prefetchaddrinfo, "(Ljava/lang/String;)V"),
+    NATIVE_METHOD(InetAddress, setResolverThreadsUnavailable, "(Z)V"),
 };
 void register_java_net_InetAddress(JNIEnv* env) {
     jniRegisterNativeMethods(env, "java/net/InetAddress", gMethods, NELEM(gMethods));
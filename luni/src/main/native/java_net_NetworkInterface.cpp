@@ -23,9 +23,12 @@
 #include "jni.h"
 #include "NetworkUtilities.h"
 #include "ScopedFd.h"
+#include "ScopedLocalRef.h"
 
 #include <errno.h>
+#include <fcntl.h>
 #include <netinet/in.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -41,6 +44,12 @@
 #include <ifaddrs.h>
 #endif
 
+#ifdef __linux__
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#define ENABLE_NETLINK_CHANGES
+#endif
+
 // Ensures we always call freeifaddrs(3) to clean up after getifaddrs(3).
 class ScopedInterfaceAddresses {
 public:
@@ -88,17 +97,21 @@ static jobject makeInterfaceAddress(JNIEnv* env, jint interfaceIndex, ifaddrs* i
             interfaceIndex, javaName, javaAddress, javaMask);
 }
 
-static jobjectArray NetworkInterface_getAllInterfaceAddressesImpl(JNIEnv* env, jclass) {
-    // Get the list of interface addresses.
-    ScopedInterfaceAddresses addresses;
-    if (!addresses.init()) {
-        jniThrowSocketException(env, errno);
-        return NULL;
+// Returns true if 'ifa' has an IPv4 or IPv6 address.
+static bool isIpAddress(ifaddrs* ifa) {
+    if (ifa->ifa_addr == NULL) {
+        return false;
     }
+    int family = ifa->ifa_addr->sa_family;
+    return family == AF_INET || family == AF_INET6;
+}
 
+// Returns an InterfaceAddress[] for the IP addresses in 'list', optionally only those of
+// interfaces that are up. The array may contain harmless null elements.
+static jobjectArray makeInterfaceAddresses(JNIEnv* env, ifaddrs* list, bool upOnly) {
     // Count how many there are.
     int interfaceAddressCount = 0;
-    for (ifaddrs* ifa = addresses.list; ifa != NULL; ifa = ifa->ifa_next) {
+    for (ifaddrs* ifa = list; ifa != NULL; ifa = ifa->ifa_next) {
         ++interfaceAddressCount;
     }
 
@@ -111,15 +124,12 @@ static jobjectArray NetworkInterface_getAllInterfaceAddressesImpl(JNIEnv* env, j
 
     // And fill it in...
     int arrayIndex = 0;
-    for (ifaddrs* ifa = addresses.list; ifa != NULL; ifa = ifa->ifa_next) {
+    for (ifaddrs* ifa = list; ifa != NULL; ifa = ifa->ifa_next) {
         // We're only interested in IP addresses.
-        int family = ifa->ifa_addr->sa_family;
-        if (family != AF_INET && family != AF_INET6) {
+        if (!isIpAddress(ifa)) {
             continue;
         }
-        // Until we implement Java 6's NetworkInterface.isUp,
-        // we only want interfaces that are up.
-        if ((ifa->ifa_flags & IFF_UP) == 0) {
+        if (upOnly && (ifa->ifa_flags & IFF_UP) == 0) {
             continue;
         }
         // Find the interface's index, and skip this address if
@@ -129,11 +139,11 @@ static jobjectArray NetworkInterface_getAllInterfaceAddressesImpl(JNIEnv* env, j
             continue;
         }
         // Make a new InterfaceAddress, and insert it into the array.
-        jobject element = makeInterfaceAddress(env, interfaceIndex, ifa);
-        if (element == NULL) {
+        ScopedLocalRef<jobject> element(env, makeInterfaceAddress(env, interfaceIndex, ifa));
+        if (element.get() == NULL) {
             return NULL;
         }
-        env->SetObjectArrayElement(result, arrayIndex, element);
+        env->SetObjectArrayElement(result, arrayIndex, element.get());
         if (env->ExceptionCheck()) {
             return NULL;
         }
@@ -142,6 +152,236 @@ static jobjectArray NetworkInterface_getAllInterfaceAddressesImpl(JNIEnv* env, j
     return result;
 }
 
+static jobjectArray NetworkInterface_getAllInterfaceAddressesImpl(JNIEnv* env, jclass) {
+    // Get the list of interface addresses.
+    ScopedInterfaceAddresses addresses;
+    if (!addresses.init()) {
+        jniThrowSocketException(env, errno);
+        return NULL;
+    }
+    // Until we implement Java 6's NetworkInterface.isUp,
+    // we only want interfaces that are up.
+    return makeInterfaceAddresses(env, addresses.list, true);
+}
+
+#ifdef ENABLE_NETLINK_CHANGES
+static pthread_mutex_t gInterfaceChangesMutex = PTHREAD_MUTEX_INITIALIZER;
+static int gInterfaceChangesFd = -1;
+// True from when we hear about a change until a snapshot reflecting it has been built.
+static bool gInterfacesChangePending = true;
+
+// Opens a netlink socket that hears about every link and address change.
+static int openInterfaceChangesSocket() {
+    int fd = socket(AF_NETLINK, SOCK_DGRAM, NETLINK_ROUTE);
+    if (fd == -1) {
+        return -1;
+    }
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    sockaddr_nl address;
+    memset(&address, 0, sizeof(address));
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * Returns true if any interface may have changed since the last successful snapshot (see
+ * interfacesSnapshotTaken). Always returns true until the first snapshot, and if we can't
+ * listen for changes.
+ */
+static bool interfacesChanged() {
+    pthread_mutex_lock(&gInterfaceChangesMutex);
+    bool changed = gInterfacesChangePending;
+    if (gInterfaceChangesFd == -1) {
+        gInterfaceChangesFd = openInterfaceChangesSocket();
+        changed = true;
+    }
+    if (gInterfaceChangesFd == -1) {
+        changed = true;
+    } else {
+        // We don't care what changed, only whether anything did, so just drain the socket.
+        char buf[4096];
+        while (true) {
+            ssize_t rc = recv(gInterfaceChangesFd, buf, sizeof(buf), 0);
+            if (rc > 0) {
+                changed = true;
+            } else if (rc == -1 && errno == EINTR) {
+                continue;
+            } else {
+                if (rc == -1 && errno != EAGAIN) {
+                    // ENOBUFS means we missed some changes, so assume the worst.
+                    changed = true;
+                }
+                break;
+            }
+        }
+    }
+    // Draining the socket consumed the news, so remember it until a snapshot has been built.
+    gInterfacesChangePending = changed;
+    pthread_mutex_unlock(&gInterfaceChangesMutex);
+    return changed;
+}
+
+/**
+ * Records that a snapshot has been built since the last call to interfacesChanged. Any
+ * change after that is still queued on the socket for the next call.
+ */
+static void interfacesSnapshotTaken() {
+    pthread_mutex_lock(&gInterfaceChangesMutex);
+    gInterfacesChangePending = (gInterfaceChangesFd == -1);
+    pthread_mutex_unlock(&gInterfaceChangesMutex);
+}
+#else
+static bool interfacesChanged() {
+    return true;
+}
+
+static void interfacesSnapshotTaken() {
+}
+#endif
+
+// These values must match the SNAPSHOT_ constants in NetworkInterface.java.
+static const int SNAPSHOT_UP = 1;
+static const int SNAPSHOT_LOOPBACK = 2;
+static const int SNAPSHOT_POINT_TO_POINT = 4;
+static const int SNAPSHOT_MULTICAST = 8;
+
+static jint toSnapshotFlags(unsigned int flags) {
+    jint result = 0;
+    if ((flags & IFF_UP) != 0) {
+        result |= SNAPSHOT_UP;
+    }
+    if ((flags & IFF_LOOPBACK) != 0) {
+        result |= SNAPSHOT_LOOPBACK;
+    }
+    if ((flags & IFF_POINTOPOINT) != 0) { // Unix API typo!
+        result |= SNAPSHOT_POINT_TO_POINT;
+    }
+    if ((flags & IFF_MULTICAST) != 0) {
+        result |= SNAPSHOT_MULTICAST;
+    }
+    return result;
+}
+
+// Returns true if 'ifa' is the first IP address in 'list' for its interface.
+static bool isFirstAddressOfInterface(ifaddrs* list, ifaddrs* ifa) {
+    for (ifaddrs* other = list; other != ifa; other = other->ifa_next) {
+        if (isIpAddress(other) && strcmp(other->ifa_name, ifa->ifa_name) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Returns everything NetworkInterface knows how to ask about every interface with an IP address,
+ * from one getifaddrs(3) and one socket's worth of ioctls. The result is an Object[] holding an
+ * InterfaceAddress[] and, per interface, a String[] of names, an int[] of SNAPSHOT_ flags,
+ * an int[] of MTUs, and a byte[][] of hardware addresses (with null for none).
+ *
+ * Unless 'force' is true, returns null if no interface has changed since the last snapshot.
+ * A failed call leaves the change pending, so the next call tries again.
+ */
+static jobjectArray NetworkInterface_getInterfaceSnapshotImpl(JNIEnv* env, jclass, jboolean force) {
+    if (!interfacesChanged() && !force) {
+        return NULL;
+    }
+
+    ScopedInterfaceAddresses addresses;
+    if (!addresses.init()) {
+        jniThrowSocketException(env, errno);
+        return NULL;
+    }
+    ScopedLocalRef<jobjectArray> interfaceAddresses(env,
+            makeInterfaceAddresses(env, addresses.list, false));
+    if (interfaceAddresses.get() == NULL) {
+        return NULL;
+    }
+
+    int interfaceCount = 0;
+    for (ifaddrs* ifa = addresses.list; ifa != NULL; ifa = ifa->ifa_next) {
+        if (isIpAddress(ifa) && isFirstAddressOfInterface(addresses.list, ifa)) {
+            ++interfaceCount;
+        }
+    }
+    ScopedLocalRef<jobjectArray> names(env,
+            env->NewObjectArray(interfaceCount, JniConstants::stringClass, NULL));
+    ScopedLocalRef<jintArray> flags(env, env->NewIntArray(interfaceCount));
+    ScopedLocalRef<jintArray> mtus(env, env->NewIntArray(interfaceCount));
+    ScopedLocalRef<jobjectArray> hardwareAddresses(env,
+            env->NewObjectArray(interfaceCount, JniConstants::byteArrayClass, NULL));
+    if (names.get() == NULL || flags.get() == NULL || mtus.get() == NULL ||
+            hardwareAddresses.get() == NULL) {
+        return NULL;
+    }
+
+    // One socket will do for every interface's ioctls.
+    ScopedFd fd(socket(AF_INET, SOCK_DGRAM, 0));
+    if (fd.get() == -1) {
+        jniThrowSocketException(env, errno);
+        return NULL;
+    }
+    int i = 0;
+    for (ifaddrs* ifa = addresses.list; ifa != NULL; ifa = ifa->ifa_next) {
+        if (!isIpAddress(ifa) || !isFirstAddressOfInterface(addresses.list, ifa)) {
+            continue;
+        }
+        ScopedLocalRef<jstring> name(env, env->NewStringUTF(ifa->ifa_name));
+        if (name.get() == NULL) {
+            return NULL;
+        }
+        env->SetObjectArrayElement(names.get(), i, name.get());
+
+        jint interfaceFlags = toSnapshotFlags(ifa->ifa_flags);
+        env->SetIntArrayRegion(flags.get(), i, 1, &interfaceFlags);
+
+        // An interface can go away under us, in which case we report what we already know.
+        ifreq ifr;
+        memset(&ifr, 0, sizeof(ifr));
+        strncpy(ifr.ifr_name, ifa->ifa_name, IFNAMSIZ - 1);
+        jint mtu = (ioctl(fd.get(), SIOCGIFMTU, &ifr) == -1) ? 0 : ifr.ifr_mtu;
+        env->SetIntArrayRegion(mtus.get(), i, 1, &mtu);
+
+        memset(&ifr, 0, sizeof(ifr));
+        strncpy(ifr.ifr_name, ifa->ifa_name, IFNAMSIZ - 1);
+        if (ioctl(fd.get(), SIOCGIFHWADDR, &ifr) != -1) {
+            bool isEmpty = true;
+            for (int j = 0; j < IFHWADDRLEN; ++j) {
+                if (ifr.ifr_hwaddr.sa_data[j] != 0) {
+                    isEmpty = false;
+                }
+            }
+            if (!isEmpty) {
+                ScopedLocalRef<jbyteArray> hardwareAddress(env, env->NewByteArray(IFHWADDRLEN));
+                if (hardwareAddress.get() == NULL) {
+                    return NULL;
+                }
+                env->SetByteArrayRegion(hardwareAddress.get(), 0, IFHWADDRLEN,
+                        reinterpret_cast<jbyte*>(ifr.ifr_hwaddr.sa_data));
+                env->SetObjectArrayElement(hardwareAddresses.get(), i, hardwareAddress.get());
+            }
+        }
+        ++i;
+    }
+
+    jobjectArray result = env->NewObjectArray(5, JniConstants::objectClass, NULL);
+    if (result == NULL) {
+        return NULL;
+    }
+    env->SetObjectArrayElement(result, 0, interfaceAddresses.get());
+    env->SetObjectArrayElement(result, 1, names.get());
+    env->SetObjectArrayElement(result, 2, flags.get());
+    env->SetObjectArrayElement(result, 3, mtus.get());
+    env->SetObjectArrayElement(result, 4, hardwareAddresses.get());
+    interfacesSnapshotTaken();
+    return result;
+}
+
 static bool doIoctl(JNIEnv* env, jstring name, int request, ifreq& ifr) {
     // Copy the name into the ifreq structure, if there's room...
     jsize nameLength = env->GetStringLength(name);
@@ -219,6 +459,7 @@ static jboolean NetworkInterface_supportsMulticastImpl(JNIEnv* env, jclass, jstr
 static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(NetworkInterface, getAllInterfaceAddressesImpl, "()[Ljava/net/InterfaceAddress;"),
     NATIVE_METHOD(NetworkInterface, getHardwareAddressImpl, "(Ljava/lang/String;)[B"),
+    NATIVE_METHOD(NetworkInterface, getInterfaceSnapshotImpl, "(Z)[Ljava/lang/Object;"),
     NATIVE_METHOD(NetworkInterface, getMTUImpl, "(Ljava/lang/String;)I"),
     NATIVE_METHOD(NetworkInterface, isLoopbackImpl, "(Ljava/lang/String;)Z"),
     NATIVE_METHOD(NetworkInterface, isPointToPointImpl, "(Ljava/lang/String;)Z"),
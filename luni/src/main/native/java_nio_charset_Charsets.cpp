@@ -19,98 +19,24 @@
 #include "JNIHelp.h"
 #include "JniConstants.h"
 #include "ScopedPrimitiveArray.h"
+#include "Utf8.h"
 #include "jni.h"
 #include "unicode/utf16.h"
 
 #include <string.h>
 
-/**
- * Approximates java.lang.UnsafeByteSequence so we don't have to pay the cost of calling back into
- * Java when converting a char[] to a UTF-8 byte[]. This lets us have UTF-8 conversions slightly
- * faster than ICU for large char[]s without paying for the NIO overhead with small char[]s.
- *
- * We could avoid this by keeping the UTF-8 bytes on the native heap until we're done and only
- * creating a byte[] on the Java heap when we know how big it needs to be, but one shouldn't lie
- * to the garbage collector (nor hide potentially large allocations from it).
- *
- * Because a call to append might require an allocation, it might fail. Callers should always
- * check the return value of append.
- */
-class NativeUnsafeByteSequence {
-public:
-    NativeUnsafeByteSequence(JNIEnv* env)
-        : mEnv(env), mJavaArray(NULL), mRawArray(NULL), mSize(-1), mOffset(0)
-    {
-    }
-
-    ~NativeUnsafeByteSequence() {
-        // Release our pointer to the raw array, copying changes back to the Java heap.
-        if (mRawArray != NULL) {
-            mEnv->ReleaseByteArrayElements(mJavaArray, mRawArray, 0);
-        }
-    }
-
-    bool append(jbyte b) {
-        if (mOffset == mSize && !resize(mSize * 2)) {
-            return false;
-        }
-        mRawArray[mOffset++] = b;
-        return true;
-    }
-
-    bool resize(int newSize) {
-        if (newSize == mSize) {
-            return true;
-        }
-
-        // Allocate a new array.
-        jbyteArray newJavaArray = mEnv->NewByteArray(newSize);
-        if (newJavaArray == NULL) {
-            return false;
-        }
-        jbyte* newRawArray = mEnv->GetByteArrayElements(newJavaArray, NULL);
-        if (newRawArray == NULL) {
-            return false;
-        }
-
-        // Copy data out of the old array and then let go of it.
-        // Note that we may be trimming the array.
-        if (mRawArray != NULL) {
-            memcpy(newRawArray, mRawArray, mOffset);
-            mEnv->ReleaseByteArrayElements(mJavaArray, mRawArray, JNI_ABORT);
-        }
-
-        // Point ourselves at the new array.
-        mJavaArray = newJavaArray;
-        mRawArray = newRawArray;
-        mSize = newSize;
-        return true;
-    }
-
-    jbyteArray toByteArray() {
-        // Trim any unused space, if necessary.
-        bool okay = resize(mOffset);
-        return okay ? mJavaArray : NULL;
-    }
-
-private:
-    JNIEnv* mEnv;
-    jbyteArray mJavaArray;
-    jbyte* mRawArray;
-    jint mSize;
-    jint mOffset;
-
-    // Disallow copy and assignment.
-    NativeUnsafeByteSequence(const NativeUnsafeByteSequence&);
-    void operator=(const NativeUnsafeByteSequence&);
-};
-
 static void Charsets_asciiBytesToChars(JNIEnv* env, jclass, jbyteArray javaBytes, jint offset, jint length, jcharArray javaChars) {
-    ScopedByteArrayRO bytes(env, javaBytes);
+    // The second array's scoped constructor would throw from inside the first's critical
+    // region if it were null, so check it before entering either.
+    if (javaChars == NULL) {
+        jniThrowNullPointerException(env, NULL);
+        return;
+    }
+    ScopedByteArrayCriticalRO bytes(env, javaBytes);
     if (bytes.get() == NULL) {
         return;
     }
-    ScopedCharArrayRW chars(env, javaChars);
+    ScopedCharArrayCriticalRW chars(env, javaChars);
     if (chars.get() == NULL) {
         return;
     }
@@ -125,11 +51,17 @@ static void Charsets_asciiBytesToChars(JNIEnv* env, jclass, jbyteArray javaBytes
 }
 
 static void Charsets_isoLatin1BytesToChars(JNIEnv* env, jclass, jbyteArray javaBytes, jint offset, jint length, jcharArray javaChars) {
-    ScopedByteArrayRO bytes(env, javaBytes);
+    // The second array's scoped constructor would throw from inside the first's critical
+    // region if it were null, so check it before entering either.
+    if (javaChars == NULL) {
+        jniThrowNullPointerException(env, NULL);
+        return;
+    }
+    ScopedByteArrayCriticalRO bytes(env, javaBytes);
     if (bytes.get() == NULL) {
         return;
     }
-    ScopedCharArrayRW chars(env, javaChars);
+    ScopedCharArrayCriticalRW chars(env, javaChars);
     if (chars.get() == NULL) {
         return;
     }
@@ -141,19 +73,50 @@ static void Charsets_isoLatin1BytesToChars(JNIEnv* env, jclass, jbyteArray javaB
     }
 }
 
+/**
+ * Decodes UTF-8, replacing malformed input as String's Java decoder always has; see
+ * utf8ToUtf16. 'chars' must have room for 'length' chars, which is always enough. Returns the
+ * number of chars written.
+ */
+static jint Charsets_utf8BytesToChars(JNIEnv* env, jclass, jbyteArray javaBytes, jint offset, jint length, jcharArray javaChars) {
+    // The second array's scoped constructor would throw from inside the first's critical
+    // region if it were null, so check it before entering either.
+    if (javaChars == NULL) {
+        jniThrowNullPointerException(env, NULL);
+        return 0;
+    }
+    ScopedByteArrayCriticalRO bytes(env, javaBytes);
+    if (bytes.get() == NULL) {
+        return 0;
+    }
+    ScopedCharArrayCriticalRW chars(env, javaChars);
+    if (chars.get() == NULL) {
+        return 0;
+    }
+    return utf8ToUtf16(&bytes[offset], length, &chars[0]);
+}
+
 /**
  * Translates the given characters to US-ASCII or ISO-8859-1 bytes, using the fact that
  * Unicode code points between U+0000 and U+007f inclusive are identical to US-ASCII, while
  * U+0000 to U+00ff inclusive are identical to ISO-8859-1.
  */
 static jbyteArray charsToBytes(JNIEnv* env, jcharArray javaChars, jint offset, jint length, jchar maxValidChar) {
-    ScopedCharArrayRO chars(env, javaChars);
-    if (chars.get() == NULL) {
+    // Check and allocate first: nothing may throw or allocate once we're inside the critical
+    // regions.
+    if (javaChars == NULL) {
+        jniThrowNullPointerException(env, NULL);
         return NULL;
     }
-
     jbyteArray javaBytes = env->NewByteArray(length);
-    ScopedByteArrayRW bytes(env, javaBytes);
+    if (javaBytes == NULL) {
+        return NULL;
+    }
+    ScopedCharArrayCriticalRO chars(env, javaChars);
+    if (chars.get() == NULL) {
+        return NULL;
+    }
+    ScopedByteArrayCriticalRW bytes(env, javaBytes);
     if (bytes.get() == NULL) {
         return NULL;
     }
@@ -179,62 +142,103 @@ static jbyteArray Charsets_toIsoLatin1Bytes(JNIEnv* env, jclass, jcharArray java
     return charsToBytes(env, javaChars, offset, length, 0xff);
 }
 
+/**
+ * Returns the exact number of bytes Charsets_toUtf8Bytes will produce for 'chars'. An unpaired
+ * surrogate becomes a single '?'.
+ */
+static size_t utf8Length(const jchar* chars, size_t length) {
+    size_t result = 0;
+    size_t i = 0;
+    while (i < length) {
+        size_t asciiCount = asciiCharCount(chars + i, length - i);
+        result += asciiCount;
+        i += asciiCount;
+        for (; i < length && chars[i] >= 0x80; ++i) {
+            jchar ch = chars[i];
+            if (ch < 0x800) {
+                result += 2;
+            } else if (!U16_IS_SURROGATE(ch)) {
+                result += 3;
+            } else if (U16_IS_SURROGATE_LEAD(ch) && i + 1 < length
+                    && U16_IS_SURROGATE_TRAIL(chars[i + 1])) {
+                result += 4;
+                ++i;
+            } else {
+                result += 1;
+            }
+        }
+    }
+    return result;
+}
+
+/**
+ * Translates the given characters to UTF-8. We measure the output first so the byte[] is
+ * allocated at exactly the right size, and copy runs of ASCII, which is most text, a vector at
+ * a time. Both passes read the chars through a critical region, so a large array is never
+ * copied; the byte[] is allocated between them, since that can't happen inside one.
+ */
 static jbyteArray Charsets_toUtf8Bytes(JNIEnv* env, jclass, jcharArray javaChars, jint offset, jint length) {
-    ScopedCharArrayRO chars(env, javaChars);
-    if (chars.get() == NULL) {
+    size_t byteCount;
+    {
+        ScopedCharArrayCriticalRO chars(env, javaChars);
+        if (chars.get() == NULL) {
+            return NULL;
+        }
+        byteCount = utf8Length(&chars[offset], length);
+    }
+    jbyteArray javaBytes = env->NewByteArray(byteCount);
+    if (javaBytes == NULL) {
         return NULL;
     }
 
-    NativeUnsafeByteSequence out(env);
-    if (!out.resize(length)) {
+    ScopedCharArrayCriticalRO chars(env, javaChars);
+    if (chars.get() == NULL) {
         return NULL;
     }
+    const jchar* src = &chars[offset];
+    ScopedByteArrayCriticalRW bytes(env, javaBytes);
+    if (bytes.get() == NULL) {
+        return NULL;
+    }
+    jbyte* dst = &bytes[0];
 
-    const int end = offset + length;
-    for (int i = offset; i < end; ++i) {
-        jint ch = chars[i];
-        if (ch < 0x80) {
-            // One byte.
-            if (!out.append(ch)) {
-                return NULL;
-            }
-        } else if (ch < 0x800) {
-            // Two bytes.
-            if (!out.append((ch >> 6) | 0xc0) || !out.append((ch & 0x3f) | 0x80)) {
-                return NULL;
-            }
-        } else if (U16_IS_SURROGATE(ch)) {
-            // A supplementary character.
-            jchar high = (jchar) ch;
-            jchar low = (i + 1 != end) ? chars[i + 1] : 0;
-            if (!U16_IS_SURROGATE_LEAD(high) || !U16_IS_SURROGATE_TRAIL(low)) {
-                if (!out.append('?')) {
-                    return NULL;
+    const jchar* end = src + length;
+    while (src < end) {
+        size_t asciiCount = asciiCharCount(src, end - src);
+        narrowAsciiChars(src, dst, asciiCount);
+        src += asciiCount;
+        dst += asciiCount;
+        for (; src < end && *src >= 0x80; ++src) {
+            jint ch = *src;
+            if (ch < 0x800) {
+                // Two bytes.
+                *dst++ = (ch >> 6) | 0xc0;
+                *dst++ = (ch & 0x3f) | 0x80;
+            } else if (U16_IS_SURROGATE(ch)) {
+                // A supplementary character.
+                jchar high = (jchar) ch;
+                jchar low = (src + 1 != end) ? src[1] : 0;
+                if (!U16_IS_SURROGATE_LEAD(high) || !U16_IS_SURROGATE_TRAIL(low)) {
+                    *dst++ = '?';
+                    continue;
                 }
-                continue;
-            }
-            // Now we know we have a *valid* surrogate pair, we can consume the low surrogate.
-            ++i;
-            ch = U16_GET_SUPPLEMENTARY(high, low);
-            // Four bytes.
-            jbyte b1 = (ch >> 18) | 0xf0;
-            jbyte b2 = ((ch >> 12) & 0x3f) | 0x80;
-            jbyte b3 = ((ch >> 6) & 0x3f) | 0x80;
-            jbyte b4 = (ch & 0x3f) | 0x80;
-            if (!out.append(b1) || !out.append(b2) || !out.append(b3) || !out.append(b4)) {
-                return NULL;
-            }
-        } else {
-            // Three bytes.
-            jbyte b1 = (ch >> 12) | 0xe0;
-            jbyte b2 = ((ch >> 6) & 0x3f) | 0x80;
-            jbyte b3 = (ch & 0x3f) | 0x80;
-            if (!out.append(b1) || !out.append(b2) || !out.append(b3)) {
-                return NULL;
+                // Now we know we have a *valid* surrogate pair, we can consume the low surrogate.
+                ++src;
+                ch = U16_GET_SUPPLEMENTARY(high, low);
+                // Four bytes.
+                *dst++ = (ch >> 18) | 0xf0;
+                *dst++ = ((ch >> 12) & 0x3f) | 0x80;
+                *dst++ = ((ch >> 6) & 0x3f) | 0x80;
+                *dst++ = (ch & 0x3f) | 0x80;
+            } else {
+                // Three bytes.
+                *dst++ = (ch >> 12) | 0xe0;
+                *dst++ = ((ch >> 6) & 0x3f) | 0x80;
+                *dst++ = (ch & 0x3f) | 0x80;
             }
         }
     }
-    return out.toByteArray();
+    return javaBytes;
 }
 
 static JNINativeMethod gMethods[] = {
@@ -243,6 +247,7 @@ static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(Charsets, toAsciiBytes, "([CII)[B"),
     NATIVE_METHOD(Charsets, toIsoLatin1Bytes, "([CII)[B"),
     NATIVE_METHOD(Charsets, toUtf8Bytes, "([CII)[B"),
+    NATIVE_METHOD(Charsets, utf8BytesToChars, "([BII[C)I"),
 };
 void register_java_nio_charset_Charsets(JNIEnv* env) {
     jniRegisterNativeMethods(env, "java/nio/charset/Charsets", gMethods, NELEM(gMethods));
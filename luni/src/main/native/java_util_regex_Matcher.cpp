@@ -28,6 +28,8 @@
 #include "unicode/parseerr.h"
 #include "unicode/regex.h"
 
+#include <vector>
+
 // ICU documentation: http://icu-project.org/apiref/icu4c/classRegexMatcher.html
 
 static RegexMatcher* toRegexMatcher(jint addr) {
@@ -38,7 +40,8 @@ static RegexMatcher* toRegexMatcher(jint addr) {
  * We use ICU4C's RegexMatcher class, but our input is on the Java heap and potentially moving
  * around between calls. This wrapper class ensures that our RegexMatcher is always pointing at
  * the current location of the char[]. Earlier versions of Android simply copied the data to the
- * native heap, but that's wasteful and hides allocations from the garbage collector.
+ * native heap, but that's wasteful and hides allocations from the garbage collector. The UText
+ * itself lives in the accessor, so setting up for a call doesn't touch the native heap either.
  */
 class MatcherAccessor {
 public:
@@ -51,7 +54,8 @@ public:
             return;
         }
 
-        mUText = utext_openUChars(NULL, mChars, env->GetStringLength(mJavaInput), &mStatus);
+        mUText = utext_openUChars(&mUTextStorage, mChars, env->GetStringLength(mJavaInput),
+                &mStatus);
         if (mUText == NULL) {
             return;
         }
@@ -95,13 +99,23 @@ public:
         }
     }
 
+    // Appends the current match's group offsets to 'offsets', laid out as updateOffsets does.
+    void appendOffsets(std::vector<jint>& offsets) {
+        for (size_t i = 0, groupCount = mMatcher->groupCount(); i <= groupCount; ++i) {
+            offsets.push_back(mMatcher->start(i, mStatus));
+            offsets.push_back(mMatcher->end(i, mStatus));
+        }
+    }
+
 private:
     void init(JNIEnv* env, jint addr) {
+        static const UText EMPTY_UTEXT = UTEXT_INITIALIZER;
         mEnv = env;
         mJavaInput = NULL;
         mMatcher = toRegexMatcher(addr);
         mChars = NULL;
         mStatus = U_ZERO_ERROR;
+        mUTextStorage = EMPTY_UTEXT;
         mUText = NULL;
     }
 
@@ -110,6 +124,7 @@ private:
     RegexMatcher* mMatcher;
     const jchar* mChars;
     UErrorCode mStatus;
+    UText mUTextStorage;
     UText* mUText;
 
     // Disallow copy and assignment.
@@ -130,6 +145,25 @@ static jint Matcher_findImpl(JNIEnv* env, jclass, jint addr, jstring javaText, j
     return result;
 }
 
+static jintArray Matcher_findAllImpl(JNIEnv* env, jclass, jint addr, jstring javaText, jint limit) {
+    MatcherAccessor matcher(env, addr, javaText, false);
+    if (U_FAILURE(matcher.status())) {
+        return NULL;
+    }
+    std::vector<jint> offsets;
+    for (jint count = 0; count < limit && matcher->find(); ++count) {
+        matcher.appendOffsets(offsets);
+    }
+    if (U_FAILURE(matcher.status())) {
+        return NULL;
+    }
+    jintArray result = env->NewIntArray(offsets.size());
+    if (result != NULL && !offsets.empty()) {
+        env->SetIntArrayRegion(result, 0, offsets.size(), &offsets[0]);
+    }
+    return result;
+}
+
 static jint Matcher_findNextImpl(JNIEnv* env, jclass, jint addr, jstring javaText, jintArray offsets) {
     MatcherAccessor matcher(env, addr, javaText, false);
     if (matcher.status() != U_ZERO_ERROR) {
@@ -200,6 +234,7 @@ static void Matcher_useTransparentBoundsImpl(JNIEnv* env, jclass, jint addr, jbo
 
 static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(Matcher, closeImpl, "(I)V"),
+    NATIVE_METHOD(Matcher, findAllImpl, "(ILjava/lang/String;I)[I"),
     NATIVE_METHOD(Matcher, findImpl, "(ILjava/lang/String;I[I)Z"),
     NATIVE_METHOD(Matcher, findNextImpl, "(ILjava/lang/String;[I)Z"),
     NATIVE_METHOD(Matcher, groupCountImpl, "(I)I"),
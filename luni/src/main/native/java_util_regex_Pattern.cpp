@@ -16,16 +16,21 @@
 
 #define LOG_TAG "Pattern"
 
+#include <pthread.h>
 #include <stdlib.h>
 
 #include "ErrorCode.h"
 #include "JNIHelp.h"
 #include "JniConstants.h"
 #include "ScopedJavaUnicodeString.h"
+#include "ScopedPthreadMutexLock.h"
 #include "jni.h"
 #include "unicode/parseerr.h"
 #include "unicode/regex.h"
 
+#include <list>
+#include <map>
+
 // ICU documentation: http://icu-project.org/apiref/icu4c/classRegexPattern.html
 
 static RegexPattern* toRegexPattern(jint addr) {
@@ -41,8 +46,87 @@ static void throwPatternSyntaxException(JNIEnv* env, UErrorCode status, jstring
     env->Throw(reinterpret_cast<jthrowable>(exception));
 }
 
+/**
+ * A compiled pattern, shared by every Java Pattern with the same regular expression and flags.
+ * ICU lets any number of threads make matchers from one RegexPattern at once.
+ */
+struct CachedPattern {
+    UnicodeString regex;
+    jint flags;
+    RegexPattern* pattern;
+    // The number of Java Patterns using this one.
+    int refCount;
+    // False once it's been evicted; it's deleted when the last Java Pattern lets go.
+    bool cached;
+};
+
+typedef std::pair<UnicodeString, jint> PatternKey;
+
+// Legacy code compiles the same few constant regular expressions over and over, often via
+// String.split, replaceAll and matches. We keep the most recently used compiled patterns
+// around, even after their Java Patterns are gone, rather than compiling them again.
+static const size_t MAX_CACHED_PATTERNS = 32;
+static pthread_mutex_t gPatternCacheMutex = PTHREAD_MUTEX_INITIALIZER;
+// Cached patterns, most recently used first.
+static std::list<CachedPattern*> gPatternCache;
+// Each pattern in use or cached, by key and by address. Evicted patterns are only in the latter.
+static std::map<PatternKey, CachedPattern*> gPatternsByKey;
+static std::map<RegexPattern*, CachedPattern*> gPatternsByAddress;
+
+static void forgetPattern(CachedPattern* entry) {
+    gPatternsByAddress.erase(entry->pattern);
+    delete entry->pattern;
+    delete entry;
+}
+
+// Returns a new reference to the cached pattern for the key, or NULL. Call with the lock held.
+static RegexPattern* takeCachedPattern(const PatternKey& key) {
+    std::map<PatternKey, CachedPattern*>::iterator it = gPatternsByKey.find(key);
+    if (it == gPatternsByKey.end()) {
+        return NULL;
+    }
+    CachedPattern* entry = it->second;
+    gPatternCache.remove(entry);
+    gPatternCache.push_front(entry);
+    ++entry->refCount;
+    return entry->pattern;
+}
+
+// Adds a freshly compiled pattern with one reference. Call with the lock held.
+static void addCachedPattern(const PatternKey& key, RegexPattern* pattern) {
+    CachedPattern* entry = new CachedPattern;
+    entry->regex = key.first;
+    entry->flags = key.second;
+    entry->pattern = pattern;
+    entry->refCount = 1;
+    entry->cached = true;
+    gPatternsByKey[key] = entry;
+    gPatternsByAddress[pattern] = entry;
+    gPatternCache.push_front(entry);
+
+    while (gPatternCache.size() > MAX_CACHED_PATTERNS) {
+        CachedPattern* evicted = gPatternCache.back();
+        gPatternCache.pop_back();
+        gPatternsByKey.erase(PatternKey(evicted->regex, evicted->flags));
+        evicted->cached = false;
+        if (evicted->refCount == 0) {
+            forgetPattern(evicted);
+        }
+    }
+}
+
 static void Pattern_closeImpl(JNIEnv*, jclass, jint addr) {
-    delete toRegexPattern(addr);
+    RegexPattern* pattern = toRegexPattern(addr);
+    ScopedPthreadMutexLock lock(&gPatternCacheMutex);
+    std::map<RegexPattern*, CachedPattern*>::iterator it = gPatternsByAddress.find(pattern);
+    if (it == gPatternsByAddress.end()) {
+        // Compilation failed, so there's nothing to free.
+        return;
+    }
+    CachedPattern* entry = it->second;
+    if (--entry->refCount == 0 && !entry->cached) {
+        forgetPattern(entry);
+    }
 }
 
 static jint Pattern_compileImpl(JNIEnv* env, jclass, jstring javaRegex, jint flags) {
@@ -54,10 +138,32 @@ static jint Pattern_compileImpl(JNIEnv* env, jclass, jstring javaRegex, jint fla
 
     ScopedJavaUnicodeString regex(env, javaRegex);
     UnicodeString& regexString(regex.unicodeString());
+    // The key needs its own copy of the chars: the Java string's may move.
+    PatternKey key(UnicodeString(regexString.getBuffer(), regexString.length()), flags);
+    {
+        ScopedPthreadMutexLock lock(&gPatternCacheMutex);
+        RegexPattern* cached = takeCachedPattern(key);
+        if (cached != NULL) {
+            return static_cast<jint>(reinterpret_cast<uintptr_t>(cached));
+        }
+    }
+
+    // Compile without the lock, so one slow pattern doesn't hold up every other thread.
     RegexPattern* result = RegexPattern::compile(regexString, flags, error, status);
     if (!U_SUCCESS(status)) {
         throwPatternSyntaxException(env, status, javaRegex, error);
+        delete result;
+        return 0;
+    }
+
+    ScopedPthreadMutexLock lock(&gPatternCacheMutex);
+    RegexPattern* cached = takeCachedPattern(key);
+    if (cached != NULL) {
+        // Another thread compiled the same pattern while we were; use theirs.
+        delete result;
+        return static_cast<jint>(reinterpret_cast<uintptr_t>(cached));
     }
+    addCachedPattern(key, result);
     return static_cast<jint>(reinterpret_cast<uintptr_t>(result));
 }
 
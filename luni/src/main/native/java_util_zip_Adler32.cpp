@@ -23,22 +23,107 @@
 #include "jni.h"
 #include "zlib.h"
 
+#include <stdint.h>
+
+// As for CRC32, each Android ABI is built for a known instruction set, so whether we have a
+// vector kernel is decided at compile time.
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#define HAVE_SSSE3_ADLER32
+#endif
+
+#if defined(HAVE_SSSE3_ADLER32)
+static const uint32_t kAdlerBase = 65521; // The largest prime smaller than 65536.
+static const size_t kAdlerNmax = 5552; // The most bytes we can sum before s2 might overflow.
+static const size_t kAdlerBlock = 32;
+
+// Sums 32-byte blocks with SSSE3: psadbw accumulates the byte sum for s1, and pmaddubsw with
+// descending weights accumulates each byte's contribution to s2. Returns the updated checksum
+// and leaves any tail of fewer than 32 bytes for zlib.
+static uLong adler32Vector(uLong adler, const Bytef* buf, size_t* lenPtr) {
+    uint32_t s1 = adler & 0xffff;
+    uint32_t s2 = (adler >> 16) & 0xffff;
+    size_t blocks = *lenPtr / kAdlerBlock;
+    *lenPtr -= blocks * kAdlerBlock;
+
+    const __m128i tap1 = _mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25,
+            24, 23, 22, 21, 20, 19, 18, 17);
+    const __m128i tap2 = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+    while (blocks > 0) {
+        size_t n = kAdlerNmax / kAdlerBlock;
+        if (n > blocks) {
+            n = blocks;
+        }
+        blocks -= n;
+
+        // v_ps accumulates s1 as it stood before each block; every byte of every later block
+        // adds that to s2 once, which we apply with a shift by log2(kAdlerBlock) at the end.
+        __m128i v_ps = _mm_set_epi32(0, 0, 0, s1 * n);
+        __m128i v_s2 = _mm_set_epi32(0, 0, 0, s2);
+        __m128i v_s1 = _mm_setzero_si128();
+        do {
+            const __m128i bytes1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf));
+            const __m128i bytes2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 16));
+            v_ps = _mm_add_epi32(v_ps, v_s1);
+            v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes1, zero));
+            v_s2 = _mm_add_epi32(v_s2, _mm_madd_epi16(_mm_maddubs_epi16(bytes1, tap1), ones));
+            v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes2, zero));
+            v_s2 = _mm_add_epi32(v_s2, _mm_madd_epi16(_mm_maddubs_epi16(bytes2, tap2), ones));
+            buf += kAdlerBlock;
+        } while (--n > 0);
+        v_s2 = _mm_add_epi32(v_s2, _mm_slli_epi32(v_ps, 5));
+
+        // Sum the four 32-bit lanes of each accumulator.
+        v_s1 = _mm_add_epi32(v_s1, _mm_shuffle_epi32(v_s1, _MM_SHUFFLE(2, 3, 0, 1)));
+        v_s1 = _mm_add_epi32(v_s1, _mm_shuffle_epi32(v_s1, _MM_SHUFFLE(1, 0, 3, 2)));
+        s1 += _mm_cvtsi128_si32(v_s1);
+        v_s2 = _mm_add_epi32(v_s2, _mm_shuffle_epi32(v_s2, _MM_SHUFFLE(2, 3, 0, 1)));
+        v_s2 = _mm_add_epi32(v_s2, _mm_shuffle_epi32(v_s2, _MM_SHUFFLE(1, 0, 3, 2)));
+        s2 = _mm_cvtsi128_si32(v_s2);
+
+        s1 %= kAdlerBase;
+        s2 %= kAdlerBase;
+    }
+    return s1 | (s2 << 16);
+}
+#endif
+
+// Our equivalent of zlib's adler32, using a vector kernel where we have one.
+static uLong adler32Update(uLong adler, const Bytef* buf, size_t len) {
+#if defined(HAVE_SSSE3_ADLER32)
+    if (len >= 64) {
+        size_t remaining = len;
+        adler = adler32Vector(adler, buf, &remaining);
+        buf += len - remaining;
+        len = remaining;
+    }
+#endif
+    return adler32(adler, buf, len);
+}
+
 static jlong Adler32_updateImpl(JNIEnv* env, jobject, jbyteArray byteArray, int off, int len, jlong crc) {
-    ScopedByteArrayRO bytes(env, byteArray);
+    ScopedByteArrayCriticalRO bytes(env, byteArray);
     if (bytes.get() == NULL) {
         return 0;
     }
-    return adler32(crc, reinterpret_cast<const Bytef*>(bytes.get() + off), len);
+    return adler32Update(crc, reinterpret_cast<const Bytef*>(bytes.get() + off), len);
+}
+
+static jlong Adler32_updateDirectImpl(JNIEnv*, jclass, jint address, jint len, jlong adler) {
+    const Bytef* buf = reinterpret_cast<const Bytef*>(static_cast<uintptr_t>(address));
+    return adler32Update(adler, buf, len);
 }
 
-static jlong Adler32_updateByteImpl(JNIEnv*, jobject, jint val, jlong crc) {
-    Bytef bytefVal = val;
-    return adler32(crc, reinterpret_cast<const Bytef*>(&bytefVal), 1);
+static jlong Adler32_combine(JNIEnv*, jclass, jlong adler1, jlong adler2, jlong len2) {
+    return adler32_combine(adler1, adler2, len2);
 }
 
 static JNINativeMethod gMethods[] = {
+    NATIVE_METHOD(Adler32, combine, "(JJJ)J"),
     NATIVE_METHOD(Adler32, updateImpl, "([BIIJ)J"),
-    NATIVE_METHOD(Adler32, updateByteImpl, "(IJ)J"),
+    NATIVE_METHOD(Adler32, updateDirectImpl, "(IIJ)J"),
 };
 void register_java_util_zip_Adler32(JNIEnv* env) {
     jniRegisterNativeMethods(env, "java/util/zip/Adler32", gMethods, NELEM(gMethods));
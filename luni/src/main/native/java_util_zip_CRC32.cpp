@@ -23,22 +23,151 @@
 #include "jni.h"
 #include "zlib.h"
 
+#include <stdint.h>
+
+// zlib's crc32 is table-driven. Where the target has carry-less multiply (x86 PCLMULQDQ) or
+// the ARMv8 CRC32 instructions, we use those instead. Each Android ABI is built for a known
+// instruction set, so the choice is made at compile time.
+#if defined(__PCLMUL__) && defined(__SSE4_1__)
+#include <smmintrin.h>
+#include <wmmintrin.h>
+#define HAVE_PCLMUL_CRC32
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define HAVE_ARM_CRC32
+#endif
+
+#if defined(HAVE_PCLMUL_CRC32)
+// Folds 64-byte blocks four lanes at a time, then reduces to 32 bits with a Barrett reduction,
+// following Intel's "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction".
+// The constants are for zlib's bit-reflected polynomial 0xedb88320. 'len' must be a multiple
+// of 16, and at least 64. 'crc' is the pre-inverted running value, as zlib keeps internally.
+static uint32_t crc32Fold(const unsigned char* buf, size_t len, uint32_t crc) {
+#define ALIGN16 __attribute__((aligned(16)))
+    static const uint64_t k1k2[] ALIGN16 = { 0x0154442bd4ULL, 0x01c6e41596ULL };
+    static const uint64_t k3k4[] ALIGN16 = { 0x01751997d0ULL, 0x00ccaa009eULL };
+    static const uint64_t k5k0[] ALIGN16 = { 0x0163cd6124ULL, 0x0000000000ULL };
+    static const uint64_t poly[] ALIGN16 = { 0x01db710641ULL, 0x01f7011641ULL };
+#undef ALIGN16
+
+    __m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x00));
+    __m128i x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x10));
+    __m128i x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x20));
+    __m128i x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(crc));
+    __m128i x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k1k2));
+    buf += 64;
+    len -= 64;
+
+    // Fold 64 bytes at a time in four independent lanes.
+    while (len >= 64) {
+        __m128i x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        __m128i x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        __m128i x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+        __m128i x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x00)));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x10)));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x20)));
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x30)));
+        buf += 64;
+        len -= 64;
+    }
+
+    // Fold the four lanes into one.
+    x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k3k4));
+    __m128i lanes[3] = { x2, x3, x4 };
+    for (int i = 0; i < 3; ++i) {
+        __m128i x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, lanes[i]), x5);
+    }
+
+    // Fold in any remaining 16-byte blocks.
+    while (len >= 16) {
+        __m128i x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf));
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+        buf += 16;
+        len -= 16;
+    }
+
+    // Fold 128 bits down to 64.
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+    x0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(k5k0));
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, x3);
+    x1 = _mm_xor_si128(_mm_clmulepi64_si128(x1, x0, 0x00), x2);
+
+    // Barrett-reduce to 32 bits.
+    x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(poly));
+    x2 = _mm_and_si128(x1, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2 = _mm_and_si128(x2, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    return _mm_extract_epi32(x1, 1);
+}
+#endif
+
+// Our equivalent of zlib's crc32, using a hardware kernel where we have one.
+static uLong crc32Update(uLong crc, const Bytef* buf, size_t len) {
+#if defined(HAVE_PCLMUL_CRC32)
+    // Below a few blocks, the setup costs more than the table lookups.
+    if (len >= 64) {
+        size_t chunk = len & ~static_cast<size_t>(15);
+        crc = ~crc32Fold(buf, chunk, ~static_cast<uint32_t>(crc));
+        buf += chunk;
+        len -= chunk;
+    }
+#elif defined(HAVE_ARM_CRC32)
+    uint32_t c = ~static_cast<uint32_t>(crc);
+    for (; len > 0 && (reinterpret_cast<uintptr_t>(buf) & 3) != 0; --len) {
+        c = __crc32b(c, *buf++);
+    }
+    for (; len >= 4; len -= 4, buf += 4) {
+        c = __crc32w(c, *reinterpret_cast<const uint32_t*>(buf));
+    }
+    for (; len > 0; --len) {
+        c = __crc32b(c, *buf++);
+    }
+    return ~c;
+#endif
+    return crc32(crc, buf, len);
+}
+
 static jlong CRC32_updateImpl(JNIEnv* env, jobject, jbyteArray byteArray, int off, int len, jlong crc) {
-    ScopedByteArrayRO bytes(env, byteArray);
+    ScopedByteArrayCriticalRO bytes(env, byteArray);
     if (bytes.get() == NULL) {
         return 0;
     }
-    jlong result = crc32(crc, reinterpret_cast<const Bytef*>(bytes.get() + off), len);
+    jlong result = crc32Update(crc, reinterpret_cast<const Bytef*>(bytes.get() + off), len);
     return result;
 }
 
-static jlong CRC32_updateByteImpl(JNIEnv*, jobject, jbyte val, jlong crc) {
-    return crc32(crc, reinterpret_cast<const Bytef*>(&val), 1);
+static jlong CRC32_updateDirectImpl(JNIEnv*, jclass, jint address, jint len, jlong crc) {
+    const Bytef* buf = reinterpret_cast<const Bytef*>(static_cast<uintptr_t>(address));
+    return crc32Update(crc, buf, len);
+}
+
+static jlong CRC32_combine(JNIEnv*, jclass, jlong crc1, jlong crc2, jlong len2) {
+    return crc32_combine(crc1, crc2, len2);
 }
 
 static JNINativeMethod gMethods[] = {
+    NATIVE_METHOD(CRC32, combine, "(JJJ)J"),
     NATIVE_METHOD(CRC32, updateImpl, "([BIIJ)J"),
-    NATIVE_METHOD(CRC32, updateByteImpl, "(BJ)J"),
+    NATIVE_METHOD(CRC32, updateDirectImpl, "(IIJ)J"),
 };
 void register_java_util_zip_CRC32(JNIEnv* env) {
     jniRegisterNativeMethods(env, "java/util/zip/CRC32", gMethods, NELEM(gMethods));
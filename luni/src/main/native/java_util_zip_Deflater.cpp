@@ -21,6 +21,8 @@
 #include "ScopedPrimitiveArray.h"
 #include "zip.h"
 
+#include <string.h>
+
 static struct {
     jfieldID inRead;
     jfieldID finished;
@@ -42,14 +44,10 @@ static jint Deflater_getAdlerImpl(JNIEnv*, jobject, jlong handle) {
     return toNativeZipStream(handle)->stream.adler;
 }
 
+static ZipStreamPool gStreamPool(deflateEnd, 4, 8);
+
 /* Create a new stream . This stream cannot be used until it has been properly initialized. */
 static jlong Deflater_createStream(JNIEnv * env, jobject, jint level, jint strategy, jboolean noHeader) {
-    UniquePtr<NativeZipStream> jstream(new NativeZipStream);
-    if (jstream.get() == NULL) {
-        jniThrowOutOfMemoryError(env, NULL);
-        return -1;
-    }
-
     int wbits = 12; // Was 15, made it 12 to reduce memory consumption. Use MAX for fastest.
     int mlevel = 5; // Was 9, made it 5 to reduce memory consumption. Might result
                   // in out-of-memory problems according to some web pages. The
@@ -60,6 +58,18 @@ static jlong Deflater_createStream(JNIEnv * env, jobject, jint level, jint strat
     if (noHeader) {
         wbits = wbits / -1;
     }
+    ZipStreamKey key(level, strategy, wbits);
+    NativeZipStream* pooled = gStreamPool.take(key);
+    if (pooled != NULL) {
+        return reinterpret_cast<uintptr_t>(pooled);
+    }
+
+    UniquePtr<NativeZipStream> jstream(new NativeZipStream);
+    if (jstream.get() == NULL) {
+        jniThrowOutOfMemoryError(env, NULL);
+        return -1;
+    }
+    jstream->key = key;
     int err = deflateInit2(&jstream->stream, level, Z_DEFLATED, wbits, mlevel, strategy);
     if (err != Z_OK) {
         throwExceptionForZlibError(env, "java/lang/IllegalArgumentException", err);
@@ -80,12 +90,17 @@ static jint Deflater_deflateImpl(JNIEnv* env, jobject recv, jbyteArray buf, int
     stream->stream.avail_out = len;
     jint sin = stream->stream.total_in;
     jint sout = stream->stream.total_out;
-    ScopedByteArrayRW out(env, buf);
-    if (out.get() == NULL) {
-        return -1;
+    int err;
+    {
+        // deflate only reads our copy of the input and writes 'buf', so it can run in a
+        // critical region.
+        ScopedByteArrayCriticalRW out(env, buf);
+        if (out.get() == NULL) {
+            return -1;
+        }
+        stream->stream.next_out = reinterpret_cast<Bytef*>(out.get() + off);
+        err = deflate(&stream->stream, flushParm);
     }
-    stream->stream.next_out = reinterpret_cast<Bytef*>(out.get() + off);
-    int err = deflate(&stream->stream, flushParm);
     if (err != Z_OK) {
         if (err == Z_MEM_ERROR) {
             jniThrowOutOfMemoryError(env, NULL);
@@ -103,10 +118,107 @@ static jint Deflater_deflateImpl(JNIEnv* env, jobject recv, jbyteArray buf, int
     return stream->stream.total_out - sout;
 }
 
+/*
+ * Compresses one block of a stream being deflated in parallel, on a z_stream of its own, and
+ * returns the raw deflate data. 'dict' is the tail of the previous block's input, so matches can
+ * still reach back across the block boundary. All but the last block end with a sync flush, which
+ * leaves the output byte-aligned and not final, so the blocks can just be concatenated.
+ */
+static jbyteArray Deflater_deflateBlockImpl(JNIEnv* env, jclass, jbyteArray javaInput, jint off,
+        jint len, jbyteArray javaDictionary, jint dictOff, jint dictLen, jint level,
+        jint strategy, jboolean last) {
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    int err = deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, 8, strategy);
+    if (err != Z_OK) {
+        throwExceptionForZlibError(env, "java/lang/IllegalArgumentException", err);
+        return NULL;
+    }
+
+    if (javaDictionary != NULL && dictLen > 0) {
+        ScopedByteArrayCriticalRO dictionary(env, javaDictionary);
+        if (dictionary.get() == NULL) {
+            deflateEnd(&stream);
+            return NULL;
+        }
+        deflateSetDictionary(&stream, reinterpret_cast<const Bytef*>(dictionary.get() + dictOff),
+                dictLen);
+    }
+
+    // deflateBound covers a single Z_FINISH; a sync flush adds at most an empty stored block.
+    size_t capacity = deflateBound(&stream, len) + 16;
+    UniquePtr<Bytef[]> output(new Bytef[capacity]);
+    {
+        ScopedByteArrayCriticalRO input(env, javaInput);
+        if (input.get() == NULL) {
+            deflateEnd(&stream);
+            return NULL;
+        }
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<jbyte*>(input.get() + off));
+        stream.avail_in = len;
+        stream.next_out = &output[0];
+        stream.avail_out = capacity;
+        err = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+    }
+    size_t produced = capacity - stream.avail_out;
+    bool complete = last ? (err == Z_STREAM_END) : (err == Z_OK && stream.avail_in == 0);
+    deflateEnd(&stream);
+    if (!complete) {
+        throwExceptionForZlibError(env, "java/lang/IllegalStateException",
+                err == Z_STREAM_END || err == Z_OK ? Z_BUF_ERROR : err);
+        return NULL;
+    }
+
+    jbyteArray result = env->NewByteArray(produced);
+    if (result != NULL) {
+        env->SetByteArrayRegion(result, 0, produced, reinterpret_cast<const jbyte*>(&output[0]));
+    }
+    return result;
+}
+
+// Like deflateImpl, but reading from and writing to native memory, such as a pair of direct
+// buffers. The stream doesn't keep a pointer to the input once we return; whatever is left of it
+// stays with the caller.
+static jint Deflater_deflateDirectImpl(JNIEnv* env, jobject recv, jint inAddress, jint inLength,
+        jint outAddress, jint outLength, jlong handle, jint flushParm) {
+    NativeZipStream* stream = toNativeZipStream(handle);
+    stream->stream.next_in = reinterpret_cast<Bytef*>(static_cast<uintptr_t>(inAddress));
+    stream->stream.avail_in = inLength;
+    stream->stream.next_out = reinterpret_cast<Bytef*>(static_cast<uintptr_t>(outAddress));
+    stream->stream.avail_out = outLength;
+
+    int err = deflate(&stream->stream, flushParm);
+    jint bytesRead = inLength - stream->stream.avail_in;
+    jint bytesWritten = outLength - stream->stream.avail_out;
+    stream->stream.next_in = NULL;
+    stream->stream.avail_in = 0;
+    if (err == Z_MEM_ERROR) {
+        jniThrowOutOfMemoryError(env, NULL);
+        return 0;
+    }
+    if (err == Z_STREAM_END) {
+        env->SetBooleanField(recv, gCachedFields.finished, JNI_TRUE);
+    }
+    env->SetIntField(recv, gCachedFields.inRead, bytesRead);
+    return bytesWritten;
+}
+
 static void Deflater_endImpl(JNIEnv*, jobject, jlong handle) {
     NativeZipStream* stream = toNativeZipStream(handle);
-    deflateEnd(&stream->stream);
-    delete stream;
+    stream->recycle();
+    if (deflateReset(&stream->stream) == Z_OK) {
+        gStreamPool.put(stream);
+    } else {
+        gStreamPool.destroy(stream);
+    }
+}
+
+static void Deflater_setStreamPoolLimits(JNIEnv* env, jclass, jint maxPerKey, jint maxTotal) {
+    setZipStreamPoolLimits(env, gStreamPool, maxPerKey, maxTotal);
+}
+
+static jlongArray Deflater_getStreamPoolStats(JNIEnv* env, jclass) {
+    return gStreamPool.getStats(env);
 }
 
 static void Deflater_resetImpl(JNIEnv* env, jobject, jlong handle) {
@@ -128,20 +240,28 @@ static void Deflater_setLevelsImpl(JNIEnv* env, jobject, int level, int strategy
     int err = deflateParams(&stream->stream, level, strategy);
     if (err != Z_OK) {
         throwExceptionForZlibError(env, "java/lang/IllegalStateException", err);
+        return;
     }
+    // deflateReset keeps the new parameters, so this is what the stream will be pooled under.
+    stream->key.level = level;
+    stream->key.strategy = strategy;
 }
 
 static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(Deflater, createStream, "(IIZ)J"),
+    NATIVE_METHOD(Deflater, deflateBlockImpl, "([BII[BIIIIZ)[B"),
+    NATIVE_METHOD(Deflater, deflateDirectImpl, "(IIIIJI)I"),
     NATIVE_METHOD(Deflater, deflateImpl, "([BIIJI)I"),
     NATIVE_METHOD(Deflater, endImpl, "(J)V"),
     NATIVE_METHOD(Deflater, getAdlerImpl, "(J)I"),
+    NATIVE_METHOD(Deflater, getStreamPoolStats, "()[J"),
     NATIVE_METHOD(Deflater, getTotalInImpl, "(J)J"),
     NATIVE_METHOD(Deflater, getTotalOutImpl, "(J)J"),
     NATIVE_METHOD(Deflater, resetImpl, "(J)V"),
     NATIVE_METHOD(Deflater, setDictionaryImpl, "([BIIJ)V"),
     NATIVE_METHOD(Deflater, setInputImpl, "([BIIJ)V"),
     NATIVE_METHOD(Deflater, setLevelsImpl, "(IIJ)V"),
+    NATIVE_METHOD(Deflater, setStreamPoolLimits, "(II)V"),
 };
 void register_java_util_zip_Deflater(JNIEnv* env) {
     gCachedFields.finished = env->GetFieldID(JniConstants::deflaterClass, "finished", "Z");
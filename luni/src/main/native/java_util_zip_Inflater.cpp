@@ -21,6 +21,8 @@
 #include "ScopedPrimitiveArray.h"
 #include "zip.h"
 #include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 static struct {
     jfieldID inRead;
@@ -28,15 +30,10 @@ static struct {
     jfieldID needsDictionary;
 } gCachedFields;
 
+static ZipStreamPool gStreamPool(inflateEnd, 4, 8);
+
 /* Create a new stream . This stream cannot be used until it has been properly initialized. */
 static jlong Inflater_createStream(JNIEnv* env, jobject, jboolean noHeader) {
-    UniquePtr<NativeZipStream> jstream(new NativeZipStream);
-    if (jstream.get() == NULL) {
-        jniThrowOutOfMemoryError(env, NULL);
-        return -1;
-    }
-    jstream->stream.adler = 1;
-
     /*
      * In the range 8..15 for checked, or -8..-15 for unchecked inflate. Unchecked
      * is appropriate for formats like zip that do their own validity checking.
@@ -46,6 +43,21 @@ static jlong Inflater_createStream(JNIEnv* env, jobject, jboolean noHeader) {
     if (noHeader) {
         wbits = wbits / -1;
     }
+    ZipStreamKey key(0, 0, wbits);
+    NativeZipStream* pooled = gStreamPool.take(key);
+    if (pooled != NULL) {
+        pooled->stream.adler = 1;
+        return reinterpret_cast<uintptr_t>(pooled);
+    }
+
+    UniquePtr<NativeZipStream> jstream(new NativeZipStream);
+    if (jstream.get() == NULL) {
+        jniThrowOutOfMemoryError(env, NULL);
+        return -1;
+    }
+    jstream->stream.adler = 1;
+    jstream->key = key;
+
     int err = inflateInit2(&jstream->stream, wbits);
     if (err != Z_OK) {
         throwExceptionForZlibError(env, "java/lang/IllegalArgumentException", err);
@@ -60,14 +72,12 @@ static void Inflater_setInputImpl(JNIEnv* env, jobject, jbyteArray buf, jint off
 
 static jint Inflater_setFileInputImpl(JNIEnv* env, jobject, jobject javaFileDescriptor, jlong off, jint len, jlong handle) {
     NativeZipStream* stream = toNativeZipStream(handle);
+    stream->unmapInput();
 
-    // We reuse the existing native buffer if it's large enough.
-    // TODO: benchmark.
-    if (stream->inCap < len) {
-        stream->setInput(env, NULL, 0, len);
-    } else {
-        stream->stream.next_in = reinterpret_cast<Bytef*>(&stream->input[0]);
-        stream->stream.avail_in = len;
+    // setInput reuses the existing native buffer if it's large enough.
+    stream->setInput(env, NULL, 0, len);
+    if (env->ExceptionCheck()) {
+        return 0;
     }
 
     // As an Android-specific optimization, we read directly onto the native heap.
@@ -94,19 +104,90 @@ static jint Inflater_setFileInputImpl(JNIEnv* env, jobject, jobject javaFileDesc
     return totalByteCount;
 }
 
-static jint Inflater_inflateImpl(JNIEnv* env, jobject recv, jbyteArray buf, int off, int len, jlong handle) {
+// Points the stream straight at a read-only mapping of the start of the file region, so the
+// compressed bytes needn't be copied into our own buffer first. At most MAPPED_INPUT_WINDOW
+// bytes are mapped at once, so a big entry never needs much address space (which matters on
+// 32-bit devices) and each window's size check is recent; InflaterInputStream comes back for the
+// rest. If the region can't be mapped, falls back to reading (part of) it instead. Returns the
+// number of bytes made available. The mapping lasts until the next input is set, or the stream
+// is reset or ended.
+static const jint MAPPED_INPUT_WINDOW = 256 * 1024;
+static const jint MAPPED_INPUT_FALLBACK_READ = 64 * 1024;
+
+static jint Inflater_setFileMappedInputImpl(JNIEnv* env, jobject recv, jobject javaFileDescriptor,
+        jlong off, jint len, jlong handle) {
     NativeZipStream* stream = toNativeZipStream(handle);
-    ScopedByteArrayRW out(env, buf);
-    if (out.get() == NULL) {
-        return -1;
+    stream->unmapInput();
+    if (len > MAPPED_INPUT_WINDOW) {
+        len = MAPPED_INPUT_WINDOW;
     }
-    stream->stream.next_out = reinterpret_cast<Bytef*>(out.get() + off);
-    stream->stream.avail_out = len;
 
-    Bytef* initialNextIn = stream->stream.next_in;
-    Bytef* initialNextOut = stream->stream.next_out;
+    int fd = jniGetFDFromFileDescriptor(env, javaFileDescriptor);
+    // Touching a mapped page past the end of the file raises SIGBUS, so make sure the whole
+    // window is really there. (An archive truncated while we're inflating it can still do
+    // that, but no more than one window's worth of mapping is ever at risk.)
+    struct stat sb;
+    if (fstat(fd, &sb) == -1) {
+        jniThrowIOException(env, errno);
+        return 0;
+    }
+    if (off < 0 || len < 0 || off + len > sb.st_size) {
+        jniThrowIOException(env, EINVAL);
+        return 0;
+    }
+    if (len == 0) {
+        stream->stream.avail_in = 0;
+        return 0;
+    }
 
+    static const long pageSize = sysconf(_SC_PAGESIZE);
+    off_t alignedOffset = off & ~static_cast<jlong>(pageSize - 1);
+    size_t slack = off - alignedOffset;
+    void* mapping = mmap(NULL, slack + len, PROT_READ, MAP_SHARED, fd, alignedOffset);
+    if (mapping == MAP_FAILED) {
+        // Out of address space, or a file system that can't map: read it like a small entry.
+        jint readLength = (len < MAPPED_INPUT_FALLBACK_READ) ? len : MAPPED_INPUT_FALLBACK_READ;
+        return Inflater_setFileInputImpl(env, recv, javaFileDescriptor, off, readLength, handle);
+    }
+    madvise(mapping, slack + len, MADV_SEQUENTIAL);
+    stream->mappedInput = mapping;
+    stream->mappedInputLength = slack + len;
+    stream->stream.next_in = reinterpret_cast<Bytef*>(mapping) + slack;
+    stream->stream.avail_in = len;
+    return len;
+}
+
+// Inflates from the stream's current input into 'out', setting 'bytesWritten'.
+static int inflateInto(NativeZipStream* stream, jbyte* out, int len, jint& bytesWritten) {
+    stream->stream.next_out = reinterpret_cast<Bytef*>(out);
+    stream->stream.avail_out = len;
     int err = inflate(&stream->stream, Z_SYNC_FLUSH);
+    bytesWritten = len - stream->stream.avail_out;
+    return err;
+}
+
+static jint Inflater_inflateImpl(JNIEnv* env, jobject recv, jbyteArray buf, int off, int len, jlong handle) {
+    NativeZipStream* stream = toNativeZipStream(handle);
+    Bytef* initialNextIn = stream->stream.next_in;
+    jint bytesWritten;
+    int err;
+    if (stream->mappedInput != NULL) {
+        // Reading mapped input can fault in pages from disk, which could hold up the GC for as
+        // long as the I/O takes if we were inside a critical region, so use ordinary access.
+        ScopedByteArrayRW out(env, buf);
+        if (out.get() == NULL) {
+            return -1;
+        }
+        err = inflateInto(stream, out.get() + off, len, bytesWritten);
+    } else {
+        // With input in our own buffer, inflate makes no JNI calls and doesn't block, so it can
+        // run inside the region.
+        ScopedByteArrayCriticalRW out(env, buf);
+        if (out.get() == NULL) {
+            return -1;
+        }
+        err = inflateInto(stream, out.get() + off, len, bytesWritten);
+    }
     if (err != Z_OK) {
         if (err == Z_STREAM_ERROR) {
             return 0;
@@ -122,7 +203,6 @@ static jint Inflater_inflateImpl(JNIEnv* env, jobject recv, jbyteArray buf, int
     }
 
     jint bytesRead = stream->stream.next_in - initialNextIn;
-    jint bytesWritten = stream->stream.next_out - initialNextOut;
 
     jint inReadValue = env->GetIntField(recv, gCachedFields.inRead);
     inReadValue += bytesRead;
@@ -130,14 +210,60 @@ static jint Inflater_inflateImpl(JNIEnv* env, jobject recv, jbyteArray buf, int
     return bytesWritten;
 }
 
+// Like inflateImpl, but reading from and writing to native memory, such as a pair of direct
+// buffers. The stream doesn't keep a pointer to the input once we return; whatever is left of it
+// stays with the caller.
+static jint Inflater_inflateDirectImpl(JNIEnv* env, jobject recv, jint inAddress, jint inLength,
+        jint outAddress, jint outLength, jlong handle) {
+    NativeZipStream* stream = toNativeZipStream(handle);
+    stream->unmapInput();
+    stream->stream.next_in = reinterpret_cast<Bytef*>(static_cast<uintptr_t>(inAddress));
+    stream->stream.avail_in = inLength;
+    stream->stream.next_out = reinterpret_cast<Bytef*>(static_cast<uintptr_t>(outAddress));
+    stream->stream.avail_out = outLength;
+
+    int err = inflate(&stream->stream, Z_SYNC_FLUSH);
+    jint bytesRead = inLength - stream->stream.avail_in;
+    jint bytesWritten = outLength - stream->stream.avail_out;
+    stream->stream.next_in = NULL;
+    stream->stream.avail_in = 0;
+    if (err != Z_OK) {
+        if (err == Z_STREAM_ERROR) {
+            return 0;
+        }
+        if (err == Z_STREAM_END) {
+            env->SetBooleanField(recv, gCachedFields.finished, JNI_TRUE);
+        } else if (err == Z_NEED_DICT) {
+            env->SetBooleanField(recv, gCachedFields.needsDictionary, JNI_TRUE);
+        } else if (err != Z_BUF_ERROR) {
+            throwExceptionForZlibError(env, "java/util/zip/DataFormatException", err);
+            return -1;
+        }
+    }
+    env->SetIntField(recv, gCachedFields.inRead, bytesRead);
+    return bytesWritten;
+}
+
 static jint Inflater_getAdlerImpl(JNIEnv*, jobject, jlong handle) {
     return toNativeZipStream(handle)->stream.adler;
 }
 
 static void Inflater_endImpl(JNIEnv*, jobject, jlong handle) {
     NativeZipStream* stream = toNativeZipStream(handle);
-    inflateEnd(&stream->stream);
-    delete stream;
+    stream->recycle();
+    if (inflateReset(&stream->stream) == Z_OK) {
+        gStreamPool.put(stream);
+    } else {
+        gStreamPool.destroy(stream);
+    }
+}
+
+static void Inflater_setStreamPoolLimits(JNIEnv* env, jclass, jint maxPerKey, jint maxTotal) {
+    setZipStreamPoolLimits(env, gStreamPool, maxPerKey, maxTotal);
+}
+
+static jlongArray Inflater_getStreamPoolStats(JNIEnv* env, jclass) {
+    return gStreamPool.getStats(env);
 }
 
 static void Inflater_setDictionaryImpl(JNIEnv* env, jobject, jbyteArray dict, int off, int len, jlong handle) {
@@ -145,7 +271,9 @@ static void Inflater_setDictionaryImpl(JNIEnv* env, jobject, jbyteArray dict, in
 }
 
 static void Inflater_resetImpl(JNIEnv* env, jobject, jlong handle) {
-    int err = inflateReset(&toNativeZipStream(handle)->stream);
+    NativeZipStream* stream = toNativeZipStream(handle);
+    stream->unmapInput();
+    int err = inflateReset(&stream->stream);
     if (err != Z_OK) {
         throwExceptionForZlibError(env, "java/lang/IllegalArgumentException", err);
     }
@@ -163,13 +291,17 @@ static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(Inflater, createStream, "(Z)J"),
     NATIVE_METHOD(Inflater, endImpl, "(J)V"),
     NATIVE_METHOD(Inflater, getAdlerImpl, "(J)I"),
+    NATIVE_METHOD(Inflater, getStreamPoolStats, "()[J"),
     NATIVE_METHOD(Inflater, getTotalInImpl, "(J)J"),
     NATIVE_METHOD(Inflater, getTotalOutImpl, "(J)J"),
+    NATIVE_METHOD(Inflater, inflateDirectImpl, "(IIIIJ)I"),
     NATIVE_METHOD(Inflater, inflateImpl, "([BIIJ)I"),
     NATIVE_METHOD(Inflater, resetImpl, "(J)V"),
     NATIVE_METHOD(Inflater, setDictionaryImpl, "([BIIJ)V"),
     NATIVE_METHOD(Inflater, setFileInputImpl, "(Ljava/io/FileDescriptor;JIJ)I"),
+    NATIVE_METHOD(Inflater, setFileMappedInputImpl, "(Ljava/io/FileDescriptor;JIJ)I"),
     NATIVE_METHOD(Inflater, setInputImpl, "([BIIJ)V"),
+    NATIVE_METHOD(Inflater, setStreamPoolLimits, "(II)V"),
 };
 void register_java_util_zip_Inflater(JNIEnv* env) {
     gCachedFields.finished = env->GetFieldID(JniConstants::inflaterClass, "finished", "Z");
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "DirectoryStream"
+
+#include "JNIHelp.h"
+#include "JniConstants.h"
+#include "ScopedLocalRef.h"
+#include "ScopedPrimitiveArray.h"
+#include "ScopedUtfChars.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+// Must match DirectoryStream.DT_*. These are the Linux values, but we don't want to depend on that.
+static jint translateType(unsigned char type) {
+    switch (type) {
+    case DT_FIFO: return 1;
+    case DT_CHR: return 2;
+    case DT_DIR: return 4;
+    case DT_BLK: return 6;
+    case DT_REG: return 8;
+    case DT_LNK: return 10;
+    case DT_SOCK: return 12;
+    default: return 0;
+    }
+}
+
+static DIR* toDir(jint handle) {
+    return reinterpret_cast<DIR*>(static_cast<uintptr_t>(handle));
+}
+
+static jint DirectoryStream_openImpl(JNIEnv* env, jclass, jstring javaPath) {
+    ScopedUtfChars path(env, javaPath);
+    if (path.c_str() == NULL) {
+        return 0;
+    }
+    DIR* dir = opendir(path.c_str());
+    if (dir == NULL) {
+        jniThrowIOException(env, errno);
+        return 0;
+    }
+    return static_cast<jint>(reinterpret_cast<uintptr_t>(dir));
+}
+
+static jint DirectoryStream_readImpl(JNIEnv* env, jclass, jint handle,
+        jobjectArray javaNames, jintArray javaTypes, jlongArray javaInodes) {
+    DIR* dir = toDir(handle);
+    ScopedIntArrayRW types(env, javaTypes);
+    if (types.get() == NULL) {
+        return -1;
+    }
+    jlong* inodes = NULL;
+    if (javaInodes != NULL) {
+        inodes = env->GetLongArrayElements(javaInodes, NULL);
+        if (inodes == NULL) {
+            return -1;
+        }
+    }
+
+    // readdir(3) is safe here: the Java side serializes access to each stream, and we don't
+    // need readdir_r(3)'s caller-supplied buffer (which is awkward to size correctly anyway).
+    const jsize capacity = env->GetArrayLength(javaNames);
+    jint count = 0;
+    while (count < capacity) {
+        errno = 0;
+        dirent* entry = readdir(dir);
+        if (entry == NULL) {
+            if (errno != 0) {
+                jniThrowIOException(env, errno);
+                count = -1;
+            }
+            break;
+        }
+        const char* name = entry->d_name;
+        if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+            continue;
+        }
+        ScopedLocalRef<jstring> javaName(env, env->NewStringUTF(name));
+        if (javaName.get() == NULL) {
+            count = -1;
+            break;
+        }
+        env->SetObjectArrayElement(javaNames, count, javaName.get());
+        if (env->ExceptionCheck()) {
+            count = -1;
+            break;
+        }
+        types[count] = translateType(entry->d_type);
+        if (inodes != NULL) {
+            inodes[count] = entry->d_ino;
+        }
+        ++count;
+    }
+
+    if (inodes != NULL) {
+        env->ReleaseLongArrayElements(javaInodes, inodes, 0);
+    }
+    return count;
+}
+
+static void DirectoryStream_closeImpl(JNIEnv* env, jclass, jint handle) {
+    if (closedir(toDir(handle)) == -1) {
+        jniThrowIOException(env, errno);
+    }
+}
+
+static JNINativeMethod gMethods[] = {
+    NATIVE_METHOD(DirectoryStream, closeImpl, "(I)V"),
+    NATIVE_METHOD(DirectoryStream, openImpl, "(Ljava/lang/String;)I"),
+    NATIVE_METHOD(DirectoryStream, readImpl, "(I[Ljava/lang/String;[I[J)I"),
+};
+void register_libcore_io_DirectoryStream(JNIEnv* env) {
+    jniRegisterNativeMethods(env, "libcore/io/DirectoryStream", gMethods, NELEM(gMethods));
+}
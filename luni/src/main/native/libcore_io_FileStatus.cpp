@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "FileStatus"
+
+#include "JNIHelp.h"
+#include "JniConstants.h"
+#include "ScopedLocalRef.h"
+#include "ScopedPrimitiveArray.h"
+#include "ScopedUtfChars.h"
+
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+// Must match FileStatus.ST_* and FileStatus.FIELD_COUNT.
+enum {
+    ST_MODE, ST_SIZE, ST_BLOCKS, ST_ATIME, ST_MTIME, ST_CTIME, ST_INO, ST_DEV, FIELD_COUNT
+};
+
+// Fills 'out' with FIELD_COUNT fields describing 'path', or zeroes it and returns false.
+static bool doStat(const char* path, bool followLinks, jlong* out) {
+    struct stat sb;
+    int rc = followLinks ? stat(path, &sb) : lstat(path, &sb);
+    if (rc == -1) {
+        memset(out, 0, FIELD_COUNT * sizeof(jlong));
+        return false;
+    }
+    out[ST_MODE] = sb.st_mode;
+    out[ST_SIZE] = sb.st_size;
+    out[ST_BLOCKS] = sb.st_blocks;
+    out[ST_ATIME] = static_cast<jlong>(sb.st_atime) * 1000L;
+    out[ST_MTIME] = static_cast<jlong>(sb.st_mtime) * 1000L;
+    out[ST_CTIME] = static_cast<jlong>(sb.st_ctime) * 1000L;
+    out[ST_INO] = sb.st_ino;
+    out[ST_DEV] = sb.st_dev;
+    return true;
+}
+
+static jboolean FileStatus_statImpl(JNIEnv* env, jclass, jstring javaPath,
+        jboolean followLinks, jlongArray javaOut) {
+    ScopedUtfChars path(env, javaPath);
+    if (path.c_str() == NULL) {
+        return JNI_FALSE;
+    }
+    ScopedLongArrayRW out(env, javaOut);
+    if (out.get() == NULL) {
+        return JNI_FALSE;
+    }
+    return doStat(path.c_str(), followLinks, out.get());
+}
+
+static jint FileStatus_statBatchImpl(JNIEnv* env, jclass, jobjectArray javaPaths,
+        jboolean followLinks, jlongArray javaOut) {
+    ScopedLongArrayRW out(env, javaOut);
+    if (out.get() == NULL) {
+        return -1;
+    }
+    const jsize pathCount = env->GetArrayLength(javaPaths);
+    jint successCount = 0;
+    for (jsize i = 0; i < pathCount; ++i) {
+        ScopedLocalRef<jstring> javaPath(env,
+                reinterpret_cast<jstring>(env->GetObjectArrayElement(javaPaths, i)));
+        if (javaPath.get() == NULL) {
+            jniThrowNullPointerException(env, "paths[i] == null");
+            return -1;
+        }
+        ScopedUtfChars path(env, javaPath.get());
+        if (path.c_str() == NULL) {
+            return -1;
+        }
+        if (doStat(path.c_str(), followLinks, out.get() + i * FIELD_COUNT)) {
+            ++successCount;
+        }
+    }
+    return successCount;
+}
+
+static JNINativeMethod gMethods[] = {
+    NATIVE_METHOD(FileStatus, statBatchImpl, "([Ljava/lang/String;Z[J)I"),
+    NATIVE_METHOD(FileStatus, statImpl, "(Ljava/lang/String;Z[J)Z"),
+};
+void register_libcore_io_FileStatus(JNIEnv* env) {
+    jniRegisterNativeMethods(env, "libcore/io/FileStatus", gMethods, NELEM(gMethods));
+}
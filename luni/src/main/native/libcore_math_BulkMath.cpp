@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "BulkMath"
+
+#include "JNIHelp.h"
+#include "JniConstants.h"
+#include "ScopedPrimitiveArray.h"
+#include "jni.h"
+
+#include <math.h>
+
+// sqrt is correctly rounded, so a vector square root gives the same bits as libm's. The other
+// functions have no vector implementation in our libm, so they're applied an element at a time;
+// that's still exactly what java_lang_Math.cpp computes.
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define HAVE_SSE2_SQRT
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define HAVE_NEON_SQRT
+#endif
+
+typedef double (*UnaryFunction)(double);
+typedef void (*ArrayFunction)(const jdouble* in, jdouble* out, jint length);
+
+static void sqrtArray(const jdouble* in, jdouble* out, jint length) {
+    jint i = 0;
+#if defined(HAVE_SSE2_SQRT)
+    for (; i + 2 <= length; i += 2) {
+        _mm_storeu_pd(out + i, _mm_sqrt_pd(_mm_loadu_pd(in + i)));
+    }
+#elif defined(HAVE_NEON_SQRT)
+    for (; i + 2 <= length; i += 2) {
+        vst1q_f64(out + i, vsqrtq_f64(vld1q_f64(in + i)));
+    }
+#endif
+    for (; i < length; ++i) {
+        out[i] = sqrt(in[i]);
+    }
+}
+
+// Instantiated once per function, so the libm call in the loop is direct.
+template <UnaryFunction fn>
+static void mapArray(const jdouble* in, jdouble* out, jint length) {
+    for (jint i = 0; i < length; ++i) {
+        out[i] = fn(in[i]);
+    }
+}
+
+/**
+ * Runs 'map' over javaIn[offset, offset + length), writing to the same range of javaOut. The
+ * Java side has already checked the bounds. The two arrays may be the same array.
+ */
+static void apply(JNIEnv* env, jdoubleArray javaIn, jdoubleArray javaOut, jint offset,
+        jint length, ArrayFunction map) {
+    ScopedDoubleArrayRW out(env, javaOut);
+    if (out.get() == NULL) {
+        return;
+    }
+    if (env->IsSameObject(javaIn, javaOut)) {
+        map(out.get() + offset, out.get() + offset, length);
+        return;
+    }
+    ScopedDoubleArrayRO in(env, javaIn);
+    if (in.get() == NULL) {
+        return;
+    }
+    map(in.get() + offset, out.get() + offset, length);
+}
+
+static void BulkMath_sinImpl(JNIEnv* env, jclass, jdoubleArray in, jdoubleArray out, jint offset, jint length) {
+    apply(env, in, out, offset, length, mapArray<sin>);
+}
+
+static void BulkMath_cosImpl(JNIEnv* env, jclass, jdoubleArray in, jdoubleArray out, jint offset, jint length) {
+    apply(env, in, out, offset, length, mapArray<cos>);
+}
+
+static void BulkMath_tanImpl(JNIEnv* env, jclass, jdoubleArray in, jdoubleArray out, jint offset, jint length) {
+    apply(env, in, out, offset, length, mapArray<tan>);
+}
+
+static void BulkMath_expImpl(JNIEnv* env, jclass, jdoubleArray in, jdoubleArray out, jint offset, jint length) {
+    apply(env, in, out, offset, length, mapArray<exp>);
+}
+
+static void BulkMath_logImpl(JNIEnv* env, jclass, jdoubleArray in, jdoubleArray out, jint offset, jint length) {
+    apply(env, in, out, offset, length, mapArray<log>);
+}
+
+static void BulkMath_log10Impl(JNIEnv* env, jclass, jdoubleArray in, jdoubleArray out, jint offset, jint length) {
+    apply(env, in, out, offset, length, mapArray<log10>);
+}
+
+static void BulkMath_cbrtImpl(JNIEnv* env, jclass, jdoubleArray in, jdoubleArray out, jint offset, jint length) {
+    apply(env, in, out, offset, length, mapArray<cbrt>);
+}
+
+static void BulkMath_sqrtImpl(JNIEnv* env, jclass, jdoubleArray in, jdoubleArray out, jint offset, jint length) {
+    apply(env, in, out, offset, length, sqrtArray);
+}
+
+static void BulkMath_powImpl(JNIEnv* env, jclass, jdoubleArray javaIn, jdouble exponent,
+        jdoubleArray javaOut, jint offset, jint length) {
+    ScopedDoubleArrayRW out(env, javaOut);
+    if (out.get() == NULL) {
+        return;
+    }
+    jdouble* dst = out.get() + offset;
+    if (env->IsSameObject(javaIn, javaOut)) {
+        for (jint i = 0; i < length; ++i) {
+            dst[i] = pow(dst[i], exponent);
+        }
+        return;
+    }
+    ScopedDoubleArrayRO in(env, javaIn);
+    if (in.get() == NULL) {
+        return;
+    }
+    const jdouble* src = in.get() + offset;
+    for (jint i = 0; i < length; ++i) {
+        dst[i] = pow(src[i], exponent);
+    }
+}
+
+static JNINativeMethod gMethods[] = {
+    NATIVE_METHOD(BulkMath, cbrtImpl, "([D[DII)V"),
+    NATIVE_METHOD(BulkMath, cosImpl, "([D[DII)V"),
+    NATIVE_METHOD(BulkMath, expImpl, "([D[DII)V"),
+    NATIVE_METHOD(BulkMath, log10Impl, "([D[DII)V"),
+    NATIVE_METHOD(BulkMath, logImpl, "([D[DII)V"),
+    NATIVE_METHOD(BulkMath, powImpl, "([DD[DII)V"),
+    NATIVE_METHOD(BulkMath, sinImpl, "([D[DII)V"),
+    NATIVE_METHOD(BulkMath, sqrtImpl, "([D[DII)V"),
+    NATIVE_METHOD(BulkMath, tanImpl, "([D[DII)V"),
+};
+void register_libcore_math_BulkMath(JNIEnv* env) {
+    jniRegisterNativeMethods(env, "libcore/math/BulkMath", gMethods, NELEM(gMethods));
+}
@@ -28,6 +28,23 @@
  */
 #define HyOpenCreateNew 64
 #define HyOpenSync      128
+// Access-pattern hints that may be or'ed into the mode passed to open.
+// Must match IFileSystem.O_SEQUENTIAL and IFileSystem.O_RANDOM.
+#define HyOpenSequential 0x20000000
+#define HyOpenRandom     0x40000000
+// Bypass the page cache. Must match IFileSystem.O_DIRECT.
+#define HyOpenDirect     0x02000000
+// Must match IFileSystem.SYNC_FILE_RANGE_*.
+#define HySyncFileRangeWaitBefore 1
+#define HySyncFileRangeWrite      2
+#define HySyncFileRangeWaitAfter  4
+// Must match IFileSystem.ADVICE_*.
+#define HyAdviceNormal     0
+#define HyAdviceSequential 1
+#define HyAdviceRandom     2
+#define HyAdviceWillNeed   3
+#define HyAdviceDontNeed   4
+#define HyAdviceNoReuse    5
 #define SHARED_LOCK_TYPE 1L
 
 #include "JNIHelp.h"
@@ -40,6 +57,8 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <limits.h>
+#include <poll.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -49,6 +68,23 @@
 #include <sys/uio.h>
 #include <unistd.h>
 
+#include <list>
+#include <map>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#ifndef FICLONE
+// From <linux/fs.h>, which clashes with the C library's headers.
+#define FICLONE _IOW(0x94, 9, int)
+#endif
+#ifdef __NR_io_uring_setup
+#include <linux/io_uring.h>
+#define ENABLE_IO_URING
+#endif
+#endif
+
 #if HAVE_SYS_SENDFILE_H
 #include <sys/sendfile.h>
 #else
@@ -262,6 +298,350 @@ static jlong OSFileSystem_transfer(JNIEnv* env, jobject, jint fd, jobject sd,
     return rc;
 }
 
+#ifdef __linux__
+// If 'out' is empty and we're copying everything in 'in', asks the file system to share the
+// data rather than copy it (a "reflink", as btrfs and XFS offer). Returns the number of bytes
+// cloned, or -1 if that wasn't possible.
+static ssize_t cloneFile(int in, off_t inOffset, int out, size_t count) {
+    struct stat inStat, outStat;
+    if (inOffset != 0 || fstat(in, &inStat) == -1 || fstat(out, &outStat) == -1) {
+        return -1;
+    }
+    if (!S_ISREG(inStat.st_mode) || outStat.st_size != 0
+            || static_cast<off_t>(count) < inStat.st_size || lseek(out, 0, SEEK_CUR) != 0) {
+        return -1;
+    }
+    if (ioctl(out, FICLONE, in) == -1 || lseek(out, inStat.st_size, SEEK_SET) == -1) {
+        return -1;
+    }
+    return inStat.st_size;
+}
+#endif
+
+// Copies up to 'count' bytes through user space, for when the kernel can't do it for us.
+static ssize_t copyFileThroughUserSpace(int in, off_t inOffset, int out, size_t count) {
+    UniquePtr<char[]> buf(new char[65536]);
+    size_t total = 0;
+    while (total < count) {
+        size_t n = (count - total > 65536) ? 65536 : count - total;
+        ssize_t rc = TEMP_FAILURE_RETRY(pread64(in, buf.get(), n, inOffset + total));
+        if (rc <= 0) {
+            return (rc == -1 && total == 0) ? -1 : static_cast<ssize_t>(total);
+        }
+        for (ssize_t written = 0; written < rc; ) {
+            ssize_t w = TEMP_FAILURE_RETRY(write(out, buf.get() + written, rc - written));
+            if (w == -1) {
+                return (total == 0) ? -1 : static_cast<ssize_t>(total);
+            }
+            written += w;
+            total += w;
+        }
+    }
+    return total;
+}
+
+/**
+ * Copies up to 'count' bytes of the file 'in', starting at 'inOffset', to the file 'out' at its
+ * current position, advancing that position. We try, in order: a reflink, which shares the data
+ * rather than copying it; copy_file_range(2); sendfile(2); and finally pread/write. Each of the
+ * first three is skipped if the kernel or file system doesn't support it.
+ */
+static jlong OSFileSystem_transferFile(JNIEnv* env, jobject, jint in, jlong inOffset,
+        jint out, jlong count) {
+    if (inOffset < 0 || count < 0) {
+        jniThrowException(env, "java/lang/IllegalArgumentException", NULL);
+        return -1;
+    }
+    size_t byteCount = (count > SSIZE_MAX) ? SSIZE_MAX : count;
+    size_t total = 0;
+    ssize_t rc = -1;
+    errno = ENOSYS;
+
+#ifdef __linux__
+    rc = cloneFile(in, inOffset, out, byteCount);
+    if (rc != -1) {
+        return rc;
+    }
+
+#ifdef __NR_copy_file_range
+    while (total < byteCount) {
+        loff_t off = inOffset + total;
+        rc = syscall(__NR_copy_file_range, in, &off, out, NULL, byteCount - total, 0);
+        if (rc == -1 && errno == EINTR) {
+            continue;
+        }
+        if (rc <= 0) {
+            break;
+        }
+        total += rc;
+    }
+    if (total == byteCount || rc == 0) {
+        return total;
+    }
+    if (total == 0 && errno != ENOSYS && errno != EXDEV && errno != EINVAL
+            && errno != EOPNOTSUPP) {
+        jniThrowIOException(env, errno);
+        return -1;
+    }
+#endif
+
+    // sendfile(2) has been able to write to files since Linux 2.6.33. Its off_t may be too
+    // small for offsets in large files, in which case we leave those to pread64(2).
+    while (total < byteCount) {
+        off_t off = inOffset + total;
+        if (static_cast<jlong>(off) != static_cast<jlong>(inOffset + total)) {
+            rc = -1;
+            break;
+        }
+        rc = TEMP_FAILURE_RETRY(sendfile(out, in, &off, byteCount - total));
+        if (rc <= 0) {
+            break;
+        }
+        total += rc;
+    }
+    if (total == byteCount || rc == 0) {
+        return total;
+    }
+#endif
+
+    rc = copyFileThroughUserSpace(in, inOffset + total, out, byteCount - total);
+    if (rc == -1) {
+        if (total > 0) {
+            return total;
+        }
+        jniThrowIOException(env, errno);
+        return -1;
+    }
+    return total + rc;
+}
+
+// Waits until 'fd' can take more data. A relay has already consumed what it's writing from
+// its source, so it has to see it through even when the sink is non-blocking.
+static bool waitUntilWritable(int fd) {
+    pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLOUT;
+    pfd.revents = 0;
+    return TEMP_FAILURE_RETRY(poll(&pfd, 1, -1)) != -1;
+}
+
+// Writes all 'count' bytes at 'buf' to 'out'. Returns the number of bytes written, which is
+// less than 'count' only if write(2) failed, in which case errno is set.
+static size_t writeFully(int out, const char* buf, size_t count) {
+    size_t written = 0;
+    while (written < count) {
+        ssize_t rc = TEMP_FAILURE_RETRY(write(out, buf + written, count - written));
+        if (rc == -1) {
+            if (errno == EAGAIN && waitUntilWritable(out)) {
+                continue;
+            }
+            break;
+        }
+        written += rc;
+    }
+    return written;
+}
+
+#ifdef __linux__
+// Each thread that relays keeps a pipe to splice through, to avoid two extra system calls
+// (and two fds' worth of churn) per relay.
+static pthread_key_t gRelayPipeKey;
+static pthread_once_t gRelayPipeKeyOnce = PTHREAD_ONCE_INIT;
+
+struct RelayPipe {
+    int fds[2];
+};
+
+static void destroyRelayPipe(void* value) {
+    RelayPipe* relayPipe = reinterpret_cast<RelayPipe*>(value);
+    close(relayPipe->fds[0]);
+    close(relayPipe->fds[1]);
+    delete relayPipe;
+}
+
+static void createRelayPipeKey() {
+    pthread_key_create(&gRelayPipeKey, destroyRelayPipe);
+}
+
+// Returns this thread's relay pipe, creating it if necessary, or NULL with errno set.
+static RelayPipe* getRelayPipe() {
+    pthread_once(&gRelayPipeKeyOnce, createRelayPipeKey);
+    RelayPipe* relayPipe = reinterpret_cast<RelayPipe*>(pthread_getspecific(gRelayPipeKey));
+    if (relayPipe == NULL) {
+        relayPipe = new RelayPipe;
+        if (pipe(relayPipe->fds) == -1) {
+            delete relayPipe;
+            return NULL;
+        }
+        for (int i = 0; i < 2; ++i) {
+            fcntl(relayPipe->fds[i], F_SETFD, FD_CLOEXEC);
+        }
+        pthread_setspecific(gRelayPipeKey, relayPipe);
+    }
+    return relayPipe;
+}
+
+// Throws away this thread's relay pipe. Used when a failure leaves data stranded in it.
+static void discardRelayPipe(RelayPipe* relayPipe) {
+    pthread_setspecific(gRelayPipeKey, NULL);
+    destroyRelayPipe(relayPipe);
+}
+
+// Moves the 'count' bytes in the relay pipe to 'out', waiting whenever a non-blocking 'out' is
+// full, and copying through user space if 'out' turns out not to support splice(2). Returns
+// the number of bytes moved, which is less than 'count' only on failure, with errno set.
+static size_t drainRelayPipe(RelayPipe* relayPipe, int out, size_t count) {
+    size_t drained = 0;
+    while (drained < count) {
+        ssize_t rc = TEMP_FAILURE_RETRY(splice(relayPipe->fds[0], NULL, out, NULL,
+                count - drained, SPLICE_F_MOVE | SPLICE_F_MORE));
+        if (rc != -1) {
+            drained += rc;
+        } else if (errno == EAGAIN) {
+            if (!waitUntilWritable(out)) {
+                break;
+            }
+        } else if (errno == EINVAL || errno == ENOSYS) {
+            char buf[8192];
+            while (drained < count) {
+                size_t chunk = (count - drained < sizeof(buf)) ? count - drained : sizeof(buf);
+                ssize_t bytesRead = TEMP_FAILURE_RETRY(read(relayPipe->fds[0], buf, chunk));
+                if (bytesRead <= 0) {
+                    return drained;
+                }
+                size_t written = writeFully(out, buf, bytesRead);
+                drained += written;
+                if (written < static_cast<size_t>(bytesRead)) {
+                    return drained;
+                }
+            }
+        } else {
+            break;
+        }
+    }
+    return drained;
+}
+
+// Moves up to 'count' bytes from 'in' to 'out' without copying them to user space. Returns
+// the number of bytes moved, 0 at end of stream, or -1 with errno set. ENOSYS and EINVAL
+// mean one of the fds doesn't support splice(2) and nothing was moved. Everything taken from
+// 'in' is written to 'out' before returning, unless writing to 'out' fails.
+static ssize_t spliceRelay(int in, int out, size_t count) {
+    RelayPipe* relayPipe = getRelayPipe();
+    if (relayPipe == NULL) {
+        return -1;
+    }
+    size_t total = 0;
+    while (total < count) {
+        // Only the first read may block: after that we move what's already arrived.
+        unsigned int flags = SPLICE_F_MOVE | SPLICE_F_MORE;
+        if (total > 0) {
+            flags |= SPLICE_F_NONBLOCK;
+        }
+        ssize_t spliced = TEMP_FAILURE_RETRY(splice(in, NULL, relayPipe->fds[1], NULL,
+                count - total, flags));
+        if (spliced == 0) {
+            break;
+        } else if (spliced == -1) {
+            if (total > 0 && errno == EAGAIN) {
+                break;
+            }
+            return (total > 0) ? static_cast<ssize_t>(total) : -1;
+        }
+        // Drain the pipe completely before reading more, so the pipe never fills.
+        size_t drained = drainRelayPipe(relayPipe, out, spliced);
+        total += drained;
+        if (drained < static_cast<size_t>(spliced)) {
+            // 'out' is broken, and what's left in the pipe can't go anywhere.
+            int error = errno;
+            discardRelayPipe(relayPipe);
+            errno = error;
+            return (total > 0) ? static_cast<ssize_t>(total) : -1;
+        }
+    }
+    return total;
+}
+#endif
+
+// Moves up to 'count' bytes from 'in' to 'out' by reading into and writing from a buffer.
+static ssize_t copyRelay(int in, int out, size_t count) {
+    char buf[8192];
+    ssize_t bytesRead = TEMP_FAILURE_RETRY(read(in, buf, (count < sizeof(buf)) ? count : sizeof(buf)));
+    if (bytesRead <= 0) {
+        return bytesRead;
+    }
+    size_t written = writeFully(out, buf, bytesRead);
+    if (written == 0) {
+        return -1;
+    }
+    return written;
+}
+
+/**
+ * Moves up to 'count' bytes from the socket (or pipe) 'source' to 'sink'. On Linux the data
+ * goes through a kernel pipe with splice(2), and never reaches user space. Returns the number
+ * of bytes moved, 0 if a non-blocking source had nothing to read, or -1 at end of stream.
+ * Whatever is read from 'source' is written to 'sink' before returning, waiting for a
+ * non-blocking sink to have room if necessary.
+ */
+static jlong OSFileSystem_relay(JNIEnv* env, jobject, jobject source, jobject sink, jlong count) {
+    int in = jniGetFDFromFileDescriptor(env, source);
+    int out = jniGetFDFromFileDescriptor(env, sink);
+    if (in == -1 || out == -1) {
+        jniThrowIOException(env, EBADF);
+        return -1;
+    }
+    if (count <= 0) {
+        return 0;
+    }
+    size_t byteCount = (count > INT_MAX) ? INT_MAX : count;
+
+    ssize_t rc = -1;
+#ifdef __linux__
+    rc = spliceRelay(in, out, byteCount);
+    if (rc == -1 && (errno == EINVAL || errno == ENOSYS)) {
+        rc = copyRelay(in, out, byteCount);
+    }
+#else
+    rc = copyRelay(in, out, byteCount);
+#endif
+    if (rc == 0) {
+        return -1;
+    }
+    if (rc == -1) {
+        if (errno == EAGAIN) {
+            return 0;
+        }
+        jniThrowIOException(env, errno);
+    }
+    return rc;
+}
+
+#ifdef O_DIRECT
+// O_DIRECT reads and writes fail with EINVAL unless the buffer address, the length and the
+// file position are all suitably aligned. Rather than pay for a check on every call, we only
+// work out whether that was the problem after the kernel says no.
+static bool throwIfMisalignedDirectIo(JNIEnv* env, jint fd, const void* buf, jint byteCount) {
+    int flags = fcntl(fd, F_GETFL);
+    if (flags == -1 || (flags & O_DIRECT) == 0) {
+        return false;
+    }
+    struct stat sb;
+    size_t alignment = (fstat(fd, &sb) == 0 && sb.st_blksize > 0) ? sb.st_blksize : 512;
+    off_t position = lseek(fd, 0, SEEK_CUR);
+    char message[160];
+    snprintf(message, sizeof(message),
+            "O_DIRECT I/O needs address (%p), length (%d) and position (%ld) aligned to %d",
+            buf, byteCount, static_cast<long>(position), static_cast<int>(alignment));
+    jniThrowException(env, "java/lang/IllegalArgumentException", message);
+    return true;
+}
+#else
+static bool throwIfMisalignedDirectIo(JNIEnv*, jint, const void*, jint) {
+    return false;
+}
+#endif
+
 static jlong OSFileSystem_readDirect(JNIEnv* env, jobject, jint fd,
         jint buf, jint offset, jint byteCount) {
     if (byteCount == 0) {
@@ -277,6 +657,9 @@ static jlong OSFileSystem_readDirect(JNIEnv* env, jobject, jint fd,
         if (errno == EAGAIN) {
             return 0;
         }
+        if (errno == EINVAL && throwIfMisalignedDirectIo(env, fd, dst, byteCount)) {
+            return -1;
+        }
         jniThrowIOException(env, errno);
     }
     return rc;
@@ -300,6 +683,9 @@ static jlong OSFileSystem_writeDirect(JNIEnv* env, jobject, jint fd,
     jbyte* src = reinterpret_cast<jbyte*>(buf + offset);
     jlong rc = TEMP_FAILURE_RETRY(write(fd, src, byteCount));
     if (rc == -1) {
+        if (errno == EINVAL && throwIfMisalignedDirectIo(env, fd, src, byteCount)) {
+            return -1;
+        }
         jniThrowIOException(env, errno);
     }
     return rc;
@@ -346,6 +732,110 @@ static void OSFileSystem_fsync(JNIEnv* env, jobject, jint fd, jboolean metadataT
     }
 }
 
+// Group commit: threads that want an fd's data durable share one flush rather than each
+// paying for their own. A thread's request is only satisfied by a flush that *started* after
+// it asked (otherwise its write might have missed the flush), so each request waits for the
+// next generation of flush. Whoever finds no flush in progress runs one on behalf of everyone
+// waiting, using fsync(2) if any of them wanted metadata too and fdatasync(2) otherwise.
+// A failed flush fails every request it covered, even if a later flush succeeds before they
+// get to look: the kernel reports a writeback error once, so the later success proves nothing.
+struct GroupSyncState {
+    GroupSyncState() : users(0), inProgress(false), metadataWanted(false),
+            started(0), completed(0), failed(0), failedErrno(0) {
+        pthread_cond_init(&cond, NULL);
+    }
+    ~GroupSyncState() {
+        pthread_cond_destroy(&cond);
+    }
+    pthread_cond_t cond;
+    int users;
+    bool inProgress;
+    bool metadataWanted; // By a request for the next generation.
+    uint64_t started;
+    uint64_t completed;
+    uint64_t failed; // The last generation to fail, or 0.
+    int failedErrno; // For generation 'failed'.
+};
+static pthread_mutex_t gGroupSyncMutex = PTHREAD_MUTEX_INITIALIZER;
+static std::map<int, GroupSyncState*> gGroupSyncStates;
+
+static void OSFileSystem_groupSync(JNIEnv* env, jobject, jint fd, jboolean metadataToo) {
+    pthread_mutex_lock(&gGroupSyncMutex);
+    GroupSyncState*& slot = gGroupSyncStates[fd];
+    if (slot == NULL) {
+        slot = new GroupSyncState;
+    }
+    GroupSyncState* state = slot;
+    ++state->users;
+
+    // The generation that will cover us is the next one to start.
+    uint64_t needed = state->started + 1;
+    if (metadataToo) {
+        state->metadataWanted = true;
+    }
+    while (state->completed < needed) {
+        if (state->inProgress) {
+            pthread_cond_wait(&state->cond, &gGroupSyncMutex);
+            continue;
+        }
+        // Lead a flush for everyone who's asked so far.
+        state->inProgress = true;
+        uint64_t generation = ++state->started;
+        bool metadata = state->metadataWanted;
+        state->metadataWanted = false;
+        pthread_mutex_unlock(&gGroupSyncMutex);
+        int rc = metadata ? fsync(fd) : fdatasync(fd);
+        int flushErrno = (rc == -1) ? errno : 0;
+        pthread_mutex_lock(&gGroupSyncMutex);
+        state->inProgress = false;
+        state->completed = generation;
+        if (flushErrno != 0) {
+            state->failed = generation;
+            state->failedErrno = flushErrno;
+        }
+        pthread_cond_broadcast(&state->cond);
+    }
+    // Any failure since our generation started may have lost our data.
+    int error = (state->failed >= needed) ? state->failedErrno : 0;
+
+    if (--state->users == 0) {
+        gGroupSyncStates.erase(fd);
+        delete state;
+    }
+    pthread_mutex_unlock(&gGroupSyncMutex);
+    if (error != 0) {
+        jniThrowIOException(env, error);
+    }
+}
+
+static void OSFileSystem_syncFileRange(JNIEnv* env, jobject, jint fd, jlong offset,
+        jlong length, jint flags) {
+    if (offset < 0 || length < 0 || (flags & ~(HySyncFileRangeWaitBefore |
+            HySyncFileRangeWrite | HySyncFileRangeWaitAfter)) != 0) {
+        jniThrowException(env, "java/lang/IllegalArgumentException", NULL);
+        return;
+    }
+#ifdef SYNC_FILE_RANGE_WRITE
+    unsigned int nativeFlags = 0;
+    if ((flags & HySyncFileRangeWaitBefore) != 0) {
+        nativeFlags |= SYNC_FILE_RANGE_WAIT_BEFORE;
+    }
+    if ((flags & HySyncFileRangeWrite) != 0) {
+        nativeFlags |= SYNC_FILE_RANGE_WRITE;
+    }
+    if ((flags & HySyncFileRangeWaitAfter) != 0) {
+        nativeFlags |= SYNC_FILE_RANGE_WAIT_AFTER;
+    }
+    int rc = TEMP_FAILURE_RETRY(sync_file_range(fd, offset, length, nativeFlags));
+#else
+    // Without sync_file_range(2), starting writeback is a no-op, and waiting means a flush.
+    int rc = (flags & (HySyncFileRangeWaitBefore | HySyncFileRangeWaitAfter)) ? fdatasync(fd) : 0;
+#endif
+    if (rc == -1) {
+        jniThrowIOException(env, errno);
+    }
+}
+
 static jint OSFileSystem_truncate(JNIEnv* env, jobject, jint fd, jlong length) {
     // TODO: if we had ftruncate64, we could kill this (http://b/3107933).
     if (offsetTooLarge(env, length)) {
@@ -359,10 +849,100 @@ static jint OSFileSystem_truncate(JNIEnv* env, jobject, jint fd, jlong length) {
     return rc;
 }
 
+#ifdef POSIX_FADV_NORMAL
+#define ENABLE_FADVISE
+#endif
+
+// Applies an IFileSystem.ADVICE_* hint to the given range of 'fd'. Returns 0, or an errno
+// value. Advice is only ever a hint, so where the platform can't take it we do nothing.
+static int adviseRange(int fd, jlong offset, jlong length, jint advice) {
+#ifdef ENABLE_FADVISE
+    int nativeAdvice;
+    switch (advice) {
+    case HyAdviceNormal:
+        nativeAdvice = POSIX_FADV_NORMAL;
+        break;
+    case HyAdviceSequential:
+        nativeAdvice = POSIX_FADV_SEQUENTIAL;
+        break;
+    case HyAdviceRandom:
+        nativeAdvice = POSIX_FADV_RANDOM;
+        break;
+    case HyAdviceWillNeed:
+        nativeAdvice = POSIX_FADV_WILLNEED;
+        break;
+    case HyAdviceDontNeed:
+        nativeAdvice = POSIX_FADV_DONTNEED;
+        break;
+    case HyAdviceNoReuse:
+        nativeAdvice = POSIX_FADV_NOREUSE;
+        break;
+    default:
+        return EINVAL;
+    }
+    // posix_fadvise returns the error rather than setting errno.
+    return posix_fadvise(fd, offset, length, nativeAdvice);
+#else
+    if (advice < HyAdviceNormal || advice > HyAdviceNoReuse) {
+        return EINVAL;
+    }
+    return 0;
+#endif
+}
+
+/**
+ * Tells the kernel how the given range of the file (to the end of the file if 'length' is 0)
+ * will be accessed: sequentially, randomly, soon, or not again.
+ */
+static void OSFileSystem_advise(JNIEnv* env, jobject, jint fd, jlong offset, jlong length,
+        jint advice) {
+    if (offset < 0 || length < 0) {
+        jniThrowException(env, "java/lang/IllegalArgumentException", "offset < 0 || length < 0");
+        return;
+    }
+    if (offsetTooLarge(env, offset) || offsetTooLarge(env, length)) {
+        return;
+    }
+    int error = adviseRange(fd, offset, length, advice);
+    if (error == EINVAL && (advice < HyAdviceNormal || advice > HyAdviceNoReuse)) {
+        jniThrowException(env, "java/lang/IllegalArgumentException", "unknown advice");
+    } else if (error != 0) {
+        jniThrowIOException(env, error);
+    }
+}
+
+/**
+ * Starts reading the given range of the file into the page cache, without waiting for it.
+ */
+static void OSFileSystem_readahead(JNIEnv* env, jobject, jint fd, jlong offset, jlong length) {
+    if (offset < 0 || length < 0) {
+        jniThrowException(env, "java/lang/IllegalArgumentException", "offset < 0 || length < 0");
+        return;
+    }
+    if (offsetTooLarge(env, offset) || offsetTooLarge(env, length)) {
+        return;
+    }
+#ifdef __GLIBC__
+    if (readahead(fd, offset, length) == -1) {
+        jniThrowIOException(env, errno);
+    }
+#else
+    // POSIX_FADV_WILLNEED is readahead(2) by another name on Linux.
+    int error = adviseRange(fd, offset, length, HyAdviceWillNeed);
+    if (error != 0) {
+        jniThrowIOException(env, error);
+    }
+#endif
+}
+
 static jint OSFileSystem_open(JNIEnv* env, jobject, jstring javaPath, jint jflags) {
     int flags = 0;
     int mode = 0;
 
+    int hints = jflags & (HyOpenSequential | HyOpenRandom);
+    bool direct = (jflags & HyOpenDirect) != 0;
+    jflags &= ~(HyOpenSequential | HyOpenRandom | HyOpenDirect);
+
     // On Android, we don't want default permissions to allow global access.
     switch (jflags) {
     case 0:
@@ -388,12 +968,26 @@ static jint OSFileSystem_open(JNIEnv* env, jobject, jstring javaPath, jint jflag
     }
 
     flags = EsTranslateOpenFlags(flags);
+#ifdef O_DIRECT
+    if (direct && flags != -1) {
+        flags |= O_DIRECT;
+    }
+#else
+    // Without O_DIRECT we still go through the page cache, which is slower but correct.
+    (void) direct;
+#endif
 
     ScopedUtfChars path(env, javaPath);
     if (path.c_str() == NULL) {
         return -1;
     }
     jint fd = TEMP_FAILURE_RETRY(open(path.c_str(), flags, mode));
+#ifdef O_DIRECT
+    if (fd == -1 && errno == EINVAL && direct) {
+        // Some file systems (tmpfs, for one) don't support O_DIRECT. Treat it as a hint.
+        fd = TEMP_FAILURE_RETRY(open(path.c_str(), flags & ~O_DIRECT, mode));
+    }
+#endif
 
     // Posix open(2) fails with EISDIR only if you ask for write permission.
     // Java disallows reading directories too.
@@ -410,6 +1004,11 @@ static jint OSFileSystem_open(JNIEnv* env, jobject, jstring javaPath, jint jflag
         }
     }
 
+    if (fd != -1 && hints != 0) {
+        // A failed hint isn't worth failing the open for.
+        adviseRange(fd, 0, 0, (hints & HyOpenRandom) ? HyAdviceRandom : HyAdviceSequential);
+    }
+
     if (fd == -1) {
         // Get the human-readable form of errno.
         char buffer[80];
@@ -486,18 +1085,506 @@ static jlong OSFileSystem_length(JNIEnv* env, jobject, jint fd) {
     return sb.st_size;
 }
 
+/*
+ * Positional I/O queues. Callers queue many reads and writes, each against its own
+ * (fd, offset, address, length), and reap the completions in batches. With io_uring the
+ * whole batch goes to the kernel in one system call; otherwise a few threads run
+ * pread/pwrite on the caller's behalf.
+ */
+
+// Must match IFileSystem.IO_READ and IFileSystem.IO_WRITE.
+#define IO_READ 0
+#define IO_WRITE 1
+
+struct IoRequest {
+    int op;
+    int fd;
+    jlong offset;
+    void* address;
+    size_t length;
+    jint tag;
+};
+
+struct IoCompletion {
+    jint tag;
+    jlong result; // Bytes transferred, or -errno.
+};
+
+class IoQueue {
+public:
+    virtual ~IoQueue() {}
+
+    // Queues up to 'count' requests. Returns how many were accepted, which is 0 if the queue
+    // is full, or -errno. On -errno none of the requests were accepted.
+    virtual int submit(const IoRequest* requests, int count) = 0;
+
+    // Waits until at least 'minComplete' requests have completed (or until nothing is
+    // outstanding), then moves up to 'maxCompletions' completions to 'out'. Returns the
+    // number moved, or -errno.
+    virtual int reap(IoCompletion* out, int minComplete, int maxCompletions) = 0;
+};
+
+static jlong positionalIo(const IoRequest& request) {
+    ssize_t rc;
+#ifdef __linux__
+    if (request.op == IO_WRITE) {
+        rc = TEMP_FAILURE_RETRY(pwrite64(request.fd, request.address, request.length,
+                request.offset));
+    } else {
+        rc = TEMP_FAILURE_RETRY(pread64(request.fd, request.address, request.length,
+                request.offset));
+    }
+#else
+    if (request.op == IO_WRITE) {
+        rc = TEMP_FAILURE_RETRY(pwrite(request.fd, request.address, request.length,
+                request.offset));
+    } else {
+        rc = TEMP_FAILURE_RETRY(pread(request.fd, request.address, request.length,
+                request.offset));
+    }
+#endif
+    return (rc == -1) ? -errno : rc;
+}
+
+class ThreadPoolIoQueue : public IoQueue {
+public:
+    // Returns a new queue, or NULL with errno set.
+    static ThreadPoolIoQueue* create(int depth) {
+        UniquePtr<ThreadPoolIoQueue> queue(new ThreadPoolIoQueue(depth));
+        int threadCount = (depth < MAX_THREADS) ? depth : MAX_THREADS;
+        while (queue->mThreadCount < threadCount) {
+            int rc = pthread_create(&queue->mThreads[queue->mThreadCount], NULL,
+                    ThreadPoolIoQueue::worker, queue.get());
+            if (rc != 0) {
+                errno = rc;
+                return NULL;
+            }
+            ++queue->mThreadCount;
+        }
+        return queue.release();
+    }
+
+    virtual ~ThreadPoolIoQueue() {
+        pthread_mutex_lock(&mMutex);
+        mStopping = true;
+        pthread_cond_broadcast(&mWorkAvailable);
+        pthread_mutex_unlock(&mMutex);
+        for (int i = 0; i < mThreadCount; ++i) {
+            pthread_join(mThreads[i], NULL);
+        }
+        pthread_cond_destroy(&mWorkAvailable);
+        pthread_cond_destroy(&mWorkDone);
+        pthread_mutex_destroy(&mMutex);
+    }
+
+    virtual int submit(const IoRequest* requests, int count) {
+        pthread_mutex_lock(&mMutex);
+        int accepted = 0;
+        while (accepted < count && mOutstanding < mDepth) {
+            mPending.push_back(requests[accepted++]);
+            ++mOutstanding;
+        }
+        pthread_cond_broadcast(&mWorkAvailable);
+        pthread_mutex_unlock(&mMutex);
+        return accepted;
+    }
+
+    virtual int reap(IoCompletion* out, int minComplete, int maxCompletions) {
+        pthread_mutex_lock(&mMutex);
+        while (static_cast<int>(mDone.size()) < minComplete
+                && static_cast<int>(mDone.size()) < mOutstanding) {
+            pthread_cond_wait(&mWorkDone, &mMutex);
+        }
+        int moved = 0;
+        while (moved < maxCompletions && !mDone.empty()) {
+            out[moved++] = mDone.front();
+            mDone.pop_front();
+            --mOutstanding;
+        }
+        pthread_mutex_unlock(&mMutex);
+        return moved;
+    }
+
+private:
+    static const int MAX_THREADS = 4;
+
+    ThreadPoolIoQueue(int depth) : mDepth(depth), mOutstanding(0), mStopping(false),
+            mThreadCount(0) {
+        pthread_mutex_init(&mMutex, NULL);
+        pthread_cond_init(&mWorkAvailable, NULL);
+        pthread_cond_init(&mWorkDone, NULL);
+    }
+
+    static void* worker(void* arg) {
+        ThreadPoolIoQueue* queue = reinterpret_cast<ThreadPoolIoQueue*>(arg);
+        pthread_mutex_lock(&queue->mMutex);
+        while (true) {
+            while (queue->mPending.empty() && !queue->mStopping) {
+                pthread_cond_wait(&queue->mWorkAvailable, &queue->mMutex);
+            }
+            if (queue->mStopping) {
+                break;
+            }
+            IoRequest request = queue->mPending.front();
+            queue->mPending.pop_front();
+            pthread_mutex_unlock(&queue->mMutex);
+
+            IoCompletion completion;
+            completion.tag = request.tag;
+            completion.result = positionalIo(request);
+
+            pthread_mutex_lock(&queue->mMutex);
+            queue->mDone.push_back(completion);
+            pthread_cond_signal(&queue->mWorkDone);
+        }
+        pthread_mutex_unlock(&queue->mMutex);
+        return NULL;
+    }
+
+    const int mDepth;
+    int mOutstanding; // Submitted but not yet reaped.
+    bool mStopping;
+    pthread_mutex_t mMutex;
+    pthread_cond_t mWorkAvailable;
+    pthread_cond_t mWorkDone;
+    std::list<IoRequest> mPending;
+    std::list<IoCompletion> mDone;
+    pthread_t mThreads[MAX_THREADS];
+    int mThreadCount;
+};
+
+#ifdef ENABLE_IO_URING
+class UringIoQueue : public IoQueue {
+public:
+    // Returns a new queue, or NULL with errno set if the kernel doesn't support io_uring.
+    static UringIoQueue* create(int depth) {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        int fd = syscall(__NR_io_uring_setup, depth, &params);
+        if (fd == -1) {
+            return NULL;
+        }
+        UniquePtr<UringIoQueue> queue(new UringIoQueue(fd, depth, params));
+        if (!queue->mapRings()) {
+            return NULL;
+        }
+        return queue.release();
+    }
+
+    virtual ~UringIoQueue() {
+        if (mSqRing != MAP_FAILED) {
+            munmap(mSqRing, mSqRingSize);
+        }
+        if (mCqRing != MAP_FAILED) {
+            munmap(mCqRing, mCqRingSize);
+        }
+        if (mSqes != MAP_FAILED) {
+            munmap(mSqes, mSqesSize);
+        }
+        // Closing the ring waits for anything still in flight.
+        close(mFd);
+    }
+
+    virtual int submit(const IoRequest* requests, int count) {
+        const unsigned firstTail = *mSqTail;
+        unsigned tail = firstTail;
+        unsigned head = *mSqHead;
+        __sync_synchronize();
+        int accepted = 0;
+        while (accepted < count && !mFreeSlots.empty() && tail - head < mParams.sq_entries) {
+            const IoRequest& request = requests[accepted++];
+            int slot = mFreeSlots.back();
+            mFreeSlots.pop_back();
+            mIovecs[slot].iov_base = request.address;
+            mIovecs[slot].iov_len = request.length;
+            mTags[slot] = request.tag;
+
+            unsigned index = tail & *mSqMask;
+            io_uring_sqe* sqe = reinterpret_cast<io_uring_sqe*>(mSqes) + index;
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = (request.op == IO_WRITE) ? IORING_OP_WRITEV : IORING_OP_READV;
+            sqe->fd = request.fd;
+            sqe->off = request.offset;
+            sqe->addr = reinterpret_cast<uintptr_t>(&mIovecs[slot]);
+            sqe->len = 1;
+            sqe->user_data = slot;
+            mSqArray[index] = index;
+            ++tail;
+        }
+        if (accepted == 0) {
+            return 0;
+        }
+        __sync_synchronize();
+        *mSqTail = tail;
+        __sync_synchronize();
+        mInFlight += accepted;
+        mUnsubmitted += accepted;
+        int rc = enter(0, 0);
+        if (rc < 0 && rc != -EAGAIN && rc != -EBUSY) {
+            // A failed enter consumes nothing, so our entries are still the newest ones in the
+            // ring. Take them back rather than leave requests the caller was told failed to be
+            // submitted by some later enter.
+            for (unsigned i = firstTail; i != tail; ++i) {
+                io_uring_sqe* sqe = reinterpret_cast<io_uring_sqe*>(mSqes) + (i & *mSqMask);
+                mFreeSlots.push_back(sqe->user_data);
+            }
+            *mSqTail = firstTail;
+            __sync_synchronize();
+            mInFlight -= accepted;
+            mUnsubmitted -= accepted;
+            return rc;
+        }
+        // Entries the kernel didn't take yet stay in the ring and go with the next enter.
+        return accepted;
+    }
+
+    virtual int reap(IoCompletion* out, int minComplete, int maxCompletions) {
+        if (minComplete > mInFlight) {
+            minComplete = mInFlight;
+        }
+        int moved = 0;
+        while (true) {
+            unsigned head = *mCqHead;
+            __sync_synchronize();
+            unsigned tail = *mCqTail;
+            while (head != tail && moved < maxCompletions) {
+                io_uring_cqe* cqe = &mCqes[head & *mCqMask];
+                int slot = cqe->user_data;
+                out[moved].tag = mTags[slot];
+                out[moved].result = cqe->res;
+                mFreeSlots.push_back(slot);
+                ++head;
+                ++moved;
+                --mInFlight;
+            }
+            __sync_synchronize();
+            *mCqHead = head;
+            if (moved >= minComplete || moved == maxCompletions) {
+                return moved;
+            }
+            int rc = enter(minComplete - moved, IORING_ENTER_GETEVENTS);
+            if (rc < 0) {
+                return (moved > 0) ? moved : rc;
+            }
+        }
+    }
+
+private:
+    UringIoQueue(int fd, int depth, const io_uring_params& params) : mFd(fd), mParams(params),
+            mSqRing(MAP_FAILED), mCqRing(MAP_FAILED), mSqes(MAP_FAILED),
+            mIovecs(depth), mTags(depth), mInFlight(0), mUnsubmitted(0) {
+        for (int i = depth - 1; i >= 0; --i) {
+            mFreeSlots.push_back(i);
+        }
+    }
+
+    bool mapRings() {
+        mSqRingSize = mParams.sq_off.array + mParams.sq_entries * sizeof(unsigned);
+        mSqRing = mmap(NULL, mSqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                mFd, IORING_OFF_SQ_RING);
+        mCqRingSize = mParams.cq_off.cqes + mParams.cq_entries * sizeof(io_uring_cqe);
+        mCqRing = mmap(NULL, mCqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                mFd, IORING_OFF_CQ_RING);
+        mSqesSize = mParams.sq_entries * sizeof(io_uring_sqe);
+        mSqes = mmap(NULL, mSqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                mFd, IORING_OFF_SQES);
+        if (mSqRing == MAP_FAILED || mCqRing == MAP_FAILED || mSqes == MAP_FAILED) {
+            return false;
+        }
+        char* sq = reinterpret_cast<char*>(mSqRing);
+        mSqHead = reinterpret_cast<unsigned*>(sq + mParams.sq_off.head);
+        mSqTail = reinterpret_cast<unsigned*>(sq + mParams.sq_off.tail);
+        mSqMask = reinterpret_cast<unsigned*>(sq + mParams.sq_off.ring_mask);
+        mSqArray = reinterpret_cast<unsigned*>(sq + mParams.sq_off.array);
+        char* cq = reinterpret_cast<char*>(mCqRing);
+        mCqHead = reinterpret_cast<unsigned*>(cq + mParams.cq_off.head);
+        mCqTail = reinterpret_cast<unsigned*>(cq + mParams.cq_off.tail);
+        mCqMask = reinterpret_cast<unsigned*>(cq + mParams.cq_off.ring_mask);
+        mCqes = reinterpret_cast<io_uring_cqe*>(cq + mParams.cq_off.cqes);
+        return true;
+    }
+
+    // Submits whatever is queued and optionally waits for completions. Returns 0 or -errno.
+    int enter(int minComplete, unsigned flags) {
+        int rc = TEMP_FAILURE_RETRY(syscall(__NR_io_uring_enter, mFd, mUnsubmitted,
+                minComplete, flags, NULL, 0));
+        if (rc == -1) {
+            return -errno;
+        }
+        mUnsubmitted -= rc;
+        return 0;
+    }
+
+    int mFd;
+    io_uring_params mParams;
+    void* mSqRing;
+    size_t mSqRingSize;
+    void* mCqRing;
+    size_t mCqRingSize;
+    void* mSqes;
+    size_t mSqesSize;
+    unsigned* mSqHead;
+    unsigned* mSqTail;
+    unsigned* mSqMask;
+    unsigned* mSqArray;
+    unsigned* mCqHead;
+    unsigned* mCqTail;
+    unsigned* mCqMask;
+    io_uring_cqe* mCqes;
+    // Per-slot state that must outlive the request: the kernel reads the iovec on its own time.
+    std::vector<iovec> mIovecs;
+    std::vector<jint> mTags;
+    std::vector<int> mFreeSlots;
+    int mInFlight;
+    int mUnsubmitted;
+};
+#endif
+
+static IoQueue* toIoQueue(JNIEnv* env, jint queueAddress) {
+    IoQueue* queue = reinterpret_cast<IoQueue*>(static_cast<uintptr_t>(queueAddress));
+    if (queue == NULL) {
+        jniThrowNullPointerException(env, "queue == null");
+    }
+    return queue;
+}
+
+static jint OSFileSystem_ioQueueOpen(JNIEnv* env, jobject, jint depth) {
+    if (depth <= 0) {
+        jniThrowException(env, "java/lang/IllegalArgumentException", "depth <= 0");
+        return 0;
+    }
+    IoQueue* queue = NULL;
+#ifdef ENABLE_IO_URING
+    queue = UringIoQueue::create(depth);
+#endif
+    if (queue == NULL) {
+        queue = ThreadPoolIoQueue::create(depth);
+    }
+    if (queue == NULL) {
+        jniThrowIOException(env, errno);
+        return 0;
+    }
+    return static_cast<jint>(reinterpret_cast<uintptr_t>(queue));
+}
+
+static jint OSFileSystem_ioQueueSubmit(JNIEnv* env, jobject, jint queueAddress,
+        jintArray javaOps, jintArray javaFds, jlongArray javaOffsets, jintArray javaAddresses,
+        jintArray javaLengths, jintArray javaTags, jint count) {
+    IoQueue* queue = toIoQueue(env, queueAddress);
+    if (queue == NULL) {
+        return -1;
+    }
+    ScopedIntArrayRO ops(env, javaOps);
+    if (ops.get() == NULL) {
+        return -1;
+    }
+    ScopedIntArrayRO fds(env, javaFds);
+    if (fds.get() == NULL) {
+        return -1;
+    }
+    ScopedLongArrayRO offsets(env, javaOffsets);
+    if (offsets.get() == NULL) {
+        return -1;
+    }
+    ScopedIntArrayRO addresses(env, javaAddresses);
+    if (addresses.get() == NULL) {
+        return -1;
+    }
+    ScopedIntArrayRO lengths(env, javaLengths);
+    if (lengths.get() == NULL) {
+        return -1;
+    }
+    ScopedIntArrayRO tags(env, javaTags);
+    if (tags.get() == NULL) {
+        return -1;
+    }
+    size_t n = count;
+    if (count < 0 || ops.size() < n || fds.size() < n || offsets.size() < n
+            || addresses.size() < n || lengths.size() < n || tags.size() < n) {
+        jniThrowException(env, "java/lang/IndexOutOfBoundsException", NULL);
+        return -1;
+    }
+    if (count == 0) {
+        return 0;
+    }
+    UniquePtr<IoRequest[]> requests(new IoRequest[count]);
+    for (int i = 0; i < count; ++i) {
+        if ((ops[i] != IO_READ && ops[i] != IO_WRITE) || offsets[i] < 0 || lengths[i] < 0) {
+            jniThrowException(env, "java/lang/IllegalArgumentException", NULL);
+            return -1;
+        }
+        requests[i].op = ops[i];
+        requests[i].fd = fds[i];
+        requests[i].offset = offsets[i];
+        requests[i].address = reinterpret_cast<void*>(static_cast<uintptr_t>(addresses[i]));
+        requests[i].length = lengths[i];
+        requests[i].tag = tags[i];
+    }
+    int rc = queue->submit(requests.get(), count);
+    if (rc < 0) {
+        jniThrowIOException(env, -rc);
+        return -1;
+    }
+    return rc;
+}
+
+static jint OSFileSystem_ioQueueReap(JNIEnv* env, jobject, jint queueAddress,
+        jintArray javaTags, jlongArray javaResults, jint minComplete) {
+    IoQueue* queue = toIoQueue(env, queueAddress);
+    if (queue == NULL) {
+        return -1;
+    }
+    ScopedIntArrayRW tags(env, javaTags);
+    if (tags.get() == NULL) {
+        return -1;
+    }
+    ScopedLongArrayRW results(env, javaResults);
+    if (results.get() == NULL) {
+        return -1;
+    }
+    int maxCompletions = (tags.size() < results.size()) ? tags.size() : results.size();
+    if (maxCompletions == 0) {
+        return 0;
+    }
+    UniquePtr<IoCompletion[]> completions(new IoCompletion[maxCompletions]);
+    int rc = queue->reap(completions.get(), minComplete, maxCompletions);
+    if (rc < 0) {
+        jniThrowIOException(env, -rc);
+        return -1;
+    }
+    for (int i = 0; i < rc; ++i) {
+        tags[i] = completions[i].tag;
+        results[i] = completions[i].result;
+    }
+    return rc;
+}
+
+static void OSFileSystem_ioQueueClose(JNIEnv*, jobject, jint queueAddress) {
+    delete reinterpret_cast<IoQueue*>(static_cast<uintptr_t>(queueAddress));
+}
+
 static JNINativeMethod gMethods[] = {
+    NATIVE_METHOD(OSFileSystem, advise, "(IJJI)V"),
     NATIVE_METHOD(OSFileSystem, fsync, "(IZ)V"),
     NATIVE_METHOD(OSFileSystem, getAllocGranularity, "()I"),
+    NATIVE_METHOD(OSFileSystem, groupSync, "(IZ)V"),
     NATIVE_METHOD(OSFileSystem, ioctlAvailable, "(Ljava/io/FileDescriptor;)I"),
+    NATIVE_METHOD(OSFileSystem, ioQueueClose, "(I)V"),
+    NATIVE_METHOD(OSFileSystem, ioQueueOpen, "(I)I"),
+    NATIVE_METHOD(OSFileSystem, ioQueueReap, "(I[I[JI)I"),
+    NATIVE_METHOD(OSFileSystem, ioQueueSubmit, "(I[I[I[J[I[I[II)I"),
     NATIVE_METHOD(OSFileSystem, length, "(I)J"),
     NATIVE_METHOD(OSFileSystem, lockImpl, "(IJJIZ)I"),
     NATIVE_METHOD(OSFileSystem, open, "(Ljava/lang/String;I)I"),
     NATIVE_METHOD(OSFileSystem, read, "(I[BII)J"),
+    NATIVE_METHOD(OSFileSystem, readahead, "(IJJ)V"),
     NATIVE_METHOD(OSFileSystem, readDirect, "(IIII)J"),
     NATIVE_METHOD(OSFileSystem, readv, "(I[I[I[II)J"),
+    NATIVE_METHOD(OSFileSystem, relay, "(Ljava/io/FileDescriptor;Ljava/io/FileDescriptor;J)J"),
     NATIVE_METHOD(OSFileSystem, seek, "(IJI)J"),
+    NATIVE_METHOD(OSFileSystem, syncFileRange, "(IJJI)V"),
     NATIVE_METHOD(OSFileSystem, transfer, "(ILjava/io/FileDescriptor;JJ)J"),
+    NATIVE_METHOD(OSFileSystem, transferFile, "(IJIJ)J"),
     NATIVE_METHOD(OSFileSystem, truncate, "(IJ)V"),
     NATIVE_METHOD(OSFileSystem, unlockImpl, "(IJJ)V"),
     NATIVE_METHOD(OSFileSystem, write, "(I[BII)J"),
@@ -25,9 +25,11 @@
 
 #include <byteswap.h>
 #include <errno.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/mman.h>
+#include <vector>
 
 #if defined(__arm__)
 // 32-bit ARM has load/store alignment restrictions for longs.
@@ -39,13 +41,81 @@
 #error unknown load/store alignment restrictions for this architecture
 #endif
 
+// Each Android ABI is built for a known instruction set, so we pick the vector byte-swap
+// kernel at compile time rather than probing the CPU at runtime.
+#if defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define HAVE_NEON_SWAP
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#define HAVE_SSSE3_SWAP
+#endif
+
+// Must match OSMemory.MAP_OPTION_*.
+#define MAP_OPTION_POPULATE   1
+#define MAP_OPTION_HUGE_PAGES 2
+
+// Must match OSMemory.MADVICE_*.
+#define MADVICE_NORMAL     0
+#define MADVICE_RANDOM     1
+#define MADVICE_SEQUENTIAL 2
+#define MADVICE_WILLNEED   3
+#define MADVICE_DONTNEED   4
+
 static jobject runtimeInstance;
 
 template <typename T> static T cast(jint address) {
     return reinterpret_cast<T>(static_cast<uintptr_t>(address));
 }
 
+// Copies and byte-swaps as many whole 16-byte vectors of 'elementSize'-byte elements as
+// 'count' allows, returning the number of elements done. The caller's scalar loop does the rest.
+// Neither pointer needs to be aligned.
+static inline size_t vectorSwap(void* dst, const void* src, size_t count, size_t elementSize) {
+#if defined(HAVE_NEON_SWAP)
+    uint8_t* d = reinterpret_cast<uint8_t*>(dst);
+    const uint8_t* s = reinterpret_cast<const uint8_t*>(src);
+    size_t vectorCount = (count * elementSize) / 16;
+    for (size_t i = 0; i < vectorCount; ++i, d += 16, s += 16) {
+        uint8x16_t v = vld1q_u8(s);
+        if (elementSize == 2) {
+            v = vrev16q_u8(v);
+        } else if (elementSize == 4) {
+            v = vrev32q_u8(v);
+        } else {
+            v = vrev64q_u8(v);
+        }
+        vst1q_u8(d, v);
+    }
+    return vectorCount * 16 / elementSize;
+#elif defined(HAVE_SSSE3_SWAP)
+    __m128i mask;
+    if (elementSize == 2) {
+        mask = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    } else if (elementSize == 4) {
+        mask = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    } else {
+        mask = _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+    }
+    __m128i* d = reinterpret_cast<__m128i*>(dst);
+    const __m128i* s = reinterpret_cast<const __m128i*>(src);
+    size_t vectorCount = (count * elementSize) / 16;
+    for (size_t i = 0; i < vectorCount; ++i) {
+        _mm_storeu_si128(d++, _mm_shuffle_epi8(_mm_loadu_si128(s++), mask));
+    }
+    return vectorCount * 16 / elementSize;
+#else
+    (void) dst; (void) src; (void) count; (void) elementSize;
+    return 0;
+#endif
+}
+
 static inline void swapShorts(jshort* dstShorts, const jshort* srcShorts, size_t count) {
+    size_t done = vectorSwap(dstShorts, srcShorts, count, sizeof(jshort));
+    dstShorts += done;
+    srcShorts += done;
+    count -= done;
+
     // Do 32-bit swaps as long as possible...
     jint* dst = reinterpret_cast<jint*>(dstShorts);
     const jint* src = reinterpret_cast<const jint*>(srcShorts);
@@ -63,6 +133,11 @@ static inline void swapShorts(jshort* dstShorts, const jshort* srcShorts, size_t
 }
 
 static inline void swapInts(jint* dstInts, const jint* srcInts, size_t count) {
+    size_t done = vectorSwap(dstInts, srcInts, count, sizeof(jint));
+    dstInts += done;
+    srcInts += done;
+    count -= done;
+
     for (size_t i = 0; i < count; ++i) {
         jint v = *srcInts++;
         *dstInts++ = bswap_32(v);
@@ -70,6 +145,11 @@ static inline void swapInts(jint* dstInts, const jint* srcInts, size_t count) {
 }
 
 static inline void swapLongs(jlong* dstLongs, const jlong* srcLongs, size_t count) {
+    size_t done = vectorSwap(dstLongs, srcLongs, count, sizeof(jlong));
+    dstLongs += done;
+    srcLongs += done;
+    count -= done;
+
     jint* dst = reinterpret_cast<jint*>(dstLongs);
     const jint* src = reinterpret_cast<const jint*>(srcLongs);
     for (size_t i = 0; i < count; ++i) {
@@ -80,6 +160,201 @@ static inline void swapLongs(jlong* dstLongs, const jlong* srcLongs, size_t coun
     }
 }
 
+// An optional pool of recycled OSMemory_malloc blocks, for callers that churn through
+// short-lived direct buffers. Blocks come in power-of-two size classes from 1KiB to 64KiB.
+// Each thread keeps a few blocks of each class for itself so the common case takes no
+// lock; beyond that, blocks go to a shared pool. The pool holds at most (roughly, since
+// the check is racy) gPoolMaxBytes, and is off when that's 0, as it is by default.
+// Switching it off bumps gPoolGeneration; each thread frees the blocks it cached under an
+// older generation the next time it allocates or frees, or when it exits.
+static const int kPoolMinShift = 10;
+static const int kPoolClassCount = 7;
+static const int kThreadCacheDepth = 4;
+
+struct PoolStats {
+    unsigned long hits;
+    unsigned long misses;
+    long bytesHeld;
+};
+static PoolStats gPoolStats;
+static volatile long gPoolMaxBytes = 0;
+static volatile int gPoolGeneration = 0;
+static pthread_mutex_t gPoolMutex = PTHREAD_MUTEX_INITIALIZER;
+static std::vector<void*> gPool[kPoolClassCount];
+
+struct ThreadCache {
+    int generation;
+    int count[kPoolClassCount];
+    void* blocks[kPoolClassCount][kThreadCacheDepth];
+};
+static pthread_key_t gThreadCacheKey;
+static pthread_once_t gThreadCacheKeyOnce = PTHREAD_ONCE_INIT;
+
+static size_t poolClassBytes(int sizeClass) {
+    return static_cast<size_t>(1) << (kPoolMinShift + sizeClass);
+}
+
+// Returns the size class for a 'size'-byte allocation, or -1 if it's too small to be
+// worth rounding up, or too big to keep around.
+static int poolSizeClass(jint size) {
+    if (size <= (1 << (kPoolMinShift - 1)) ||
+            static_cast<size_t>(size) > poolClassBytes(kPoolClassCount - 1)) {
+        return -1;
+    }
+    int sizeClass = 0;
+    while (poolClassBytes(sizeClass) < static_cast<size_t>(size)) {
+        ++sizeClass;
+    }
+    return sizeClass;
+}
+
+static void destroyThreadCache(void* value) {
+    ThreadCache* cache = reinterpret_cast<ThreadCache*>(value);
+    // These blocks are already accounted for in bytesHeld, so they go to the shared pool
+    // unless the pool has been switched off in the meantime.
+    pthread_mutex_lock(&gPoolMutex);
+    for (int c = 0; c < kPoolClassCount; ++c) {
+        for (int i = 0; i < cache->count[c]; ++i) {
+            if (gPoolMaxBytes != 0) {
+                gPool[c].push_back(cache->blocks[c][i]);
+            } else {
+                __sync_fetch_and_sub(&gPoolStats.bytesHeld, poolClassBytes(c));
+                free(cache->blocks[c][i]);
+            }
+        }
+    }
+    pthread_mutex_unlock(&gPoolMutex);
+    delete cache;
+}
+
+static void createThreadCacheKey() {
+    pthread_key_create(&gThreadCacheKey, destroyThreadCache);
+}
+
+// Frees the blocks in 'cache' if the pool has been switched off since they were cached.
+static void drainIfStale(ThreadCache* cache) {
+    int generation = gPoolGeneration;
+    if (cache->generation == generation) {
+        return;
+    }
+    for (int c = 0; c < kPoolClassCount; ++c) {
+        for (int i = 0; i < cache->count[c]; ++i) {
+            __sync_fetch_and_sub(&gPoolStats.bytesHeld, poolClassBytes(c));
+            free(cache->blocks[c][i]);
+        }
+        cache->count[c] = 0;
+    }
+    cache->generation = generation;
+}
+
+// Returns this thread's cache, creating it if necessary, or NULL if that's impossible.
+static ThreadCache* getThreadCache() {
+    pthread_once(&gThreadCacheKeyOnce, createThreadCacheKey);
+    ThreadCache* cache = reinterpret_cast<ThreadCache*>(pthread_getspecific(gThreadCacheKey));
+    if (cache == NULL) {
+        cache = new ThreadCache;
+        memset(cache, 0, sizeof(*cache));
+        cache->generation = gPoolGeneration;
+        pthread_setspecific(gThreadCacheKey, cache);
+    } else {
+        drainIfStale(cache);
+    }
+    return cache;
+}
+
+// Called on the allocation paths that bypass the pool while it's off, so that a thread's
+// cached blocks don't wait for the thread to exit. Doesn't create a cache, and costs nothing
+// if the pool has never been switched off after being on.
+static void drainThreadCache() {
+    if (gPoolGeneration == 0) {
+        return;
+    }
+    pthread_once(&gThreadCacheKeyOnce, createThreadCacheKey);
+    ThreadCache* cache = reinterpret_cast<ThreadCache*>(pthread_getspecific(gThreadCacheKey));
+    if (cache != NULL) {
+        drainIfStale(cache);
+    }
+}
+
+// Returns a recycled block of the given class (with a header's worth of extra space), or NULL.
+static void* poolTake(int sizeClass) {
+    void* block = NULL;
+    ThreadCache* cache = getThreadCache();
+    if (cache->count[sizeClass] > 0) {
+        block = cache->blocks[sizeClass][--cache->count[sizeClass]];
+    } else {
+        pthread_mutex_lock(&gPoolMutex);
+        if (!gPool[sizeClass].empty()) {
+            block = gPool[sizeClass].back();
+            gPool[sizeClass].pop_back();
+        }
+        pthread_mutex_unlock(&gPoolMutex);
+    }
+    if (block != NULL) {
+        __sync_fetch_and_add(&gPoolStats.hits, 1);
+        __sync_fetch_and_sub(&gPoolStats.bytesHeld, poolClassBytes(sizeClass));
+    } else {
+        __sync_fetch_and_add(&gPoolStats.misses, 1);
+    }
+    return block;
+}
+
+// Keeps 'block' for reuse if there's room. Returns false if the caller should free it.
+static bool poolGive(int sizeClass, void* block) {
+    long classBytes = poolClassBytes(sizeClass);
+    if (gPoolStats.bytesHeld + classBytes > gPoolMaxBytes) {
+        return false;
+    }
+    __sync_fetch_and_add(&gPoolStats.bytesHeld, classBytes);
+    ThreadCache* cache = getThreadCache();
+    if (cache->count[sizeClass] < kThreadCacheDepth) {
+        cache->blocks[sizeClass][cache->count[sizeClass]++] = block;
+    } else {
+        pthread_mutex_lock(&gPoolMutex);
+        gPool[sizeClass].push_back(block);
+        pthread_mutex_unlock(&gPoolMutex);
+    }
+    return true;
+}
+
+static void OSMemory_setPoolLimit(JNIEnv* env, jclass, jint maxBytes) {
+    if (maxBytes < 0) {
+        jniThrowException(env, "java/lang/IllegalArgumentException", "maxBytes < 0");
+        return;
+    }
+    long oldMaxBytes = gPoolMaxBytes;
+    gPoolMaxBytes = maxBytes;
+    if (maxBytes == 0) {
+        // Release the shared pool now. Other threads' caches can only be touched by their
+        // own threads, so tell them to drain; this thread's goes straight away.
+        if (oldMaxBytes != 0) {
+            __sync_fetch_and_add(&gPoolGeneration, 1);
+        }
+        drainThreadCache();
+        pthread_mutex_lock(&gPoolMutex);
+        for (int c = 0; c < kPoolClassCount; ++c) {
+            for (size_t i = 0; i < gPool[c].size(); ++i) {
+                free(gPool[c][i]);
+            }
+            __sync_fetch_and_sub(&gPoolStats.bytesHeld, gPool[c].size() * poolClassBytes(c));
+            gPool[c].clear();
+        }
+        pthread_mutex_unlock(&gPoolMutex);
+    }
+}
+
+static jlongArray OSMemory_getPoolStats(JNIEnv* env, jclass) {
+    jlong stats[3];
+    stats[0] = gPoolStats.hits;
+    stats[1] = gPoolStats.misses;
+    stats[2] = gPoolStats.bytesHeld;
+    jlongArray result = env->NewLongArray(3);
+    if (result != NULL) {
+        env->SetLongArrayRegion(result, 0, 3, stats);
+    }
+    return result;
+}
+
 static jint OSMemory_malloc(JNIEnv* env, jclass, jint size) {
     static jmethodID trackExternalAllocationMethod =
             env->GetMethodID(JniConstants::vmRuntimeClass, "trackExternalAllocation", "(J)Z");
@@ -94,16 +369,70 @@ static jint OSMemory_malloc(JNIEnv* env, jclass, jint size) {
 
     // Our only caller wants zero-initialized memory.
     // calloc(3) may be faster than malloc(3) followed by memset(3).
-    void* block = calloc(size + sizeof(jlong), 1);
+    int sizeClass = (gPoolMaxBytes != 0) ? poolSizeClass(size) : -1;
+    if (gPoolMaxBytes == 0) {
+        drainThreadCache();
+    }
+    void* block;
+    if (sizeClass != -1) {
+        // Pooled blocks are always a whole size class, so they can be recycled for any
+        // allocation in that class.
+        block = poolTake(sizeClass);
+        if (block != NULL) {
+            memset(reinterpret_cast<jlong*>(block) + 1, 0, size);
+        } else {
+            block = calloc(poolClassBytes(sizeClass) + sizeof(jlong), 1);
+        }
+    } else {
+        block = calloc(size + sizeof(jlong), 1);
+    }
     if (block == NULL) {
         jniThrowException(env, "java/lang/OutOfMemoryError", NULL);
         return 0;
     }
 
     // Tuck a copy of the size at the head of the buffer.  We need this
-    // so OSMemory_free() knows how much memory is being freed.
+    // so OSMemory_free() knows how much memory is being freed. Pooled
+    // blocks also record their size class (plus one) in the high word.
     jlong* result = reinterpret_cast<jlong*>(block);
-    *result++ = size;
+    *result++ = (static_cast<jlong>(sizeClass + 1) << 32) | size;
+    return static_cast<jint>(reinterpret_cast<uintptr_t>(result));
+}
+
+/**
+ * Like OSMemory_malloc, but the result is a multiple of 'alignment', for O_DIRECT I/O.
+ * The block is laid out as padding, the address of the underlying allocation, and the
+ * complemented size (which is negative, so OSMemory_free can tell the two kinds apart).
+ */
+static jint OSMemory_mallocAligned(JNIEnv* env, jclass, jint size, jint alignment) {
+    if (size < 0 || alignment < static_cast<jint>(2 * sizeof(jlong))
+            || (alignment & (alignment - 1)) != 0) {
+        jniThrowException(env, "java/lang/IllegalArgumentException",
+                "alignment must be a power of two >= 16");
+        return 0;
+    }
+
+    static jmethodID trackExternalAllocationMethod =
+            env->GetMethodID(JniConstants::vmRuntimeClass, "trackExternalAllocation", "(J)Z");
+    jboolean allowed = env->CallBooleanMethod(runtimeInstance, trackExternalAllocationMethod,
+            static_cast<jlong>(size));
+    if (!allowed) {
+        ALOGW("External allocation of %d bytes was rejected\n", size);
+        jniThrowException(env, "java/lang/OutOfMemoryError", NULL);
+        return 0;
+    }
+
+    // One extra 'alignment' at the front holds our two header words.
+    void* block = NULL;
+    if (posix_memalign(&block, alignment, alignment + size) != 0) {
+        jniThrowException(env, "java/lang/OutOfMemoryError", NULL);
+        return 0;
+    }
+    memset(block, 0, alignment + size);
+
+    jlong* result = reinterpret_cast<jlong*>(reinterpret_cast<char*>(block) + alignment);
+    result[-2] = static_cast<jlong>(reinterpret_cast<uintptr_t>(block));
+    result[-1] = ~static_cast<jlong>(size);
     return static_cast<jint>(reinterpret_cast<uintptr_t>(result));
 }
 
@@ -113,8 +442,24 @@ static void OSMemory_free(JNIEnv* env, jclass, jint address) {
 
     jlong* p = reinterpret_cast<jlong*>(static_cast<uintptr_t>(address));
     jlong size = *--p;
+    void* block = p;
+    int sizeClass = -1;
+    if (size < 0) {
+        // From OSMemory_mallocAligned.
+        size = ~size;
+        block = reinterpret_cast<void*>(static_cast<uintptr_t>(p[-1]));
+    } else if ((size >> 32) != 0) {
+        // A pooled block.
+        sizeClass = static_cast<int>(size >> 32) - 1;
+        size &= 0xffffffff;
+    }
     env->CallVoidMethod(runtimeInstance, trackExternalFreeMethod, size);
-    free(reinterpret_cast<void*>(p));
+    if (gPoolMaxBytes == 0) {
+        drainThreadCache();
+    }
+    if (sizeClass == -1 || !poolGive(sizeClass, block)) {
+        free(block);
+    }
 }
 
 static void OSMemory_memmove(JNIEnv*, jclass, jint dstAddress, jint srcAddress, jlong length) {
@@ -131,14 +476,14 @@ static void OSMemory_peekByteArray(JNIEnv* env, jclass, jint srcAddress, jbyteAr
 
 // Implements the peekXArray methods:
 // - For unswapped access, we just use the JNI SetXArrayRegion functions.
-// - For swapped access, we use GetXArrayElements and our own copy-and-swap routines.
-//   GetXArrayElements is disproportionately cheap on Dalvik because it doesn't copy (as opposed
-//   to Hotspot, which always copies). The SWAP_FN copies and swaps in one pass, which is cheaper
-//   than copying and then swapping in a second pass. Depending on future VM/GC changes, the
-//   swapped case might need to be revisited.
+// - For swapped access, we take a critical region on the array and use our own copy-and-swap
+//   routines. Unlike GetXArrayElements, which Hotspot implements by copying the whole array,
+//   GetPrimitiveArrayCritical gives direct access wherever the VM can, so we touch only the
+//   elements we swap. The SWAP_FN copies and swaps in one pass, which is cheaper than copying
+//   and then swapping in a second pass, and makes no JNI calls, as the region requires.
 #define PEEKER(SCALAR_TYPE, JNI_NAME, SWAP_TYPE, SWAP_FN) { \
     if (swap) { \
-        Scoped ## JNI_NAME ## ArrayRW elements(env, dst); \
+        Scoped ## JNI_NAME ## ArrayCriticalRW elements(env, dst); \
         if (elements.get() == NULL) { \
             return; \
         } \
@@ -184,14 +529,14 @@ static void OSMemory_pokeByteArray(JNIEnv* env, jclass, jint dstAddress, jbyteAr
 
 // Implements the pokeXArray methods:
 // - For unswapped access, we just use the JNI GetXArrayRegion functions.
-// - For swapped access, we use GetXArrayElements and our own copy-and-swap routines.
-//   GetXArrayElements is disproportionately cheap on Dalvik because it doesn't copy (as opposed
-//   to Hotspot, which always copies). The SWAP_FN copies and swaps in one pass, which is cheaper
-//   than copying and then swapping in a second pass. Depending on future VM/GC changes, the
-//   swapped case might need to be revisited.
+// - For swapped access, we take a critical region on the array and use our own copy-and-swap
+//   routines. Unlike GetXArrayElements, which Hotspot implements by copying the whole array,
+//   GetPrimitiveArrayCritical gives direct access wherever the VM can, so we touch only the
+//   elements we swap. The SWAP_FN copies and swaps in one pass, which is cheaper than copying
+//   and then swapping in a second pass, and makes no JNI calls, as the region requires.
 #define POKER(SCALAR_TYPE, JNI_NAME, SWAP_TYPE, SWAP_FN) { \
     if (swap) { \
-        Scoped ## JNI_NAME ## ArrayRO elements(env, src); \
+        Scoped ## JNI_NAME ## ArrayCriticalRO elements(env, src); \
         if (elements.get() == NULL) { \
             return; \
         } \
@@ -300,7 +645,8 @@ static void OSMemory_pokeLong(JNIEnv*, jclass, jint dstAddress, jlong value, jbo
     }
 }
 
-static jint OSMemory_mmapImpl(JNIEnv* env, jclass, jint fd, jlong offset, jlong size, jint mapMode) {
+static jint OSMemory_mmapImpl(JNIEnv* env, jclass, jint fd, jlong offset, jlong size,
+        jint mapMode, jint options) {
     int prot, flags;
     switch (mapMode) {
     case 0: // MapMode.PRIVATE
@@ -321,10 +667,27 @@ static jint OSMemory_mmapImpl(JNIEnv* env, jclass, jint fd, jlong offset, jlong
         return -1;
     }
 
+#ifdef MAP_POPULATE
+    // Prefault the whole mapping now rather than take a fault on each first touch.
+    if ((options & MAP_OPTION_POPULATE) != 0) {
+        flags |= MAP_POPULATE;
+    }
+#endif
+
     void* mapAddress = mmap(0, size, prot, flags, fd, offset);
     if (mapAddress == MAP_FAILED) {
         jniThrowIOException(env, errno);
+        return -1;
     }
+#ifdef MADV_HUGEPAGE
+    // Only a hint: kernels without transparent huge pages (or without them for this kind of
+    // mapping) refuse, and the mapping works regardless.
+    if ((options & MAP_OPTION_HUGE_PAGES) != 0) {
+        madvise(mapAddress, size, MADV_HUGEPAGE);
+    }
+#else
+    (void) options;
+#endif
     return reinterpret_cast<uintptr_t>(mapAddress);
 }
 
@@ -332,6 +695,33 @@ static void OSMemory_munmap(JNIEnv*, jclass, jint address, jlong size) {
     munmap(cast<void*>(address), size);
 }
 
+static void OSMemory_madvise(JNIEnv* env, jclass, jint address, jlong size, jint advice) {
+    int nativeAdvice;
+    switch (advice) {
+    case MADVICE_NORMAL: nativeAdvice = MADV_NORMAL; break;
+    case MADVICE_RANDOM: nativeAdvice = MADV_RANDOM; break;
+    case MADVICE_SEQUENTIAL: nativeAdvice = MADV_SEQUENTIAL; break;
+    case MADVICE_WILLNEED: nativeAdvice = MADV_WILLNEED; break;
+    case MADVICE_DONTNEED: nativeAdvice = MADV_DONTNEED; break;
+    default:
+        jniThrowException(env, "java/lang/IllegalArgumentException", "unknown advice");
+        return;
+    }
+    if (size == 0) {
+        return;
+    }
+
+    // madvise(2) wants a page-aligned start, but callers think in terms of byte ranges.
+    static int page_size = getpagesize();
+    int align_offset = address % page_size;
+    address -= align_offset;
+    size += align_offset;
+
+    if (madvise(cast<void*>(address), size, nativeAdvice) == -1) {
+        jniThrowIOException(env, errno);
+    }
+}
+
 static void OSMemory_load(JNIEnv*, jclass, jint address, jlong size) {
     if (mlock(cast<void*>(address), size) != -1) {
         munlock(cast<void*>(address), size);
@@ -392,7 +782,12 @@ static void unsafeBulkCopy(jbyte* dst, const jbyte* src, jint byteCount,
 
 static void OSMemory_unsafeBulkGet(JNIEnv* env, jclass, jobject dstObject, jint dstOffset,
         jint byteCount, jbyteArray srcArray, jint srcOffset, jint sizeofElement, jboolean swap) {
-    ScopedByteArrayRO srcBytes(env, srcArray);
+    // Nothing may throw once we're inside srcBytes' critical region.
+    if (dstObject == NULL) {
+        jniThrowNullPointerException(env, NULL);
+        return;
+    }
+    ScopedByteArrayCriticalRO srcBytes(env, srcArray);
     if (srcBytes.get() == NULL) {
         return;
     }
@@ -409,7 +804,12 @@ static void OSMemory_unsafeBulkGet(JNIEnv* env, jclass, jobject dstObject, jint
 
 static void OSMemory_unsafeBulkPut(JNIEnv* env, jclass, jbyteArray dstArray, jint dstOffset,
         jint byteCount, jobject srcObject, jint srcOffset, jint sizeofElement, jboolean swap) {
-    ScopedByteArrayRW dstBytes(env, dstArray);
+    // Nothing may throw once we're inside dstBytes' critical region.
+    if (srcObject == NULL) {
+        jniThrowNullPointerException(env, NULL);
+        return;
+    }
+    ScopedByteArrayCriticalRW dstBytes(env, dstArray);
     if (dstBytes.get() == NULL) {
         return;
     }
@@ -426,11 +826,14 @@ static void OSMemory_unsafeBulkPut(JNIEnv* env, jclass, jbyteArray dstArray, jin
 
 static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(OSMemory, free, "(I)V"),
+    NATIVE_METHOD(OSMemory, getPoolStats, "()[J"),
     NATIVE_METHOD(OSMemory, isLoaded, "(IJ)Z"),
     NATIVE_METHOD(OSMemory, load, "(IJ)V"),
     NATIVE_METHOD(OSMemory, malloc, "(I)I"),
+    NATIVE_METHOD(OSMemory, mallocAligned, "(II)I"),
     NATIVE_METHOD(OSMemory, memmove, "(IIJ)V"),
-    NATIVE_METHOD(OSMemory, mmapImpl, "(IJJI)I"),
+    NATIVE_METHOD(OSMemory, madvise, "(IJI)V"),
+    NATIVE_METHOD(OSMemory, mmapImpl, "(IJJII)I"),
     NATIVE_METHOD(OSMemory, msync, "(IJ)V"),
     NATIVE_METHOD(OSMemory, munmap, "(IJ)V"),
     NATIVE_METHOD(OSMemory, peekByte, "(I)B"),
@@ -455,6 +858,7 @@ static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(OSMemory, pokeLongArray, "(I[JIIZ)V"),
     NATIVE_METHOD(OSMemory, pokeShort, "(ISZ)V"),
     NATIVE_METHOD(OSMemory, pokeShortArray, "(I[SIIZ)V"),
+    NATIVE_METHOD(OSMemory, setPoolLimit, "(I)V"),
     NATIVE_METHOD(OSMemory, unsafeBulkGet, "(Ljava/lang/Object;II[BIIZ)V"),
     NATIVE_METHOD(OSMemory, unsafeBulkPut, "([BIILjava/lang/Object;IIZ)V"),
 };
@@ -23,24 +23,38 @@
 #include "LocalArray.h"
 #include "NetFd.h"
 #include "NetworkUtilities.h"
+#include "ScopedPthreadMutexLock.h"
 #include "ScopedPrimitiveArray.h"
+#include "UniquePtr.h"
 #include "jni.h"
 #include "valueOf.h"
 
 #include <arpa/inet.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
 #include <netdb.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <poll.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/time.h>
+#include <sys/uio.h>
 #include <sys/un.h>
+#include <time.h>
 #include <unistd.h>
 
+#include <map>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
 // Temporary hack to build on systems that don't have up-to-date libc headers.
 #ifndef IPV6_TCLASS
 #ifdef __linux__
@@ -58,6 +72,15 @@
 #define ENABLE_MULTICAST
 #endif
 
+/*
+ * epoll(7) is Linux-only. Elsewhere the epoll* natives throw
+ * UnsupportedOperationException and callers must stick to selectImpl.
+ */
+#ifdef __linux__
+#define ENABLE_EPOLL
+#include <sys/epoll.h>
+#endif
+
 #define JAVASOCKOPT_IP_MULTICAST_IF 16
 #define JAVASOCKOPT_IP_MULTICAST_IF2 31
 #define JAVASOCKOPT_IP_MULTICAST_LOOP 18
@@ -75,6 +98,33 @@
 #define JAVASOCKOPT_SO_SNDBUF 4097
 #define JAVASOCKOPT_TCP_NODELAY 1
 
+// TCP Fast Open (Linux 3.6 and later). Older libc headers don't know about it, and
+// elsewhere we always fall back to an ordinary connect.
+#if defined(__linux__) && !defined(MSG_FASTOPEN)
+#define MSG_FASTOPEN 0x20000000
+#endif
+#ifndef MSG_FASTOPEN
+#define MSG_FASTOPEN 0
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+// MSG_MORE is Linux-only; elsewhere the hint is simply ignored.
+#ifndef MSG_MORE
+#define MSG_MORE 0
+#endif
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+// Older libc headers don't know about recvmmsg(2)'s flag.
+#ifndef MSG_WAITFORONE
+#define MSG_WAITFORONE 0x10000
+#endif
+
 /* constants for OSNetworkSystem_selectImpl */
 #define SOCKET_OP_NONE 0
 #define SOCKET_OP_READ 1
@@ -222,23 +272,133 @@ static long toMs(const timeval& tv) {
     return tv.tv_sec * 1000 + tv.tv_usec / 1000;
 }
 
+// Returns the current time in milliseconds, from a clock that isn't affected by changes
+// to the wall clock.
+static int64_t monotonicMs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+/*
+ * Optional socket I/O statistics. When disabled (the default), each instrumented call pays
+ * for one load of gSocketStatsEnabled. When enabled, each call's elapsed time, result and
+ * errno are folded into counters and a log2-bucketed latency histogram for the call's fd and
+ * operation, which getSocketStats snapshots for Java.
+ */
+enum SocketStatsOp {
+    SOCKET_STATS_READ,
+    SOCKET_STATS_WRITE,
+    SOCKET_STATS_RECV,
+    SOCKET_STATS_SEND,
+    SOCKET_STATS_ACCEPT,
+    SOCKET_STATS_CONNECT,
+    SOCKET_STATS_OP_COUNT
+};
+
+// Bucket i counts calls that took less than 2^i microseconds (but not less than 2^(i-1)).
+static const int SOCKET_STATS_BUCKET_COUNT = 32;
+
+struct SocketOpStats {
+    int64_t calls;
+    int64_t bytes;
+    int64_t wouldBlock;
+    int64_t errors;
+    int64_t histogram[SOCKET_STATS_BUCKET_COUNT];
+};
+
+struct SocketFdStats {
+    SocketOpStats ops[SOCKET_STATS_OP_COUNT];
+};
+
+// The number of jlongs per fd in the array returned by getSocketStats: the fd, then each
+// operation's counters.
+static const size_t SOCKET_STATS_LONGS_PER_FD = 1 + sizeof(SocketFdStats) / sizeof(int64_t);
+
+static volatile bool gSocketStatsEnabled = false;
+static pthread_mutex_t gSocketStatsMutex = PTHREAD_MUTEX_INITIALIZER;
+// Keyed by fd. An fd's entry outlives the socket, so that a snapshot still sees sockets that
+// have since been closed; a later socket given the same fd adds to the same entry.
+static std::map<int, SocketFdStats> gSocketStats;
+
+static int64_t monotonicUs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+// Returns the start time to pass to recordSocketStats, or 0 if statistics are disabled.
+static inline int64_t socketStatsStart() {
+    return gSocketStatsEnabled ? monotonicUs() : 0;
+}
+
+// Records the outcome of a call on 'fd' made at 'start' that returned 'result' (with errno
+// set if 'result' is -1). Preserves errno.
+static void recordSocketStats(int fd, SocketStatsOp op, int64_t start, ssize_t result) {
+    if (start == 0) {
+        return;
+    }
+    const int savedErrno = errno;
+    int64_t elapsed = monotonicUs() - start;
+    int bucket = 0;
+    while (elapsed > 0 && bucket < SOCKET_STATS_BUCKET_COUNT - 1) {
+        elapsed >>= 1;
+        ++bucket;
+    }
+    {
+        ScopedPthreadMutexLock lock(&gSocketStatsMutex);
+        std::map<int, SocketFdStats>::iterator it = gSocketStats.find(fd);
+        if (it == gSocketStats.end()) {
+            SocketFdStats empty;
+            memset(&empty, 0, sizeof(empty));
+            it = gSocketStats.insert(std::make_pair(fd, empty)).first;
+        }
+        SocketOpStats& stats(it->second.ops[op]);
+        ++stats.calls;
+        ++stats.histogram[bucket];
+        if (result >= 0) {
+            stats.bytes += result;
+        } else if (savedErrno == EAGAIN || savedErrno == EWOULDBLOCK) {
+            ++stats.wouldBlock;
+        } else {
+            ++stats.errors;
+        }
+    }
+    errno = savedErrno;
+}
+
+static void OSNetworkSystem_setSocketStatsEnabled(JNIEnv*, jobject, jboolean enabled) {
+    gSocketStatsEnabled = enabled;
+}
+
 /**
- * Query OS for timestamp.
- * Retrieve the current value of system clock and convert to milliseconds.
- *
- * @param[in] portLibrary The port library.
- *
- * @return 0 on failure, time value in milliseconds on success.
- * @deprecated Use @ref time_hires_clock and @ref time_hires_delta
- *
- * technically, this should return uint64_t since both timeval.tv_sec and
- * timeval.tv_usec are long
+ * Returns a snapshot of the socket statistics. For each fd with statistics, in ascending
+ * order, the array holds the fd and then, for each operation (read, write, recv, send, accept,
+ * connect) in turn, the call count, byte count, EAGAIN count, other error count, and
+ * SOCKET_STATS_BUCKET_COUNT latency histogram buckets. Optionally resets the statistics.
  */
-static int time_msec_clock() {
-    timeval tp;
-    struct timezone tzp;
-    gettimeofday(&tp, &tzp);
-    return toMs(tp);
+static jlongArray OSNetworkSystem_getSocketStats(JNIEnv* env, jobject, jboolean reset) {
+    std::vector<jlong> snapshot;
+    {
+        ScopedPthreadMutexLock lock(&gSocketStatsMutex);
+        snapshot.reserve(gSocketStats.size() * SOCKET_STATS_LONGS_PER_FD);
+        for (std::map<int, SocketFdStats>::const_iterator it = gSocketStats.begin();
+                it != gSocketStats.end(); ++it) {
+            snapshot.push_back(it->first);
+            const jlong* counters = reinterpret_cast<const jlong*>(&it->second);
+            snapshot.insert(snapshot.end(), counters,
+                    counters + SOCKET_STATS_LONGS_PER_FD - 1);
+        }
+        if (reset) {
+            gSocketStats.clear();
+        }
+    }
+    jlongArray result = env->NewLongArray(snapshot.size());
+    if (result == NULL || snapshot.empty()) {
+        return result;
+    }
+    env->SetLongArrayRegion(result, 0, snapshot.size(), &snapshot[0]);
+    return result;
 }
 
 /**
@@ -259,6 +419,17 @@ public:
     }
 
     int start(NetFd& fd, jobject inetAddr, jint port) {
+        return startWithData(fd, inetAddr, port, NULL, 0, NULL);
+    }
+
+    // Like start, but where the kernel supports TCP Fast Open, sends up to 'count' bytes of
+    // 'data' in the SYN. '*bytesSent' is set to the number of bytes of 'data' accepted by the
+    // kernel, which may be 0; the caller must send the rest once connected.
+    int startWithData(NetFd& fd, jobject inetAddr, jint port,
+            const jbyte* data, size_t count, ssize_t* bytesSent) {
+        if (bytesSent != NULL) {
+            *bytesSent = 0;
+        }
         sockaddr_storage ss;
         if (!inetAddressToSocketAddress(mEnv, inetAddr, port, &ss)) {
             return -EINVAL; // Bogus, but clearly a failure, and we've already thrown.
@@ -266,15 +437,26 @@ public:
 
         // Set the socket to non-blocking and initiate a connection attempt...
         const CompatibleSocketAddress compatibleAddress(fd.get(), ss, true);
-        if (!setBlocking(fd.get(), false) ||
-                connect(fd.get(), compatibleAddress.get(), sizeof(sockaddr_storage)) == -1) {
-            if (fd.isClosed()) {
-                return -EINVAL; // Bogus, but clearly a failure, and we've already thrown.
+        if (!setBlocking(fd.get(), false)) {
+            return failedToStart(fd);
+        }
+        if (MSG_FASTOPEN != 0 && data != NULL && count > 0) {
+            ssize_t rc = sendto(fd.get(), data, count, MSG_FASTOPEN | MSG_NOSIGNAL,
+                    compatibleAddress.get(), sizeof(sockaddr_storage));
+            if (rc >= 0) {
+                // The data went in the SYN, but the handshake is still under way.
+                *bytesSent = rc;
+                return -EINPROGRESS;
             }
-            if (errno != EINPROGRESS) {
-                didFail(fd.get(), -errno);
+            // EINPROGRESS means we had no cookie for this peer, so a plain SYN (asking for
+            // one) has gone out. Kernels without client-side Fast Open fail with one of the
+            // errors below, and we fall back to connect(2).
+            if (errno != EOPNOTSUPP && errno != ENOTCONN && errno != EPIPE) {
+                return failedToStart(fd);
             }
-            return -errno;
+        }
+        if (connect(fd.get(), compatibleAddress.get(), sizeof(sockaddr_storage)) == -1) {
+            return failedToStart(fd);
         }
         // We connected straight away!
         didConnect(fd.get());
@@ -283,47 +465,44 @@ public:
 
     // Returns 0 if we're connected; -EINPROGRESS if we're still hopeful, -errno if we've failed.
     // 'timeout' the timeout in milliseconds. If timeout is negative, perform a blocking operation.
+    // Unlike select(2), poll(2) works for any fd, and is trivially retried after EINTR.
     int isConnected(int fd, int timeout) {
-        timeval passedTimeout(toTimeval(timeout));
-
-        // Initialize the fd sets for the select.
-        fd_set readSet;
-        fd_set writeSet;
-        FD_ZERO(&readSet);
-        FD_ZERO(&writeSet);
-        FD_SET(fd, &readSet);
-        FD_SET(fd, &writeSet);
-
-        int nfds = fd + 1;
-        timeval* tp = timeout >= 0 ? &passedTimeout : NULL;
-        int rc = select(nfds, &readSet, &writeSet, NULL, tp);
+        const int64_t deadline = monotonicMs() + timeout;
+        pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLOUT;
+        int rc;
+        {
+            AsynchronousSocketCloseMonitor monitor(fd);
+            do {
+                pfd.revents = 0;
+                int remaining = timeout;
+                if (timeout > 0) {
+                    int64_t now = monotonicMs();
+                    remaining = (now < deadline) ? static_cast<int>(deadline - now) : 0;
+                }
+                rc = poll(&pfd, 1, remaining);
+            } while (rc == -1 && errno == EINTR);
+        }
         if (rc == -1) {
-            if (errno == EINTR) {
-                // We can't trivially retry a select with TEMP_FAILURE_RETRY, so punt and ask the
-                // caller to try again.
-                return -EINPROGRESS;
-            }
             return -errno;
         }
-
-        // If the fd is just in the write set, we're connected.
-        if (FD_ISSET(fd, &writeSet) && !FD_ISSET(fd, &readSet)) {
-            return 0;
+        if (rc == 0) {
+            // Timeout expired.
+            return -EINPROGRESS;
         }
-
-        // If the fd is in both the read and write set, there was an error.
-        if (FD_ISSET(fd, &readSet) || FD_ISSET(fd, &writeSet)) {
-            // Get the pending error.
-            int error = 0;
-            socklen_t errorLen = sizeof(error);
-            if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &errorLen) == -1) {
-                return -errno; // Couldn't get the real error, so report why not.
-            }
-            return -error;
+        if ((pfd.revents & POLLNVAL) != 0) {
+            // Someone closed the socket under us.
+            return -EBADF;
         }
 
-        // Timeout expired.
-        return -EINPROGRESS;
+        // The connect has finished one way or the other, so get the pending error (if any).
+        int error = 0;
+        socklen_t errorLen = sizeof(error);
+        if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &errorLen) == -1) {
+            return -errno; // Couldn't get the real error, so report why not.
+        }
+        return -error;
     }
 
     void didConnect(int fd) {
@@ -350,6 +529,18 @@ public:
     }
 
 private:
+    // Reports a failure to start connecting (or the expected EINPROGRESS) from errno.
+    int failedToStart(NetFd& fd) {
+        const int error = errno;
+        if (fd.isClosed()) {
+            return -EINVAL; // Bogus, but clearly a failure, and we've already thrown.
+        }
+        if (error != EINPROGRESS) {
+            didFail(fd.get(), -error);
+        }
+        return -error;
+    }
+
     JNIEnv* mEnv;
 };
 
@@ -470,10 +661,12 @@ static jint OSNetworkSystem_writeDirect(JNIEnv* env, jobject,
     jbyte* src = reinterpret_cast<jbyte*>(static_cast<uintptr_t>(address + offset));
 
     ssize_t bytesSent;
+    const int64_t statsStart = socketStatsStart();
     {
         int intFd = fd.get();
         AsynchronousSocketCloseMonitor monitor(intFd);
         bytesSent = NET_FAILURE_RETRY(fd, write(intFd, src, count));
+        recordSocketStats(intFd, SOCKET_STATS_WRITE, statsStart, bytesSent);
     }
     if (env->ExceptionOccurred()) {
         return -1;
@@ -503,6 +696,117 @@ static jint OSNetworkSystem_write(JNIEnv* env, jobject,
     return result;
 }
 
+// Translates three Java int[]s to 'size' elements of the native iovec[] 'vectors'.
+static bool fillSocketIoVec(JNIEnv* env, jintArray javaBuffers, jintArray javaOffsets,
+        jintArray javaLengths, jint size, iovec* vectors) {
+    ScopedIntArrayRO buffers(env, javaBuffers);
+    if (buffers.get() == NULL) {
+        return false;
+    }
+    ScopedIntArrayRO offsets(env, javaOffsets);
+    if (offsets.get() == NULL) {
+        return false;
+    }
+    ScopedIntArrayRO lengths(env, javaLengths);
+    if (lengths.get() == NULL) {
+        return false;
+    }
+    for (int i = 0; i < size; ++i) {
+        vectors[i].iov_base = reinterpret_cast<void*>(static_cast<uintptr_t>(buffers[i] + offsets[i]));
+        vectors[i].iov_len = lengths[i];
+    }
+    return true;
+}
+
+/**
+ * Writes 'size' buffers with a single sendmsg(2). If 'more' is true, the kernel is told that
+ * more data will follow shortly (MSG_MORE, the per-call equivalent of TCP_CORK), so that,
+ * for example, a response header and body can share a segment. Like writeDirect, returns the
+ * number of bytes written, which may be 0 for a non-blocking socket.
+ */
+static jlong OSNetworkSystem_writev(JNIEnv* env, jobject, jobject fileDescriptor,
+        jintArray buffers, jintArray offsets, jintArray lengths, jint size, jboolean more) {
+    NetFd fd(env, fileDescriptor);
+    if (fd.isClosed() || size <= 0) {
+        return 0;
+    }
+    // Writing fewer buffers than asked is just a short write.
+    if (size > IOV_MAX) {
+        size = IOV_MAX;
+    }
+    LocalArray<16 * sizeof(iovec)> vectorBuffer(size * sizeof(iovec));
+    iovec* vectors = reinterpret_cast<iovec*>(&vectorBuffer[0]);
+    if (!fillSocketIoVec(env, buffers, offsets, lengths, size, vectors)) {
+        return -1;
+    }
+
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = vectors;
+    msg.msg_iovlen = size;
+    const int flags = more ? MSG_MORE : 0;
+
+    ssize_t bytesSent;
+    const int64_t statsStart = socketStatsStart();
+    {
+        int intFd = fd.get();
+        AsynchronousSocketCloseMonitor monitor(intFd);
+        bytesSent = NET_FAILURE_RETRY(fd, sendmsg(intFd, &msg, flags));
+        recordSocketStats(intFd, SOCKET_STATS_WRITE, statsStart, bytesSent);
+    }
+    if (env->ExceptionOccurred()) {
+        return -1;
+    }
+    if (bytesSent == -1) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            jniThrowSocketException(env, errno);
+        }
+        return 0;
+    }
+    return bytesSent;
+}
+
+/**
+ * Reads into 'size' buffers with a single readv(2). Like readDirect, returns the number of
+ * bytes read, 0 if a non-blocking socket had nothing to read, and -1 at end of stream.
+ */
+static jlong OSNetworkSystem_readv(JNIEnv* env, jobject, jobject fileDescriptor,
+        jintArray buffers, jintArray offsets, jintArray lengths, jint size) {
+    NetFd fd(env, fileDescriptor);
+    if (fd.isClosed() || size <= 0) {
+        return 0;
+    }
+    if (size > IOV_MAX) {
+        size = IOV_MAX;
+    }
+    LocalArray<16 * sizeof(iovec)> vectorBuffer(size * sizeof(iovec));
+    iovec* vectors = reinterpret_cast<iovec*>(&vectorBuffer[0]);
+    if (!fillSocketIoVec(env, buffers, offsets, lengths, size, vectors)) {
+        return -1;
+    }
+
+    ssize_t bytesReceived;
+    const int64_t statsStart = socketStatsStart();
+    {
+        int intFd = fd.get();
+        AsynchronousSocketCloseMonitor monitor(intFd);
+        bytesReceived = NET_FAILURE_RETRY(fd, readv(intFd, vectors, size));
+        recordSocketStats(intFd, SOCKET_STATS_READ, statsStart, bytesReceived);
+    }
+    if (env->ExceptionOccurred()) {
+        return -1;
+    }
+    if (bytesReceived == 0) {
+        return -1;
+    } else if (bytesReceived == -1) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            jniThrowSocketException(env, errno);
+        }
+        return 0;
+    }
+    return bytesReceived;
+}
+
 static jboolean OSNetworkSystem_connectNonBlocking(JNIEnv* env, jobject, jobject fileDescriptor, jobject inetAddr, jint port) {
     NetFd fd(env, fileDescriptor);
     if (fd.isClosed()) {
@@ -533,53 +837,69 @@ static jboolean OSNetworkSystem_isConnected(JNIEnv* env, jobject, jobject fileDe
     }
 }
 
-// TODO: move this into Java, using connectNonBlocking and isConnected!
-static void OSNetworkSystem_connect(JNIEnv* env, jobject, jobject fileDescriptor,
-        jobject inetAddr, jint port, jint timeout) {
-
-    /* if a timeout was specified calculate the finish time value */
-    bool hasTimeout = timeout > 0;
-    int finishTime = 0;
-    if (hasTimeout)  {
-        finishTime = time_msec_clock() + (int) timeout;
+// Completes a connection attempt begun by ConnectHelper::start, waiting for at most 'timeout'
+// milliseconds (or forever, if 'timeout' is 0). Returns true on success; otherwise we've thrown.
+static bool finishConnect(NetFd& fd, ConnectHelper& context, int result, jint timeout) {
+    if (result != -EINPROGRESS) {
+        // Either we connected straight away, or start has already thrown.
+        return result == 0;
     }
+    result = context.isConnected(fd.get(), (timeout > 0) ? timeout : -1);
+    if (fd.isClosed()) {
+        return false;
+    }
+    if (result == 0) {
+        context.didConnect(fd.get());
+        return true;
+    }
+    context.didFail(fd.get(), (result == -EINPROGRESS) ? -ETIMEDOUT : result);
+    return false;
+}
 
+static void OSNetworkSystem_connect(JNIEnv* env, jobject, jobject fileDescriptor,
+        jobject inetAddr, jint port, jint timeout) {
     NetFd fd(env, fileDescriptor);
     if (fd.isClosed()) {
         return;
     }
 
+    const int intFd = fd.get();
+    const int64_t statsStart = socketStatsStart();
     ConnectHelper context(env);
     int result = context.start(fd, inetAddr, port);
-    int remainingTimeout = timeout;
-    while (result == -EINPROGRESS) {
-        /*
-         * ok now try and connect. Depending on the platform this may sleep
-         * for up to passedTimeout milliseconds
-         */
-        result = context.isConnected(fd.get(), remainingTimeout);
-        if (fd.isClosed()) {
-            return;
-        }
-        if (result == 0) {
-            context.didConnect(fd.get());
-            return;
-        } else if (result != -EINPROGRESS) {
-            context.didFail(fd.get(), result);
-            return;
-        }
+    bool connected = finishConnect(fd, context, result, timeout);
+    recordSocketStats(intFd, SOCKET_STATS_CONNECT, statsStart, connected ? 0 : -1);
+}
 
-        /* check if the timeout has expired */
-        if (hasTimeout) {
-            remainingTimeout = finishTime - time_msec_clock();
-            if (remainingTimeout <= 0) {
-                context.didFail(fd.get(), -ETIMEDOUT);
-                return;
-            }
-        } else {
-            remainingTimeout = 100;
-        }
+/**
+ * Connects like connect, but uses TCP Fast Open (where available) to send the first 'count'
+ * bytes of 'data' along with the SYN, saving a round trip on reconnection to a peer we've
+ * talked to before. Returns how many bytes of 'data' were sent; the caller must write the
+ * rest itself.
+ */
+static jint OSNetworkSystem_connectWithData(JNIEnv* env, jobject, jobject fileDescriptor,
+        jobject inetAddr, jint port, jint timeout, jbyteArray data, jint offset, jint count) {
+    NetFd fd(env, fileDescriptor);
+    if (fd.isClosed()) {
+        return -1;
+    }
+    ScopedByteArrayRO bytes(env, data);
+    if (bytes.get() == NULL) {
+        return -1;
     }
+    if (offset < 0 || count < 0 || offset > static_cast<jint>(bytes.size()) - count) {
+        jniThrowException(env, "java/lang/ArrayIndexOutOfBoundsException", NULL);
+        return -1;
+    }
+
+    ConnectHelper context(env);
+    ssize_t bytesSent = 0;
+    int result = context.startWithData(fd, inetAddr, port, bytes.get() + offset, count,
+            &bytesSent);
+    if (!finishConnect(fd, context, result, timeout)) {
+        return -1;
+    }
+    return bytesSent;
 }
 
 static void OSNetworkSystem_bind(JNIEnv* env, jobject, jobject fileDescriptor,
@@ -631,10 +951,12 @@ static void OSNetworkSystem_accept(JNIEnv* env, jobject, jobject serverFileDescr
     sockaddr* sa = reinterpret_cast<sockaddr*>(&ss);
 
     int clientFd;
+    const int64_t statsStart = socketStatsStart();
     {
         int intFd = serverFd.get();
         AsynchronousSocketCloseMonitor monitor(intFd);
         clientFd = NET_FAILURE_RETRY(serverFd, accept(intFd, sa, &addrLen));
+        recordSocketStats(intFd, SOCKET_STATS_ACCEPT, statsStart, (clientFd == -1) ? -1 : 0);
     }
     if (env->ExceptionOccurred()) {
         return;
@@ -733,10 +1055,12 @@ static jint OSNetworkSystem_readDirect(JNIEnv* env, jobject, jobject fileDescrip
 
     jbyte* dst = reinterpret_cast<jbyte*>(static_cast<uintptr_t>(address));
     ssize_t bytesReceived;
+    const int64_t statsStart = socketStatsStart();
     {
         int intFd = fd.get();
         AsynchronousSocketCloseMonitor monitor(intFd);
         bytesReceived = NET_FAILURE_RETRY(fd, read(intFd, dst, count));
+        recordSocketStats(intFd, SOCKET_STATS_READ, statsStart, bytesReceived);
     }
     if (env->ExceptionOccurred()) {
         return -1;
@@ -784,10 +1108,12 @@ static jint OSNetworkSystem_recvDirect(JNIEnv* env, jobject, jobject fileDescrip
     socklen_t* fromLength = connected ? NULL : &sockAddrLen;
 
     ssize_t bytesReceived;
+    const int64_t statsStart = socketStatsStart();
     {
         int intFd = fd.get();
         AsynchronousSocketCloseMonitor monitor(intFd);
         bytesReceived = NET_FAILURE_RETRY(fd, recvfrom(intFd, buf, length, flags, from, fromLength));
+        recordSocketStats(intFd, SOCKET_STATS_RECV, statsStart, bytesReceived);
     }
     if (env->ExceptionOccurred()) {
         return -1;
@@ -840,6 +1166,31 @@ static jint OSNetworkSystem_recv(JNIEnv* env, jobject, jobject fd, jobject packe
 
 
 
+// Sends 'length' bytes from 'buf' to 'to', or to the connected peer if 'to' is NULL.
+static jint sendDatagram(JNIEnv* env, NetFd& fd, const char* buf, jint length,
+        const sockaddr* to, socklen_t toLength) {
+    int flags = 0;
+    ssize_t bytesSent;
+    const int64_t statsStart = socketStatsStart();
+    {
+        int intFd = fd.get();
+        AsynchronousSocketCloseMonitor monitor(intFd);
+        bytesSent = NET_FAILURE_RETRY(fd, sendto(intFd, buf, length, flags, to, toLength));
+        recordSocketStats(intFd, SOCKET_STATS_SEND, statsStart, bytesSent);
+    }
+    if (env->ExceptionOccurred()) {
+        return -1;
+    }
+    if (bytesSent == -1) {
+        if (errno == ECONNRESET || errno == ECONNREFUSED) {
+            return 0;
+        } else {
+            jniThrowSocketException(env, errno);
+        }
+    }
+    return bytesSent;
+}
+
 static jint OSNetworkSystem_sendDirect(JNIEnv* env, jobject, jobject fileDescriptor, jint address, jint offset, jint length, jint port, jobject inetAddress) {
     NetFd fd(env, fileDescriptor);
     if (fd.isClosed()) {
@@ -851,28 +1202,45 @@ static jint OSNetworkSystem_sendDirect(JNIEnv* env, jobject, jobject fileDescrip
         return -1;
     }
 
-    int flags = 0;
     char* buf = reinterpret_cast<char*>(static_cast<uintptr_t>(address + offset));
     sockaddr* to = inetAddress ? reinterpret_cast<sockaddr*>(&receiver) : NULL;
     socklen_t toLength = inetAddress ? sizeof(receiver) : 0;
+    return sendDatagram(env, fd, buf, length, to, toLength);
+}
 
-    ssize_t bytesSent;
-    {
-        int intFd = fd.get();
-        AsynchronousSocketCloseMonitor monitor(intFd);
-        bytesSent = NET_FAILURE_RETRY(fd, sendto(intFd, buf, length, flags, to, toLength));
+/**
+ * Sends to the peer a datagram socket is connected to. The kernel already holds the peer's
+ * address, so there's no InetAddress to marshal.
+ */
+static jint OSNetworkSystem_sendConnectedDirect(JNIEnv* env, jobject, jobject fileDescriptor,
+        jint address, jint offset, jint length) {
+    NetFd fd(env, fileDescriptor);
+    if (fd.isClosed()) {
+        return -1;
     }
-    if (env->ExceptionOccurred()) {
+    char* buf = reinterpret_cast<char*>(static_cast<uintptr_t>(address + offset));
+    return sendDatagram(env, fd, buf, length, NULL, 0);
+}
+
+static jint OSNetworkSystem_sendConnected(JNIEnv* env, jobject, jobject fileDescriptor,
+        jbyteArray data, jint offset, jint length) {
+    if (data == NULL) {
+        jniThrowNullPointerException(env, NULL);
         return -1;
     }
-    if (bytesSent == -1) {
-        if (errno == ECONNRESET || errno == ECONNREFUSED) {
-            return 0;
-        } else {
-            jniThrowSocketException(env, errno);
-        }
+    if (offset < 0 || length < 0 || offset > env->GetArrayLength(data) - length) {
+        jniThrowException(env, "java/lang/ArrayIndexOutOfBoundsException", NULL);
+        return -1;
     }
-    return bytesSent;
+    NetFd fd(env, fileDescriptor);
+    if (fd.isClosed()) {
+        return -1;
+    }
+    // Copy just the packet rather than pinning or copying the whole array: the packets sent
+    // this way are typically small and their arrays re-used.
+    LocalArray<1024> buf(length);
+    env->GetByteArrayRegion(data, offset, length, reinterpret_cast<jbyte*>(&buf[0]));
+    return sendDatagram(env, fd, &buf[0], length, NULL, 0);
 }
 
 static jint OSNetworkSystem_send(JNIEnv* env, jobject, jobject fd,
@@ -893,6 +1261,289 @@ static jint OSNetworkSystem_send(JNIEnv* env, jobject, jobject fd,
 
 
 
+/*
+ * Batched datagram I/O. The datagrams in a batch live at successive 'stride'-byte slots
+ * of the caller's buffer. Each datagram's address is held in a 16-byte slot of the caller's
+ * address array, with IPv4 addresses in their IPv4-mapped IPv6 form, so the caller never has
+ * to create an InetAddress per packet.
+ */
+static const size_t BATCH_ADDRESS_LENGTH = 16;
+
+// Has the same layout as Linux's struct mmsghdr, which not every libc defines.
+struct BatchMessage {
+    msghdr msg_hdr;
+    unsigned int msg_len;
+};
+
+// Not every libc has wrappers for recvmmsg(2) and sendmmsg(2), so we make the system calls
+// ourselves, and remember if the kernel turns out not to support them.
+static bool gHaveRecvmmsg = true;
+static bool gHaveSendmmsg = true;
+
+static int recvmmsgCompat(int fd, BatchMessage* messages, unsigned int count, int flags) {
+#ifdef __NR_recvmmsg
+    return syscall(__NR_recvmmsg, fd, messages, count, flags, NULL);
+#else
+    (void) fd; (void) messages; (void) count; (void) flags;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+static int sendmmsgCompat(int fd, BatchMessage* messages, unsigned int count, int flags) {
+#ifdef __NR_sendmmsg
+    return syscall(__NR_sendmmsg, fd, messages, count, flags);
+#else
+    (void) fd; (void) messages; (void) count; (void) flags;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+// Receives up to 'count' datagrams, blocking (if the socket is blocking) only for the first.
+// Returns the number of datagrams received, or -1 and sets errno if none could be.
+static int recvBatch(int fd, BatchMessage* messages, int count) {
+    if (gHaveRecvmmsg) {
+        int rc = recvmmsgCompat(fd, messages, count, MSG_WAITFORONE);
+        if (rc != -1 || errno != ENOSYS) {
+            return rc;
+        }
+        gHaveRecvmmsg = false;
+    }
+    for (int i = 0; i < count; ++i) {
+        ssize_t rc = recvmsg(fd, &messages[i].msg_hdr, (i == 0) ? 0 : MSG_DONTWAIT);
+        if (rc == -1) {
+            return (i == 0) ? -1 : i;
+        }
+        messages[i].msg_len = rc;
+    }
+    return count;
+}
+
+// Sends up to 'count' datagrams. Returns the number sent, or -1 and sets errno if none were.
+static int sendBatch(int fd, BatchMessage* messages, int count) {
+    if (gHaveSendmmsg) {
+        int rc = sendmmsgCompat(fd, messages, count, 0);
+        if (rc != -1 || errno != ENOSYS) {
+            return rc;
+        }
+        gHaveSendmmsg = false;
+    }
+    for (int i = 0; i < count; ++i) {
+        ssize_t rc = sendmsg(fd, &messages[i].msg_hdr, 0);
+        if (rc == -1) {
+            return (i == 0) ? -1 : i;
+        }
+        messages[i].msg_len = rc;
+    }
+    return count;
+}
+
+// Writes the address and port in 'ss' to a 16-byte batch address slot.
+static void socketAddressToBatchAddress(const sockaddr_storage& ss, jbyte* dst, jint* port) {
+    memset(dst, 0, BATCH_ADDRESS_LENGTH);
+    if (ss.ss_family == AF_INET6) {
+        const sockaddr_in6* sin6 = reinterpret_cast<const sockaddr_in6*>(&ss);
+        memcpy(dst, &sin6->sin6_addr.s6_addr, BATCH_ADDRESS_LENGTH);
+        *port = ntohs(sin6->sin6_port);
+    } else if (ss.ss_family == AF_INET) {
+        const sockaddr_in* sin = reinterpret_cast<const sockaddr_in*>(&ss);
+        memset(&dst[10], 0xff, 2);
+        memcpy(&dst[12], &sin->sin_addr.s_addr, 4);
+        *port = ntohs(sin->sin_port);
+    } else {
+        *port = -1;
+    }
+}
+
+// Reads a 16-byte batch address slot, unmapping IPv4-mapped addresses.
+static void batchAddressToSocketAddress(const jbyte* src, int port, sockaddr_storage* ss) {
+    memset(ss, 0, sizeof(*ss));
+    in6_addr addr;
+    memcpy(&addr.s6_addr, src, BATCH_ADDRESS_LENGTH);
+    if (IN6_IS_ADDR_V4MAPPED(&addr)) {
+        sockaddr_in* sin = reinterpret_cast<sockaddr_in*>(ss);
+        sin->sin_family = AF_INET;
+        sin->sin_port = htons(port);
+        memcpy(&sin->sin_addr.s_addr, &addr.s6_addr[12], 4);
+    } else {
+        sockaddr_in6* sin6 = reinterpret_cast<sockaddr_in6*>(ss);
+        sin6->sin6_family = AF_INET6;
+        sin6->sin6_port = htons(port);
+        sin6->sin6_addr = addr;
+    }
+}
+
+static bool checkBatchArrays(JNIEnv* env, jint count, jintArray lengths, jintArray ports,
+        jbyteArray addresses) {
+    if (lengths == NULL) {
+        jniThrowNullPointerException(env, NULL);
+        return false;
+    }
+    if (env->GetArrayLength(lengths) < count ||
+            (ports != NULL && env->GetArrayLength(ports) < count) ||
+            (addresses != NULL &&
+             static_cast<size_t>(env->GetArrayLength(addresses)) < count * BATCH_ADDRESS_LENGTH)) {
+        jniThrowException(env, "java/lang/ArrayIndexOutOfBoundsException", NULL);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Receives up to 'count' datagrams with a single system call where possible. Datagram i is
+ * written to 'address + i * stride', and its length, sender port and sender address are
+ * written to element i of 'lengths', 'ports' and 'addresses' (either of the latter two may be
+ * null). Only the first datagram blocks. Returns the number of datagrams received.
+ */
+static jint OSNetworkSystem_recvBatchDirect(JNIEnv* env, jobject, jobject fileDescriptor,
+        jint address, jint stride, jint count, jintArray lengths, jintArray ports,
+        jbyteArray addresses) {
+    NetFd fd(env, fileDescriptor);
+    if (fd.isClosed()) {
+        return 0;
+    }
+    if (count <= 0 || !checkBatchArrays(env, count, lengths, ports, addresses)) {
+        return 0;
+    }
+
+    UniquePtr<BatchMessage[]> messages(new BatchMessage[count]);
+    UniquePtr<iovec[]> vectors(new iovec[count]);
+    UniquePtr<sockaddr_storage[]> senders(new sockaddr_storage[count]);
+    memset(messages.get(), 0, count * sizeof(BatchMessage));
+    for (int i = 0; i < count; ++i) {
+        vectors[i].iov_base = reinterpret_cast<void*>(static_cast<uintptr_t>(address + i * stride));
+        vectors[i].iov_len = stride;
+        messages[i].msg_hdr.msg_iov = &vectors[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+        messages[i].msg_hdr.msg_name = &senders[i];
+        messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+    }
+
+    int received;
+    {
+        int intFd = fd.get();
+        AsynchronousSocketCloseMonitor monitor(intFd);
+        received = NET_FAILURE_RETRY(fd, recvBatch(intFd, messages.get(), count));
+    }
+    if (env->ExceptionOccurred()) {
+        return -1;
+    }
+    if (received == -1) {
+        if (errno == ECONNREFUSED) {
+            jniThrowException(env, "java/net/PortUnreachableException", "");
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            jniThrowSocketTimeoutException(env, errno);
+        } else {
+            jniThrowSocketException(env, errno);
+        }
+        return 0;
+    }
+
+    LocalArray<64 * sizeof(jint)> javaLengths(received * sizeof(jint));
+    LocalArray<64 * sizeof(jint)> javaPorts(received * sizeof(jint));
+    LocalArray<64 * BATCH_ADDRESS_LENGTH> javaAddresses(received * BATCH_ADDRESS_LENGTH);
+    jint* lengthsOut = reinterpret_cast<jint*>(&javaLengths[0]);
+    jint* portsOut = reinterpret_cast<jint*>(&javaPorts[0]);
+    jbyte* addressesOut = reinterpret_cast<jbyte*>(&javaAddresses[0]);
+    for (int i = 0; i < received; ++i) {
+        lengthsOut[i] = messages[i].msg_len;
+        if (messages[i].msg_hdr.msg_namelen == 0) {
+            // Connected sockets don't necessarily report the sender.
+            senders[i].ss_family = AF_UNSPEC;
+        }
+        socketAddressToBatchAddress(senders[i], &addressesOut[i * BATCH_ADDRESS_LENGTH],
+                &portsOut[i]);
+    }
+    env->SetIntArrayRegion(lengths, 0, received, lengthsOut);
+    if (ports != NULL) {
+        env->SetIntArrayRegion(ports, 0, received, portsOut);
+    }
+    if (addresses != NULL) {
+        env->SetByteArrayRegion(addresses, 0, received * BATCH_ADDRESS_LENGTH, addressesOut);
+    }
+    return received;
+}
+
+/**
+ * Sends up to 'count' datagrams with a single system call where possible. Datagram i is read
+ * from 'address + i * stride' and is 'lengths[i]' bytes long. If 'addresses' is null, the
+ * socket must be connected; otherwise datagram i goes to element i of 'ports' and 'addresses'.
+ * Returns the number of datagrams sent.
+ */
+static jint OSNetworkSystem_sendBatchDirect(JNIEnv* env, jobject, jobject fileDescriptor,
+        jint address, jint stride, jint count, jintArray lengths, jintArray ports,
+        jbyteArray addresses) {
+    NetFd fd(env, fileDescriptor);
+    if (fd.isClosed()) {
+        return -1;
+    }
+    if (count <= 0 || !checkBatchArrays(env, count, lengths, ports, addresses)) {
+        return 0;
+    }
+    if (addresses != NULL && ports == NULL) {
+        jniThrowNullPointerException(env, "ports");
+        return -1;
+    }
+
+    LocalArray<64 * sizeof(jint)> javaLengths(count * sizeof(jint));
+    jint* lengthsIn = reinterpret_cast<jint*>(&javaLengths[0]);
+    env->GetIntArrayRegion(lengths, 0, count, lengthsIn);
+    for (int i = 0; i < count; ++i) {
+        // A datagram mustn't run into the next one's slot, or past the end of the buffer.
+        if (lengthsIn[i] < 0 || lengthsIn[i] > stride) {
+            jniThrowExceptionFmt(env, "java/lang/IllegalArgumentException",
+                    "lengths[%d] == %d, stride == %d", i, lengthsIn[i], stride);
+            return -1;
+        }
+    }
+
+    UniquePtr<BatchMessage[]> messages(new BatchMessage[count]);
+    UniquePtr<iovec[]> vectors(new iovec[count]);
+    UniquePtr<sockaddr_storage[]> receivers(addresses != NULL ? new sockaddr_storage[count] : NULL);
+    memset(messages.get(), 0, count * sizeof(BatchMessage));
+    if (addresses != NULL) {
+        ScopedIntArrayRO javaPorts(env, ports);
+        ScopedByteArrayRO javaAddresses(env, addresses);
+        if (javaPorts.get() == NULL || javaAddresses.get() == NULL) {
+            return -1;
+        }
+        const int intFd = fd.get();
+        for (int i = 0; i < count; ++i) {
+            sockaddr_storage ss;
+            batchAddressToSocketAddress(&javaAddresses[i * BATCH_ADDRESS_LENGTH], javaPorts[i], &ss);
+            const CompatibleSocketAddress compatibleAddress(intFd, ss, true);
+            memcpy(&receivers[i], compatibleAddress.get(), sizeof(sockaddr_storage));
+            messages[i].msg_hdr.msg_name = &receivers[i];
+            messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+        }
+    }
+    for (int i = 0; i < count; ++i) {
+        vectors[i].iov_base = reinterpret_cast<void*>(static_cast<uintptr_t>(address + i * stride));
+        vectors[i].iov_len = lengthsIn[i];
+        messages[i].msg_hdr.msg_iov = &vectors[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int sent;
+    {
+        int intFd = fd.get();
+        AsynchronousSocketCloseMonitor monitor(intFd);
+        sent = NET_FAILURE_RETRY(fd, sendBatch(intFd, messages.get(), count));
+    }
+    if (env->ExceptionOccurred()) {
+        return -1;
+    }
+    if (sent == -1) {
+        if (errno == ECONNRESET || errno == ECONNREFUSED) {
+            return 0;
+        }
+        jniThrowSocketException(env, errno);
+        return -1;
+    }
+    return sent;
+}
+
 static bool isValidFd(int fd) {
     return fd >= 0 && fd < FD_SETSIZE;
 }
@@ -990,6 +1641,181 @@ static jboolean OSNetworkSystem_selectImpl(JNIEnv* env, jclass,
             translateFdSet(env, writeFDArray, countWriteC, writeFds, flagArray.get(), countReadC, SOCKET_OP_WRITE);
 }
 
+#ifdef ENABLE_EPOLL
+// Translates a set of SOCKET_OP_ bits to the corresponding epoll(7) event mask.
+static uint32_t toEpollEvents(jint ops) {
+    uint32_t events = 0;
+    if ((ops & SOCKET_OP_READ) != 0) {
+        events |= EPOLLIN;
+    }
+    if ((ops & SOCKET_OP_WRITE) != 0) {
+        events |= EPOLLOUT;
+    }
+    return events;
+}
+
+// Translates an epoll(7) event mask back to SOCKET_OP_ bits. Like select(2), we report
+// errors and hang-ups as both readable and writable, so the caller's next I/O sees the error.
+static jint fromEpollEvents(uint32_t events) {
+    jint ops = SOCKET_OP_NONE;
+    if ((events & (EPOLLIN | EPOLLERR | EPOLLHUP)) != 0) {
+        ops |= SOCKET_OP_READ;
+    }
+    if ((events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) != 0) {
+        ops |= SOCKET_OP_WRITE;
+    }
+    return ops;
+}
+
+static void epollControl(JNIEnv* env, jobject epollFileDescriptor, jobject fileDescriptor,
+        int op, jint ops, jint token) {
+    NetFd epollFd(env, epollFileDescriptor);
+    if (epollFd.isClosed()) {
+        return;
+    }
+    NetFd fd(env, fileDescriptor);
+    if (fd.isClosed()) {
+        return;
+    }
+
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = toEpollEvents(ops);
+    event.data.u32 = token;
+    int rc = epoll_ctl(epollFd.get(), op, fd.get(), &event);
+    if (rc == -1) {
+        jniThrowSocketException(env, errno);
+    }
+}
+#endif // def ENABLE_EPOLL
+
+static void OSNetworkSystem_epollCreate(JNIEnv* env, jobject, jobject epollFileDescriptor) {
+#ifdef ENABLE_EPOLL
+    if (epollFileDescriptor == NULL) {
+        jniThrowNullPointerException(env, NULL);
+        return;
+    }
+    // The size hint is ignored by modern kernels, but must be positive.
+    int fd = epoll_create(1);
+    if (fd == -1) {
+        jniThrowSocketException(env, errno);
+        return;
+    }
+    // Don't leak the epoll fd into child processes.
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    jniSetFileDescriptorOfFD(env, epollFileDescriptor, fd);
+#else
+    jniThrowException(env, "java/lang/UnsupportedOperationException", NULL);
+#endif
+}
+
+static void OSNetworkSystem_epollRegister(JNIEnv* env, jobject, jobject epollFileDescriptor,
+        jobject fileDescriptor, jint ops, jint token) {
+#ifdef ENABLE_EPOLL
+    epollControl(env, epollFileDescriptor, fileDescriptor, EPOLL_CTL_ADD, ops, token);
+#else
+    jniThrowException(env, "java/lang/UnsupportedOperationException", NULL);
+#endif
+}
+
+static void OSNetworkSystem_epollModify(JNIEnv* env, jobject, jobject epollFileDescriptor,
+        jobject fileDescriptor, jint ops, jint token) {
+#ifdef ENABLE_EPOLL
+    epollControl(env, epollFileDescriptor, fileDescriptor, EPOLL_CTL_MOD, ops, token);
+#else
+    jniThrowException(env, "java/lang/UnsupportedOperationException", NULL);
+#endif
+}
+
+static void OSNetworkSystem_epollDeregister(JNIEnv* env, jobject, jobject epollFileDescriptor,
+        jobject fileDescriptor) {
+#ifdef ENABLE_EPOLL
+    NetFd epollFd(env, epollFileDescriptor);
+    if (epollFd.isClosed()) {
+        return;
+    }
+    const int fd = jniGetFDFromFileDescriptor(env, fileDescriptor);
+    if (fd == -1) {
+        // Closing an fd removes it from every epoll set, so there's nothing left to do.
+        return;
+    }
+    // Kernels before 2.6.9 require a non-NULL event even for EPOLL_CTL_DEL.
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    int rc = epoll_ctl(epollFd.get(), EPOLL_CTL_DEL, fd, &event);
+    if (rc == -1 && errno != ENOENT && errno != EBADF) {
+        jniThrowSocketException(env, errno);
+    }
+#else
+    jniThrowException(env, "java/lang/UnsupportedOperationException", NULL);
+#endif
+}
+
+/**
+ * Waits for at most 'timeoutMs' milliseconds (forever if negative) for any registered fd to
+ * become ready. The token and SOCKET_OP_ bits of each ready fd are written to successive
+ * elements of 'readyTokens' and 'readyOps'. Returns the number of ready fds, which is 0 on
+ * timeout or if the wait was interrupted. The cost is proportional to the number of ready
+ * fds rather than the number registered, and there's no FD_SETSIZE limit.
+ */
+static jint OSNetworkSystem_epollWait(JNIEnv* env, jobject, jobject epollFileDescriptor,
+        jintArray readyTokens, jintArray readyOps, jlong timeoutMs) {
+#ifdef ENABLE_EPOLL
+    NetFd epollFd(env, epollFileDescriptor);
+    if (epollFd.isClosed()) {
+        return 0;
+    }
+    if (readyTokens == NULL || readyOps == NULL) {
+        jniThrowNullPointerException(env, NULL);
+        return 0;
+    }
+    jsize maxEvents = env->GetArrayLength(readyTokens);
+    if (env->GetArrayLength(readyOps) < maxEvents) {
+        maxEvents = env->GetArrayLength(readyOps);
+    }
+    if (maxEvents <= 0) {
+        jniThrowException(env, "java/lang/IllegalArgumentException", "empty ready set");
+        return 0;
+    }
+
+    LocalArray<64 * sizeof(epoll_event)> buffer(maxEvents * sizeof(epoll_event));
+    epoll_event* events = reinterpret_cast<epoll_event*>(&buffer[0]);
+    int timeout = -1;
+    if (timeoutMs >= 0) {
+        timeout = (timeoutMs > INT_MAX) ? INT_MAX : static_cast<int>(timeoutMs);
+    }
+
+    int readyCount;
+    {
+        int intFd = epollFd.get();
+        AsynchronousSocketCloseMonitor monitor(intFd);
+        readyCount = epoll_wait(intFd, events, maxEvents, timeout);
+    }
+    if (readyCount == -1) {
+        if (errno == EINTR) {
+            // Either a signal or an asynchronous close; the caller will check which.
+            return 0;
+        }
+        jniThrowSocketException(env, errno);
+        return 0;
+    }
+
+    ScopedIntArrayRW tokens(env, readyTokens);
+    ScopedIntArrayRW ops(env, readyOps);
+    if (tokens.get() == NULL || ops.get() == NULL) {
+        return 0;
+    }
+    for (int i = 0; i < readyCount; ++i) {
+        tokens[i] = events[i].data.u32;
+        ops[i] = fromEpollEvents(events[i].events);
+    }
+    return readyCount;
+#else
+    jniThrowException(env, "java/lang/UnsupportedOperationException", NULL);
+    return 0;
+#endif
+}
+
 static jobject OSNetworkSystem_getSocketLocalAddress(JNIEnv* env,
         jobject, jobject fileDescriptor) {
     NetFd fd(env, fileDescriptor);
@@ -1360,27 +2186,41 @@ static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(OSNetworkSystem, close, "(Ljava/io/FileDescriptor;)V"),
     NATIVE_METHOD(OSNetworkSystem, connectNonBlocking, "(Ljava/io/FileDescriptor;Ljava/net/InetAddress;I)Z"),
     NATIVE_METHOD(OSNetworkSystem, connect, "(Ljava/io/FileDescriptor;Ljava/net/InetAddress;II)V"),
+    NATIVE_METHOD(OSNetworkSystem, connectWithData, "(Ljava/io/FileDescriptor;Ljava/net/InetAddress;II[BII)I"),
     NATIVE_METHOD(OSNetworkSystem, disconnectDatagram, "(Ljava/io/FileDescriptor;)V"),
+    NATIVE_METHOD(OSNetworkSystem, epollCreate, "(Ljava/io/FileDescriptor;)V"),
+    NATIVE_METHOD(OSNetworkSystem, epollDeregister, "(Ljava/io/FileDescriptor;Ljava/io/FileDescriptor;)V"),
+    NATIVE_METHOD(OSNetworkSystem, epollModify, "(Ljava/io/FileDescriptor;Ljava/io/FileDescriptor;II)V"),
+    NATIVE_METHOD(OSNetworkSystem, epollRegister, "(Ljava/io/FileDescriptor;Ljava/io/FileDescriptor;II)V"),
+    NATIVE_METHOD(OSNetworkSystem, epollWait, "(Ljava/io/FileDescriptor;[I[IJ)I"),
     NATIVE_METHOD(OSNetworkSystem, getSocketLocalAddress, "(Ljava/io/FileDescriptor;)Ljava/net/InetAddress;"),
     NATIVE_METHOD(OSNetworkSystem, getSocketLocalPort, "(Ljava/io/FileDescriptor;)I"),
     NATIVE_METHOD(OSNetworkSystem, getSocketOption, "(Ljava/io/FileDescriptor;I)Ljava/lang/Object;"),
+    NATIVE_METHOD(OSNetworkSystem, getSocketStats, "(Z)[J"),
     NATIVE_METHOD(OSNetworkSystem, isConnected, "(Ljava/io/FileDescriptor;I)Z"),
     NATIVE_METHOD(OSNetworkSystem, listen, "(Ljava/io/FileDescriptor;I)V"),
     NATIVE_METHOD(OSNetworkSystem, read, "(Ljava/io/FileDescriptor;[BII)I"),
     NATIVE_METHOD(OSNetworkSystem, readDirect, "(Ljava/io/FileDescriptor;II)I"),
+    NATIVE_METHOD(OSNetworkSystem, readv, "(Ljava/io/FileDescriptor;[I[I[II)J"),
     NATIVE_METHOD(OSNetworkSystem, recv, "(Ljava/io/FileDescriptor;Ljava/net/DatagramPacket;[BIIZZ)I"),
+    NATIVE_METHOD(OSNetworkSystem, recvBatchDirect, "(Ljava/io/FileDescriptor;III[I[I[B)I"),
     NATIVE_METHOD(OSNetworkSystem, recvDirect, "(Ljava/io/FileDescriptor;Ljava/net/DatagramPacket;IIIZZ)I"),
     NATIVE_METHOD(OSNetworkSystem, selectImpl, "([Ljava/io/FileDescriptor;[Ljava/io/FileDescriptor;II[IJ)Z"),
     NATIVE_METHOD(OSNetworkSystem, send, "(Ljava/io/FileDescriptor;[BIIILjava/net/InetAddress;)I"),
+    NATIVE_METHOD(OSNetworkSystem, sendBatchDirect, "(Ljava/io/FileDescriptor;III[I[I[B)I"),
+    NATIVE_METHOD(OSNetworkSystem, sendConnected, "(Ljava/io/FileDescriptor;[BII)I"),
+    NATIVE_METHOD(OSNetworkSystem, sendConnectedDirect, "(Ljava/io/FileDescriptor;III)I"),
     NATIVE_METHOD(OSNetworkSystem, sendDirect, "(Ljava/io/FileDescriptor;IIIILjava/net/InetAddress;)I"),
     NATIVE_METHOD(OSNetworkSystem, sendUrgentData, "(Ljava/io/FileDescriptor;B)V"),
     NATIVE_METHOD(OSNetworkSystem, setInetAddress, "(Ljava/net/InetAddress;[B)V"),
     NATIVE_METHOD(OSNetworkSystem, setSocketOption, "(Ljava/io/FileDescriptor;ILjava/lang/Object;)V"),
+    NATIVE_METHOD(OSNetworkSystem, setSocketStatsEnabled, "(Z)V"),
     NATIVE_METHOD(OSNetworkSystem, shutdownInput, "(Ljava/io/FileDescriptor;)V"),
     NATIVE_METHOD(OSNetworkSystem, shutdownOutput, "(Ljava/io/FileDescriptor;)V"),
     NATIVE_METHOD(OSNetworkSystem, socket, "(Ljava/io/FileDescriptor;Z)V"),
     NATIVE_METHOD(OSNetworkSystem, write, "(Ljava/io/FileDescriptor;[BII)I"),
     NATIVE_METHOD(OSNetworkSystem, writeDirect, "(Ljava/io/FileDescriptor;III)I"),
+    NATIVE_METHOD(OSNetworkSystem, writev, "(Ljava/io/FileDescriptor;[I[I[IIZ)J"),
 };
 
 void register_org_apache_harmony_luni_platform_OSNetworkSystem(JNIEnv* env) {
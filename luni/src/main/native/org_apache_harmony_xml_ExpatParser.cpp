@@ -22,17 +22,22 @@
 #include "ScopedJavaUnicodeString.h"
 #include "ScopedLocalRef.h"
 #include "ScopedPrimitiveArray.h"
+#include "ScopedPthreadMutexLock.h"
 #include "ScopedUtfChars.h"
 #include "UniquePtr.h"
+#include "Utf8.h"
 #include "jni.h"
 #include "utils/Log.h"
 
+#include <errno.h>
+#include <pthread.h>
 #include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include <vector>
 #include <utils/misc.h>
 #include <expat.h>
-#include <cutils/jstring.h>
-
-#define BUCKET_COUNT 128
 
 static void throw_OutOfMemoryError(JNIEnv* env) {
     jniThrowException(env, "java/lang/OutOfMemoryError", "Out of memory.");
@@ -42,7 +47,7 @@ static void throw_OutOfMemoryError(JNIEnv* env) {
  * Wrapper around an interned string.
  */
 struct InternedString {
-    InternedString() : interned(NULL), bytes(NULL) {
+    InternedString() : interned(NULL), bytes(NULL), pooled(false) {
     }
 
     ~InternedString() {
@@ -57,6 +62,178 @@ struct InternedString {
 
     /** Hash code of the interned string. */
     int hash;
+
+    /** True if this string belongs to an InternPool rather than to a single parser. */
+    bool pooled;
+};
+
+/**
+ * Open-addressed hash table of interned strings, keyed by their UTF-8 bytes.
+ * The table doubles whenever it gets three quarters full, so lookups stay
+ * short however many distinct names a document uses.
+ */
+class InternedStringTable {
+public:
+    InternedStringTable() : entries(NULL), capacity(0), count(0) {
+    }
+
+    ~InternedStringTable() {
+        delete[] entries;
+    }
+
+    /**
+     * Returns the entry for s, or NULL if there isn't one.
+     */
+    InternedString* find(const char* s, int hash) const {
+        if (count == 0) {
+            return NULL;
+        }
+        size_t mask = capacity - 1;
+        for (size_t i = indexFor(hash); entries[i] != NULL; i = (i + 1) & mask) {
+            if (entries[i]->hash == hash && !strcmp(s, entries[i]->bytes)) {
+                return entries[i];
+            }
+        }
+        return NULL;
+    }
+
+    /**
+     * Adds an entry that isn't already present. Returns false if we ran out
+     * of memory, in which case the table is unchanged.
+     */
+    bool add(InternedString* entry) {
+        if ((count + 1) * 4 > capacity * 3) {
+            size_t newCapacity = (capacity == 0) ? size_t(INITIAL_CAPACITY) : capacity * 2;
+            if (!resize(newCapacity)) {
+                return false;
+            }
+        }
+        insert(entry);
+        count++;
+        return true;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    /**
+     * Empties the table, freeing the entries it owns: all of them for an
+     * InternPool, or those that aren't pooled for a parser.
+     */
+    void clear(JNIEnv* env, bool freePooled) {
+        for (size_t i = 0; i < capacity; i++) {
+            InternedString* entry = entries[i];
+            if (entry != NULL && (freePooled || !entry->pooled)) {
+                env->DeleteGlobalRef(entry->interned);
+                delete entry;
+            }
+        }
+        delete[] entries;
+        entries = NULL;
+        capacity = 0;
+        count = 0;
+    }
+
+private:
+    enum { INITIAL_CAPACITY = 64 };
+
+    size_t indexFor(int hash) const {
+        // Our hash is weak in the low bits, which are the ones we use, so mix in the high bits.
+        unsigned int h = hash;
+        h ^= (h >> 16);
+        h ^= (h >> 7);
+        return h & (capacity - 1);
+    }
+
+    void insert(InternedString* entry) {
+        size_t mask = capacity - 1;
+        size_t i = indexFor(entry->hash);
+        while (entries[i] != NULL) {
+            i = (i + 1) & mask;
+        }
+        entries[i] = entry;
+    }
+
+    bool resize(size_t newCapacity) {
+        InternedString** newEntries = new InternedString*[newCapacity];
+        if (newEntries == NULL) {
+            return false;
+        }
+        memset(newEntries, 0, newCapacity * sizeof(InternedString*));
+        InternedString** oldEntries = entries;
+        size_t oldCapacity = capacity;
+        entries = newEntries;
+        capacity = newCapacity;
+        for (size_t i = 0; i < oldCapacity; i++) {
+            if (oldEntries[i] != NULL) {
+                insert(oldEntries[i]);
+            }
+        }
+        delete[] oldEntries;
+        return true;
+    }
+
+    InternedString** entries;
+    size_t capacity;
+    size_t count;
+
+    // Disallow copy and assignment.
+    InternedStringTable(const InternedStringTable&);
+    void operator=(const InternedStringTable&);
+};
+
+/**
+ * Interned strings shared by every parser given the pool, so that documents
+ * following the same schema only create Java strings for their names once.
+ * Parsers look in their own table first and only take the lock for names
+ * they haven't seen yet. The pool is freed when the Java ExpatInternPool and
+ * every parser using it have let go of it.
+ */
+class InternPool {
+public:
+    InternPool() : refCount(1) {
+        pthread_mutex_init(&mutex, NULL);
+    }
+
+    void acquire() {
+        ScopedPthreadMutexLock lock(&mutex);
+        refCount++;
+    }
+
+    void release(JNIEnv* env) {
+        {
+            ScopedPthreadMutexLock lock(&mutex);
+            if (--refCount > 0) {
+                return;
+            }
+            strings.clear(env, true);
+        }
+        delete this;
+    }
+
+    /**
+     * Returns the pool's entry for s, creating it if need be. Returns NULL
+     * without throwing if the pool is full, in which case the caller should
+     * intern s itself.
+     */
+    InternedString* intern(JNIEnv* env, const char* s, int hash);
+
+private:
+    ~InternPool() {
+        pthread_mutex_destroy(&mutex);
+    }
+
+    /**
+     * The most strings we'll pool. Public and system ids are interned too and
+     * vary from document to document, so we need a limit to stop them
+     * accumulating forever.
+     */
+    enum { MAX_POOLED_STRINGS = 4096 };
+
+    pthread_mutex_t mutex;
+    int refCount;
+    InternedStringTable strings;
 };
 
 /**
@@ -92,6 +269,10 @@ public:
         return (size == 0) ? NULL : array[--size];
     }
 
+    void clear() {
+        size = 0;
+    }
+
 private:
     enum { DEFAULT_CAPACITY = 10 };
 
@@ -100,14 +281,182 @@ private:
     int size;
 };
 
+/**
+ * Element, text and comment events waiting to be handed to Java in a single
+ * upcall, for parsers that batch their events. Each event is a few ints in
+ * 'events': its type, then indices into 'strings' for names and offsets into
+ * 'text' for character data; see ExpatParser.dispatchEvents. We build the
+ * batch in native memory and copy it into the Java arrays when we flush.
+ */
+class EventBatch {
+public:
+    // These must match the constants in ExpatParser.java.
+    enum {
+        START_ELEMENT = 0, // uri, localName, qName, attributes, attributeCount
+        END_ELEMENT = 1, // uri, localName, qName
+        TEXT = 2, // offset, length
+        COMMENT = 3, // offset, length
+    };
+
+    enum {
+        EVENT_CAPACITY = 1024, // ints
+        TEXT_CAPACITY = 8192, // jchars
+        STRING_CAPACITY = 512,
+    };
+
+    EventBatch() : javaEvents(NULL), javaText(NULL), javaStrings(NULL), eventLength(0),
+            textLength(0), stringCount(0), lastText(-1), attributeChunk(NULL),
+            attributeChunkUsed(0) {
+    }
+
+    /**
+     * Allocates the Java arrays. Returns false with an exception pending on failure.
+     */
+    bool init(JNIEnv* env) {
+        javaEvents = newGlobalRef(env, env->NewIntArray(EVENT_CAPACITY));
+        javaText = newGlobalRef(env, env->NewCharArray(TEXT_CAPACITY));
+        javaStrings = newGlobalRef(env,
+                env->NewObjectArray(STRING_CAPACITY, JniConstants::stringClass, NULL));
+        return javaEvents != NULL && javaText != NULL && javaStrings != NULL;
+    }
+
+    // Warning: 'env' must be valid on entry.
+    void release(JNIEnv* env) {
+        clear();
+        delete[] attributeChunk;
+        attributeChunk = NULL;
+        env->DeleteGlobalRef(javaEvents);
+        env->DeleteGlobalRef(javaText);
+        env->DeleteGlobalRef(javaStrings);
+    }
+
+    bool isEmpty() const {
+        return eventLength == 0;
+    }
+
+    bool hasRoom(int ints, int chars, int strings) const {
+        return eventLength + ints <= EVENT_CAPACITY && textLength + chars <= TEXT_CAPACITY
+                && stringCount + strings <= STRING_CAPACITY;
+    }
+
+    void addInt(jint i) {
+        events[eventLength++] = i;
+    }
+
+    jint addString(JNIEnv* env, jstring s) {
+        env->SetObjectArrayElement(javaStrings, stringCount, s);
+        return stringCount++;
+    }
+
+    /**
+     * Copies 'count' attribute name/value pairs to memory that stays valid
+     * until the batch is cleared, laid out like ExpatParser_cloneAttributes.
+     * Returns NULL if we ran out of memory.
+     */
+    char* cloneAttributes(const char** source, int count);
+
+    /**
+     * Copies the accumulated events into the Java arrays.
+     */
+    void copyToJava(JNIEnv* env) {
+        env->SetIntArrayRegion(javaEvents, 0, eventLength, events);
+        env->SetCharArrayRegion(javaText, 0, textLength, text);
+    }
+
+    void clear() {
+        eventLength = 0;
+        textLength = 0;
+        stringCount = 0;
+        lastText = -1;
+        attributeChunkUsed = 0;
+        for (size_t i = 0; i < largeAttributes.size(); i++) {
+            delete[] largeAttributes[i];
+        }
+        largeAttributes.clear();
+    }
+
+    jintArray javaEvents;
+    jcharArray javaText;
+    jobjectArray javaStrings;
+
+    jint events[EVENT_CAPACITY];
+    int eventLength;
+
+    jchar text[TEXT_CAPACITY];
+    int textLength;
+
+    int stringCount;
+
+    /** Offset in 'events' of the most recent TEXT event, or -1. */
+    int lastText;
+
+private:
+    enum { ATTRIBUTE_CHUNK_SIZE = 16 * 1024 };
+
+    template <typename T>
+    static T newGlobalRef(JNIEnv* env, T localRef) {
+        if (localRef == NULL) {
+            return NULL;
+        }
+        T globalRef = reinterpret_cast<T>(env->NewGlobalRef(localRef));
+        env->DeleteLocalRef(localRef);
+        return globalRef;
+    }
+
+    /** Cloned attributes for the current batch, allocated sequentially. */
+    char* attributeChunk;
+    size_t attributeChunkUsed;
+
+    /** Cloned attributes too big for the chunk's remaining space. */
+    std::vector<char*> largeAttributes;
+};
+
+char* EventBatch::cloneAttributes(const char** source, int count) {
+    count <<= 1;
+    size_t arraySize = (count + 1) * sizeof(char*);
+    size_t totalSize = arraySize;
+    for (int i = 0; i < count; i++) {
+        totalSize += strlen(source[i]) + 1;
+    }
+    // Keep the pointer arrays aligned.
+    totalSize = (totalSize + sizeof(char*) - 1) & ~(sizeof(char*) - 1);
+
+    char* buffer;
+    if (attributeChunkUsed + totalSize <= ATTRIBUTE_CHUNK_SIZE) {
+        if (attributeChunk == NULL) {
+            attributeChunk = new char[ATTRIBUTE_CHUNK_SIZE];
+            if (attributeChunk == NULL) {
+                return NULL;
+            }
+        }
+        buffer = attributeChunk + attributeChunkUsed;
+        attributeChunkUsed += totalSize;
+    } else {
+        buffer = new char[totalSize];
+        if (buffer == NULL) {
+            return NULL;
+        }
+        largeAttributes.push_back(buffer);
+    }
+
+    char** clonedArray = reinterpret_cast<char**>(buffer);
+    clonedArray[count] = NULL;
+    char* destinationString = buffer + arraySize;
+    for (int i = 0; i < count; i++) {
+        size_t length = strlen(source[i]);
+        memcpy(destinationString, source[i], length + 1);
+        clonedArray[i] = destinationString;
+        destinationString += length + 1;
+    }
+    return buffer;
+}
+
 /**
  * Data passed to parser handler method by the parser.
  */
 struct ParsingContext {
-    ParsingContext(jobject object) : env(NULL), object(object), buffer(NULL), bufferSize(-1) {
-        for (int i = 0; i < BUCKET_COUNT; i++) {
-            internedStrings[i] = NULL;
-        }
+    ParsingContext(jobject object) : env(NULL), object(object), buffer(NULL), bufferSize(-1),
+            internPool(NULL), eventBatch(NULL), pullParser(NULL), upcallCount(0) {
     }
 
     // Warning: 'env' must be valid on entry.
@@ -115,31 +464,26 @@ struct ParsingContext {
         freeBuffer();
 
         // Free interned string cache.
-        for (int i = 0; i < BUCKET_COUNT; i++) {
-            if (internedStrings[i]) {
-                InternedString** bucket = internedStrings[i];
-                InternedString* current;
-                while ((current = *(bucket++)) != NULL) {
-                    // Free the interned string reference.
-                    env->DeleteGlobalRef(current->interned);
-
-                    // Free the bucket.
-                    delete current;
-                }
-
-                // Free the buckets.
-                delete[] internedStrings[i];
-            }
+        internedStrings.clear(env, false);
+        if (internPool != NULL) {
+            internPool->release(env);
+        }
+        if (eventBatch != NULL) {
+            eventBatch->release(env);
+            delete eventBatch;
         }
     }
 
     jcharArray ensureCapacity(int length) {
         if (bufferSize < length) {
+            // Grow geometrically so that slowly growing text doesn't reallocate every time.
+            int newSize = std::max(length, 2 * bufferSize);
+
             // Free the existing char[].
             freeBuffer();
 
             // Allocate a new char[].
-            jcharArray javaBuffer = env->NewCharArray(length);
+            jcharArray javaBuffer = env->NewCharArray(newSize);
             if (javaBuffer == NULL) return NULL;
 
             // Create a global reference.
@@ -147,12 +491,42 @@ struct ParsingContext {
             if (javaBuffer == NULL) return NULL;
 
             buffer = javaBuffer;
-            bufferSize = length;
+            bufferSize = newSize;
         }
         return buffer;
     }
 
+    /**
+     * Gets the context ready for another document, keeping the text buffer,
+     * event batch and interned strings that make reuse worthwhile.
+     */
+    void prepareForReuse() {
+        object = NULL;
+        attributes = NULL;
+        attributeCount = -1;
+        stringStack.clear();
+        if (internPool != NULL) {
+            // Our table may hold the pool's strings, which we're no longer entitled to.
+            internedStrings.clear(env, false);
+            internPool->release(env);
+            internPool = NULL;
+        } else if (internedStrings.size() > MAX_REUSED_INTERNED_STRINGS) {
+            internedStrings.clear(env, false);
+        }
+        if (eventBatch != NULL) {
+            eventBatch->clear();
+        }
+        pullParser = NULL;
+        upcallCount = 0;
+    }
+
 private:
+    /**
+     * The most interned strings we carry over to another document. Public and
+     * system ids vary from document to document, so we mustn't keep them all.
+     */
+    enum { MAX_REUSED_INTERNED_STRINGS = 1024 };
+
     void freeBuffer() {
         if (buffer != NULL) {
             env->DeleteGlobalRef(buffer);
@@ -192,7 +566,23 @@ public:
     StringStack stringStack;
 
     /** Cache of interned strings. */
-    InternedString** internedStrings[BUCKET_COUNT];
+    InternedStringTable internedStrings;
+
+    /** Interned strings shared with other parsers, or NULL. */
+    InternPool* internPool;
+
+    /** Events not yet delivered to Java, or NULL if we deliver each one as it happens. */
+    EventBatch* eventBatch;
+
+    /**
+     * In pull mode, the parser to suspend after each batched event; NULL
+     * otherwise. Entity parsers share our context, so we can't just use
+     * whichever parser called us.
+     */
+    XML_Parser pullParser;
+
+    /** The number of calls we've made to the Java parser, for benchmarks. */
+    int upcallCount;
 };
 
 static ParsingContext* toParsingContext(void* data) {
@@ -204,6 +594,7 @@ static ParsingContext* toParsingContext(XML_Parser parser) {
 }
 
 static jmethodID commentMethod;
+static jmethodID dispatchEventsMethod;
 static jmethodID endCdataMethod;
 static jmethodID endDtdMethod;
 static jmethodID endElementMethod;
@@ -238,6 +629,22 @@ static int hashString(const char* s) {
     return hash;
 }
 
+/**
+ * Returns a new Java string for the 0-terminated UTF-8 in 's', or NULL if 's' is NULL. Unlike
+ * NewStringUTF, which wants modified UTF-8, this copes with the four-byte sequences Expat uses
+ * for characters outside the BMP.
+ */
+static jstring newStringUtf8(JNIEnv* env, const char* s) {
+    if (s == NULL) {
+        return NULL;
+    }
+    size_t length = strlen(s);
+    LocalArray<1024> chars(length * sizeof(jchar));
+    jchar* dst = reinterpret_cast<jchar*>(&chars[0]);
+    size_t utf16Length = utf8ToUtf16(reinterpret_cast<const jbyte*>(s), length, dst);
+    return env->NewString(dst, utf16Length);
+}
+
 /**
  * Creates a new interned string wrapper. Looks up the interned string
  * representing the given UTF-8 bytes.
@@ -269,7 +676,7 @@ static InternedString* newInternedString(JNIEnv* env, const char* bytes, int has
 
     // To intern a string, we must first create a new string and then call
     // intern() on it. We then keep a global reference to the interned string.
-    ScopedLocalRef<jstring> newString(env, env->NewStringUTF(bytes));
+    ScopedLocalRef<jstring> newString(env, newStringUtf8(env, bytes));
     if (env->ExceptionCheck()) {
         return NULL;
     }
@@ -290,62 +697,24 @@ static InternedString* newInternedString(JNIEnv* env, const char* bytes, int has
     return wrapper.release();
 }
 
-/**
- * Allocates a new bucket with one entry.
- *
- * @param entry to store in the bucket
- * @returns a reference to the bucket
- */
-static InternedString** newInternedStringBucket(InternedString* entry) {
-    InternedString** bucket = new InternedString*[2];
-    if (bucket != NULL) {
-        bucket[0] = entry;
-        bucket[1] = NULL;
+InternedString* InternPool::intern(JNIEnv* env, const char* s, int hash) {
+    ScopedPthreadMutexLock lock(&mutex);
+    InternedString* entry = strings.find(s, hash);
+    if (entry != NULL || strings.size() >= MAX_POOLED_STRINGS) {
+        return entry;
     }
-    return bucket;
-}
-
-/**
- * Expands an interned string bucket and adds the given entry. Frees the
- * provided bucket and returns a new one.
- *
- * @param existingBucket the bucket to replace
- * @param entry to add to the bucket
- * @returns a reference to the newly-allocated bucket containing the given entry
- */
-static InternedString** expandInternedStringBucket(
-        InternedString** existingBucket, InternedString* entry) {
-    // Determine the size of the existing bucket.
-    int size = 0;
-    while (existingBucket[size]) size++;
-
-    // Allocate the new bucket with enough space for one more entry and
-    // a null terminator.
-    InternedString** newBucket = new InternedString*[size + 2];
-    if (newBucket == NULL) return NULL;
-
-    memcpy(newBucket, existingBucket, size * sizeof(InternedString*));
-    newBucket[size] = entry;
-    newBucket[size + 1] = NULL;
-
-    return newBucket;
-}
-
-/**
- * Returns an interned string for the given UTF-8 string.
- *
- * @param bucket to search for s
- * @param s null-terminated string to find
- * @param hash of s
- * @returns interned Java string equivalent of s or null if not found
- */
-static jstring findInternedString(InternedString** bucket, const char* s, int hash) {
-    InternedString* current;
-    while ((current = *(bucket++)) != NULL) {
-        if (current->hash != hash) continue;
-        if (!strcmp(s, current->bytes)) return current->interned;
+    entry = newInternedString(env, s, hash);
+    if (entry == NULL) {
+        return NULL;
     }
-    return NULL;
+    entry->pooled = true;
+    if (!strings.add(entry)) {
+        env->DeleteGlobalRef(entry->interned);
+        delete entry;
+        throw_OutOfMemoryError(env);
+        return NULL;
+    }
+    return entry;
 }
 
 /**
@@ -358,51 +727,34 @@ static jstring internString(JNIEnv* env, ParsingContext* parsingContext, const c
     if (s == NULL) return NULL;
 
     int hash = hashString(s);
-    int bucketIndex = hash & (BUCKET_COUNT - 1);
-
-    InternedString*** buckets = parsingContext->internedStrings;
-    InternedString** bucket = buckets[bucketIndex];
-    InternedString* internedString;
-
-    if (bucket) {
-        // We have a bucket already. Look for the given string.
-        jstring found = findInternedString(bucket, s, hash);
-        if (found) {
-            // We found it!
-            return found;
-        }
-
-        // We didn't find it. :(
-        // Create a new entry.
-        internedString = newInternedString(env, s, hash);
-        if (internedString == NULL) return NULL;
-
-        // Expand the bucket.
-        bucket = expandInternedStringBucket(bucket, internedString);
-        if (bucket == NULL) {
-            throw_OutOfMemoryError(env);
-            return NULL;
-        }
-
-        buckets[bucketIndex] = bucket;
-
+    InternedStringTable& table = parsingContext->internedStrings;
+    InternedString* internedString = table.find(s, hash);
+    if (internedString != NULL) {
+        // We found it!
         return internedString->interned;
-    } else {
-        // We don't even have a bucket yet. Create an entry.
+    }
+
+    // We didn't find it. Try the shared pool, if we have one, and fall back
+    // to creating an entry of our own.
+    internedString = NULL;
+    if (parsingContext->internPool != NULL) {
+        internedString = parsingContext->internPool->intern(env, s, hash);
+        if (env->ExceptionCheck()) return NULL;
+    }
+    if (internedString == NULL) {
         internedString = newInternedString(env, s, hash);
         if (internedString == NULL) return NULL;
+    }
 
-        // Create a new bucket with one entry.
-        bucket = newInternedStringBucket(internedString);
-        if (bucket == NULL) {
-            throw_OutOfMemoryError(env);
-            return NULL;
+    if (!table.add(internedString)) {
+        if (!internedString->pooled) {
+            env->DeleteGlobalRef(internedString->interned);
+            delete internedString;
         }
-
-        buckets[bucketIndex] = bucket;
-
-        return internedString->interned;
+        throw_OutOfMemoryError(env);
+        return NULL;
     }
+    return internedString->interned;
 }
 
 static void jniThrowExpatException(JNIEnv* env, XML_Error error) {
@@ -431,9 +783,7 @@ static size_t fillBuffer(ParsingContext* parsingContext, const char* characters,
         return -1;
     }
 
-    size_t utf16length;
-    strcpylen8to16(nativeBuffer.get(), characters, length, &utf16length);
-    return utf16length;
+    return utf8ToUtf16(reinterpret_cast<const jbyte*>(characters), length, nativeBuffer.get());
 }
 
 /**
@@ -458,9 +808,96 @@ static void bufferAndInvoke(jmethodID method, void* data, const char* text, size
     // Invoke given method.
     jobject javaParser = parsingContext->object;
     jcharArray buffer = parsingContext->buffer;
+    parsingContext->upcallCount++;
     env->CallVoidMethod(javaParser, method, buffer, utf16length);
 }
 
+/**
+ * Delivers any batched events to Java. Handlers for events we don't batch
+ * call this first, so that everything arrives in document order.
+ *
+ * @param parsingContext the parsing context
+ * @returns false if a handler threw an exception
+ */
+static bool flushEvents(ParsingContext* parsingContext) {
+    EventBatch* batch = parsingContext->eventBatch;
+    if (batch == NULL || batch->isEmpty()) {
+        return true;
+    }
+
+    JNIEnv* env = parsingContext->env;
+    batch->copyToJava(env);
+    parsingContext->upcallCount++;
+    env->CallVoidMethod(parsingContext->object, dispatchEventsMethod, batch->javaEvents,
+            batch->eventLength, batch->javaText, batch->javaStrings);
+    // The cloned attributes were only needed until the handlers had seen them.
+    batch->clear();
+    return !env->ExceptionCheck();
+}
+
+/**
+ * Adds a text or comment event to the batch, or delivers it directly if it
+ * won't fit in an empty batch.
+ *
+ * @param type EventBatch::TEXT or EventBatch::COMMENT
+ * @param method to pass the characters and length to if we can't batch them
+ * @param data parsing context
+ * @param text to copy into the buffer
+ * @param length of text to copy (in bytes)
+ */
+static void batchText(int type, jmethodID method, void* data, const char* text, size_t length) {
+    ParsingContext* parsingContext = toParsingContext(data);
+    JNIEnv* env = parsingContext->env;
+
+    // Bail out if a previously called handler threw an exception.
+    if (env->ExceptionCheck()) return;
+
+    // UTF-8 never takes fewer bytes than UTF-16 takes chars, so 'length' jchars is enough.
+    EventBatch* batch = parsingContext->eventBatch;
+    if (!batch->hasRoom(3, length, 0)) {
+        if (!flushEvents(parsingContext)) return;
+        if (!batch->hasRoom(3, length, 0)) {
+            bufferAndInvoke(method, data, text, length);
+            return;
+        }
+    }
+
+    size_t utf16length = utf8ToUtf16(reinterpret_cast<const jbyte*>(text), length,
+            &batch->text[batch->textLength]);
+    // Expat splits text at line ends, entities and buffer boundaries; join up the pieces.
+    if (type == EventBatch::TEXT && batch->lastText != -1
+            && batch->lastText + 3 == batch->eventLength) {
+        batch->events[batch->lastText + 2] += utf16length;
+        batch->textLength += utf16length;
+        return;
+    }
+    if (type == EventBatch::TEXT) {
+        batch->lastText = batch->eventLength;
+    }
+    batch->addInt(type);
+    batch->addInt(batch->textLength);
+    batch->addInt(utf16length);
+    batch->textLength += utf16length;
+}
+
+/**
+ * In pull mode, asks Expat to return to its caller once it has finished the
+ * current token, so that the consumer sees about one event per append or
+ * resume rather than a whole buffer's worth. We don't stop for text, which
+ * keeps contiguous text together in a single event.
+ */
+static void suspendIfPulling(ParsingContext* parsingContext) {
+    XML_Parser parser = parsingContext->pullParser;
+    if (parser == NULL) {
+        return;
+    }
+    XML_ParsingStatus status;
+    XML_GetParsingStatus(parser, &status);
+    if (status.parsing == XML_PARSING) {
+        XML_StopParser(parser, XML_TRUE);
+    }
+}
+
 static const char** toAttributes(jint attributePointer) {
     return reinterpret_cast<const char**>(static_cast<uintptr_t>(attributePointer));
 }
@@ -625,6 +1062,31 @@ static void startElement(void* data, const char* elementName, const char** attri
     parsingContext->stringStack.push(env, uri);
     parsingContext->stringStack.push(env, localName);
 
+    EventBatch* batch = parsingContext->eventBatch;
+    if (batch != NULL) {
+        parsingContext->attributes = NULL;
+        parsingContext->attributeCount = -1;
+        if (!batch->hasRoom(6, 0, 3) && !flushEvents(parsingContext)) return;
+        // Expat reuses its attribute memory once we return, so keep a copy for the handlers.
+        char* clonedAttributes = NULL;
+        if (count > 0) {
+            clonedAttributes = batch->cloneAttributes(attributes, count);
+            if (clonedAttributes == NULL) {
+                throw_OutOfMemoryError(env);
+                return;
+            }
+        }
+        batch->addInt(EventBatch::START_ELEMENT);
+        batch->addInt(batch->addString(env, uri));
+        batch->addInt(batch->addString(env, localName));
+        batch->addInt(batch->addString(env, qName));
+        batch->addInt(static_cast<jint>(reinterpret_cast<uintptr_t>(clonedAttributes)));
+        batch->addInt(count);
+        suspendIfPulling(parsingContext);
+        return;
+    }
+
+    parsingContext->upcallCount++;
     env->CallVoidMethod(javaParser, startElementMethod, uri, localName, qName, attributes, count);
 
     parsingContext->attributes = NULL;
@@ -652,6 +1114,18 @@ static void endElement(void* data, const char* /*elementName*/) {
     jstring uri = parsingContext->stringStack.pop();
     jstring qName = parsingContext->stringStack.pop();
 
+    EventBatch* batch = parsingContext->eventBatch;
+    if (batch != NULL) {
+        if (!batch->hasRoom(4, 0, 3) && !flushEvents(parsingContext)) return;
+        batch->addInt(EventBatch::END_ELEMENT);
+        batch->addInt(batch->addString(env, uri));
+        batch->addInt(batch->addString(env, localName));
+        batch->addInt(batch->addString(env, qName));
+        suspendIfPulling(parsingContext);
+        return;
+    }
+
+    parsingContext->upcallCount++;
     env->CallVoidMethod(javaParser, endElementMethod, uri, localName, qName);
 }
 
@@ -665,7 +1139,11 @@ static void endElement(void* data, const char* /*elementName*/) {
  * @param length number of characters in the buffer
  */
 static void text(void* data, const char* characters, int length) {
-    bufferAndInvoke(textMethod, data, characters, length);
+    if (toParsingContext(data)->eventBatch != NULL) {
+        batchText(EventBatch::TEXT, textMethod, data, characters, length);
+    } else {
+        bufferAndInvoke(textMethod, data, characters, length);
+    }
 }
 
 /**
@@ -676,7 +1154,12 @@ static void text(void* data, const char* characters, int length) {
  * @param comment 0-terminated
  */
 static void comment(void* data, const char* comment) {
-    bufferAndInvoke(commentMethod, data, comment, strlen(comment));
+    if (toParsingContext(data)->eventBatch != NULL) {
+        batchText(EventBatch::COMMENT, commentMethod, data, comment, strlen(comment));
+        suspendIfPulling(toParsingContext(data));
+    } else {
+        bufferAndInvoke(commentMethod, data, comment, strlen(comment));
+    }
 }
 
 /**
@@ -692,6 +1175,7 @@ static void startNamespace(void* data, const char* prefix, const char* uri) {
 
     // Bail out if a previously called handler threw an exception.
     if (env->ExceptionCheck()) return;
+    if (!flushEvents(parsingContext)) return;
 
     jstring internedPrefix = emptyString;
     if (prefix != NULL) {
@@ -708,6 +1192,7 @@ static void startNamespace(void* data, const char* prefix, const char* uri) {
     parsingContext->stringStack.push(env, internedPrefix);
 
     jobject javaParser = parsingContext->object;
+    parsingContext->upcallCount++;
     env->CallVoidMethod(javaParser, startNamespaceMethod, internedPrefix, internedUri);
 }
 
@@ -724,10 +1209,12 @@ static void endNamespace(void* data, const char* /*prefix*/) {
 
     // Bail out if a previously called handler threw an exception.
     if (env->ExceptionCheck()) return;
+    if (!flushEvents(parsingContext)) return;
 
     jstring internedPrefix = parsingContext->stringStack.pop();
 
     jobject javaParser = parsingContext->object;
+    parsingContext->upcallCount++;
     env->CallVoidMethod(javaParser, endNamespaceMethod, internedPrefix);
 }
 
@@ -742,8 +1229,10 @@ static void startCdata(void* data) {
 
     // Bail out if a previously called handler threw an exception.
     if (env->ExceptionCheck()) return;
+    if (!flushEvents(parsingContext)) return;
 
     jobject javaParser = parsingContext->object;
+    parsingContext->upcallCount++;
     env->CallVoidMethod(javaParser, startCdataMethod);
 }
 
@@ -758,8 +1247,10 @@ static void endCdata(void* data) {
 
     // Bail out if a previously called handler threw an exception.
     if (env->ExceptionCheck()) return;
+    if (!flushEvents(parsingContext)) return;
 
     jobject javaParser = parsingContext->object;
+    parsingContext->upcallCount++;
     env->CallVoidMethod(javaParser, endCdataMethod);
 }
 
@@ -774,6 +1265,7 @@ static void startDtd(void* data, const char* name,
 
     // Bail out if a previously called handler threw an exception.
     if (env->ExceptionCheck()) return;
+    if (!flushEvents(parsingContext)) return;
 
     jstring javaName = internString(env, parsingContext, name);
     if (env->ExceptionCheck()) return;
@@ -785,6 +1277,7 @@ static void startDtd(void* data, const char* name,
     if (env->ExceptionCheck()) return;
 
     jobject javaParser = parsingContext->object;
+    parsingContext->upcallCount++;
     env->CallVoidMethod(javaParser, startDtdMethod, javaName, javaPublicId,
         javaSystemId);
 }
@@ -800,8 +1293,10 @@ static void endDtd(void* data) {
 
     // Bail out if a previously called handler threw an exception.
     if (env->ExceptionCheck()) return;
+    if (!flushEvents(parsingContext)) return;
 
     jobject javaParser = parsingContext->object;
+    parsingContext->upcallCount++;
     env->CallVoidMethod(javaParser, endDtdMethod);
 }
 
@@ -818,14 +1313,16 @@ static void processingInstruction(void* data, const char* target, const char* in
 
     // Bail out if a previously called handler threw an exception.
     if (env->ExceptionCheck()) return;
+    if (!flushEvents(parsingContext)) return;
 
     jstring javaTarget = internString(env, parsingContext, target);
     if (env->ExceptionCheck()) return;
 
-    ScopedLocalRef<jstring> javaInstructionData(env, env->NewStringUTF(instructionData));
+    ScopedLocalRef<jstring> javaInstructionData(env, newStringUtf8(env, instructionData));
     if (env->ExceptionCheck()) return;
 
     jobject javaParser = parsingContext->object;
+    parsingContext->upcallCount++;
     env->CallVoidMethod(javaParser, processingInstructionMethod, javaTarget, javaInstructionData.get());
 }
 
@@ -868,21 +1365,25 @@ static int handleExternalEntity(XML_Parser parser, const char* context,
     if (env->ExceptionCheck()) {
         return XML_STATUS_ERROR;
     }
+    if (!flushEvents(parsingContext)) {
+        return XML_STATUS_ERROR;
+    }
 
-    ScopedLocalRef<jstring> javaSystemId(env, env->NewStringUTF(systemId));
+    ScopedLocalRef<jstring> javaSystemId(env, newStringUtf8(env, systemId));
     if (env->ExceptionCheck()) {
         return XML_STATUS_ERROR;
     }
-    ScopedLocalRef<jstring> javaPublicId(env, env->NewStringUTF(publicId));
+    ScopedLocalRef<jstring> javaPublicId(env, newStringUtf8(env, publicId));
     if (env->ExceptionCheck()) {
         return XML_STATUS_ERROR;
     }
-    ScopedLocalRef<jstring> javaContext(env, env->NewStringUTF(context));
+    ScopedLocalRef<jstring> javaContext(env, newStringUtf8(env, context));
     if (env->ExceptionCheck()) {
         return XML_STATUS_ERROR;
     }
 
     // Pass the wrapped parser and both strings to java.
+    parsingContext->upcallCount++;
     env->CallVoidMethod(javaParser, handleExternalEntityMethod, javaContext.get(),
             javaPublicId.get(), javaSystemId.get());
 
@@ -909,16 +1410,18 @@ static void unparsedEntityDecl(void* data, const char* name, const char* /*base*
 
     // Bail out if a previously called handler threw an exception.
     if (env->ExceptionCheck()) return;
+    if (!flushEvents(parsingContext)) return;
 
-    ScopedLocalRef<jstring> javaName(env, env->NewStringUTF(name));
+    ScopedLocalRef<jstring> javaName(env, newStringUtf8(env, name));
     if (env->ExceptionCheck()) return;
-    ScopedLocalRef<jstring> javaPublicId(env, env->NewStringUTF(publicId));
+    ScopedLocalRef<jstring> javaPublicId(env, newStringUtf8(env, publicId));
     if (env->ExceptionCheck()) return;
-    ScopedLocalRef<jstring> javaSystemId(env, env->NewStringUTF(systemId));
+    ScopedLocalRef<jstring> javaSystemId(env, newStringUtf8(env, systemId));
     if (env->ExceptionCheck()) return;
-    ScopedLocalRef<jstring> javaNotationName(env, env->NewStringUTF(notationName));
+    ScopedLocalRef<jstring> javaNotationName(env, newStringUtf8(env, notationName));
     if (env->ExceptionCheck()) return;
 
+    parsingContext->upcallCount++;
     env->CallVoidMethod(javaParser, unparsedEntityDeclMethod, javaName.get(), javaPublicId.get(), javaSystemId.get(), javaNotationName.get());
 }
 
@@ -932,73 +1435,176 @@ static void notationDecl(void* data, const char* name, const char* /*base*/, con
 
     // Bail out if a previously called handler threw an exception.
     if (env->ExceptionCheck()) return;
+    if (!flushEvents(parsingContext)) return;
 
-    ScopedLocalRef<jstring> javaName(env, env->NewStringUTF(name));
+    ScopedLocalRef<jstring> javaName(env, newStringUtf8(env, name));
     if (env->ExceptionCheck()) return;
-    ScopedLocalRef<jstring> javaPublicId(env, env->NewStringUTF(publicId));
+    ScopedLocalRef<jstring> javaPublicId(env, newStringUtf8(env, publicId));
     if (env->ExceptionCheck()) return;
-    ScopedLocalRef<jstring> javaSystemId(env, env->NewStringUTF(systemId));
+    ScopedLocalRef<jstring> javaSystemId(env, newStringUtf8(env, systemId));
     if (env->ExceptionCheck()) return;
 
+    parsingContext->upcallCount++;
     env->CallVoidMethod(javaParser, notationDeclMethod, javaName.get(), javaPublicId.get(), javaSystemId.get());
 }
 
 /**
- * Creates a new Expat parser. Called from the Java ExpatParser constructor.
+ * A parser and its context, reset and waiting for another document with the
+ * same encoding and namespace setting.
+ */
+struct PooledParser {
+    XML_Parser parser;
+    ParsingContext* context;
+    std::string encoding;
+    bool processNamespaces;
+};
+
+/**
+ * The most parsers we keep for reuse, across all configurations. Each costs
+ * Expat's own tables plus our buffers and interned strings.
+ */
+static const size_t MAX_POOLED_PARSERS = 8;
+
+static pthread_mutex_t gParserPoolMutex = PTHREAD_MUTEX_INITIALIZER;
+static std::vector<PooledParser> gParserPool;
+
+/**
+ * Removes a pooled parser matching the given configuration from the pool.
+ * Returns its context, or NULL if there wasn't one.
+ */
+static ParsingContext* takePooledParser(const char* encoding, bool processNamespaces,
+        XML_Parser* parser) {
+    ScopedPthreadMutexLock lock(&gParserPoolMutex);
+    for (size_t i = gParserPool.size(); i-- > 0; ) {
+        PooledParser& pooled = gParserPool[i];
+        if (pooled.processNamespaces == processNamespaces && pooled.encoding == encoding) {
+            ParsingContext* context = pooled.context;
+            *parser = pooled.parser;
+            gParserPool.erase(gParserPool.begin() + i);
+            return context;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Installs our handlers on a new or newly reset parser.
+ */
+static void setHandlers(XML_Parser parser, bool processNamespaces) {
+    if (processNamespaces) {
+        XML_SetNamespaceDeclHandler(parser, startNamespace, endNamespace);
+        XML_SetReturnNSTriplet(parser, 1);
+    }
+
+    XML_SetCdataSectionHandler(parser, startCdata, endCdata);
+    XML_SetCharacterDataHandler(parser, text);
+    XML_SetCommentHandler(parser, comment);
+    XML_SetDoctypeDeclHandler(parser, startDtd, endDtd);
+    XML_SetElementHandler(parser, startElement, endElement);
+    XML_SetExternalEntityRefHandler(parser, handleExternalEntity);
+    XML_SetNotationDeclHandler(parser, notationDecl);
+    XML_SetProcessingInstructionHandler(parser, processingInstruction);
+    XML_SetUnparsedEntityDeclHandler(parser, unparsedEntityDecl);
+}
+
+/**
+ * Creates a new Expat parser, or reuses one a previous document has finished
+ * with. Called from the Java ExpatParser constructor.
  *
  * @param object the Java ExpatParser instance
  * @param javaEncoding the character encoding name
  * @param processNamespaces true if the parser should handle namespaces
+ * @param internPoolPointer the InternPool to share, or 0
+ * @param batchEvents true to deliver element, text and comment events in batches
+ * @param pullEvents true to also suspend after each of those events but text; implies batching
  * @returns the pointer to the C Expat parser
  */
 static jint ExpatParser_initialize(JNIEnv* env, jobject object, jstring javaEncoding,
-        jboolean processNamespaces) {
-    // Allocate parsing context.
-    UniquePtr<ParsingContext> context(new ParsingContext(object));
-    if (context.get() == NULL) {
-        throw_OutOfMemoryError(env);
+        jboolean processNamespaces, jint internPoolPointer, jboolean batchEvents,
+        jboolean pullEvents) {
+    ScopedUtfChars encoding(env, javaEncoding);
+    if (encoding.c_str() == NULL) {
         return 0;
     }
 
-    context->processNamespaces = (bool) processNamespaces;
+    // Take a reset parser and context from the pool if there's a suitable one.
+    XML_Parser parser = NULL;
+    UniquePtr<ParsingContext> context(takePooledParser(encoding.c_str(), processNamespaces,
+            &parser));
+    if (context.get() == NULL) {
+        context.reset(new ParsingContext(object));
+        if (context.get() == NULL) {
+            throw_OutOfMemoryError(env);
+            return 0;
+        }
+    }
+    context->object = object;
 
-    // Create a parser.
-    XML_Parser parser;
-    ScopedUtfChars encoding(env, javaEncoding);
-    if (encoding.c_str() == NULL) {
-        return 0;
+    context->processNamespaces = (bool) processNamespaces;
+    if (internPoolPointer != 0) {
+        context->internPool = reinterpret_cast<InternPool*>(static_cast<uintptr_t>(internPoolPointer));
+        context->internPool->acquire();
     }
-    if (processNamespaces) {
-        // Use '|' to separate URIs from local names.
-        parser = XML_ParserCreateNS(encoding.c_str(), '|');
-    } else {
-        parser = XML_ParserCreate(encoding.c_str());
+    // The context's destructor needs an env if it's freed on one of the early returns below.
+    context->env = env;
+    if (batchEvents || pullEvents) {
+        if (context->eventBatch == NULL) {
+            context->eventBatch = new EventBatch;
+            if (context->eventBatch == NULL) {
+                throw_OutOfMemoryError(env);
+            }
+            if (context->eventBatch == NULL || !context->eventBatch->init(env)) {
+                // A pooled parser has no user data yet, so nothing else will free it.
+                if (parser != NULL) {
+                    XML_ParserFree(parser);
+                }
+                return 0;
+            }
+        }
+    } else if (context->eventBatch != NULL) {
+        context->eventBatch->release(env);
+        delete context->eventBatch;
+        context->eventBatch = NULL;
     }
 
-    if (parser != NULL) {
+    // Create a parser if the pool didn't have one.
+    if (parser == NULL) {
         if (processNamespaces) {
-            XML_SetNamespaceDeclHandler(parser, startNamespace, endNamespace);
-            XML_SetReturnNSTriplet(parser, 1);
+            // Use '|' to separate URIs from local names.
+            parser = XML_ParserCreateNS(encoding.c_str(), '|');
+        } else {
+            parser = XML_ParserCreate(encoding.c_str());
+        }
+        if (parser == NULL) {
+            throw_OutOfMemoryError(env);
+            return 0;
         }
+    }
 
-        XML_SetCdataSectionHandler(parser, startCdata, endCdata);
-        XML_SetCharacterDataHandler(parser, text);
-        XML_SetCommentHandler(parser, comment);
-        XML_SetDoctypeDeclHandler(parser, startDtd, endDtd);
-        XML_SetElementHandler(parser, startElement, endElement);
-        XML_SetExternalEntityRefHandler(parser, handleExternalEntity);
-        XML_SetNotationDeclHandler(parser, notationDecl);
-        XML_SetProcessingInstructionHandler(parser, processingInstruction);
-        XML_SetUnparsedEntityDeclHandler(parser, unparsedEntityDecl);
-        XML_SetUserData(parser, context.release());
-    } else {
-        throw_OutOfMemoryError(env);
-        return 0;
+    setHandlers(parser, processNamespaces);
+    if (pullEvents) {
+        context->pullParser = parser;
     }
+    context->env = NULL;
+    XML_SetUserData(parser, context.release());
 
     return (jint) parser;
 }
 
+/**
+ * Cleans up after one of the append functions has given Expat its input.
+ */
+static void finishAppend(JNIEnv* env, ParsingContext* context) {
+    // Hand over whatever's left in the batch before returning, unless we're failing anyway.
+    if (!env->ExceptionCheck()) {
+        flushEvents(context);
+    } else if (context->eventBatch != NULL) {
+        context->eventBatch->clear();
+    }
+    context->object = NULL;
+    context->env = NULL;
+}
+
 /**
  * Expat decides for itself what character encoding it's looking at. The interface is in terms of
  * bytes, which may point to UTF-8, UTF-16, ISO-8859-1, or US-ASCII. appendBytes, appendCharacters,
@@ -1013,8 +1619,7 @@ static void append(JNIEnv* env, jobject object, jint pointer,
     if (!XML_Parse(parser, bytes + byteOffset, byteCount, isFinal) && !env->ExceptionCheck()) {
         jniThrowExpatException(env, XML_GetErrorCode(parser));
     }
-    context->object = NULL;
-    context->env = NULL;
+    finishAppend(env, context);
 }
 
 static void ExpatParser_appendBytes(JNIEnv* env, jobject object, jint pointer,
@@ -1049,6 +1654,83 @@ static void ExpatParser_appendString(JNIEnv* env, jobject object, jint pointer,
     append(env, object, pointer, bytes, 0, byteCount, isFinal);
 }
 
+/**
+ * Lets a parser in pull mode carry on with the input it already has after
+ * suspending to deliver an event.
+ *
+ * @returns false, doing nothing, if the parser isn't suspended and so needs
+ *  more input
+ */
+static jboolean ExpatParser_resumeParser(JNIEnv* env, jobject object, jint pointer) {
+    XML_Parser parser = (XML_Parser) pointer;
+    XML_ParsingStatus status;
+    XML_GetParsingStatus(parser, &status);
+    if (status.parsing != XML_SUSPENDED) {
+        return JNI_FALSE;
+    }
+
+    ParsingContext* context = toParsingContext(parser);
+    context->env = env;
+    context->object = object;
+    if (XML_ResumeParser(parser) == XML_STATUS_ERROR && !env->ExceptionCheck()) {
+        jniThrowExpatException(env, XML_GetErrorCode(parser));
+    }
+    finishAppend(env, context);
+    return JNI_TRUE;
+}
+
+/**
+ * How much we read at a time.
+ */
+static const int READ_BUFFER_SIZE = 64 * 1024;
+
+/**
+ * Parses everything from a file descriptor's current offset to the end of
+ * the file without copying it into the Java heap. The bytes are read
+ * straight into Expat's own buffer, which is the one copy Expat needs
+ * anyway: XML_Parse would copy mapped pages into that buffer too, and a
+ * mapping would leave us open to SIGBUS if the file were truncated.
+ *
+ * @param object the Java ExpatParser instance
+ * @param pointer to the C expat parser
+ * @param javaFd the file descriptor to read
+ */
+static void ExpatParser_appendFd(JNIEnv* env, jobject object, jint pointer, jobject javaFd) {
+    int fd = jniGetFDFromFileDescriptor(env, javaFd);
+    if (fd == -1) {
+        jniThrowIOException(env, EBADF);
+        return;
+    }
+
+    XML_Parser parser = (XML_Parser) pointer;
+    ParsingContext* context = toParsingContext(parser);
+    context->env = env;
+    context->object = object;
+
+    while (true) {
+        void* buffer = XML_GetBuffer(parser, READ_BUFFER_SIZE);
+        if (buffer == NULL) {
+            throw_OutOfMemoryError(env);
+            break;
+        }
+        ssize_t byteCount = TEMP_FAILURE_RETRY(read(fd, buffer, READ_BUFFER_SIZE));
+        if (byteCount == -1) {
+            jniThrowIOException(env, errno);
+            break;
+        }
+        if (byteCount == 0) {
+            break;
+        }
+        if (!XML_ParseBuffer(parser, byteCount, XML_FALSE) || env->ExceptionCheck()) {
+            if (!env->ExceptionCheck()) {
+                jniThrowExpatException(env, XML_GetErrorCode(parser));
+            }
+            break;
+        }
+    }
+    finishAppend(env, context);
+}
+
 /**
  * Releases parser only.
  *
@@ -1076,6 +1758,48 @@ static void ExpatParser_release(JNIEnv* env, jobject, jint i) {
     XML_ParserFree(parser);
 }
 
+/**
+ * Resets the parser and keeps it and its context for another document with
+ * the same configuration, or frees both if the pool is full. Called once
+ * ExpatReader has finished with a document.
+ *
+ * @param object the Java ExpatParser instance
+ * @param pointer to the C expat parser
+ * @param javaEncoding the encoding the parser was created with
+ */
+static void ExpatParser_recycleParser(JNIEnv* env, jobject, jint pointer, jstring javaEncoding) {
+    XML_Parser parser = (XML_Parser) pointer;
+    ParsingContext* context = toParsingContext(parser);
+    context->env = env;
+
+    ScopedUtfChars encoding(env, javaEncoding);
+    if (encoding.c_str() != NULL && XML_ParserReset(parser, encoding.c_str())) {
+        context->prepareForReuse();
+        context->env = NULL;
+        ScopedPthreadMutexLock lock(&gParserPoolMutex);
+        if (gParserPool.size() < MAX_POOLED_PARSERS) {
+            PooledParser pooled = { parser, context, encoding.c_str(), context->processNamespaces };
+            gParserPool.push_back(pooled);
+            return;
+        }
+        context->env = env;
+    }
+
+    delete context;
+    XML_ParserFree(parser);
+}
+
+/**
+ * Returns the number of calls the parser has made to the Java parser.
+ *
+ * @param object the Java ExpatParser instance
+ * @param pointer to the C expat parser
+ */
+static jint ExpatParser_getUpcallCount(JNIEnv*, jobject, jint pointer) {
+    XML_Parser parser = (XML_Parser) pointer;
+    return toParsingContext(parser)->upcallCount;
+}
+
 /**
  * Gets the current line.
  *
@@ -1149,18 +1873,66 @@ static jstring ExpatAttributes_getQName(JNIEnv* env, jobject, jint pointer,
 }
 
 /**
- * Gets the value of the attribute at the given index.
+ * Gets the values of all the attributes at once.
  *
- * @param object Java ExpatParser instance
  * @param attributePointer to the attribute array
- * @param index of the attribute
- * @returns Java string containing attribute's value
+ * @param count number of attributes
+ * @returns Java strings containing the attributes' values
  */
-static jstring ExpatAttributes_getValueByIndex(JNIEnv* env, jobject,
-        jint attributePointer, jint index) {
+static jobjectArray ExpatAttributes_getValues(JNIEnv* env, jclass,
+        jint attributePointer, jint count) {
+    jobjectArray result = env->NewObjectArray(count, JniConstants::stringClass, NULL);
+    if (result == NULL) {
+        return NULL;
+    }
     const char** attributes = toAttributes(attributePointer);
-    const char* value = attributes[(index << 1) + 1];
-    return env->NewStringUTF(value);
+    for (int index = 0; index < count; ++index) {
+        ScopedLocalRef<jstring> value(env, newStringUtf8(env, attributes[(index << 1) + 1]));
+        if (value.get() == NULL) {
+            return NULL;
+        }
+        env->SetObjectArrayElement(result, index, value.get());
+    }
+    return result;
+}
+
+/**
+ * Gets the local or qualified names of all the attributes at once.
+ *
+ * @param pointer to the C expat parser
+ * @param attributePointer to the attribute array
+ * @param count number of attributes
+ * @param qualified true for qualified names, false for local names
+ * @returns interned Java strings containing the attributes' names
+ */
+static jobjectArray getAttributeNames(JNIEnv* env, jint pointer, jint attributePointer,
+        jint count, bool qualified) {
+    jobjectArray result = env->NewObjectArray(count, JniConstants::stringClass, NULL);
+    if (result == NULL) {
+        return NULL;
+    }
+    XML_Parser parser = (XML_Parser) pointer;
+    ParsingContext* context = toParsingContext(parser);
+    for (int index = 0; index < count; ++index) {
+        ExpatElementName name(env, context, attributePointer, index);
+        // Interned strings are global references, so there's no local reference to delete.
+        jstring s = qualified ? name.qName() : name.localName();
+        if (env->ExceptionCheck()) {
+            return NULL;
+        }
+        env->SetObjectArrayElement(result, index, s);
+    }
+    return result;
+}
+
+static jobjectArray ExpatAttributes_getLocalNames(JNIEnv* env, jclass, jint pointer,
+        jint attributePointer, jint count) {
+    return getAttributeNames(env, pointer, attributePointer, count, false);
+}
+
+static jobjectArray ExpatAttributes_getQNames(JNIEnv* env, jclass, jint pointer,
+        jint attributePointer, jint count) {
+    return getAttributeNames(env, pointer, attributePointer, count, true);
 }
 
 /**
@@ -1221,38 +1993,6 @@ static jint ExpatAttributes_getIndex(JNIEnv* env, jobject, jint attributePointer
     return -1;
 }
 
-/**
- * Gets the value of the attribute with the given qualified name.
- *
- * @param attributePointer to the attribute array
- * @param uri to look for
- * @param localName to look for
- * @returns value of attribute with the given uri and local name or NULL if not
- *  found
- */
-static jstring ExpatAttributes_getValueForQName(JNIEnv* env, jobject clazz,
-        jint attributePointer, jstring qName) {
-    jint index = ExpatAttributes_getIndexForQName(env, clazz, attributePointer, qName);
-    return index == -1 ? NULL
-            : ExpatAttributes_getValueByIndex(env, clazz, attributePointer, index);
-}
-
-/**
- * Gets the value of the attribute with the given URI and name.
- *
- * @param attributePointer to the attribute array
- * @param uri to look for
- * @param localName to look for
- * @returns value of attribute with the given uri and local name or NULL if not
- *  found
- */
-static jstring ExpatAttributes_getValue(JNIEnv* env, jobject clazz,
-        jint attributePointer, jstring uri, jstring localName) {
-    jint index = ExpatAttributes_getIndex(env, clazz, attributePointer, uri, localName);
-    return index == -1 ? NULL
-            : ExpatAttributes_getValueByIndex(env, clazz, attributePointer, index);
-}
-
 /**
  * Clones an array of strings. Uses one contiguous block of memory so as to
  * maximize performance.
@@ -1304,6 +2044,30 @@ static void ExpatAttributes_freeAttributes(JNIEnv*, jobject, jint pointer) {
     delete[] reinterpret_cast<char*>(static_cast<uintptr_t>(pointer));
 }
 
+/**
+ * Creates a pool of interned strings that parsers can share.
+ *
+ * @returns pointer to the native InternPool
+ */
+static jint ExpatInternPool_create(JNIEnv* env, jclass) {
+    InternPool* pool = new InternPool;
+    if (pool == NULL) {
+        throw_OutOfMemoryError(env);
+        return 0;
+    }
+    return static_cast<jint>(reinterpret_cast<uintptr_t>(pool));
+}
+
+/**
+ * Drops the Java ExpatInternPool's hold on the native pool. Parsers still
+ * using it keep it alive until they're released.
+ *
+ * @param pointer to the native InternPool
+ */
+static void ExpatInternPool_release(JNIEnv* env, jclass, jint pointer) {
+    reinterpret_cast<InternPool*>(static_cast<uintptr_t>(pointer))->release(env);
+}
+
 /**
  * Called when we initialize our Java parser class.
  *
@@ -1325,6 +2089,10 @@ static void ExpatParser_staticInitialize(JNIEnv* env, jobject classObject, jstri
     commentMethod = env->GetMethodID(clazz, "comment", "([CI)V");
     if (commentMethod == NULL) return;
 
+    dispatchEventsMethod = env->GetMethodID(clazz, "dispatchEvents",
+        "([II[C[Ljava/lang/String;)V");
+    if (dispatchEventsMethod == NULL) return;
+
     startCdataMethod = env->GetMethodID(clazz, "startCdata", "()V");
     if (startCdataMethod == NULL) return;
 
@@ -1374,13 +2142,17 @@ static JNINativeMethod parserMethods[] = {
     NATIVE_METHOD(ExpatParser, appendString, "(ILjava/lang/String;Z)V"),
     NATIVE_METHOD(ExpatParser, appendBytes, "(I[BII)V"),
     NATIVE_METHOD(ExpatParser, appendChars, "(I[CII)V"),
+    NATIVE_METHOD(ExpatParser, appendFd, "(ILjava/io/FileDescriptor;)V"),
     NATIVE_METHOD(ExpatParser, cloneAttributes, "(II)I"),
     NATIVE_METHOD(ExpatParser, column, "(I)I"),
     NATIVE_METHOD(ExpatParser, createEntityParser, "(ILjava/lang/String;)I"),
-    NATIVE_METHOD(ExpatParser, initialize, "(Ljava/lang/String;Z)I"),
+    NATIVE_METHOD(ExpatParser, getUpcallCount, "(I)I"),
+    NATIVE_METHOD(ExpatParser, initialize, "(Ljava/lang/String;ZIZZ)I"),
     NATIVE_METHOD(ExpatParser, line, "(I)I"),
+    NATIVE_METHOD(ExpatParser, recycleParser, "(ILjava/lang/String;)V"),
     NATIVE_METHOD(ExpatParser, release, "(I)V"),
     NATIVE_METHOD(ExpatParser, releaseParser, "(I)V"),
+    NATIVE_METHOD(ExpatParser, resumeParser, "(I)Z"),
     NATIVE_METHOD(ExpatParser, staticInitialize, "(Ljava/lang/String;)V"),
 };
 
@@ -1389,13 +2161,19 @@ static JNINativeMethod attributeMethods[] = {
     NATIVE_METHOD(ExpatAttributes, getIndexForQName, "(ILjava/lang/String;)I"),
     NATIVE_METHOD(ExpatAttributes, getIndex, "(ILjava/lang/String;Ljava/lang/String;)I"),
     NATIVE_METHOD(ExpatAttributes, getLocalName, "(III)Ljava/lang/String;"),
+    NATIVE_METHOD(ExpatAttributes, getLocalNames, "(III)[Ljava/lang/String;"),
     NATIVE_METHOD(ExpatAttributes, getQName, "(III)Ljava/lang/String;"),
+    NATIVE_METHOD(ExpatAttributes, getQNames, "(III)[Ljava/lang/String;"),
     NATIVE_METHOD(ExpatAttributes, getURI, "(III)Ljava/lang/String;"),
-    NATIVE_METHOD(ExpatAttributes, getValueByIndex, "(II)Ljava/lang/String;"),
-    NATIVE_METHOD(ExpatAttributes, getValueForQName, "(ILjava/lang/String;)Ljava/lang/String;"),
-    NATIVE_METHOD(ExpatAttributes, getValue, "(ILjava/lang/String;Ljava/lang/String;)Ljava/lang/String;"),
+    NATIVE_METHOD(ExpatAttributes, getValues, "(II)[Ljava/lang/String;"),
+};
+
+static JNINativeMethod internPoolMethods[] = {
+    NATIVE_METHOD(ExpatInternPool, create, "()I"),
+    NATIVE_METHOD(ExpatInternPool, release, "(I)V"),
 };
 void register_org_apache_harmony_xml_ExpatParser(JNIEnv* env) {
     jniRegisterNativeMethods(env, "org/apache/harmony/xml/ExpatParser", parserMethods, NELEM(parserMethods));
     jniRegisterNativeMethods(env, "org/apache/harmony/xml/ExpatAttributes", attributeMethods, NELEM(attributeMethods));
+    jniRegisterNativeMethods(env, "org/apache/harmony/xml/ExpatInternPool", internPoolMethods, NELEM(internPoolMethods));
 }
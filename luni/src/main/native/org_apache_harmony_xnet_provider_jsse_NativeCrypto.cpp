@@ -21,9 +21,25 @@
 #define LOG_TAG "NativeCrypto"
 
 #include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <sys/socket.h>
+#include <time.h>
 #include <unistd.h>
 
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#ifdef EFD_SEMAPHORE
+#define ENABLE_EVENTFD
+#endif
+#endif
+
 #include <jni.h>
 
 #include <openssl/dsa.h>
@@ -413,13 +429,52 @@ static BIGNUM* arrayToBignum(JNIEnv* env, jbyteArray source) {
 #define THROW_SOCKETTIMEOUTEXCEPTION (-3)
 #define THROWN_SOCKETEXCEPTION (-4)
 
-static MUTEX_TYPE* mutex_buf = NULL;
+/**
+ * OpenSSL asks for shared access to many of its locks (the ERR and RNG state,
+ * the X509 store, ...), so we back them with rwlocks rather than mutexes and
+ * let concurrent readers through.
+ */
+static pthread_rwlock_t* lock_buf = NULL;
+
+/**
+ * Optional per-lock counters of acquisitions and of acquisitions that had to
+ * wait, at the same index as the lock. Only maintained while gLockStatsEnabled
+ * is set, since the extra atomic operations are not free.
+ */
+struct LockStats {
+    unsigned long acquisitions;
+    unsigned long contended;
+};
+static LockStats* lock_stats = NULL;
+static volatile bool gLockStatsEnabled = false;
 
 static void locking_function(int mode, int n, const char*, int) {
-    if (mode & CRYPTO_LOCK) {
-        MUTEX_LOCK(mutex_buf[n]);
+    if (!(mode & CRYPTO_LOCK)) {
+        pthread_rwlock_unlock(&lock_buf[n]);
+        return;
+    }
+
+    bool read = (mode & CRYPTO_READ) != 0;
+    if (!gLockStatsEnabled) {
+        if (read) {
+            pthread_rwlock_rdlock(&lock_buf[n]);
+        } else {
+            pthread_rwlock_wrlock(&lock_buf[n]);
+        }
+        return;
+    }
+
+    __sync_fetch_and_add(&lock_stats[n].acquisitions, 1);
+    if (read) {
+        if (pthread_rwlock_tryrdlock(&lock_buf[n]) != 0) {
+            __sync_fetch_and_add(&lock_stats[n].contended, 1);
+            pthread_rwlock_rdlock(&lock_buf[n]);
+        }
     } else {
-        MUTEX_UNLOCK(mutex_buf[n]);
+        if (pthread_rwlock_trywrlock(&lock_buf[n]) != 0) {
+            __sync_fetch_and_add(&lock_stats[n].contended, 1);
+            pthread_rwlock_wrlock(&lock_buf[n]);
+        }
     }
 }
 
@@ -428,13 +483,17 @@ static unsigned long id_function(void) {
 }
 
 int THREAD_setup(void) {
-    mutex_buf = new MUTEX_TYPE[CRYPTO_num_locks()];
-    if (!mutex_buf) {
+    int lockCount = CRYPTO_num_locks();
+    lock_buf = new pthread_rwlock_t[lockCount];
+    lock_stats = new LockStats[lockCount];
+    if (!lock_buf || !lock_stats) {
         return 0;
     }
 
-    for (int i = 0; i < CRYPTO_num_locks(); ++i) {
-        MUTEX_SETUP(mutex_buf[i]);
+    for (int i = 0; i < lockCount; ++i) {
+        pthread_rwlock_init(&lock_buf[i], NULL);
+        lock_stats[i].acquisitions = 0;
+        lock_stats[i].contended = 0;
     }
 
     CRYPTO_set_id_callback(id_function);
@@ -444,7 +503,7 @@ int THREAD_setup(void) {
 }
 
 int THREAD_cleanup(void) {
-    if (!mutex_buf) {
+    if (!lock_buf) {
         return 0;
     }
 
@@ -452,11 +511,13 @@ int THREAD_cleanup(void) {
     CRYPTO_set_locking_callback(NULL);
 
     for (int i = 0; i < CRYPTO_num_locks( ); i++) {
-        MUTEX_CLEANUP(mutex_buf[i]);
+        pthread_rwlock_destroy(&lock_buf[i]);
     }
 
-    free(mutex_buf);
-    mutex_buf = NULL;
+    delete[] lock_buf;
+    lock_buf = NULL;
+    delete[] lock_stats;
+    lock_stats = NULL;
 
     return 1;
 }
@@ -474,6 +535,53 @@ static void NativeCrypto_clinit(JNIEnv*, jclass)
     THREAD_setup();
 }
 
+/**
+ * public static native void CRYPTO_set_lock_stats_enabled(boolean enabled);
+ */
+static void NativeCrypto_CRYPTO_set_lock_stats_enabled(JNIEnv*, jclass, jboolean enabled) {
+    JNI_TRACE("CRYPTO_set_lock_stats_enabled(%d)", enabled);
+    gLockStatsEnabled = enabled;
+}
+
+/**
+ * public static native long[] CRYPTO_get_lock_stats();
+ *
+ * Returns two entries per OpenSSL lock id: the number of acquisitions and
+ * the number of those that found the lock held.
+ */
+static jlongArray NativeCrypto_CRYPTO_get_lock_stats(JNIEnv* env, jclass) {
+    if (lock_stats == NULL) {
+        JNI_TRACE("CRYPTO_get_lock_stats => NULL");
+        return NULL;
+    }
+    int lockCount = CRYPTO_num_locks();
+    jlongArray result = env->NewLongArray(lockCount * 2);
+    if (result == NULL) {
+        return NULL;
+    }
+    ScopedLongArrayRW counts(env, result);
+    if (counts.get() == NULL) {
+        return NULL;
+    }
+    for (int i = 0; i < lockCount; ++i) {
+        counts[i * 2] = lock_stats[i].acquisitions;
+        counts[i * 2 + 1] = lock_stats[i].contended;
+    }
+    JNI_TRACE("CRYPTO_get_lock_stats => %p", result);
+    return result;
+}
+
+/**
+ * public static native String CRYPTO_get_lock_name(int lockId);
+ */
+static jstring NativeCrypto_CRYPTO_get_lock_name(JNIEnv* env, jclass, jint lockId) {
+    if (lockId < 0 || lockId >= CRYPTO_num_locks()) {
+        jniThrowException(env, "java/lang/IndexOutOfBoundsException", NULL);
+        return NULL;
+    }
+    return env->NewStringUTF(CRYPTO_get_lock_name(lockId));
+}
+
 /**
  * public static native int EVP_PKEY_new_DSA(byte[] p, byte[] q, byte[] g,
  *                                           byte[] pub_key, byte[] priv_key);
@@ -760,6 +868,119 @@ static void NativeCrypto_EVP_DigestUpdate(JNIEnv* env, jclass, EVP_MD_CTX* ctx,
     throwExceptionIfNecessary(env, "NativeCrypto_EVP_DigestUpdate");
 }
 
+/*
+ * public static native void EVP_DigestUpdateDirect(int, int, int)
+ */
+static void NativeCrypto_EVP_DigestUpdateDirect(JNIEnv* env, jclass, EVP_MD_CTX* ctx,
+                                                jint address, jint length) {
+    const unsigned char* buffer =
+            reinterpret_cast<const unsigned char*>(static_cast<uintptr_t>(address));
+    JNI_TRACE("NativeCrypto_EVP_DigestUpdateDirect(%p, %p, %d)", ctx, buffer, length);
+
+    if (length < 0) {
+        jniThrowException(env, "java/lang/IndexOutOfBoundsException", NULL);
+        return;
+    }
+
+    if (ctx == NULL || buffer == NULL) {
+        jniThrowNullPointerException(env, NULL);
+        return;
+    }
+
+    EVP_DigestUpdate(ctx, buffer, length);
+
+    throwExceptionIfNecessary(env, "NativeCrypto_EVP_DigestUpdateDirect");
+}
+
+/*
+ * public static native int EVP_Digest_batch(String, byte[], int[], int[], byte[])
+ *
+ * Digests each (offsets[i], lengths[i]) slice of buffer separately and writes
+ * the i'th digest at i * digestSize in out. Returns digestSize.
+ */
+static jint NativeCrypto_EVP_Digest_batch(JNIEnv* env, jclass, jstring algorithm,
+                                          jbyteArray buffer, jintArray offsets,
+                                          jintArray lengths, jbyteArray out) {
+    JNI_TRACE("NativeCrypto_EVP_Digest_batch(%p, %p, %p, %p, %p)",
+              algorithm, buffer, offsets, lengths, out);
+
+    if (algorithm == NULL || buffer == NULL || offsets == NULL || lengths == NULL
+            || out == NULL) {
+        jniThrowNullPointerException(env, NULL);
+        return -1;
+    }
+
+    ScopedUtfChars algorithmChars(env, algorithm);
+    if (algorithmChars.c_str() == NULL) {
+        return -1;
+    }
+    const EVP_MD* digest = EVP_get_digestbynid(OBJ_txt2nid(algorithmChars.c_str()));
+    if (digest == NULL) {
+        jniThrowRuntimeException(env, "Hash algorithm not found");
+        return -1;
+    }
+    int digestSize = EVP_MD_size(digest);
+
+    ScopedIntArrayRO offsetInts(env, offsets);
+    if (offsetInts.get() == NULL) {
+        return -1;
+    }
+    ScopedIntArrayRO lengthInts(env, lengths);
+    if (lengthInts.get() == NULL) {
+        return -1;
+    }
+    size_t count = offsetInts.size();
+    if (lengthInts.size() != count) {
+        jniThrowException(env, "java/lang/IllegalArgumentException",
+                          "offsets.length != lengths.length");
+        return -1;
+    }
+
+    ScopedByteArrayRO bufferBytes(env, buffer);
+    if (bufferBytes.get() == NULL) {
+        return -1;
+    }
+    ScopedByteArrayRW outBytes(env, out);
+    if (outBytes.get() == NULL) {
+        return -1;
+    }
+    if (outBytes.size() < count * digestSize) {
+        jniThrowException(env, "java/lang/IndexOutOfBoundsException", "out too small");
+        return -1;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        jint offset = offsetInts[i];
+        jint length = lengthInts[i];
+        if (offset < 0 || length < 0
+                || static_cast<size_t>(length) > bufferBytes.size()
+                || static_cast<size_t>(offset) > bufferBytes.size() - length) {
+            jniThrowException(env, "java/lang/IndexOutOfBoundsException", NULL);
+            return -1;
+        }
+    }
+
+    // One context for the whole batch; EVP_DigestInit_ex resets it for each slice.
+    EVP_MD_CTX ctx;
+    EVP_MD_CTX_init(&ctx);
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(bufferBytes.get());
+    unsigned char* hash = reinterpret_cast<unsigned char*>(outBytes.get());
+    for (size_t i = 0; i < count; ++i) {
+        if (!EVP_DigestInit_ex(&ctx, digest, NULL)
+                || !EVP_DigestUpdate(&ctx, data + offsetInts[i], lengthInts[i])
+                || !EVP_DigestFinal_ex(&ctx, hash + i * digestSize, NULL)) {
+            break;
+        }
+    }
+    EVP_MD_CTX_cleanup(&ctx);
+
+    if (throwExceptionIfNecessary(env, "NativeCrypto_EVP_Digest_batch")) {
+        return -1;
+    }
+    JNI_TRACE("NativeCrypto_EVP_Digest_batch(%p, %p, %p, %p, %p) => %d",
+              algorithm, buffer, offsets, lengths, out, digestSize);
+    return digestSize;
+}
+
 /*
  * public static native void EVP_VerifyInit(int, java.lang.String)
  */
@@ -872,6 +1093,77 @@ static RSA* rsaCreateKey(const jbyte* mod, int modLen, const jbyte* exp, int exp
     return rsa.release();
 }
 
+/**
+ * A few recently used RSA public keys, most recent first. Signature checks
+ * (JARs, APKs, tokens) tend to use the same handful of keys over and over,
+ * and a cached key also keeps the Montgomery context OpenSSL computes on
+ * first use. Entries are keyed by the length-prefixed modulus and exponent.
+ */
+struct RsaKeyCacheEntry {
+    std::string key;
+    EVP_PKEY* pkey;
+};
+static std::list<RsaKeyCacheEntry> gRsaKeyCache;
+static pthread_mutex_t gRsaKeyCacheMutex = PTHREAD_MUTEX_INITIALIZER;
+static const size_t RSA_KEY_CACHE_MAX_SIZE = 16;
+
+/**
+ * Returns a new reference to an EVP_PKEY for the RSA public key with the given
+ * modulus and exponent, creating and caching it if necessary. Returns NULL on
+ * error.
+ */
+static EVP_PKEY* rsaGetPublicKey(const jbyte* mod, int modLen, const jbyte* exp, int expLen) {
+    std::string key;
+    key.reserve(sizeof(modLen) + modLen + expLen);
+    key.append(reinterpret_cast<const char*>(&modLen), sizeof(modLen));
+    key.append(reinterpret_cast<const char*>(mod), modLen);
+    key.append(reinterpret_cast<const char*>(exp), expLen);
+
+    pthread_mutex_lock(&gRsaKeyCacheMutex);
+    for (std::list<RsaKeyCacheEntry>::iterator it = gRsaKeyCache.begin();
+            it != gRsaKeyCache.end(); ++it) {
+        if (it->key == key) {
+            gRsaKeyCache.splice(gRsaKeyCache.begin(), gRsaKeyCache, it);
+            EVP_PKEY* pkey = it->pkey;
+            CRYPTO_add(&pkey->references, 1, CRYPTO_LOCK_EVP_PKEY);
+            pthread_mutex_unlock(&gRsaKeyCacheMutex);
+            JNI_TRACE("rsaGetPublicKey(..., %d, ..., %d) => cached %p", modLen, expLen, pkey);
+            return pkey;
+        }
+    }
+    pthread_mutex_unlock(&gRsaKeyCacheMutex);
+
+    // Build the key outside the lock; two threads racing on the same new key
+    // just both insert it, and the older copy ages out.
+    Unique_RSA rsa(rsaCreateKey(mod, modLen, exp, expLen));
+    if (rsa.get() == NULL) {
+        return NULL;
+    }
+    Unique_EVP_PKEY pkey(EVP_PKEY_new());
+    if (pkey.get() == NULL || !EVP_PKEY_set1_RSA(pkey.get(), rsa.get())) {
+        return NULL;
+    }
+
+    RsaKeyCacheEntry entry;
+    entry.key = key;
+    entry.pkey = pkey.get();
+    CRYPTO_add(&pkey->references, 1, CRYPTO_LOCK_EVP_PKEY);
+    pthread_mutex_lock(&gRsaKeyCacheMutex);
+    gRsaKeyCache.push_front(entry);
+    EVP_PKEY* evicted = NULL;
+    if (gRsaKeyCache.size() > RSA_KEY_CACHE_MAX_SIZE) {
+        evicted = gRsaKeyCache.back().pkey;
+        gRsaKeyCache.pop_back();
+    }
+    pthread_mutex_unlock(&gRsaKeyCacheMutex);
+    if (evicted != NULL) {
+        EVP_PKEY_free(evicted);
+    }
+
+    JNI_TRACE("rsaGetPublicKey(..., %d, ..., %d) => %p", modLen, expLen, pkey.get());
+    return pkey.release();
+}
+
 /**
  * Helper function that verifies a given RSA signature for a given message.
  *
@@ -880,22 +1172,16 @@ static RSA* rsaCreateKey(const jbyte* mod, int modLen, const jbyte* exp, int exp
  * @param sig The signature to verify
  * @param sigLen The length of the signature
  * @param algorithm The name of the hash/sign algorithm to use, e.g. "RSA-SHA1"
- * @param rsa The RSA public key to use
+ * @param pkey The RSA public key to use
  *
  * @return 1 on success, 0 on failure, -1 on error (check SSL errors then)
  *
  */
 static int rsaVerify(const jbyte* msg, unsigned int msgLen, const jbyte* sig,
-                     unsigned int sigLen, const char* algorithm, RSA* rsa) {
+                     unsigned int sigLen, const char* algorithm, EVP_PKEY* pkey) {
 
     JNI_TRACE("rsaVerify(%p, %d, %p, %d, %s, %p)",
-              msg, msgLen, sig, sigLen, algorithm, rsa);
-
-    Unique_EVP_PKEY pkey(EVP_PKEY_new());
-    if (pkey.get() == NULL) {
-        return -1;
-    }
-    EVP_PKEY_set1_RSA(pkey.get(), rsa);
+              msg, msgLen, sig, sigLen, algorithm, pkey);
 
     const EVP_MD* type = EVP_get_digestbyname(algorithm);
     if (type == NULL) {
@@ -905,16 +1191,17 @@ static int rsaVerify(const jbyte* msg, unsigned int msgLen, const jbyte* sig,
     EVP_MD_CTX ctx;
     EVP_MD_CTX_init(&ctx);
     if (EVP_VerifyInit_ex(&ctx, type, NULL) == 0) {
+        EVP_MD_CTX_cleanup(&ctx);
         return -1;
     }
 
     EVP_VerifyUpdate(&ctx, msg, msgLen);
     int result = EVP_VerifyFinal(&ctx, reinterpret_cast<const unsigned char*>(sig), sigLen,
-            pkey.get());
+            pkey);
     EVP_MD_CTX_cleanup(&ctx);
 
     JNI_TRACE("rsaVerify(%p, %d, %p, %d, %s, %p) => %d",
-              msg, msgLen, sig, sigLen, algorithm, rsa, result);
+              msg, msgLen, sig, sigLen, algorithm, pkey, result);
     return result;
 }
 
@@ -950,11 +1237,12 @@ static int NativeCrypto_verifySignature(JNIEnv* env, jclass,
     }
     JNI_TRACE("NativeCrypto_verifySignature algorithmChars=%s", algorithmChars.c_str());
 
-    Unique_RSA rsa(rsaCreateKey(modBytes.get(), modBytes.size(), expBytes.get(), expBytes.size()));
+    Unique_EVP_PKEY pkey(rsaGetPublicKey(modBytes.get(), modBytes.size(),
+                                         expBytes.get(), expBytes.size()));
     int result = -1;
-    if (rsa.get() != NULL) {
+    if (pkey.get() != NULL) {
         result = rsaVerify(msgBytes.get(), msgBytes.size(), sigBytes.get(), sigBytes.size(),
-                algorithmChars.c_str(), rsa.get());
+                algorithmChars.c_str(), pkey.get());
     }
 
     if (result == -1) {
@@ -1108,51 +1396,116 @@ static void info_callback_LOG(const SSL* s __attribute__ ((unused)), int where,
 #endif
 
 /**
- * Returns an array containing all the X509 certificate's bytes.
+ * DER-encodes each certificate in the chain into out. Returns false if a
+ * certificate can't be encoded.
  */
-static jobjectArray getCertificateBytes(JNIEnv* env, const STACK_OF(X509)* chain)
+static bool encodeCertificates(const STACK_OF(X509)* chain, std::vector<std::string>& out)
 {
+    out.clear();
     if (chain == NULL) {
         // Chain can be NULL if the associated cipher doesn't do certs.
-        return NULL;
+        return true;
     }
 
     int count = sk_X509_num(chain);
-    if (count <= 0) {
-        return NULL;
+    for (int i = 0; i < count; i++) {
+        X509* cert = sk_X509_value(chain, i);
+
+        int len = i2d_X509(cert, NULL);
+        if (len < 0) {
+            return false;
+        }
+        out.push_back(std::string(len, '\0'));
+        unsigned char* p = reinterpret_cast<unsigned char*>(&out.back()[0]);
+        int n = i2d_X509(cert, &p);
+        if (n < 0) {
+            return false;
+        }
     }
+    return true;
+}
 
-    jobjectArray joa = env->NewObjectArray(count, JniConstants::byteArrayClass, NULL);
-    if (joa == NULL) {
-        return NULL;
+/**
+ * Drops the references taken by holdCertificates.
+ */
+static void releaseCertificates(std::vector<X509*>& held) {
+    for (size_t i = 0; i < held.size(); i++) {
+        X509_free(held[i]);
     }
+    held.clear();
+}
 
+/**
+ * Replaces held with the certificates in chain, taking a reference on each.
+ * While held, none of them can be freed and have its address reused by
+ * another certificate, so comparing addresses with sameCertificates is safe.
+ */
+static void holdCertificates(std::vector<X509*>& held, const STACK_OF(X509)* chain) {
+    releaseCertificates(held);
+    int count = (chain == NULL) ? 0 : sk_X509_num(chain);
     for (int i = 0; i < count; i++) {
         X509* cert = sk_X509_value(chain, i);
+        CRYPTO_add(&cert->references, 1, CRYPTO_LOCK_X509);
+        held.push_back(cert);
+    }
+}
 
-        int len = i2d_X509(cert, NULL);
-        if (len < 0) {
-            return NULL;
+/**
+ * Returns true if chain holds exactly the certificates in held, in order.
+ */
+static bool sameCertificates(const std::vector<X509*>& held, const STACK_OF(X509)* chain) {
+    int count = (chain == NULL) ? 0 : sk_X509_num(chain);
+    if (static_cast<size_t>(count) != held.size()) {
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        if (sk_X509_value(chain, i) != held[i]) {
+            return false;
         }
-        ScopedLocalRef<jbyteArray> byteArray(env, env->NewByteArray(len));
+    }
+    return true;
+}
+
+/**
+ * Returns a byte[][] holding the encoded certificates, or NULL if there are
+ * none.
+ */
+static jobjectArray toCertificateArray(JNIEnv* env, const std::vector<std::string>& encoded)
+{
+    if (encoded.empty()) {
+        return NULL;
+    }
+
+    jobjectArray joa = env->NewObjectArray(encoded.size(), JniConstants::byteArrayClass, NULL);
+    if (joa == NULL) {
+        return NULL;
+    }
+
+    for (size_t i = 0; i < encoded.size(); i++) {
+        ScopedLocalRef<jbyteArray> byteArray(env, env->NewByteArray(encoded[i].size()));
         if (byteArray.get() == NULL) {
             return NULL;
         }
-        ScopedByteArrayRW bytes(env, byteArray.get());
-        if (bytes.get() == NULL) {
-            return NULL;
-        }
-        unsigned char* p = reinterpret_cast<unsigned char*>(bytes.get());
-        int n = i2d_X509(cert, &p);
-        if (n < 0) {
-            return NULL;
-        }
+        env->SetByteArrayRegion(byteArray.get(), 0, encoded[i].size(),
+                                reinterpret_cast<const jbyte*>(encoded[i].data()));
         env->SetObjectArrayElement(joa, i, byteArray.get());
     }
 
     return joa;
 }
 
+/**
+ * Returns an array containing all the X509 certificate's bytes.
+ */
+static jobjectArray getCertificateBytes(JNIEnv* env, const STACK_OF(X509)* chain)
+{
+    std::vector<std::string> encoded;
+    if (!encodeCertificates(chain, encoded)) {
+        return NULL;
+    }
+    return toCertificateArray(env, encoded);
+}
+
 /**
  * Returns an array containing all the X500 principal's bytes.
  */
@@ -1210,25 +1563,26 @@ static jobjectArray getPrincipalBytes(JNIEnv* env, const STACK_OF(X509_NAME)* na
  * the Java layer ensures that no more threads will enter the native code at the
  * same time.
  *
- * (3) The pipe is used primarily as a means of cancelling a blocking select()
+ * (3) The pipe is used primarily as a means of cancelling a blocking poll()
  * when we want to close the connection (aka "emergency button"). It is also
  * necessary for dealing with a possible race condition situation: There might
  * be cases where both threads see an SSL_ERROR_WANT_READ or
- * SSL_ERROR_WANT_WRITE. Both will enter a select() with the proper argument.
- * If one leaves the select() successfully before the other enters it, the
+ * SSL_ERROR_WANT_WRITE. Both will enter a poll() with the proper argument.
+ * If one leaves the poll() successfully before the other enters it, the
  * "success" event is already consumed and the second thread will be blocked,
  * possibly forever (depending on network conditions).
  *
  * The idea for solving the problem looks like this: Whenever a thread is
  * successful in moving around data on the network, and it knows there is
- * another thread stuck in a select(), it will write a byte to the pipe, waking
- * up the other thread. A thread that returned from select(), on the other hand,
+ * another thread stuck in a poll(), it will write a token to the pipe, waking
+ * up the other thread. A thread that returned from poll(), on the other hand,
  * knows whether it's been woken up by the pipe. If so, it will consume the
- * byte, and the original state of affairs has been restored.
+ * token, and the original state of affairs has been restored.
  *
  * The pipe may seem like a bit of overhead, but it fits in nicely with the
- * other file descriptors of the select(), so there's only one condition to wait
- * for.
+ * other file descriptor of the poll(), so there's only one condition to wait
+ * for. Where we can, the "pipe" is a semaphore-mode eventfd, which costs one
+ * fd rather than two and behaves just like a pipe of one-byte tokens.
  *
  * (4) Finally, a mutex is needed to make sure that at most one thread is in
  * either SSL_read() or SSL_write() at any given time. This is an OpenSSL
@@ -1270,19 +1624,43 @@ class AppData {
     volatile int aliveAndKicking;
     int waitingThreads;
     int fdsEmergency[2];
+    bool emergencyIsEventFd;
     MUTEX_TYPE mutex;
     JNIEnv* env;
     jobject sslHandshakeCallbacks;
     jobject fileDescriptor;
     Unique_RSA ephemeralRsa;
 
+    /**
+     * DER encodings of the local and peer certificate chains, so repeated
+     * SSL_get_certificate and SSL_get_peer_cert_chain calls don't re-encode
+     * them. Each is tagged with the X509 objects it was encoded from, which
+     * we hold references on, and re-encoded if those change, as on
+     * renegotiation. Guarded by certificateMutex.
+     */
+    MUTEX_TYPE certificateMutex;
+    bool localCertificatesCached;
+    std::vector<X509*> localCertificatesSource;
+    std::vector<std::string> localCertificates;
+    bool peerCertificatesCached;
+    std::vector<X509*> peerCertificatesSource;
+    std::vector<std::string> peerCertificates;
+
     /**
      * Creates the application data context for the SSL*.
      */
   public:
     static AppData* create() {
         UniquePtr<AppData> appData(new AppData());
-        if (pipe(appData.get()->fdsEmergency) == -1) {
+#ifdef ENABLE_EVENTFD
+        int eventFd = eventfd(0, EFD_SEMAPHORE);
+        if (eventFd != -1) {
+            // Both ends of our "pipe" are the same fd.
+            appData.get()->fdsEmergency[0] = appData.get()->fdsEmergency[1] = eventFd;
+            appData.get()->emergencyIsEventFd = true;
+        }
+#endif
+        if (!appData.get()->emergencyIsEventFd && pipe(appData.get()->fdsEmergency) == -1) {
             return NULL;
         }
         if (!setBlocking(appData.get()->fdsEmergency[0], false)) {
@@ -1291,6 +1669,9 @@ class AppData {
         if (MUTEX_SETUP(appData.get()->mutex) == -1) {
             return NULL;
         }
+        if (MUTEX_SETUP(appData.get()->certificateMutex) == -1) {
+            return NULL;
+        }
         return appData.release();
     }
 
@@ -1299,19 +1680,25 @@ class AppData {
         if (fdsEmergency[0] != -1) {
             close(fdsEmergency[0]);
         }
-        if (fdsEmergency[1] != -1) {
+        if (fdsEmergency[1] != -1 && !emergencyIsEventFd) {
             close(fdsEmergency[1]);
         }
         MUTEX_CLEANUP(mutex);
+        MUTEX_CLEANUP(certificateMutex);
+        releaseCertificates(localCertificatesSource);
+        releaseCertificates(peerCertificatesSource);
     }
 
   private:
     AppData() :
             aliveAndKicking(1),
             waitingThreads(0),
+            emergencyIsEventFd(false),
             env(NULL),
             sslHandshakeCallbacks(NULL),
-            ephemeralRsa(NULL) {
+            ephemeralRsa(NULL),
+            localCertificatesCached(false),
+            peerCertificatesCached(false) {
         fdsEmergency[0] = -1;
         fdsEmergency[1] = -1;
     }
@@ -1359,22 +1746,20 @@ class AppData {
  * @param type Either SSL_ERROR_WANT_READ or SSL_ERROR_WANT_WRITE
  * @param fdObject The FileDescriptor, since appData->fileDescriptor should be NULL
  * @param appData The application data structure with mutex info etc.
- * @param timeout The timeout value for select call, with the special value
+ * @param timeout The timeout value for poll call, with the special value
  *                0 meaning no timeout at all (wait indefinitely). Note: This is
  *                the Java semantics of the timeout value, not the usual
- *                select() semantics.
- * @return The result of the inner select() call,
+ *                poll() semantics.
+ * @return The result of the inner poll() call,
  * THROW_SOCKETEXCEPTION if a SocketException was thrown, -1 on
  * additional errors
  */
 static int sslSelect(JNIEnv* env, int type, jobject fdObject, AppData* appData, int timeout) {
     // This loop is an expanded version of the NET_FAILURE_RETRY
-    // macro. It cannot simply be used in this case because select
-    // cannot be restarted without recreating the fd_sets and timeout
-    // structure.
+    // macro. It cannot simply be used in this case because we
+    // need to check for a close before each retry.
     int result;
-    fd_set rfds;
-    fd_set wfds;
+    pollfd fds[2];
     do {
         NetFd fd(env, fdObject);
         if (fd.isClosed()) {
@@ -1385,32 +1770,14 @@ static int sslSelect(JNIEnv* env, int type, jobject fdObject, AppData* appData,
         JNI_TRACE("sslSelect type=%s fd=%d appData=%p timeout=%d",
                   (type == SSL_ERROR_WANT_READ) ? "READ" : "WRITE", intFd, appData, timeout);
 
-        FD_ZERO(&rfds);
-        FD_ZERO(&wfds);
-
-        if (type == SSL_ERROR_WANT_READ) {
-            FD_SET(intFd, &rfds);
-        } else {
-            FD_SET(intFd, &wfds);
-        }
-
-        FD_SET(appData->fdsEmergency[0], &rfds);
-
-        int maxFd = (intFd > appData->fdsEmergency[0]) ? intFd : appData->fdsEmergency[0];
-
-        // Build a struct for the timeout data if we actually want a timeout.
-        timeval tv;
-        timeval* ptv;
-        if (timeout > 0) {
-            tv.tv_sec = timeout / 1000;
-            tv.tv_usec = 0;
-            ptv = &tv;
-        } else {
-            ptv = NULL;
-        }
+        memset(fds, 0, sizeof(fds));
+        fds[0].fd = intFd;
+        fds[0].events = (type == SSL_ERROR_WANT_READ) ? POLLIN : POLLOUT;
+        fds[1].fd = appData->fdsEmergency[0];
+        fds[1].events = POLLIN;
 
         AsynchronousSocketCloseMonitor monitor(intFd);
-        result = select(maxFd + 1, &rfds, &wfds, NULL, ptv);
+        result = poll(fds, 2, (timeout > 0) ? timeout : -1);
         JNI_TRACE("sslSelect %s fd=%d appData=%p timeout=%d => %d",
                   (type == SSL_ERROR_WANT_READ) ? "READ" : "WRITE",
                   fd.get(), appData, timeout, result);
@@ -1433,14 +1800,17 @@ static int sslSelect(JNIEnv* env, int type, jobject fdObject, AppData* appData,
         // If we have been woken up by the emergency pipe. We can't be
         // sure there is a token in it because it could have been read
         // by the thread that wrote it between when when we woke up
-        // from select and attempt to read it here. Thus we cannot
+        // from poll and attempt to read it here. Thus we cannot
         // safely read it in a blocking way (so we make it
         // non-blocking at creation).
-        if (FD_ISSET(appData->fdsEmergency[0], &rfds)) {
-            char token;
-            do {
-                read(appData->fdsEmergency[0], &token, 1);
-            } while (errno == EINTR);
+        if ((fds[1].revents & POLLIN) != 0) {
+            if (appData->emergencyIsEventFd) {
+                uint64_t token;
+                TEMP_FAILURE_RETRY(read(appData->fdsEmergency[0], &token, sizeof(token)));
+            } else {
+                char token;
+                TEMP_FAILURE_RETRY(read(appData->fdsEmergency[0], &token, 1));
+            }
         }
     }
 
@@ -1454,22 +1824,24 @@ static int sslSelect(JNIEnv* env, int type, jobject fdObject, AppData* appData,
 }
 
 /**
- * Helper function that wakes up a thread blocked in select(), in case there is
+ * Helper function that wakes up a thread blocked in poll(), in case there is
  * one. Is being called by sslRead() and sslWrite() as well as by JNI glue
  * before closing the connection.
  *
  * @param data The application data structure with mutex info etc.
  */
 static void sslNotify(AppData* appData) {
-    // Write a byte to the emergency pipe, so a concurrent select() can return.
+    // Write a token to the emergency pipe, so a concurrent poll() can return.
     // Note we have to restore the errno of the original system call, since the
     // caller relies on it for generating error messages.
     int errnoBackup = errno;
-    char token = '*';
-    do {
-        errno = 0;
-        write(appData->fdsEmergency[1], &token, 1);
-    } while (errno == EINTR);
+    if (appData->emergencyIsEventFd) {
+        uint64_t token = 1;
+        TEMP_FAILURE_RETRY(write(appData->fdsEmergency[1], &token, sizeof(token)));
+    } else {
+        char token = '*';
+        TEMP_FAILURE_RETRY(write(appData->fdsEmergency[1], &token, 1));
+    }
     errno = errnoBackup;
 }
 
@@ -1654,29 +2026,225 @@ static RSA* rsaGenerateKey(int keylength) {
     return rsa.release();
 }
 
+static DH* dhGenerateParameters(int keylength);
+
 /**
- * Call back to ask for an ephemeral RSA key for SSL_RSA_EXPORT_WITH_RC4_40_MD5 (aka EXP-RC4-MD5)
+ * Ephemeral keys and parameters are slow to generate (hundreds of
+ * milliseconds for 1024 bits), so a background thread keeps a pool of them
+ * per key length and handshakes take from it. Each RSA key is shared by all
+ * handshakes until it is rotated out after gEphemeralRotationSeconds. DH
+ * parameters are single use (see dhGenerateParameters), so a few ready ones
+ * are queued. A handshake only generates its own when the pool for its key
+ * length is empty, which is the case the first time a length is used unless
+ * it was configured ahead of time with SSL_ephemeral_key_pool_configure.
  */
-static RSA* tmp_rsa_callback(SSL* ssl __attribute__ ((unused)),
-                             int is_export __attribute__ ((unused)),
-                             int keylength) {
-    JNI_TRACE("ssl=%p tmp_rsa_callback is_export=%d keylength=%d", ssl, is_export, keylength);
+struct EphemeralKeySlot {
+    EphemeralKeySlot() : rsa(NULL), rsaCreated(0) {}
+    RSA* rsa;
+    time_t rsaCreated;
+    std::list<DH*> dh;
+};
+static std::map<int, EphemeralKeySlot> gEphemeralKeys;
+static pthread_mutex_t gEphemeralKeysMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t gEphemeralKeysCond = PTHREAD_COND_INITIALIZER;
+static int gEphemeralRotationSeconds = 3600;
+static bool gEphemeralThreadStarted = false;
+static const size_t EPHEMERAL_DH_POOL_SIZE = 4;
+
+static void* ephemeralKeyThread(void*) {
+    pthread_mutex_lock(&gEphemeralKeysMutex);
+    while (true) {
+        if (gEphemeralRotationSeconds == 0) {
+            pthread_cond_wait(&gEphemeralKeysCond, &gEphemeralKeysMutex);
+            continue;
+        }
+        time_t now = time(NULL);
+        int keylength = 0;
+        bool wantRsa = false;
+        for (std::map<int, EphemeralKeySlot>::iterator it = gEphemeralKeys.begin();
+                it != gEphemeralKeys.end(); ++it) {
+            EphemeralKeySlot& slot = it->second;
+            if (slot.rsa == NULL || now - slot.rsaCreated >= gEphemeralRotationSeconds) {
+                keylength = it->first;
+                wantRsa = true;
+                break;
+            }
+            if (slot.dh.size() < EPHEMERAL_DH_POOL_SIZE) {
+                keylength = it->first;
+                break;
+            }
+        }
+        if (keylength == 0) {
+            // Nothing to do until something is used up or a key is due for rotation.
+            timespec deadline;
+            deadline.tv_sec = now + gEphemeralRotationSeconds;
+            deadline.tv_nsec = 0;
+            pthread_cond_timedwait(&gEphemeralKeysCond, &gEphemeralKeysMutex, &deadline);
+            continue;
+        }
 
-    AppData* appData = toAppData(ssl);
-    if (appData->ephemeralRsa.get() == NULL) {
-        JNI_TRACE("ssl=%p tmp_rsa_callback generating ephemeral RSA key", ssl);
-        appData->ephemeralRsa.reset(rsaGenerateKey(keylength));
+        pthread_mutex_unlock(&gEphemeralKeysMutex);
+        RSA* rsa = wantRsa ? rsaGenerateKey(keylength) : NULL;
+        DH* dh = wantRsa ? NULL : dhGenerateParameters(keylength);
+        freeSslErrorState();
+        RSA* oldRsa = NULL;
+        pthread_mutex_lock(&gEphemeralKeysMutex);
+
+        EphemeralKeySlot& slot = gEphemeralKeys[keylength];
+        if (rsa != NULL) {
+            oldRsa = slot.rsa;
+            slot.rsa = rsa;
+            slot.rsaCreated = time(NULL);
+        } else if (dh != NULL) {
+            slot.dh.push_back(dh);
+        } else {
+            // Generation failed; back off rather than spin.
+            timespec deadline;
+            deadline.tv_sec = time(NULL) + 1;
+            deadline.tv_nsec = 0;
+            pthread_cond_timedwait(&gEphemeralKeysCond, &gEphemeralKeysMutex, &deadline);
+        }
+        if (oldRsa != NULL) {
+            // Handshakes in progress hold their own references.
+            RSA_free(oldRsa);
+        }
     }
-    JNI_TRACE("ssl=%p tmp_rsa_callback => %p", ssl, appData->ephemeralRsa.get());
-    return appData->ephemeralRsa.get();
+    return NULL;
 }
 
-static DH* dhGenerateParameters(int keylength) {
+/**
+ * Makes sure the pool knows about keylength and the background thread is
+ * running. gEphemeralKeysMutex must be held.
+ */
+static EphemeralKeySlot& ephemeralKeySlotLocked(int keylength) {
+    if (!gEphemeralThreadStarted) {
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        pthread_t thread;
+        gEphemeralThreadStarted = pthread_create(&thread, &attr, ephemeralKeyThread, NULL) == 0;
+        pthread_attr_destroy(&attr);
+    }
+    pthread_cond_signal(&gEphemeralKeysCond);
+    return gEphemeralKeys[keylength];
+}
 
-    /*
-     * The SSL_CTX_set_tmp_dh_callback(3SSL) man page discusses two
-     * different options for generating DH keys. One is generating the
-     * keys using a single set of DH parameters. However, generating
+/**
+ * Returns a new reference to an ephemeral RSA key of the given length.
+ */
+static RSA* ephemeralRsaKey(int keylength) {
+    pthread_mutex_lock(&gEphemeralKeysMutex);
+    if (gEphemeralRotationSeconds != 0) {
+        EphemeralKeySlot& slot = ephemeralKeySlotLocked(keylength);
+        if (slot.rsa != NULL) {
+            RSA* rsa = slot.rsa;
+            RSA_up_ref(rsa);
+            pthread_mutex_unlock(&gEphemeralKeysMutex);
+            return rsa;
+        }
+    }
+    pthread_mutex_unlock(&gEphemeralKeysMutex);
+    return rsaGenerateKey(keylength);
+}
+
+/**
+ * Returns fresh DH parameters of the given length, owned by the caller.
+ */
+static DH* ephemeralDhParameters(int keylength) {
+    pthread_mutex_lock(&gEphemeralKeysMutex);
+    if (gEphemeralRotationSeconds != 0) {
+        EphemeralKeySlot& slot = ephemeralKeySlotLocked(keylength);
+        if (!slot.dh.empty()) {
+            DH* dh = slot.dh.front();
+            slot.dh.pop_front();
+            pthread_mutex_unlock(&gEphemeralKeysMutex);
+            return dh;
+        }
+    }
+    pthread_mutex_unlock(&gEphemeralKeysMutex);
+    return dhGenerateParameters(keylength);
+}
+
+/**
+ * public static native void SSL_ephemeral_key_pool_configure(int rotationIntervalSeconds,
+ *                                                            int[] keyLengths);
+ */
+static void NativeCrypto_SSL_ephemeral_key_pool_configure(JNIEnv* env, jclass,
+        jint rotationIntervalSeconds, jintArray keyLengths) {
+    JNI_TRACE("NativeCrypto_SSL_ephemeral_key_pool_configure(%d, %p)",
+              rotationIntervalSeconds, keyLengths);
+    if (rotationIntervalSeconds < 0) {
+        jniThrowException(env, "java/lang/IllegalArgumentException",
+                          "rotationIntervalSeconds < 0");
+        return;
+    }
+    UniquePtr<ScopedIntArrayRO> lengths;
+    if (keyLengths != NULL) {
+        lengths.reset(new ScopedIntArrayRO(env, keyLengths));
+        if (lengths->get() == NULL) {
+            return;
+        }
+        for (size_t i = 0; i < lengths->size(); ++i) {
+            if ((*lengths)[i] <= 0) {
+                jniThrowException(env, "java/lang/IllegalArgumentException", "keyLength <= 0");
+                return;
+            }
+        }
+    }
+
+    std::vector<RSA*> rsaToFree;
+    std::vector<DH*> dhToFree;
+    pthread_mutex_lock(&gEphemeralKeysMutex);
+    gEphemeralRotationSeconds = rotationIntervalSeconds;
+    if (rotationIntervalSeconds == 0) {
+        // Drop everything pooled; handshakes go back to generating their own.
+        for (std::map<int, EphemeralKeySlot>::iterator it = gEphemeralKeys.begin();
+                it != gEphemeralKeys.end(); ++it) {
+            if (it->second.rsa != NULL) {
+                rsaToFree.push_back(it->second.rsa);
+            }
+            dhToFree.insert(dhToFree.end(), it->second.dh.begin(), it->second.dh.end());
+        }
+        gEphemeralKeys.clear();
+    } else if (lengths.get() != NULL) {
+        for (size_t i = 0; i < lengths->size(); ++i) {
+            ephemeralKeySlotLocked((*lengths)[i]);
+        }
+    }
+    pthread_cond_signal(&gEphemeralKeysCond);
+    pthread_mutex_unlock(&gEphemeralKeysMutex);
+
+    for (size_t i = 0; i < rsaToFree.size(); ++i) {
+        RSA_free(rsaToFree[i]);
+    }
+    for (size_t i = 0; i < dhToFree.size(); ++i) {
+        DH_free(dhToFree[i]);
+    }
+}
+
+/**
+ * Call back to ask for an ephemeral RSA key for SSL_RSA_EXPORT_WITH_RC4_40_MD5 (aka EXP-RC4-MD5)
+ */
+static RSA* tmp_rsa_callback(SSL* ssl __attribute__ ((unused)),
+                             int is_export __attribute__ ((unused)),
+                             int keylength) {
+    JNI_TRACE("ssl=%p tmp_rsa_callback is_export=%d keylength=%d", ssl, is_export, keylength);
+
+    AppData* appData = toAppData(ssl);
+    if (appData->ephemeralRsa.get() == NULL) {
+        JNI_TRACE("ssl=%p tmp_rsa_callback getting ephemeral RSA key", ssl);
+        appData->ephemeralRsa.reset(ephemeralRsaKey(keylength));
+    }
+    JNI_TRACE("ssl=%p tmp_rsa_callback => %p", ssl, appData->ephemeralRsa.get());
+    return appData->ephemeralRsa.get();
+}
+
+static DH* dhGenerateParameters(int keylength) {
+
+    /*
+     * The SSL_CTX_set_tmp_dh_callback(3SSL) man page discusses two
+     * different options for generating DH keys. One is generating the
+     * keys using a single set of DH parameters. However, generating
      * DH parameters is slow enough (minutes) that they suggest doing
      * it once at install time. The other is to generate DH keys from
      * DSA parameters. Generating DSA parameters is faster than DH
@@ -1710,7 +2278,7 @@ static DH* tmp_dh_callback(SSL* ssl __attribute__ ((unused)),
                            int is_export __attribute__ ((unused)),
                            int keylength) {
     JNI_TRACE("ssl=%p tmp_dh_callback is_export=%d keylength=%d", ssl, is_export, keylength);
-    DH* tmp_dh = dhGenerateParameters(keylength);
+    DH* tmp_dh = ephemeralDhParameters(keylength);
     JNI_TRACE("ssl=%p tmp_dh_callback => %p", ssl, tmp_dh);
     return tmp_dh;
 }
@@ -1769,6 +2337,8 @@ static int NativeCrypto_SSL_CTX_new(JNIEnv* env, jclass) {
     return (jint) sslCtx.release();
 }
 
+static void removeSessionCacheEntriesForContext(SSL_CTX* ssl_ctx);
+
 /**
  * public static native void SSL_CTX_free(int ssl_ctx)
  */
@@ -1780,6 +2350,7 @@ static void NativeCrypto_SSL_CTX_free(JNIEnv* env,
     if (ssl_ctx == NULL) {
         return;
     }
+    removeSessionCacheEntriesForContext(ssl_ctx);
     SSL_CTX_free(ssl_ctx);
 }
 
@@ -2227,6 +2798,299 @@ static void NativeCrypto_SSL_set_session(JNIEnv* env, jclass,
     }
 }
 
+/*
+ * A native cache of client sessions, so that a session that has fallen out of
+ * a ClientSessionContext's small Java cache can be resumed without a round
+ * trip through DER. Sessions are only ever resumed through the SSL_CTX that
+ * negotiated them: another SSLContext may have different trust or key
+ * managers, and would never have accepted the peer. Within an SSL_CTX,
+ * sessions are found by "host:port" or by session id, and the least recently
+ * used session in the whole cache is evicted when it's full. Each cached
+ * session holds a reference to its SSL_SESSION, and the peer's certificate
+ * chain (as DER) for the Java session object.
+ */
+struct SessionCacheEntry {
+    SSL_CTX* ssl_ctx;
+    std::string hostAndPort;
+    std::string sessionId;
+    SSL_SESSION* session;
+    std::vector<std::string> peerCertificates;
+};
+
+// Most recently used first.
+typedef std::list<SessionCacheEntry> SessionCacheList;
+typedef std::map<std::string, SessionCacheList::iterator> SessionCacheIndex;
+
+static pthread_mutex_t gSessionCacheMutex = PTHREAD_MUTEX_INITIALIZER;
+static SessionCacheList gSessionCache;
+static SessionCacheIndex gSessionsByHostAndPort;
+static SessionCacheIndex gSessionsById;
+static size_t gSessionCacheMaxSize = 256;
+
+// Index keys start with the owning SSL_CTX, so contexts never see each other's sessions.
+static std::string toContextKey(SSL_CTX* ssl_ctx) {
+    return std::string(reinterpret_cast<const char*>(&ssl_ctx), sizeof(ssl_ctx));
+}
+
+static std::string toHostAndPort(SSL_CTX* ssl_ctx, const char* host, jint port) {
+    char portString[16];
+    snprintf(portString, sizeof(portString), ":%d", port);
+    return toContextKey(ssl_ctx) + host + portString;
+}
+
+static std::string sessionIdOf(SSL_CTX* ssl_ctx, const unsigned char* id, size_t length) {
+    if (length == 0) {
+        return std::string();
+    }
+    return toContextKey(ssl_ctx) + std::string(reinterpret_cast<const char*>(id), length);
+}
+
+// Called with gSessionCacheMutex held.
+static void removeSessionCacheEntryLocked(SessionCacheList::iterator it) {
+    gSessionsByHostAndPort.erase(it->hostAndPort);
+    if (!it->sessionId.empty()) {
+        gSessionsById.erase(it->sessionId);
+    }
+    SSL_SESSION_free(it->session);
+    gSessionCache.erase(it);
+}
+
+/**
+ * Drops every session cached for 'ssl_ctx'. Called when the SSL_CTX is
+ * freed, so that a new SSL_CTX at the same address starts out empty.
+ */
+static void removeSessionCacheEntriesForContext(SSL_CTX* ssl_ctx) {
+    pthread_mutex_lock(&gSessionCacheMutex);
+    SessionCacheList::iterator it = gSessionCache.begin();
+    while (it != gSessionCache.end()) {
+        SessionCacheList::iterator next = it;
+        ++next;
+        if (it->ssl_ctx == ssl_ctx) {
+            removeSessionCacheEntryLocked(it);
+        }
+        it = next;
+    }
+    pthread_mutex_unlock(&gSessionCacheMutex);
+}
+
+/**
+ * Returns a new reference to the session 'it' refers to, or NULL if it has
+ * expired (in which case it's removed). Copies the peer's certificates into
+ * 'peerCertificates'. Called with gSessionCacheMutex held.
+ */
+static SSL_SESSION* useSessionCacheEntryLocked(SessionCacheList::iterator it,
+                                               std::vector<std::string>* peerCertificates) {
+    SSL_SESSION* session = it->session;
+    if (SSL_SESSION_get_time(session) + SSL_SESSION_get_timeout(session) < time(NULL)) {
+        removeSessionCacheEntryLocked(it);
+        return NULL;
+    }
+    gSessionCache.splice(gSessionCache.begin(), gSessionCache, it);
+    CRYPTO_add(&session->references, 1, CRYPTO_LOCK_SSL_SESSION);
+    *peerCertificates = it->peerCertificates;
+    return session;
+}
+
+/**
+ * Returns a session from the cache as an int, storing its peer's certificate
+ * chain in peerCertificatesOut[0]. Returns 0 if 'session' is NULL.
+ */
+static jint toJavaSession(JNIEnv* env, SSL_SESSION* session,
+                          const std::vector<std::string>& peerCertificates,
+                          jobjectArray peerCertificatesOut) {
+    if (session == NULL) {
+        return 0;
+    }
+    jobjectArray certificates = env->NewObjectArray(peerCertificates.size(),
+                                                    JniConstants::byteArrayClass, NULL);
+    if (certificates == NULL) {
+        SSL_SESSION_free(session);
+        return 0;
+    }
+    for (size_t i = 0; i < peerCertificates.size(); ++i) {
+        const std::string& der = peerCertificates[i];
+        ScopedLocalRef<jbyteArray> bytes(env, env->NewByteArray(der.size()));
+        if (bytes.get() == NULL) {
+            SSL_SESSION_free(session);
+            return 0;
+        }
+        env->SetByteArrayRegion(bytes.get(), 0, der.size(),
+                                reinterpret_cast<const jbyte*>(der.data()));
+        env->SetObjectArrayElement(certificates, i, bytes.get());
+    }
+    env->SetObjectArrayElement(peerCertificatesOut, 0, certificates);
+    if (env->ExceptionCheck()) {
+        SSL_SESSION_free(session);
+        return 0;
+    }
+    return static_cast<jint>(reinterpret_cast<uintptr_t>(session));
+}
+
+/**
+ * Adds a session to ssl_ctx's part of the session cache, replacing any
+ * session it previously cached for the same host and port or with the same id.
+ */
+static void NativeCrypto_SSL_SESSION_cache_put(JNIEnv* env, jclass, jint ssl_ctx_address,
+                                               jstring javaHost, jint port,
+                                               jint ssl_session_address,
+                                               jobjectArray javaPeerCertificates)
+{
+    SSL_CTX* ssl_ctx = to_SSL_CTX(env, ssl_ctx_address, true);
+    SSL_SESSION* ssl_session = to_SSL_SESSION(env, ssl_session_address, true);
+    JNI_TRACE("ssl_ctx=%p ssl_session=%p NativeCrypto_SSL_SESSION_cache_put port=%d",
+              ssl_ctx, ssl_session, port);
+    if (ssl_ctx == NULL || ssl_session == NULL) {
+        return;
+    }
+    if (javaHost == NULL) {
+        jniThrowNullPointerException(env, "host == null");
+        return;
+    }
+    ScopedUtfChars host(env, javaHost);
+    if (host.c_str() == NULL) {
+        return;
+    }
+
+    SessionCacheEntry entry;
+    entry.ssl_ctx = ssl_ctx;
+    entry.hostAndPort = toHostAndPort(ssl_ctx, host.c_str(), port);
+    entry.sessionId = sessionIdOf(ssl_ctx, ssl_session->session_id,
+                                  ssl_session->session_id_length);
+    entry.session = ssl_session;
+    if (javaPeerCertificates != NULL) {
+        jsize count = env->GetArrayLength(javaPeerCertificates);
+        for (jsize i = 0; i < count; ++i) {
+            ScopedLocalRef<jbyteArray> javaDer(env, reinterpret_cast<jbyteArray>(
+                    env->GetObjectArrayElement(javaPeerCertificates, i)));
+            ScopedByteArrayRO der(env, javaDer.get());
+            if (der.get() == NULL) {
+                return;
+            }
+            entry.peerCertificates.push_back(
+                    std::string(reinterpret_cast<const char*>(der.get()), der.size()));
+        }
+    }
+
+    pthread_mutex_lock(&gSessionCacheMutex);
+    SessionCacheIndex::iterator old = gSessionsByHostAndPort.find(entry.hostAndPort);
+    if (old != gSessionsByHostAndPort.end()) {
+        removeSessionCacheEntryLocked(old->second);
+    }
+    if (!entry.sessionId.empty()) {
+        old = gSessionsById.find(entry.sessionId);
+        if (old != gSessionsById.end()) {
+            removeSessionCacheEntryLocked(old->second);
+        }
+    }
+    CRYPTO_add(&ssl_session->references, 1, CRYPTO_LOCK_SSL_SESSION);
+    gSessionCache.push_front(entry);
+    gSessionsByHostAndPort[entry.hostAndPort] = gSessionCache.begin();
+    if (!entry.sessionId.empty()) {
+        gSessionsById[entry.sessionId] = gSessionCache.begin();
+    }
+    while (gSessionCache.size() > gSessionCacheMaxSize) {
+        SessionCacheList::iterator eldest = gSessionCache.end();
+        removeSessionCacheEntryLocked(--eldest);
+    }
+    pthread_mutex_unlock(&gSessionCacheMutex);
+}
+
+/**
+ * Returns a new reference to the session ssl_ctx cached for the given host and
+ * port, or 0. The caller must free the returned session with SSL_SESSION_free.
+ */
+static jint NativeCrypto_SSL_SESSION_cache_get(JNIEnv* env, jclass, jint ssl_ctx_address,
+                                               jstring javaHost, jint port,
+                                               jobjectArray peerCertificatesOut)
+{
+    SSL_CTX* ssl_ctx = to_SSL_CTX(env, ssl_ctx_address, true);
+    JNI_TRACE("ssl_ctx=%p NativeCrypto_SSL_SESSION_cache_get port=%d", ssl_ctx, port);
+    if (ssl_ctx == NULL) {
+        return 0;
+    }
+    if (javaHost == NULL || peerCertificatesOut == NULL) {
+        jniThrowNullPointerException(env, NULL);
+        return 0;
+    }
+    ScopedUtfChars host(env, javaHost);
+    if (host.c_str() == NULL) {
+        return 0;
+    }
+    std::string hostAndPort(toHostAndPort(ssl_ctx, host.c_str(), port));
+
+    SSL_SESSION* session = NULL;
+    std::vector<std::string> peerCertificates;
+    pthread_mutex_lock(&gSessionCacheMutex);
+    SessionCacheIndex::iterator it = gSessionsByHostAndPort.find(hostAndPort);
+    if (it != gSessionsByHostAndPort.end()) {
+        session = useSessionCacheEntryLocked(it->second, &peerCertificates);
+    }
+    pthread_mutex_unlock(&gSessionCacheMutex);
+
+    JNI_TRACE("NativeCrypto_SSL_SESSION_cache_get port=%d => %p", port, session);
+    return toJavaSession(env, session, peerCertificates, peerCertificatesOut);
+}
+
+/**
+ * Returns a new reference to the session ssl_ctx cached with the given id, or
+ * 0. The caller must free the returned session with SSL_SESSION_free.
+ */
+static jint NativeCrypto_SSL_SESSION_cache_get_by_id(JNIEnv* env, jclass, jint ssl_ctx_address,
+                                                     jbyteArray javaId,
+                                                     jobjectArray peerCertificatesOut)
+{
+    SSL_CTX* ssl_ctx = to_SSL_CTX(env, ssl_ctx_address, true);
+    JNI_TRACE("ssl_ctx=%p NativeCrypto_SSL_SESSION_cache_get_by_id", ssl_ctx);
+    if (ssl_ctx == NULL) {
+        return 0;
+    }
+    if (peerCertificatesOut == NULL) {
+        jniThrowNullPointerException(env, NULL);
+        return 0;
+    }
+    ScopedByteArrayRO id(env, javaId);
+    if (id.get() == NULL) {
+        return 0;
+    }
+    std::string sessionId(sessionIdOf(ssl_ctx, reinterpret_cast<const unsigned char*>(id.get()),
+                                      id.size()));
+    if (sessionId.empty()) {
+        return 0;
+    }
+
+    SSL_SESSION* session = NULL;
+    std::vector<std::string> peerCertificates;
+    pthread_mutex_lock(&gSessionCacheMutex);
+    SessionCacheIndex::iterator it = gSessionsById.find(sessionId);
+    if (it != gSessionsById.end()) {
+        session = useSessionCacheEntryLocked(it->second, &peerCertificates);
+    }
+    pthread_mutex_unlock(&gSessionCacheMutex);
+
+    return toJavaSession(env, session, peerCertificates, peerCertificatesOut);
+}
+
+/**
+ * Sets the maximum number of sessions in the shared session cache, evicting
+ * the least recently used sessions if there are already more. 0 empties the
+ * cache and disables it.
+ */
+static void NativeCrypto_SSL_SESSION_cache_set_max_size(JNIEnv* env, jclass, jint maxSize)
+{
+    JNI_TRACE("NativeCrypto_SSL_SESSION_cache_set_max_size maxSize=%d", maxSize);
+    if (maxSize < 0) {
+        jniThrowException(env, "java/lang/IllegalArgumentException", "maxSize < 0");
+        return;
+    }
+    pthread_mutex_lock(&gSessionCacheMutex);
+    gSessionCacheMaxSize = maxSize;
+    while (gSessionCache.size() > gSessionCacheMaxSize) {
+        SessionCacheList::iterator eldest = gSessionCache.end();
+        removeSessionCacheEntryLocked(--eldest);
+    }
+    pthread_mutex_unlock(&gSessionCacheMutex);
+}
+
 /**
  * Sets the ciphers suites that are enabled in the SSL
  */
@@ -2280,56 +3144,31 @@ static jstring NativeCrypto_SSL_get_servername(JNIEnv* env, jclass, jint ssl_add
 }
 
 /**
- * Perform SSL handshake
+ * Attaches the socket to the SSL, makes it non-blocking and creates the
+ * AppData the handshake and later I/O rely on. Returns NULL with an exception
+ * pending on failure.
  */
-static jint NativeCrypto_SSL_do_handshake(JNIEnv* env, jclass,
-    jint ssl_address, jobject fdObject, jobject shc, jint timeout, jboolean client_mode)
-{
-    SSL* ssl = to_SSL(env, ssl_address, true);
-    JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake fd=%p shc=%p timeout=%d client_mode=%d",
-              ssl, fdObject, shc, timeout, client_mode);
-    if (ssl == NULL) {
-      return 0;
-    }
-    if (fdObject == NULL) {
-        jniThrowNullPointerException(env, "fd == null");
-        JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake => 0", ssl);
-        return 0;
-    }
-    if (shc == NULL) {
-        jniThrowNullPointerException(env, "sslHandshakeCallbacks == null");
-        JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake => 0", ssl);
-        return 0;
-    }
-
-    NetFd fd(env, fdObject);
-    if (fd.isClosed()) {
-        // SocketException thrown by NetFd.isClosed
-        SSL_clear(ssl);
-        JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake => 0", ssl);
-        return 0;
-    }
-
+static AppData* sslHandshakeSetup(JNIEnv* env, SSL* ssl, NetFd& fd, jboolean client_mode) {
     int ret = SSL_set_fd(ssl, fd.get());
-    JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake s=%d", ssl, fd.get());
+    JNI_TRACE("ssl=%p sslHandshakeSetup s=%d", ssl, fd.get());
 
     if (ret != 1) {
         throwSSLExceptionWithSslErrors(env, ssl, SSL_ERROR_NONE,
                                        "Error setting the file descriptor");
         SSL_clear(ssl);
-        JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake => 0", ssl);
-        return 0;
+        JNI_TRACE("ssl=%p sslHandshakeSetup => NULL", ssl);
+        return NULL;
     }
 
     /*
      * Make socket non-blocking, so SSL_connect SSL_read() and SSL_write() don't hang
-     * forever and we can use select() to find out if the socket is ready.
+     * forever and we can use poll() to find out if the socket is ready.
      */
     if (!setBlocking(fd.get(), false)) {
         throwSSLExceptionStr(env, "Unable to make socket non blocking");
         SSL_clear(ssl);
-        JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake => 0", ssl);
-        return 0;
+        JNI_TRACE("ssl=%p sslHandshakeSetup => NULL", ssl);
+        return NULL;
     }
 
     /*
@@ -2339,8 +3178,8 @@ static jint NativeCrypto_SSL_do_handshake(JNIEnv* env, jclass,
     if (appData == NULL) {
         throwSSLExceptionStr(env, "Unable to create application data");
         SSL_clear(ssl);
-        JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake => 0", ssl);
-        return 0;
+        JNI_TRACE("ssl=%p sslHandshakeSetup => NULL", ssl);
+        return NULL;
     }
     SSL_set_app_data(ssl, reinterpret_cast<char*>(appData));
     JNI_TRACE("ssl=%p AppData::create => %p", ssl, appData);
@@ -2351,43 +3190,115 @@ static jint NativeCrypto_SSL_do_handshake(JNIEnv* env, jclass,
         SSL_set_accept_state(ssl);
     }
 
-    ret = 0;
-    while (appData->aliveAndKicking) {
-        errno = 0;
+    return appData;
+}
 
-        if (!appData->setCallbackState(env, shc, fdObject)) {
-            // SocketException thrown by NetFd.isClosed
-            SSL_clear(ssl);
-            JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake => 0", ssl);
-            return 0;
-        }
-        ret = SSL_do_handshake(ssl);
-        appData->clearCallbackState();
-        // cert_verify_callback threw exception
-        if (env->ExceptionCheck()) {
-            SSL_clear(ssl);
-            JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake => 0", ssl);
-            return 0;
-        }
-        // success case
-        if (ret == 1) {
-            break;
-        }
-        // retry case
-        if (errno == EINTR) {
-            continue;
-        }
-        // error case
+/**
+ * Throws the appropriate exception for an SSL_do_handshake that returned
+ * ret <= 0 for some reason other than wanting to read or write.
+ */
+static void sslThrowHandshakeError(JNIEnv* env, SSL* ssl, int ret) {
+    // clean error. See SSL_do_handshake(3SSL) man page.
+    if (ret == 0) {
+        /*
+         * The other side closed the socket before the handshake could be
+         * completed, but everything is within the bounds of the TLS protocol.
+         * We still might want to find out the real reason of the failure.
+         */
         int sslError = SSL_get_error(ssl, ret);
-        JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake ret=%d errno=%d sslError=%d timeout=%d",
-                  ssl, ret, errno, sslError, timeout);
+        if (sslError == SSL_ERROR_NONE || (sslError == SSL_ERROR_SYSCALL && errno == 0)) {
+            throwSSLExceptionStr(env, "Connection closed by peer");
+        } else {
+            throwSSLExceptionWithSslErrors(env, ssl, sslError, "SSL handshake terminated");
+        }
+        return;
+    }
 
+    // unclean error. See SSL_do_handshake(3SSL) man page.
+    if (ret < 0) {
         /*
-         * If SSL_do_handshake doesn't succeed due to the socket being
-         * either unreadable or unwritable, we use sslSelect to
-         * wait for it to become ready. If that doesn't happen
-         * before the specified timeout or an error occurs, we
-         * cancel the handshake. Otherwise we try the SSL_connect
+         * Translate the error and throw exception. We are sure it is an error
+         * at this point.
+         */
+        int sslError = SSL_get_error(ssl, ret);
+        throwSSLExceptionWithSslErrors(env, ssl, sslError, "SSL handshake aborted");
+    }
+}
+
+/**
+ * Perform SSL handshake
+ */
+static jint NativeCrypto_SSL_do_handshake(JNIEnv* env, jclass,
+    jint ssl_address, jobject fdObject, jobject shc, jint timeout, jboolean client_mode)
+{
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake fd=%p shc=%p timeout=%d client_mode=%d",
+              ssl, fdObject, shc, timeout, client_mode);
+    if (ssl == NULL) {
+      return 0;
+    }
+    if (fdObject == NULL) {
+        jniThrowNullPointerException(env, "fd == null");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake => 0", ssl);
+        return 0;
+    }
+    if (shc == NULL) {
+        jniThrowNullPointerException(env, "sslHandshakeCallbacks == null");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake => 0", ssl);
+        return 0;
+    }
+
+    NetFd fd(env, fdObject);
+    if (fd.isClosed()) {
+        // SocketException thrown by NetFd.isClosed
+        SSL_clear(ssl);
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake => 0", ssl);
+        return 0;
+    }
+
+    AppData* appData = sslHandshakeSetup(env, ssl, fd, client_mode);
+    if (appData == NULL) {
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake => 0", ssl);
+        return 0;
+    }
+
+    int ret = 0;
+    while (appData->aliveAndKicking) {
+        errno = 0;
+
+        if (!appData->setCallbackState(env, shc, fdObject)) {
+            // SocketException thrown by NetFd.isClosed
+            SSL_clear(ssl);
+            JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake => 0", ssl);
+            return 0;
+        }
+        ret = SSL_do_handshake(ssl);
+        appData->clearCallbackState();
+        // cert_verify_callback threw exception
+        if (env->ExceptionCheck()) {
+            SSL_clear(ssl);
+            JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake => 0", ssl);
+            return 0;
+        }
+        // success case
+        if (ret == 1) {
+            break;
+        }
+        // retry case
+        if (errno == EINTR) {
+            continue;
+        }
+        // error case
+        int sslError = SSL_get_error(ssl, ret);
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake ret=%d errno=%d sslError=%d timeout=%d",
+                  ssl, ret, errno, sslError, timeout);
+
+        /*
+         * If SSL_do_handshake doesn't succeed due to the socket being
+         * either unreadable or unwritable, we use sslSelect to
+         * wait for it to become ready. If that doesn't happen
+         * before the specified timeout or an error occurs, we
+         * cancel the handshake. Otherwise we try the SSL_connect
          * again.
          */
         if (sslError == SSL_ERROR_WANT_READ || sslError == SSL_ERROR_WANT_WRITE) {
@@ -2419,39 +3330,104 @@ static jint NativeCrypto_SSL_do_handshake(JNIEnv* env, jclass,
         }
     }
 
-    // clean error. See SSL_do_handshake(3SSL) man page.
-    if (ret == 0) {
-        /*
-         * The other side closed the socket before the handshake could be
-         * completed, but everything is within the bounds of the TLS protocol.
-         * We still might want to find out the real reason of the failure.
-         */
-        int sslError = SSL_get_error(ssl, ret);
-        if (sslError == SSL_ERROR_NONE || (sslError == SSL_ERROR_SYSCALL && errno == 0)) {
-            throwSSLExceptionStr(env, "Connection closed by peer");
-        } else {
-            throwSSLExceptionWithSslErrors(env, ssl, sslError, "SSL handshake terminated");
-        }
+    if (ret <= 0) {
+        sslThrowHandshakeError(env, ssl, ret);
         SSL_clear(ssl);
         JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake => 0", ssl);
         return 0;
     }
+    SSL_SESSION* ssl_session = SSL_get1_session(ssl);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake => ssl_session=%p", ssl, ssl_session);
+    return (jint) ssl_session;
+}
 
-    // unclean error. See SSL_do_handshake(3SSL) man page.
-    if (ret < 0) {
-        /*
-         * Translate the error and throw exception. We are sure it is an error
-         * at this point.
-         */
-        int sslError = SSL_get_error(ssl, ret);
-        throwSSLExceptionWithSslErrors(env, ssl, sslError, "SSL handshake aborted");
-        SSL_clear(ssl);
-        JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake => 0", ssl);
+/**
+ * Takes one non-blocking step of the SSL handshake. The first call attaches
+ * the socket and sets up the connection like SSL_do_handshake; later calls
+ * continue from where the last one stopped. Returns SSL_ERROR_NONE once the
+ * handshake is complete, or SSL_ERROR_WANT_READ or SSL_ERROR_WANT_WRITE when
+ * the caller should wait for the socket (with its own selector) and call
+ * again. The verification and client certificate callbacks run during the
+ * step that needs them, on the calling thread.
+ */
+static jint NativeCrypto_SSL_do_handshake_nonblocking(JNIEnv* env, jclass,
+    jint ssl_address, jobject fdObject, jobject shc, jboolean client_mode)
+{
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake_nonblocking fd=%p shc=%p client_mode=%d",
+              ssl, fdObject, shc, client_mode);
+    if (ssl == NULL) {
+      return -1;
+    }
+    if (fdObject == NULL) {
+        jniThrowNullPointerException(env, "fd == null");
+        return -1;
+    }
+    if (shc == NULL) {
+        jniThrowNullPointerException(env, "sslHandshakeCallbacks == null");
+        return -1;
+    }
+
+    AppData* appData = reinterpret_cast<AppData*>(SSL_get_app_data(ssl));
+    if (appData == NULL) {
+        NetFd fd(env, fdObject);
+        if (fd.isClosed()) {
+            // SocketException thrown by NetFd.isClosed
+            SSL_clear(ssl);
+            return -1;
+        }
+        appData = sslHandshakeSetup(env, ssl, fd, client_mode);
+        if (appData == NULL) {
+            JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake_nonblocking => -1", ssl);
+            return -1;
+        }
+    }
+
+    int ret;
+    do {
+        errno = 0;
+        if (!appData->setCallbackState(env, shc, fdObject)) {
+            // SocketException thrown by NetFd.isClosed
+            SSL_clear(ssl);
+            return -1;
+        }
+        ret = SSL_do_handshake(ssl);
+        appData->clearCallbackState();
+        // cert_verify_callback threw exception
+        if (env->ExceptionCheck()) {
+            SSL_clear(ssl);
+            return -1;
+        }
+    } while (ret != 1 && errno == EINTR);
+
+    if (ret == 1) {
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake_nonblocking => SSL_ERROR_NONE", ssl);
+        return SSL_ERROR_NONE;
+    }
+    int sslError = SSL_get_error(ssl, ret);
+    if (sslError == SSL_ERROR_WANT_READ || sslError == SSL_ERROR_WANT_WRITE) {
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake_nonblocking => %d", ssl, sslError);
+        return sslError;
+    }
+    sslThrowHandshakeError(env, ssl, ret);
+    SSL_clear(ssl);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake_nonblocking => -1", ssl);
+    return -1;
+}
+
+/**
+ * Returns a new reference to the SSL's negotiated session, for use after a
+ * non-blocking handshake completes.
+ */
+static jint NativeCrypto_SSL_get1_session(JNIEnv* env, jclass, jint ssl_address) {
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_get1_session", ssl);
+    if (ssl == NULL) {
         return 0;
     }
     SSL_SESSION* ssl_session = SSL_get1_session(ssl);
-    JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake => ssl_session=%p", ssl, ssl_session);
-    return (jint) ssl_session;
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_get1_session => %p", ssl, ssl_session);
+    return static_cast<jint>(reinterpret_cast<uintptr_t>(ssl_session));
 }
 
 /**
@@ -2481,80 +3457,194 @@ static void NativeCrypto_SSL_renegotiate(JNIEnv* env, jclass, jint ssl_address)
 }
 
 /**
- * public static native byte[][] SSL_get_certificate(int ssl);
+ * Returns the DER encodings of a certificate chain in out, from the AppData
+ * cache if it was encoded from the same X509 objects. Without AppData
+ * (before the handshake starts) the chain is simply encoded. Returns false if
+ * encoding failed.
  */
-static jobjectArray NativeCrypto_SSL_get_certificate(JNIEnv* env, jclass, jint ssl_address)
-{
-    SSL* ssl = to_SSL(env, ssl_address, true);
-    JNI_TRACE("ssl=%p NativeCrypto_SSL_get_certificate", ssl);
-    if (ssl == NULL) {
-        return NULL;
+static bool cachedCertificates(AppData* appData, const STACK_OF(X509)* chain, bool peer,
+                               std::vector<std::string>& out) {
+    if (appData == NULL) {
+        return encodeCertificates(chain, out);
+    }
+    bool& cachedValid = peer ? appData->peerCertificatesCached : appData->localCertificatesCached;
+    std::vector<X509*>& cachedSource =
+            peer ? appData->peerCertificatesSource : appData->localCertificatesSource;
+    std::vector<std::string>& cached =
+            peer ? appData->peerCertificates : appData->localCertificates;
+
+    MUTEX_LOCK(appData->certificateMutex);
+    bool ok = true;
+    if (!cachedValid || !sameCertificates(cachedSource, chain)) {
+        ok = encodeCertificates(chain, cached);
+        cachedValid = ok;
+        if (ok) {
+            holdCertificates(cachedSource, chain);
+        } else {
+            releaseCertificates(cachedSource);
+        }
+    }
+    if (ok) {
+        out = cached;
     }
+    MUTEX_UNLOCK(appData->certificateMutex);
+    return ok;
+}
+
+/**
+ * Fills out with the DER encodings of the local certificate chain, leaf
+ * first. Returns false with an exception pending on failure.
+ */
+static bool localCertificates(JNIEnv* env, SSL* ssl, std::vector<std::string>& out) {
+    out.clear();
     X509* certificate = SSL_get_certificate(ssl);
     if (certificate == NULL) {
-        JNI_TRACE("ssl=%p NativeCrypto_SSL_get_certificate => NULL", ssl);
-        return NULL;
+        return true;
     }
+    STACK_OF(X509)* cert_chain = SSL_get_certificate_chain(ssl, certificate);
 
     Unique_sk_X509 chain(sk_X509_new_null());
     if (chain.get() == NULL) {
         jniThrowOutOfMemoryError(env, "Unable to allocate local certificate chain");
-        JNI_TRACE("ssl=%p NativeCrypto_SSL_get_certificate => threw exception", ssl);
-        return NULL;
+        return false;
     }
     if (!sk_X509_push(chain.get(), certificate)) {
         jniThrowOutOfMemoryError(env, "Unable to push local certificate");
-        JNI_TRACE("ssl=%p NativeCrypto_SSL_get_certificate => NULL", ssl);
-        return NULL;
+        return false;
     }
-    STACK_OF(X509)* cert_chain = SSL_get_certificate_chain(ssl, certificate);
     for (int i=0; i<sk_X509_num(cert_chain); i++) {
         if (!sk_X509_push(chain.get(), sk_X509_value(cert_chain, i))) {
             jniThrowOutOfMemoryError(env, "Unable to push local certificate chain");
-            JNI_TRACE("ssl=%p NativeCrypto_SSL_get_certificate => NULL", ssl);
-            return NULL;
+            return false;
         }
     }
-
-    jobjectArray objectArray = getCertificateBytes(env, chain.get());
-    JNI_TRACE("ssl=%p NativeCrypto_SSL_get_certificate => %p", ssl, objectArray);
-    return objectArray;
+    if (!cachedCertificates(toAppData(ssl), chain.get(), false, out)) {
+        throwSSLExceptionStr(env, "Unable to encode local certificate chain");
+        return false;
+    }
+    return true;
 }
 
-// Fills a byte[][] with the peer certificates in the chain.
-static jobjectArray NativeCrypto_SSL_get_peer_cert_chain(JNIEnv* env, jclass, jint ssl_address)
-{
-    SSL* ssl = to_SSL(env, ssl_address, true);
-    JNI_TRACE("ssl=%p NativeCrypto_SSL_get_peer_cert_chain", ssl);
-    if (ssl == NULL) {
-        return NULL;
-    }
+/**
+ * Fills out with the DER encodings of the peer's certificate chain, leaf
+ * first. Returns false with an exception pending on failure.
+ */
+static bool peerCertificates(JNIEnv* env, SSL* ssl, std::vector<std::string>& out) {
+    out.clear();
     STACK_OF(X509)* chain = SSL_get_peer_cert_chain(ssl);
     Unique_sk_X509 chain_copy(NULL);
+    X509* x509 = NULL;
     if (ssl->server) {
-        X509* x509 = SSL_get_peer_certificate(ssl);
+        // A server's peer chain doesn't include the client's own certificate.
+        x509 = SSL_get_peer_certificate(ssl);
         if (x509 == NULL) {
-            JNI_TRACE("ssl=%p NativeCrypto_SSL_get_peer_cert_chain => NULL", ssl);
-            return NULL;
+            return true;
         }
+        // SSL_get_peer_certificate took a reference we don't want to keep.
+        X509_free(x509);
         chain_copy.reset(sk_X509_dup(chain));
         if (chain_copy.get() == NULL) {
             jniThrowOutOfMemoryError(env, "Unable to allocate peer certificate chain");
-            JNI_TRACE("ssl=%p NativeCrypto_SSL_get_peer_cert_chain => certificate dup error", ssl);
-            return NULL;
+            return false;
         }
         if (!sk_X509_push(chain_copy.get(), x509)) {
             jniThrowOutOfMemoryError(env, "Unable to push server's peer certificate");
-            JNI_TRACE("ssl=%p NativeCrypto_SSL_get_peer_cert_chain => certificate push error", ssl);
-            return NULL;
+            return false;
         }
-        chain = chain_copy.get();
     }
-    jobjectArray objectArray = getCertificateBytes(env, chain);
+    if (!cachedCertificates(toAppData(ssl),
+                            chain_copy.get() != NULL ? chain_copy.get() : chain, true, out)) {
+        throwSSLExceptionStr(env, "Unable to encode peer certificate chain");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * public static native byte[][] SSL_get_certificate(int ssl);
+ */
+static jobjectArray NativeCrypto_SSL_get_certificate(JNIEnv* env, jclass, jint ssl_address)
+{
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_get_certificate", ssl);
+    if (ssl == NULL) {
+        return NULL;
+    }
+    std::vector<std::string> encoded;
+    if (!localCertificates(env, ssl, encoded)) {
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_get_certificate => threw exception", ssl);
+        return NULL;
+    }
+    jobjectArray objectArray = toCertificateArray(env, encoded);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_get_certificate => %p", ssl, objectArray);
+    return objectArray;
+}
+
+// Fills a byte[][] with the peer certificates in the chain.
+static jobjectArray NativeCrypto_SSL_get_peer_cert_chain(JNIEnv* env, jclass, jint ssl_address)
+{
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_get_peer_cert_chain", ssl);
+    if (ssl == NULL) {
+        return NULL;
+    }
+    std::vector<std::string> encoded;
+    if (!peerCertificates(env, ssl, encoded)) {
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_get_peer_cert_chain => threw exception", ssl);
+        return NULL;
+    }
+    jobjectArray objectArray = toCertificateArray(env, encoded);
     JNI_TRACE("ssl=%p NativeCrypto_SSL_get_peer_cert_chain => %p", ssl, objectArray);
     return objectArray;
 }
 
+/**
+ * public static native byte[][] SSL_get_peer_cert_fingerprints(int ssl, String algorithm);
+ *
+ * Returns the digest of each certificate in the peer's chain, leaf first,
+ * without copying the certificates themselves to Java.
+ */
+static jobjectArray NativeCrypto_SSL_get_peer_cert_fingerprints(JNIEnv* env, jclass,
+        jint ssl_address, jstring algorithm)
+{
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_get_peer_cert_fingerprints %p", ssl, algorithm);
+    if (ssl == NULL) {
+        return NULL;
+    }
+    if (algorithm == NULL) {
+        jniThrowNullPointerException(env, "algorithm == null");
+        return NULL;
+    }
+    ScopedUtfChars algorithmChars(env, algorithm);
+    if (algorithmChars.c_str() == NULL) {
+        return NULL;
+    }
+    const EVP_MD* digest = EVP_get_digestbynid(OBJ_txt2nid(algorithmChars.c_str()));
+    if (digest == NULL) {
+        jniThrowRuntimeException(env, "Hash algorithm not found");
+        return NULL;
+    }
+
+    std::vector<std::string> encoded;
+    if (!peerCertificates(env, ssl, encoded)) {
+        return NULL;
+    }
+    std::vector<std::string> fingerprints(encoded.size());
+    for (size_t i = 0; i < encoded.size(); i++) {
+        unsigned char md[EVP_MAX_MD_SIZE];
+        unsigned int mdLength;
+        if (!EVP_Digest(encoded[i].data(), encoded[i].size(), md, &mdLength, digest, NULL)) {
+            throwExceptionIfNecessary(env, "NativeCrypto_SSL_get_peer_cert_fingerprints");
+            return NULL;
+        }
+        fingerprints[i].assign(reinterpret_cast<const char*>(md), mdLength);
+    }
+    jobjectArray objectArray = toCertificateArray(env, fingerprints);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_get_peer_cert_fingerprints => %p", ssl, objectArray);
+    return objectArray;
+}
+
 /**
  * Helper function which does the actual reading. The Java layer guarantees that
  * at most one thread will enter this function at any given time.
@@ -2741,6 +3831,42 @@ static jint NativeCrypto_SSL_read_byte(JNIEnv* env, jclass, jint ssl_address,
     return result;
 }
 
+/**
+ * Reads into 'buf' with sslRead, throwing the appropriate exception on failure.
+ * Returns the number of bytes read, or -1 at end of stream or if an exception
+ * was thrown.
+ */
+static jint sslReadOrThrow(JNIEnv* env, SSL* ssl, jobject fdObject, jobject shc,
+                           char* buf, jint len, jint timeout)
+{
+    int returnCode = 0;
+    int sslErrorCode = SSL_ERROR_NONE;
+
+    int ret = sslRead(env, ssl, fdObject, shc, buf, len, &returnCode, &sslErrorCode, timeout);
+
+    int result;
+    switch (ret) {
+        case THROW_EXCEPTION:
+            // See sslRead() regarding improper failure to handle normal cases.
+            throwSSLExceptionWithSslErrors(env, ssl, sslErrorCode, "Read error");
+            result = -1;
+            break;
+        case THROW_SOCKETTIMEOUTEXCEPTION:
+            throwSocketTimeoutException(env, "Read timed out");
+            result = -1;
+            break;
+        case THROWN_SOCKETEXCEPTION:
+            // SocketException thrown by NetFd.isClosed
+            result = -1;
+            break;
+        default:
+            result = ret;
+            break;
+    }
+
+    return result;
+}
+
 /**
  * OpenSSL read function (2): read into buffer at offset n chunks.
  * Returns 1 (success) or value <= 0 (failure).
@@ -2770,33 +3896,40 @@ static jint NativeCrypto_SSL_read(JNIEnv* env, jclass, jint ssl_address, jobject
         JNI_TRACE("ssl=%p NativeCrypto_SSL_read => threw exception", ssl);
         return 0;
     }
-    int returnCode = 0;
-    int sslErrorCode = SSL_ERROR_NONE;;
-
-    int ret = sslRead(env, ssl, fdObject, shc, reinterpret_cast<char*>(bytes.get() + offset), len,
-                      &returnCode, &sslErrorCode, timeout);
+    jint result = sslReadOrThrow(env, ssl, fdObject, shc,
+                                 reinterpret_cast<char*>(bytes.get() + offset), len, timeout);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_read => %d", ssl, result);
+    return result;
+}
 
-    int result;
-    switch (ret) {
-        case THROW_EXCEPTION:
-            // See sslRead() regarding improper failure to handle normal cases.
-            throwSSLExceptionWithSslErrors(env, ssl, sslErrorCode, "Read error");
-            result = -1;
-            break;
-        case THROW_SOCKETTIMEOUTEXCEPTION:
-            throwSocketTimeoutException(env, "Read timed out");
-            result = -1;
-            break;
-        case THROWN_SOCKETEXCEPTION:
-            // SocketException thrown by NetFd.isClosed
-            result = -1;
-            break;
-        default:
-            result = ret;
-            break;
+/**
+ * OpenSSL read function (3): read into native memory, such as a direct
+ * ByteBuffer, avoiding a copy through the Java heap.
+ */
+static jint NativeCrypto_SSL_read_direct(JNIEnv* env, jclass, jint ssl_address, jobject fdObject,
+                                         jobject shc, jint address, jint len, jint timeout)
+{
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_read_direct fd=%p shc=%p address=%p len=%d timeout=%d",
+              ssl, fdObject, shc, reinterpret_cast<void*>(static_cast<uintptr_t>(address)), len,
+              timeout);
+    if (ssl == NULL) {
+        return 0;
+    }
+    if (fdObject == NULL) {
+        jniThrowNullPointerException(env, "fd == null");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_read_direct => fd == null", ssl);
+        return 0;
+    }
+    if (shc == NULL) {
+        jniThrowNullPointerException(env, "sslHandshakeCallbacks == null");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_read_direct => sslHandshakeCallbacks == null", ssl);
+        return 0;
     }
 
-    JNI_TRACE("ssl=%p NativeCrypto_SSL_read => %d", ssl, result);
+    char* buf = reinterpret_cast<char*>(static_cast<uintptr_t>(address));
+    jint result = sslReadOrThrow(env, ssl, fdObject, shc, buf, len, timeout);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_read_direct => %d", ssl, result);
     return result;
 }
 
@@ -2978,6 +4111,32 @@ static void NativeCrypto_SSL_write_byte(JNIEnv* env, jclass, jint ssl_address,
     }
 }
 
+/**
+ * Writes 'buf' with sslWrite, throwing the appropriate exception on failure.
+ */
+static void sslWriteOrThrow(JNIEnv* env, SSL* ssl, jobject fdObject, jobject shc,
+                            const char* buf, jint len)
+{
+    int returnCode = 0;
+    int sslErrorCode = SSL_ERROR_NONE;
+    int ret = sslWrite(env, ssl, fdObject, shc, buf, len, &returnCode, &sslErrorCode);
+
+    switch (ret) {
+        case THROW_EXCEPTION:
+            // See sslWrite() regarding improper failure to handle normal cases.
+            throwSSLExceptionWithSslErrors(env, ssl, sslErrorCode, "Write error");
+            break;
+        case THROW_SOCKETTIMEOUTEXCEPTION:
+            throwSocketTimeoutException(env, "Write timed out");
+            break;
+        case THROWN_SOCKETEXCEPTION:
+            // SocketException thrown by NetFd.isClosed
+            break;
+        default:
+            break;
+    }
+}
+
 /**
  * OpenSSL write function (2): write into buffer at offset n chunks.
  */
@@ -3006,24 +4165,124 @@ static void NativeCrypto_SSL_write(JNIEnv* env, jclass, jint ssl_address, jobjec
         JNI_TRACE("ssl=%p NativeCrypto_SSL_write => threw exception", ssl);
         return;
     }
-    int returnCode = 0;
-    int sslErrorCode = SSL_ERROR_NONE;
-    int ret = sslWrite(env, ssl, fdObject, shc, reinterpret_cast<const char*>(bytes.get() + offset),
-                       len, &returnCode, &sslErrorCode);
+    sslWriteOrThrow(env, ssl, fdObject, shc, reinterpret_cast<const char*>(bytes.get() + offset),
+                    len);
+}
 
-    switch (ret) {
-        case THROW_EXCEPTION:
-            // See sslWrite() regarding improper failure to handle normal cases.
-            throwSSLExceptionWithSslErrors(env, ssl, sslErrorCode, "Write error");
-            break;
-        case THROW_SOCKETTIMEOUTEXCEPTION:
-            throwSocketTimeoutException(env, "Write timed out");
-            break;
-        case THROWN_SOCKETEXCEPTION:
-            // SocketException thrown by NetFd.isClosed
-            break;
-        default:
-            break;
+/**
+ * OpenSSL write function (3): write from native memory, such as a direct
+ * ByteBuffer, avoiding a copy through the Java heap.
+ */
+static void NativeCrypto_SSL_write_direct(JNIEnv* env, jclass, jint ssl_address, jobject fdObject,
+                                          jobject shc, jint address, jint len)
+{
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_write_direct fd=%p shc=%p address=%p len=%d",
+              ssl, fdObject, shc, reinterpret_cast<void*>(static_cast<uintptr_t>(address)), len);
+    if (ssl == NULL) {
+        return;
+    }
+    if (fdObject == NULL) {
+        jniThrowNullPointerException(env, "fd == null");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_write_direct => fd == null", ssl);
+        return;
+    }
+    if (shc == NULL) {
+        jniThrowNullPointerException(env, "sslHandshakeCallbacks == null");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_write_direct => sslHandshakeCallbacks == null", ssl);
+        return;
+    }
+
+    const char* buf = reinterpret_cast<const char*>(static_cast<uintptr_t>(address));
+    sslWriteOrThrow(env, ssl, fdObject, shc, buf, len);
+}
+
+/**
+ * The most plaintext a single TLS record can carry. Gathering writes are
+ * packed into records of this size.
+ */
+static const jint SSL_MAX_RECORD_PLAINTEXT = 16 * 1024;
+
+/**
+ * OpenSSL write function (4): write several buffers, packing them into as few
+ * full-sized TLS records as possible rather than one record per buffer.
+ */
+static void NativeCrypto_SSL_write_gathering(JNIEnv* env, jclass, jint ssl_address,
+                                             jobject fdObject, jobject shc,
+                                             jobjectArray buffers, jintArray offsets,
+                                             jintArray lengths)
+{
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_write_gathering fd=%p shc=%p buffers=%p",
+              ssl, fdObject, shc, buffers);
+    if (ssl == NULL) {
+        return;
+    }
+    if (fdObject == NULL) {
+        jniThrowNullPointerException(env, "fd == null");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_write_gathering => fd == null", ssl);
+        return;
+    }
+    if (shc == NULL) {
+        jniThrowNullPointerException(env, "sslHandshakeCallbacks == null");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_write_gathering => sslHandshakeCallbacks == null", ssl);
+        return;
+    }
+    if (buffers == NULL) {
+        jniThrowNullPointerException(env, "buffers == null");
+        return;
+    }
+    ScopedIntArrayRO offsetsArray(env, offsets);
+    if (offsetsArray.get() == NULL) {
+        return;
+    }
+    ScopedIntArrayRO lengthsArray(env, lengths);
+    if (lengthsArray.get() == NULL) {
+        return;
+    }
+    jsize count = env->GetArrayLength(buffers);
+    if (offsetsArray.size() < static_cast<size_t>(count) ||
+            lengthsArray.size() < static_cast<size_t>(count)) {
+        jniThrowException(env, "java/lang/ArrayIndexOutOfBoundsException", NULL);
+        return;
+    }
+
+    UniquePtr<char[]> record(new char[SSL_MAX_RECORD_PLAINTEXT]);
+    jint recordLength = 0;
+    for (jsize i = 0; i < count; ++i) {
+        ScopedLocalRef<jbyteArray> buffer(env,
+                reinterpret_cast<jbyteArray>(env->GetObjectArrayElement(buffers, i)));
+        if (buffer.get() == NULL) {
+            jniThrowNullPointerException(env, "buffers[i] == null");
+            return;
+        }
+        jint offset = offsetsArray[i];
+        jint length = lengthsArray[i];
+        if ((offset | length) < 0 || length > env->GetArrayLength(buffer.get()) - offset) {
+            jniThrowException(env, "java/lang/ArrayIndexOutOfBoundsException", NULL);
+            return;
+        }
+        while (length > 0) {
+            jint chunk = SSL_MAX_RECORD_PLAINTEXT - recordLength;
+            if (chunk > length) {
+                chunk = length;
+            }
+            env->GetByteArrayRegion(buffer.get(), offset, chunk,
+                                    reinterpret_cast<jbyte*>(record.get() + recordLength));
+            recordLength += chunk;
+            offset += chunk;
+            length -= chunk;
+            if (recordLength == SSL_MAX_RECORD_PLAINTEXT) {
+                sslWriteOrThrow(env, ssl, fdObject, shc, record.get(), recordLength);
+                if (env->ExceptionCheck()) {
+                    return;
+                }
+                recordLength = 0;
+            }
+        }
+    }
+    if (recordLength > 0) {
+        sslWriteOrThrow(env, ssl, fdObject, shc, record.get(), recordLength);
     }
 }
 
@@ -3040,7 +4299,7 @@ static void NativeCrypto_SSL_interrupt(
 
     /*
      * Mark the connection as quasi-dead, then send something to the emergency
-     * file descriptor, so any blocking select() calls are woken up.
+     * file descriptor, so any blocking poll() calls are woken up.
      */
     AppData* appData = toAppData(ssl);
     if (appData != NULL) {
@@ -3327,6 +4586,9 @@ static jint NativeCrypto_d2i_SSL_SESSION(JNIEnv* env, jclass, jbyteArray javaByt
 #define SSL_CALLBACKS "Lorg/apache/harmony/xnet/provider/jsse/NativeCrypto$SSLHandshakeCallbacks;"
 static JNINativeMethod sNativeCryptoMethods[] = {
     NATIVE_METHOD(NativeCrypto, clinit, "()V"),
+    NATIVE_METHOD(NativeCrypto, CRYPTO_set_lock_stats_enabled, "(Z)V"),
+    NATIVE_METHOD(NativeCrypto, CRYPTO_get_lock_stats, "()[J"),
+    NATIVE_METHOD(NativeCrypto, CRYPTO_get_lock_name, "(I)Ljava/lang/String;"),
     NATIVE_METHOD(NativeCrypto, EVP_PKEY_new_DSA, "([B[B[B[B[B)I"),
     NATIVE_METHOD(NativeCrypto, EVP_PKEY_new_RSA, "([B[B[B[B[B)I"),
     NATIVE_METHOD(NativeCrypto, EVP_PKEY_free, "(I)V"),
@@ -3338,6 +4600,8 @@ static JNINativeMethod sNativeCryptoMethods[] = {
     NATIVE_METHOD(NativeCrypto, EVP_MD_CTX_block_size, "(I)I"),
     NATIVE_METHOD(NativeCrypto, EVP_MD_CTX_size, "(I)I"),
     NATIVE_METHOD(NativeCrypto, EVP_DigestUpdate, "(I[BII)V"),
+    NATIVE_METHOD(NativeCrypto, EVP_DigestUpdateDirect, "(III)V"),
+    NATIVE_METHOD(NativeCrypto, EVP_Digest_batch, "(Ljava/lang/String;[B[I[I[B)I"),
     NATIVE_METHOD(NativeCrypto, EVP_VerifyInit, "(ILjava/lang/String;)V"),
     NATIVE_METHOD(NativeCrypto, EVP_VerifyUpdate, "(I[BII)V"),
     NATIVE_METHOD(NativeCrypto, EVP_VerifyFinal, "(I[BIII)I"),
@@ -3345,6 +4609,7 @@ static JNINativeMethod sNativeCryptoMethods[] = {
     NATIVE_METHOD(NativeCrypto, RAND_seed, "([B)V"),
     NATIVE_METHOD(NativeCrypto, RAND_load_file, "(Ljava/lang/String;J)I"),
     NATIVE_METHOD(NativeCrypto, SSL_CTX_new, "()I"),
+    NATIVE_METHOD(NativeCrypto, SSL_ephemeral_key_pool_configure, "(I[I)V"),
     NATIVE_METHOD(NativeCrypto, SSL_CTX_free, "(I)V"),
     NATIVE_METHOD(NativeCrypto, SSL_new, "(I)I"),
     NATIVE_METHOD(NativeCrypto, SSL_use_PrivateKey, "(I[B)V"),
@@ -3364,13 +4629,19 @@ static JNINativeMethod sNativeCryptoMethods[] = {
     NATIVE_METHOD(NativeCrypto, SSL_set_tlsext_host_name, "(ILjava/lang/String;)V"),
     NATIVE_METHOD(NativeCrypto, SSL_get_servername, "(I)Ljava/lang/String;"),
     NATIVE_METHOD(NativeCrypto, SSL_do_handshake, "(I" FILE_DESCRIPTOR SSL_CALLBACKS "IZ)I"),
+    NATIVE_METHOD(NativeCrypto, SSL_do_handshake_nonblocking, "(I" FILE_DESCRIPTOR SSL_CALLBACKS "Z)I"),
+    NATIVE_METHOD(NativeCrypto, SSL_get1_session, "(I)I"),
     NATIVE_METHOD(NativeCrypto, SSL_renegotiate, "(I)V"),
     NATIVE_METHOD(NativeCrypto, SSL_get_certificate, "(I)[[B"),
     NATIVE_METHOD(NativeCrypto, SSL_get_peer_cert_chain, "(I)[[B"),
+    NATIVE_METHOD(NativeCrypto, SSL_get_peer_cert_fingerprints, "(ILjava/lang/String;)[[B"),
     NATIVE_METHOD(NativeCrypto, SSL_read_byte, "(I" FILE_DESCRIPTOR SSL_CALLBACKS "I)I"),
     NATIVE_METHOD(NativeCrypto, SSL_read, "(I" FILE_DESCRIPTOR SSL_CALLBACKS "[BIII)I"),
+    NATIVE_METHOD(NativeCrypto, SSL_read_direct, "(I" FILE_DESCRIPTOR SSL_CALLBACKS "III)I"),
     NATIVE_METHOD(NativeCrypto, SSL_write_byte, "(I" FILE_DESCRIPTOR SSL_CALLBACKS "I)V"),
     NATIVE_METHOD(NativeCrypto, SSL_write, "(I" FILE_DESCRIPTOR SSL_CALLBACKS "[BII)V"),
+    NATIVE_METHOD(NativeCrypto, SSL_write_direct, "(I" FILE_DESCRIPTOR SSL_CALLBACKS "II)V"),
+    NATIVE_METHOD(NativeCrypto, SSL_write_gathering, "(I" FILE_DESCRIPTOR SSL_CALLBACKS "[[B[I[I)V"),
     NATIVE_METHOD(NativeCrypto, SSL_interrupt, "(I)V"),
     NATIVE_METHOD(NativeCrypto, SSL_shutdown, "(I" FILE_DESCRIPTOR SSL_CALLBACKS ")V"),
     NATIVE_METHOD(NativeCrypto, SSL_free, "(I)V"),
@@ -3380,6 +4651,10 @@ static JNINativeMethod sNativeCryptoMethods[] = {
     NATIVE_METHOD(NativeCrypto, SSL_SESSION_cipher, "(I)Ljava/lang/String;"),
     NATIVE_METHOD(NativeCrypto, SSL_SESSION_compress_meth, "(II)Ljava/lang/String;"),
     NATIVE_METHOD(NativeCrypto, SSL_SESSION_free, "(I)V"),
+    NATIVE_METHOD(NativeCrypto, SSL_SESSION_cache_put, "(ILjava/lang/String;II[[B)V"),
+    NATIVE_METHOD(NativeCrypto, SSL_SESSION_cache_get, "(ILjava/lang/String;I[[[B)I"),
+    NATIVE_METHOD(NativeCrypto, SSL_SESSION_cache_get_by_id, "(I[B[[[B)I"),
+    NATIVE_METHOD(NativeCrypto, SSL_SESSION_cache_set_max_size, "(I)V"),
     NATIVE_METHOD(NativeCrypto, i2d_SSL_SESSION, "(I)[B"),
     NATIVE_METHOD(NativeCrypto, d2i_SSL_SESSION, "([B)I"),
 };
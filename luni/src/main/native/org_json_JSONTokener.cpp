@@ -0,0 +1,311 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "JSONTokener"
+
+#include "JNIHelp.h"
+#include "JniConstants.h"
+#include "jni.h"
+
+#include <string.h>
+#include <vector>
+
+// As in Utf8.cpp, we pick the vector kernel at compile time for the ABI we're built for.
+#if defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define HAVE_NEON_SCAN
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define HAVE_SSE2_SCAN
+#endif
+
+// Token types. These must be kept in sync with the TOKEN_ constants in JSONTokener.java.
+enum TokenType {
+    TOKEN_END = 0,
+    TOKEN_ERROR = 1,
+    TOKEN_BEGIN_OBJECT = 2,
+    TOKEN_END_OBJECT = 3,
+    TOKEN_BEGIN_ARRAY = 4,
+    TOKEN_END_ARRAY = 5,
+    TOKEN_NAME_SEPARATOR = 6,
+    TOKEN_VALUE_SEPARATOR = 7,
+    TOKEN_STRING = 8,
+    TOKEN_ESCAPED_STRING = 9,
+    TOKEN_LITERAL = 10,
+    TOKEN_TRUE = 11,
+    TOKEN_FALSE = 12,
+    TOKEN_NULL = 13,
+    TOKEN_INTEGER = 14,
+};
+
+static void addToken(std::vector<jint>& tape, TokenType type, size_t offset, size_t length) {
+    tape.push_back(type);
+    tape.push_back(offset);
+    tape.push_back(length);
+}
+
+/**
+ * Returns the index of the first char at or after 'i' that is either 'quote' or a backslash, or
+ * 'length' if there's none. Looks at 8 chars at a time where the CPU allows; string bodies are
+ * most of most documents.
+ */
+static size_t findQuoteOrBackslash(const jchar* chars, size_t i, size_t length, jchar quote) {
+#if defined(HAVE_NEON_SCAN)
+    const uint16x8_t quotes = vdupq_n_u16(quote);
+    const uint16x8_t backslashes = vdupq_n_u16('\\');
+    for (; i + 8 <= length; i += 8) {
+        uint16x8_t v = vld1q_u16(chars + i);
+        uint64x2_t hits = vreinterpretq_u64_u16(
+                vorrq_u16(vceqq_u16(v, quotes), vceqq_u16(v, backslashes)));
+        if ((vgetq_lane_u64(hits, 0) | vgetq_lane_u64(hits, 1)) != 0) {
+            break;
+        }
+    }
+#elif defined(HAVE_SSE2_SCAN)
+    const __m128i quotes = _mm_set1_epi16(quote);
+    const __m128i backslashes = _mm_set1_epi16('\\');
+    for (; i + 8 <= length; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(chars + i));
+        __m128i hits = _mm_or_si128(_mm_cmpeq_epi16(v, quotes), _mm_cmpeq_epi16(v, backslashes));
+        if (_mm_movemask_epi8(hits) != 0) {
+            break;
+        }
+    }
+#endif
+    for (; i < length && chars[i] != quote && chars[i] != '\\'; ++i) {
+    }
+    return i;
+}
+
+/**
+ * Returns true for the chars that end an unquoted literal. These are the ones JSONTokener's
+ * readLiteral has always stopped at.
+ */
+static bool endsLiteral(jchar ch) {
+    switch (ch) {
+    case '{': case '}': case '[': case ']': case '/': case '\\': case ':': case ',': case '=':
+    case ';': case '#': case ' ': case '\t': case '\f': case '\r': case '\n':
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool literalEquals(const jchar* chars, size_t length, const char* keyword) {
+    if (length != strlen(keyword)) {
+        return false;
+    }
+    for (size_t i = 0; i < length; ++i) {
+        if (chars[i] != keyword[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Picks out the literals Java can turn into values without first making a String of them:
+ * lower-case keywords, and decimal integers too short to overflow an int. Anything else,
+ * including octal, hex and floating point, is left to readLiteral.
+ */
+static TokenType classifyLiteral(const jchar* chars, size_t length) {
+    if (literalEquals(chars, length, "true")) {
+        return TOKEN_TRUE;
+    } else if (literalEquals(chars, length, "false")) {
+        return TOKEN_FALSE;
+    } else if (literalEquals(chars, length, "null")) {
+        return TOKEN_NULL;
+    }
+    size_t i = (chars[0] == '-') ? 1 : 0;
+    size_t digitCount = length - i;
+    // A leading zero means octal, unless there's a sign or it's the only digit.
+    if (digitCount == 0 || digitCount > 9 || (i == 0 && chars[0] == '0' && length > 1)) {
+        return TOKEN_LITERAL;
+    }
+    for (; i < length; ++i) {
+        if (chars[i] < '0' || chars[i] > '9') {
+            return TOKEN_LITERAL;
+        }
+    }
+    return TOKEN_INTEGER;
+}
+
+/**
+ * Returns the index just after the next '\r' or '\n' at or after 'i', or 'length'.
+ */
+static size_t skipToEndOfLine(const jchar* chars, size_t i, size_t length) {
+    for (; i < length; ++i) {
+        if (chars[i] == '\r' || chars[i] == '\n') {
+            return i + 1;
+        }
+    }
+    return length;
+}
+
+/**
+ * Appends the tokens of the value starting at chars[pos] to 'tape', skipping whitespace and
+ * comments exactly as JSONTokener.nextCleanInternal does. Only one value is scanned, so a caller
+ * that moves around the input a value at a time never rescans what follows. The tape ends with a
+ * TOKEN_END just after the value (or at the end of the input), or a TOKEN_ERROR where we found
+ * something no JSON value can contain. Tokens are lexical only: it's up to the Java code to check
+ * they come in an order that makes sense.
+ */
+static void tokenize(const jchar* chars, size_t length, size_t pos, std::vector<jint>& tape) {
+    // Open objects and arrays. We're done when a token leaves none open.
+    int depth = 0;
+    while (pos < length) {
+        size_t start = pos;
+        jchar ch = chars[pos++];
+        switch (ch) {
+        case ' ':
+        case '\t':
+        case '\n':
+        case '\r':
+            continue;
+
+        case '/':
+            if (pos < length && chars[pos] == '*') {
+                size_t end = pos + 1;
+                for (; end + 1 < length; ++end) {
+                    if (chars[end] == '*' && chars[end + 1] == '/') {
+                        break;
+                    }
+                }
+                if (end + 1 >= length) {
+                    addToken(tape, TOKEN_ERROR, start, 0);
+                    return;
+                }
+                pos = end + 2;
+                continue;
+            } else if (pos < length && chars[pos] == '/') {
+                pos = skipToEndOfLine(chars, pos + 1, length);
+                continue;
+            }
+            addToken(tape, TOKEN_ERROR, start, 0);
+            return;
+
+        case '#':
+            pos = skipToEndOfLine(chars, pos, length);
+            continue;
+
+        case '{':
+            addToken(tape, TOKEN_BEGIN_OBJECT, start, 1);
+            ++depth;
+            break;
+        case '}':
+            addToken(tape, TOKEN_END_OBJECT, start, 1);
+            --depth;
+            break;
+        case '[':
+            addToken(tape, TOKEN_BEGIN_ARRAY, start, 1);
+            ++depth;
+            break;
+        case ']':
+            addToken(tape, TOKEN_END_ARRAY, start, 1);
+            --depth;
+            break;
+
+        case ':':
+        case '=':
+            // Accept "=>" and ":>" as JSONTokener always has.
+            if (pos < length && chars[pos] == '>') {
+                ++pos;
+            }
+            addToken(tape, TOKEN_NAME_SEPARATOR, start, pos - start);
+            break;
+
+        case ',':
+        case ';':
+            addToken(tape, TOKEN_VALUE_SEPARATOR, start, 1);
+            break;
+
+        case '"':
+        case '\'':
+            {
+                bool escaped = false;
+                while (true) {
+                    pos = findQuoteOrBackslash(chars, pos, length, ch);
+                    if (pos < length && chars[pos] == ch) {
+                        break;
+                    }
+                    // A backslash, or the end of the input: step over the escape sequence.
+                    if (pos == length || ++pos == length) {
+                        addToken(tape, TOKEN_ERROR, start, 0);
+                        return;
+                    }
+                    escaped = true;
+                    if (chars[pos] == 'u') {
+                        if (pos + 5 > length) {
+                            addToken(tape, TOKEN_ERROR, start, 0);
+                            return;
+                        }
+                        pos += 5;
+                    } else {
+                        ++pos;
+                    }
+                }
+                ++pos; // The closing quote.
+                addToken(tape, escaped ? TOKEN_ESCAPED_STRING : TOKEN_STRING, start, pos - start);
+                break;
+            }
+
+        case '\\':
+        case '\f':
+            // These would be an empty literal.
+            addToken(tape, TOKEN_ERROR, start, 0);
+            return;
+
+        default:
+            while (pos < length && !endsLiteral(chars[pos])) {
+                ++pos;
+            }
+            addToken(tape, classifyLiteral(chars + start, pos - start), start, pos - start);
+            break;
+        }
+        if (depth <= 0) {
+            addToken(tape, TOKEN_END, pos, 0);
+            return;
+        }
+    }
+    addToken(tape, TOKEN_END, length, 0);
+}
+
+static jintArray JSONTokener_tokenize(JNIEnv* env, jclass, jstring javaIn, jint pos) {
+    if (javaIn == NULL) {
+        jniThrowNullPointerException(env, NULL);
+        return NULL;
+    }
+    const jchar* chars = env->GetStringChars(javaIn, NULL);
+    if (chars == NULL) {
+        return NULL;
+    }
+    std::vector<jint> tape;
+    tokenize(chars, env->GetStringLength(javaIn), pos, tape);
+    env->ReleaseStringChars(javaIn, chars);
+
+    jintArray result = env->NewIntArray(tape.size());
+    if (result != NULL) {
+        env->SetIntArrayRegion(result, 0, tape.size(), &tape[0]);
+    }
+    return result;
+}
+
+static JNINativeMethod gMethods[] = {
+    NATIVE_METHOD(JSONTokener, tokenize, "(Ljava/lang/String;I)[I"),
+};
+void register_org_json_JSONTokener(JNIEnv* env) {
+    jniRegisterNativeMethods(env, "org/json/JSONTokener", gMethods, NELEM(gMethods));
+}
@@ -20,6 +20,7 @@ LOCAL_SRC_FILES := \
 	NetworkUtilities.cpp \
 	Register.cpp \
 	TimeZones.cpp \
+	Utf8.cpp \
 	cbigint.cpp \
 	java_io_Console.cpp \
 	java_io_File.cpp \
@@ -45,7 +46,10 @@ LOCAL_SRC_FILES := \
 	java_util_zip_CRC32.cpp \
 	java_util_zip_Deflater.cpp \
 	java_util_zip_Inflater.cpp \
+	libcore_io_DirectoryStream.cpp \
+	libcore_io_FileStatus.cpp \
 	libcore_io_IoUtils.cpp \
+	libcore_math_BulkMath.cpp \
 	org_apache_harmony_luni_platform_OSFileSystem.cpp \
 	org_apache_harmony_luni_platform_OSMemory.cpp \
 	org_apache_harmony_luni_platform_OSNetworkSystem.cpp \
@@ -53,6 +57,7 @@ LOCAL_SRC_FILES := \
 	libcore_io_OsConstants.cpp \
 	org_apache_harmony_xml_ExpatParser.cpp \
 	org_apache_harmony_xnet_provider_jsse_NativeCrypto.cpp \
+	org_json_JSONTokener.cpp \
 	valueOf.cpp
 
 LOCAL_C_INCLUDES += \
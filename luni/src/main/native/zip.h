@@ -20,10 +20,16 @@
 
 #include "JNIHelp.h"
 #include "JniException.h"
+#include "ScopedPthreadMutexLock.h"
 #include "UniquePtr.h"
 #include "jni.h"
 #include "zlib.h"
 
+#include <map>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <vector>
+
 static void throwExceptionForZlibError(JNIEnv* env, const char* exceptionClassName, int error) {
     if (error == Z_MEM_ERROR) {
         jniThrowOutOfMemoryError(env, NULL);
@@ -32,13 +38,43 @@ static void throwExceptionForZlibError(JNIEnv* env, const char* exceptionClassNa
     }
 }
 
+// The parameters a z_stream was initialized with, which a pooled stream must match to be reused.
+// A negative windowBits means a raw stream with no zlib header, which is how zlib spells nowrap.
+// Inflaters always have level and strategy 0.
+struct ZipStreamKey {
+    int level;
+    int strategy;
+    int windowBits;
+
+    ZipStreamKey(int level, int strategy, int windowBits)
+            : level(level), strategy(strategy), windowBits(windowBits) {
+    }
+
+    bool operator<(const ZipStreamKey& rhs) const {
+        if (level != rhs.level) {
+            return level < rhs.level;
+        }
+        if (strategy != rhs.strategy) {
+            return strategy < rhs.strategy;
+        }
+        return windowBits < rhs.windowBits;
+    }
+};
+
 class NativeZipStream {
 public:
     UniquePtr<jbyte[]> input;
     int inCap;
     z_stream stream;
 
-    NativeZipStream() : input(NULL), inCap(0), mDict(NULL) {
+    // Set instead of 'input' when the input is a read-only mapping of part of a file.
+    void* mappedInput;
+    size_t mappedInputLength;
+
+    ZipStreamKey key;
+
+    NativeZipStream() : input(NULL), inCap(0), mappedInput(NULL), mappedInputLength(0),
+            key(0, 0, 0), mDict(NULL) {
         // Let zlib use its default allocator.
         stream.opaque = Z_NULL;
         stream.zalloc = Z_NULL;
@@ -46,6 +82,15 @@ public:
     }
 
     ~NativeZipStream() {
+        unmapInput();
+    }
+
+    void unmapInput() {
+        if (mappedInput != NULL) {
+            munmap(mappedInput, mappedInputLength);
+            mappedInput = NULL;
+            mappedInputLength = 0;
+        }
     }
 
     void setDictionary(JNIEnv* env, jbyteArray javaDictionary, int off, int len, bool inflate) {
@@ -69,14 +114,32 @@ public:
         mDict.reset(dictionaryBytes.release());
     }
 
-    void setInput(JNIEnv* env, jbyteArray buf, jint off, jint len) {
-        input.reset(new jbyte[len]);
-        if (input.get() == NULL) {
+    // Drops the per-use state that a reset z_stream doesn't, before the stream goes back in a pool.
+    void recycle() {
+        unmapInput();
+        mDict.reset();
+        stream.next_in = NULL;
+        stream.avail_in = 0;
+        // Keep a small input buffer for the next user, but don't sit on a big one.
+        if (inCap > 64 * 1024) {
+            input.reset();
             inCap = 0;
-            jniThrowOutOfMemoryError(env, NULL);
-            return;
         }
-        inCap = len;
+    }
+
+    // Copies the input, since zlib keeps a pointer to it between calls. The buffer is reused
+    // while it's big enough, so streaming a file in fixed-size chunks allocates once.
+    void setInput(JNIEnv* env, jbyteArray buf, jint off, jint len) {
+        unmapInput();
+        if (input.get() == NULL || len > inCap) {
+            input.reset(new jbyte[len]);
+            if (input.get() == NULL) {
+                inCap = 0;
+                jniThrowOutOfMemoryError(env, NULL);
+                return;
+            }
+            inCap = len;
+        }
         if (buf != NULL) {
             env->GetByteArrayRegion(buf, off, len, &input[0]);
         }
@@ -96,4 +159,116 @@ static NativeZipStream* toNativeZipStream(jlong address) {
     return reinterpret_cast<NativeZipStream*>(static_cast<uintptr_t>(address));
 }
 
+/*
+ * Reset-ready streams, kept when an Inflater or Deflater is ended so the next one with the same
+ * parameters can skip inflateInit2/deflateInit2 and their window allocation. Callers reset each
+ * stream before handing it in. Each of Inflater and Deflater has a pool of its own.
+ */
+class ZipStreamPool {
+public:
+    typedef int (*EndFunction)(z_streamp);
+
+    ZipStreamPool(EndFunction end, size_t maxPerKey, size_t maxTotal)
+            : mEnd(end), mMaxPerKey(maxPerKey), mMaxTotal(maxTotal), mTotal(0),
+            mHits(0), mMisses(0) {
+        pthread_mutex_init(&mMutex, NULL);
+    }
+
+    // Returns a pooled stream initialized with 'key', or NULL if there isn't one.
+    NativeZipStream* take(const ZipStreamKey& key) {
+        ScopedPthreadMutexLock lock(&mMutex);
+        Streams::iterator it = mStreams.find(key);
+        if (it == mStreams.end() || it->second.empty()) {
+            ++mMisses;
+            return NULL;
+        }
+        NativeZipStream* stream = it->second.back();
+        it->second.pop_back();
+        --mTotal;
+        ++mHits;
+        return stream;
+    }
+
+    // Takes ownership of 'stream', either keeping it or freeing it if the pool is full.
+    void put(NativeZipStream* stream) {
+        {
+            ScopedPthreadMutexLock lock(&mMutex);
+            std::vector<NativeZipStream*>& streams = mStreams[stream->key];
+            if (mTotal < mMaxTotal && streams.size() < mMaxPerKey) {
+                streams.push_back(stream);
+                ++mTotal;
+                return;
+            }
+        }
+        destroy(stream);
+    }
+
+    // Changes the caps, freeing any streams over the new ones. Zero turns the pool off.
+    void setLimits(size_t maxPerKey, size_t maxTotal) {
+        std::vector<NativeZipStream*> evicted;
+        {
+            ScopedPthreadMutexLock lock(&mMutex);
+            mMaxPerKey = maxPerKey;
+            mMaxTotal = maxTotal;
+            for (Streams::iterator it = mStreams.begin(); it != mStreams.end(); ++it) {
+                std::vector<NativeZipStream*>& streams = it->second;
+                while (!streams.empty() && (streams.size() > mMaxPerKey || mTotal > mMaxTotal)) {
+                    evicted.push_back(streams.back());
+                    streams.pop_back();
+                    --mTotal;
+                }
+            }
+        }
+        for (size_t i = 0; i < evicted.size(); ++i) {
+            destroy(evicted[i]);
+        }
+    }
+
+    // Returns the hit count, miss count, and the number of streams held, in that order.
+    jlongArray getStats(JNIEnv* env) {
+        jlong stats[3];
+        {
+            ScopedPthreadMutexLock lock(&mMutex);
+            stats[0] = mHits;
+            stats[1] = mMisses;
+            stats[2] = mTotal;
+        }
+        jlongArray result = env->NewLongArray(3);
+        if (result != NULL) {
+            env->SetLongArrayRegion(result, 0, 3, stats);
+        }
+        return result;
+    }
+
+    void destroy(NativeZipStream* stream) {
+        mEnd(&stream->stream);
+        delete stream;
+    }
+
+private:
+    typedef std::map<ZipStreamKey, std::vector<NativeZipStream*> > Streams;
+
+    EndFunction mEnd;
+    pthread_mutex_t mMutex;
+    Streams mStreams;
+    size_t mMaxPerKey;
+    size_t mMaxTotal;
+    size_t mTotal;
+    jlong mHits;
+    jlong mMisses;
+
+    // Disallow copy and assignment.
+    ZipStreamPool(const ZipStreamPool&);
+    void operator=(const ZipStreamPool&);
+};
+
+static void setZipStreamPoolLimits(JNIEnv* env, ZipStreamPool& pool, jint maxPerKey,
+        jint maxTotal) {
+    if (maxPerKey < 0 || maxTotal < 0) {
+        jniThrowException(env, "java/lang/IllegalArgumentException", "negative limit");
+        return;
+    }
+    pool.setLimits(maxPerKey, maxTotal);
+}
+
 #endif /* zip_h */
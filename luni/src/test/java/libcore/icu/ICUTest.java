@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.icu;
+
+public class ICUTest extends junit.framework.TestCase {
+    public void test_getCharacterTypesMatchesCharacter() throws Exception {
+        char[] chars = new char[0x10000];
+        for (int i = 0; i < chars.length; ++i) {
+            chars[i] = (char) i;
+        }
+        byte[] types = new byte[chars.length];
+        // Every BMP char on its own, including unpaired surrogates.
+        for (int i = 0; i < chars.length; ++i) {
+            ICU.getCharacterTypes(chars, i, 1, types);
+            assertEquals(Integer.toHexString(i), Character.getType(chars[i]), types[0]);
+        }
+        // A range that ends in the middle of a pair.
+        ICU.getCharacterTypes(chars, 0xd000, 0xd800 - 0xd000 + 1, types);
+        for (int i = 0xd000; i <= 0xd800; ++i) {
+            assertEquals(Integer.toHexString(i), Character.getType(chars[i]), types[i - 0xd000]);
+        }
+    }
+
+    public void test_getCharacterTypesSurrogatePairs() throws Exception {
+        // U+1D400 MATHEMATICAL BOLD CAPITAL A, then a lone trail surrogate, then 'a'.
+        String s = "x\ud835\udc00\udc00a";
+        byte[] types = new byte[s.length()];
+        ICU.getCharacterTypes(s, 0, s.length(), types);
+        assertEquals(Character.LOWERCASE_LETTER, types[0]);
+        assertEquals(Character.UPPERCASE_LETTER, types[1]);
+        assertEquals(Character.UPPERCASE_LETTER, types[2]);
+        assertEquals(Character.SURROGATE, types[3]);
+        assertEquals(Character.LOWERCASE_LETTER, types[4]);
+
+        // Starting inside the pair leaves its trail surrogate unpaired.
+        ICU.getCharacterTypes(s.toCharArray(), 2, 3, types);
+        assertEquals(Character.SURROGATE, types[0]);
+        assertEquals(Character.SURROGATE, types[1]);
+        assertEquals(Character.LOWERCASE_LETTER, types[2]);
+    }
+
+    public void test_getCharacterTypesBounds() throws Exception {
+        byte[] types = new byte[4];
+        try {
+            ICU.getCharacterTypes("abc", 1, 3, types);
+            fail();
+        } catch (IndexOutOfBoundsException expected) {
+        }
+        try {
+            ICU.getCharacterTypes("abcdef", 0, 5, types);
+            fail();
+        } catch (IndexOutOfBoundsException expected) {
+        }
+        try {
+            ICU.getCharacterTypes(new char[2], -1, 1, types);
+            fail();
+        } catch (IndexOutOfBoundsException expected) {
+        }
+        ICU.getCharacterTypes("abc", 3, 0, types);
+    }
+}
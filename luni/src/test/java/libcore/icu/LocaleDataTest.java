@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.icu;
+
+import java.text.DateFormat;
+import java.util.Locale;
+
+public class LocaleDataTest extends junit.framework.TestCase {
+    public void test_sectionsLoadIndependently() throws Exception {
+        // Each part is loaded on demand, so ask for them in an unusual order.
+        LocaleData de = LocaleData.get(new Locale("de", "DE"));
+        assertEquals(',', de.getDecimalSeparator());
+        assertEquals("Januar", de.getLongMonthNames()[0]);
+        assertEquals("EUR", de.getInternationalCurrencySymbol());
+        assertEquals(Integer.valueOf(2), de.getFirstDayOfWeek());
+        assertEquals(',', de.getDecimalSeparator());
+    }
+
+    public void test_variantFallsBackToParent() throws Exception {
+        LocaleData parent = LocaleData.get(Locale.US);
+        LocaleData variant = LocaleData.get(new Locale("en", "US", "POSIX"));
+        assertEquals(parent.getDateFormat(DateFormat.SHORT),
+                variant.getDateFormat(DateFormat.SHORT));
+        assertEquals(parent.getShortWeekdayNames()[1], variant.getShortWeekdayNames()[1]);
+        assertEquals(parent.getCurrencyPattern(), variant.getCurrencyPattern());
+    }
+
+    public void test_concurrentFirstUse() throws Exception {
+        final Locale locale = new Locale("fr", "CA");
+        Thread[] threads = new Thread[8];
+        final String[] results = new String[threads.length];
+        for (int i = 0; i < threads.length; i++) {
+            final int index = i;
+            threads[i] = new Thread() {
+                @Override public void run() {
+                    results[index] = LocaleData.get(locale).getLongMonthNames()[0];
+                }
+            };
+        }
+        for (Thread thread : threads) {
+            thread.start();
+        }
+        for (Thread thread : threads) {
+            thread.join();
+        }
+        for (String result : results) {
+            assertEquals("janvier", result);
+        }
+    }
+}
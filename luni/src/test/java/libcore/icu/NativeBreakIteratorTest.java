@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.icu;
+
+import java.util.ArrayList;
+import java.util.List;
+import java.util.Locale;
+
+public class NativeBreakIteratorTest extends junit.framework.TestCase {
+    public void test_getBoundariesMatchesNext() throws Exception {
+        String text = "The quick (\"brown\") fox can't jump 32.3 feet, right? Yes.";
+        NativeBreakIterator it = NativeBreakIterator.getWordInstance(Locale.US);
+        it.setText(text);
+        List<Integer> expected = new ArrayList<Integer>();
+        for (int offset = it.first(); offset != -1; offset = it.next()) {
+            expected.add(offset);
+        }
+        it.first();
+        it.next();
+        int[] boundaries = it.getBoundaries();
+        assertEquals(2 * expected.size(), boundaries.length);
+        for (int i = 0; i < expected.size(); i++) {
+            assertEquals((int) expected.get(i), boundaries[2 * i]);
+        }
+        // The position wasn't disturbed.
+        assertEquals(3, it.current());
+    }
+
+    public void test_getBoundariesEmptyText() throws Exception {
+        NativeBreakIterator it = NativeBreakIterator.getSentenceInstance(Locale.US);
+        it.setText("");
+        int[] boundaries = it.getBoundaries();
+        assertEquals(2, boundaries.length);
+        assertEquals(0, boundaries[0]);
+    }
+
+    public void test_instancesAreIndependent() throws Exception {
+        // Instances are cloned from a shared template, so make sure they don't share any text.
+        NativeBreakIterator a = NativeBreakIterator.getWordInstance(Locale.US);
+        NativeBreakIterator b = NativeBreakIterator.getWordInstance(Locale.US);
+        a.setText("one two");
+        b.setText("three");
+        assertEquals(3, a.following(0));
+        assertEquals(5, b.following(0));
+    }
+}
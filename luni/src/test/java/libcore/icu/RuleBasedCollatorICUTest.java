@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2009 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.icu;
+
+import java.text.CollationKey;
+import java.util.Arrays;
+import java.util.Locale;
+
+public class RuleBasedCollatorICUTest extends junit.framework.TestCase {
+    private static final String[] WORDS = {
+        "peach", "Péché", "péché", "", "apple", "peach", "Apple", "pêche",
+    };
+
+    public void testGetCollationKeys() throws Exception {
+        RuleBasedCollatorICU collator = new RuleBasedCollatorICU(Locale.US);
+        String[] sources = Arrays.copyOf(WORDS, WORDS.length + 1); // Ends with a null.
+        CollationKey[] keys = collator.getCollationKeys(sources);
+        assertEquals(sources.length, keys.length);
+        for (int i = 0; i < WORDS.length; ++i) {
+            CollationKey expected = collator.getCollationKey(WORDS[i]);
+            assertEquals(WORDS[i], keys[i].getSourceString());
+            assertTrue(WORDS[i], Arrays.equals(expected.toByteArray(), keys[i].toByteArray()));
+        }
+        assertNull(keys[WORDS.length]);
+    }
+
+    public void testSort() throws Exception {
+        RuleBasedCollatorICU collator = new RuleBasedCollatorICU(Locale.US);
+        int[] indices = collator.sort(WORDS);
+        assertEquals(WORDS.length, indices.length);
+        for (int i = 1; i < indices.length; ++i) {
+            int order = collator.compare(WORDS[indices[i - 1]], WORDS[indices[i]]);
+            assertTrue(order < 0 || (order == 0 && indices[i - 1] < indices[i]));
+        }
+        assertEquals(0, collator.sort(new String[0]).length);
+    }
+
+    public void testSortNull() throws Exception {
+        try {
+            new RuleBasedCollatorICU(Locale.US).sort(new String[] { "a", null });
+            fail();
+        } catch (NullPointerException expected) {
+        }
+    }
+}
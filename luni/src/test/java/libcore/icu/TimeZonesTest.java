@@ -16,6 +16,9 @@
 
 package libcore.icu;
 
+import java.util.Locale;
+import java.util.TimeZone;
+
 public class TimeZonesTest extends junit.framework.TestCase {
     public void test_getZoneStrings() throws Exception {
         // Check that corrupting our array doesn't affect other callers.
@@ -27,4 +30,17 @@ public class TimeZonesTest extends junit.framework.TestCase {
         TimeZones.getZoneStrings(null)[0][0] = null;
         assertNotNull(TimeZones.getZoneStrings(null)[0][0]);
     }
+
+    public void test_getDisplayNameMatchesZoneStrings() throws Exception {
+        // Ask for one zone's name before the table exists, then check it against the table.
+        Locale locale = Locale.FRANCE;
+        String longDst = TimeZones.getDisplayName("America/Los_Angeles", true, TimeZone.LONG,
+                locale);
+        String[][] zoneStrings = TimeZones.getZoneStrings(locale);
+        assertEquals(TimeZones.lookupDisplayName(zoneStrings, "America/Los_Angeles", true,
+                TimeZone.LONG), longDst);
+        for (String[] row : zoneStrings) {
+            assertEquals(row[2], TimeZones.getDisplayName(row[0], false, TimeZone.SHORT, locale));
+        }
+    }
 }
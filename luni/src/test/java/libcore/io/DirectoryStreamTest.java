@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.io;
+
+import java.io.File;
+import java.io.IOException;
+import java.util.HashMap;
+import java.util.Map;
+import java.util.UUID;
+import junit.framework.TestCase;
+
+public class DirectoryStreamTest extends TestCase {
+    public void testRead() throws Exception {
+        File dir = new File(System.getProperty("java.io.tmpdir"), UUID.randomUUID().toString());
+        assertTrue(dir.mkdir());
+        for (int i = 0; i < 10; ++i) {
+            assertTrue(new File(dir, "file" + i).createNewFile());
+        }
+        assertTrue(new File(dir, "subdir").mkdir());
+
+        // Read in small batches to check that we pick up where we left off.
+        Map<String, Integer> types = new HashMap<String, Integer>();
+        DirectoryStream stream = new DirectoryStream(dir.getPath());
+        try {
+            String[] names = new String[3];
+            int[] batchTypes = new int[3];
+            long[] inodes = new long[3];
+            int count;
+            while ((count = stream.read(names, batchTypes, inodes)) > 0) {
+                for (int i = 0; i < count; ++i) {
+                    assertNull(types.put(names[i], batchTypes[i]));
+                    assertTrue(inodes[i] != 0);
+                }
+            }
+            assertEquals(0, stream.read(names, batchTypes, null));
+        } finally {
+            stream.close();
+        }
+
+        assertEquals(11, types.size());
+        assertFalse(types.containsKey("."));
+        assertFalse(types.containsKey(".."));
+        for (Map.Entry<String, Integer> entry : types.entrySet()) {
+            int type = entry.getValue();
+            boolean isDir = entry.getKey().equals("subdir");
+            // DT_UNKNOWN is always allowed.
+            if (type != DirectoryStream.DT_UNKNOWN) {
+                assertEquals(isDir ? DirectoryStream.DT_DIR : DirectoryStream.DT_REG, type);
+            }
+            assertTrue(new File(dir, entry.getKey()).delete());
+        }
+        assertTrue(dir.delete());
+    }
+
+    public void testMissingDirectory() throws Exception {
+        try {
+            new DirectoryStream("/does/not/exist");
+            fail();
+        } catch (IOException expected) {
+        }
+    }
+
+    public void testClosed() throws Exception {
+        DirectoryStream stream = new DirectoryStream(System.getProperty("java.io.tmpdir"));
+        stream.close();
+        stream.close();
+        try {
+            stream.read(new String[1], new int[1], null);
+            fail();
+        } catch (IOException expected) {
+        }
+    }
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.io;
+
+import java.io.File;
+import java.io.FileOutputStream;
+import junit.framework.TestCase;
+
+public class FileStatusTest extends TestCase {
+    public void testStat() throws Exception {
+        File file = File.createTempFile("FileStatusTest", null);
+        file.deleteOnExit();
+        FileOutputStream out = new FileOutputStream(file);
+        out.write(new byte[1234]);
+        out.close();
+
+        long[] fields = new long[FileStatus.FIELD_COUNT];
+        assertTrue(FileStatus.stat(file.getPath(), true, fields));
+        assertTrue(OsConstants.S_ISREG((int) fields[FileStatus.ST_MODE]));
+        assertEquals(1234, fields[FileStatus.ST_SIZE]);
+        assertEquals(file.lastModified(), fields[FileStatus.ST_MTIME]);
+        assertTrue(fields[FileStatus.ST_INO] != 0);
+
+        assertFalse(FileStatus.stat("/does/not/exist", true, fields));
+        assertEquals(0, fields[FileStatus.ST_MODE]);
+    }
+
+    public void testStatBatch() throws Exception {
+        File dir = new File(System.getProperty("java.io.tmpdir"));
+        String[] paths = new String[] { dir.getPath(), "/does/not/exist", dir.getPath() };
+        long[] fields = new long[paths.length * FileStatus.FIELD_COUNT];
+        assertEquals(2, FileStatus.stat(paths, false, fields));
+        assertTrue(OsConstants.S_ISDIR((int) fields[FileStatus.ST_MODE]));
+        assertEquals(0, fields[FileStatus.FIELD_COUNT + FileStatus.ST_MODE]);
+        assertEquals(fields[FileStatus.ST_INO],
+                fields[2 * FileStatus.FIELD_COUNT + FileStatus.ST_INO]);
+
+        try {
+            FileStatus.stat(paths, false, new long[FileStatus.FIELD_COUNT]);
+            fail();
+        } catch (IllegalArgumentException expected) {
+        }
+    }
+}
@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.io;
+
+import java.io.FileDescriptor;
+import java.io.FileInputStream;
+import java.io.IOException;
+import org.apache.harmony.luni.platform.OSNetworkSystem;
+
+public class SupervisedProcessesTest extends junit.framework.TestCase {
+    private static final int READABLE = 1;
+    private static final int SIGKILL = 9;
+    private static final int SIGCHLD = 17;
+
+    private static ProcessBuilder shell(String script) {
+        String sh = "Dalvik".equals(System.getProperty("java.vm.name")) ? "/system/bin/sh" : "/bin/sh";
+        return new ProcessBuilder(sh, "-c", script);
+    }
+
+    public void testPidFdWithEpoll() throws Exception {
+        Process process = SupervisedProcesses.start(shell("read x; exit 3"));
+        int pid = SupervisedProcesses.getPid(process);
+        FileDescriptor pidFd;
+        try {
+            pidFd = SupervisedProcesses.openPidFd(process);
+        } catch (IOException e) {
+            // No pidfds on this kernel; testReap covers the rest. Reap the shell
+            // so it doesn't outlive the test as a zombie. Only reap sets its exit
+            // value, so waitFor can't be called until reap has seen it.
+            process.destroy();
+            assertEquals(SIGKILL, reapUntil(pid));
+            assertEquals(SIGKILL, process.waitFor());
+            return;
+        }
+        OSNetworkSystem network = OSNetworkSystem.getOSNetworkSystem();
+        FileDescriptor epollFd = new FileDescriptor();
+        network.epollCreate(epollFd);
+        try {
+            int[] tokens = new int[1];
+            int[] ops = new int[1];
+            network.epollRegister(epollFd, pidFd, READABLE, pid);
+            assertEquals(0, network.epollWait(epollFd, tokens, ops, 0));
+
+            process.getOutputStream().close();
+            assertEquals(1, network.epollWait(epollFd, tokens, ops, 10000));
+            assertEquals(pid, tokens[0]);
+
+            int[] pids = new int[4];
+            int[] statuses = new int[4];
+            assertEquals(1, SupervisedProcesses.reap(pids, statuses));
+            assertEquals(pid, pids[0]);
+            assertEquals(3, statuses[0]);
+            assertEquals(3, process.waitFor());
+        } finally {
+            network.close(epollFd);
+            IoUtils.close(pidFd);
+        }
+
+        // Once reaped, the pid may be reused, so no more pidfds.
+        try {
+            SupervisedProcesses.openPidFd(process);
+            fail();
+        } catch (IllegalArgumentException expected) {
+        }
+    }
+
+    public void testSigChldFd() throws Exception {
+        FileDescriptor sigChldFd;
+        try {
+            sigChldFd = SupervisedProcesses.openSigChldFd();
+        } catch (IOException e) {
+            return; // No signalfd on this platform.
+        }
+        OSNetworkSystem network = OSNetworkSystem.getOSNetworkSystem();
+        FileDescriptor epollFd = new FileDescriptor();
+        network.epollCreate(epollFd);
+        try {
+            Process process = SupervisedProcesses.start(shell("exit 4"));
+            int pid = SupervisedProcesses.getPid(process);
+            int[] tokens = new int[1];
+            int[] ops = new int[1];
+            network.epollRegister(epollFd, sigChldFd, READABLE, 1);
+            // Only this thread blocks SIGCHLD, so the kernel may deliver it to another thread
+            // instead. If it's queued for the fd, it must be a SIGCHLD.
+            if (network.epollWait(epollFd, tokens, ops, 10000) == 1) {
+                assertEquals(1, tokens[0]);
+                byte[] siginfo = new byte[128];
+                assertEquals(siginfo.length, new FileInputStream(sigChldFd).read(siginfo));
+                int signo = (siginfo[0] & 0xff) | (siginfo[1] & 0xff) << 8
+                        | (siginfo[2] & 0xff) << 16 | (siginfo[3] & 0xff) << 24;
+                assertEquals(SIGCHLD, signo);
+            }
+            assertEquals(4, reapUntil(pid));
+            assertEquals(4, process.waitFor());
+        } finally {
+            network.close(epollFd);
+            IoUtils.close(sigChldFd);
+        }
+    }
+
+    /** Calls reap until it reports pid, and returns pid's exit value. */
+    private static int reapUntil(int pid) throws InterruptedException {
+        int[] pids = new int[4];
+        int[] statuses = new int[4];
+        for (int attempt = 0; attempt < 1000; ++attempt) {
+            int count = SupervisedProcesses.reap(pids, statuses);
+            for (int i = 0; i < count; ++i) {
+                if (pids[i] == pid) {
+                    return statuses[i];
+                }
+            }
+            Thread.sleep(10);
+        }
+        fail("pid " + pid + " wasn't reaped");
+        return -1;
+    }
+
+    public void testReap() throws Exception {
+        Process[] processes = new Process[3];
+        for (int i = 0; i < processes.length; ++i) {
+            processes[i] = SupervisedProcesses.start(shell("exit " + (10 + i)));
+        }
+        int[] pids = new int[processes.length];
+        int[] statuses = new int[processes.length];
+        int reaped = 0;
+        for (int attempt = 0; reaped < processes.length && attempt < 1000; ++attempt) {
+            int[] somePids = new int[processes.length];
+            int[] someStatuses = new int[processes.length];
+            int count = SupervisedProcesses.reap(somePids, someStatuses);
+            System.arraycopy(somePids, 0, pids, reaped, count);
+            System.arraycopy(someStatuses, 0, statuses, reaped, count);
+            reaped += count;
+            Thread.sleep(10);
+        }
+        assertEquals(processes.length, reaped);
+        for (int i = 0; i < processes.length; ++i) {
+            int pid = SupervisedProcesses.getPid(processes[i]);
+            int found = -1;
+            for (int j = 0; j < reaped; ++j) {
+                if (pids[j] == pid) {
+                    found = j;
+                }
+            }
+            assertTrue(found != -1);
+            assertEquals(10 + i, statuses[found]);
+            assertEquals(10 + i, processes[i].exitValue());
+        }
+    }
+
+    public void testRunningProcessIsNotReaped() throws Exception {
+        Process process = SupervisedProcesses.start(shell("read x"));
+        int[] pids = new int[1];
+        int[] statuses = new int[1];
+        assertEquals(0, SupervisedProcesses.reap(pids, statuses));
+        try {
+            process.exitValue();
+            fail();
+        } catch (IllegalThreadStateException expected) {
+        }
+        process.getOutputStream().close();
+        while (SupervisedProcesses.reap(pids, statuses) == 0) {
+            Thread.sleep(10);
+        }
+        assertEquals(SupervisedProcesses.getPid(process), pids[0]);
+        assertEquals(0, process.waitFor());
+    }
+}
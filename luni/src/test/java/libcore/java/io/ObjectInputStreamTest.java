@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.java.io;
+
+import java.io.ByteArrayInputStream;
+import java.io.ByteArrayOutputStream;
+import java.io.ObjectInputStream;
+import java.io.ObjectOutputStream;
+import java.io.Serializable;
+import java.util.ArrayList;
+import java.util.List;
+import junit.framework.TestCase;
+
+public final class ObjectInputStreamTest extends TestCase {
+    static class Base implements Serializable {
+        private static final long serialVersionUID = 1L;
+        private int baseInt;
+        private String baseName;
+    }
+
+    static class AllPrimitives extends Base {
+        private static final long serialVersionUID = 1L;
+        private boolean z;
+        private byte b;
+        private char c;
+        private short s;
+        private int i;
+        private long j;
+        private float f;
+        private double d;
+        private String name;
+    }
+
+    private static AllPrimitives make(int n) {
+        AllPrimitives result = new AllPrimitives();
+        result.baseInt = -n;
+        result.baseName = "base" + n;
+        result.z = (n % 2) == 0;
+        result.b = (byte) (n * 7);
+        result.c = (char) (0xfedc + n);
+        result.s = (short) (-n * 3);
+        result.i = 0x12345678 * n;
+        result.j = 0x123456789abcdefL * n;
+        result.f = n * -1.5f;
+        result.d = Math.PI * n;
+        result.name = "n" + n;
+        return result;
+    }
+
+    // Primitive fields are set in bulk with field IDs cached per class descriptor, so read
+    // enough instances that the cache is used, and check every value.
+    public void testPrimitiveFieldsRoundTrip() throws Exception {
+        List<AllPrimitives> original = new ArrayList<AllPrimitives>();
+        for (int n = 0; n < 100; ++n) {
+            original.add(make(n));
+        }
+        original.get(1).f = Float.NaN;
+        original.get(2).d = Double.NEGATIVE_INFINITY;
+        original.get(3).j = Long.MIN_VALUE;
+        original.get(4).c = Character.MAX_VALUE;
+
+        ByteArrayOutputStream bytes = new ByteArrayOutputStream();
+        ObjectOutputStream out = new ObjectOutputStream(bytes);
+        out.writeObject(original);
+        out.close();
+        ObjectInputStream in = new ObjectInputStream(new ByteArrayInputStream(bytes.toByteArray()));
+        @SuppressWarnings("unchecked")
+        List<AllPrimitives> copy = (List<AllPrimitives>) in.readObject();
+
+        assertEquals(original.size(), copy.size());
+        for (int n = 0; n < original.size(); ++n) {
+            AllPrimitives expected = original.get(n);
+            AllPrimitives actual = copy.get(n);
+            assertEquals(expected.baseInt, actual.baseInt);
+            assertEquals(expected.baseName, actual.baseName);
+            assertEquals(expected.z, actual.z);
+            assertEquals(expected.b, actual.b);
+            assertEquals(expected.c, actual.c);
+            assertEquals(expected.s, actual.s);
+            assertEquals(expected.i, actual.i);
+            assertEquals(expected.j, actual.j);
+            assertEquals(Float.floatToIntBits(expected.f), Float.floatToIntBits(actual.f));
+            assertEquals(Double.doubleToLongBits(expected.d), Double.doubleToLongBits(actual.d));
+            assertEquals(expected.name, actual.name);
+        }
+    }
+}
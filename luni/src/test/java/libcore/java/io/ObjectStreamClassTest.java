@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.java.io;
+
+import java.io.ObjectStreamClass;
+import java.io.Serializable;
+import junit.framework.TestCase;
+
+public final class ObjectStreamClassTest extends TestCase {
+    // No serialVersionUID, and overloads so the SUID computation has to sort by signature.
+    static class NoExplicitUid implements Serializable {
+        static int counter = 1;
+        int a;
+        protected String b;
+        public NoExplicitUid() { }
+        NoExplicitUid(int a) { this.a = a; }
+        protected NoExplicitUid(String b, int a) { this.a = a; this.b = b; }
+        public void m() { }
+        public void m(int x) { }
+        public int m(String s) { return 0; }
+        void n(long l) { }
+        private void p() { }
+    }
+
+    // Descriptors are cached per thread; every thread must compute the same SUID.
+    public void testComputedSerialVersionUidIsConsistentAcrossThreads() throws Exception {
+        final long[] uids = new long[4];
+        Thread[] threads = new Thread[uids.length];
+        for (int i = 0; i < threads.length; ++i) {
+            final int index = i;
+            threads[i] = new Thread() {
+                @Override public void run() {
+                    uids[index] = ObjectStreamClass.lookup(NoExplicitUid.class)
+                            .getSerialVersionUID();
+                }
+            };
+            threads[i].start();
+        }
+        for (Thread thread : threads) {
+            thread.join();
+        }
+        long expected = ObjectStreamClass.lookup(NoExplicitUid.class).getSerialVersionUID();
+        for (long uid : uids) {
+            assertEquals(expected, uid);
+        }
+    }
+}
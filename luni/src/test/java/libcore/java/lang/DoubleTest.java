@@ -16,6 +16,7 @@
 
 package libcore.java.lang;
 
+import java.util.Random;
 import junit.framework.TestCase;
 
 public class DoubleTest extends TestCase {
@@ -24,4 +25,58 @@ public class DoubleTest extends TestCase {
         assertEquals("0.008", Double.toString(0.008));
         assertEquals("0.008366", Double.toString(0.008366));
     }
+
+    // Values too large or small for longDigitGenerator take the table-driven native path.
+    public void testToStringLargeAndSmall() throws Exception {
+        assertEquals("1.234123412431233E107", Double.toString(1.234123412431233E107));
+        assertEquals("1.2341234124312331E107", Double.toString(1.2341234124312331E107));
+        assertEquals("1.0E23", Double.toString(1.0E23));
+        assertEquals("2.0769187434139308E34", Double.toString(2.0769187434139308E34));
+        assertEquals("1.1805916207174113E21", Double.toString(0x1p70));
+        assertEquals("1.7976931348623157E308", Double.toString(Double.MAX_VALUE));
+        assertEquals("2.2250738585072014E-308", Double.toString(Double.MIN_NORMAL));
+        assertEquals("-1.0E-300", Double.toString(-1e-300));
+        assertEquals("3.4028235E38", Float.toString(Float.MAX_VALUE));
+        assertEquals("1.4E-45", Float.toString(Float.MIN_VALUE));
+    }
+
+    // Most inputs are parsed with 64-bit arithmetic; the rest fall back to bignums.
+    public void testParseDouble() throws Exception {
+        assertEquals(3.14159, Double.parseDouble("3.14159"));
+        assertEquals(0x1.0000000000001p0, Double.parseDouble("1.0000000000000002220446049250313"));
+        // Exactly halfway between two doubles, so ties-to-even needs every digit.
+        assertEquals(9007199254740992.0, Double.parseDouble("9007199254740993"));
+        assertEquals(9007199254740996.0, Double.parseDouble("9007199254740995"));
+        assertEquals(Double.MAX_VALUE, Double.parseDouble("1.7976931348623157e308"));
+        assertEquals(Double.MIN_NORMAL, Double.parseDouble("2.2250738585072014E-308"));
+        assertEquals(Double.MIN_VALUE, Double.parseDouble("4.9e-324"));
+        assertEquals(Double.POSITIVE_INFINITY, Double.parseDouble("1e309"));
+        assertEquals(0.0, Double.parseDouble("1e-400"));
+        assertEquals(-0.0, Double.parseDouble("-0e10"));
+        assertEquals(123456789012345680000.0, Double.parseDouble("123456789012345678901"));
+
+        Random random = new Random(0);
+        for (int i = 0; i < 10000; ++i) {
+            double d = Double.longBitsToDouble(random.nextLong());
+            if (!Double.isNaN(d)) {
+                assertEquals(d, Double.parseDouble(Double.toString(d)));
+            }
+        }
+    }
+
+    // Pairs that straddle the point halfway between two doubles, with enough digits
+    // and a big enough exponent that the bignum path multiplies by 10^19. cbigint has a 64-bit
+    // limb version of that multiply (for compilers with __int128) and a half-word version (for
+    // the rest, including 32-bit devices; -DCBIGINT_NO_UINT128 selects it on 64-bit hosts).
+    // Both must give these results.
+    public void testParseDoubleManyDigitsLargeExponent() throws Exception {
+        assertEquals(0x56cbd6ac21636369L, Double.doubleToRawLongBits(
+                Double.parseDouble("1.3076010600306360168216314770150e110")));
+        assertEquals(0x56cbd6ac2163636aL, Double.doubleToRawLongBits(
+                Double.parseDouble("1.3076010600306360168216314770151e110")));
+        assertEquals(0x65ef03f3d6645fa9L, Double.doubleToRawLongBits(
+                Double.parseDouble("1.029592389809430586104273e183")));
+        assertEquals(0x65ef03f3d6645faaL, Double.doubleToRawLongBits(
+                Double.parseDouble("1.029592389809430586104274e183")));
+    }
 }
@@ -27,4 +27,14 @@ public class FloatTest extends junit.framework.TestCase {
         // http://code.google.com/p/android/issues/detail?id=3156
         assertEquals(-2.14748365E9f, Float.valueOf(String.valueOf(Integer.MIN_VALUE)));
     }
+
+    public void testParseFloat() throws Exception {
+        assertEquals(3.14159f, Float.parseFloat("3.14159"));
+        // Exactly halfway between two floats.
+        assertEquals(16777216f, Float.parseFloat("16777217"));
+        assertEquals(Float.MAX_VALUE, Float.parseFloat("3.4028235e38"));
+        assertEquals(Float.MIN_VALUE, Float.parseFloat("1.4e-45"));
+        assertEquals(Float.POSITIVE_INFINITY, Float.parseFloat("3.5e38"));
+        assertEquals(1.0e-10f, Float.parseFloat("0.0000000001"));
+    }
 }
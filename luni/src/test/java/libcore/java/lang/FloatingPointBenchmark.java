@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.java.lang;
+
+/**
+ * Measures the slow paths of Double.parseDouble and Float.parseFloat, which
+ * use cbigint's multi-word arithmetic: more significant digits than fit in a
+ * long, values exactly halfway between two doubles, and subnormals. Also
+ * measures Double.toString on values too large or small for RealToString's
+ * long arithmetic. Each case is checked against its expected result before
+ * it's timed. Not run as part of
+ * the tests; run it with
+ *
+ * <pre>dalvikvm -cp core-tests.jar libcore.java.lang.FloatingPointBenchmark [millis]</pre>
+ *
+ * where {@code millis} is how long to spend on each case, one second by
+ * default.
+ */
+public final class FloatingPointBenchmark {
+
+    public static void main(String[] args) throws Exception {
+        long millis = (args.length > 0) ? Long.parseLong(args[0]) : 1000;
+
+        Case[] cases = {
+                new ParseDouble("long-mantissa", "3.14159265358979323846264338327950288", Math.PI),
+                new ParseDouble("halfway", "9007199254740993", 9007199254740992.0),
+                new ParseDouble("just-over-half", "2.47032822920623272088e-324",
+                        Double.MIN_VALUE),
+                new ParseDouble("subnormal", "4.9406564584124654e-324", Double.MIN_VALUE),
+                new ParseDouble("huge", "1.7976931348623157e308", Double.MAX_VALUE),
+                new ParseDouble("tiny", "2.2250738585072011e-308", 0x0.fffffffffffffp-1022),
+                new ParseFloat("float-long", "1.00000017881393432617187499", 0x1.000002p0f),
+                new ParseFloat("float-subnormal", "1.4012984643e-45", Float.MIN_VALUE),
+                new DoubleToString("print-huge", 1.7976931348623157e308),
+                new DoubleToString("print-tiny", 2.2250738585072014e-308),
+                new DoubleToString("print-subnormal", 4.9406564584124654e-322),
+                new DoubleToString("print-2^70", 0x1p70),
+        };
+
+        System.out.printf("%-16s %12s %12s%n", "case", "ns/op", "ops/s");
+        for (Case c : cases) {
+            c.check();
+            double nanosPerOp = run(c, millis);
+            System.out.printf("%-16s %12.1f %12.0f%n", c.name, nanosPerOp, 1e9 / nanosPerOp);
+        }
+    }
+
+    private static double run(Case c, long millis) {
+        // Warm up.
+        for (int i = 0; i < 10000; i++) {
+            c.run(100);
+        }
+        long ops = 0;
+        long start = System.nanoTime();
+        long end = start + millis * 1000000L;
+        long now;
+        do {
+            c.run(1000);
+            ops += 1000;
+            now = System.nanoTime();
+        } while (now < end);
+        return (now - start) / (double) ops;
+    }
+
+    private abstract static class Case {
+        final String name;
+        // Written by run so the work can't be optimized away.
+        volatile long sink;
+
+        Case(String name) {
+            this.name = name;
+        }
+
+        /** Throws if the operation doesn't give the result it should. */
+        abstract void check();
+
+        abstract void run(int count);
+    }
+
+    private static class ParseDouble extends Case {
+        private final String input;
+        private final double expected;
+
+        ParseDouble(String name, String input, double expected) {
+            super(name);
+            this.input = input;
+            this.expected = expected;
+        }
+
+        @Override void check() {
+            if (Double.parseDouble(input) != expected) {
+                throw new AssertionError(name + ": " + Double.parseDouble(input) + " != "
+                        + expected);
+            }
+        }
+
+        @Override void run(int count) {
+            long bits = 0;
+            for (int i = 0; i < count; i++) {
+                bits += Double.doubleToRawLongBits(Double.parseDouble(input));
+            }
+            sink = bits;
+        }
+    }
+
+    private static class ParseFloat extends Case {
+        private final String input;
+        private final float expected;
+
+        ParseFloat(String name, String input, float expected) {
+            super(name);
+            this.input = input;
+            this.expected = expected;
+        }
+
+        @Override void check() {
+            if (Float.parseFloat(input) != expected) {
+                throw new AssertionError(name + ": " + Float.parseFloat(input) + " != "
+                        + expected);
+            }
+        }
+
+        @Override void run(int count) {
+            long bits = 0;
+            for (int i = 0; i < count; i++) {
+                bits += Float.floatToRawIntBits(Float.parseFloat(input));
+            }
+            sink = bits;
+        }
+    }
+
+    private static class DoubleToString extends Case {
+        private final double value;
+
+        DoubleToString(String name, double value) {
+            super(name);
+            this.value = value;
+        }
+
+        @Override void check() {
+            if (Double.parseDouble(Double.toString(value)) != value) {
+                throw new AssertionError(name + ": " + Double.toString(value));
+            }
+        }
+
+        @Override void run(int count) {
+            long length = 0;
+            for (int i = 0; i < count; i++) {
+                length += Double.toString(value).length();
+            }
+            sink = length;
+        }
+    }
+}
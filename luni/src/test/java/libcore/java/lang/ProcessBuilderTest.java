@@ -16,8 +16,16 @@
 
 package libcore.java.lang;
 
+import java.io.File;
+import java.io.FileInputStream;
+import java.io.FileWriter;
+import java.io.IOException;
+import java.util.ArrayList;
 import java.util.HashMap;
+import java.util.List;
 import java.util.Map;
+import java.util.Scanner;
+import libcore.io.IoUtils;
 import static tests.support.Support_Exec.execAndCheckOutput;
 
 public class ProcessBuilderTest extends junit.framework.TestCase {
@@ -62,4 +70,110 @@ public class ProcessBuilderTest extends junit.framework.TestCase {
         }
         assertEquals(before, environment);
     }
+
+    public void testCommandIsFoundOnDefaultPath() throws Exception {
+        // The child's environment has no PATH, so the search uses the default path.
+        ProcessBuilder pb = new ProcessBuilder("sh", "-c", "echo $A");
+        pb.environment().clear();
+        pb.environment().put("A", "android");
+        execAndCheckOutput(pb, "android\n", "");
+    }
+
+    public void testCommandIsFoundOnChildPath() throws Exception {
+        File dir = createTempDir();
+        try {
+            File script = createScript(dir, "libcore-path-test", "#!" + shell() + "\necho found\n");
+            ProcessBuilder pb = new ProcessBuilder(script.getName());
+            pb.environment().put("PATH", dir.getPath());
+            execAndCheckOutput(pb, "found\n", "");
+        } finally {
+            deleteTempDir(dir);
+        }
+    }
+
+    public void testScriptWithoutInterpreterIsRunByShell() throws Exception {
+        File dir = createTempDir();
+        try {
+            // execve fails with ENOEXEC, so the child falls back to the shell.
+            File script = createScript(dir, "libcore-noexec-test", "echo fallback\n");
+            ProcessBuilder pb = new ProcessBuilder(script.getPath());
+            execAndCheckOutput(pb, "fallback\n", "");
+        } finally {
+            deleteTempDir(dir);
+        }
+    }
+
+    public void testDirectory() throws Exception {
+        File dir = new File(System.getProperty("java.io.tmpdir")).getCanonicalFile();
+        ProcessBuilder pb = new ProcessBuilder(shell(), "-c", "pwd");
+        pb.directory(dir);
+        execAndCheckOutput(pb, dir.getPath() + "\n", "");
+    }
+
+    public void testMissingCommand() throws Exception {
+        try {
+            new ProcessBuilder("/no/such/command").start();
+            fail();
+        } catch (IOException expected) {
+        }
+    }
+
+    public void testChildDoesNotInheritFds() throws Exception {
+        List<FileInputStream> streams = new ArrayList<FileInputStream>();
+        try {
+            for (int i = 0; i < 32; ++i) {
+                streams.add(new FileInputStream("/dev/null"));
+            }
+            // Expect stdin, stdout, stderr, the fd ls reads the directory with, and on Android
+            // the system properties fd.
+            ProcessBuilder pb = new ProcessBuilder(shell(), "-c", "ls /proc/self/fd | wc -l");
+            Process process = pb.start();
+            String output = new Scanner(process.getInputStream()).next();
+            assertEquals(0, process.waitFor());
+            assertTrue(output, Integer.parseInt(output.trim()) < 8);
+        } finally {
+            for (FileInputStream stream : streams) {
+                stream.close();
+            }
+        }
+    }
+
+    public void testChildDoesNotInheritHighFd() throws Exception {
+        FileInputStream stream = new FileInputStream("/dev/null");
+        try {
+            int fd = IoUtils.getFd(stream.getFD());
+            assertTrue(fd > 2);
+            ProcessBuilder pb = new ProcessBuilder(shell(), "-c",
+                    "if [ -e /proc/self/fd/" + fd + " ]; then echo open; else echo closed; fi");
+            execAndCheckOutput(pb, "closed\n", "");
+        } finally {
+            stream.close();
+        }
+    }
+
+    private static File createTempDir() throws IOException {
+        File dir = File.createTempFile("ProcessBuilderTest", null);
+        assertTrue(dir.delete());
+        assertTrue(dir.mkdir());
+        return dir;
+    }
+
+    private static void deleteTempDir(File dir) {
+        for (File file : dir.listFiles()) {
+            file.delete();
+        }
+        dir.delete();
+    }
+
+    private static File createScript(File dir, String name, String contents) throws IOException {
+        File script = new File(dir, name);
+        FileWriter writer = new FileWriter(script);
+        try {
+            writer.write(contents);
+        } finally {
+            writer.close();
+        }
+        assertTrue(script.setExecutable(true));
+        return script;
+    }
 }
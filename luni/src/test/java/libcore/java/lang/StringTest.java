@@ -16,6 +16,7 @@
 
 package libcore.java.lang;
 
+import java.io.ByteArrayOutputStream;
 import java.lang.reflect.Field;
 import java.lang.reflect.Modifier;
 import java.nio.ByteBuffer;
@@ -26,6 +27,7 @@ import java.nio.charset.CharsetDecoder;
 import java.nio.charset.CharsetEncoder;
 import java.nio.charset.CoderResult;
 import java.util.Arrays;
+import java.util.Locale;
 import junit.framework.TestCase;
 
 public class StringTest extends TestCase {
@@ -150,12 +152,80 @@ public class StringTest extends TestCase {
         assertEquals("[104, 63, 105]", Arrays.toString("h\ud800i".getBytes(cs)));
     }
 
+    public void test_getBytes_UTF_8_long() throws Exception {
+        // Long runs of ASCII are copied a vector at a time; put non-ASCII characters at every
+        // offset around the vector boundaries and check the output against a slow encoding.
+        Charset cs = Charset.forName("UTF-8");
+        String[] specials = { "\u0666", "\u1234", "\ud800\udc00", "\ud800" };
+        for (String special : specials) {
+            for (int i = 0; i < 40; i++) {
+                StringBuilder sb = new StringBuilder();
+                for (int j = 0; j < 40; j++) {
+                    sb.append(j == i ? special : String.valueOf((char) ('a' + j % 26)));
+                }
+                String s = sb.toString();
+                assertEquals(Arrays.toString(slowUtf8(s)), Arrays.toString(s.getBytes(cs)));
+            }
+        }
+    }
+
+    private static byte[] slowUtf8(String s) throws Exception {
+        ByteArrayOutputStream out = new ByteArrayOutputStream();
+        for (int i = 0; i < s.length(); i++) {
+            char ch = s.charAt(i);
+            if (Character.isHighSurrogate(ch) && i + 1 < s.length()
+                    && Character.isLowSurrogate(s.charAt(i + 1))) {
+                out.write(s.substring(i, i + 2).getBytes("UTF-8"));
+                ++i;
+            } else if (Character.isHighSurrogate(ch) || Character.isLowSurrogate(ch)) {
+                out.write('?');
+            } else {
+                out.write(String.valueOf(ch).getBytes("UTF-8"));
+            }
+        }
+        return out.toByteArray();
+    }
+
     public void test_new_String_bad() throws Exception {
         // Check that we use U+FFFD as the replacement string for invalid bytes.
         assertEquals("a\ufffdb", new String(new byte[] { 97, -2, 98 }, "US-ASCII"));
         assertEquals("a\ufffdb", new String(new byte[] { 97, -2, 98 }, Charset.forName("US-ASCII")));
     }
 
+    public void test_new_String_UTF_8() throws Exception {
+        Charset cs = Charset.forName("UTF-8");
+        assertEquals("h\u0666\u1234\ud800\udf81", new String(
+                new byte[] { 104, -39, -90, -31, -120, -76, -16, -112, -114, -127 }, cs));
+        // A stray continuation byte, and a lead byte followed by a non-continuation byte.
+        assertEquals("a\ufffdb", new String(new byte[] { 97, -128, 98 }, cs));
+        assertEquals("\ufffdbb", new String(new byte[] { -31, 98, 98 }, cs));
+        // A sequence cut off by the end of the input ends decoding.
+        assertEquals("a\ufffd", new String(new byte[] { 97, -31, -120 }, cs));
+        // Surrogates may only be encoded in three bytes.
+        assertEquals("\ud800", new String(new byte[] { -19, -96, -128 }, cs));
+        assertEquals("\ufffd", new String(new byte[] { -16, -115, -96, -128 }, cs));
+        // Nothing above U+10FFFF.
+        assertEquals("\ufffd", new String(new byte[] { -12, -112, -128, -128 }, cs));
+
+        // Long ASCII runs are decoded a vector at a time; check a non-ASCII character at
+        // every offset around the vector boundaries.
+        for (int i = 0; i < 40; i++) {
+            byte[] bytes = new byte[41];
+            StringBuilder expected = new StringBuilder();
+            for (int j = 0, k = 0; j < 40; j++) {
+                if (j == i) {
+                    bytes[k++] = -39;
+                    bytes[k++] = -90;
+                    expected.append('\u0666');
+                } else {
+                    bytes[k++] = (byte) ('a' + j % 26);
+                    expected.append((char) ('a' + j % 26));
+                }
+            }
+            assertEquals(expected.toString(), new String(bytes, cs));
+        }
+    }
+
     /**
      * Tests a widely assumed performance characteristic of String.substring():
      * that it reuses the original's backing array. Although behaviour should be
@@ -197,6 +267,26 @@ public class StringTest extends TestCase {
         throw new UnsupportedOperationException("No chars[] field on String!");
     }
 
+    // Turkish, Azeri and Lithuanian go to ICU, which maps ASCII itself unless the locale matters.
+    public void testCaseMappingInSpecialLocales() {
+        Locale tr = new Locale("tr", "TR");
+        Locale lt = new Locale("lt");
+        assertEquals("content-type: text/html", "Content-Type: TEXT/HTML".toLowerCase(lt));
+        assertEquals("CONTENT-TYPE: TEXT/HTML", "Content-Type: text/html".toUpperCase(lt));
+        assertEquals("abcdefghjklmnopqrstuvwxyz", "ABCDEFGHJKLMNOPQRSTUVWXYZ".toLowerCase(tr));
+        assertEquals("ABCDEFGHJKLMNOPQRSTUVWXYZ", "abcdefghjklmnopqrstuvwxyz".toUpperCase(tr));
+        assertEquals("\u0131stanbul", "ISTANBUL".toLowerCase(tr));
+        assertEquals("\u0130STANBUL", "istanbul".toUpperCase(new Locale("az")));
+        assertEquals("h\u00e9llo", "H\u00c9LLO".toLowerCase(tr));
+    }
+
+    public void testCaseMappingReturnsSameStringIfUnchanged() {
+        String lower = "x-forwarded-for: 10.0.0.1";
+        assertSame(lower, lower.toLowerCase(new Locale("tr")));
+        String upper = "X-FORWARDED-FOR: 10.0.0.1";
+        assertSame(upper, upper.toUpperCase(new Locale("lt")));
+    }
+
     /**
      * Test that strings interned manually and then later loaded as literals
      * maintain reference equality. http://b/3098960
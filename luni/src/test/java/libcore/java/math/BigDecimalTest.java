@@ -64,4 +64,19 @@ public final class BigDecimalTest extends TestCase {
         BigDecimal rounded = bigDecimal.round(new MathContext(2, RoundingMode.FLOOR));
         assertEquals("0.99", rounded.toString());
     }
+
+    // Adding numbers of different scales that don't fit in a long scales one of them natively.
+    public void testAddDifferentScales() {
+        assertEquals("98765432109876543333.3456789012345678901234567890",
+                new BigDecimal("123.3456789012345678901234567890")
+                .add(new BigDecimal("98765432109876543210")).toString());
+        assertEquals("-98765432109876543086.6543210987654321098765432110",
+                new BigDecimal("123.3456789012345678901234567890")
+                .add(new BigDecimal("-98765432109876543210")).toString());
+        assertEquals("12345678901234567890."
+                + "000000000000000000000000000000000000000000000000000000001",
+                new BigDecimal("1E-57").add(new BigDecimal("12345678901234567890")).toString());
+        assertEquals("1.000000000000000000001", new BigDecimal("1")
+                .add(new BigDecimal("0.000000000000000000001")).toString());
+    }
 }
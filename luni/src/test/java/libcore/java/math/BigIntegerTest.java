@@ -73,4 +73,51 @@ public class BigIntegerTest extends junit.framework.TestCase {
         } catch (NumberFormatException expected) {
         }
     }
+
+    // Montgomery contexts are cached per modulus, so mix repeated and alternating moduli.
+    public void test_modPowCachedModuli() throws Exception {
+        BigInteger[] moduli = {
+            new BigInteger("170141183460469231731687303715884105727"), // 2^127 - 1
+            new BigInteger("1000000007"),
+            new BigInteger("340282366920938463463374607431768211456"), // 2^128 (even)
+            new BigInteger("18446744073709551557"), // largest prime below 2^64
+            new BigInteger("4294967291"),
+            new BigInteger("123456789012345678901234567890123456789"),
+        };
+        BigInteger[] bases = {
+            BigInteger.valueOf(2),
+            BigInteger.valueOf(65537),
+            new BigInteger("98765432109876543210987654321098765432109876543210"),
+            BigInteger.valueOf(-2),
+            new BigInteger("-98765432109876543210987654321098765432109876543210"),
+        };
+        BigInteger exponent = new BigInteger("1234567");
+        for (int round = 0; round < 3; ++round) {
+            for (BigInteger m : moduli) {
+                for (BigInteger base : bases) {
+                    assertEquals(m + " " + base, slowModPow(base, exponent, m),
+                            base.modPow(exponent, m));
+                }
+            }
+        }
+        // The same modulus value in a different BigInteger.
+        BigInteger p = new BigInteger("1000000007");
+        assertEquals(BigInteger.ONE, BigInteger.valueOf(5).modPow(p.subtract(BigInteger.ONE), p));
+        assertEquals(BigInteger.ZERO, p.modPow(exponent, p));
+        // A negative one-word base mustn't be treated as its magnitude.
+        assertEquals(BigInteger.valueOf(6),
+                BigInteger.valueOf(-2).modPow(BigInteger.valueOf(3), BigInteger.valueOf(7)));
+    }
+
+    private static BigInteger slowModPow(BigInteger base, BigInteger exponent, BigInteger m) {
+        BigInteger result = BigInteger.ONE;
+        BigInteger b = base.mod(m);
+        for (int i = exponent.bitLength() - 1; i >= 0; --i) {
+            result = result.multiply(result).mod(m);
+            if (exponent.testBit(i)) {
+                result = result.multiply(b).mod(m);
+            }
+        }
+        return result;
+    }
 }
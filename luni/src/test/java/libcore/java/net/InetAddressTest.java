@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.java.net;
+
+import java.lang.reflect.Method;
+import java.net.InetAddress;
+import java.net.UnknownHostException;
+import junit.framework.TestCase;
+
+public class InetAddressTest extends TestCase {
+    private static void setResolverThreadsUnavailable(boolean unavailable) throws Exception {
+        Method method = InetAddress.class.getDeclaredMethod(
+                "setResolverThreadsUnavailable", boolean.class);
+        method.setAccessible(true);
+        method.invoke(null, unavailable);
+    }
+
+    // With no resolver thread to do it, a lookup that waits for one must fail promptly
+    // rather than wait out its timeout (or forever), and a later lookup must try again.
+    public void testLookupFailsWhenNoResolverThreadCanStart() throws Exception {
+        String host = "resolver-thread-test.invalid";
+        InetAddress.clearDnsCache();
+        setResolverThreadsUnavailable(true);
+        try {
+            InetAddress.prefetchByName(host);
+            long start = System.currentTimeMillis();
+            try {
+                InetAddress.getAllByNameWithTimeout(host, 60 * 1000);
+                fail();
+            } catch (UnknownHostException expected) {
+            }
+            assertTrue(System.currentTimeMillis() - start < 10 * 1000);
+        } finally {
+            setResolverThreadsUnavailable(false);
+            InetAddress.clearDnsCache();
+        }
+
+        assertTrue(InetAddress.getAllByNameWithTimeout("localhost", 60 * 1000).length > 0);
+    }
+}
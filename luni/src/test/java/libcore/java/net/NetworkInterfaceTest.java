@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.java.net;
+
+import java.net.NetworkInterface;
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.List;
+import junit.framework.TestCase;
+
+public class NetworkInterfaceTest extends TestCase {
+    // With nothing changing, a second poll is served from the cache.
+    public void testSnapshotCached() throws Exception {
+        List<NetworkInterface> first = NetworkInterface.getNetworkInterfacesSnapshot(true);
+        List<NetworkInterface> second = NetworkInterface.getNetworkInterfacesSnapshot();
+        assertSame(first, second);
+        // The snapshot also includes interfaces that are down.
+        assertTrue(names(second).containsAll(
+                names(Collections.list(NetworkInterface.getNetworkInterfaces()))));
+    }
+
+    // A refresh builds a new snapshot with the same interfaces, and is cached in turn.
+    public void testSnapshotForcedRefresh() throws Exception {
+        List<NetworkInterface> cached = NetworkInterface.getNetworkInterfacesSnapshot();
+        List<NetworkInterface> refreshed = NetworkInterface.getNetworkInterfacesSnapshot(true);
+        assertNotSame(cached, refreshed);
+        assertEquals(names(cached), names(refreshed));
+        assertSame(refreshed, NetworkInterface.getNetworkInterfacesSnapshot());
+
+        NetworkInterface loopback = null;
+        for (NetworkInterface ni : refreshed) {
+            if (ni.isLoopback()) {
+                loopback = ni;
+            }
+        }
+        assertNotNull(loopback);
+        assertTrue(loopback.isUp());
+        assertTrue(loopback.getMTU() > 0);
+    }
+
+    private static List<String> names(List<NetworkInterface> interfaces) {
+        List<String> result = new ArrayList<String>();
+        for (NetworkInterface ni : interfaces) {
+            result.add(ni.getName());
+        }
+        Collections.sort(result);
+        return result;
+    }
+}
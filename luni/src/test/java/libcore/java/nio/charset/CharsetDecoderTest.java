@@ -80,6 +80,26 @@ public class CharsetDecoderTest extends junit.framework.TestCase {
         assertEquals(SAMPLE_STRING, outBuffer.toString().trim());
     }
 
+    public void test_decodeDirectBuffer() throws Exception {
+        String expected = "Android \u65e5\u672c\u8a9e \u30c6\u30b9\u30c8 Android";
+        byte[] bytes = expected.getBytes("Shift_JIS");
+        // Feed the decoder a few bytes at a time so that multi-byte sequences are split
+        // between calls, as they would be when reading a channel.
+        CharsetDecoder decoder = Charset.forName("Shift_JIS").newDecoder();
+        ByteBuffer in = ByteBuffer.allocateDirect(bytes.length);
+        CharBuffer out = CharBuffer.allocate(expected.length());
+        for (int i = 0; i < bytes.length; i += 3) {
+            in.put(bytes, i, Math.min(3, bytes.length - i));
+            in.flip();
+            CoderResult result = decoder.decode(in, out, i + 3 >= bytes.length);
+            assertFalse(result.toString(), result.isError());
+            in.compact();
+        }
+        decoder.flush(out);
+        out.flip();
+        assertEquals(expected, out.toString());
+    }
+
     private static byte[] prependByteToByteArray(byte[] arr, byte b) {
         byte[] result = new byte[arr.length + 1];
         result[0] = b;
@@ -16,9 +16,11 @@
 
 package libcore.java.nio.charset;
 
+import java.nio.ByteBuffer;
 import java.nio.CharBuffer;
 import java.nio.charset.Charset;
 import java.nio.charset.CharsetEncoder;
+import java.nio.charset.CoderResult;
 import java.nio.charset.CodingErrorAction;
 import java.util.Arrays;
 
@@ -35,6 +37,49 @@ public class CharsetEncoderTest extends junit.framework.TestCase {
         assertEquals("hello=world", output);
     }
 
+    public void test_encodeDirectBuffer() throws Exception {
+        String input = "Android \u65e5\u672c\u8a9e \u30c6\u30b9\u30c8 Android";
+        byte[] expected = input.getBytes("EUC-JP");
+        // A small output buffer forces the encoder to stop and resume in mid-string.
+        CharsetEncoder encoder = Charset.forName("EUC-JP").newEncoder();
+        CharBuffer in = CharBuffer.wrap(input);
+        ByteBuffer out = ByteBuffer.allocateDirect(5);
+        byte[] actual = new byte[expected.length];
+        int count = 0;
+        while (true) {
+            CoderResult result = encoder.encode(in, out, true);
+            assertFalse(result.toString(), result.isError());
+            out.flip();
+            int n = out.remaining();
+            out.get(actual, count, n);
+            count += n;
+            out.clear();
+            if (result.isUnderflow()) {
+                break;
+            }
+        }
+        assertEquals(CoderResult.UNDERFLOW, encoder.flush(out));
+        assertEquals(0, out.position());
+        assertEquals(expected.length, count);
+        assertEquals(Arrays.toString(expected), Arrays.toString(actual));
+    }
+
+    public void test_manyEncodersAndDecoders() throws Exception {
+        // Converters for the same charset are cloned from one another, so they mustn't share state.
+        Charset charset = Charset.forName("Shift_JIS");
+        String input = "\u65e5\u672c\u8a9e";
+        byte[] expected = input.getBytes("Shift_JIS");
+        for (int i = 0; i < 100; i++) {
+            CharsetEncoder encoder = charset.newEncoder();
+            encoder.replaceWith(new byte[] { (byte) ('a' + (i % 26)) });
+            ByteBuffer bytes = encoder.encode(CharBuffer.wrap(input));
+            byte[] actual = new byte[bytes.remaining()];
+            bytes.get(actual);
+            assertEquals(Arrays.toString(expected), Arrays.toString(actual));
+            assertEquals(input, charset.newDecoder().decode(ByteBuffer.wrap(expected)).toString());
+        }
+    }
+
     private void assertReplacementBytesForEncoder(String charset, byte[] bytes) {
         byte[] result = Charset.forName(charset).newEncoder().replacement();
         assertEquals(Arrays.toString(bytes), Arrays.toString(result));
@@ -21,6 +21,7 @@ import java.nio.CharBuffer;
 import java.nio.charset.Charset;
 import java.nio.charset.CharsetEncoder;
 import java.util.Arrays;
+import libcore.icu.NativeConverter;
 
 public class CharsetTest extends junit.framework.TestCase {
     public void test_guaranteedCharsetsAvailable() throws Exception {
@@ -52,6 +53,31 @@ public class CharsetTest extends junit.framework.TestCase {
         }
     }
 
+    public void test_charsetForNameRepeatedly() throws Exception {
+        // Each lookup is answered from the native index after the first, under any spelling.
+        Charset expected = NativeConverter.charsetForName("Shift_JIS");
+        assertNotNull(expected);
+        for (String name : new String[] { "Shift_JIS", "shift_jis", "csShiftJIS", "MS_Kanji" }) {
+            for (int i = 0; i < 3; i++) {
+                Charset cs = NativeConverter.charsetForName(name);
+                assertEquals(name, expected, cs);
+                assertEquals(name, expected.aliases(), cs.aliases());
+            }
+        }
+        assertNull(NativeConverter.charsetForName("no-such-charset"));
+        assertNull(NativeConverter.charsetForName("no-such-charset"));
+    }
+
+    public void test_getAvailableCharsetNames() throws Exception {
+        // The names are only worked out once, but every caller gets an array of its own.
+        String[] names = NativeConverter.getAvailableCharsetNames();
+        String[] again = NativeConverter.getAvailableCharsetNames();
+        assertNotSame(names, again);
+        assertEquals(Arrays.asList(names), Arrays.asList(again));
+        names[0] = null;
+        assertNotNull(NativeConverter.getAvailableCharsetNames()[0]);
+    }
+
     public void test_EUC_JP() throws Exception {
         assertEncodes(Charset.forName("EUC-JP"), "\ufffd", 0xf4, 0xfe);
     }
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.java.nio.charset;
+
+import java.nio.charset.Charsets;
+import junit.framework.TestCase;
+
+public class CharsetsTest extends TestCase {
+    public void testNullArrays() {
+        byte[] bytes = new byte[] { 'a', 'b' };
+        try {
+            Charsets.asciiBytesToChars(bytes, 0, bytes.length, null);
+            fail();
+        } catch (NullPointerException expected) {
+        }
+        try {
+            Charsets.isoLatin1BytesToChars(bytes, 0, bytes.length, null);
+            fail();
+        } catch (NullPointerException expected) {
+        }
+        try {
+            Charsets.utf8BytesToChars(bytes, 0, bytes.length, null);
+            fail();
+        } catch (NullPointerException expected) {
+        }
+        try {
+            Charsets.toAsciiBytes(null, 0, 0);
+            fail();
+        } catch (NullPointerException expected) {
+        }
+        try {
+            Charsets.toUtf8Bytes(null, 0, 0);
+            fail();
+        } catch (NullPointerException expected) {
+        }
+    }
+
+    public void testRoundTrip() {
+        char[] chars = new char[3];
+        Charsets.asciiBytesToChars(new byte[] { 'x', 'a', 'b', 'c' }, 1, 3, chars);
+        assertEquals("abc", new String(chars));
+        assertEquals("abc", new String(Charsets.toAsciiBytes(chars, 0, chars.length)));
+    }
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.java.text;
+
+import java.text.Bidi;
+import java.util.Arrays;
+import org.apache.harmony.text.NativeBidi;
+
+public class BidiTest extends junit.framework.TestCase {
+    // Paragraphs are analyzed in one native call, but lines still go through a UBiDi struct.
+    public void testParagraphMatchesLine() throws Exception {
+        String text = "abc \u05d0\u05d1\u05d2 123 def";
+        Bidi paragraph = new Bidi(text, Bidi.DIRECTION_DEFAULT_LEFT_TO_RIGHT);
+        Bidi line = paragraph.createLineBidi(0, text.length());
+        assertEquals(line.getRunCount(), paragraph.getRunCount());
+        for (int i = 0; i < paragraph.getRunCount(); ++i) {
+            assertEquals(line.getRunStart(i), paragraph.getRunStart(i));
+            assertEquals(line.getRunLimit(i), paragraph.getRunLimit(i));
+            assertEquals(line.getRunLevel(i), paragraph.getRunLevel(i));
+        }
+        for (int i = 0; i < text.length(); ++i) {
+            assertEquals(line.getLevelAt(i), paragraph.getLevelAt(i));
+        }
+        assertTrue(paragraph.isMixed());
+        assertEquals(0, paragraph.getBaseLevel());
+    }
+
+    public void testTextStart() throws Exception {
+        char[] text = "xx\u05d0\u05d1yy".toCharArray();
+        Bidi bidi = new Bidi(text, 2, null, 0, 2, Bidi.DIRECTION_DEFAULT_LEFT_TO_RIGHT);
+        assertTrue(bidi.isRightToLeft());
+        assertEquals(1, bidi.getBaseLevel());
+        assertEquals(2, bidi.getLength());
+    }
+
+    public void testAnalyze() throws Exception {
+        char[] text = "ab\u05d0\u05d1".toCharArray();
+        byte[] levels = new byte[text.length];
+        int[] visualMap = new int[text.length];
+        int[] info = NativeBidi.ubidi_analyze(text, 0, text.length, 0, null, levels, visualMap);
+        assertEquals(NativeBidi.UBiDiDirection_UBIDI_MIXED, info[0]);
+        assertEquals(0, info[1]);
+        assertEquals(2, info[2]);
+        assertEquals("[2, 0, 2, 0, 2, 4, 1]", Arrays.toString(Arrays.copyOfRange(info, 2, 9)));
+        assertEquals("[0, 0, 1, 1]", Arrays.toString(levels));
+        assertEquals("[0, 1, 3, 2]", Arrays.toString(visualMap));
+    }
+}
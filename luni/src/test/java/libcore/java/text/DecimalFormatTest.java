@@ -21,6 +21,7 @@ import java.math.BigInteger;
 import java.math.RoundingMode;
 import java.text.DecimalFormat;
 import java.text.DecimalFormatSymbols;
+import java.text.FieldPosition;
 import java.text.NumberFormat;
 import java.util.Locale;
 
@@ -56,6 +57,30 @@ public class DecimalFormatTest extends junit.framework.TestCase {
         assertEquals(309, numberFormat.format(BigInteger.valueOf(123)).length());
     }
 
+    // Simple patterns are formatted without ICU; check we get what ICU would have given us.
+    public void testSimpleFormatsMatchFieldPositionFormats() throws Exception {
+        String[] patterns = { "#,##0", "#,##0.00", "0", "000000" };
+        long[] longs = { 0, 1, -1, 999, 1000, -1234567, Long.MAX_VALUE, Long.MIN_VALUE };
+        double[] doubles = { 0.0, -0.0, 1.0, -1.0, 1234567.0, 1.5, -0.25, 1e15, 1e20,
+                Double.NaN, Double.POSITIVE_INFINITY };
+        for (String pattern : patterns) {
+            DecimalFormat df = new DecimalFormat(pattern, new DecimalFormatSymbols(Locale.US));
+            for (long l : longs) {
+                StringBuffer slow = df.format(l, new StringBuffer(), new FieldPosition(0));
+                assertEquals(pattern + " " + l, slow.toString(), df.format(l));
+            }
+            for (double d : doubles) {
+                StringBuffer slow = df.format(d, new StringBuffer(), new FieldPosition(0));
+                assertEquals(pattern + " " + d, slow.toString(), df.format(d));
+            }
+        }
+        DecimalFormat df = new DecimalFormat("#,##0.00", new DecimalFormatSymbols(Locale.US));
+        assertEquals("-9,223,372,036,854,775,808.00", df.format(Long.MIN_VALUE));
+        assertEquals("0.00", df.format(0));
+        assertEquals("x1,234.00", df.format(1234, new StringBuffer("x"), new FieldPosition(-1))
+                .toString());
+    }
+
     // Regression test for http://b/1897917: BigDecimal does not take into account multiplier.
     public void testBigDecimalBug1897917() {
         // For example. the BigDecimal 0.17 formatted in PercentInstance is 0% instead of 17%:
@@ -17,6 +17,8 @@
 package libcore.java.text;
 
 import java.text.Normalizer;
+import java.util.Arrays;
+import libcore.icu.NativeNormalizer;
 
 public class NormalizerTest extends junit.framework.TestCase {
     public void testNormalize() {
@@ -84,4 +86,31 @@ public class NormalizerTest extends junit.framework.TestCase {
             // pass
         }
     }
+
+    public void testNormalizeReturnsNormalizedInputUnchanged() {
+        String src = "already-normalized key 42";
+        assertSame(src, Normalizer.normalize(src, Normalizer.Form.NFC));
+        assertSame(src, Normalizer.normalize(src, Normalizer.Form.NFKD));
+    }
+
+    public void testNormalizeAfterNormalizedPrefix() {
+        // Only the part after the quick check's normalized prefix is normalized again; make sure
+        // a combining mark right after that prefix still composes with what precedes it.
+        assertEquals("long prefix \u00e9", Normalizer.normalize("long prefix e\u0301",
+                Normalizer.Form.NFC));
+        assertEquals("x\u1e69y", Normalizer.normalize("x\u1e9b\u0323y", Normalizer.Form.NFKC));
+    }
+
+    public void testNormalizeMany() {
+        String normalized = "abc";
+        String[] result = NativeNormalizer.normalize(
+                new String[] { normalized, "e\u0301", "" }, Normalizer.Form.NFC);
+        assertEquals("[abc, \u00e9, ]", Arrays.toString(result));
+        assertSame(normalized, result[0]);
+        try {
+            NativeNormalizer.normalize(new String[] { "a", null }, Normalizer.Form.NFC);
+            fail();
+        } catch (NullPointerException expected) {
+        }
+    }
 }
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.java.util.regex;
+
+import java.util.Arrays;
+import java.util.regex.Matcher;
+import java.util.regex.Pattern;
+import junit.framework.TestCase;
+
+public final class MatcherTest extends TestCase {
+
+    public void testReplaceAllAcrossBatches() {
+        // replaceAll fetches matches from native code in batches; use a few batches' worth.
+        StringBuilder input = new StringBuilder();
+        StringBuilder expected = new StringBuilder();
+        for (int i = 0; i < 300; i++) {
+            input.append("x").append(i % 10).append(' ');
+            expected.append(i % 10).append("x ");
+        }
+        Matcher m = Pattern.compile("([a-z])(\\d)").matcher(input);
+        assertEquals(expected.toString(), m.replaceAll("$2$1"));
+        try {
+            m.group();
+            fail();
+        } catch (IllegalStateException expectedException) {
+        }
+    }
+
+    public void testReplaceAllNoMatches() {
+        assertEquals("abc", Pattern.compile("\\d").matcher("abc").replaceAll("-"));
+    }
+
+    public void testSplitWithGroupsAndLimit() {
+        assertEquals("[a, b;c]", Arrays.toString("a,b;c".split("([,;])", 2)));
+        assertEquals("[a, b, c]", Arrays.toString("a,b;c".split("([,;])")));
+        assertEquals("[a,b;c]", Arrays.toString("a,b;c".split("([,;])", 1)));
+        assertEquals("[a, b, , ]", Arrays.toString("a,b,,".split("(,)", -1)));
+    }
+}
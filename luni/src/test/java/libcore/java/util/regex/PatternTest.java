@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.java.util.regex;
+
+import java.util.ArrayList;
+import java.util.List;
+import java.util.regex.Pattern;
+import java.util.regex.PatternSyntaxException;
+import junit.framework.TestCase;
+
+public final class PatternTest extends TestCase {
+
+    public void testSharedCompiledPatterns() {
+        // The same regular expression with different flags must not share a compiled form.
+        Pattern caseSensitive = Pattern.compile("abc");
+        Pattern caseInsensitive = Pattern.compile("abc", Pattern.CASE_INSENSITIVE);
+        assertFalse(caseSensitive.matcher("ABC").matches());
+        assertTrue(caseInsensitive.matcher("ABC").matches());
+        assertTrue(Pattern.compile("abc").matcher("abc").matches());
+    }
+
+    public void testManyPatternsOutliveEviction() {
+        // Compile more distinct patterns than are cached, and keep using all of them.
+        List<Pattern> patterns = new ArrayList<Pattern>();
+        for (int i = 0; i < 100; i++) {
+            patterns.add(Pattern.compile("x{" + i + "}"));
+        }
+        for (int i = 0; i < 100; i++) {
+            StringBuilder input = new StringBuilder();
+            for (int j = 0; j < i; j++) {
+                input.append('x');
+            }
+            assertTrue(patterns.get(i).matcher(input).matches());
+        }
+    }
+
+    public void testSyntaxErrorsAreNotCached() {
+        for (int i = 0; i < 2; i++) {
+            try {
+                Pattern.compile("(");
+                fail();
+            } catch (PatternSyntaxException expected) {
+            }
+        }
+    }
+}
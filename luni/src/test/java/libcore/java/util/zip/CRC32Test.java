@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.java.util.zip;
+
+import java.nio.ByteBuffer;
+import java.util.zip.CRC32;
+import java.util.zip.Checksum;
+
+public class CRC32Test extends ChecksumTestCase {
+    @Override protected Checksum newChecksum() {
+        return new CRC32();
+    }
+
+    @Override protected void update(Checksum checksum, ByteBuffer buffer) {
+        ((CRC32) checksum).update(buffer);
+    }
+
+    @Override protected long expectedCheckValue() {
+        return 0xcbf43926L;
+    }
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.java.util.zip;
+
+import java.nio.ByteBuffer;
+import java.util.Random;
+import java.util.zip.Checksum;
+import junit.framework.TestCase;
+
+/**
+ * Tests shared by the checksums, each of which has a vector kernel in native code and a hidden
+ * update(ByteBuffer) that isn't part of {@link Checksum}.
+ */
+public abstract class ChecksumTestCase extends TestCase {
+    protected abstract Checksum newChecksum();
+
+    protected abstract void update(Checksum checksum, ByteBuffer buffer);
+
+    /** Returns the checksum of the ASCII bytes of "123456789". */
+    protected abstract long expectedCheckValue();
+
+    public void testKnownValue() {
+        Checksum checksum = newChecksum();
+        byte[] bytes = "123456789".getBytes();
+        checksum.update(bytes, 0, bytes.length);
+        assertEquals(expectedCheckValue(), checksum.getValue());
+    }
+
+    // The native code switches to a vector kernel for longer inputs, so check that every
+    // way of feeding bytes in agrees, across lengths either side of the switch.
+    public void testUpdatesAgree() {
+        Random random = new Random(42);
+        byte[] bytes = new byte[1000];
+        random.nextBytes(bytes);
+        for (int length = 0; length <= bytes.length; length += 7) {
+            Checksum byteAtATime = newChecksum();
+            for (int i = 0; i < length; ++i) {
+                byteAtATime.update(bytes[i]);
+            }
+
+            Checksum array = newChecksum();
+            array.update(bytes, 0, length);
+            assertEquals(byteAtATime.getValue(), array.getValue());
+
+            ByteBuffer direct = ByteBuffer.allocateDirect(length + 3);
+            direct.position(3);
+            direct.put(bytes, 0, length);
+            direct.position(3);
+            Checksum directChecksum = newChecksum();
+            update(directChecksum, direct);
+            assertEquals(byteAtATime.getValue(), directChecksum.getValue());
+            assertEquals(length + 3, direct.position());
+
+            Checksum heapChecksum = newChecksum();
+            update(heapChecksum, ByteBuffer.wrap(bytes, 0, length));
+            assertEquals(byteAtATime.getValue(), heapChecksum.getValue());
+        }
+    }
+}
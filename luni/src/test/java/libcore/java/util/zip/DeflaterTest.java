@@ -16,6 +16,8 @@
 
 package libcore.java.util.zip;
 
+import java.nio.ByteBuffer;
+import java.util.Arrays;
 import java.util.zip.DataFormatException;
 import java.util.zip.Deflater;
 import java.util.zip.Inflater;
@@ -56,6 +58,89 @@ public class DeflaterTest extends TestCase {
         assertEquals(0, inflater.inflate(decompressed));
     }
 
+    public void testStreamPool() throws DataFormatException {
+        Deflater.setStreamPoolLimits(4, 8);
+        Inflater.setStreamPoolLimits(4, 8);
+        try {
+            // Leave a dictionary and unread input behind; a reused stream mustn't see either.
+            Deflater used = new Deflater(Deflater.BEST_SPEED);
+            used.setDictionary(new byte[] { 1, 2, 3 });
+            used.setInput(new byte[] { 4, 5, 6 });
+            used.end();
+            Inflater usedInflater = new Inflater();
+            usedInflater.setInput(new byte[] { 1, 2, 3 });
+            usedInflater.end();
+
+            long[] before = Deflater.getStreamPoolStats();
+            long[] inflaterBefore = Inflater.getStreamPoolStats();
+            deflater.end();
+            inflater.end();
+            deflater = new Deflater(Deflater.BEST_SPEED);
+            inflater = new Inflater();
+            assertEquals(before[0] + 1, Deflater.getStreamPoolStats()[0]);
+            assertEquals(inflaterBefore[0] + 1, Inflater.getStreamPoolStats()[0]);
+
+            deflater.setInput(new byte[] { 7, 8, 9 });
+            deflater.finish();
+            totalDeflated = deflater.deflate(compressed);
+            assertTrue(deflater.finished());
+            inflater.setInput(compressed, 0, totalDeflated);
+            assertEquals(3, inflater.inflate(decompressed));
+            assertTrue(inflater.finished());
+            assertDecompressed(7, 8, 9);
+
+            deflater.end();
+            Deflater.setStreamPoolLimits(0, 0);
+            assertEquals(0, Deflater.getStreamPoolStats()[2]);
+        } finally {
+            Deflater.setStreamPoolLimits(4, 8);
+        }
+    }
+
+    public void testDirectBuffers() throws DataFormatException {
+        byte[] data = new byte[100000];
+        for (int i = 0; i < data.length; i++) {
+            data[i] = (byte) (i % 251 + (i / 1000));
+        }
+        ByteBuffer input = ByteBuffer.allocateDirect(data.length);
+        input.put(data).flip();
+
+        // Deflate through a small output buffer, so the input takes several calls.
+        ByteBuffer compressedBuffer = ByteBuffer.allocateDirect(data.length + 1024);
+        ByteBuffer chunk = ByteBuffer.allocateDirect(4096);
+        deflater.finish();
+        while (!deflater.finished()) {
+            chunk.clear();
+            deflater.deflate(input, chunk, Deflater.NO_FLUSH);
+            chunk.flip();
+            compressedBuffer.put(chunk);
+        }
+        assertFalse(input.hasRemaining());
+        assertEquals(data.length, deflater.getBytesRead());
+        compressedBuffer.flip();
+        assertEquals(compressedBuffer.remaining(), deflater.getBytesWritten());
+
+        ByteBuffer output = ByteBuffer.allocateDirect(data.length);
+        while (!inflater.finished()) {
+            // Hand the inflater its input a little at a time.
+            ByteBuffer slice = compressedBuffer.duplicate();
+            slice.limit(Math.min(compressedBuffer.limit(), compressedBuffer.position() + 1000));
+            inflater.inflate(slice, output);
+            compressedBuffer.position(slice.position());
+        }
+        assertFalse(compressedBuffer.hasRemaining());
+        output.flip();
+        byte[] result = new byte[output.remaining()];
+        output.get(result);
+        assertTrue(Arrays.equals(data, result));
+
+        try {
+            inflater.inflate(ByteBuffer.allocate(16), output);
+            fail();
+        } catch (IllegalArgumentException expected) {
+        }
+    }
+
     private void deflateInflate(int flush) throws DataFormatException {
         int lastDeflated = deflater.deflate(compressed, totalDeflated,
                 compressed.length - totalDeflated, flush);
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.java.util.zip;
+
+import java.io.ByteArrayInputStream;
+import java.io.ByteArrayOutputStream;
+import java.io.IOException;
+import java.io.InputStream;
+import java.util.Arrays;
+import java.util.Random;
+import java.util.zip.Adler32;
+import java.util.zip.Deflater;
+import java.util.zip.GZIPInputStream;
+import java.util.zip.Inflater;
+import java.util.zip.InflaterInputStream;
+import java.util.zip.ParallelDeflaterOutputStream;
+import junit.framework.TestCase;
+
+public final class ParallelDeflaterOutputStreamTest extends TestCase {
+
+    public void testGzip() throws IOException {
+        byte[] data = compressibleData(1024 * 1024 + 17);
+        byte[] gzipped = compress(data, ParallelDeflaterOutputStream.FORMAT_GZIP, 64 * 1024);
+        // GZIPInputStream checks both the CRC and the length in the trailer.
+        assertTrue(Arrays.equals(data, readFully(new GZIPInputStream(
+                new ByteArrayInputStream(gzipped)))));
+    }
+
+    public void testZlib() throws IOException {
+        byte[] data = compressibleData(300 * 1000);
+        byte[] compressed = compress(data, ParallelDeflaterOutputStream.FORMAT_ZLIB, 10 * 1000);
+        Inflater inflater = new Inflater();
+        assertTrue(Arrays.equals(data, readFully(new InflaterInputStream(
+                new ByteArrayInputStream(compressed), inflater))));
+        // The trailer's Adler-32 is the one zlib computes over the whole input.
+        assertEquals(adler32(data), inflater.getAdler() & 0xffffffffL);
+    }
+
+    public void testRaw() throws IOException {
+        byte[] data = compressibleData(200 * 1000);
+        byte[] compressed = compress(data, ParallelDeflaterOutputStream.FORMAT_RAW, 50 * 1000);
+        assertTrue(Arrays.equals(data, readFully(new InflaterInputStream(
+                new ByteArrayInputStream(compressed), new Inflater(true)))));
+    }
+
+    public void testEmpty() throws IOException {
+        byte[] gzipped = compress(new byte[0], ParallelDeflaterOutputStream.FORMAT_GZIP, 1024);
+        assertEquals(0, readFully(new GZIPInputStream(new ByteArrayInputStream(gzipped))).length);
+    }
+
+    public void testDictionaryKeepsRatioAcrossBlocks() throws IOException {
+        // With the previous block as dictionary, small blocks should cost little over one stream.
+        byte[] data = compressibleData(512 * 1024);
+        int parallel = compress(data, ParallelDeflaterOutputStream.FORMAT_RAW, 32 * 1024).length;
+        ByteArrayOutputStream serial = new ByteArrayOutputStream();
+        Deflater deflater = new Deflater(Deflater.DEFAULT_COMPRESSION, true);
+        deflater.setInput(data);
+        deflater.finish();
+        byte[] buf = new byte[8192];
+        while (!deflater.finished()) {
+            serial.write(buf, 0, deflater.deflate(buf));
+        }
+        deflater.end();
+        assertTrue(parallel + " vs " + serial.size(), parallel < serial.size() * 1.05);
+    }
+
+    private static byte[] compress(byte[] data, int format, int blockSize) throws IOException {
+        ByteArrayOutputStream bytesOut = new ByteArrayOutputStream();
+        ParallelDeflaterOutputStream out = new ParallelDeflaterOutputStream(bytesOut, format,
+                Deflater.DEFAULT_COMPRESSION, blockSize, 4);
+        // Write in uneven pieces so writes straddle block boundaries.
+        int offset = 0;
+        Random random = new Random(0);
+        while (offset < data.length) {
+            int n = Math.min(data.length - offset, random.nextInt(3 * blockSize / 2) + 1);
+            out.write(data, offset, n);
+            offset += n;
+        }
+        out.close();
+        return bytesOut.toByteArray();
+    }
+
+    private static byte[] compressibleData(int length) {
+        byte[] data = new byte[length];
+        Random random = new Random(length);
+        String[] words = { "alpha ", "beta ", "gamma ", "delta ", "epsilon ", "\n" };
+        int i = 0;
+        while (i < length) {
+            byte[] word = words[random.nextInt(words.length)].getBytes();
+            int n = Math.min(word.length, length - i);
+            System.arraycopy(word, 0, data, i, n);
+            i += n;
+        }
+        return data;
+    }
+
+    private static long adler32(byte[] data) {
+        Adler32 adler = new Adler32();
+        adler.update(data);
+        return adler.getValue();
+    }
+
+    private static byte[] readFully(InputStream in) throws IOException {
+        ByteArrayOutputStream bytes = new ByteArrayOutputStream();
+        byte[] buf = new byte[8192];
+        int count;
+        while ((count = in.read(buf)) != -1) {
+            bytes.write(buf, 0, count);
+        }
+        in.close();
+        return bytes.toByteArray();
+    }
+}
@@ -21,6 +21,7 @@ import java.io.FileInputStream;
 import java.io.FileOutputStream;
 import java.io.IOException;
 import java.io.InputStream;
+import java.util.Arrays;
 import java.util.Enumeration;
 import java.util.Random;
 import java.util.zip.ZipEntry;
@@ -60,6 +61,41 @@ public final class ZipFileTest extends TestCase {
         }
     }
 
+    /**
+     * Large entries are inflated straight out of a mapping of the archive, and
+     * small ones through a buffer; both must give back exactly what went in.
+     */
+    public void testInflatedContentsMatch() throws IOException {
+        for (int size : new int[] { 1000, 1024 * 1024 }) {
+            byte[] original = new byte[size];
+            new Random(size).nextBytes(original);
+            File file = File.createTempFile("ZipFileTest", "zip");
+            file.deleteOnExit();
+            ZipOutputStream out = new ZipOutputStream(new FileOutputStream(file));
+            out.putNextEntry(new ZipEntry("padding"));
+            out.write(new byte[777]);
+            out.closeEntry();
+            out.putNextEntry(new ZipEntry("random"));
+            out.write(original);
+            out.closeEntry();
+            out.close();
+
+            ZipFile zipFile = new ZipFile(file);
+            InputStream is = zipFile.getInputStream(zipFile.getEntry("random"));
+            byte[] inflated = new byte[size];
+            int count = 0;
+            int n;
+            while ((n = is.read(inflated, count, Math.min(8192, size - count))) > 0) {
+                count += n;
+            }
+            assertEquals(size, count);
+            assertEquals(-1, is.read());
+            is.close();
+            zipFile.close();
+            assertTrue(Arrays.equals(original, inflated));
+        }
+    }
+
     /**
      * Compresses a single random file into a .zip archive.
      */
@@ -551,6 +551,47 @@ public class SSLSocketTest extends TestCase {
         thread.join();
     }
 
+    /**
+     * A session a trusting context negotiated must not let a context that
+     * doesn't trust the server skip certificate verification by resuming it.
+     */
+    public void test_SSLSocket_sessionNotSharedAcrossContexts() throws Exception {
+        TestSSLContext c = TestSSLContext.create();
+        SSLSocket[] trusted = TestSSLSocketPair.connect(c, null, null);
+        assertNotNull(c.clientContext.getClientSessionContext().getSession(
+                trusted[1].getSession().getId()));
+        trusted[0].close();
+        trusted[1].close();
+
+        TestKeyStore untrusting = TestKeyStore.getClientCA2();
+        SSLContext untrustingContext = TestSSLContext.createSSLContext(
+                "TLS", StandardNames.JSSE_PROVIDER_NAME,
+                untrusting.keyManagers, untrusting.trustManagers);
+        SSLSocket client = (SSLSocket) untrustingContext.getSocketFactory().createSocket(c.host,
+                                                                                        c.port);
+        final SSLSocket server = (SSLSocket) c.serverSocket.accept();
+        Thread thread = new Thread(new Runnable () {
+            public void run() {
+                try {
+                    server.startHandshake();
+                } catch (Exception expected) {
+                    // The client rejects the server's certificate.
+                }
+            }
+        });
+        thread.start();
+        try {
+            client.startHandshake();
+            fail();
+        } catch (SSLHandshakeException expected) {
+            assertTrue(expected.getCause() instanceof CertificateException);
+        }
+        thread.join();
+        client.close();
+        server.close();
+        c.close();
+    }
+
     public void test_SSLSocket_clientAuth() throws Exception {
         TestSSLContext c = TestSSLContext.create(TestKeyStore.getClientCertificate(),
                                                  TestKeyStore.getServer());
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.math;
+
+public class BulkMathTest extends junit.framework.TestCase {
+    private static final double[] VALUES = {
+        0.0, -0.0, 1.0, -1.0, 0.5, 2.0, 3.0, Math.PI, Math.E, 1e-300, 4.9e-324, 1e300,
+        -123.456, 700.0, Double.MAX_VALUE, Double.NaN,
+        Double.POSITIVE_INFINITY, Double.NEGATIVE_INFINITY,
+    };
+
+    // Each result must be bit-for-bit what Math gives, including signed zeros.
+    public void test_matchesMath() throws Exception {
+        double[] out = new double[VALUES.length];
+        BulkMath.sin(VALUES, out, 0, VALUES.length);
+        for (int i = 0; i < VALUES.length; ++i) {
+            assertIdentical(Math.sin(VALUES[i]), out[i]);
+        }
+        BulkMath.cos(VALUES, out, 0, VALUES.length);
+        for (int i = 0; i < VALUES.length; ++i) {
+            assertIdentical(Math.cos(VALUES[i]), out[i]);
+        }
+        BulkMath.tan(VALUES, out, 0, VALUES.length);
+        for (int i = 0; i < VALUES.length; ++i) {
+            assertIdentical(Math.tan(VALUES[i]), out[i]);
+        }
+        BulkMath.exp(VALUES, out, 0, VALUES.length);
+        for (int i = 0; i < VALUES.length; ++i) {
+            assertIdentical(Math.exp(VALUES[i]), out[i]);
+        }
+        BulkMath.log(VALUES, out, 0, VALUES.length);
+        for (int i = 0; i < VALUES.length; ++i) {
+            assertIdentical(Math.log(VALUES[i]), out[i]);
+        }
+        BulkMath.log10(VALUES, out, 0, VALUES.length);
+        for (int i = 0; i < VALUES.length; ++i) {
+            assertIdentical(Math.log10(VALUES[i]), out[i]);
+        }
+        BulkMath.cbrt(VALUES, out, 0, VALUES.length);
+        for (int i = 0; i < VALUES.length; ++i) {
+            assertIdentical(Math.cbrt(VALUES[i]), out[i]);
+        }
+        BulkMath.sqrt(VALUES, out, 0, VALUES.length);
+        for (int i = 0; i < VALUES.length; ++i) {
+            assertIdentical(Math.sqrt(VALUES[i]), out[i]);
+        }
+        BulkMath.pow(VALUES, 2.5, out, 0, VALUES.length);
+        for (int i = 0; i < VALUES.length; ++i) {
+            assertIdentical(Math.pow(VALUES[i], 2.5), out[i]);
+        }
+    }
+
+    public void test_rangeOnly() throws Exception {
+        double[] in = { 4.0, 9.0, 16.0, 25.0, 36.0 };
+        double[] out = { -1.0, -1.0, -1.0, -1.0, -1.0 };
+        BulkMath.sqrt(in, out, 1, 3);
+        assertEquals(-1.0, out[0]);
+        assertEquals(3.0, out[1]);
+        assertEquals(4.0, out[2]);
+        assertEquals(5.0, out[3]);
+        assertEquals(-1.0, out[4]);
+        BulkMath.sqrt(in, out, 5, 0);
+    }
+
+    public void test_inPlace() throws Exception {
+        double[] values = new double[1000];
+        for (int i = 0; i < values.length; ++i) {
+            values[i] = i;
+        }
+        BulkMath.sqrt(values, values, 0, values.length);
+        BulkMath.pow(values, 2.0, values, 0, values.length);
+        for (int i = 0; i < values.length; ++i) {
+            assertEquals(i, values[i], 1e-9);
+        }
+    }
+
+    public void test_badArguments() throws Exception {
+        double[] in = new double[4];
+        double[] shortOut = new double[2];
+        try {
+            BulkMath.exp(in, shortOut, 0, 4);
+            fail();
+        } catch (ArrayIndexOutOfBoundsException expected) {
+        }
+        try {
+            BulkMath.exp(in, in, -1, 2);
+            fail();
+        } catch (ArrayIndexOutOfBoundsException expected) {
+        }
+        try {
+            BulkMath.exp(in, in, 3, 2);
+            fail();
+        } catch (ArrayIndexOutOfBoundsException expected) {
+        }
+        try {
+            BulkMath.exp(in, in, 1, Integer.MAX_VALUE);
+            fail();
+        } catch (ArrayIndexOutOfBoundsException expected) {
+        }
+        try {
+            BulkMath.exp(null, in, 0, 0);
+            fail();
+        } catch (NullPointerException expected) {
+        }
+    }
+
+    private static void assertIdentical(double expected, double actual) {
+        assertEquals(Double.doubleToLongBits(expected), Double.doubleToLongBits(actual));
+    }
+}
@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.util;
+
+import java.text.Bidi;
+import java.text.Normalizer;
+
+public class NativeSubsystemsTest extends junit.framework.TestCase {
+    public void testEnsureRegisteredIsIdempotent() throws Exception {
+        NativeSubsystems.ensureRegistered(NativeSubsystems.ICU);
+        NativeSubsystems.ensureRegistered(NativeSubsystems.ICU);
+        assertEquals("é", Normalizer.normalize("é", Normalizer.Form.NFC));
+        assertFalse(new Bidi("abc", Bidi.DIRECTION_LEFT_TO_RIGHT).isMixed());
+    }
+
+    public void testUnknownSubsystem() throws Exception {
+        try {
+            NativeSubsystems.ensureRegistered("no-such-subsystem");
+            fail();
+        } catch (IllegalArgumentException expected) {
+        }
+    }
+}
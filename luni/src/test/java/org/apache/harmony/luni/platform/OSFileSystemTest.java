@@ -0,0 +1,322 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.apache.harmony.luni.platform;
+
+import java.io.File;
+import java.io.FileDescriptor;
+import java.io.FileOutputStream;
+import java.io.InputStream;
+import java.io.RandomAccessFile;
+import java.net.InetSocketAddress;
+import java.net.Socket;
+import java.nio.channels.ServerSocketChannel;
+import java.nio.channels.SocketChannel;
+import java.util.Arrays;
+import junit.framework.TestCase;
+import libcore.io.IoUtils;
+
+/**
+ * Tests org.apache.harmony.luni.platform.OSFileSystem.
+ */
+public class OSFileSystemTest extends TestCase {
+    private final OSFileSystem fileSystem = OSFileSystem.getOSFileSystem();
+
+    public void testIoQueue() throws Exception {
+        File file = File.createTempFile("OSFileSystemTest", null);
+        file.deleteOnExit();
+        RandomAccessFile raf = new RandomAccessFile(file, "rw");
+        byte[] contents = new byte[8192];
+        for (int i = 0; i < contents.length; i++) {
+            contents[i] = (byte) i;
+        }
+        raf.write(contents);
+        int fd = IoUtils.getFd(raf.getFD());
+
+        int queue = fileSystem.ioQueueOpen(8);
+        int buffer = OSMemory.malloc(4 * 16);
+        try {
+            // Read four 16-byte chunks from scattered offsets.
+            int[] ops = new int[4];
+            int[] fds = new int[] { fd, fd, fd, fd };
+            long[] offsets = new long[] { 0, 4096, 100, 8000 };
+            int[] addresses = new int[4];
+            int[] lengths = new int[] { 16, 16, 16, 16 };
+            int[] tags = new int[] { 10, 11, 12, 13 };
+            for (int i = 0; i < 4; i++) {
+                ops[i] = IFileSystem.IO_READ;
+                addresses[i] = buffer + i * 16;
+            }
+            assertEquals(4, fileSystem.ioQueueSubmit(queue, ops, fds, offsets, addresses,
+                    lengths, tags, 4));
+
+            int[] doneTags = new int[4];
+            long[] results = new long[4];
+            int done = 0;
+            while (done < 4) {
+                int n = fileSystem.ioQueueReap(queue, doneTags, results, 1);
+                for (int i = 0; i < n; i++) {
+                    assertEquals(16, results[i]);
+                }
+                done += n;
+            }
+
+            for (int i = 0; i < 4; i++) {
+                for (int j = 0; j < 16; j++) {
+                    assertEquals(contents[(int) offsets[i] + j], OSMemory.peekByte(addresses[i] + j));
+                }
+            }
+
+            // Nothing is outstanding, so reaping doesn't block.
+            assertEquals(0, fileSystem.ioQueueReap(queue, doneTags, results, 1));
+        } finally {
+            OSMemory.free(buffer);
+            fileSystem.ioQueueClose(queue);
+            raf.close();
+        }
+    }
+
+    public void testAdvise() throws Exception {
+        File file = File.createTempFile("OSFileSystemTest", null);
+        file.deleteOnExit();
+        RandomAccessFile raf = new RandomAccessFile(file, "rw");
+        raf.write(new byte[8192]);
+        raf.close();
+
+        int fd = fileSystem.open(file.getPath(), IFileSystem.O_RDONLY | IFileSystem.O_SEQUENTIAL);
+        try {
+            fileSystem.advise(fd, 0, 0, IFileSystem.ADVICE_RANDOM);
+            fileSystem.advise(fd, 4096, 4096, IFileSystem.ADVICE_DONTNEED);
+            fileSystem.readahead(fd, 0, 4096);
+            try {
+                fileSystem.advise(fd, 0, 0, 42);
+                fail();
+            } catch (IllegalArgumentException expected) {
+            }
+            try {
+                fileSystem.advise(fd, -1, 0, IFileSystem.ADVICE_NORMAL);
+                fail();
+            } catch (IllegalArgumentException expected) {
+            }
+        } finally {
+            IoUtils.close(IoUtils.newFileDescriptor(fd));
+        }
+    }
+
+    public void testDirectIo() throws Exception {
+        File file = File.createTempFile("OSFileSystemTest", null);
+        file.deleteOnExit();
+        RandomAccessFile raf = new RandomAccessFile(file, "rw");
+        byte[] contents = new byte[8192];
+        for (int i = 0; i < contents.length; i++) {
+            contents[i] = (byte) i;
+        }
+        raf.write(contents);
+        raf.close();
+
+        int buffer = OSMemory.mallocAligned(4096, 4096);
+        assertEquals(0, buffer & 4095);
+        int fd = fileSystem.open(file.getPath(), IFileSystem.O_RDONLY | IFileSystem.O_DIRECT);
+        try {
+            // Some file systems (tmpfs, for one) refuse O_DIRECT, in which case open falls back
+            // to an ordinary read; either way we should read back what we wrote.
+            assertEquals(4096, fileSystem.readDirect(fd, buffer, 0, 4096));
+            for (int i = 0; i < 4096; i++) {
+                assertEquals(contents[i], OSMemory.peekByte(buffer + i));
+            }
+        } finally {
+            IoUtils.close(IoUtils.newFileDescriptor(fd));
+            OSMemory.free(buffer);
+        }
+
+        try {
+            OSMemory.mallocAligned(16, 24);
+            fail();
+        } catch (IllegalArgumentException expected) {
+        }
+    }
+
+    public void testTransferFile() throws Exception {
+        File source = File.createTempFile("OSFileSystemTest", null);
+        source.deleteOnExit();
+        byte[] contents = new byte[100000];
+        for (int i = 0; i < contents.length; i++) {
+            contents[i] = (byte) (i * 31);
+        }
+        RandomAccessFile in = new RandomAccessFile(source, "rw");
+        in.write(contents);
+
+        File dest = File.createTempFile("OSFileSystemTest", null);
+        dest.deleteOnExit();
+        RandomAccessFile out = new RandomAccessFile(dest, "rw");
+        try {
+            int inFd = IoUtils.getFd(in.getFD());
+            int outFd = IoUtils.getFd(out.getFD());
+
+            // A whole-file copy into an empty file may be a reflink; either way the data must match.
+            assertEquals(contents.length, fileSystem.transferFile(inFd, 0, outFd, contents.length));
+            assertEquals(contents.length, out.getFilePointer());
+
+            // A partial copy is appended at the destination's position, and stops at end of file.
+            assertEquals(1000, fileSystem.transferFile(inFd, contents.length - 1000, outFd, 5000));
+            assertEquals(contents.length + 1000, out.length());
+
+            byte[] copy = new byte[(int) out.length()];
+            out.seek(0);
+            out.readFully(copy);
+            for (int i = 0; i < contents.length; i++) {
+                assertEquals(contents[i], copy[i]);
+            }
+            for (int i = 0; i < 1000; i++) {
+                assertEquals(contents[contents.length - 1000 + i], copy[contents.length + i]);
+            }
+        } finally {
+            in.close();
+            out.close();
+        }
+    }
+
+    /**
+     * Relays into a non-blocking socket whose peer reads slowly, so the sink fills up part way
+     * through. Every byte taken from the source must still arrive, in order.
+     */
+    public void testRelayToNonBlockingSocket() throws Exception {
+        final byte[] contents = new byte[1024 * 1024];
+        for (int i = 0; i < contents.length; i++) {
+            contents[i] = (byte) (i * 31 + i / 256);
+        }
+        int[] pipeFds = new int[2];
+        IoUtils.pipe(pipeFds);
+        FileDescriptor source = IoUtils.newFileDescriptor(pipeFds[0]);
+        final FileOutputStream pipeOut =
+                new FileOutputStream(IoUtils.newFileDescriptor(pipeFds[1]));
+
+        ServerSocketChannel server = ServerSocketChannel.open();
+        server.socket().bind(new InetSocketAddress("localhost", 0));
+        SocketChannel client = SocketChannel.open(server.socket().getLocalSocketAddress());
+        final Socket peer = server.accept().socket();
+        client.socket().setSendBufferSize(4096);
+        client.configureBlocking(false);
+        FileDescriptor sink = ((FileDescriptorHandler) client).getFD();
+
+        final Throwable[] failure = new Throwable[1];
+        Thread writer = new Thread() {
+            @Override public void run() {
+                try {
+                    pipeOut.write(contents);
+                    pipeOut.close();
+                } catch (Throwable t) {
+                    failure[0] = t;
+                }
+            }
+        };
+        final byte[] received = new byte[contents.length];
+        Thread reader = new Thread() {
+            @Override public void run() {
+                try {
+                    InputStream in = peer.getInputStream();
+                    int count = 0;
+                    while (count < received.length) {
+                        // Read in small sips so the relay keeps finding the sink full.
+                        Thread.sleep(1);
+                        int n = in.read(received, count, Math.min(8192, received.length - count));
+                        if (n == -1) {
+                            break;
+                        }
+                        count += n;
+                    }
+                } catch (Throwable t) {
+                    failure[0] = t;
+                }
+            }
+        };
+        writer.start();
+        reader.start();
+        try {
+            long total = 0;
+            while (true) {
+                long n = fileSystem.relay(source, sink, contents.length);
+                if (n == -1) {
+                    break;
+                }
+                total += n;
+            }
+            assertEquals(contents.length, total);
+            writer.join();
+            reader.join();
+            assertNull(failure[0]);
+            assertTrue(Arrays.equals(contents, received));
+        } finally {
+            IoUtils.close(source);
+            client.close();
+            peer.close();
+            server.close();
+        }
+    }
+
+    public void testGroupSync() throws Exception {
+        File file = File.createTempFile("OSFileSystemTest", null);
+        file.deleteOnExit();
+        final RandomAccessFile raf = new RandomAccessFile(file, "rw");
+        final int fd = IoUtils.getFd(raf.getFD());
+        final Throwable[] failure = new Throwable[1];
+        Thread[] threads = new Thread[8];
+        for (int i = 0; i < threads.length; i++) {
+            final boolean metadata = (i % 2) == 0;
+            threads[i] = new Thread() {
+                @Override public void run() {
+                    try {
+                        for (int j = 0; j < 10; j++) {
+                            synchronized (raf) {
+                                raf.write(new byte[512]);
+                            }
+                            fileSystem.groupSync(fd, metadata);
+                        }
+                    } catch (Throwable t) {
+                        failure[0] = t;
+                    }
+                }
+            };
+            threads[i].start();
+        }
+        for (Thread thread : threads) {
+            thread.join();
+        }
+        raf.close();
+        assertNull(failure[0]);
+        assertEquals(8 * 10 * 512, file.length());
+    }
+
+    public void testSyncFileRange() throws Exception {
+        File file = File.createTempFile("OSFileSystemTest", null);
+        file.deleteOnExit();
+        RandomAccessFile raf = new RandomAccessFile(file, "rw");
+        try {
+            raf.write(new byte[8192]);
+            int fd = IoUtils.getFd(raf.getFD());
+            fileSystem.syncFileRange(fd, 0, 4096, IFileSystem.SYNC_FILE_RANGE_WRITE);
+            fileSystem.syncFileRange(fd, 0, 0, IFileSystem.SYNC_FILE_RANGE_WAIT_BEFORE
+                    | IFileSystem.SYNC_FILE_RANGE_WRITE | IFileSystem.SYNC_FILE_RANGE_WAIT_AFTER);
+            try {
+                fileSystem.syncFileRange(fd, 0, 0, 8);
+                fail();
+            } catch (IllegalArgumentException expected) {
+            }
+        } finally {
+            raf.close();
+        }
+    }
+}
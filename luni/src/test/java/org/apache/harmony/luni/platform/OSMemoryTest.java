@@ -17,7 +17,12 @@
 
 package org.apache.harmony.luni.platform;
 
+import java.io.File;
+import java.io.RandomAccessFile;
+import java.nio.channels.FileChannel.MapMode;
+import java.util.concurrent.CountDownLatch;
 import junit.framework.TestCase;
+import libcore.io.IoUtils;
 
 /**
  * Tests org.apache.harmony.luni.platform.OSMemory.
@@ -111,4 +116,153 @@ public class OSMemoryTest extends TestCase {
             assertEquals(expectedValues[i], OSMemory.peekShort(ptr + 2 * i, swap));
         }
     }
+
+    // The swapping code works in 16-byte vectors where it can, so check every length up to a few
+    // vectors, at an address that isn't 16-byte aligned, to cover the scalar tail too.
+    public void testSwappedArraysOfAllLengths() {
+        int ptr = OSMemory.malloc(8 * 40 + 4);
+        try {
+            for (int count = 0; count <= 40; ++count) {
+                short[] shorts = new short[count];
+                int[] ints = new int[count];
+                long[] longs = new long[count];
+                for (int i = 0; i < count; ++i) {
+                    shorts[i] = (short) (0x0102 * (i + 1));
+                    ints[i] = 0x01020304 * (i + 1);
+                    longs[i] = 0x0102030405060708L * (i + 1);
+                }
+
+                OSMemory.pokeShortArray(ptr + 4, shorts, 0, count, true);
+                short[] shortsBack = new short[count];
+                OSMemory.peekShortArray(ptr + 4, shortsBack, 0, count, true);
+                for (int i = 0; i < count; ++i) {
+                    assertEquals(shorts[i], shortsBack[i]);
+                    assertEquals(Short.reverseBytes(shorts[i]), OSMemory.peekShort(ptr + 4 + 2 * i, false));
+                }
+
+                OSMemory.pokeIntArray(ptr + 4, ints, 0, count, true);
+                int[] intsBack = new int[count];
+                OSMemory.peekIntArray(ptr + 4, intsBack, 0, count, true);
+                for (int i = 0; i < count; ++i) {
+                    assertEquals(ints[i], intsBack[i]);
+                    assertEquals(Integer.reverseBytes(ints[i]), OSMemory.peekInt(ptr + 4 + 4 * i, false));
+                }
+
+                OSMemory.pokeLongArray(ptr + 4, longs, 0, count, true);
+                long[] longsBack = new long[count];
+                OSMemory.peekLongArray(ptr + 4, longsBack, 0, count, true);
+                for (int i = 0; i < count; ++i) {
+                    assertEquals(longs[i], longsBack[i]);
+                    assertEquals(Long.reverseBytes(longs[i]), OSMemory.peekLong(ptr + 4 + 8 * i, false));
+                }
+            }
+        } finally {
+            OSMemory.free(ptr);
+        }
+    }
+
+    public void testUnsafeBulkNullArrays() {
+        byte[] bytes = new byte[8];
+        try {
+            OSMemory.unsafeBulkGet(null, 0, 8, bytes, 0, 4, true);
+            fail();
+        } catch (NullPointerException expected) {
+        }
+        try {
+            OSMemory.unsafeBulkPut(bytes, 0, 8, null, 0, 4, true);
+            fail();
+        } catch (NullPointerException expected) {
+        }
+    }
+
+    public void testPool() throws Exception {
+        OSMemory.setPoolLimit(1024 * 1024);
+        try {
+            int ptr = OSMemory.malloc(4000);
+            long[] before = OSMemory.getPoolStats();
+            OSMemory.pokeInt(ptr, 0x12345678, false);
+            OSMemory.free(ptr);
+            assertEquals(before[2] + 4096, OSMemory.getPoolStats()[2]);
+
+            // A different size in the same class reuses the block, zeroed.
+            ptr = OSMemory.malloc(3000);
+            long[] after = OSMemory.getPoolStats();
+            assertEquals(before[0] + 1, after[0]);
+            assertEquals(before[2], after[2]);
+            assertEquals(0, OSMemory.peekInt(ptr, false));
+            OSMemory.free(ptr);
+        } finally {
+            OSMemory.setPoolLimit(0);
+        }
+    }
+
+    public void testPoolOffReleasesThreadCaches() throws Exception {
+        long heldBefore = OSMemory.getPoolStats()[2];
+        OSMemory.setPoolLimit(1024 * 1024);
+        try {
+            // This thread's block goes to its own cache.
+            OSMemory.free(OSMemory.malloc(4000));
+            // Another thread's block goes to its cache, which it keeps using afterwards.
+            final CountDownLatch cached = new CountDownLatch(1);
+            final CountDownLatch poolOff = new CountDownLatch(1);
+            final long[] heldAfterOtherThreadDrained = new long[1];
+            Thread other = new Thread() {
+                @Override public void run() {
+                    OSMemory.free(OSMemory.malloc(8000));
+                    cached.countDown();
+                    try {
+                        poolOff.await();
+                    } catch (InterruptedException e) {
+                        throw new AssertionError(e);
+                    }
+                    OSMemory.free(OSMemory.malloc(16));
+                    heldAfterOtherThreadDrained[0] = OSMemory.getPoolStats()[2];
+                }
+            };
+            other.start();
+            cached.await();
+            assertEquals(heldBefore + 4096 + 8192, OSMemory.getPoolStats()[2]);
+
+            OSMemory.setPoolLimit(0);
+            assertEquals(heldBefore + 8192, OSMemory.getPoolStats()[2]);
+            poolOff.countDown();
+            other.join();
+            assertEquals(heldBefore, heldAfterOtherThreadDrained[0]);
+        } finally {
+            OSMemory.setPoolLimit(0);
+        }
+    }
+
+    public void testMmapOptionsAndMadvise() throws Exception {
+        File file = File.createTempFile("OSMemoryTest", null);
+        file.deleteOnExit();
+        RandomAccessFile raf = new RandomAccessFile(file, "rw");
+        byte[] contents = new byte[3 * 4096];
+        for (int i = 0; i < contents.length; ++i) {
+            contents[i] = (byte) i;
+        }
+        raf.write(contents);
+
+        int fd = IoUtils.getFd(raf.getFD());
+        int options = OSMemory.MAP_OPTION_POPULATE | OSMemory.MAP_OPTION_HUGE_PAGES;
+        int address = OSMemory.mmap(fd, 0, contents.length, MapMode.READ_ONLY, options);
+        try {
+            // Sub-ranges needn't start on a page boundary.
+            OSMemory.madvise(address + 100, 4096, OSMemory.MADVICE_RANDOM);
+            OSMemory.madvise(address, contents.length, OSMemory.MADVICE_SEQUENTIAL);
+            OSMemory.madvise(address + 4096, 4096, OSMemory.MADVICE_DONTNEED);
+            // Shared mappings read back the file after MADV_DONTNEED.
+            for (int i = 0; i < contents.length; ++i) {
+                assertEquals(contents[i], OSMemory.peekByte(address + i));
+            }
+            try {
+                OSMemory.madvise(address, 4096, 42);
+                fail();
+            } catch (IllegalArgumentException expected) {
+            }
+        } finally {
+            OSMemory.munmap(address, contents.length);
+            raf.close();
+        }
+    }
 }
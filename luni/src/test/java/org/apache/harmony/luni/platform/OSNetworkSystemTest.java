@@ -0,0 +1,313 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.apache.harmony.luni.platform;
+
+import java.io.FileDescriptor;
+import java.io.InputStream;
+import java.net.InetAddress;
+import java.net.ServerSocket;
+import java.net.Socket;
+import junit.framework.TestCase;
+import libcore.io.IoUtils;
+
+/**
+ * Tests org.apache.harmony.luni.platform.OSNetworkSystem.
+ */
+public class OSNetworkSystemTest extends TestCase {
+    private static final int READABLE = 1;
+    private static final int WRITABLE = 2;
+
+    private final OSNetworkSystem network = OSNetworkSystem.getOSNetworkSystem();
+
+    private FileDescriptor newBoundDatagramSocket() throws Exception {
+        FileDescriptor fd = new FileDescriptor();
+        network.socket(fd, false);
+        network.bind(fd, InetAddress.getByName("127.0.0.1"), 0);
+        return fd;
+    }
+
+    public void testEpoll() throws Exception {
+        FileDescriptor epollFd = new FileDescriptor();
+        network.epollCreate(epollFd);
+        FileDescriptor fd = newBoundDatagramSocket();
+        try {
+            int[] tokens = new int[4];
+            int[] ops = new int[4];
+
+            // Nothing has been sent, so we shouldn't be readable.
+            network.epollRegister(epollFd, fd, READABLE, 42);
+            assertEquals(0, network.epollWait(epollFd, tokens, ops, 0));
+
+            // Send ourselves a datagram, and check we're told about it.
+            byte[] data = new byte[] { 1, 2, 3 };
+            int port = network.getSocketLocalPort(fd);
+            network.send(fd, data, 0, data.length, port, InetAddress.getByName("127.0.0.1"));
+            assertEquals(1, network.epollWait(epollFd, tokens, ops, 1000));
+            assertEquals(42, tokens[0]);
+            assertEquals(READABLE, ops[0] & READABLE);
+
+            // A datagram socket is always writable.
+            network.epollModify(epollFd, fd, WRITABLE, 7);
+            assertEquals(1, network.epollWait(epollFd, tokens, ops, 1000));
+            assertEquals(7, tokens[0]);
+            assertEquals(WRITABLE, ops[0] & WRITABLE);
+
+            // Once deregistered, we shouldn't hear about it any more.
+            network.epollDeregister(epollFd, fd);
+            assertEquals(0, network.epollWait(epollFd, tokens, ops, 0));
+        } finally {
+            network.close(fd);
+            network.close(epollFd);
+        }
+    }
+
+    public void testBatchDatagrams() throws Exception {
+        FileDescriptor fd = newBoundDatagramSocket();
+        int stride = 64;
+        int count = 3;
+        int buffer = OSMemory.malloc(stride * count);
+        try {
+            int port = network.getSocketLocalPort(fd);
+            byte[] loopback = new byte[16];
+            loopback[10] = (byte) 0xff;
+            loopback[11] = (byte) 0xff;
+            loopback[12] = 127;
+            loopback[15] = 1;
+
+            int[] lengths = new int[count];
+            int[] ports = new int[count];
+            byte[] addresses = new byte[16 * count];
+            for (int i = 0; i < count; ++i) {
+                OSMemory.pokeByte(buffer + i * stride, (byte) i);
+                lengths[i] = i + 1;
+                ports[i] = port;
+                System.arraycopy(loopback, 0, addresses, 16 * i, 16);
+            }
+            assertEquals(count, network.sendBatchDirect(fd, buffer, stride, count,
+                    lengths, ports, addresses));
+
+            int[] receivedLengths = new int[count];
+            int[] receivedPorts = new int[count];
+            byte[] receivedAddresses = new byte[16 * count];
+            // Clear the buffer so we know the datagrams really were received.
+            for (int i = 0; i < count; ++i) {
+                OSMemory.pokeByte(buffer + i * stride, (byte) -1);
+            }
+            int received = network.recvBatchDirect(fd, buffer, stride, count,
+                    receivedLengths, receivedPorts, receivedAddresses);
+            assertTrue(received >= 1 && received <= count);
+            for (int i = 0; i < received; ++i) {
+                assertEquals(i + 1, receivedLengths[i]);
+                assertEquals(port, receivedPorts[i]);
+                assertEquals((byte) i, OSMemory.peekByte(buffer + i * stride));
+            }
+        } finally {
+            OSMemory.free(buffer);
+            network.close(fd);
+        }
+    }
+
+    public void testSendBatchRejectsBadLengths() throws Exception {
+        FileDescriptor fd = newBoundDatagramSocket();
+        int stride = 64;
+        int buffer = OSMemory.malloc(stride * 2);
+        try {
+            int port = network.getSocketLocalPort(fd);
+            byte[] addresses = new byte[16 * 2];
+            for (int i = 0; i < 2; ++i) {
+                addresses[16 * i + 10] = (byte) 0xff;
+                addresses[16 * i + 11] = (byte) 0xff;
+                addresses[16 * i + 12] = 127;
+                addresses[16 * i + 15] = 1;
+            }
+            int[] ports = new int[] { port, port };
+            for (int badLength : new int[] { -1, stride + 1 }) {
+                try {
+                    network.sendBatchDirect(fd, buffer, stride, 2, new int[] { 1, badLength },
+                            ports, addresses);
+                    fail("length " + badLength);
+                } catch (IllegalArgumentException expected) {
+                }
+            }
+            // A datagram may fill its whole slot.
+            assertEquals(2, network.sendBatchDirect(fd, buffer, stride, 2,
+                    new int[] { stride, 0 }, ports, addresses));
+        } finally {
+            OSMemory.free(buffer);
+            network.close(fd);
+        }
+    }
+
+    public void testConnectWithData() throws Exception {
+        ServerSocket serverSocket = new ServerSocket(0, 1, InetAddress.getByName("127.0.0.1"));
+        FileDescriptor fd = new FileDescriptor();
+        network.socket(fd, true);
+        try {
+            byte[] data = new byte[] { 1, 2, 3, 4 };
+            int sent = network.connectWithData(fd, InetAddress.getByName("127.0.0.1"),
+                    serverSocket.getLocalPort(), 1000, data, 0, data.length);
+            assertTrue(sent >= 0 && sent <= data.length);
+            // Whatever didn't go in the SYN is ours to send.
+            while (sent < data.length) {
+                sent += network.write(fd, data, sent, data.length - sent);
+            }
+
+            Socket peer = serverSocket.accept();
+            InputStream in = peer.getInputStream();
+            for (byte b : data) {
+                assertEquals(b, (byte) in.read());
+            }
+            peer.close();
+        } finally {
+            network.close(fd);
+            serverSocket.close();
+        }
+    }
+
+    public void testConnectWithDataRejectsBadBounds() throws Exception {
+        ServerSocket serverSocket = new ServerSocket(0, 1, InetAddress.getByName("127.0.0.1"));
+        FileDescriptor fd = new FileDescriptor();
+        network.socket(fd, true);
+        try {
+            InetAddress loopback = InetAddress.getByName("127.0.0.1");
+            int port = serverSocket.getLocalPort();
+            byte[] data = new byte[4];
+            int[][] badBounds = { { -1, 1 }, { 0, -1 }, { 0, 5 }, { 3, 2 }, { 5, 0 } };
+            for (int[] bounds : badBounds) {
+                try {
+                    network.connectWithData(fd, loopback, port, 1000, data, bounds[0], bounds[1]);
+                    fail("offset=" + bounds[0] + " count=" + bounds[1]);
+                } catch (ArrayIndexOutOfBoundsException expected) {
+                }
+            }
+        } finally {
+            network.close(fd);
+            serverSocket.close();
+        }
+    }
+
+    public void testScatterGather() throws Exception {
+        ServerSocket serverSocket = new ServerSocket(0, 1, InetAddress.getByName("127.0.0.1"));
+        FileDescriptor fd = new FileDescriptor();
+        network.socket(fd, true);
+        int header = OSMemory.malloc(8);
+        int body = OSMemory.malloc(8);
+        try {
+            network.connect(fd, InetAddress.getByName("127.0.0.1"),
+                    serverSocket.getLocalPort(), 1000);
+            Socket peer = serverSocket.accept();
+
+            // Gather a 3-byte header and a 5-byte body, each from an offset into its buffer.
+            for (int i = 0; i < 8; ++i) {
+                OSMemory.pokeByte(header + i, (byte) (10 + i));
+                OSMemory.pokeByte(body + i, (byte) (20 + i));
+            }
+            int[] buffers = new int[] { header, body };
+            assertEquals(8, network.writev(fd, buffers, new int[] { 1, 2 }, new int[] { 3, 5 },
+                    2, false));
+            InputStream in = peer.getInputStream();
+            byte[] expected = new byte[] { 11, 12, 13, 22, 23, 24, 25, 26 };
+            for (byte b : expected) {
+                assertEquals(b, (byte) in.read());
+            }
+
+            // Scatter the same bytes back into a 3-byte and a 5-byte buffer.
+            for (int i = 0; i < 8; ++i) {
+                OSMemory.pokeByte(header + i, (byte) 0);
+                OSMemory.pokeByte(body + i, (byte) 0);
+            }
+            peer.getOutputStream().write(expected);
+            assertEquals(8, network.readv(fd, buffers, new int[] { 0, 0 }, new int[] { 3, 5 }, 2));
+            for (int i = 0; i < 3; ++i) {
+                assertEquals(expected[i], OSMemory.peekByte(header + i));
+            }
+            for (int i = 0; i < 5; ++i) {
+                assertEquals(expected[3 + i], OSMemory.peekByte(body + i));
+            }
+            peer.close();
+        } finally {
+            OSMemory.free(header);
+            OSMemory.free(body);
+            network.close(fd);
+            serverSocket.close();
+        }
+    }
+
+    public void testSocketStats() throws Exception {
+        final int longsPerOp = 36;
+        final int longsPerFd = 1 + 6 * longsPerOp;
+        final int sendOp = 3;
+        FileDescriptor fd = newBoundDatagramSocket();
+        FileDescriptor otherFd = newBoundDatagramSocket();
+        network.setSocketStatsEnabled(true);
+        try {
+            network.getSocketStats(true);
+            byte[] data = new byte[] { 1, 2, 3 };
+            InetAddress loopback = InetAddress.getByName("127.0.0.1");
+            network.send(fd, data, 0, data.length, network.getSocketLocalPort(otherFd), loopback);
+            network.send(otherFd, data, 0, 1, network.getSocketLocalPort(fd), loopback);
+            network.send(otherFd, data, 0, 1, network.getSocketLocalPort(fd), loopback);
+            long[] stats = network.getSocketStats(false);
+            assertEquals(2 * longsPerFd, stats.length);
+
+            // Each socket's sends are counted against its own fd.
+            for (int record = 0; record < stats.length; record += longsPerFd) {
+                int send = record + 1 + sendOp * longsPerOp;
+                long histogramTotal = 0;
+                for (int i = 4; i < longsPerOp; ++i) {
+                    histogramTotal += stats[send + i];
+                }
+                if (stats[record] == IoUtils.getFd(fd)) {
+                    assertEquals(1, stats[send]);
+                    assertEquals(data.length, stats[send + 1]);
+                    assertEquals(1, histogramTotal);
+                } else {
+                    assertEquals(IoUtils.getFd(otherFd), stats[record]);
+                    assertEquals(2, stats[send]);
+                    assertEquals(2, stats[send + 1]);
+                    assertEquals(2, histogramTotal);
+                }
+            }
+
+            // Resetting drops every fd's record.
+            network.getSocketStats(true);
+            assertEquals(0, network.getSocketStats(false).length);
+        } finally {
+            network.setSocketStatsEnabled(false);
+            network.close(fd);
+            network.close(otherFd);
+        }
+    }
+
+    public void testSendConnected() throws Exception {
+        FileDescriptor fd = newBoundDatagramSocket();
+        try {
+            // Connect the socket to itself, and send with no address.
+            InetAddress loopback = InetAddress.getByName("127.0.0.1");
+            network.connect(fd, loopback, network.getSocketLocalPort(fd), 0);
+            byte[] data = new byte[] { 9, 1, 2, 3, 9 };
+            assertEquals(3, network.sendConnected(fd, data, 1, 3));
+
+            byte[] received = new byte[8];
+            assertEquals(3, network.read(fd, received, 0, received.length));
+            assertEquals(1, received[0]);
+            assertEquals(3, received[2]);
+        } finally {
+            network.close(fd);
+        }
+    }
+}
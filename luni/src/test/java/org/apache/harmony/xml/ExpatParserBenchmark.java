@@ -0,0 +1,341 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.apache.harmony.xml;
+
+import dalvik.system.VMDebug;
+import java.io.ByteArrayInputStream;
+import java.io.IOException;
+import java.io.UnsupportedEncodingException;
+import java.util.ArrayList;
+import java.util.List;
+import javax.xml.parsers.DocumentBuilderFactory;
+import javax.xml.parsers.ParserConfigurationException;
+import org.w3c.dom.Document;
+import org.w3c.dom.Element;
+import org.w3c.dom.Node;
+import org.xml.sax.Attributes;
+import org.xml.sax.InputSource;
+import org.xml.sax.SAXException;
+import org.xml.sax.helpers.DefaultHandler;
+
+/**
+ * Measures the Expat binding end to end over a small corpus of typical
+ * document shapes, for SAX handlers and for a handler building a DOM. For
+ * each pair it reports throughput, events handled, objects allocated and
+ * calls from native code into ExpatParser per document. Not run as part of
+ * the tests; run it with
+ *
+ * <pre>dalvikvm -cp core-tests.jar org.apache.harmony.xml.ExpatParserBenchmark [millis]</pre>
+ *
+ * where {@code millis} is how long to spend on each pair, one second by
+ * default.
+ */
+public final class ExpatParserBenchmark {
+
+    public static void main(String[] args) throws Exception {
+        long millis = (args.length > 0) ? Long.parseLong(args[0]) : 1000;
+
+        List<Corpus> corpora = new ArrayList<Corpus>();
+        corpora.add(new Corpus("small-rpc", smallRpc()));
+        corpora.add(new Corpus("deep", deep(1000)));
+        corpora.add(new Corpus("attributes", attributeHeavy(2000, 20)));
+        corpora.add(new Corpus("text", textHeavy(200)));
+        corpora.add(new Corpus("namespaces", namespaceHeavy(2000, 8)));
+
+        ExpatInternPool internPool = new ExpatInternPool();
+        Consumer[] consumers = {
+                new SaxConsumer("sax", false, null),
+                new SaxConsumer("sax-batched", true, null),
+                new SaxConsumer("sax-pooled", true, internPool),
+                new DomConsumer("dom"),
+        };
+
+        System.out.printf("%-12s %-12s %10s %12s %12s %12s %12s%n", "corpus", "consumer",
+                "MB/s", "events/s", "events/doc", "allocs/doc", "upcalls/doc");
+        for (Corpus corpus : corpora) {
+            for (Consumer consumer : consumers) {
+                Result result = run(consumer, corpus, millis);
+                System.out.printf("%-12s %-12s %10.2f %12.0f %12d %12s %12d%n",
+                        corpus.name, consumer.name,
+                        result.bytes / (result.seconds * 1024 * 1024),
+                        result.events / result.seconds,
+                        result.eventsPerDocument,
+                        (result.allocationsPerDocument >= 0)
+                                ? Long.toString(result.allocationsPerDocument) : "n/a",
+                        result.upcallsPerDocument);
+            }
+        }
+    }
+
+    private static Result run(Consumer consumer, Corpus corpus, long millis) throws Exception {
+        // Warm up, and take the per-document counts from a parse of their own.
+        for (int i = 0; i < 10; i++) {
+            consumer.parse(corpus.xml);
+        }
+        Result result = new Result();
+        long allocations = countAllocations(consumer, corpus.xml);
+        result.allocationsPerDocument = allocations;
+        result.eventsPerDocument = consumer.parse(corpus.xml);
+        result.upcallsPerDocument = consumer.lastUpcallCount;
+
+        long documents = 0;
+        long start = System.nanoTime();
+        long end = start + millis * 1000000L;
+        long now;
+        do {
+            result.events += consumer.parse(corpus.xml);
+            documents++;
+            now = System.nanoTime();
+        } while (now < end);
+        result.seconds = (now - start) / 1e9;
+        result.bytes = documents * corpus.xml.length;
+        return result;
+    }
+
+    /**
+     * Returns the number of objects allocated by this thread while parsing
+     * one document, or -1 if the VM can't tell us.
+     */
+    private static long countAllocations(Consumer consumer, byte[] xml) throws Exception {
+        try {
+            VMDebug.startAllocCounting();
+        } catch (Throwable unsupported) {
+            // VMDebug is Dalvik's; other VMs don't have it.
+            return -1;
+        }
+        try {
+            VMDebug.resetAllocCount(VMDebug.KIND_THREAD_ALLOCATED_OBJECTS);
+            consumer.parse(xml);
+            return VMDebug.getAllocCount(VMDebug.KIND_THREAD_ALLOCATED_OBJECTS);
+        } finally {
+            VMDebug.stopAllocCounting();
+        }
+    }
+
+    private static class Result {
+        double seconds;
+        long bytes;
+        long events;
+        long eventsPerDocument;
+        long allocationsPerDocument;
+        long upcallsPerDocument;
+    }
+
+    private static class Corpus {
+        final String name;
+        final byte[] xml;
+
+        Corpus(String name, String xml) throws UnsupportedEncodingException {
+            this.name = name;
+            this.xml = xml.getBytes("UTF-8");
+        }
+    }
+
+    /**
+     * Parses documents and reports how many events it handled, and how many
+     * upcalls the last parse took.
+     */
+    private abstract static class Consumer {
+        final String name;
+        long lastUpcallCount;
+
+        Consumer(String name) {
+            this.name = name;
+        }
+
+        abstract long parse(byte[] xml) throws Exception;
+
+        void parse(ExpatReader reader, byte[] xml) throws IOException, SAXException {
+            reader.parse(new InputSource(new ByteArrayInputStream(xml)));
+            lastUpcallCount = reader.getLastUpcallCount();
+        }
+    }
+
+    private static class SaxConsumer extends Consumer {
+        private final ExpatReader reader = new ExpatReader();
+        private final CountingHandler handler = new CountingHandler();
+
+        SaxConsumer(String name, boolean batchEvents, ExpatInternPool internPool) {
+            super(name);
+            reader.setContentHandler(handler);
+            reader.setEventBatchingEnabled(batchEvents);
+            reader.setInternPool(internPool);
+        }
+
+        @Override long parse(byte[] xml) throws Exception {
+            handler.events = 0;
+            parse(reader, xml);
+            return handler.events;
+        }
+    }
+
+    private static class CountingHandler extends DefaultHandler {
+        long events;
+
+        @Override public void startElement(String uri, String localName, String qName,
+                Attributes attributes) {
+            // Look at the attributes, as any real handler would.
+            for (int i = 0; i < attributes.getLength(); i++) {
+                attributes.getValue(i);
+            }
+            events++;
+        }
+
+        @Override public void endElement(String uri, String localName, String qName) {
+            events++;
+        }
+
+        @Override public void characters(char[] ch, int start, int length) {
+            events++;
+        }
+
+        @Override public void startPrefixMapping(String prefix, String uri) {
+            events++;
+        }
+
+        @Override public void endPrefixMapping(String prefix) {
+            events++;
+        }
+    }
+
+    private static class DomConsumer extends Consumer {
+        private final ExpatReader reader = new ExpatReader();
+        private final DomBuilder builder;
+
+        DomConsumer(String name) throws ParserConfigurationException {
+            super(name);
+            DocumentBuilderFactory factory = DocumentBuilderFactory.newInstance();
+            factory.setNamespaceAware(true);
+            builder = new DomBuilder(factory);
+            reader.setContentHandler(builder);
+        }
+
+        @Override long parse(byte[] xml) throws Exception {
+            builder.events = 0;
+            parse(reader, xml);
+            return builder.events;
+        }
+    }
+
+    /**
+     * Builds a DOM from SAX events, as an application holding the whole
+     * document in memory would.
+     */
+    private static class DomBuilder extends CountingHandler {
+        private final DocumentBuilderFactory factory;
+        Document document;
+        private Node current;
+
+        DomBuilder(DocumentBuilderFactory factory) {
+            this.factory = factory;
+        }
+
+        @Override public void startDocument() throws SAXException {
+            try {
+                document = factory.newDocumentBuilder().newDocument();
+            } catch (ParserConfigurationException e) {
+                throw new SAXException(e);
+            }
+            current = document;
+        }
+
+        @Override public void startElement(String uri, String localName, String qName,
+                Attributes attributes) {
+            Element element = document.createElementNS(uri, qName);
+            for (int i = 0; i < attributes.getLength(); i++) {
+                element.setAttributeNS(attributes.getURI(i), attributes.getQName(i),
+                        attributes.getValue(i));
+            }
+            current.appendChild(element);
+            current = element;
+            events++;
+        }
+
+        @Override public void endElement(String uri, String localName, String qName) {
+            current = current.getParentNode();
+            events++;
+        }
+
+        @Override public void characters(char[] ch, int start, int length) {
+            current.appendChild(document.createTextNode(new String(ch, start, length)));
+            events++;
+        }
+    }
+
+    /** A small XML-RPC call, as sent by an RPC client. */
+    private static String smallRpc() {
+        return "<?xml version=\"1.0\"?>\n"
+                + "<methodCall><methodName>inventory.lookup</methodName><params>"
+                + "<param><value><string>sku-20394</string></value></param>"
+                + "<param><value><int>42</int></value></param>"
+                + "<param><value><struct>"
+                + "<member><name>warehouse</name><value><string>east</string></value></member>"
+                + "<member><name>reserve</name><value><boolean>1</boolean></value></member>"
+                + "</struct></value></param>"
+                + "</params></methodCall>\n";
+    }
+
+    private static String deep(int depth) {
+        StringBuilder xml = new StringBuilder();
+        for (int i = 0; i < depth; i++) {
+            xml.append("<level d='").append(i).append("'>");
+        }
+        xml.append("bottom");
+        for (int i = 0; i < depth; i++) {
+            xml.append("</level>");
+        }
+        return xml.toString();
+    }
+
+    private static String attributeHeavy(int elements, int attributes) {
+        StringBuilder xml = new StringBuilder("<rows>\n");
+        for (int i = 0; i < elements; i++) {
+            xml.append("<row");
+            for (int j = 0; j < attributes; j++) {
+                xml.append(" column").append(j).append("='").append(i * j).append('\'');
+            }
+            xml.append("/>\n");
+        }
+        return xml.append("</rows>").toString();
+    }
+
+    private static String textHeavy(int paragraphs) {
+        StringBuilder xml = new StringBuilder("<article><title>Text</title>\n");
+        for (int i = 0; i < paragraphs; i++) {
+            xml.append("<p>");
+            for (int j = 0; j < 20; j++) {
+                xml.append("Most of this document is running text, with the odd &amp; "
+                        + "entity and <em>emphasis</em> mixed in. ");
+            }
+            xml.append("</p>\n");
+        }
+        return xml.append("</article>").toString();
+    }
+
+    private static String namespaceHeavy(int elements, int namespaces) {
+        StringBuilder xml = new StringBuilder("<root xmlns='urn:default'>\n");
+        for (int i = 0; i < elements; i++) {
+            int ns = i % namespaces;
+            xml.append("<n").append(ns).append(":item xmlns:n").append(ns)
+                    .append("='urn:example:").append(ns).append("' n").append(ns)
+                    .append(":id='").append(i).append("'><n").append(ns)
+                    .append(":value>").append(i).append("</n").append(ns)
+                    .append(":value></n").append(ns).append(":item>\n");
+        }
+        return xml.append("</root>").toString();
+    }
+}
@@ -31,6 +31,9 @@ import org.xmlpull.v1.XmlPullParser;
 import org.xmlpull.v1.XmlPullParserException;
 
 import java.io.ByteArrayInputStream;
+import java.io.File;
+import java.io.FileInputStream;
+import java.io.FileOutputStream;
 import java.io.IOException;
 import java.io.InputStream;
 import java.io.OutputStream;
@@ -228,6 +231,37 @@ public class ExpatParserTest extends TestCase {
         testPullParserNamespaces(pullParser);
     }
 
+    public void testExpatPullParserAcrossBuffers() throws Exception {
+        // Enough elements and text to span many of the pull parser's buffers.
+        StringBuilder xml = new StringBuilder("<root>");
+        StringBuilder longText = new StringBuilder();
+        for (int i = 0; i < 2000; i++) {
+            xml.append("<item n='").append(i).append("'>a&amp;b\nc</item><empty/>");
+            longText.append("x&lt;").append(i).append(' ');
+        }
+        xml.append(longText).append("</root>");
+
+        XmlPullParser parser = newPullParser();
+        parser.setInput(new StringReader(xml.toString()));
+        assertEquals(XmlPullParser.START_TAG, parser.next());
+        assertEquals("root", parser.getName());
+        for (int i = 0; i < 2000; i++) {
+            assertEquals(XmlPullParser.START_TAG, parser.next());
+            assertEquals("item", parser.getName());
+            assertEquals(String.valueOf(i), parser.getAttributeValue(null, "n"));
+            assertEquals(XmlPullParser.TEXT, parser.next());
+            assertEquals("a&b\nc", parser.getText());
+            assertEquals(XmlPullParser.END_TAG, parser.next());
+            assertEquals(XmlPullParser.START_TAG, parser.next());
+            assertTrue(parser.isEmptyElementTag());
+            assertEquals(XmlPullParser.END_TAG, parser.next());
+        }
+        assertEquals(XmlPullParser.TEXT, parser.next());
+        assertEquals(longText.toString().replace("&lt;", "<"), parser.getText());
+        assertEquals(XmlPullParser.END_TAG, parser.next());
+        assertEquals(XmlPullParser.END_DOCUMENT, parser.next());
+    }
+
     private void testPullParserNamespaces(XmlPullParser parser) throws Exception {
         assertEquals(0, parser.getDepth());
         assertEquals(0, parser.getNamespaceCount(0));
@@ -635,6 +669,276 @@ public class ExpatParserTest extends TestCase {
         }
     }
 
+    public void testManyNames() throws Exception {
+        // Enough distinct names to make the intern table grow several times.
+        StringBuilder xml = new StringBuilder("<root>");
+        for (int i = 0; i < 2000; i++) {
+            xml.append("<e").append(i).append(" a").append(i).append("='v'/>");
+        }
+        xml.append("</root>");
+        List<String> names = parseNames(new ExpatReader(), xml.toString());
+        assertEquals(1 + 2 * 2000, names.size());
+        assertEquals("root", names.get(0));
+        for (int i = 0; i < 2000; i++) {
+            assertEquals("e" + i, names.get(1 + 2 * i));
+            assertEquals("a" + i, names.get(2 + 2 * i));
+        }
+    }
+
+    public void testInternPool() throws Exception {
+        ExpatInternPool pool = new ExpatInternPool();
+        ExpatReader first = new ExpatReader();
+        first.setInternPool(pool);
+        ExpatReader second = new ExpatReader();
+        second.setInternPool(pool);
+        assertSame(pool, second.getInternPool());
+
+        String xml = "<a:feed xmlns:a='http://a/'><a:item id='1'/><b/></a:feed>";
+        List<String> expected = parseNames(new ExpatReader(), xml);
+        for (int i = 0; i < 10; i++) {
+            List<String> names = parseNames((i % 2 == 0) ? first : second, xml);
+            assertEquals(expected, names);
+            for (int j = 0; j < names.size(); j++) {
+                assertSame(expected.get(j), names.get(j));
+            }
+        }
+    }
+
+    /**
+     * Returns the local names of the elements and attributes in {@code xml},
+     * in document order.
+     */
+    private static List<String> parseNames(ExpatReader reader, String xml) throws Exception {
+        final List<String> names = new ArrayList<String>();
+        reader.setContentHandler(new DefaultHandler() {
+            @Override
+            public void startElement(String uri, String localName, String qName,
+                    Attributes attributes) {
+                names.add(localName);
+                for (int i = 0; i < attributes.getLength(); i++) {
+                    names.add(attributes.getLocalName(i));
+                }
+            }
+        });
+        reader.parse(new InputSource(new StringReader(xml)));
+        return names;
+    }
+
+    public void testEventBatching() throws Exception {
+        // Big enough to fill several batches, mixing batched and unbatched events.
+        StringBuilder xml = new StringBuilder("<?xml version='1.0'?><root xmlns:p='http://p/'>");
+        for (int i = 0; i < 3000; i++) {
+            xml.append("<p:item n='").append(i).append("' m='x").append(i).append("'>");
+            xml.append("text ").append(i).append(" &amp; more");
+            if (i % 100 == 0) {
+                xml.append("<!-- comment ").append(i).append(" --><?pi ").append(i).append("?>");
+            }
+            if (i % 250 == 0) {
+                xml.append("<![CDATA[<cdata>]]><q xmlns='http://q/'/>");
+            }
+            xml.append("</p:item>\n");
+        }
+        xml.append("</root>");
+
+        String expected = recordEvents(false, xml.toString());
+        assertEquals(expected, recordEvents(true, xml.toString()));
+        assertTrue(expected.contains("start:http://p/:item:p:item[n=2999,m=x2999]"));
+    }
+
+    private static String recordEvents(boolean batch, String xml) throws Exception {
+        final StringBuilder events = new StringBuilder();
+        DefaultHandler2 handler = new DefaultHandler2() {
+            @Override public void startElement(String uri, String localName, String qName,
+                    Attributes attributes) {
+                events.append("start:").append(uri).append(':').append(localName)
+                        .append(':').append(qName).append('[');
+                for (int i = 0; i < attributes.getLength(); i++) {
+                    events.append(i == 0 ? "" : ",").append(attributes.getQName(i))
+                            .append('=').append(attributes.getValue(i));
+                }
+                events.append("]\n");
+            }
+            @Override public void endElement(String uri, String localName, String qName) {
+                events.append("end:").append(qName).append('\n');
+            }
+            @Override public void characters(char[] ch, int start, int length) {
+                events.append("text:").append(ch, start, length).append('\n');
+            }
+            @Override public void comment(char[] ch, int start, int length) {
+                events.append("comment:").append(ch, start, length).append('\n');
+            }
+            @Override public void processingInstruction(String target, String data) {
+                events.append("pi:").append(target).append(' ').append(data).append('\n');
+            }
+            @Override public void startPrefixMapping(String prefix, String uri) {
+                events.append("prefix:").append(prefix).append('=').append(uri).append('\n');
+            }
+            @Override public void startCDATA() {
+                events.append("cdata\n");
+            }
+        };
+        ExpatReader reader = new ExpatReader();
+        reader.setEventBatchingEnabled(batch);
+        assertEquals(batch, reader.isEventBatchingEnabled());
+        reader.setContentHandler(handler);
+        reader.setLexicalHandler(handler);
+        reader.parse(new InputSource(new StringReader(xml)));
+        return events.toString();
+    }
+
+    public void testUpcallCount() throws Exception {
+        StringBuilder xml = new StringBuilder("<root>");
+        for (int i = 0; i < 50; i++) {
+            xml.append("<item/>");
+        }
+        xml.append("</root>");
+
+        ExpatReader reader = new ExpatReader();
+        reader.parse(new InputSource(new StringReader(xml.toString())));
+        // A start and an end for each element.
+        assertEquals(2 * 51, reader.getLastUpcallCount());
+
+        reader.setEventBatchingEnabled(true);
+        reader.parse(new InputSource(new StringReader(xml.toString())));
+        assertEquals(1, reader.getLastUpcallCount());
+    }
+
+    public void testParseFile() throws Exception {
+        // Large files take several reads into Expat's buffer.
+        for (int count : new int[] { 10, 20000 }) {
+            File file = File.createTempFile("ExpatParserTest", ".xml");
+            file.deleteOnExit();
+            FileOutputStream out = new FileOutputStream(file);
+            out.write("<root>".getBytes("UTF-8"));
+            for (int i = 0; i < count; i++) {
+                out.write(("<item n='" + i + "'>\u00e9l\u00e9ment " + i + "</item>").getBytes("UTF-8"));
+            }
+            out.write("</root>".getBytes("UTF-8"));
+            out.close();
+
+            final int[] items = new int[1];
+            final StringBuilder lastText = new StringBuilder();
+            ExpatReader reader = new ExpatReader();
+            reader.setContentHandler(new DefaultHandler() {
+                @Override public void startElement(String uri, String localName, String qName,
+                        Attributes attributes) {
+                    if (localName.equals("item")) {
+                        assertEquals(Integer.toString(items[0]++), attributes.getValue("n"));
+                        lastText.setLength(0);
+                    }
+                }
+                @Override public void characters(char[] ch, int start, int length) {
+                    lastText.append(ch, start, length);
+                }
+            });
+            FileInputStream in = new FileInputStream(file);
+            reader.parse(new InputSource(in));
+            assertEquals(count, items[0]);
+            assertEquals("\u00e9l\u00e9ment " + (count - 1), lastText.toString());
+        }
+    }
+
+    public void testParseFileMalformed() throws Exception {
+        File file = File.createTempFile("ExpatParserTest", ".xml");
+        file.deleteOnExit();
+        FileOutputStream out = new FileOutputStream(file);
+        out.write("<root><a></b></root>".getBytes("UTF-8"));
+        out.close();
+        try {
+            new ExpatReader().parse(new InputSource(new FileInputStream(file)));
+            fail();
+        } catch (SAXException expected) {
+        }
+    }
+
+    public void testManyAttributes() throws Exception {
+        // Enough attributes to be looked up by hash rather than by scanning.
+        StringBuilder xml = new StringBuilder("<root xmlns:p='http://p/'>");
+        for (int element = 0; element < 2; element++) {
+            xml.append("<e");
+            for (int i = 0; i < 12; i++) {
+                xml.append(i % 3 == 0 ? " p:a" : " a").append(i).append("='v").append(element)
+                        .append('-').append(i).append("'");
+            }
+            xml.append("/>");
+        }
+        xml.append("</root>");
+
+        final int[] elements = new int[1];
+        ExpatReader reader = new ExpatReader();
+        reader.setContentHandler(new DefaultHandler() {
+            @Override public void startElement(String uri, String localName, String qName,
+                    Attributes attributes) {
+                if (!localName.equals("e")) {
+                    return;
+                }
+                int element = elements[0]++;
+                assertEquals(12, attributes.getLength());
+                for (int pass = 0; pass < 2; pass++) {
+                    for (int i = 0; i < 12; i++) {
+                        String expectedValue = "v" + element + "-" + i;
+                        String name = (i % 3 == 0 ? "p:a" : "a") + i;
+                        assertEquals(name, attributes.getQName(i));
+                        assertEquals("a" + i, attributes.getLocalName(i));
+                        assertEquals(i % 3 == 0 ? "http://p/" : "", attributes.getURI(i));
+                        assertEquals(expectedValue, attributes.getValue(i));
+                        assertEquals(i, attributes.getIndex(name));
+                        // Without a prefix, a qualified name matches on the local name.
+                        assertEquals(i, attributes.getIndex("a" + i));
+                        assertEquals(expectedValue, attributes.getValue(name));
+                        assertEquals(expectedValue, attributes.getValue(attributes.getURI(i),
+                                "a" + i));
+                    }
+                }
+                assertEquals(-1, attributes.getIndex("q:a0"));
+                assertEquals(-1, attributes.getIndex("a12"));
+                assertNull(attributes.getValue("a12"));
+            }
+        });
+        reader.parse(new InputSource(new StringReader(xml.toString())));
+        assertEquals(2, elements[0]);
+    }
+
+    public void testParserReuse() throws Exception {
+        // Each parse recycles its parser, so later ones pick up parsers that have
+        // seen other documents, including ones that failed halfway.
+        final Locator[] locator = new Locator[1];
+        final StringBuilder events = new StringBuilder();
+        DefaultHandler handler = new DefaultHandler() {
+            @Override public void setDocumentLocator(Locator l) {
+                locator[0] = l;
+            }
+            @Override public void startElement(String uri, String localName, String qName,
+                    Attributes attributes) {
+                events.append('<').append(uri).append(',').append(localName).append(',')
+                        .append(qName).append(',').append(attributes.getValue("a")).append('>');
+            }
+            @Override public void characters(char[] ch, int start, int length) {
+                events.append(ch, start, length);
+            }
+        };
+        for (int i = 0; i < 20; i++) {
+            boolean namespaces = (i % 2 == 0);
+            ExpatReader reader = new ExpatReader();
+            reader.setFeature("http://xml.org/sax/features/namespaces", namespaces);
+            reader.setContentHandler(handler);
+            events.setLength(0);
+            if (i % 3 == 0) {
+                try {
+                    reader.parse(new InputSource(new StringReader("<x:a xmlns:x='u'><b>")));
+                    fail();
+                } catch (SAXException expected) {
+                }
+                continue;
+            }
+            byte[] xml = ("<x:a xmlns:x='u' a='" + i + "'>t" + i + "</x:a>").getBytes("UTF-8");
+            reader.parse(new InputSource(new ByteArrayInputStream(xml)));
+            String expected = namespaces ? "<u,a,x:a," + i + ">t" + i : "<,,x:a," + i + ">t" + i;
+            assertEquals(expected, events.toString());
+            assertEquals(-1, locator[0].getLineNumber());
+        }
+    }
+
     public void testProcessingInstructions() throws IOException, SAXException {
         Reader in = new StringReader(
             "<?bob lee?><a></a>");
@@ -650,6 +954,33 @@ public class ExpatParserTest extends TestCase {
         assertEquals("lee", handler.data);
     }
 
+    public void testSupplementaryCharacters() throws IOException, SAXException {
+        // U+1F600 takes four bytes in UTF-8, which modified UTF-8 doesn't allow.
+        String smiley = "\ud83d\ude00";
+        Reader in = new StringReader("<?bob " + smiley + "?><a b='" + smiley + "'>"
+                + smiley + "</a>");
+
+        ExpatReader reader = new ExpatReader();
+        final StringBuilder text = new StringBuilder();
+        final String[] value = new String[1];
+        TestProcessingInstrutionHandler handler = new TestProcessingInstrutionHandler() {
+            @Override public void startElement(String uri, String localName, String qName,
+                    Attributes attributes) {
+                value[0] = attributes.getValue("b");
+            }
+            @Override public void characters(char[] ch, int start, int length) {
+                text.append(ch, start, length);
+            }
+        };
+        reader.setContentHandler(handler);
+
+        reader.parse(new InputSource(in));
+
+        assertEquals(smiley, handler.data);
+        assertEquals(smiley, value[0]);
+        assertEquals(smiley, text.toString());
+    }
+
     static class TestProcessingInstrutionHandler extends DefaultHandler2 {
 
         String target;
@@ -726,6 +1057,64 @@ public class ExpatParserTest extends TestCase {
         assertEquals("bob", handler.text.toString().trim());
     }
 
+    public void testEntityCache() throws IOException, SAXException {
+        final int[] resolved = new int[2];
+        final StringBuilder text = new StringBuilder();
+        DefaultHandler handler = new DefaultHandler() {
+            @Override public InputSource resolveEntity(String publicId, String systemId)
+                    throws IOException {
+                if (systemId.equals("chars.ent")) {
+                    resolved[0]++;
+                    return new InputSource(new StringReader("<a>chars</a>"));
+                }
+                resolved[1]++;
+                InputSource inputSource = new InputSource(
+                        new ByteArrayInputStream("<b>bytes</b>".getBytes("UTF-8")));
+                inputSource.setEncoding("UTF-8");
+                return inputSource;
+            }
+            @Override public void characters(char[] ch, int start, int length) {
+                text.append(ch, start, length);
+            }
+        };
+        String xml = "<!DOCTYPE foo [\n"
+                + "  <!ENTITY a SYSTEM 'chars.ent'>\n"
+                + "  <!ENTITY b PUBLIC 'publicB' 'bytes.ent'>\n"
+                + "]><foo>&a;&b;&a;</foo>";
+
+        ExpatEntityCache entityCache = new ExpatEntityCache();
+        for (int i = 0; i < 3; i++) {
+            ExpatReader reader = new ExpatReader();
+            reader.setContentHandler(handler);
+            reader.setEntityResolver(handler);
+            reader.setEntityCache(entityCache);
+            text.setLength(0);
+            reader.parse(new InputSource(new StringReader(xml)));
+            assertEquals("charsbyteschars", text.toString());
+        }
+        assertEquals(1, resolved[0]);
+        assertEquals(1, resolved[1]);
+
+        // Once an entity is removed, or reported stale, it's resolved again.
+        entityCache.remove(null, "chars.ent");
+        ExpatReader reader = new ExpatReader();
+        reader.setEntityResolver(handler);
+        reader.setEntityCache(entityCache);
+        reader.parse(new InputSource(new StringReader(xml)));
+        assertEquals(2, resolved[0]);
+        assertEquals(1, resolved[1]);
+
+        reader.setEntityCache(new ExpatEntityCache() {
+            @Override protected boolean isStale(String publicId, String systemId,
+                    long loadedAtMillis) {
+                return true;
+            }
+        });
+        reader.parse(new InputSource(new StringReader(xml)));
+        assertEquals(4, resolved[0]);
+        assertEquals(2, resolved[1]);
+    }
+
     public void testExternalEntityDownload() throws IOException, SAXException {
         class Server implements Runnable {
 
@@ -42,6 +42,7 @@ import javax.net.ssl.SSLException;
 import javax.net.ssl.SSLProtocolException;
 import javax.security.auth.x500.X500Principal;
 import junit.framework.TestCase;
+import org.apache.harmony.luni.platform.OSMemory;
 import org.apache.harmony.xnet.provider.jsse.NativeCrypto.SSLHandshakeCallbacks;
 
 public class NativeCryptoTest extends TestCase {
@@ -70,6 +71,86 @@ public class NativeCryptoTest extends TestCase {
         assertEquals(Arrays.deepToString(expected), Arrays.deepToString(actual));
     }
 
+    public void test_CRYPTO_get_lock_stats() throws Exception {
+        NativeCrypto.CRYPTO_set_lock_stats_enabled(true);
+        try {
+            long[] before = NativeCrypto.CRYPTO_get_lock_stats();
+            assertNotNull(before);
+            assertEquals(0, before.length % 2);
+            // Creating a context takes the SSL_CTX lock among others
+            int c = NativeCrypto.SSL_CTX_new();
+            NativeCrypto.SSL_CTX_free(c);
+            long[] after = NativeCrypto.CRYPTO_get_lock_stats();
+            assertEquals(before.length, after.length);
+            long acquired = 0;
+            for (int i = 0; i < after.length; i += 2) {
+                assertTrue(after[i + 1] <= after[i]);
+                acquired += after[i] - before[i];
+            }
+            assertTrue(acquired > 0);
+            assertNotNull(NativeCrypto.CRYPTO_get_lock_name(1));
+        } finally {
+            NativeCrypto.CRYPTO_set_lock_stats_enabled(false);
+        }
+    }
+
+    public void test_EVP_Digest_batch() throws Exception {
+        byte[] buffer = "abcdefghijklmnopqrstuvwxyz".getBytes("US-ASCII");
+        int[] offsets = new int[] { 0, 3, 10, 26 };
+        int[] lengths = new int[] { 3, 7, 16, 0 };
+        java.security.MessageDigest md = java.security.MessageDigest.getInstance("SHA-1");
+        byte[] out = new byte[offsets.length * md.getDigestLength()];
+
+        int size = NativeCrypto.EVP_Digest_batch("sha1", buffer, offsets, lengths, out);
+        assertEquals(md.getDigestLength(), size);
+        for (int i = 0; i < offsets.length; i++) {
+            md.update(buffer, offsets[i], lengths[i]);
+            assertEqualByteArrays(md.digest(),
+                                  Arrays.copyOfRange(out, i * size, (i + 1) * size));
+        }
+
+        try {
+            NativeCrypto.EVP_Digest_batch("sha1", buffer, new int[] { 20 }, new int[] { 7 }, out);
+            fail();
+        } catch (IndexOutOfBoundsException expected) {
+        }
+        try {
+            NativeCrypto.EVP_Digest_batch("sha1", buffer, offsets, lengths, new byte[size]);
+            fail();
+        } catch (IndexOutOfBoundsException expected) {
+        }
+    }
+
+    public void test_EVP_DigestUpdateDirect() throws Exception {
+        byte[] data = "abcdefghijklmnopqrstuvwxyz".getBytes("US-ASCII");
+        java.nio.ByteBuffer direct = java.nio.ByteBuffer.allocateDirect(data.length);
+        direct.put(data);
+        direct.position(5);
+
+        java.security.MessageDigest md = new OpenSSLMessageDigestJDK.SHA1();
+        md.update(direct);
+        assertEquals(data.length, direct.position());
+        byte[] actual = md.digest();
+
+        md.update(data, 5, data.length - 5);
+        assertEqualByteArrays(md.digest(), actual);
+    }
+
+    public void test_SSL_ephemeral_key_pool_configure() throws Exception {
+        try {
+            NativeCrypto.SSL_ephemeral_key_pool_configure(-1, null);
+            fail();
+        } catch (IllegalArgumentException expected) {
+        }
+        try {
+            NativeCrypto.SSL_ephemeral_key_pool_configure(60, new int[] { 0 });
+            fail();
+        } catch (IllegalArgumentException expected) {
+        }
+        NativeCrypto.SSL_ephemeral_key_pool_configure(0, null);
+        NativeCrypto.SSL_ephemeral_key_pool_configure(3600, new int[] { 512 });
+    }
+
     public void test_SSL_CTX_new() throws Exception {
         int c = NativeCrypto.SSL_CTX_new();
         assertTrue(c != NULL);
@@ -706,6 +787,41 @@ public class NativeCryptoTest extends TestCase {
         assertTrue(serverCallback.handshakeCompletedCalled);
     }
 
+    public void test_SSL_do_handshake_nonblocking() throws Exception {
+        final ServerSocket listener = new ServerSocket(0);
+        Hooks sHooks = new ServerHooks(SERVER_PRIVATE_KEY, SERVER_CERTIFICATES);
+        Future<TestSSLHandshakeCallbacks> server = handshake(listener, 0, false, sHooks);
+
+        Hooks cHooks = new Hooks();
+        Socket socket = new Socket(listener.getInetAddress(), listener.getLocalPort());
+        FileDescriptor fd = NativeCrypto.getFileDescriptor(socket);
+        int c = cHooks.getContext();
+        int s = cHooks.beforeHandshake(c);
+        NativeCrypto.SSL_clear_mode(s, NativeCrypto.SSL_MODE_HANDSHAKE_CUTTHROUGH);
+        TestSSLHandshakeCallbacks clientCallback = new TestSSLHandshakeCallbacks(s, cHooks);
+
+        // Drive the handshake from this thread, polling rather than blocking
+        int steps = 0;
+        int result;
+        while ((result = NativeCrypto.SSL_do_handshake_nonblocking(s, fd, clientCallback, true))
+                != NativeCrypto.SSL_ERROR_NONE) {
+            assertTrue(result == NativeCrypto.SSL_ERROR_WANT_READ
+                       || result == NativeCrypto.SSL_ERROR_WANT_WRITE);
+            assertTrue(++steps < TIMEOUT_SECONDS * 100);
+            Thread.sleep(10);
+        }
+        int session = NativeCrypto.SSL_get1_session(s);
+        assertTrue(session != NULL);
+
+        TestSSLHandshakeCallbacks serverCallback = server.get(TIMEOUT_SECONDS, TimeUnit.SECONDS);
+        assertTrue(clientCallback.verifyCertificateChainCalled);
+        assertEqualCertificateChains(SERVER_CERTIFICATES,
+                                     clientCallback.asn1DerEncodedCertificateChain);
+        assertTrue(clientCallback.handshakeCompletedCalled);
+        assertTrue(serverCallback.handshakeCompletedCalled);
+        cHooks.afterHandshake(session, s, c, socket, fd, clientCallback);
+    }
+
     public void test_SSL_do_handshake_missing_required_certificate() throws Exception {
         // required client certificate negative case
         final ServerSocket listener = new ServerSocket(0);
@@ -1101,6 +1217,42 @@ public class NativeCryptoTest extends TestCase {
         server.get(TIMEOUT_SECONDS, TimeUnit.SECONDS);
     }
 
+    public void test_SSL_get_peer_cert_fingerprints() throws Exception {
+        try {
+            NativeCrypto.SSL_get_peer_cert_fingerprints(NULL, "sha1");
+            fail();
+        } catch (NullPointerException expected) {
+        }
+
+        final ServerSocket listener = new ServerSocket(0);
+
+        Hooks cHooks = new Hooks() {
+            @Override
+            public void afterHandshake(int session, int s, int c,
+                                       Socket sock, FileDescriptor fd,
+                                       SSLHandshakeCallbacks callback)
+                    throws Exception {
+                byte[][] fingerprints = NativeCrypto.SSL_get_peer_cert_fingerprints(s, "sha1");
+                assertEquals(SERVER_CERTIFICATES.length, fingerprints.length);
+                java.security.MessageDigest md = new OpenSSLMessageDigestJDK.SHA1();
+                for (int i = 0; i < SERVER_CERTIFICATES.length; i++) {
+                    assertEqualByteArrays(md.digest(SERVER_CERTIFICATES[i]), fingerprints[i]);
+                }
+                // The second call is served from the cached encoding
+                assertEqualCertificateChains(SERVER_CERTIFICATES,
+                                             NativeCrypto.SSL_get_peer_cert_chain(s));
+                assertEqualCertificateChains(SERVER_CERTIFICATES,
+                                             NativeCrypto.SSL_get_peer_cert_chain(s));
+                super.afterHandshake(session, s, c, sock, fd, callback);
+            }
+        };
+        Hooks sHooks = new ServerHooks(SERVER_PRIVATE_KEY, SERVER_CERTIFICATES);
+        Future<TestSSLHandshakeCallbacks> client = handshake(listener, 0, true, cHooks);
+        Future<TestSSLHandshakeCallbacks> server = handshake(listener, 0, false, sHooks);
+        client.get(TIMEOUT_SECONDS, TimeUnit.SECONDS);
+        server.get(TIMEOUT_SECONDS, TimeUnit.SECONDS);
+    }
+
     public void test_SSL_read_byte() throws Exception {
         try {
             NativeCrypto.SSL_read_byte(NULL, null, null, 0);
@@ -1343,6 +1495,89 @@ public class NativeCryptoTest extends TestCase {
         }
     }
 
+    public void test_SSL_read_direct_and_SSL_write_direct() throws Exception {
+        final ServerSocket listener = new ServerSocket(0);
+        Hooks cHooks = new Hooks() {
+            @Override
+            public void afterHandshake(int session, int s, int c,
+                                       Socket sock, FileDescriptor fd,
+                                       SSLHandshakeCallbacks callback)
+                    throws Exception {
+                int address = OSMemory.malloc(BYTES.length);
+                try {
+                    assertEquals(BYTES.length,
+                                 NativeCrypto.SSL_read_direct(s, fd, callback, address,
+                                                              BYTES.length, 0));
+                    for (int i = 0; i < BYTES.length; i++) {
+                        assertEquals(BYTES[i], OSMemory.peekByte(address + i));
+                    }
+                } finally {
+                    OSMemory.free(address);
+                }
+                super.afterHandshake(session, s, c, sock, fd, callback);
+            }
+        };
+        Hooks sHooks = new ServerHooks(SERVER_PRIVATE_KEY, SERVER_CERTIFICATES) {
+            @Override
+            public void afterHandshake(int session, int s, int c,
+                                       Socket sock, FileDescriptor fd,
+                                       SSLHandshakeCallbacks callback)
+                    throws Exception {
+                int address = OSMemory.malloc(BYTES.length);
+                try {
+                    for (int i = 0; i < BYTES.length; i++) {
+                        OSMemory.pokeByte(address + i, BYTES[i]);
+                    }
+                    NativeCrypto.SSL_write_direct(s, fd, callback, address, BYTES.length);
+                } finally {
+                    OSMemory.free(address);
+                }
+                super.afterHandshake(session, s, c, sock, fd, callback);
+            }
+        };
+        Future<TestSSLHandshakeCallbacks> client = handshake(listener, 0, true, cHooks);
+        Future<TestSSLHandshakeCallbacks> server = handshake(listener, 0, false, sHooks);
+        client.get(TIMEOUT_SECONDS, TimeUnit.SECONDS);
+        server.get(TIMEOUT_SECONDS, TimeUnit.SECONDS);
+    }
+
+    public void test_SSL_write_gathering() throws Exception {
+        final ServerSocket listener = new ServerSocket(0);
+        Hooks cHooks = new Hooks() {
+            @Override
+            public void afterHandshake(int session, int s, int c,
+                                       Socket sock, FileDescriptor fd,
+                                       SSLHandshakeCallbacks callback)
+                    throws Exception {
+                // The buffers were coalesced into one record, so one read gets them all.
+                byte[] in = new byte[256];
+                assertEquals(BYTES.length,
+                             NativeCrypto.SSL_read(s, fd, callback, in, 0, in.length, 0));
+                for (int i = 0; i < BYTES.length; i++) {
+                    assertEquals(BYTES[i], in[i]);
+                }
+                super.afterHandshake(session, s, c, sock, fd, callback);
+            }
+        };
+        Hooks sHooks = new ServerHooks(SERVER_PRIVATE_KEY, SERVER_CERTIFICATES) {
+            @Override
+            public void afterHandshake(int session, int s, int c,
+                                       Socket sock, FileDescriptor fd,
+                                       SSLHandshakeCallbacks callback)
+                    throws Exception {
+                byte[][] buffers = new byte[][] { BYTES, BYTES };
+                int[] offsets = new int[] { 0, 2 };
+                int[] lengths = new int[] { 2, BYTES.length - 2 };
+                NativeCrypto.SSL_write_gathering(s, fd, callback, buffers, offsets, lengths);
+                super.afterHandshake(session, s, c, sock, fd, callback);
+            }
+        };
+        Future<TestSSLHandshakeCallbacks> client = handshake(listener, 0, true, cHooks);
+        Future<TestSSLHandshakeCallbacks> server = handshake(listener, 0, false, sHooks);
+        client.get(TIMEOUT_SECONDS, TimeUnit.SECONDS);
+        server.get(TIMEOUT_SECONDS, TimeUnit.SECONDS);
+    }
+
     public void test_SSL_write_byte() throws Exception {
         try {
             NativeCrypto.SSL_write_byte(NULL, null, null, 0);
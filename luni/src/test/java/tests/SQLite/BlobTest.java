@@ -34,6 +34,8 @@ import tests.support.Support_SQL;
 import java.io.IOException;
 import java.io.InputStream;
 import java.io.OutputStream;
+import java.nio.ByteBuffer;
+import java.nio.ReadOnlyBufferException;
 
 @TestTargetClass(Blob.class)
 public class BlobTest extends SQLiteTest {
@@ -151,6 +153,76 @@ public class BlobTest extends SQLiteTest {
         }
     }
 
+    /**
+     * @tests Blob#write(ByteBuffer, int)
+     * @tests Blob#read(ByteBuffer, int)
+     */
+    @TestTargets ( {
+    @TestTargetNew(
+        level = TestLevel.NOT_FEASIBLE,
+        notes = "db.open_blob is not supported, therefore cannot test Blobs",
+        method = "write",
+        args = {ByteBuffer.class, int.class}
+    ),
+    @TestTargetNew(
+        level = TestLevel.NOT_FEASIBLE,
+        notes = "db.open_blob is not supported, therefore cannot test Blobs",
+        method = "read",
+        args = {ByteBuffer.class, int.class}
+    )
+    })
+    @KnownFailure("db.open_blob is not supported.")
+    public void testByteBuffers() throws Exception, IOException {
+        Blob blob = db.open_blob(dbFile.getPath(), "B", "val", 1, true);
+        try {
+            ByteBuffer direct = ByteBuffer.allocateDirect(100);
+            for (int i = 0; i < 100; i++) {
+                direct.put((byte) i);
+            }
+            direct.flip();
+            assertEquals(100, blob.write(direct, 0));
+            assertFalse(direct.hasRemaining());
+
+            // Reads stop at the end of the 128 byte blob.
+            ByteBuffer heap = ByteBuffer.allocate(64);
+            assertEquals(28, blob.read(heap, 100));
+            heap.clear();
+            assertEquals(-1, blob.read(heap, 128));
+
+            direct.clear();
+            direct.position(10);
+            assertEquals(90, blob.read(direct, 10));
+            assertEquals(100, direct.position());
+            assertEquals(99, direct.get(99));
+        } finally {
+            blob.close();
+        }
+    }
+
+    /**
+     * @tests Blob#read(ByteBuffer, int)
+     */
+    @TestTargetNew(
+        level = TestLevel.PARTIAL_COMPLETE,
+        notes = "Exception test; runs without incremental blob I/O",
+        method = "read",
+        args = {ByteBuffer.class, int.class}
+    )
+    public void testReadIntoReadOnlyByteBuffer() throws Exception, IOException {
+        // Reads are refused before they reach SQLite, so this needs no open blob.
+        Blob blob = new Blob() {{ size = 128; }};
+        try {
+            blob.read(ByteBuffer.allocate(64).asReadOnlyBuffer(), 0);
+            fail("Exception not thrown for read-only heap buffer.");
+        } catch (ReadOnlyBufferException expected) {
+        }
+        try {
+            blob.read(ByteBuffer.allocateDirect(64).asReadOnlyBuffer(), 0);
+            fail("Exception not thrown for read-only direct buffer.");
+        } catch (ReadOnlyBufferException expected) {
+        }
+    }
+
     /**
      * @tests Blob#finalize()
      */
@@ -39,6 +39,8 @@ import java.sql.SQLException;
 import java.sql.Statement;
 
 import SQLite.Authorizer;
+import SQLite.Backup;
+import SQLite.BackupProgress;
 import SQLite.Blob;
 import SQLite.BusyHandler;
 import SQLite.Callback;
@@ -47,6 +49,8 @@ import SQLite.Database;
 import SQLite.Exception;
 import SQLite.Function;
 import SQLite.FunctionContext;
+import SQLite.PackedCallback;
+import SQLite.PackedRows;
 import SQLite.ProgressHandler;
 import SQLite.Stmt;
 import SQLite.TableResult;
@@ -56,6 +60,8 @@ import SQLite.Vm;
 import java.util.ArrayList;
 import java.util.Arrays;
 import java.util.List;
+import java.util.concurrent.Future;
+import java.util.concurrent.TimeUnit;
 import java.util.logging.Logger;
 
 @TestTargetClass(Database.class)
@@ -1565,6 +1571,124 @@ public class DatabaseTest extends SQLiteTest {
 
     }
 
+    /**
+     * @tests {@link Database#exec_packed(String, PackedCallback, byte[])}
+     */
+    @TestTargetNew(
+        level = TestLevel.COMPLETE,
+        notes = "method test",
+        method = "exec_packed",
+        args = {java.lang.String.class, PackedCallback.class, byte[].class}
+    )
+    public void testExec_packed() throws Exception {
+        db.exec("create table packed (i, t)", null);
+        for (int i = 0; i < 10; i++) {
+            db.exec("insert into packed values (" + i + ", 'row" + i + "')", null);
+        }
+        final List<String> columns = new ArrayList<String>();
+        final List<Integer> batches = new ArrayList<Integer>();
+        final StringBuilder values = new StringBuilder();
+        PackedCallback cb = new PackedCallback() {
+            public void columns(String[] coldata) {
+                columns.addAll(Arrays.asList(coldata));
+            }
+            public boolean newrows(byte[] buf, int nrows) {
+                batches.add(nrows);
+                PackedRows rows = new PackedRows(buf);
+                try {
+                    for (int r = 0; r < nrows; r++) {
+                        values.append(rows.column_long()).append(rows.column_string()).append(' ');
+                    }
+                } catch (Exception e) {
+                    throw new RuntimeException(e);
+                }
+                return false;
+            }
+        };
+        // Each row packs into 1+8 + 1+4+4 bytes, so 50 bytes hold 2 of them.
+        db.exec_packed("select i, t from packed order by i", cb, new byte[50]);
+        assertEquals(Arrays.asList("i", "t"), columns);
+        assertEquals(Arrays.asList(2, 2, 2, 2, 2), batches);
+        assertEquals("0row0 1row1 2row2 3row3 4row4 5row5 6row6 7row7 8row8 9row9 ",
+                values.toString());
+
+        try {
+            db.exec_packed("select * from nosuch", cb, new byte[50]);
+            fail();
+        } catch (Exception expected) {
+        }
+        try {
+            db.exec_packed("select zeroblob(100)", cb, new byte[50]);
+            fail("row doesn't fit");
+        } catch (Exception expected) {
+        }
+    }
+
+    /**
+     * @tests {@link Database#stmt_cache_size(int)}
+     * @tests {@link Database#stmt_cache_stats(long[])}
+     */
+    @TestTargets({
+        @TestTargetNew(
+            level = TestLevel.COMPLETE,
+            notes = "method test",
+            method = "stmt_cache_size",
+            args = {int.class}
+        ),
+        @TestTargetNew(
+            level = TestLevel.COMPLETE,
+            notes = "method test",
+            method = "stmt_cache_stats",
+            args = {long[].class}
+        )
+    })
+    public void testStmt_cache() throws Exception {
+        long[] before = new long[3];
+        long[] after = new long[3];
+        String sql = "select ?";
+        db.stmt_cache_size(0);
+        db.stmt_cache_size(4);
+        db.stmt_cache_stats(before);
+        assertEquals(0, before[2]);
+
+        Stmt st = db.prepare(sql);
+        st.bind(1, 10);
+        assertTrue(st.step());
+        assertEquals(10, st.column_int(0));
+        st.close();
+        db.stmt_cache_stats(after);
+        assertEquals(before[1] + 1, after[1]);
+        assertEquals(1, after[2]);
+
+        // The same text gets the cached statement back, with its bindings cleared.
+        st = db.prepare(sql);
+        db.stmt_cache_stats(after);
+        assertEquals(before[0] + 1, after[0]);
+        assertEquals(0, after[2]);
+        // A second copy while the first is in use is prepared separately.
+        Stmt st2 = db.prepare(sql);
+        db.stmt_cache_stats(after);
+        assertEquals(before[1] + 2, after[1]);
+        assertTrue(st.step());
+        assertNull(st.column(0));
+        st.close();
+        st2.close();
+
+        // exec() of a single statement uses the cache too.
+        db.exec("delete from " + DatabaseCreator.SIMPLE_TABLE1, null);
+        db.exec("delete from " + DatabaseCreator.SIMPLE_TABLE1, null);
+        db.stmt_cache_stats(after);
+        assertEquals(before[0] + 2, after[0]);
+
+        // Shrinking the cache finalizes what doesn't fit.
+        db.stmt_cache_size(1);
+        db.stmt_cache_stats(after);
+        assertEquals(1, after[2]);
+        db.stmt_cache_size(0);
+        db.stmt_cache_stats(after);
+        assertEquals(0, after[2]);
+    }
+
     /**
      * @throws Exception
      * @throws java.lang.Exception
@@ -1638,6 +1762,48 @@ public class DatabaseTest extends SQLiteTest {
             is.close();
     }
 
+    /**
+     * @tests {@link Database#backup(Database, String, String)}
+     */
+    @TestTargetNew(
+        level = TestLevel.PARTIAL_COMPLETE,
+        notes = "paced backup on a background thread",
+        method = "backup",
+        args = {Database.class, String.class, String.class}
+    )
+    @KnownFailure("The backup API isn't compiled in (HAVE_SQLITE3_BACKUPAPI is unset).")
+    public void testBackup_start_paced() throws java.lang.Exception {
+        for (int i = 0; i < numOfRecords; i++) {
+            db.exec("insert into " + DatabaseCreator.SIMPLE_TABLE1 + " values(" + i + ", "
+                    + i + ", " + i + ")", null);
+        }
+        Database dest = new Database();
+        dest.open(":memory:", 0);
+        try {
+            final List<Integer> remainingPages = new ArrayList<Integer>();
+            final Thread testThread = Thread.currentThread();
+            Backup backup = db.backup(dest, "main", "main");
+            Future<Boolean> result = backup.start_paced(1, 1, new BackupProgress() {
+                public boolean progress(int remaining, int pagecount) {
+                    assertNotSame(testThread, Thread.currentThread());
+                    synchronized (remainingPages) {
+                        remainingPages.add(remaining);
+                    }
+                    return true;
+                }
+            });
+            assertTrue(result.get(10, TimeUnit.SECONDS));
+            synchronized (remainingPages) {
+                assertFalse(remainingPages.isEmpty());
+                assertEquals(0, (int) remainingPages.get(remainingPages.size() - 1));
+            }
+            TableResult rows = dest.get_table("select * from " + DatabaseCreator.SIMPLE_TABLE1);
+            assertEquals(numOfRecords, rows.nrows);
+        } finally {
+            dest.close();
+        }
+    }
+
     /**
      * @tests {@link Database#is3()}
      */
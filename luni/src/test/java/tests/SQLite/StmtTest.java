@@ -19,6 +19,7 @@ package tests.SQLite;
 import SQLite.Constants;
 import SQLite.Database;
 import SQLite.Exception;
+import SQLite.PackedRows;
 import SQLite.Stmt;
 import SQLite.TableResult;
 import dalvik.annotation.BrokenTest;
@@ -237,6 +238,120 @@ public class StmtTest extends SQLiteTest {
 
     }
 
+    /**
+     * @tests {@link Stmt#step_many(int, byte[])}
+     */
+    @TestTargetNew(
+        level = TestLevel.COMPLETE,
+        notes = "method test",
+        method = "step_many",
+        args = {int.class, byte[].class}
+    )
+    public void testStep_many() throws Exception {
+        db.exec("create table packed (i, f, t, b)", null);
+        db.exec("insert into packed values (" + Long.MIN_VALUE
+                + ", 2.5, 'h\u00e9llo', x'00ff')", null);
+        db.exec("insert into packed values (null, null, '', x'')", null);
+        db.exec("insert into packed values (7, -0.0, null, null)", null);
+
+        st = db.prepare("select * from packed");
+        // Room for the first row (1+8, 1+8, 1+4+6, 1+4+2) but not the second.
+        byte[] buf = new byte[36];
+        assertEquals(1, st.step_many(10, buf));
+        PackedRows rows = new PackedRows(buf);
+        assertEquals(Long.MIN_VALUE, rows.column_long());
+        assertEquals(2.5, rows.column_double());
+        assertEquals("h\u00e9llo", rows.column_string());
+        assertTrue(java.util.Arrays.equals(new byte[] { 0, (byte) 0xff }, rows.column_bytes()));
+
+        // The second row was kept for the next call.
+        buf = new byte[1024];
+        assertEquals(2, st.step_many(10, buf));
+        rows = new PackedRows(buf);
+        assertEquals(Constants.SQLITE_NULL, rows.type());
+        assertNull(rows.column());
+        assertNull(rows.column());
+        assertEquals("", rows.column());
+        assertEquals(0, ((byte[]) rows.column()).length);
+        assertEquals(Long.valueOf(7), rows.column());
+        assertEquals(Double.doubleToLongBits(-0.0),
+                Double.doubleToLongBits(rows.column_double()));
+        assertNull(rows.column_string());
+        assertNull(rows.column_bytes());
+        assertEquals(0, st.step_many(10, buf));
+
+        // A row that can't fit at all is an error, and is still there for step().
+        st.reset();
+        try {
+            st.step_many(10, new byte[8]);
+            fail();
+        } catch (Exception expected) {
+        }
+        assertTrue(st.step());
+        assertEquals(Long.MIN_VALUE, st.column_long(0));
+    }
+
+    /**
+     * @tests {@link Stmt#execute_batch(int, Object[], boolean)}
+     */
+    @TestTargetNew(
+        level = TestLevel.COMPLETE,
+        notes = "method test",
+        method = "execute_batch",
+        args = {int.class, Object[].class, boolean.class}
+    )
+    public void testExecute_batch() throws Exception {
+        db.exec("create table batch (i, j, d, t, b unique)", null);
+        st = db.prepare("insert into batch values (?, ?, ?, ?, ?)");
+        Object[] columns = {
+            new int[] { 1, 2, 3 },
+            new long[] { Long.MAX_VALUE, -1, 0 },
+            new double[] { 1.5, 2.5, 3.5 },
+            new String[] { "one", null, "" },
+            new byte[][] { null, { 1, 2 }, {} },
+        };
+        assertEquals(3, st.execute_batch(3, columns, true));
+
+        Stmt check = db.prepare("select * from batch order by i");
+        assertTrue(check.step());
+        assertEquals(1, check.column_int(0));
+        assertEquals(Long.MAX_VALUE, check.column_long(1));
+        assertEquals(1.5, check.column_double(2));
+        assertEquals("one", check.column_string(3));
+        assertEquals(Constants.SQLITE_NULL, check.column_type(4));
+        assertTrue(check.step());
+        assertEquals(Constants.SQLITE_NULL, check.column_type(3));
+        assertTrue(java.util.Arrays.equals(new byte[] { 1, 2 }, check.column_bytes(4)));
+        assertTrue(check.step());
+        assertEquals("", check.column_string(3));
+        assertEquals(0, check.column_bytes(4).length);
+        assertFalse(check.step());
+        check.close();
+
+        // A failing row rolls back the whole batch.
+        columns[4] = new byte[][] { { 9 }, { 1, 2 } };
+        try {
+            st.execute_batch(2, columns, true);
+            fail();
+        } catch (Exception expected) {
+        }
+        check = db.prepare("select count(*) from batch");
+        assertTrue(check.step());
+        assertEquals(3, check.column_int(0));
+        check.close();
+
+        try {
+            st.execute_batch(4, columns, false);
+            fail("columns are too short");
+        } catch (Exception expected) {
+        }
+        try {
+            st.execute_batch(1, new Object[] { new float[1] }, false);
+            fail("float[] isn't supported");
+        } catch (Exception expected) {
+        }
+    }
+
     /**
      * @tests {@link Stmt#close()}
      */
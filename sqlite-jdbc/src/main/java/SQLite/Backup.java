@@ -1,5 +1,9 @@
 package SQLite;
 
+import java.util.concurrent.Callable;
+import java.util.concurrent.Future;
+import java.util.concurrent.FutureTask;
+
 /**
  * Class wrapping an SQLite backup object.
  */
@@ -62,6 +66,78 @@ public class Backup {
 	}
     }
 
+    /**
+     * Perform the backup n pages at a time, sleeping interval
+     * milliseconds after each step, so that writers to the source
+     * database are only locked out while a step copies its pages.
+     * Runs on the calling thread; see start_paced to run it on a
+     * thread of its own. Every step takes this object's lock on its
+     * own, so remaining() and pagecount() can be used from other
+     * threads in between.
+     *
+     * @param n number of pages to backup per step
+     * @param interval milliseconds to sleep between steps
+     * @param progress if not null, invoked after each step
+     * @return true when backup completed, false if stopped by
+     * progress or by interrupting the calling thread
+     */
+
+    public boolean step_paced(int n, int interval, BackupProgress progress)
+	throws SQLite.Exception {
+	for (;;) {
+	    boolean done;
+	    int remaining, pagecount;
+	    synchronized(this) {
+		done = _step(n);
+		remaining = _remaining();
+		pagecount = _pagecount();
+	    }
+	    if (progress != null && !progress.progress(remaining, pagecount)
+		&& !done) {
+		return false;
+	    }
+	    if (done) {
+		return true;
+	    }
+	    try {
+		Thread.sleep(interval);
+	    } catch (InterruptedException e) {
+		Thread.currentThread().interrupt();
+		return false;
+	    }
+	}
+    }
+
+    /**
+     * Perform the backup as step_paced does, but on a new daemon
+     * thread, so that the caller can carry on while it runs. Cancel
+     * the returned future, allowing interruption, to stop the backup
+     * after its current step. Its get() returns the result of
+     * step_paced, or throws an ExecutionException wrapping the
+     * SQLite.Exception that ended the backup. Both databases must
+     * stay open until the future is done.
+     *
+     * @param n number of pages to backup per step
+     * @param interval milliseconds to sleep between steps
+     * @param progress if not null, invoked on the backup thread
+     * after each step
+     * @return future for the result of step_paced
+     */
+
+    public Future<Boolean> start_paced(final int n, final int interval,
+				       final BackupProgress progress) {
+	FutureTask<Boolean> task =
+	    new FutureTask<Boolean>(new Callable<Boolean>() {
+		public Boolean call() throws SQLite.Exception {
+		    return step_paced(n, interval, progress);
+		}
+	    });
+	Thread thread = new Thread(task, "SQLite paced backup");
+	thread.setDaemon(true);
+	thread.start();
+	return task;
+    }
+
     /**
      * Return number of remaining pages to be backed up.
      */
@@ -0,0 +1,20 @@
+package SQLite;
+
+/**
+ * Callback interface for the progress of a paced backup, see
+ * <A HREF="Backup.html#step_paced(int, int, SQLite.BackupProgress)">Backup.step_paced</A>.
+ */
+
+public interface BackupProgress {
+
+    /**
+     * Invoked after each backup step.
+     * The method should return true to continue the
+     * backup, or false in order to stop it for now.<BR><BR>
+     *
+     * @param remaining number of pages still to be backed up
+     * @param pagecount total number of pages in the source database
+     */
+
+    public boolean progress(int remaining, int pagecount);
+}
@@ -1,6 +1,8 @@
 package SQLite;
 
 import java.io.*;
+import java.nio.ByteBuffer;
+import java.nio.ReadOnlyBufferException;
 
 /**
  * Internal class implementing java.io.InputStream on
@@ -305,6 +307,72 @@ public class Blob {
 
     native int read(byte[] b, int off, int pos, int len) throws IOException;
 
+    /**
+     * Write the remaining bytes of a buffer to the blob at pos,
+     * advancing the buffer's position. The data of a direct buffer
+     * goes straight to SQLite without being copied to a byte array.
+     * @param buf buffer to be written
+     * @param pos offset into blob
+     * @return number of bytes written to blob
+     */
+
+    public int write(ByteBuffer buf, int pos) throws IOException {
+	int len = buf.remaining();
+	int n;
+	if (buf.isDirect()) {
+	    n = write_direct(buf, buf.position(), pos, len);
+	} else if (buf.hasArray()) {
+	    n = write(buf.array(), buf.arrayOffset() + buf.position(), pos,
+		      len);
+	} else {
+	    byte b[] = new byte[len];
+	    buf.duplicate().get(b);
+	    n = write(b, 0, pos, len);
+	}
+	buf.position(buf.position() + n);
+	return n;
+    }
+
+    /**
+     * Read blob data at pos into a buffer, up to its limit or the end
+     * of the blob, advancing the buffer's position. A direct buffer
+     * is filled straight from SQLite without a copy through a byte
+     * array, so large blobs can be streamed to a channel.
+     * @param buf buffer to be filled
+     * @param pos offset into blob
+     * @return number of bytes read from blob, -1 at end of blob
+     * @throws ReadOnlyBufferException if buf is read-only
+     */
+
+    public int read(ByteBuffer buf, int pos) throws IOException {
+	if (buf.isReadOnly()) {
+	    throw new ReadOnlyBufferException();
+	}
+	int len = Math.min(buf.remaining(), size - pos);
+	if (len <= 0) {
+	    return buf.hasRemaining() ? -1 : 0;
+	}
+	int n;
+	if (buf.isDirect()) {
+	    n = read_direct(buf, buf.position(), pos, len);
+	} else if (buf.hasArray()) {
+	    n = read(buf.array(), buf.arrayOffset() + buf.position(), pos,
+		     len);
+	} else {
+	    byte b[] = new byte[len];
+	    n = read(b, 0, pos, len);
+	    buf.duplicate().put(b, 0, n);
+	}
+	buf.position(buf.position() + n);
+	return n;
+    }
+
+    private native int write_direct(ByteBuffer b, int off, int pos, int len)
+	throws IOException;
+
+    private native int read_direct(ByteBuffer b, int off, int pos, int len)
+	throws IOException;
+
     /**
      * Destructor for object.
      */
@@ -214,6 +214,29 @@ public class Database {
     private native void _exec(String sql, SQLite.Callback cb, String args[])
 	throws SQLite.Exception;
 
+    /**
+     * Execute an SQL statement and report its result rows in
+     * batches, packed into buf as by
+     * <A HREF="Stmt.html#step_many(int, byte[])">Stmt.step_many</A>,
+     * instead of as one String per column value. Only available in
+     * SQLite 3.0 and above.
+     *
+     * @param sql the SQL statement to be executed
+     * @param cb the object implementing the callback methods
+     * @param buf buffer to pack rows into, reused for each batch
+     */
+
+    public void exec_packed(String sql, SQLite.PackedCallback cb,
+			    byte buf[]) throws SQLite.Exception {
+	synchronized(this) {
+	    _exec_packed(sql, cb, buf);
+	}
+    }
+
+    private native void _exec_packed(String sql, SQLite.PackedCallback cb,
+				     byte buf[])
+	throws SQLite.Exception;
+
     /**
      * Return the row identifier of the last inserted
      * row.
@@ -669,6 +692,42 @@ public class Database {
 
     private native int _db_status(int op, int info[], boolean flag);
 
+    /**
+     * Set the number of idle prepared statements kept for reuse.
+     * Statements made by prepare() and single statements run by
+     * exec() are cached by their SQL text once closed, and handed
+     * out again instead of being parsed anew. They are reset and
+     * their bindings are cleared on the way back. Zero turns the
+     * cache off; the default is 16. Only available in SQLite 3.0
+     * and above.
+     *
+     * @param n max. number of idle statements to keep
+     */
+
+    public void stmt_cache_size(int n) throws SQLite.Exception {
+	synchronized(this) {
+	    _stmt_cache_size(n);
+	}
+    }
+
+    private native void _stmt_cache_size(int n) throws SQLite.Exception;
+
+    /**
+     * Return statement cache statistics since the database was opened.
+     *
+     * @param stats output buffer, must be able to hold three
+     *              values (hits/misses/idle statements)
+     */
+
+    public void stmt_cache_stats(long stats[]) throws SQLite.Exception {
+	synchronized(this) {
+	    _stmt_cache_stats(stats);
+	}
+    }
+
+    private native void _stmt_cache_stats(long stats[])
+	throws SQLite.Exception;
+
     /**
      * Compile and return SQLite VM for SQL statement. Only available
      * in SQLite 2.8.0 and above, otherwise a no-op.
@@ -0,0 +1,59 @@
+package SQLite;
+
+/**
+ * Callback interface for query results delivered in batches of
+ * packed rows by
+ * <A HREF="Database.html#exec_packed(java.lang.String, SQLite.PackedCallback, byte[])">Database.exec_packed</A>.
+ * Column values arrive as UTF-8 bytes or binary numbers with their
+ * type codes, so no String is made unless the callback asks for one.
+ * <BR><BR>
+ * Example:<BR>
+ *
+ * <PRE>
+ *   class Counter implements SQLite.PackedCallback {
+ *     int ncol, total;
+ *     public void columns(String cols[]) {
+ *       ncol = cols.length;
+ *     }
+ *     public boolean newrows(byte buf[], int nrows) {
+ *       PackedRows rows = new PackedRows(buf);
+ *       for (int r = 0; r &lt; nrows; r++) {
+ *         for (int c = 0; c &lt; ncol; c++) {
+ *           if (rows.type() == SQLite.Constants.SQLITE_INTEGER) {
+ *             total += rows.column_long();
+ *           } else {
+ *             rows.column();
+ *           }
+ *         }
+ *       }
+ *       return false;
+ *     }
+ *   }
+ * </PRE>
+ */
+
+public interface PackedCallback {
+
+    /**
+     * Reports column names of the query result.
+     * This method is invoked first (and once) when
+     * the SQLite engine returns the result set.<BR><BR>
+     *
+     * @param coldata string array holding the column names
+     */
+
+    public void columns(String coldata[]);
+
+    /**
+     * Reports a batch of rows of the query result, packed into
+     * the buffer given to exec_packed() in the format read by
+     * <A HREF="PackedRows.html">PackedRows</A>. The buffer is
+     * reused for the next batch once this method returns. If true
+     * is returned the running SQLite query is aborted.<BR><BR>
+     *
+     * @param buf buffer holding the packed rows
+     * @param nrows number of rows in buf
+     */
+
+    public boolean newrows(byte buf[], int nrows);
+}
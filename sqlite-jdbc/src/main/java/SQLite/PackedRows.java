@@ -0,0 +1,172 @@
+package SQLite;
+
+import java.nio.charset.Charsets;
+
+/**
+ * Class to read back the rows packed by
+ * <A HREF="Stmt.html#step_many(int, byte[])">Stmt.step_many</A>.
+ * Values are read in order, row by row and column by column;
+ * the caller knows the column count from Stmt.column_count().
+ * <BR><BR>
+ * Example:<BR>
+ * <PRE>
+ *   ...
+ *   byte buf[] = new byte[65536];
+ *   int ncol = s.column_count();
+ *   int nrows;
+ *   while ((nrows = s.step_many(1000, buf)) > 0) {
+ *     PackedRows rows = new PackedRows(buf);
+ *     for (int r = 0; r &lt; nrows; r++) {
+ *       for (int c = 0; c &lt; ncol; c++) {
+ *         Object o = rows.column();
+ *         ...
+ *       }
+ *     }
+ *   }
+ * </PRE>
+ */
+
+public class PackedRows {
+
+    /**
+     * Buffer filled by Stmt.step_many().
+     */
+
+    private final byte buf[];
+
+    /**
+     * Position of the next value's type code.
+     */
+
+    private int pos;
+
+    /**
+     * Construct reader positioned at the first value in buf.
+     * @param buf buffer filled by Stmt.step_many()
+     */
+
+    public PackedRows(byte buf[]) {
+	this.buf = buf;
+	this.pos = 0;
+    }
+
+    /**
+     * Return type of the next value without consuming it.
+     * @return column type code, e.g. SQLite.Constants.SQLITE_INTEGER
+     */
+
+    public int type() {
+	return buf[pos];
+    }
+
+    /**
+     * Retrieve next value as long, which must be an integer or NULL.
+     * @return long value, 0 for NULL
+     */
+
+    public long column_long() throws SQLite.Exception {
+	switch (buf[pos]) {
+	case Constants.SQLITE_INTEGER:
+	    pos++;
+	    return readLong();
+	case Constants.SQLITE_NULL:
+	    pos++;
+	    return 0;
+	}
+	throw new SQLite.Exception("not an integer column");
+    }
+
+    /**
+     * Retrieve next value as double, which must be a number or NULL.
+     * @return double value, 0 for NULL
+     */
+
+    public double column_double() throws SQLite.Exception {
+	switch (buf[pos]) {
+	case Constants.SQLITE_FLOAT:
+	    pos++;
+	    return Double.longBitsToDouble(readLong());
+	case Constants.SQLITE_INTEGER:
+	    pos++;
+	    return readLong();
+	case Constants.SQLITE_NULL:
+	    pos++;
+	    return 0;
+	}
+	throw new SQLite.Exception("not a numeric column");
+    }
+
+    /**
+     * Retrieve next value as String, which must be text or NULL.
+     * @return String value or null
+     */
+
+    public String column_string() throws SQLite.Exception {
+	switch (buf[pos]) {
+	case Constants.SQLITE3_TEXT:
+	    pos++;
+	    int n = readInt();
+	    String s = new String(buf, pos, n, Charsets.UTF_8);
+	    pos += n;
+	    return s;
+	case Constants.SQLITE_NULL:
+	    pos++;
+	    return null;
+	}
+	throw new SQLite.Exception("not a text column");
+    }
+
+    /**
+     * Retrieve next value as byte array, which must be a blob or NULL.
+     * @return byte[] value or null
+     */
+
+    public byte[] column_bytes() throws SQLite.Exception {
+	switch (buf[pos]) {
+	case Constants.SQLITE_BLOB:
+	    pos++;
+	    int n = readInt();
+	    byte b[] = new byte[n];
+	    System.arraycopy(buf, pos, b, 0, n);
+	    pos += n;
+	    return b;
+	case Constants.SQLITE_NULL:
+	    pos++;
+	    return null;
+	}
+	throw new SQLite.Exception("not a blob column");
+    }
+
+    /**
+     * Retrieve next value as object, as Stmt.column() would.
+     * @return Long, Double, String, byte[] or null
+     */
+
+    public Object column() throws SQLite.Exception {
+	switch (buf[pos]) {
+	case Constants.SQLITE_INTEGER:
+	    return Long.valueOf(column_long());
+	case Constants.SQLITE_FLOAT:
+	    return new Double(column_double());
+	case Constants.SQLITE_BLOB:
+	    return column_bytes();
+	case Constants.SQLITE3_TEXT:
+	    return column_string();
+	}
+	pos++;
+	return null;
+    }
+
+    private int readInt() {
+	int x = ((buf[pos] & 0xff) << 24) | ((buf[pos + 1] & 0xff) << 16)
+	    | ((buf[pos + 2] & 0xff) << 8) | (buf[pos + 3] & 0xff);
+	pos += 4;
+	return x;
+    }
+
+    private long readLong() {
+	long hi = readInt();
+	long lo = readInt() & 0xffffffffL;
+	return (hi << 32) | lo;
+    }
+}
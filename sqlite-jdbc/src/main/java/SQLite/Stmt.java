@@ -68,6 +68,60 @@ public class Stmt {
 
     public native boolean step() throws SQLite.Exception;
 
+    /**
+     * Perform up to maxrows steps of compiled SQLite3 statement,
+     * packing the column values of each row into buf rather than
+     * leaving them to be fetched a column at a time. Use a
+     * <A HREF="PackedRows.html">PackedRows</A> to read them back.
+     * <BR><BR>
+     * Each value is a type code byte (e.g.
+     * SQLite.Constants.SQLITE_INTEGER) followed by an 8 byte big
+     * endian long for SQLITE_INTEGER, an 8 byte big endian double for
+     * SQLITE_FLOAT, a 4 byte big endian length and that many bytes of
+     * UTF-8 text or blob data for SQLITE3_TEXT and SQLITE_BLOB, and
+     * nothing for SQLITE_NULL.
+     * <BR><BR>
+     * A row that doesn't fit in what's left of buf is kept for the
+     * next call to step_many() or step().
+     *
+     * @param maxrows maximum number of rows to pack
+     * @param buf buffer to pack rows into
+     * @return number of rows packed, 0 at end of result set
+     * @throws SQLite.Exception if a single row doesn't fit in buf
+     */
+
+    public native int step_many(int maxrows, byte[] buf)
+	throws SQLite.Exception;
+
+    /**
+     * Execute compiled SQLite3 statement once per row of parameter
+     * values, binding, stepping and resetting it for each row in one
+     * call instead of one call per parameter.
+     * <BR><BR>
+     * columns[i] holds the values of parameter i + 1, one per row,
+     * and must be an int[], long[], double[], String[] or byte[][];
+     * null elements of the last two are bound as NULL. Parameters
+     * after columns.length keep their current bindings. Any result
+     * rows are discarded.
+     * <BR><BR>
+     * Example:<BR>
+     * <PRE>
+     *   Stmt s = db.prepare("insert into t values (?, ?)");
+     *   s.execute_batch(ids.length, new Object[] { ids, names }, true);
+     *   s.close();
+     * </PRE>
+     *
+     * @param nrows number of rows to execute
+     * @param columns parameter values, column by column
+     * @param transaction if true and no transaction is active, all
+     * rows are executed in one transaction, rolled back on error
+     * @return number of rows executed
+     */
+
+    public native int execute_batch(int nrows, Object columns[],
+				    boolean transaction)
+	throws SQLite.Exception;
+
     /**
      * Close the compiled SQLite3 statement.
      */
@@ -4,6 +4,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <pthread.h>
 
 #if HAVE_SQLITE2
 #include "sqlite.h"
@@ -70,6 +71,12 @@ typedef struct {
 #endif
 #if HAVE_SQLITE3
     sqlite3_stmt *stmt;		/* For callback() */
+    struct hstc *stmtcache;	/* idle prepared statements, MRU first */
+    int stmtcache_n;		/* number of entries in stmtcache */
+    int stmtcache_max;		/* capacity of stmtcache */
+    jlong stmtcache_hits;	/* lookups found in stmtcache */
+    jlong stmtcache_misses;	/* lookups that had to prepare */
+    pthread_mutex_t stmtcache_lock; /* Stmt.close() isn't synchronized */
 #endif
 #if HAVE_SQLITE3 && HAVE_SQLITE3_INCRBLOBIO
     struct hbl *blobs;		/* SQLite3 blob handles */
@@ -79,6 +86,18 @@ typedef struct {
 #endif
 } handle;
 
+#if HAVE_SQLITE3
+/* internal entry of prepared statement cache, keyed by SQL text */
+
+typedef struct hstc {
+    struct hstc *next;		/* next (less recently used) entry */
+    sqlite3_stmt *stmt;		/* idle SQLite3 statement */
+    int is16;			/* true if key is UTF-16 */
+    int key_len;		/* length of key in bytes */
+    char key[1];		/* SQL text, not NUL terminated */
+} hstc;
+#endif
+
 /* internal handle for SQLite user defined function */
 
 typedef struct hfunc {
@@ -107,6 +126,9 @@ typedef struct hvm {
     int tail_len;		/* only for SQLite3/prepare */
     handle *h;			/* SQLite database handle */
     handle hh;			/* fake SQLite database handle */
+    int row_pending;		/* stepped row not yet packed by step_many */
+    char *key;			/* statement cache key or 0 */
+    int key_len;		/* length of key in bytes */
 } hvm;
 #endif
 
@@ -770,6 +792,208 @@ callback(void *udata, int ncol, char **data, char **cols)
     return 0;
 }
 
+#if HAVE_SQLITE3
+/*
+ * Prepared statement cache: each handle keeps up to stmtcache_max
+ * idle statements, most recently used first. A statement is taken
+ * out of the cache while in use and put back, reset and with its
+ * bindings cleared, when it's done with.
+ */
+
+static void
+stmtcache_trim(handle *h, int max)
+{
+    hstc *e, **ep;
+
+    pthread_mutex_lock(&h->stmtcache_lock);
+    while (h->stmtcache_n > max) {
+	for (ep = &h->stmtcache; (*ep)->next; ep = &(*ep)->next) {
+	}
+	e = *ep;
+	*ep = 0;
+	h->stmtcache_n--;
+	sqlite3_finalize(e->stmt);
+	free(e);
+    }
+    pthread_mutex_unlock(&h->stmtcache_lock);
+}
+
+static sqlite3_stmt *
+stmtcache_get(handle *h, int is16, const void *key, int key_len)
+{
+    hstc *e, **ep;
+    sqlite3_stmt *stmt = 0;
+
+    if (h->stmtcache_max <= 0) {
+	return 0;
+    }
+    pthread_mutex_lock(&h->stmtcache_lock);
+    for (ep = &h->stmtcache; (e = *ep); ep = &e->next) {
+	if (e->is16 == is16 && e->key_len == key_len &&
+	    memcmp(e->key, key, key_len) == 0) {
+	    *ep = e->next;
+	    h->stmtcache_n--;
+	    stmt = e->stmt;
+	    free(e);
+	    break;
+	}
+    }
+    /* without the _v2 prepares, a schema change invalidates it */
+    if (stmt && sqlite3_expired(stmt)) {
+	sqlite3_finalize(stmt);
+	stmt = 0;
+    }
+    if (stmt) {
+	h->stmtcache_hits++;
+    } else {
+	h->stmtcache_misses++;
+    }
+    pthread_mutex_unlock(&h->stmtcache_lock);
+    return stmt;
+}
+
+/* returns the result of sqlite3_reset(), like sqlite3_finalize() would */
+
+static int
+stmtcache_put(handle *h, sqlite3_stmt *stmt, int is16,
+	      const void *key, int key_len)
+{
+    hstc *e;
+    int ret = sqlite3_reset(stmt);
+
+    if (h->stmtcache_max <= 0 || !(e = malloc(sizeof (hstc) + key_len))) {
+	sqlite3_finalize(stmt);
+	return ret;
+    }
+#if HAVE_SQLITE3_CLEAR_BINDINGS
+    sqlite3_clear_bindings(stmt);
+#else
+    {
+	int i, n = sqlite3_bind_parameter_count(stmt);
+
+	for (i = 1; i <= n; i++) {
+	    sqlite3_bind_null(stmt, i);
+	}
+    }
+#endif
+    e->stmt = stmt;
+    e->is16 = is16;
+    e->key_len = key_len;
+    memcpy(e->key, key, key_len);
+    pthread_mutex_lock(&h->stmtcache_lock);
+    e->next = h->stmtcache;
+    h->stmtcache = e;
+    h->stmtcache_n++;
+    pthread_mutex_unlock(&h->stmtcache_lock);
+    stmtcache_trim(h, h->stmtcache_max);
+    return ret;
+}
+
+/* true if the remaining SQL after a prepare is only white space */
+
+static int
+onlyspace(const char *s, int len)
+{
+    while (len > 0 && *s) {
+	if (!strchr(" \t\n\r\f\v", *s)) {
+	    return 0;
+	}
+	s++;
+	len--;
+    }
+    return 1;
+}
+
+static int
+onlyspace16(const jchar *s, int len)
+{
+    while (len > 0 && *s) {
+	if (*s > ' ' || !strchr(" \t\n\r\f\v", (char) *s)) {
+	    return 0;
+	}
+	s++;
+	len--;
+    }
+    return 1;
+}
+
+/*
+ * sqlite3_exec() of a single statement through the statement cache.
+ * Returns -1, having done nothing, for anything else; otherwise an
+ * SQLite result code, with *err set as sqlite3_exec() would.
+ */
+
+static int
+execcached(handle *h, const char *sql, char **err)
+{
+    sqlite3_stmt *stmt;
+    const char *tail = 0, *semi;
+    char **data;
+    int ret, ncol, i, len = strlen(sql);
+
+    /* statements after ';' would need sqlite3_exec(), don't try twice */
+    semi = strchr(sql, ';');
+    if (h->stmtcache_max <= 0 ||
+	(semi && !onlyspace(semi + 1, len))) {
+	return -1;
+    }
+    stmt = stmtcache_get(h, 0, sql, len);
+    if (!stmt) {
+#if HAVE_SQLITE3_PREPARE_V2
+	ret = sqlite3_prepare_v2((sqlite3 *) h->sqlite, sql, len, &stmt,
+				 &tail);
+#else
+	ret = sqlite3_prepare((sqlite3 *) h->sqlite, sql, len, &stmt, &tail);
+#endif
+	if (ret != SQLITE_OK || !stmt ||
+	    !onlyspace(tail, len - (tail - sql))) {
+	    /* let sqlite3_exec() report errors and run the rest */
+	    if (stmt) {
+		sqlite3_finalize(stmt);
+	    }
+	    return -1;
+	}
+    }
+    ncol = sqlite3_column_count(stmt);
+    data = malloc(2 * (ncol + 1) * sizeof (char *));
+    if (!data) {
+	sqlite3_finalize(stmt);
+	return -1;
+    }
+    while ((ret = sqlite3_step(stmt)) == SQLITE_ROW) {
+	for (i = 0; i < ncol; i++) {
+	    data[i] = (char *) sqlite3_column_text(stmt, i);
+	    data[ncol + 1 + i] = (char *) sqlite3_column_name(stmt, i);
+	}
+	data[ncol] = data[2 * ncol + 1] = 0;
+	if (callback(h, ncol, data, data + ncol + 1)) {
+	    ret = SQLITE_ABORT;
+	    break;
+	}
+    }
+    free(data);
+    if (ret == SQLITE_DONE) {
+	ret = SQLITE_OK;
+    } else if (ret == SQLITE_ABORT) {
+	*err = sqlite3_mprintf("callback requested query abort");
+    } else {
+	/* the legacy interface gives the real error code on reset */
+	i = sqlite3_reset(stmt);
+	if (i != SQLITE_OK) {
+	    ret = i;
+	}
+	if (ret == SQLITE_SCHEMA) {
+	    /* changed by another connection, sqlite3_exec() reprepares */
+	    sqlite3_finalize(stmt);
+	    return -1;
+	}
+	*err = sqlite3_mprintf("%s", sqlite3_errmsg((sqlite3 *) h->sqlite));
+    }
+    stmtcache_put(h, stmt, 0, sql, len);
+    return ret;
+}
+#endif
+
 static void
 doclose(JNIEnv *env, jobject obj, int final)
 {
@@ -808,6 +1032,9 @@ doclose(JNIEnv *env, jobject obj, int final)
 		v->vm = 0;
 	    }
 	}
+#endif
+#if HAVE_SQLITE3
+	stmtcache_trim(h, 0);
 #endif
 	if (h->sqlite) {
 #if HAVE_BOTH_SQLITE
@@ -868,6 +1095,9 @@ doclose(JNIEnv *env, jobject obj, int final)
 	delglobrefp(env, &h->tr);
 	delglobrefp(env, &h->ph);
 	delglobrefp(env, &h->enc);
+#if HAVE_SQLITE3
+	pthread_mutex_destroy(&h->stmtcache_lock);
+#endif
 	free(h);
 	(*env)->SetLongField(env, obj, F_SQLite_Database_handle, 0);
 	return;
@@ -1068,6 +1298,9 @@ Java_SQLite_Database__1open4(JNIEnv *env, jobject obj, jstring file, jint mode,
 
     if (h) {
 	if (h->sqlite) {
+#if HAVE_SQLITE3
+	    stmtcache_trim(h, 0);
+#endif
 #if HAVE_BOTH_SQLITE
 	    if (h->is3) {
 		sqlite3_close((sqlite3 *) h->sqlite);
@@ -1113,6 +1346,13 @@ Java_SQLite_Database__1open4(JNIEnv *env, jobject obj, jstring file, jint mode,
 #if HAVE_SQLITE_COMPILE
 	h->vms = 0;
 #endif
+#if HAVE_SQLITE3
+	h->stmtcache = 0;
+	h->stmtcache_n = 0;
+	h->stmtcache_max = 16;
+	h->stmtcache_hits = h->stmtcache_misses = 0;
+	pthread_mutex_init(&h->stmtcache_lock, 0);
+#endif
 #if HAVE_SQLITE3 && HAVE_SQLITE3_INCRBLOBIO
 	h->blobs = 0;
 #endif
@@ -1375,8 +1615,11 @@ Java_SQLite_Database__1exec__Ljava_lang_String_2LSQLite_Callback_2
 	    }
 #if HAVE_BOTH_SQLITE
 	    if (h->is3) {
-		rc = sqlite3_exec((sqlite3 *) h->sqlite, sqlstr.result,
-				  callback, h, &err);
+		rc = execcached(h, sqlstr.result, &err);
+		if (rc < 0) {
+		    rc = sqlite3_exec((sqlite3 *) h->sqlite, sqlstr.result,
+				      callback, h, &err);
+		}
 		freeproc = (freemem *) sqlite3_free;
 	    } else {
 		rc = sqlite_exec((sqlite *) h->sqlite, sqlstr.result,
@@ -1390,8 +1633,11 @@ Java_SQLite_Database__1exec__Ljava_lang_String_2LSQLite_Callback_2
 	    freeproc = (freemem *) sqlite_freemem;
 #endif
 #if HAVE_SQLITE3
-	    rc = sqlite3_exec((sqlite3 *) h->sqlite, sqlstr.result,
-			      callback, h, &err);
+	    rc = execcached(h, sqlstr.result, &err);
+	    if (rc < 0) {
+		rc = sqlite3_exec((sqlite3 *) h->sqlite, sqlstr.result,
+				  callback, h, &err);
+	    }
 	    freeproc = (freemem *) sqlite3_free;
 #endif
 #endif
@@ -3000,6 +3246,7 @@ Java_SQLite_Vm_compile(JNIEnv *env, jobject obj)
 	v->vm = svm;
 	v->tail = (char *) tail;
 	v->hh.row1 = 1;
+	v->row_pending = 0;
 	return JNI_TRUE;
     }
     throwex(env, "vm already closed");
@@ -3152,6 +3399,8 @@ Java_SQLite_Database_vm_1compile(JNIEnv *env, jobject obj, jstring sql,
     strcpy(v->tail, tail);
     v->hh.sqlite = 0;
     v->hh.haveutf = h->haveutf;
+    v->row_pending = 0;
+    v->key = 0;
     v->hh.ver = h->ver;
     v->hh.bh = v->hh.cb = v->hh.ai = v->hh.tr = v->hh.ph = 0;
     v->hh.row1 = 1;
@@ -3358,6 +3607,8 @@ Java_SQLite_Database_vm_1compile_1args(JNIEnv *env,
 	    sqlite3_free(s);
 	    v->hh.sqlite = 0;
 	    v->hh.haveutf = h->haveutf;
+	    v->row_pending = 0;
+	    v->key = 0;
 	    v->hh.ver = h->ver;
 	    v->hh.bh = v->hh.cb = v->hh.ai = v->hh.tr = v->hh.ph = 0;
 	    v->hh.row1 = 1;
@@ -3485,8 +3736,14 @@ Java_SQLite_Stmt_prepare(JNIEnv *env, jobject obj)
     int ret;
 
     if (v && v->vm) {
-	sqlite3_finalize((sqlite3_stmt *) v->vm);
+	if (v->key && v->h) {
+	    stmtcache_put(v->h, (sqlite3_stmt *) v->vm, 1,
+			  v->key, v->key_len);
+	} else {
+	    sqlite3_finalize((sqlite3_stmt *) v->vm);
+	}
 	v->vm = 0;
+	v->key = 0;
     }
     if (v && v->h && v->h->sqlite) {
 	if (!v->tail) {
@@ -3523,6 +3780,7 @@ Java_SQLite_Stmt_prepare(JNIEnv *env, jobject obj)
 	v->vm = svm;
 	v->tail = (char *) tail;
 	v->hh.row1 = 1;
+	v->row_pending = 0;
 	return JNI_TRUE;
     }
     throwex(env, "stmt already closed");
@@ -3541,9 +3799,9 @@ Java_SQLite_Database_stmt_1prepare(JNIEnv *env, jobject obj, jstring sql,
     void *svm = 0;
     hvm *v;
     jvalue vv;
-    jsize len16;
+    jsize len16, key_len;
     const jchar *sql16, *tail = 0;
-    int ret;
+    int ret, cache;
 
     if (!h) {
 	throwclosed(env);
@@ -3569,13 +3827,22 @@ Java_SQLite_Database_stmt_1prepare(JNIEnv *env, jobject obj, jstring sql,
     }
     h->env = env;
     sql16 = (*env)->GetStringChars(env, sql, 0);
+    key_len = len16;
+    svm = stmtcache_get(h, 1, sql16, key_len);
+    if (svm) {
+	/* only single statements are cached, there's no tail */
+	tail = sql16 + key_len / sizeof (jchar);
+	ret = SQLITE_OK;
+    } else {
 #if HAVE_SQLITE3_PREPARE16_V2
-    ret = sqlite3_prepare16_v2((sqlite3 *) h->sqlite, sql16, len16,
-			       (sqlite3_stmt **) &svm, (const void **) &tail);
+	ret = sqlite3_prepare16_v2((sqlite3 *) h->sqlite, sql16, len16,
+				   (sqlite3_stmt **) &svm,
+				   (const void **) &tail);
 #else
-    ret = sqlite3_prepare16((sqlite3 *) h->sqlite, sql16, len16,
-			    (sqlite3_stmt **) &svm, (const void **) &tail);
+	ret = sqlite3_prepare16((sqlite3 *) h->sqlite, sql16, len16,
+				(sqlite3_stmt **) &svm, (const void **) &tail);
 #endif
+    }
     if (ret != SQLITE_OK) {
 	if (svm) {
 	    sqlite3_finalize((sqlite3_stmt *) svm);
@@ -3598,7 +3865,9 @@ Java_SQLite_Database_stmt_1prepare(JNIEnv *env, jobject obj, jstring sql,
     if (len16 < sizeof (jchar)) {
 	len16 = sizeof (jchar);
     }
-    v = malloc(sizeof (hvm) + len16);
+    cache = h->stmtcache_max > 0 &&
+	onlyspace16(tail, len16 / sizeof (jchar) - 1);
+    v = malloc(sizeof (hvm) + len16 + (cache ? key_len : 0));
     if (!v) {
 	(*env)->ReleaseStringChars(env, sql, sql16);
 	sqlite3_finalize((sqlite3_stmt *) svm);
@@ -3614,11 +3883,19 @@ Java_SQLite_Database_stmt_1prepare(JNIEnv *env, jobject obj, jstring sql,
     v->is3 = v->hh.is3 = 1;
 #endif
     memcpy(v->tail, tail, len16);
+    if (cache) {
+	v->key = v->tail + len16;
+	v->key_len = key_len;
+	memcpy(v->key, sql16, key_len);
+    } else {
+	v->key = 0;
+    }
     len16 /= sizeof (jchar);
     ((jchar *) v->tail)[len16 - 1] = 0;
     (*env)->ReleaseStringChars(env, sql, sql16);
     v->hh.sqlite = 0;
     v->hh.haveutf = h->haveutf;
+    v->row_pending = 0;
     v->hh.ver = h->ver;
     v->hh.bh = v->hh.cb = v->hh.ai = v->hh.tr = v->hh.ph = 0;
     v->hh.row1 = 1;
@@ -3643,6 +3920,11 @@ Java_SQLite_Stmt_step(JNIEnv *env, jobject obj)
     if (v && v->vm && v->h) {
 	int ret;
 
+	if (v->row_pending) {
+	    /* step_many stopped on a row it couldn't pack; hand it over */
+	    v->row_pending = 0;
+	    return JNI_TRUE;
+	}
 	ret = sqlite3_step((sqlite3_stmt *) v->vm);
 	if (ret == SQLITE_ROW) {
 	    return JNI_TRUE;
@@ -3662,6 +3944,630 @@ Java_SQLite_Stmt_step(JNIEnv *env, jobject obj)
     return JNI_FALSE;
 }
 
+#if HAVE_SQLITE3 && HAVE_SQLITE_COMPILE
+static void
+putbe32(jbyte *p, jint x)
+{
+    p[0] = (jbyte) (x >> 24);
+    p[1] = (jbyte) (x >> 16);
+    p[2] = (jbyte) (x >> 8);
+    p[3] = (jbyte) x;
+}
+
+static void
+putbe64(jbyte *p, jlong x)
+{
+    putbe32(p, (jint) (x >> 32));
+    putbe32(p + 4, (jint) x);
+}
+
+/*
+ * Pack the columns of the current row into buf[pos..len), each as a
+ * type code byte followed by an 8 byte big endian integer or double,
+ * a 4 byte big endian length and that many bytes of UTF-8 text or
+ * blob data, or nothing for NULL. Returns the new position, or -1
+ * if the row doesn't fit.
+ */
+
+static int
+packrow(sqlite3_stmt *stmt, jbyte *buf, int pos, int len)
+{
+    int i, ncol = sqlite3_data_count(stmt);
+
+    for (i = 0; i < ncol; i++) {
+	int type = sqlite3_column_type(stmt, i);
+	const void *data;
+	union {
+	    jdouble d;
+	    jlong j;
+	} u;
+	int n;
+
+	if (pos >= len) {
+	    return -1;
+	}
+	buf[pos++] = (jbyte) type;
+	switch (type) {
+	case SQLITE_INTEGER:
+	    if (len - pos < 8) {
+		return -1;
+	    }
+	    putbe64(buf + pos, sqlite3_column_int64(stmt, i));
+	    pos += 8;
+	    break;
+	case SQLITE_FLOAT:
+	    if (len - pos < 8) {
+		return -1;
+	    }
+	    u.d = sqlite3_column_double(stmt, i);
+	    putbe64(buf + pos, u.j);
+	    pos += 8;
+	    break;
+	case SQLITE_TEXT:
+	case SQLITE_BLOB:
+	    /* sqlite3_column_bytes must come after the text conversion */
+	    if (type == SQLITE_TEXT) {
+		data = sqlite3_column_text(stmt, i);
+	    } else {
+		data = sqlite3_column_blob(stmt, i);
+	    }
+	    n = sqlite3_column_bytes(stmt, i);
+	    if (len - pos < 4 || len - pos - 4 < n) {
+		return -1;
+	    }
+	    putbe32(buf + pos, n);
+	    pos += 4;
+	    if (n > 0) {
+		memcpy(buf + pos, data, n);
+		pos += n;
+	    }
+	    break;
+	default:
+	    /* SQLITE_NULL has no payload */
+	    break;
+	}
+    }
+    return pos;
+}
+#endif
+
+JNIEXPORT jint JNICALL
+Java_SQLite_Stmt_step_1many(JNIEnv *env, jobject obj, jint maxrows,
+			    jbyteArray buf)
+{
+#if HAVE_SQLITE3 && HAVE_SQLITE_COMPILE
+    hvm *v = gethstmt(env, obj);
+
+    if (v && v->vm && v->h) {
+	sqlite3_stmt *stmt = (sqlite3_stmt *) v->vm;
+	jbyte *data;
+	jint rows = 0;
+	int len, pos = 0, ret;
+
+	if (!buf) {
+	    throwex(env, "null buffer");
+	    return 0;
+	}
+	len = (*env)->GetArrayLength(env, buf);
+	/*
+	 * Not GetPrimitiveArrayCritical: sqlite3_step can block on I/O,
+	 * and may call back into Java for user defined functions.
+	 */
+	data = (*env)->GetByteArrayElements(env, buf, 0);
+	if (!data) {
+	    return 0;
+	}
+	while (rows < maxrows) {
+	    int next;
+
+	    if (!v->row_pending) {
+		ret = sqlite3_step(stmt);
+		if (ret == SQLITE_DONE) {
+		    break;
+		}
+		if (ret != SQLITE_ROW) {
+		    const char *err = sqlite3_errmsg(v->h->sqlite);
+
+		    (*env)->ReleaseByteArrayElements(env, buf, data, 0);
+		    setstmterr(env, obj, ret);
+		    throwex(env, err ? err : "error in step");
+		    return 0;
+		}
+		v->row_pending = 1;
+	    }
+	    next = packrow(stmt, data, pos, len);
+	    if (next < 0) {
+		/* keep the row for the next call, or for step() */
+		if (rows == 0) {
+		    (*env)->ReleaseByteArrayElements(env, buf, data, 0);
+		    throwex(env, "row too large for buffer");
+		    return 0;
+		}
+		break;
+	    }
+	    pos = next;
+	    v->row_pending = 0;
+	    rows++;
+	}
+	(*env)->ReleaseByteArrayElements(env, buf, data, 0);
+	return rows;
+    }
+    throwex(env, "stmt already closed");
+#else
+    throwex(env, "unsupported");
+#endif
+    return 0;
+}
+
+#if HAVE_SQLITE3 && HAVE_SQLITE_COMPILE
+/*
+ * Helpers of Database.exec_packed(): report column names, and the
+ * rows packed so far. Both return -1 if the callback threw, and
+ * packedrows() returns 1 if it asked for the query to be aborted.
+ */
+
+static int
+packedcolumns(JNIEnv *env, jobject cb, jmethodID mid, sqlite3_stmt *stmt)
+{
+    int i, ncol = sqlite3_column_count(stmt);
+    jobjectArray arr;
+    jthrowable exc;
+
+    arr = (*env)->NewObjectArray(env, ncol, C_java_lang_String, 0);
+    for (i = 0; arr && i < ncol; i++) {
+	const jchar *name = sqlite3_column_name16(stmt, i);
+	jsize n = 0;
+	jstring col;
+
+	if (!name) {
+	    continue;
+	}
+	while (name[n]) {
+	    n++;
+	}
+	col = (*env)->NewString(env, name, n);
+	if (!col) {
+	    break;
+	}
+	(*env)->SetObjectArrayElement(env, arr, i, col);
+	(*env)->DeleteLocalRef(env, col);
+    }
+    if (arr && i == ncol) {
+	(*env)->CallVoidMethod(env, cb, mid, arr);
+    }
+    if (arr) {
+	(*env)->DeleteLocalRef(env, arr);
+    }
+    exc = (*env)->ExceptionOccurred(env);
+    if (exc) {
+	(*env)->DeleteLocalRef(env, exc);
+	return -1;
+    }
+    return 0;
+}
+
+static int
+packedrows(JNIEnv *env, jobject cb, jmethodID mid, jbyteArray buf,
+	   jbyte *data, jint nrows)
+{
+    jboolean rc;
+    jthrowable exc;
+
+    /* a no-op unless GetByteArrayElements made a copy */
+    (*env)->ReleaseByteArrayElements(env, buf, data, JNI_COMMIT);
+    rc = (*env)->CallBooleanMethod(env, cb, mid, buf, nrows);
+    exc = (*env)->ExceptionOccurred(env);
+    if (exc) {
+	(*env)->DeleteLocalRef(env, exc);
+	return -1;
+    }
+    return rc != JNI_FALSE;
+}
+#endif
+
+JNIEXPORT void JNICALL
+Java_SQLite_Database__1exec_1packed(JNIEnv *env, jobject obj, jstring sql,
+				    jobject cb, jbyteArray buf)
+{
+#if HAVE_SQLITE3 && HAVE_SQLITE_COMPILE
+    handle *h = gethandle(env, obj);
+    jclass cls;
+    jmethodID mcols, mrows;
+    const jchar *sql16;
+    const void *s, *tail;
+    jbyte *data;
+    jsize left;
+    jint nrows = 0;
+    int ret = SQLITE_OK, len, pos = 0, next, row1 = 1, stop = 0;
+
+    if (!h || !h->sqlite) {
+	throwclosed(env);
+	return;
+    }
+#if HAVE_BOTH_SQLITE
+    if (!h->is3) {
+	throwex(env, "only on SQLite3 database");
+	return;
+    }
+#endif
+    if (!sql) {
+	throwex(env, "invalid SQL statement");
+	return;
+    }
+    if (!cb || !buf) {
+	throwex(env, "null callback or buffer");
+	return;
+    }
+    cls = (*env)->GetObjectClass(env, cb);
+    mcols = (*env)->GetMethodID(env, cls, "columns", "([Ljava/lang/String;)V");
+    mrows = (*env)->GetMethodID(env, cls, "newrows", "([BI)Z");
+    (*env)->DeleteLocalRef(env, cls);
+    if (!mcols || !mrows) {
+	return;
+    }
+    len = (*env)->GetArrayLength(env, buf);
+    /* see step_many() for why this isn't GetPrimitiveArrayCritical */
+    data = (*env)->GetByteArrayElements(env, buf, 0);
+    if (!data) {
+	return;
+    }
+    left = (*env)->GetStringLength(env, sql) * sizeof (jchar);
+    sql16 = (*env)->GetStringChars(env, sql, 0);
+    if (!sql16) {
+	(*env)->ReleaseByteArrayElements(env, buf, data, JNI_ABORT);
+	return;
+    }
+    h->env = env;
+    s = sql16;
+    while (!stop && ret == SQLITE_OK && left > 0) {
+	sqlite3_stmt *stmt = 0;
+	int ret2;
+
+	tail = 0;
+#if HAVE_SQLITE3_PREPARE16_V2
+	ret = sqlite3_prepare16_v2((sqlite3 *) h->sqlite, s, left, &stmt,
+				   &tail);
+#else
+	ret = sqlite3_prepare16((sqlite3 *) h->sqlite, s, left, &stmt, &tail);
+#endif
+	if (ret != SQLITE_OK) {
+	    break;
+	}
+	left -= (const char *) tail - (const char *) s;
+	s = tail;
+	if (!stmt) {
+	    /* only white space or a comment */
+	    continue;
+	}
+	while ((ret = sqlite3_step(stmt)) == SQLITE_ROW) {
+	    if (row1) {
+		row1 = 0;
+		stop = packedcolumns(env, cb, mcols, stmt);
+		if (stop) {
+		    break;
+		}
+	    }
+	    next = packrow(stmt, data, pos, len);
+	    if (next < 0 && nrows > 0) {
+		stop = packedrows(env, cb, mrows, buf, data, nrows);
+		nrows = 0;
+		pos = 0;
+		if (stop) {
+		    break;
+		}
+		next = packrow(stmt, data, pos, len);
+	    }
+	    if (next < 0) {
+		stop = 2;
+		break;
+	    }
+	    pos = next;
+	    nrows++;
+	}
+	/* the legacy interface gives the real error code on finalize */
+	ret2 = sqlite3_finalize(stmt);
+	if (stop) {
+	    break;
+	}
+	if (ret != SQLITE_DONE) {
+	    ret = ret2 != SQLITE_OK ? ret2 : ret;
+	    break;
+	}
+	ret = SQLITE_OK;
+	/* keep each batch to the rows of one statement */
+	if (nrows > 0) {
+	    stop = packedrows(env, cb, mrows, buf, data, nrows);
+	    nrows = 0;
+	    pos = 0;
+	}
+    }
+    (*env)->ReleaseStringChars(env, sql, sql16);
+    (*env)->ReleaseByteArrayElements(env, buf, data, 0);
+    switch (stop) {
+    case 0:
+	if (ret != SQLITE_OK) {
+	    const char *err = sqlite3_errmsg((sqlite3 *) h->sqlite);
+
+	    seterr(env, obj, ret);
+	    throwex(env, err ? err : "error in exec_packed");
+	}
+	break;
+    case 1:
+	seterr(env, obj, SQLITE_ABORT);
+	throwex(env, "callback requested query abort");
+	break;
+    case 2:
+	throwex(env, "row too large for buffer");
+	break;
+    }
+#else
+    throwex(env, "unsupported");
+#endif
+}
+
+#if HAVE_SQLITE3 && HAVE_SQLITE_COMPILE
+/* one parameter column of Stmt.execute_batch() */
+
+#define BATCH_INT	0
+#define BATCH_LONG	1
+#define BATCH_DOUBLE	2
+#define BATCH_TEXT	3
+#define BATCH_BLOB	4
+
+typedef struct {
+    int type;			/* BATCH_* */
+    jarray arr;			/* column array, one element per row */
+    void *elems;		/* pinned elements of primitive array */
+    jobject cur;		/* String/byte[] bound for the current row */
+    void *curdata;		/* its pinned chars/bytes */
+} batchcol;
+
+static const char *const batchsigs[] = {
+    "[I", "[J", "[D", "[Ljava/lang/String;", "[[B"
+};
+
+/* returns 0 with an exception pending if arr can't be used */
+
+static int
+batchcolinit(JNIEnv *env, batchcol *c, jarray arr, jint nrows)
+{
+    int t;
+
+    c->arr = arr;
+    c->type = -1;
+    if (!arr) {
+	throwex(env, "null batch column");
+	return 0;
+    }
+    for (t = BATCH_INT; t <= BATCH_BLOB && c->type < 0; t++) {
+	jclass cls = (*env)->FindClass(env, batchsigs[t]);
+
+	if (!cls) {
+	    return 0;
+	}
+	if ((*env)->IsInstanceOf(env, arr, cls)) {
+	    c->type = t;
+	}
+	(*env)->DeleteLocalRef(env, cls);
+    }
+    if (c->type < 0) {
+	throwex(env, "unsupported batch column type");
+	return 0;
+    }
+    if ((*env)->GetArrayLength(env, arr) < nrows) {
+	throwex(env, "batch column too short");
+	return 0;
+    }
+    switch (c->type) {
+    case BATCH_INT:
+	c->elems = (*env)->GetIntArrayElements(env, (jintArray) arr, 0);
+	break;
+    case BATCH_LONG:
+	c->elems = (*env)->GetLongArrayElements(env, (jlongArray) arr, 0);
+	break;
+    case BATCH_DOUBLE:
+	c->elems = (*env)->GetDoubleArrayElements(env, (jdoubleArray) arr, 0);
+	break;
+    default:
+	return 1;
+    }
+    return c->elems != 0;
+}
+
+/* unpin the String/byte[] bound for the last row */
+
+static void
+batchcolunbind(JNIEnv *env, batchcol *c)
+{
+    if (c->cur) {
+	if (c->type == BATCH_TEXT) {
+	    (*env)->ReleaseStringChars(env, (jstring) c->cur, c->curdata);
+	} else {
+	    (*env)->ReleaseByteArrayElements(env, (jbyteArray) c->cur,
+					     c->curdata, JNI_ABORT);
+	}
+	(*env)->DeleteLocalRef(env, c->cur);
+	c->cur = 0;
+	c->curdata = 0;
+    }
+}
+
+static void
+batchcolfree(JNIEnv *env, batchcol *c)
+{
+    batchcolunbind(env, c);
+    if (c->elems) {
+	switch (c->type) {
+	case BATCH_INT:
+	    (*env)->ReleaseIntArrayElements(env, (jintArray) c->arr,
+					    c->elems, JNI_ABORT);
+	    break;
+	case BATCH_LONG:
+	    (*env)->ReleaseLongArrayElements(env, (jlongArray) c->arr,
+					     c->elems, JNI_ABORT);
+	    break;
+	case BATCH_DOUBLE:
+	    (*env)->ReleaseDoubleArrayElements(env, (jdoubleArray) c->arr,
+					       c->elems, JNI_ABORT);
+	    break;
+	}
+	c->elems = 0;
+    }
+    if (c->arr) {
+	(*env)->DeleteLocalRef(env, c->arr);
+	c->arr = 0;
+    }
+}
+
+/*
+ * Bind row of column c to parameter pos. Text and blobs are bound
+ * SQLITE_STATIC from their pinned Java arrays, which stay pinned
+ * until the next row is bound.
+ */
+
+static int
+batchcolbind(JNIEnv *env, sqlite3_stmt *stmt, batchcol *c, int pos, jint row)
+{
+    jsize len;
+
+    switch (c->type) {
+    case BATCH_INT:
+	return sqlite3_bind_int(stmt, pos, ((jint *) c->elems)[row]);
+    case BATCH_LONG:
+	return sqlite3_bind_int64(stmt, pos,
+				  (sqlite_int64) ((jlong *) c->elems)[row]);
+    case BATCH_DOUBLE:
+	return sqlite3_bind_double(stmt, pos, ((jdouble *) c->elems)[row]);
+    }
+    batchcolunbind(env, c);
+    c->cur = (*env)->GetObjectArrayElement(env, (jobjectArray) c->arr, row);
+    if (!c->cur) {
+	return sqlite3_bind_null(stmt, pos);
+    }
+    if (c->type == BATCH_TEXT) {
+	len = (*env)->GetStringLength(env, (jstring) c->cur);
+	c->curdata = (void *) (*env)->GetStringChars(env, (jstring) c->cur, 0);
+    } else {
+	len = (*env)->GetArrayLength(env, (jbyteArray) c->cur);
+	c->curdata = (*env)->GetByteArrayElements(env, (jbyteArray) c->cur, 0);
+    }
+    if (!c->curdata) {
+	(*env)->DeleteLocalRef(env, c->cur);
+	c->cur = 0;
+	return SQLITE_NOMEM;
+    }
+    if (c->type == BATCH_TEXT) {
+	return sqlite3_bind_text16(stmt, pos, c->curdata, len * sizeof (jchar),
+				   SQLITE_STATIC);
+    }
+    return sqlite3_bind_blob(stmt, pos, len > 0 ? c->curdata : "", len,
+			     SQLITE_STATIC);
+}
+#endif
+
+JNIEXPORT jint JNICALL
+Java_SQLite_Stmt_execute_1batch(JNIEnv *env, jobject obj, jint nrows,
+				jobjectArray columns, jboolean trans)
+{
+#if HAVE_SQLITE3 && HAVE_SQLITE_COMPILE
+    hvm *v = gethstmt(env, obj);
+
+    if (v && v->vm && v->h) {
+	sqlite3_stmt *stmt = (sqlite3_stmt *) v->vm;
+	sqlite3 *db = (sqlite3 *) v->h->sqlite;
+	int npar = sqlite3_bind_parameter_count(stmt);
+	int i, ncol, ret = SQLITE_OK, began = 0;
+	jint row = 0;
+	jthrowable exc = 0;
+	batchcol *cols;
+
+	if (!columns) {
+	    throwex(env, "null batch columns");
+	    return 0;
+	}
+	ncol = (*env)->GetArrayLength(env, columns);
+	if (ncol > npar) {
+	    throwex(env, "parameter position out of bounds");
+	    return 0;
+	}
+	/* each column holds its array and the current row's element */
+	if ((*env)->EnsureLocalCapacity(env, 2 * ncol + 2) < 0) {
+	    return 0;
+	}
+	cols = calloc(ncol + 1, sizeof (batchcol));
+	if (!cols) {
+	    throwoom(env, "unable to get batch columns");
+	    return 0;
+	}
+	for (i = 0; i < ncol; i++) {
+	    jarray arr = (*env)->GetObjectArrayElement(env, columns, i);
+
+	    if (!batchcolinit(env, &cols[i], arr, nrows)) {
+		goto done;
+	    }
+	}
+	v->h->env = env;
+	v->row_pending = 0;
+	sqlite3_reset(stmt);
+	if (trans && sqlite3_get_autocommit(db)) {
+	    ret = sqlite3_exec(db, "BEGIN", 0, 0, 0);
+	    began = ret == SQLITE_OK;
+	}
+	for (; ret == SQLITE_OK && row < nrows; row++) {
+	    for (i = 0; ret == SQLITE_OK && i < ncol; i++) {
+		ret = batchcolbind(env, stmt, &cols[i], i + 1, row);
+	    }
+	    if (ret != SQLITE_OK) {
+		break;
+	    }
+	    while ((ret = sqlite3_step(stmt)) == SQLITE_ROW) {
+	    }
+	    /* the legacy interface gives the real error code on reset */
+	    i = sqlite3_reset(stmt);
+	    exc = (*env)->ExceptionOccurred(env);
+	    if (exc) {
+		/* thrown from a user defined function */
+		goto done;
+	    }
+	    if (ret != SQLITE_DONE) {
+		ret = i != SQLITE_OK ? i : ret;
+		break;
+	    }
+	    ret = SQLITE_OK;
+	}
+	if (began && ret == SQLITE_OK) {
+	    ret = sqlite3_exec(db, "COMMIT", 0, 0, 0);
+	}
+	if (ret != SQLITE_OK) {
+	    const char *err = sqlite3_errmsg(db);
+
+	    setstmterr(env, obj, ret);
+	    throwex(env, err ? err : "error in execute_batch");
+	}
+done:
+	if (began && (ret != SQLITE_OK || exc)) {
+	    sqlite3_exec(db, "ROLLBACK", 0, 0, 0);
+	}
+	if (exc) {
+	    (*env)->DeleteLocalRef(env, exc);
+	}
+	for (i = 0; i < ncol; i++) {
+	    if (cols[i].cur) {
+		/* don't leave SQLite pointing into an unpinned array */
+		sqlite3_bind_null(stmt, i + 1);
+	    }
+	    batchcolfree(env, &cols[i]);
+	}
+	free(cols);
+	return row;
+    }
+    throwex(env, "stmt already closed");
+#else
+    throwex(env, "unsupported");
+#endif
+    return 0;
+}
+
 JNIEXPORT void JNICALL
 Java_SQLite_Stmt_close(JNIEnv *env, jobject obj)
 {
@@ -3671,7 +4577,13 @@ Java_SQLite_Stmt_close(JNIEnv *env, jobject obj)
     if (v && v->vm && v->h) {
 	int ret;
 
-	ret = sqlite3_finalize((sqlite3_stmt *) v->vm);
+	if (v->key) {
+	    ret = stmtcache_put(v->h, (sqlite3_stmt *) v->vm, 1,
+				v->key, v->key_len);
+	    v->key = 0;
+	} else {
+	    ret = sqlite3_finalize((sqlite3_stmt *) v->vm);
+	}
 	v->vm = 0;
 	if (ret != SQLITE_OK) {
 	    const char *err = sqlite3_errmsg(v->h->sqlite);
@@ -3696,6 +4608,7 @@ Java_SQLite_Stmt_reset(JNIEnv *env, jobject obj)
 
     if (v && v->vm && v->h) {
 	sqlite3_reset((sqlite3_stmt *) v->vm);
+	v->row_pending = 0;
     } else {
 	throwex(env, "stmt already closed");
     }
@@ -4512,6 +5425,74 @@ Java_SQLite_Blob_read(JNIEnv *env , jobject obj, jbyteArray b, jint off,
     return 0;
 }
 
+JNIEXPORT jint JNICALL
+Java_SQLite_Blob_write_1direct(JNIEnv *env, jobject obj, jobject b, jint off,
+			       jint pos, jint len)
+{
+#if HAVE_SQLITE3 && HAVE_SQLITE3_INCRBLOBIO
+    hbl *bl = gethbl(env, obj);
+
+    if (bl && bl->h && bl->blob) {
+	char *buf;
+	int ret;
+
+	if (len <= 0) {
+	    return 0;
+	}
+	buf = (*env)->GetDirectBufferAddress(env, b);
+	if (!buf || off < 0 ||
+	    off + len > (*env)->GetDirectBufferCapacity(env, b)) {
+	    throwex(env, "invalid direct buffer");
+	    return 0;
+	}
+	ret = sqlite3_blob_write(bl->blob, buf + off, len, pos);
+	if (ret != SQLITE_OK) {
+	    throwioex(env, "blob write error");
+	    return 0;
+	}
+	return len;
+    }
+    throwex(env, "blob already closed");
+#else
+    throwex(env, "unsupported");
+#endif
+    return 0;
+}
+
+JNIEXPORT jint JNICALL
+Java_SQLite_Blob_read_1direct(JNIEnv *env, jobject obj, jobject b, jint off,
+			      jint pos, jint len)
+{
+#if HAVE_SQLITE3 && HAVE_SQLITE3_INCRBLOBIO
+    hbl *bl = gethbl(env, obj);
+
+    if (bl && bl->h && bl->blob) {
+	char *buf;
+	int ret;
+
+	if (len <= 0) {
+	    return 0;
+	}
+	buf = (*env)->GetDirectBufferAddress(env, b);
+	if (!buf || off < 0 ||
+	    off + len > (*env)->GetDirectBufferCapacity(env, b)) {
+	    throwex(env, "invalid direct buffer");
+	    return 0;
+	}
+	ret = sqlite3_blob_read(bl->blob, buf + off, len, pos);
+	if (ret != SQLITE_OK) {
+	    throwioex(env, "blob read error");
+	    return 0;
+	}
+	return len;
+    }
+    throwex(env, "blob already closed");
+#else
+    throwex(env, "unsupported");
+#endif
+    return 0;
+}
+
 JNIEXPORT void JNICALL
 Java_SQLite_Blob_close(JNIEnv *env, jobject obj)
 {
@@ -4937,6 +5918,47 @@ Java_SQLite_Database__1db_1status(JNIEnv *env, jobject obj, jint op,
     return ret;
 }
 
+JNIEXPORT void JNICALL
+Java_SQLite_Database__1stmt_1cache_1size(JNIEnv *env, jobject obj, jint n)
+{
+#if HAVE_SQLITE3
+    handle *h = gethandle(env, obj);
+
+    if (h && h->sqlite) {
+	h->stmtcache_max = n < 0 ? 0 : n;
+	stmtcache_trim(h, h->stmtcache_max);
+	return;
+    }
+    throwclosed(env);
+#else
+    throwex(env, "unsupported");
+#endif
+}
+
+JNIEXPORT void JNICALL
+Java_SQLite_Database__1stmt_1cache_1stats(JNIEnv *env, jobject obj,
+					  jlongArray stats)
+{
+#if HAVE_SQLITE3
+    handle *h = gethandle(env, obj);
+
+    if (h && h->sqlite) {
+	jlong data[3];
+
+	pthread_mutex_lock(&h->stmtcache_lock);
+	data[0] = h->stmtcache_hits;
+	data[1] = h->stmtcache_misses;
+	data[2] = h->stmtcache_n;
+	pthread_mutex_unlock(&h->stmtcache_lock);
+	(*env)->SetLongArrayRegion(env, stats, 0, 3, data);
+	return;
+    }
+    throwclosed(env);
+#else
+    throwex(env, "unsupported");
+#endif
+}
+
 JNIEXPORT void JNICALL
 Java_SQLite_Stmt_internal_1init(JNIEnv *env, jclass cls)
 {